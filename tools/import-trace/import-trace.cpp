@@ -0,0 +1,115 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+// Converts the import trace saved by Vita3K (import_trace.bin in the log folder) to text or CSV
+
+#include <kernel/import_trace_format.h>
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+static void print_usage() {
+    std::cerr << "Usage: import-trace [--csv] <import_trace.bin> [output]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    bool csv = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else
+            paths.emplace_back(argv[i]);
+    }
+    if (paths.empty() || paths.size() > 2) {
+        print_usage();
+        return 1;
+    }
+
+    std::ifstream file(paths[0], std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << paths[0] << std::endl;
+        return 1;
+    }
+
+    import_trace::FileHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || std::memcmp(header.magic, import_trace::FILE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << paths[0] << " is not an import trace" << std::endl;
+        return 1;
+    }
+    if (header.version != import_trace::FILE_VERSION) {
+        std::cerr << "Unsupported import trace version " << header.version << std::endl;
+        return 1;
+    }
+
+    std::vector<import_trace::Entry> entries(header.entry_count);
+    file.read(reinterpret_cast<char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(import_trace::Entry)));
+
+    std::map<uint32_t, std::string> names;
+    for (uint32_t i = 0; i < header.name_count && file; i++) {
+        uint32_t nid = 0;
+        uint32_t length = 0;
+        file.read(reinterpret_cast<char *>(&nid), sizeof(nid));
+        file.read(reinterpret_cast<char *>(&length), sizeof(length));
+        std::string name(length, '\0');
+        file.read(name.data(), length);
+        names.emplace(nid, std::move(name));
+    }
+    if (!file) {
+        std::cerr << paths[0] << " is truncated" << std::endl;
+        return 1;
+    }
+
+    std::ofstream output_file;
+    if (paths.size() == 2) {
+        output_file.open(paths[1]);
+        if (!output_file) {
+            std::cerr << "Cannot write " << paths[1] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &output = output_file.is_open() ? output_file : std::cout;
+
+    output << std::hex << std::setfill('0');
+    if (csv)
+        output << "time_us,thread_id,nid,name,lr,r0,r1,r2,r3\n";
+    for (const auto &entry : entries) {
+        const std::string &name = names[entry.nid];
+        if (csv) {
+            output << std::dec << entry.time_ns / 1000 << ',' << entry.thread_id << std::hex
+                   << ",0x" << std::setw(8) << entry.nid << ',' << name << ",0x" << std::setw(8) << entry.lr;
+            for (const uint32_t arg : entry.args)
+                output << ",0x" << std::setw(8) << arg;
+        } else {
+            output << std::dec << std::setfill(' ') << std::setw(12) << entry.time_ns / 1000 << " us TID: " << std::setw(3) << entry.thread_id
+                   << std::hex << std::setfill('0') << " FUNC: 0x" << std::setw(8) << entry.nid << ' ' << name << " at 0x" << std::setw(8) << entry.lr << " (";
+            for (size_t i = 0; i < std::size(entry.args); i++)
+                output << (i ? ", " : "") << "0x" << std::setw(8) << entry.args[i];
+            output << ')';
+        }
+        output << '\n';
+    }
+
+    return 0;
+}
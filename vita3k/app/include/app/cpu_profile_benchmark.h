@@ -0,0 +1,74 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+struct EmuEnvState;
+
+namespace app {
+
+// Optimizations of the jit profile chosen in the config for the app being booted.
+// The auto profile is the one recorded by the last benchmark of the app, or the default one.
+uint32_t get_cpu_profile_optimizations(EmuEnvState &emuenv);
+
+/**
+ * @brief Benchmark of the jit profiles on the running app (--benchmark-cpu-profiles)
+ *
+ * Starting with the first frame of the app, the running threads switch in turn to each profile which
+ * contains at least the optimizations of the default one. The frames shown by the app are counted after
+ * a warm up during which the code is translated again. A profile during which the app stopped showing
+ * frames is not stable. The fastest stable profile is recorded for the auto profile and used for the rest
+ * of the session, the default one is kept unless the others are clearly faster.
+ */
+class CpuProfileBenchmark {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CpuProfileBenchmark(EmuEnvState &emuenv, std::chrono::seconds duration);
+
+    // to be called for each new frame shown by the app
+    void on_frame();
+    // switches to the next profile once the current one has been measured, to be called in the main loop
+    void update(EmuEnvState &emuenv);
+    bool is_done() const;
+
+private:
+    struct Result {
+        size_t profile;
+        float fps;
+        bool stable;
+    };
+
+    void start_profile(EmuEnvState &emuenv);
+    void finish(EmuEnvState &emuenv);
+
+    std::chrono::seconds duration;
+    std::vector<size_t> profiles;
+    std::vector<Result> results;
+    size_t current = 0;
+    Clock::time_point profile_start;
+    Clock::time_point last_frame;
+    uint32_t frame_count = 0;
+    Clock::duration longest_frame{};
+    bool done = false;
+};
+
+} // namespace app
@@ -0,0 +1,68 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+struct EmuEnvState;
+
+namespace app {
+
+/**
+ * @brief Measurements of a run of fixed length of the app, for the automated performance runs (--perf-run)
+ *
+ * The run starts with the first frame of the app. It records the time between the frames shown by the app,
+ * the CPU time of each host thread (only on Linux for now), the pipelines or shaders compiled and the
+ * texture data uploaded, and saves them as a JSON report to compare the runs of different builds.
+ */
+class PerfRun {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct ThreadTime {
+        std::string name;
+        uint64_t cpu_ticks;
+    };
+
+    PerfRun(EmuEnvState &emuenv, std::chrono::seconds duration);
+
+    // to be called for each new frame shown by the app
+    void on_frame();
+    bool is_done() const;
+
+    bool save_report(EmuEnvState &emuenv, const fs::path &path);
+
+private:
+    Clock::time_point start;
+    Clock::time_point last_frame;
+    std::chrono::seconds duration;
+    std::vector<float> frame_times_ms;
+
+    std::map<int, ThreadTime> start_thread_times;
+    uint32_t start_shaders_compiled;
+    uint64_t start_texture_upload_bytes;
+};
+
+} // namespace app
@@ -0,0 +1,41 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+struct EmuEnvState;
+
+namespace app {
+
+/**
+ * @brief Snapshot of the running app, to go back to the same point of the game later in the session
+ *
+ * The state holds the allocated guest memory, the registers of the guest threads and the counters of the
+ * semaphores and event flags. The threads are only paused while the memory is copied, the copy is then
+ * compressed and written to the file in the background.
+ * The host objects (renderer, audio, threads blocked in the kernel) are not part of it, so a state can only
+ * be loaded in the session it was saved in, once the app has the same memory allocations and threads.
+ */
+bool save_state(EmuEnvState &emuenv, const fs::path &path);
+bool load_state(EmuEnvState &emuenv, const fs::path &path);
+
+// waits for the file of the last save state to be written
+void wait_for_save_state();
+
+} // namespace app
@@ -17,6 +17,7 @@
 
 #include <app/functions.h>
 
+#include <audio/state.h>
 #include <config/state.h>
 #include <config/version.h>
 #include <display/state.h>
@@ -55,6 +56,7 @@ void calculate_fps(EmuEnvState &emuenv) {
         emuenv.sdl_ticks = sdl_ticks_now;
         emuenv.frame_count = 0;
         set_window_title(emuenv);
+        emuenv.audio.update_stats(ms);
 
         // Set FPS Statistics
         emuenv.fps_values[emuenv.current_fps_offset] = static_cast<float>(emuenv.fps);
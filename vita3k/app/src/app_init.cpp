@@ -33,6 +33,7 @@
 #include <renderer/state.h>
 
 #include <renderer/functions.h>
+#include <util/boot_trace.h>
 #include <util/fs.h>
 #include <util/log.h>
 #include <util/string_utils.h>
@@ -285,6 +286,7 @@ void init_paths(Root &root_paths) {
 }
 
 bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
+    const boot_trace::Span span("app::init");
     state.cfg = std::move(cfg);
 
     state.base_path = root_paths.get_base_path();
@@ -352,6 +354,10 @@ bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
     }
 #endif
 
+    // the window is still needed to create the renderer, it is just never shown
+    if (state.cfg.headless)
+        window_type |= SDL_WINDOW_HIDDEN;
+
     state.manual_dpi_scale = SDL_GetDisplayContentScale(SDL_GetPrimaryDisplay());
     state.window = WindowPtr(SDL_CreateWindow(window_title, DEFAULT_RES_WIDTH * state.manual_dpi_scale, DEFAULT_RES_HEIGHT * state.manual_dpi_scale, window_type | SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY), SDL_DestroyWindow);
     if (!state.window) {
@@ -398,6 +404,14 @@ bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
         LOG_ERROR("Failed to initialize file system for the emulator!");
         return false;
     }
+    state.io.map_app_files = state.cfg.map_app_files;
+    // the size of the write buffer is in KiB
+    state.io.write_buffer_size = state.cfg.io_write_buffer_size > 0 ? static_cast<size_t>(state.cfg.io_write_buffer_size) * 1024 : 0;
+    state.io.stats.enabled = state.cfg.io_stats;
+    state.kernel.hle_profiler.enabled = state.cfg.hle_profiler;
+    state.kernel.import_trace.enabled = state.cfg.import_trace;
+    if (state.cfg.guest_profiler)
+        state.kernel.guest_profiler.start(state.kernel);
 
 #ifdef __ANDROID__
     state.renderer->current_custom_driver = state.cfg.custom_driver_name;
@@ -415,16 +429,24 @@ bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
 }
 
 bool late_init(EmuEnvState &state) {
+    const boot_trace::Span span("app::late_init");
     // note: mem is not initialized yet but that's not an issue
     // the renderer is not using it yet, just storing it for later uses
     state.renderer->late_init(state.cfg, state.app_path, state.mem);
 
-    const bool need_page_table = state.renderer->mapping_method == MappingMethod::PageTable || state.renderer->mapping_method == MappingMethod::NativeBuffer;
+    const bool need_page_table = (state.renderer->mapping_method == MappingMethod::PageTable && !state.renderer->move_mapped_memory) || state.renderer->mapping_method == MappingMethod::NativeBuffer;
+    state.mem.move_external_mappings = state.renderer->move_mapped_memory;
+    state.mem.use_huge_pages = state.cfg.huge_pages;
+    state.mem.use_cold_pages = state.cfg.reclaim_cold_pages;
     if (!init(state.mem, need_page_table)) {
         LOG_ERROR("Failed to initialize memory for emulator state!");
         return false;
     }
 
+    if (state.cfg.soft_dirty_tracking)
+        enable_soft_dirty_tracking(state.mem);
+
+    state.audio.target_latency_ms = state.cfg.audio_latency;
     if (!state.audio.init(state.cfg.audio_backend)) {
         LOG_WARN("Failed to initialize audio! Audio will not work.");
     }
@@ -447,6 +469,20 @@ void destroy(EmuEnvState &emuenv, ImGui_State *imgui) {
     if (emuenv.cfg.gdbstub)
         server_close(emuenv);
 
+    emuenv.kernel.jit_block_cache.save();
+    log_mem_stats(emuenv.mem);
+    emuenv.kernel.libc_heap.log_stats();
+    if (emuenv.io.stats.enabled)
+        emuenv.io.stats.save_report(emuenv.log_path / "io_stats.json");
+    if (emuenv.kernel.hle_profiler.enabled)
+        emuenv.kernel.hle_profiler.save_csv(emuenv.log_path / "hle_profile.csv");
+    if (emuenv.kernel.import_trace.enabled)
+        emuenv.kernel.import_trace.save(emuenv.log_path / "import_trace.bin");
+    if (emuenv.kernel.guest_profiler.is_running()) {
+        emuenv.kernel.guest_profiler.stop();
+        emuenv.kernel.guest_profiler.save_folded(emuenv.kernel, emuenv.log_path / "guest_profile.folded");
+    }
+
     // There may be changes that made in the GUI, so we should save, again
     if (emuenv.cfg.overwrite_config)
         config::serialize_config(emuenv.cfg, emuenv.cfg.config_path);
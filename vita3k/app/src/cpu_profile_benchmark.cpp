@@ -0,0 +1,139 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <app/cpu_profile_benchmark.h>
+
+#include <config/state.h>
+#include <cpu/functions.h>
+#include <emuenv/state.h>
+#include <io/state.h>
+#include <kernel/state.h>
+#include <util/fs.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <string>
+
+namespace app {
+
+// the code is translated again after a change of profile, this is not measured
+static constexpr auto WARM_UP = std::chrono::seconds(3);
+// no frame was shown for this long, the app hanged with the profile
+static constexpr auto HANG_TIME = std::chrono::seconds(2);
+// another profile must be this much faster to replace the default one, the measures of a running app are noisy
+static constexpr float MIN_SPEEDUP = 1.05f;
+
+static fs::path get_result_path(EmuEnvState &emuenv) {
+    return emuenv.cache_path / "cpu_profiles" / fmt::format("{}.txt", emuenv.io.title_id);
+}
+
+uint32_t get_cpu_profile_optimizations(EmuEnvState &emuenv) {
+    std::string profile = emuenv.cfg.current_config.cpu_profile;
+    if (profile == "auto") {
+        fs::ifstream result(get_result_path(emuenv));
+        if (!result || !std::getline(result, profile))
+            profile = JIT_PROFILES[0].name;
+    }
+
+    LOG_INFO("CPU profile: {}", profile);
+    return get_jit_profile_optimizations(profile);
+}
+
+CpuProfileBenchmark::CpuProfileBenchmark(EmuEnvState &emuenv, std::chrono::seconds duration)
+    : duration(duration) {
+    if (!emuenv.kernel.cpu_opt) {
+        LOG_WARN("The CPU optimizations are disabled, there is no profile to benchmark");
+        done = true;
+        return;
+    }
+
+    // the profiles disabling some of the default optimizations are only there to debug
+    const uint32_t default_optimizations = JIT_PROFILES[0].optimizations;
+    for (size_t i = 0; i < JIT_PROFILES.size(); i++) {
+        if ((JIT_PROFILES[i].optimizations & default_optimizations) == default_optimizations)
+            profiles.push_back(i);
+    }
+
+    LOG_INFO("Benchmark of {} CPU profiles started, {} s each", profiles.size(), duration.count());
+    start_profile(emuenv);
+}
+
+void CpuProfileBenchmark::start_profile(EmuEnvState &emuenv) {
+    emuenv.kernel.set_jit_optimizations(JIT_PROFILES[profiles[current]].optimizations);
+    profile_start = Clock::now();
+    last_frame = profile_start + WARM_UP;
+    frame_count = 0;
+    longest_frame = {};
+}
+
+void CpuProfileBenchmark::on_frame() {
+    const auto now = Clock::now();
+    if (done || now < profile_start + WARM_UP)
+        return;
+
+    frame_count++;
+    longest_frame = std::max(longest_frame, now - last_frame);
+    last_frame = now;
+}
+
+void CpuProfileBenchmark::update(EmuEnvState &emuenv) {
+    const auto now = Clock::now();
+    if (done || now < profile_start + WARM_UP + duration)
+        return;
+
+    longest_frame = std::max(longest_frame, now - last_frame);
+    const float fps = static_cast<float>(frame_count) / std::chrono::duration<float>(duration).count();
+    const bool stable = frame_count > 0 && longest_frame < HANG_TIME;
+    results.push_back({ profiles[current], fps, stable });
+    LOG_INFO("CPU profile {}: {:.2f} fps{}", JIT_PROFILES[profiles[current]].name, fps, stable ? "" : ", not stable");
+
+    if (++current < profiles.size())
+        start_profile(emuenv);
+    else
+        finish(emuenv);
+}
+
+bool CpuProfileBenchmark::is_done() const {
+    return done;
+}
+
+void CpuProfileBenchmark::finish(EmuEnvState &emuenv) {
+    done = true;
+
+    // the default profile is measured first
+    const Result *best = &results.front();
+    for (const auto &result : results) {
+        if (result.stable && result.fps > best->fps * MIN_SPEEDUP)
+            best = &result;
+    }
+
+    const char *name = JIT_PROFILES[best->profile].name;
+    const fs::path result_path = get_result_path(emuenv);
+    boost::system::error_code error_code;
+    fs::create_directories(result_path.parent_path(), error_code);
+    fs::ofstream result(result_path);
+    result << name << '\n';
+    if (result)
+        LOG_INFO("CPU profile {} recorded for the auto profile of {}", name, emuenv.io.title_id);
+    else
+        LOG_ERROR("Cannot write the CPU profile to {}", result_path);
+
+    // back to the profile of the config, which is the recorded one with auto
+    emuenv.kernel.set_jit_optimizations(get_cpu_profile_optimizations(emuenv));
+}
+
+} // namespace app
@@ -0,0 +1,178 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <app/perf_run.h>
+
+#include <config/state.h>
+#include <emuenv/state.h>
+#include <io/state.h>
+#include <renderer/state.h>
+#include <renderer/texture_cache.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace app {
+
+// CPU time of each thread of the process, in clock ticks, only implemented on Linux
+static std::map<int, PerfRun::ThreadTime> get_thread_times() {
+    std::map<int, PerfRun::ThreadTime> times;
+#ifdef __linux__
+    boost::system::error_code err;
+    for (const auto &entry : fs::directory_iterator("/proc/self/task", err)) {
+        const std::string tid = entry.path().filename().string();
+
+        std::string name;
+        fs::ifstream comm(entry.path() / "comm");
+        std::getline(comm, name);
+
+        std::string stat_line;
+        fs::ifstream stat(entry.path() / "stat");
+        std::getline(stat, stat_line);
+        // the name in parentheses may contain spaces, the fields are counted from its end
+        const auto name_end = stat_line.rfind(')');
+        if (name_end == std::string::npos)
+            continue;
+
+        std::istringstream fields(stat_line.substr(name_end + 2));
+        std::string field;
+        uint64_t utime = 0, stime = 0;
+        // utime and stime are the fields 14 and 15, state being the field 3
+        for (int i = 3; i <= 15 && fields >> field; i++) {
+            if (i == 14)
+                utime = std::stoull(field);
+            else if (i == 15)
+                stime = std::stoull(field);
+        }
+        times[std::stoi(tid)] = { name, utime + stime };
+    }
+#endif
+    return times;
+}
+
+static uint64_t get_texture_upload_bytes(EmuEnvState &emuenv) {
+    const renderer::TextureCache *cache = emuenv.renderer->get_texture_cache();
+    return cache ? cache->upload_bytes : 0;
+}
+
+PerfRun::PerfRun(EmuEnvState &emuenv, std::chrono::seconds duration)
+    : start(Clock::now())
+    , last_frame(start)
+    , duration(duration)
+    , start_thread_times(get_thread_times())
+    , start_shaders_compiled(emuenv.renderer->shaders_count_compiled)
+    , start_texture_upload_bytes(get_texture_upload_bytes(emuenv)) {
+    LOG_INFO("Performance run started for {} s", duration.count());
+}
+
+void PerfRun::on_frame() {
+    const auto now = Clock::now();
+    frame_times_ms.push_back(std::chrono::duration<float, std::milli>(now - last_frame).count());
+    last_frame = now;
+}
+
+bool PerfRun::is_done() const {
+    return Clock::now() - start >= duration;
+}
+
+static float get_percentile(std::vector<float> &sorted_values, double share) {
+    if (sorted_values.empty())
+        return 0.0f;
+    const auto index = std::min(static_cast<size_t>(static_cast<double>(sorted_values.size()) * share), sorted_values.size() - 1);
+    return sorted_values[index];
+}
+
+static std::string escape_json(const std::string &str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (const char c : str) {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+bool PerfRun::save_report(EmuEnvState &emuenv, const fs::path &path) {
+    const double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<float> sorted_frame_times = frame_times_ms;
+    std::sort(sorted_frame_times.begin(), sorted_frame_times.end());
+    const float average_ms = sorted_frame_times.empty() ? 0.0f : std::accumulate(sorted_frame_times.begin(), sorted_frame_times.end(), 0.0f) / sorted_frame_times.size();
+
+    // threads which ended during the run are not counted, the ones created during it started from 0
+    struct ThreadUsage {
+        int tid;
+        std::string name;
+        double cpu_percent;
+    };
+    std::vector<ThreadUsage> threads;
+    double process_cpu_percent = 0.0;
+#ifdef __linux__
+    const double ticks_per_second = static_cast<double>(sysconf(_SC_CLK_TCK));
+    for (const auto &[tid, time] : get_thread_times()) {
+        const auto start_time = start_thread_times.find(tid);
+        const uint64_t start_ticks = start_time != start_thread_times.end() ? start_time->second.cpu_ticks : 0;
+        const double cpu_percent = static_cast<double>(time.cpu_ticks - start_ticks) / ticks_per_second / elapsed_s * 100.0;
+        threads.push_back({ tid, time.name, cpu_percent });
+        process_cpu_percent += cpu_percent;
+    }
+    std::sort(threads.begin(), threads.end(), [](const ThreadUsage &a, const ThreadUsage &b) { return a.cpu_percent > b.cpu_percent; });
+#endif
+
+    fs::ofstream report(path);
+    if (!report) {
+        LOG_ERROR("Cannot write the performance report to {}", path);
+        return false;
+    }
+
+    report << "{\n";
+    report << fmt::format("  \"title_id\": \"{}\",\n", escape_json(emuenv.io.title_id));
+    report << fmt::format("  \"title\": \"{}\",\n", escape_json(emuenv.current_app_title));
+    report << fmt::format("  \"backend\": \"{}\",\n", escape_json(emuenv.cfg.current_config.backend_renderer));
+    report << fmt::format("  \"duration_s\": {:.3f},\n", elapsed_s);
+    report << fmt::format("  \"frames\": {},\n", frame_times_ms.size());
+    report << fmt::format("  \"fps\": {:.2f},\n", elapsed_s > 0.0 ? frame_times_ms.size() / elapsed_s : 0.0);
+    report << fmt::format("  \"frame_time_ms\": {{ \"average\": {:.3f}, \"p50\": {:.3f}, \"p90\": {:.3f}, \"p99\": {:.3f}, \"max\": {:.3f} }},\n",
+        average_ms, get_percentile(sorted_frame_times, 0.5), get_percentile(sorted_frame_times, 0.9), get_percentile(sorted_frame_times, 0.99),
+        sorted_frame_times.empty() ? 0.0f : sorted_frame_times.back());
+    // pipelines with Vulkan, shaders with OpenGL
+    report << fmt::format("  \"shaders_compiled\": {},\n", emuenv.renderer->shaders_count_compiled - start_shaders_compiled);
+    report << fmt::format("  \"texture_upload_bytes\": {},\n", get_texture_upload_bytes(emuenv) - start_texture_upload_bytes);
+    report << fmt::format("  \"process_cpu_percent\": {:.1f},\n", process_cpu_percent);
+    report << "  \"threads\": [";
+    for (size_t i = 0; i < threads.size(); i++) {
+        report << (i == 0 ? "\n" : ",\n")
+               << fmt::format("    {{ \"tid\": {}, \"name\": \"{}\", \"cpu_percent\": {:.1f} }}", threads[i].tid, escape_json(threads[i].name), threads[i].cpu_percent);
+    }
+    report << "\n  ]\n}\n";
+
+    LOG_INFO("Performance report saved to {}: {} frames, {:.2f} ms average, {:.2f} ms p99", path, frame_times_ms.size(), average_ms, get_percentile(sorted_frame_times, 0.99));
+    return static_cast<bool>(report);
+}
+
+} // namespace app
@@ -0,0 +1,450 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <app/save_state.h>
+
+#include <cpu/functions.h>
+#include <emuenv/state.h>
+#include <io/state.h>
+#include <kernel/state.h>
+#include <kernel/thread/thread_state.h>
+#include <mem/ptr.h>
+#include <util/log.h>
+
+#include <miniz.h>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace app {
+
+static constexpr uint32_t SAVE_STATE_MAGIC = 0x534B3356; // V3KS
+static constexpr uint32_t SAVE_STATE_VERSION = 1;
+
+struct SavedThread {
+    SceUID id;
+    ThreadStatus status;
+    CPUContext context;
+};
+
+struct SavedMemoryRange {
+    Address address;
+    std::vector<uint8_t> data;
+};
+
+struct SaveState {
+    std::string title_id;
+    std::vector<SavedMemoryRange> memory;
+    std::vector<SavedThread> threads;
+    std::map<SceUID, int> semaphore_values;
+    std::map<SceUID, int> eventflag_patterns;
+};
+
+static std::future<void> pending_save;
+
+// plain data appended to a buffer, the state is only read back by the same build
+class StateWriter {
+public:
+    template <typename T>
+    void write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto bytes = reinterpret_cast<const uint8_t *>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    void write(const std::string &str) {
+        write(static_cast<uint32_t>(str.size()));
+        data.insert(data.end(), str.begin(), str.end());
+    }
+
+    std::vector<uint8_t> data;
+};
+
+class StateReader {
+public:
+    StateReader(const uint8_t *data, size_t size)
+        : data(data)
+        , size(size) {}
+
+    template <typename T>
+    bool read(T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (size - offset < sizeof(T))
+            return false;
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string &str) {
+        uint32_t length;
+        if (!read(length) || size - offset < length)
+            return false;
+        str.assign(reinterpret_cast<const char *>(data + offset), length);
+        offset += length;
+        return true;
+    }
+
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t offset = 0;
+};
+
+// the threads which were running are only asked to stop, wait for them to leave the guest code
+static void wait_for_threads_halted(KernelState &kernel) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    const std::shared_lock<std::shared_mutex> lock(kernel.threads_mutex);
+    for (auto &[_, thread] : kernel.threads) {
+        std::unique_lock<std::mutex> thread_lock(thread->mutex);
+        // a thread still running at the deadline is inside a kernel call, its registers are not saved
+        thread->status_cond.wait_until(thread_lock, deadline, [&] { return thread->status != ThreadStatus::run; });
+    }
+}
+
+// list of the allocated blocks of guest memory as (address, size), mem.generation_mutex must be locked
+static std::vector<std::pair<Address, uint32_t>> get_allocated_ranges(const MemState &mem) {
+    std::vector<std::pair<Address, uint32_t>> ranges;
+    const uint64_t page_count = GiB(4) / mem.page_size;
+    for (uint64_t page = 0; page < page_count;) {
+        const AllocMemPage &alloc_page = mem.alloc_table[page];
+        if (alloc_page.allocated && alloc_page.size != 0) {
+            ranges.emplace_back(static_cast<Address>(page * mem.page_size), alloc_page.size * mem.page_size);
+            page += alloc_page.size;
+        } else {
+            page++;
+        }
+    }
+    return ranges;
+}
+
+static void copy_memory(SaveState &state, const MemState &mem) {
+    for (const auto &[address, size] : get_allocated_ranges(mem)) {
+        SavedMemoryRange &range = state.memory.emplace_back();
+        range.address = address;
+        range.data.resize(size);
+        // copied page by page, the pages can come from different host mappings
+        for (uint32_t offset = 0; offset < size; offset += mem.page_size)
+            memcpy(range.data.data() + offset, Ptr<uint8_t>(address + offset).get(mem), mem.page_size);
+    }
+}
+
+static void copy_kernel_state(SaveState &state, KernelState &kernel) {
+    {
+        const std::shared_lock<std::shared_mutex> lock(kernel.threads_mutex);
+        for (auto &[id, thread] : kernel.threads) {
+            const std::lock_guard<std::mutex> thread_lock(thread->mutex);
+            state.threads.push_back({ id, thread->status, save_context(*thread->cpu) });
+        }
+    }
+
+    const std::lock_guard<std::mutex> lock(kernel.mutex);
+    for (auto &[id, semaphore] : kernel.semaphores) {
+        const std::lock_guard<std::mutex> semaphore_lock(semaphore->mutex);
+        state.semaphore_values[id] = semaphore->val;
+    }
+    for (auto &[id, eventflag] : kernel.eventflags) {
+        const std::lock_guard<std::mutex> eventflag_lock(eventflag->mutex);
+        state.eventflag_patterns[id] = eventflag->flags;
+    }
+}
+
+static std::vector<uint8_t> serialize_kernel_state(const SaveState &state) {
+    StateWriter writer;
+    writer.write(SAVE_STATE_MAGIC);
+    writer.write(SAVE_STATE_VERSION);
+    writer.write(state.title_id);
+
+    writer.write(static_cast<uint32_t>(state.threads.size()));
+    for (const auto &thread : state.threads) {
+        writer.write(thread.id);
+        writer.write(thread.status);
+        writer.write(thread.context.cpu_registers);
+        writer.write(thread.context.fpu_registers);
+        writer.write(thread.context.cpsr);
+        writer.write(thread.context.fpscr);
+    }
+
+    writer.write(static_cast<uint32_t>(state.semaphore_values.size()));
+    for (const auto &[id, value] : state.semaphore_values) {
+        writer.write(id);
+        writer.write(value);
+    }
+    writer.write(static_cast<uint32_t>(state.eventflag_patterns.size()));
+    for (const auto &[id, pattern] : state.eventflag_patterns) {
+        writer.write(id);
+        writer.write(pattern);
+    }
+    return std::move(writer.data);
+}
+
+static bool deserialize_kernel_state(SaveState &state, const uint8_t *data, size_t size) {
+    StateReader reader(data, size);
+    uint32_t magic, version;
+    if (!reader.read(magic) || magic != SAVE_STATE_MAGIC || !reader.read(version) || version != SAVE_STATE_VERSION)
+        return false;
+    if (!reader.read(state.title_id))
+        return false;
+
+    uint32_t count;
+    if (!reader.read(count))
+        return false;
+    for (uint32_t i = 0; i < count; i++) {
+        SavedThread &thread = state.threads.emplace_back();
+        if (!reader.read(thread.id) || !reader.read(thread.status) || !reader.read(thread.context.cpu_registers)
+            || !reader.read(thread.context.fpu_registers) || !reader.read(thread.context.cpsr) || !reader.read(thread.context.fpscr))
+            return false;
+    }
+
+    for (auto *values : { &state.semaphore_values, &state.eventflag_patterns }) {
+        if (!reader.read(count))
+            return false;
+        for (uint32_t i = 0; i < count; i++) {
+            SceUID id;
+            int value;
+            if (!reader.read(id) || !reader.read(value))
+                return false;
+            (*values)[id] = value;
+        }
+    }
+    return true;
+}
+
+static std::string get_memory_entry_name(Address address) {
+    return fmt::format("memory/{:08X}", address);
+}
+
+static void write_state(const SaveState &state, const fs::path &path) {
+    const auto start = std::chrono::steady_clock::now();
+
+    FILE *file = FOPEN(path.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR("Cannot write the save state to {}", path);
+        return;
+    }
+
+    mz_zip_archive zip{};
+    bool success = mz_zip_writer_init_cfile(&zip, file, 0);
+    if (success) {
+        const auto kernel_state = serialize_kernel_state(state);
+        success = mz_zip_writer_add_mem(&zip, "kernel", kernel_state.data(), kernel_state.size(), MZ_BEST_SPEED);
+        for (const auto &range : state.memory) {
+            if (!success)
+                break;
+            success = mz_zip_writer_add_mem(&zip, get_memory_entry_name(range.address).c_str(), range.data.data(), range.data.size(), MZ_BEST_SPEED);
+        }
+        success = success && mz_zip_writer_finalize_archive(&zip);
+        if (!success)
+            LOG_ERROR("Error while writing the save state to {}: {}", path, mz_zip_get_error_string(mz_zip_get_last_error(&zip)));
+        mz_zip_writer_end(&zip);
+    }
+    fclose(file);
+
+    if (success) {
+        const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        LOG_INFO("Save state written to {} in {} ms", path, duration.count());
+    }
+}
+
+static bool read_state(SaveState &state, const fs::path &path) {
+    FILE *file = FOPEN(path.c_str(), "rb");
+    if (!file) {
+        LOG_ERROR("Cannot open the save state {}", path);
+        return false;
+    }
+
+    mz_zip_archive zip{};
+    if (!mz_zip_reader_init_cfile(&zip, file, 0, 0)) {
+        LOG_ERROR("Cannot read the save state {}: {}", path, mz_zip_get_error_string(mz_zip_get_last_error(&zip)));
+        fclose(file);
+        return false;
+    }
+
+    bool success = true;
+    const auto num_files = mz_zip_reader_get_num_files(&zip);
+    for (mz_uint i = 0; i < num_files && success; i++) {
+        mz_zip_archive_file_stat file_stat;
+        if (!mz_zip_reader_file_stat(&zip, i, &file_stat)) {
+            success = false;
+            break;
+        }
+
+        size_t size = 0;
+        void *data = mz_zip_reader_extract_to_heap(&zip, i, &size, 0);
+        if (!data) {
+            success = false;
+            break;
+        }
+
+        const std::string_view name = file_stat.m_filename;
+        if (name == "kernel") {
+            success = deserialize_kernel_state(state, static_cast<const uint8_t *>(data), size);
+        } else if (name.starts_with("memory/")) {
+            SavedMemoryRange &range = state.memory.emplace_back();
+            range.address = static_cast<Address>(std::stoul(std::string(name.substr(7)), nullptr, 16));
+            range.data.assign(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + size);
+        }
+        mz_free(data);
+    }
+
+    mz_zip_reader_end(&zip);
+    fclose(file);
+
+    if (!success)
+        LOG_ERROR("The save state {} is corrupted or was made by another version", path);
+    return success;
+}
+
+bool save_state(EmuEnvState &emuenv, const fs::path &path) {
+    if (emuenv.io.title_id.empty()) {
+        LOG_ERROR("Trying to save a state while not ingame");
+        return false;
+    }
+
+    // only one state is written at a time, the memory of a second copy could be too much
+    wait_for_save_state();
+
+    const auto pause_start = std::chrono::steady_clock::now();
+    SaveState state;
+    state.title_id = emuenv.io.title_id;
+
+    const bool was_paused = emuenv.kernel.is_threads_paused();
+    if (!was_paused) {
+        emuenv.kernel.pause_threads();
+        wait_for_threads_halted(emuenv.kernel);
+    }
+    {
+        const std::lock_guard<std::mutex> lock(emuenv.mem.generation_mutex);
+        copy_memory(state, emuenv.mem);
+    }
+    copy_kernel_state(state, emuenv.kernel);
+    if (!was_paused)
+        emuenv.kernel.resume_threads();
+
+    const auto pause_duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - pause_start);
+    LOG_INFO("Save state taken, the app was paused for {} ms", pause_duration.count());
+
+    fs::create_directories(path.parent_path());
+    pending_save = std::async(std::launch::async, [state = std::move(state), path]() {
+        write_state(state, path);
+    });
+    return true;
+}
+
+bool load_state(EmuEnvState &emuenv, const fs::path &path) {
+    if (emuenv.io.title_id.empty()) {
+        LOG_ERROR("Trying to load a state while not ingame");
+        return false;
+    }
+
+    // the state may be the one being written
+    wait_for_save_state();
+
+    SaveState state;
+    if (!read_state(state, path))
+        return false;
+    if (state.title_id != emuenv.io.title_id) {
+        LOG_ERROR("The save state {} was made for {}, not for {}", path, state.title_id, emuenv.io.title_id);
+        return false;
+    }
+
+    KernelState &kernel = emuenv.kernel;
+    MemState &mem = emuenv.mem;
+    const bool was_paused = kernel.is_threads_paused();
+    if (!was_paused) {
+        kernel.pause_threads();
+        wait_for_threads_halted(kernel);
+    }
+
+    bool success = true;
+    {
+        const std::lock_guard<std::mutex> lock(mem.generation_mutex);
+        const std::shared_lock<std::shared_mutex> threads_lock(kernel.threads_mutex);
+
+        // the allocations and threads must be the ones of the state, the host objects behind them are not restored
+        const auto ranges = get_allocated_ranges(mem);
+        success = ranges.size() == state.memory.size() && kernel.threads.size() == state.threads.size();
+        for (size_t i = 0; success && i < ranges.size(); i++)
+            success = ranges[i].first == state.memory[i].address && ranges[i].second == state.memory[i].data.size();
+        for (size_t i = 0; success && i < state.threads.size(); i++)
+            success = kernel.threads.contains(state.threads[i].id);
+
+        if (success) {
+            // only the pages which changed are written, to not trigger the write tracking of the others
+            for (const auto &range : state.memory) {
+                for (uint32_t offset = 0; offset < range.data.size(); offset += mem.page_size) {
+                    uint8_t *page = Ptr<uint8_t>(range.address + offset).get(mem);
+                    if (memcmp(page, range.data.data() + offset, mem.page_size) != 0)
+                        memcpy(page, range.data.data() + offset, mem.page_size);
+                }
+            }
+
+            // the threads blocked in the kernel at either time have a host stack which does not match the state
+            uint32_t threads_not_restored = 0;
+            for (const auto &saved_thread : state.threads) {
+                const ThreadStatePtr &thread = kernel.threads.at(saved_thread.id);
+                const std::lock_guard<std::mutex> thread_lock(thread->mutex);
+                if (thread->status == ThreadStatus::suspend && saved_thread.status == ThreadStatus::suspend)
+                    load_context(*thread->cpu, saved_thread.context);
+                else if (thread->status != ThreadStatus::dormant || saved_thread.status != ThreadStatus::dormant)
+                    threads_not_restored++;
+            }
+            if (threads_not_restored > 0)
+                LOG_WARN("{} threads were waiting in the kernel and keep their current state", threads_not_restored);
+        } else {
+            LOG_ERROR("The memory allocations or threads of the app changed since the save state {} was made", path);
+        }
+    }
+
+    if (success) {
+        // the counters are only restored if no thread is waiting on them, the waits could not be satisfied otherwise
+        const std::lock_guard<std::mutex> lock(kernel.mutex);
+        for (const auto &[id, value] : state.semaphore_values) {
+            const auto semaphore = kernel.semaphores.find(id);
+            if (semaphore == kernel.semaphores.end())
+                continue;
+            const std::lock_guard<std::mutex> semaphore_lock(semaphore->second->mutex);
+            if (semaphore->second->waiting_threads->empty())
+                semaphore->second->val = value;
+        }
+        for (const auto &[id, pattern] : state.eventflag_patterns) {
+            const auto eventflag = kernel.eventflags.find(id);
+            if (eventflag == kernel.eventflags.end())
+                continue;
+            const std::lock_guard<std::mutex> eventflag_lock(eventflag->second->mutex);
+            if (eventflag->second->waiting_threads->empty())
+                eventflag->second->flags = pattern;
+        }
+        LOG_INFO("Save state {} loaded", path);
+    }
+
+    if (!was_paused)
+        kernel.resume_threads();
+    return success;
+}
+
+void wait_for_save_state() {
+    if (pending_save.valid())
+        pending_save.get();
+}
+
+} // namespace app
@@ -17,35 +17,60 @@
 
 #pragma once
 
+#include "../sample_ring.h"
 #include "../state.h"
 
+#include <codec/resampler.h>
+#include <util/profile.h>
+
+#include <atomic>
 #include <condition_variable>
+#include <vector>
 
 #include <cubeb/cubeb.h>
 
-struct AudioBuffer {
-    std::vector<uint8_t> buffer;
-    int buffer_position;
-};
+class CubebAudioAdapter;
 
 struct CubebAudioOutPort : AudioOutPort {
-    cubeb_stream *out_stream = nullptr;
-    cubeb_stream_params spec;
-    // sync variables used to wait for the buffer to be ready
+    CubebAudioAdapter &adapter;
+    int channels = 2;
+    // filled by the guest thread and emptied by the mixer
+    SampleRing ring;
+    // the guest thread waits until the ring has at most this number of samples before adding a buffer
+    size_t max_queued_samples = 0;
+    // used by the guest thread to wait for the mixer, which only notifies it
     std::mutex mutex;
     std::condition_variable cond_var;
-    // buffer filled with audio data to pass to cubeb
-    std::vector<AudioBuffer> audio_buffers;
-    // position of the next audio buffer to put audio
-    int next_audio_buffer = 0;
-    int nb_buffers_ready = 0;
 
-    // use the destructor to destroy the cubeb stream
+    // gain of each channel, including the global volume
+    std::atomic<float> left_gain = 1.0f;
+    std::atomic<float> right_gain = 1.0f;
+
+    // only used by the mixer when the port sample rate is not the one of the stream
+    Resampler resampler{ ResamplerQuality::Low };
+
+    explicit CubebAudioOutPort(CubebAudioAdapter &adapter)
+        : adapter(adapter) {}
+    // remove the port from the mixer
     ~CubebAudioOutPort();
 };
 
+// All the ports are mixed into a single cubeb stream, at the sample rate of the PS Vita.
+// cubeb then converts this stream to the device format if needed.
 class CubebAudioAdapter : public AudioAdapter {
     cubeb *cubeb_ctx = nullptr;
+    cubeb_stream *out_stream = nullptr;
+    // in frames of the stream
+    uint32_t stream_latency = 0;
+
+    // the ports being mixed, each port removes itself when it is destroyed
+    PROFILE_LOCKABLE(std::mutex, ports_mutex, "Audio ports");
+    std::vector<CubebAudioOutPort *> ports;
+
+    static long mix_ports(cubeb_stream *stream, void *user_data, const void *input, void *output, long nframes);
+    void mix_port(CubebAudioOutPort &port, float *output, long nframes);
+
+    friend struct CubebAudioOutPort;
 
 public:
     CubebAudioAdapter(AudioState &audio_state);
@@ -56,4 +81,5 @@ public:
     void audio_output(AudioOutPort &out_port, const void *buffer) override;
     void set_volume(AudioOutPort &out_port, float volume) override;
     void switch_state(const bool pause) override;
+    int get_rest_sample(AudioOutPort &out_port) override;
 };
@@ -0,0 +1,86 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Single producer single consumer ring of samples.
+// The producer is the guest thread outputting to a port and the consumer the host audio callback,
+// neither of them takes a lock.
+class SampleRing {
+public:
+    // must be called before the producer and the consumer start using the ring
+    void init(size_t min_capacity) {
+        samples.assign(std::bit_ceil(std::max<size_t>(min_capacity, 1)), 0);
+        mask = samples.size() - 1;
+        read_pos = 0;
+        write_pos = 0;
+    }
+
+    size_t capacity() const {
+        return samples.size();
+    }
+
+    size_t size() const {
+        return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire);
+    }
+
+    // producer side, return the number of samples written
+    size_t write(const int16_t *data, size_t count) {
+        const size_t write = write_pos.load(std::memory_order_relaxed);
+        count = std::min(count, capacity() - (write - read_pos.load(std::memory_order_acquire)));
+        copy_to_ring(write, data, count);
+        write_pos.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    // consumer side, return the number of samples read
+    size_t read(int16_t *data, size_t count) {
+        const size_t read = read_pos.load(std::memory_order_relaxed);
+        count = std::min(count, write_pos.load(std::memory_order_acquire) - read);
+        copy_from_ring(read, data, count);
+        read_pos.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    void copy_to_ring(size_t pos, const int16_t *data, size_t count) {
+        const size_t start = pos & mask;
+        const size_t first_part = std::min(count, capacity() - start);
+        memcpy(&samples[start], data, first_part * sizeof(int16_t));
+        memcpy(&samples[0], data + first_part, (count - first_part) * sizeof(int16_t));
+    }
+
+    void copy_from_ring(size_t pos, int16_t *data, size_t count) const {
+        const size_t start = pos & mask;
+        const size_t first_part = std::min(count, capacity() - start);
+        memcpy(data, &samples[start], first_part * sizeof(int16_t));
+        memcpy(data + first_part, &samples[0], (count - first_part) * sizeof(int16_t));
+    }
+
+    std::vector<int16_t> samples;
+    size_t mask = 0;
+    // only ever increase, the position in the ring is given by the mask
+    std::atomic<size_t> read_pos = 0;
+    std::atomic<size_t> write_pos = 0;
+};
@@ -19,6 +19,7 @@
 
 #include <util/types.h>
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -40,6 +41,8 @@ struct AudioOutPort {
     uint64_t len_microseconds = 0;
     // last time sceAudioOutOutput was called with this port (timestamp in microseconds)
     uint64_t last_output = 0;
+    // the adapter itself blocks until the host needs the buffer, there is no need to emulate it
+    bool is_paced = false;
 
     // current config
     int type = 0;
@@ -87,6 +90,24 @@ struct AudioState {
     AudioInPort in_port;
     std::string audio_backend;
     float global_volume = 1;
+    // called from the guest thread with each buffer output to a port, before the adapter gets it (to record the app)
+    // it must be set before the app starts
+    std::function<void(const AudioOutPort &out_port, const void *buffer)> output_callback;
+    // number of samples the host should have queued for each port, in milliseconds (0 to use the minimum latency of the backend)
+    int target_latency_ms = 0;
+
+    // the host needed samples which were not output yet
+    std::atomic<uint32_t> underrun_count = 0;
+    // buffers output by the guest which had to be dropped
+    std::atomic<uint32_t> overrun_count = 0;
+    // samples queued in the host for the last port the guest output to, in milliseconds
+    std::atomic<uint32_t> queued_ms = 0;
+
+    // refreshed by update_stats, share of the time spent updating the NGS systems and in the audio decoders (in percent)
+    float ngs_load = 0.0f;
+    float decode_load = 0.0f;
+    // longest NGS update between the last two calls to update_stats, in microseconds
+    uint32_t ngs_update_max_time = 0;
 
     bool init(const std::string &adapter_name);
     void set_backend(const std::string &adapter_name);
@@ -96,4 +117,6 @@ struct AudioState {
     void set_global_volume(float volume);
     void switch_state(const bool pause);
     int get_rest_sample(AudioOutPort &out_port);
+    // take the audio pipeline stats gathered during the last elapsed_ms milliseconds
+    void update_stats(uint32_t elapsed_ms);
 };
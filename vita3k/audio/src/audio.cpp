@@ -20,11 +20,16 @@
 #include <audio/impl/cubeb_audio.h>
 #include <audio/impl/sdl_audio.h>
 
+#include <util/audio_stats.h>
 #include <util/log.h>
 
 #include <cassert>
 #include <cstring>
 
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#endif
+
 bool AudioState::init(const std::string &adapter_name) {
     set_backend(adapter_name);
     if (!adapter)
@@ -64,8 +69,20 @@ AudioOutPortPtr AudioState::open_port(int nb_channels, int freq, int nb_sample)
 }
 
 void AudioState::audio_output(AudioOutPort &out_port, const void *buffer) {
+    if (output_callback)
+        output_callback(out_port, buffer);
     adapter->audio_output(out_port, buffer);
 
+    if (out_port.freq > 0) {
+        queued_ms = static_cast<uint32_t>(adapter->get_rest_sample(out_port) * 1000ULL / out_port.freq);
+#ifdef TRACY_ENABLE
+        TracyPlot("Audio queued (ms)", static_cast<int64_t>(queued_ms.load()));
+#endif
+    }
+
+    if (out_port.is_paced)
+        return;
+
     uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     uint64_t diff = now - out_port.last_output;
     uint64_t to_wait = out_port.len_microseconds - diff;
@@ -104,3 +121,14 @@ void AudioState::switch_state(const bool pause) {
 int AudioState::get_rest_sample(AudioOutPort &out_port) {
     return adapter->get_rest_sample(out_port);
 }
+
+void AudioState::update_stats(uint32_t elapsed_ms) {
+    if (elapsed_ms == 0)
+        return;
+
+    // the time is summed over all the guest threads, so this can go above 100%
+    const float elapsed_us = elapsed_ms * 1000.0f;
+    ngs_load = audio_pipeline_stats.ngs_update_time.exchange(0) * 100.0f / elapsed_us;
+    decode_load = audio_pipeline_stats.decode_time.exchange(0) * 100.0f / elapsed_us;
+    ngs_update_max_time = audio_pipeline_stats.ngs_update_max_time.exchange(0);
+}
@@ -18,57 +18,117 @@
 #include "audio/impl/cubeb_audio.h"
 #include "util/log.h"
 
-static long impl_cubeb_audio_callback(cubeb_stream *stream, void *user_data, const void *input, void *output, long nframes) {
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+// sample rate of the mixed stream, the one of the main port
+static constexpr uint32_t MIXER_FREQ = 48000;
+// number of frames read at once from a port
+static constexpr long MIXER_CHUNK_FRAMES = 512;
+
+// the guest thread gives up on a buffer if the mixer didn't make room for it after this number of buffer durations
+static constexpr int MAX_OUTPUT_WAITS = 4;
+
+static void impl_cubeb_state_callback(cubeb_stream *stm, void *user, cubeb_state state) {
+    // we must give this function as a parameter to cubeb, but we don't care about it
+}
+
+CubebAudioOutPort::~CubebAudioOutPort() {
+    const std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> lock(adapter.ports_mutex);
+    std::erase(adapter.ports, this);
+}
+
+long CubebAudioAdapter::mix_ports(cubeb_stream *stream, void *user_data, const void *input, void *output, long nframes) {
     assert(user_data != nullptr);
     assert(stream != nullptr);
-    CubebAudioOutPort *port = static_cast<CubebAudioOutPort *>(user_data);
-    uint8_t *output_buffer = static_cast<uint8_t *>(output);
-
-    int bytes_given = 0;
-    const int bytes_to_give = nframes * port->spec.channels * sizeof(uint16_t);
-    while (bytes_given < bytes_to_give) {
-        if (port->nb_buffers_ready == 0) {
-            // no data available, should we wait for it or return nothing?
-            // return nothing for now
-            break;
-        }
-
-        AudioBuffer &audio_buffer = port->audio_buffers[port->next_audio_buffer];
-        // compute the number of bytes we can copy from this buffer to the output
-        const int bytes_to_copy = std::min(bytes_to_give - bytes_given, port->len_bytes - audio_buffer.buffer_position);
-        memcpy(&output_buffer[bytes_given], &audio_buffer.buffer[audio_buffer.buffer_position], bytes_to_copy);
-        audio_buffer.buffer_position += bytes_to_copy;
-
-        if (audio_buffer.buffer_position == port->len_bytes) {
-            // if we are done with this buffer, tell it
-            std::unique_lock<std::mutex> lock(port->mutex);
-            port->next_audio_buffer = (port->next_audio_buffer + 1) % port->audio_buffers.size();
-            port->nb_buffers_ready--;
-            lock.unlock();
+    PROFILE_THREAD_NAME_ONCE("Audio mixer");
+    PROFILE_SCOPE("Audio mix");
+    CubebAudioAdapter *adapter = static_cast<CubebAudioAdapter *>(user_data);
+    float *output_buffer = static_cast<float *>(output);
+
+    std::fill_n(output_buffer, nframes * 2, 0.0f);
+    {
+        // only held for long by this callback, the ports are opened and released rarely
+        const std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> lock(adapter->ports_mutex);
+        for (CubebAudioOutPort *port : adapter->ports) {
+            adapter->mix_port(*port, output_buffer, nframes);
             port->cond_var.notify_one();
         }
-
-        bytes_given += bytes_to_copy;
     }
 
-    return nframes;
-}
+    for (long i = 0; i < nframes * 2; i++)
+        output_buffer[i] = std::clamp(output_buffer[i], -1.0f, 1.0f);
 
-static void impl_cubeb_state_callback(cubeb_stream *stm, void *user, cubeb_state state) {
-    // we must give this function as a parameter to cubeb, but we don't care about it
+    return nframes;
 }
 
-CubebAudioOutPort::~CubebAudioOutPort() {
-    if (out_stream) {
-        cubeb_stream_stop(out_stream);
-        cubeb_stream_destroy(out_stream);
+void CubebAudioAdapter::mix_port(CubebAudioOutPort &port, float *output, long nframes) {
+    const float left_gain = port.left_gain / 32768.0f;
+    const float right_gain = port.right_gain / 32768.0f;
+    // mono ports use the same sample for both channels
+    const int right_channel = port.channels - 1;
+
+    long frames_mixed = 0;
+    if (port.freq == MIXER_FREQ) {
+        int16_t samples[MIXER_CHUNK_FRAMES * 2];
+        while (frames_mixed < nframes) {
+            const long frames_to_read = std::min(nframes - frames_mixed, MIXER_CHUNK_FRAMES);
+            const long frames_read = static_cast<long>(port.ring.read(samples, frames_to_read * port.channels) / port.channels);
+            float *dest = output + frames_mixed * 2;
+            for (long i = 0; i < frames_read; i++) {
+                dest[i * 2] += samples[i * port.channels] * left_gain;
+                dest[i * 2 + 1] += samples[i * port.channels + right_channel] * right_gain;
+            }
+
+            frames_mixed += frames_read;
+            if (frames_read < frames_to_read)
+                break;
+        }
+    } else {
+        // the ports are never faster than the mixer, so a chunk of output never needs more than a chunk of input
+        // (plus the frames the filter still needs at the start)
+        static constexpr long INPUT_CHUNK_FRAMES = MIXER_CHUNK_FRAMES + 64;
+        int16_t samples[INPUT_CHUNK_FRAMES * 2];
+        float input[INPUT_CHUNK_FRAMES * 2];
+        float resampled[MIXER_CHUNK_FRAMES * 2];
+        while (frames_mixed < nframes) {
+            const long frames_to_mix = std::min(nframes - frames_mixed, MIXER_CHUNK_FRAMES);
+            const long frames_to_read = std::min<long>(port.resampler.get_input_needed(frames_to_mix), INPUT_CHUNK_FRAMES);
+            const long frames_read = static_cast<long>(port.ring.read(samples, frames_to_read * port.channels) / port.channels);
+            for (long i = 0; i < frames_read; i++) {
+                input[i * 2] = samples[i * port.channels];
+                input[i * 2 + 1] = samples[i * port.channels + right_channel];
+            }
+
+            const long frames_resampled = port.resampler.process(input, frames_read, resampled, frames_to_mix);
+            float *dest = output + frames_mixed * 2;
+            for (long i = 0; i < frames_resampled; i++) {
+                dest[i * 2] += resampled[i * 2] * left_gain;
+                dest[i * 2 + 1] += resampled[i * 2 + 1] * right_gain;
+            }
+
+            frames_mixed += frames_resampled;
+            if (frames_resampled < frames_to_mix)
+                break;
+        }
     }
+
+    // the port ran dry in the middle of a callback, the guest is outputting too late
+    // (when nothing is given at all, the port is simply not used at the moment)
+    if (frames_mixed > 0 && frames_mixed < nframes)
+        state.underrun_count++;
 }
 
 CubebAudioAdapter::CubebAudioAdapter(AudioState &audio_state)
     : AudioAdapter(audio_state) {}
 
 CubebAudioAdapter::~CubebAudioAdapter() {
+    if (out_stream) {
+        cubeb_stream_stop(out_stream);
+        cubeb_stream_destroy(out_stream);
+    }
     if (cubeb_ctx)
         cubeb_destroy(cubeb_ctx);
 }
@@ -79,79 +139,98 @@ bool CubebAudioAdapter::init() {
         return false;
     }
 
-    return true;
-}
-
-AudioOutPortPtr CubebAudioAdapter::open_port(int nb_channels, int freq, int nb_sample) {
-    std::shared_ptr<CubebAudioOutPort> port = std::make_shared<CubebAudioOutPort>();
-    port->spec = {
-        // all the ps vita samples are signed 16 bits low edian
-        .format = CUBEB_SAMPLE_S16LE,
-        .rate = static_cast<uint32_t>(freq),
-        .channels = static_cast<uint32_t>(nb_channels),
-        .layout = CUBEB_LAYOUT_UNDEFINED,
-        // we could use the params of sceAudioOutOpenPort to select some prefs, although I don't think it will change anything
+    cubeb_stream_params spec = {
+        .format = CUBEB_SAMPLE_FLOAT32NE,
+        .rate = MIXER_FREQ,
+        .channels = 2,
+        .layout = CUBEB_LAYOUT_STEREO,
         .prefs = CUBEB_STREAM_PREF_NONE
     };
 
-    uint32_t latency;
-    cubeb_get_min_latency(cubeb_ctx, &port->spec, &latency);
+    if (cubeb_get_min_latency(cubeb_ctx, &spec, &stream_latency) != CUBEB_OK)
+        stream_latency = MIXER_CHUNK_FRAMES;
 
-    if (cubeb_stream_init(cubeb_ctx, &port->out_stream, "Vita3K audio out", nullptr, nullptr, nullptr,
-            &port->spec, latency, impl_cubeb_audio_callback, impl_cubeb_state_callback, port.get())
+    if (cubeb_stream_init(cubeb_ctx, &out_stream, "Vita3K audio out", nullptr, nullptr, nullptr,
+            &spec, stream_latency, mix_ports, impl_cubeb_state_callback, this)
         != CUBEB_OK) {
         LOG_ERROR("Could not initialize cubeb stream");
-        return nullptr;
+        out_stream = nullptr;
+        return false;
     }
 
-    port->len_bytes = nb_sample * nb_channels * sizeof(uint16_t);
-
-    // allocate enough buffers to be able to satisfy a callback (+1 to make sure one buffer can be ready)
-    const int nb_buffers = (latency + nb_sample - 1) / nb_sample + 1;
-    port->audio_buffers.resize(nb_buffers);
-    for (AudioBuffer &audio_buffer : port->audio_buffers) {
-        // initialize all the buffers
-        audio_buffer.buffer.resize(port->len_bytes);
-        audio_buffer.buffer_position = 0;
-    }
+    cubeb_stream_start(out_stream);
+    return true;
+}
 
-    cubeb_stream_start(port->out_stream);
+AudioOutPortPtr CubebAudioAdapter::open_port(int nb_channels, int freq, int nb_sample) {
+    std::shared_ptr<CubebAudioOutPort> port = std::make_shared<CubebAudioOutPort>(*this);
+    port->channels = nb_channels;
+    // also set by sceAudioOutOpenPort, but the mixer may need it before
+    port->freq = freq;
+    port->len_bytes = nb_sample * nb_channels * sizeof(int16_t);
+    port->len_microseconds = (nb_sample * 1'000'000ULL) / freq;
+    port->is_paced = true;
+
+    port->resampler.set_rates(freq, MIXER_FREQ);
+
+    // keep enough samples to satisfy a callback or to reach the target latency, plus one buffer being added
+    const uint32_t callback_latency = static_cast<uint64_t>(stream_latency) * freq / MIXER_FREQ;
+    const uint32_t target_latency = static_cast<uint64_t>(state.target_latency_ms) * freq / 1000;
+    port->max_queued_samples = static_cast<size_t>(std::max(callback_latency, target_latency)) * nb_channels;
+    port->ring.init(port->max_queued_samples + nb_sample * nb_channels);
+
+    const std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> lock(ports_mutex);
+    ports.push_back(port.get());
     return port;
 }
 
 void CubebAudioAdapter::audio_output(AudioOutPort &out_port, const void *buffer) {
     CubebAudioOutPort &port = static_cast<CubebAudioOutPort &>(out_port);
 
-    std::unique_lock<std::mutex> lock(port.mutex);
-    if (port.nb_buffers_ready == port.audio_buffers.size()) {
-        port.cond_var.wait(lock);
-    }
+    // the buffer can be empty to drain the port
+    if (!buffer)
+        return;
 
-    assert(port.nb_buffers_ready < port.audio_buffers.size());
-    if (buffer) {
-        // the buffer can be empty to drain the port
-        int next_buffer_pos = (port.next_audio_buffer + port.nb_buffers_ready) % port.audio_buffers.size();
-        // we could unlock the lock here and re-lock it right after, but will this be faster?
-        memcpy(port.audio_buffers[next_buffer_pos].buffer.data(), buffer, port.len_bytes);
-        port.audio_buffers[next_buffer_pos].buffer_position = 0;
-        port.nb_buffers_ready++;
+    // this is what makes sceAudioOutOutput blocking, the mixer notifies each time it takes some samples
+    // as it does so without the lock, a notification can be missed so only wait for a buffer duration at a time
+    std::unique_lock<std::mutex> lock(port.mutex);
+    int nb_waits = 0;
+    while (port.ring.size() > port.max_queued_samples) {
+        if (++nb_waits > MAX_OUTPUT_WAITS) {
+            // the stream is not running, drop this buffer rather than blocking the guest
+            state.overrun_count++;
+            return;
+        }
+        port.cond_var.wait_for(lock, std::chrono::microseconds(port.len_microseconds));
     }
-
     lock.unlock();
-    port.cond_var.notify_one();
+
+    const size_t nb_samples = port.len_bytes / sizeof(int16_t);
+    if (port.ring.write(static_cast<const int16_t *>(buffer), nb_samples) < nb_samples)
+        state.overrun_count++;
 }
 
 void CubebAudioAdapter::set_volume(AudioOutPort &out_port, float volume) {
     CubebAudioOutPort &port = static_cast<CubebAudioOutPort &>(out_port);
-    cubeb_stream_set_volume(port.out_stream, volume);
+    // the volume is the average of both channels, the mixer applies each of them
+    const int average_volume = (port.left_channel_volume + port.right_channel_volume) / 2;
+    if (average_volume == 0) {
+        port.left_gain = 0.0f;
+        port.right_gain = 0.0f;
+        return;
+    }
+    port.left_gain = volume * port.left_channel_volume / average_volume;
+    port.right_gain = volume * port.right_channel_volume / average_volume;
 }
 
 void CubebAudioAdapter::switch_state(const bool pause) {
-    for (auto &[_, out_port] : state.out_ports) {
-        CubebAudioOutPort &port = static_cast<CubebAudioOutPort &>(*out_port);
-        if (pause)
-            cubeb_stream_stop(port.out_stream);
-        else
-            cubeb_stream_start(port.out_stream);
-    }
+    if (pause)
+        cubeb_stream_stop(out_stream);
+    else
+        cubeb_stream_start(out_stream);
+}
+
+int CubebAudioAdapter::get_rest_sample(AudioOutPort &out_port) {
+    CubebAudioOutPort &port = static_cast<CubebAudioOutPort &>(out_port);
+    return static_cast<int>(port.ring.size() / port.channels);
 }
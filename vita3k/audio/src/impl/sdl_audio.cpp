@@ -17,6 +17,7 @@
 
 #include "audio/impl/sdl_audio.h"
 #include "util/log.h"
+#include "util/profile.h"
 #include <SDL3/SDL_audio.h>
 #include <SDL3/SDL_hints.h>
 
@@ -35,6 +36,7 @@
 void SDLCALL SDLAudioAdapter::thread_wakeup_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount) {
     assert(userdata != nullptr);
     assert(stream != nullptr);
+    PROFILE_THREAD_NAME_ONCE("Audio stream");
     SDLAudioOutPort *port = static_cast<SDLAudioOutPort *>(userdata);
     const int samples_available = port->adapter.get_rest_sample(*port);
     if (samples_available < 2 * port->adapter.device_buffer_samples || additional_amount > 0) {
@@ -0,0 +1,77 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <mem/allocator.h>
+#include <mem/util.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+// same size as the allocator of the guest main memory, in pages
+static constexpr size_t ALLOCATOR_SLOTS = KiB(128);
+
+static void BM_bitmap_allocator_alloc_free(benchmark::State &state) {
+    const auto alloc_size = static_cast<uint32_t>(state.range(0));
+    const bool best_fit = state.range(1) != 0;
+    BitmapAllocator allocator(ALLOCATOR_SLOTS);
+
+    for (auto _ : state) {
+        uint32_t size = alloc_size;
+        const int offset = allocator.allocate_from(0, size, best_fit);
+        benchmark::DoNotOptimize(offset);
+        allocator.free(offset, size);
+    }
+}
+BENCHMARK(BM_bitmap_allocator_alloc_free)->ArgsProduct({ { 1, 16, 256 }, { 0, 1 } });
+
+// allocations of random sizes freed in random order, so that the bitmap gets fragmented
+static void BM_bitmap_allocator_fragmented(benchmark::State &state) {
+    const bool best_fit = state.range(0) != 0;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> size_dist(1, 64);
+
+    BitmapAllocator allocator(ALLOCATOR_SLOTS);
+    std::vector<std::pair<int, uint32_t>> live;
+    for (auto _ : state) {
+        uint32_t size = size_dist(rng);
+        const int offset = allocator.allocate_from(0, size, best_fit);
+        if (offset >= 0)
+            live.emplace_back(offset, size);
+
+        // keep the allocator about half full
+        if (!live.empty() && (live.size() > ALLOCATOR_SLOTS / 64 || offset < 0)) {
+            const size_t victim = rng() % live.size();
+            allocator.free(live[victim].first, live[victim].second);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+    }
+}
+BENCHMARK(BM_bitmap_allocator_fragmented)->Arg(0)->Arg(1);
+
+static void BM_bitmap_allocator_free_slot_count(benchmark::State &state) {
+    BitmapAllocator allocator(ALLOCATOR_SLOTS);
+    for (uint32_t offset = 0; offset < ALLOCATOR_SLOTS; offset += 8)
+        allocator.allocate_at(offset, 3);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(allocator.free_slot_count(0, ALLOCATOR_SLOTS));
+}
+BENCHMARK(BM_bitmap_allocator_free_slot_count);
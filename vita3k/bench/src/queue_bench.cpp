@@ -0,0 +1,52 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <threads/queue.h>
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+static void BM_queue_push_pop(benchmark::State &state) {
+    Queue<int> queue;
+    for (auto _ : state) {
+        queue.push(1);
+        benchmark::DoNotOptimize(queue.pop());
+    }
+}
+BENCHMARK(BM_queue_push_pop);
+
+// one producer and one consumer, with the queue bounded like the display queue of gxm
+static void BM_queue_producer_consumer(benchmark::State &state) {
+    Queue<int> queue;
+    queue.maxPendingCount_ = static_cast<unsigned int>(state.range(0));
+
+    std::thread consumer([&] {
+        while (queue.pop())
+            ;
+    });
+
+    for (auto _ : state)
+        queue.push(1);
+
+    queue.wait_empty();
+    queue.abort();
+    consumer.join();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_queue_producer_consumer)->Arg(1)->Arg(16)->UseRealTime();
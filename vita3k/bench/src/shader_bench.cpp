@@ -0,0 +1,71 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <shader/spirv_recompiler.h>
+
+#include <util/fs.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+// translation of the shaders of a corpus of .gxp files, found in the folder given by VITA3K_BENCH_GXP_DIR
+static void BM_convert_gxp_corpus(benchmark::State &state, shader::Target target) {
+    const char *corpus_dir = std::getenv("VITA3K_BENCH_GXP_DIR");
+    if (!corpus_dir) {
+        state.SkipWithError("VITA3K_BENCH_GXP_DIR is not set");
+        return;
+    }
+
+    std::vector<std::pair<std::string, std::vector<char>>> programs;
+    for (const auto &entry : fs::directory_iterator(fs_utils::utf8_to_path(corpus_dir))) {
+        if (entry.path().extension() != ".gxp")
+            continue;
+        std::vector<char> program;
+        if (fs_utils::read_data(entry.path(), program))
+            programs.emplace_back(fs_utils::path_to_utf8(entry.path().filename()), std::move(program));
+    }
+    if (programs.empty()) {
+        state.SkipWithError("No .gxp file in VITA3K_BENCH_GXP_DIR");
+        return;
+    }
+
+    // same features and hints as convert_gxp_to_glsl_from_filepath
+    const FeatureState features{
+        .support_shader_interlock = true,
+        .direct_fragcolor = false
+    };
+    shader::Hints hints{
+        .attributes = nullptr,
+        .color_format = SCE_GXM_COLOR_FORMAT_U8U8U8U8_ABGR,
+    };
+    std::fill_n(hints.vertex_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+    std::fill_n(hints.fragment_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+
+    for (auto _ : state) {
+        for (const auto &[name, program] : programs) {
+            const auto shader = shader::convert_gxp(*reinterpret_cast<const SceGxmProgram *>(program.data()), name, features, target, hints);
+            benchmark::DoNotOptimize(shader);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * programs.size());
+}
+BENCHMARK_CAPTURE(BM_convert_gxp_corpus, spirv_vulkan, shader::Target::SpirVVulkan)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_convert_gxp_corpus, glsl_opengl, shader::Target::GLSLOpenGL)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,107 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <renderer/functions.h>
+
+#include <gxm/types.h>
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace renderer;
+
+static std::vector<uint8_t> random_data(size_t size) {
+    std::mt19937 rng(42);
+    std::vector<uint8_t> data(size);
+    for (auto &byte : data)
+        byte = static_cast<uint8_t>(rng());
+    return data;
+}
+
+static void BM_decompress_texture(benchmark::State &state, SceGxmTextureBaseFormat format) {
+    const auto size = static_cast<uint32_t>(state.range(0));
+    // no supported block format takes more than one byte per pixel
+    const auto blocks = random_data(size * size);
+    std::vector<uint32_t> pixels(size * size);
+
+    for (auto _ : state) {
+        texture::decompress_compressed_texture(format, pixels.data(), blocks.data(), size, size);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * pixels.size() * sizeof(uint32_t));
+}
+BENCHMARK_CAPTURE(BM_decompress_texture, bc1, SCE_GXM_TEXTURE_BASE_FORMAT_UBC1)->Arg(256)->Arg(1024);
+BENCHMARK_CAPTURE(BM_decompress_texture, bc3, SCE_GXM_TEXTURE_BASE_FORMAT_UBC3)->Arg(256)->Arg(1024);
+BENCHMARK_CAPTURE(BM_decompress_texture, bc5, SCE_GXM_TEXTURE_BASE_FORMAT_UBC5)->Arg(256)->Arg(1024);
+BENCHMARK_CAPTURE(BM_decompress_texture, pvrt2bpp, SCE_GXM_TEXTURE_BASE_FORMAT_PVRT2BPP)->Arg(256)->Arg(1024);
+BENCHMARK_CAPTURE(BM_decompress_texture, pvrt4bpp, SCE_GXM_TEXTURE_BASE_FORMAT_PVRT4BPP)->Arg(256)->Arg(1024);
+
+static void BM_swizzled_to_linear(benchmark::State &state) {
+    const auto size = static_cast<uint16_t>(state.range(0));
+    const auto swizzled = random_data(size * size * 4);
+    std::vector<uint8_t> linear(swizzled.size());
+
+    for (auto _ : state) {
+        texture::swizzled_texture_to_linear_texture(linear.data(), swizzled.data(), size, size, 32);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * linear.size());
+}
+BENCHMARK(BM_swizzled_to_linear)->Arg(256)->Arg(1024);
+
+static void BM_tiled_to_linear(benchmark::State &state) {
+    const auto size = static_cast<uint16_t>(state.range(0));
+    const auto tiled = random_data(size * size * 4);
+    std::vector<uint8_t> linear(tiled.size());
+
+    for (auto _ : state) {
+        texture::tiled_texture_to_linear_texture(linear.data(), tiled.data(), size, size, 32);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * linear.size());
+}
+BENCHMARK(BM_tiled_to_linear)->Arg(256)->Arg(1024);
+
+// the texture cache hashes the textures from the guest memory on every use when write tracking is not used
+static void BM_hash_texture_data(benchmark::State &state) {
+    const auto size = static_cast<uint32_t>(state.range(0));
+    MemState mem;
+    if (!init(mem, false)) {
+        state.SkipWithError("Cannot reserve the guest memory");
+        return;
+    }
+
+    const uint32_t texture_size = size * size * 4;
+    const Address address = alloc(mem, texture_size, "bench texture");
+    const auto data = random_data(texture_size);
+    std::memcpy(Ptr<uint8_t>(address).get(mem), data.data(), texture_size);
+
+    SceGxmTexture gxm_texture{};
+    gxm_texture.data_addr = address >> 2;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(texture::hash_texture_data(gxm_texture, texture_size, mem));
+    state.SetBytesProcessed(state.iterations() * texture_size);
+}
+BENCHMARK(BM_hash_texture_data)->Arg(256)->Arg(1024);
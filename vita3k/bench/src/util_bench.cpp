@@ -0,0 +1,42 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <util/bytes.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+// the F16 uniforms are converted on the CPU when they are set
+static void BM_float_to_half(benchmark::State &state) {
+    const auto count = static_cast<int>(state.range(0));
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> distribution(-1000.0f, 1000.0f);
+    std::vector<float> floats(count);
+    for (auto &value : floats)
+        value = distribution(rng);
+    std::vector<uint16_t> halves(count);
+
+    for (auto _ : state) {
+        float_to_half(floats.data(), halves.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * count * sizeof(float));
+}
+BENCHMARK(BM_float_to_half)->Arg(4)->Arg(64)->Arg(4096);
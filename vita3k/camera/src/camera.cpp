@@ -26,6 +26,12 @@
 #include <SDL3/SDL_camera.h>
 #include <SDL3/SDL_timer.h>
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 struct stbi_deleter {
     void operator()(stbi_uc *d) const { stbi_image_free(d); }
 };
@@ -61,6 +67,63 @@ Camera::Camera()
     : pImpl(std::make_unique<CameraImpl>()) {}
 Camera::~Camera() = default;
 
+// size of the pixels of a frame, the planes of a YV12 frame follow each other
+static size_t get_frame_size(const SDL_Surface *frame) {
+    const size_t size = static_cast<size_t>(frame->pitch) * frame->h;
+    return frame->format == SDL_PIXELFORMAT_YV12 ? size * 3 / 2 : size;
+}
+
+// copies a frame acquired from the camera to the frame kept by the camera, its buffer is reused when the frames have the same layout
+static bool store_camera_frame(SDL_SurfacePtr &frame, SDL_Surface *acquired) {
+    if (frame && frame->w == acquired->w && frame->h == acquired->h && frame->format == acquired->format && frame->pitch == acquired->pitch
+        && !SDL_MUSTLOCK(frame.get()) && !SDL_MUSTLOCK(acquired)) {
+        memcpy(frame->pixels, acquired->pixels, get_frame_size(acquired));
+        return true;
+    }
+
+    frame.reset(SDL_DuplicateSurface(acquired));
+    return frame != nullptr;
+}
+
+// splits the Y0 U0 Y1 V0 pixels of a SDL_PIXELFORMAT_YUY2 frame into 3 planes
+static void yuy2_to_planar(const uint8_t *packed, int pitch, int width, int height, uint8_t *Y, uint8_t *U, uint8_t *V) {
+    const int half_width = width / 2;
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row = packed + static_cast<ptrdiff_t>(y) * pitch;
+        uint8_t *Y_row = Y + static_cast<ptrdiff_t>(y) * width;
+        uint8_t *U_row = U + static_cast<ptrdiff_t>(y) * half_width;
+        uint8_t *V_row = V + static_cast<ptrdiff_t>(y) * half_width;
+
+        // 16 pixels at a time
+        int x = 0;
+#if defined(__aarch64__)
+        for (; x + 16 <= width; x += 16) {
+            const uint8x8x4_t pixels = vld4_u8(row + x * 2);
+            vst2_u8(Y_row + x, uint8x8x2_t{ { pixels.val[0], pixels.val[2] } });
+            vst1_u8(U_row + x / 2, pixels.val[1]);
+            vst1_u8(V_row + x / 2, pixels.val[3]);
+        }
+#elif defined(__x86_64__) || defined(_M_X64)
+        const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+        for (; x + 16 <= width; x += 16) {
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x * 2));
+            const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x * 2 + 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(Y_row + x), _mm_packus_epi16(_mm_and_si128(first, low_bytes), _mm_and_si128(second, low_bytes)));
+            // U0 V0 U1 V1 ...
+            const __m128i uv = _mm_packus_epi16(_mm_srli_epi16(first, 8), _mm_srli_epi16(second, 8));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(U_row + x / 2), _mm_packus_epi16(_mm_and_si128(uv, low_bytes), _mm_setzero_si128()));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(V_row + x / 2), _mm_packus_epi16(_mm_srli_epi16(uv, 8), _mm_setzero_si128()));
+        }
+#endif
+        for (; x + 1 < width; x += 2) {
+            Y_row[x] = row[x * 2];
+            Y_row[x + 1] = row[x * 2 + 2];
+            U_row[x / 2] = row[x * 2 + 1];
+            V_row[x / 2] = row[x * 2 + 3];
+        }
+    }
+}
+
 static bool init_web_camera(Camera *self) {
     // open web camera via SDL3
     int num_cameras;
@@ -310,9 +373,9 @@ int Camera::read(SceCameraRead *read, void *pIBase, void *pUBase, void *pVBase,
         if (next_surface)
             SDL_ReleaseCameraFrame(pImpl->sdl_camera.get(), next_surface);
         if (surface) {
-            pImpl->frame.reset(SDL_DuplicateSurface(surface));
+            const bool stored = store_camera_frame(pImpl->frame, surface);
             SDL_ReleaseCameraFrame(pImpl->sdl_camera.get(), surface);
-            LOG_ERROR_IF(!pImpl->frame, "Failed to duplicate camera surface: {}", SDL_GetError());
+            LOG_ERROR_IF(!stored, "Failed to duplicate camera surface: {}", SDL_GetError());
             last_frame_timestamp_us = timestampNS / SDL_NS_PER_US + tick_diff_us;
         }
     }
@@ -339,21 +402,8 @@ int Camera::read(SceCameraRead *read, void *pIBase, void *pUBase, void *pVBase,
                 LOG_ERROR("Failed to lock camera frame surface: {}", SDL_GetError());
                 goto BAD_FRAME;
             };
-            uint8_t const *packed = (uint8_t *)pImpl->frame->pixels;
-            uint8_t *Y = (uint8_t *)pIBase;
-            uint8_t *U = (uint8_t *)pUBase;
-            uint8_t *V = (uint8_t *)pVBase;
-            int pitch = pImpl->frame->pitch;
-            for (ptrdiff_t y = 0; y < height; y++) {
-                uint8_t const *row = packed + y * pitch;
-                for (ptrdiff_t x = 0; x < width; x += 2) {
-                    ptrdiff_t pair_idx = x / 2;
-                    Y[y * width + x] = row[pair_idx * 4];
-                    Y[y * width + x + 1] = row[pair_idx * 4 + 2];
-                    U[y * (width / 2) + pair_idx] = row[pair_idx * 4 + 1];
-                    V[y * (width / 2) + pair_idx] = row[pair_idx * 4 + 3];
-                }
-            }
+            yuy2_to_planar(static_cast<const uint8_t *>(pImpl->frame->pixels), pImpl->frame->pitch, width, height,
+                static_cast<uint8_t *>(pIBase), static_cast<uint8_t *>(pUBase), static_cast<uint8_t *>(pVBase));
             SDL_UnlockSurface(pImpl->frame.get());
         } else {
             sizeIBase = std::min(sizeIBase, (SceSize)(pImpl->frame->pitch * pImpl->frame->h)); // here pitch is width in bytes
@@ -0,0 +1,123 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <codec/resampler.h>
+
+#include <util/fs.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct AVBufferRef;
+struct AVCodecContext;
+struct AVFormatContext;
+struct AVFrame;
+struct AVPacket;
+struct AVStream;
+struct SwsContext;
+
+/**
+ * @brief Records the frames displayed by the app and the sound of its audio ports to a video file
+ *
+ * The callers only queue the frames and the samples, the encoding and the muxing run on a thread of the recorder.
+ * The video is encoded with a hardware H.264 encoder when one can be opened, with the software encoders of the
+ * FFmpeg build otherwise. The audio ports are mixed into a 48 kHz stereo AAC track, the position of each port
+ * in it comes from the time it outputs at, so that the sound stays in sync with the frames.
+ */
+class VideoRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    VideoRecorder() = default;
+    ~VideoRecorder();
+    VideoRecorder(const VideoRecorder &) = delete;
+    VideoRecorder &operator=(const VideoRecorder &) = delete;
+
+    // the video size is the one of the first frame, the frames of another size are scaled to it
+    bool start(const fs::path &path, int fps);
+    // encodes what is still queued and closes the file
+    void stop();
+
+    // frame read back from the display (RGBA), it is dropped if the previous one has the same timestamp
+    void add_frame(std::vector<uint32_t> &&frame, uint32_t width, uint32_t height);
+    // interleaved s16 samples output to an audio port, port identifies the port in the mix
+    void add_audio(const void *port, const int16_t *samples, uint32_t nb_frames, int nb_channels, int freq, float volume);
+
+private:
+    struct QueuedFrame {
+        std::vector<uint32_t> pixels;
+        uint32_t width;
+        uint32_t height;
+        int64_t pts;
+    };
+
+    struct AudioPort {
+        Resampler resampler;
+        int freq = 0;
+        // next 48 kHz frame of the mix this port writes to
+        int64_t position = 0;
+    };
+
+    bool open_output(uint32_t width, uint32_t height);
+    bool open_video_encoder(uint32_t width, uint32_t height);
+    bool open_audio_encoder();
+    void encode_thread();
+    void encode_video(const QueuedFrame &frame);
+    // called with the lock held, it is released while encoding
+    void encode_audio(std::unique_lock<std::mutex> &lock, bool flush);
+    bool write_packets(AVCodecContext *context, AVStream *stream);
+    void close();
+    int64_t get_mix_position(Clock::time_point time) const;
+
+    fs::path path;
+    int fps = 0;
+    Clock::time_point start_time;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread thread;
+    bool recording = false;
+    bool stopping = false;
+    std::deque<QueuedFrame> frames;
+    int64_t last_frame_pts = -1;
+    std::map<const void *, AudioPort> audio_ports;
+    // interleaved stereo mix of the ports, mix[0] is the frame mix_start of the track
+    std::deque<float> mix;
+    int64_t mix_start = 0;
+
+    // only used by the encoding thread once the recording started
+    AVFormatContext *format = nullptr;
+    AVCodecContext *video_context = nullptr;
+    AVCodecContext *audio_context = nullptr;
+    AVStream *video_stream = nullptr;
+    AVStream *audio_stream = nullptr;
+    AVBufferRef *hw_device = nullptr;
+    AVFrame *video_frame = nullptr;
+    AVFrame *audio_frame = nullptr;
+    AVPacket *packet = nullptr;
+    SwsContext *sws_context = nullptr;
+    int64_t audio_pts = 0;
+    bool header_written = false;
+};
@@ -0,0 +1,72 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+enum class ResamplerQuality {
+    // 8 taps, enough for small rate changes (pitch effects, 44.1 kHz to 48 kHz)
+    Low,
+    // 16 taps
+    Medium,
+    // 32 taps, for large ratios where the aliasing of the shorter filters can be heard
+    High,
+};
+
+/**
+ * @brief Polyphase windowed-sinc resampler for interleaved float stereo samples
+ *
+ * The filter of each output frame is interpolated between the two closest of a fixed number of phases,
+ * so that any ratio can be used and changed while playing without rebuilding the tables (unless the
+ * low-pass cutoff changes). The cost of a frame only depends on the quality.
+ * The input is kept in a history buffer, the output lags behind it by half the filter length.
+ */
+class Resampler {
+public:
+    explicit Resampler(ResamplerQuality quality = ResamplerQuality::Medium);
+
+    // the history is kept, the new ratio is used from the next output frame
+    void set_rates(double in_rate, double out_rate);
+    // forget the history, for a new stream
+    void reset();
+
+    // number of input frames to give to process so that it can output out_frames frames
+    uint32_t get_input_needed(uint32_t out_frames) const;
+    // maximum number of frames process can output with in_frames more input frames
+    uint32_t get_max_output(uint32_t in_frames) const;
+
+    // add the input to the history and write at most max_out_frames frames to output, return the number of frames written
+    // the input which is not used yet stays in the history
+    uint32_t process(const float *input, uint32_t in_frames, float *output, uint32_t max_out_frames);
+
+private:
+    void build_filter(double cutoff);
+
+    uint32_t taps;
+    // the cutoff the filter was built for, relative to the input Nyquist frequency
+    double filter_cutoff = 0.0;
+    // taps coefficients for each phase, with one more phase to interpolate the last one
+    std::vector<float> filter;
+
+    double step = 1.0;
+    // position of the next output frame in the history
+    double position = 0.0;
+    // planar input, the first frame is the first one used by the next output frame
+    std::vector<float> history[2];
+};
@@ -17,10 +17,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <future>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <vector>
 
 struct AVFrame;
 struct AVPacket;
@@ -68,17 +72,41 @@ enum class DecoderQuery {
     AT9_SUPERFRAME_SIZE,
 };
 
+// adds the time spent in an audio decoder call to the audio pipeline stats, from its construction to its destruction
+class AudioDecodeTimer {
+public:
+    AudioDecodeTimer();
+    ~AudioDecodeTimer();
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
 struct DecoderState {
     AVCodecContext *context{};
 
     std::mutex codec_mutex;
 
+    // reused by send and receive instead of being allocated for each call, see get_packet and get_frame
+    AVPacket *packet{};
+    AVFrame *frame{};
+    // copy of the input with the padding needed by FFmpeg, see pad_input
+    std::vector<uint8_t> padded_input;
+
+    // return an empty packet or frame, allocated the first time it is needed
+    AVPacket *get_packet();
+    AVFrame *get_frame();
+    // FFmpeg may read a little past the end of the data it decodes, the data is copied to a padded buffer
+    uint8_t *pad_input(const uint8_t *data, uint32_t size);
+
     virtual uint32_t get(DecoderQuery query);
 
     virtual void flush();
     virtual bool send(const uint8_t *data, uint32_t size) = 0;
     virtual bool receive(uint8_t *data, DecoderSize *size = nullptr) = 0;
     virtual uint32_t get_es_size();
+    // give the data following the last frame sent, the decoder may start decoding it in the background
+    virtual void decode_ahead(const uint8_t *data, uint32_t size) {}
 
     virtual ~DecoderState();
 };
@@ -120,7 +148,8 @@ struct H264DecoderState : public DecoderState {
     void get_pts(uint32_t &upper, uint32_t &lower);
     void set_output_format(bool is_yuv_p3);
 
-    H264DecoderState(uint32_t width, uint32_t height);
+    // nb_threads is given to set_codec_threads
+    H264DecoderState(uint32_t width, uint32_t height, bool use_hw_decoding = false, int nb_threads = 1);
     ~H264DecoderState() override;
 };
 
@@ -155,6 +184,23 @@ struct Atrac9DecoderSavedState {
     double prev_values[2][256]{};
 };
 
+// progression of the decoder through the stream
+struct Atrac9DecoderPosition {
+    Atrac9DecoderSavedState saved_state;
+    int index_in_superframe;
+    int superframe_frame_idx;
+    int superframe_data_left;
+};
+
+// frame decoded in the background, only used if the next frame sent has the same data
+struct Atrac9DecodedFrame {
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> result;
+    uint32_t es_size_used;
+    // position of the decoder once the frame is decoded
+    Atrac9DecoderPosition position;
+};
+
 struct Atrac9DecoderState : public DecoderState {
     uint32_t config_data;
     void *decoder_handle;
@@ -164,12 +210,22 @@ struct Atrac9DecoderState : public DecoderState {
     int superframe_frame_idx;
     int superframe_data_left;
 
+    // decoder used by the worker thread to decode the next frames
+    void *ahead_handle = nullptr;
+    std::future<void> ahead_job;
+    std::deque<Atrac9DecodedFrame> ahead_frames;
+    // number of frames decoded ahead in a row which were not the ones sent next
+    uint32_t ahead_misses = 0;
+
     uint32_t get(DecoderQuery query) override;
     uint32_t get_es_size() override;
 
     bool send(const uint8_t *data, uint32_t size = 0) override;
     bool receive(uint8_t *data, DecoderSize *size) override;
     void flush() override;
+    void decode_ahead(const uint8_t *data, uint32_t size) override;
+    // wait for the worker thread and forget the frames decoded ahead
+    void cancel_decode_ahead();
 
     void export_state(Atrac9DecoderSavedState *dest);
     void load_state(const Atrac9DecoderSavedState *src);
@@ -232,7 +288,6 @@ public:
 struct AacDecoderState : public DecoderState {
     const AVCodec *codec;
     SwrContext *swr = nullptr;
-    AVFrame *frame;
     uint32_t es_size_used;
     uint32_t get(DecoderQuery query) override;
 
@@ -257,6 +312,9 @@ struct PlayerState {
     std::queue<AVPacket *> audio_packets;
     std::queue<AVPacket *> video_packets;
 
+    // last decoded video frame, kept to not allocate a new buffer for each frame
+    std::vector<uint8_t> video_frame;
+
     uint64_t time_of_last_frame = 0;
     uint64_t framerate_microseconds = 0;
 
@@ -265,6 +323,11 @@ struct PlayerState {
     uint32_t last_sample_rate = 0;
     uint32_t last_sample_count = 0;
 
+    // try to decode the videos with the hardware of the host
+    bool use_hw_decoding = false;
+    // threads used to decode the videos, see set_codec_threads
+    int nb_threads = 1;
+
     DecoderSize get_size();
     uint64_t get_framerate_microseconds();
 
@@ -275,7 +338,8 @@ struct PlayerState {
     bool next_packet(int32_t stream_id);
 
     std::vector<int16_t> receive_audio();
-    std::vector<uint8_t> receive_video();
+    // the frame is only valid until the next call, it is empty if there is no frame
+    const std::vector<uint8_t> &receive_video();
 
     void queue(const std::string &path);
 
@@ -286,5 +350,12 @@ void convert_rgb_to_yuv(const uint8_t *rgba, uint8_t *yuv, uint32_t width, uint3
 void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t frame_width, const DecoderColorSpace color_space, bool is_bgra, MJpegPitch pitch[4]);
 int convert_yuv_to_jpeg(const uint8_t *yuv, uint8_t *jpeg, uint32_t width, uint32_t height, uint32_t max_size, const DecoderColorSpace color_space, int32_t compress_ratio);
 void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest, const uint32_t width, const uint32_t height, bool is_p3);
+// must be called before the context is opened, 0 threads means as many as the host can spare
+// frame threads add a delay of one frame per thread, they can only be used when the output does not need to follow the input
+void set_codec_threads(AVCodecContext *context, int nb_threads, bool allow_frame_threads);
+// must be called before the context is opened, returns false if the software decoder is used
+bool init_hw_decoding(AVCodecContext *context, const AVCodec *codec);
+// replace a frame decoded by the hardware with a copy of it in system memory
+bool download_hw_frame(AVFrame **frame);
 void calculate_pitch_info(uint32_t width, uint32_t height, int downscale_ratio, DecoderColorSpace color_space, bool use_standard_decoder, MJpegPitch output_pitch[4]);
 std::string codec_error_name(int error);
@@ -37,8 +37,6 @@ AacDecoderState::AacDecoderState(uint32_t sample_rate, uint32_t channels) {
     context = avcodec_alloc_context3(codec);
     assert(context);
 
-    frame = av_frame_alloc();
-
     context->codec_type = AVMEDIA_TYPE_AUDIO;
     av_channel_layout_default(&context->ch_layout, channels);
     context->sample_rate = sample_rate;
@@ -58,7 +56,6 @@ AacDecoderState::AacDecoderState(uint32_t sample_rate, uint32_t channels) {
 }
 
 AacDecoderState::~AacDecoderState() {
-    av_frame_free(&frame);
     swr_free(&swr);
 }
 
@@ -73,18 +70,18 @@ uint32_t AacDecoderState::get(DecoderQuery query) {
 }
 
 bool AacDecoderState::send(const uint8_t *data, uint32_t size) {
-    AVPacket *packet = av_packet_alloc();
+    const AudioDecodeTimer timer;
+    AVPacket *packet = get_packet();
     packet->data = const_cast<uint8_t *>(data);
     packet->size = size;
 
-    av_frame_unref(frame);
+    AVFrame *frame = get_frame();
 
     const FFCodec *ff_codec = ffcodec(codec);
     int got_frame;
     int len = ff_codec->cb.decode(context, frame, &got_frame, packet);
     assert(got_frame);
 
-    av_packet_free(&packet);
     if (len < 0) {
         LOG_WARN("Error sending Aac packet: {}.", codec_error_name(len));
         return false;
@@ -96,6 +93,7 @@ bool AacDecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool AacDecoderState::receive(uint8_t *data, DecoderSize *size) {
+    const AudioDecodeTimer timer;
     assert(frame->format == AV_SAMPLE_FMT_FLTP);
 
     if (data) {
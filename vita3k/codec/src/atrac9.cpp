@@ -27,9 +27,15 @@ extern "C" {
 
 #include <error_codes.h>
 
+#include <threads/job_pool.h>
 #include <util/log.h>
+#include <util/profile.h>
 
 #include <algorithm>
+#include <thread>
+
+// decoding ahead is given up for a decoder after this number of frames decoded for nothing in a row
+static constexpr uint32_t MAX_AHEAD_MISSES = 8;
 
 struct FFMPEGAtrac9Info {
     uint32_t version;
@@ -57,7 +63,31 @@ uint32_t Atrac9DecoderState::get_es_size() {
     return es_size_used;
 }
 
+static void export_handle_state(void *handle, Atrac9DecoderSavedState *dest) {
+    Frame &frame = static_cast<Atrac9Handle *>(handle)->Frame;
+    if (frame.Channels[0])
+        std::copy_n(frame.Channels[0]->Mdct.ImdctPrevious, 256, dest->prev_values[0]);
+    if (frame.Channels[1])
+        std::copy_n(frame.Channels[1]->Mdct.ImdctPrevious, 256, dest->prev_values[1]);
+}
+
+static void load_handle_state(void *handle, const Atrac9DecoderSavedState *src) {
+    Frame &frame = static_cast<Atrac9Handle *>(handle)->Frame;
+    if (frame.Channels[0])
+        std::copy_n(src->prev_values[0], 256, frame.Channels[0]->Mdct.ImdctPrevious);
+    if (frame.Channels[1])
+        std::copy_n(src->prev_values[1], 256, frame.Channels[1]->Mdct.ImdctPrevious);
+}
+
+void Atrac9DecoderState::cancel_decode_ahead() {
+    if (ahead_job.valid())
+        ahead_job.wait();
+    ahead_frames.clear();
+}
+
 void Atrac9DecoderState::flush() {
+    cancel_decode_ahead();
+
     Atrac9CodecInfo *info = static_cast<Atrac9CodecInfo *>(atrac9_info);
     superframe_frame_idx = 0;
     superframe_data_left = info->superframeSize;
@@ -71,24 +101,44 @@ void Atrac9DecoderState::flush() {
 }
 
 void Atrac9DecoderState::export_state(Atrac9DecoderSavedState *dest) {
-    Frame &frame = static_cast<Atrac9Handle *>(decoder_handle)->Frame;
-    if (frame.Channels[0])
-        std::copy_n(frame.Channels[0]->Mdct.ImdctPrevious, 256, dest->prev_values[0]);
-    if (frame.Channels[1])
-        std::copy_n(frame.Channels[1]->Mdct.ImdctPrevious, 256, dest->prev_values[1]);
+    export_handle_state(decoder_handle, dest);
 }
 
 void Atrac9DecoderState::load_state(const Atrac9DecoderSavedState *src) {
-    Frame &frame = static_cast<Atrac9Handle *>(decoder_handle)->Frame;
-    if (frame.Channels[0])
-        std::copy_n(src->prev_values[0], 256, frame.Channels[0]->Mdct.ImdctPrevious);
-    if (frame.Channels[1])
-        std::copy_n(src->prev_values[1], 256, frame.Channels[1]->Mdct.ImdctPrevious);
+    // the frames decoded ahead follow the previous state
+    cancel_decode_ahead();
+    load_handle_state(decoder_handle, src);
 }
 
 bool Atrac9DecoderState::send(const uint8_t *data, uint32_t size) {
+    const AudioDecodeTimer timer;
     Atrac9CodecInfo *info = static_cast<Atrac9CodecInfo *>(atrac9_info);
 
+    if (ahead_job.valid())
+        ahead_job.wait();
+
+    if (!ahead_frames.empty()) {
+        Atrac9DecodedFrame &frame = ahead_frames.front();
+        if (memcmp(data, frame.input.data(), frame.input.size()) == 0) {
+            std::swap(result, frame.result);
+            es_size_used = frame.es_size_used;
+
+            // bring the decoder to where it would be after decoding this frame
+            load_handle_state(decoder_handle, &frame.position.saved_state);
+            static_cast<Atrac9Handle *>(decoder_handle)->Frame.IndexInSuperframe = frame.position.index_in_superframe;
+            superframe_frame_idx = frame.position.superframe_frame_idx;
+            superframe_data_left = frame.position.superframe_data_left;
+
+            ahead_frames.pop_front();
+            ahead_misses = 0;
+            return true;
+        }
+
+        // the game is not reading the stream in order
+        ahead_frames.clear();
+        ahead_misses++;
+    }
+
     int decode_used = 0;
 
     const int res = Atrac9Decode(decoder_handle, data, reinterpret_cast<short *>(result.data()), &decode_used);
@@ -110,7 +160,94 @@ bool Atrac9DecoderState::send(const uint8_t *data, uint32_t size) {
     return true;
 }
 
+void Atrac9DecoderState::decode_ahead(const uint8_t *data, uint32_t size) {
+    // the workers are shared by all the decoders and only started the first time a frame is decoded ahead
+    static JobPool pool;
+    static const int nb_threads = static_cast<int>(std::min(std::thread::hardware_concurrency(), 4U));
+
+    if (nb_threads <= 1 || ahead_misses >= MAX_AHEAD_MISSES)
+        return;
+
+    // the previous job is still running, the next frames will be sent later anyway
+    if (ahead_job.valid() && ahead_job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    Atrac9CodecInfo *info = static_cast<Atrac9CodecInfo *>(atrac9_info);
+
+    Atrac9DecoderPosition position;
+    // offset in data of the first frame which is not decoded yet
+    uint32_t offset = 0;
+    if (ahead_frames.empty()) {
+        // the scale factors of the previous frame of a superframe are not part of the saved state,
+        // only superframe boundaries can be decoded ahead from the state of the decoder
+        if (superframe_frame_idx != 0)
+            return;
+
+        if (!ahead_handle) {
+            ahead_handle = Atrac9GetHandle();
+            if (Atrac9InitDecoder(ahead_handle, reinterpret_cast<uint8_t *>(&config_data)) != At9Status::ERR_SUCCESS) {
+                LOG_ERROR("Error initializing the decoder used to decode ahead");
+                ahead_misses = MAX_AHEAD_MISSES;
+                return;
+            }
+        }
+
+        export_handle_state(decoder_handle, &position.saved_state);
+        load_handle_state(ahead_handle, &position.saved_state);
+        static_cast<Atrac9Handle *>(ahead_handle)->Frame.IndexInSuperframe = 0;
+        position.index_in_superframe = 0;
+        position.superframe_frame_idx = 0;
+        position.superframe_data_left = info->superframeSize;
+    } else {
+        // the decoder used ahead is already where the last frame decoded left it
+        position = ahead_frames.back().position;
+        for (const Atrac9DecodedFrame &frame : ahead_frames)
+            offset += frame.es_size_used;
+    }
+
+    // decode the rest of the current superframe, the decoder may read until its end
+    if (offset >= size || size - offset < static_cast<uint32_t>(position.superframe_data_left))
+        return;
+
+    static std::once_flag pool_started;
+    std::call_once(pool_started, [] { pool.start(nb_threads - 1, [] { PROFILE_THREAD_NAME("ATRAC9 decoder"); }); });
+
+    // the guest memory may change once the function returns, the data is copied now
+    std::vector<uint8_t> input(data + offset, data + offset + position.superframe_data_left);
+    const size_t result_size = result.size();
+    ahead_job = pool.submit([this, info, result_size, input = std::move(input), position]() mutable {
+        const uint8_t *frame_data = input.data();
+        do {
+            Atrac9DecodedFrame frame;
+            frame.result.resize(result_size);
+            int decode_used = 0;
+            if (Atrac9Decode(ahead_handle, frame_data, reinterpret_cast<short *>(frame.result.data()), &decode_used) != At9Status::ERR_SUCCESS) {
+                // the decoder used ahead is not where the last frame left it anymore
+                ahead_frames.clear();
+                return;
+            }
+
+            frame.input.assign(frame_data, frame_data + decode_used);
+            frame.es_size_used = static_cast<uint32_t>(decode_used);
+            frame_data += decode_used;
+            position.superframe_data_left -= decode_used;
+            position.superframe_frame_idx++;
+            if (position.superframe_frame_idx == info->framesInSuperframe) {
+                frame.es_size_used += position.superframe_data_left;
+                position.superframe_frame_idx = 0;
+                position.superframe_data_left = info->superframeSize;
+            }
+
+            export_handle_state(ahead_handle, &position.saved_state);
+            position.index_in_superframe = static_cast<Atrac9Handle *>(ahead_handle)->Frame.IndexInSuperframe;
+            frame.position = position;
+            ahead_frames.push_back(std::move(frame));
+        } while (position.superframe_frame_idx != 0);
+    });
+}
+
 bool Atrac9DecoderState::receive(uint8_t *data, DecoderSize *size) {
+    const AudioDecodeTimer timer;
     Atrac9CodecInfo *info = static_cast<Atrac9CodecInfo *>(atrac9_info);
 
     if (data) {
@@ -144,6 +281,10 @@ Atrac9DecoderState::Atrac9DecoderState(uint32_t config_data)
 }
 
 Atrac9DecoderState::~Atrac9DecoderState() {
+    if (ahead_job.valid())
+        ahead_job.wait();
+    if (ahead_handle)
+        Atrac9ReleaseHandle(ahead_handle);
     Atrac9ReleaseHandle(decoder_handle);
     delete static_cast<Atrac9CodecInfo *>(atrac9_info);
     context = nullptr;
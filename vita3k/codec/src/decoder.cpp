@@ -19,10 +19,49 @@
 
 extern "C" {
 #include <libavcodec/avcodec.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
 }
 
+#include <util/audio_stats.h>
 #include <util/log.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#endif
+
+// hardware decoders tried in this order, the first one which can be created is used
+static constexpr AVHWDeviceType HW_DEVICE_TYPES[] = {
+#ifdef _WIN32
+    AV_HWDEVICE_TYPE_D3D11VA,
+    AV_HWDEVICE_TYPE_DXVA2,
+#elif defined(__APPLE__)
+    AV_HWDEVICE_TYPE_VIDEOTOOLBOX,
+#elif defined(__ANDROID__)
+    AV_HWDEVICE_TYPE_MEDIACODEC,
+#else
+    AV_HWDEVICE_TYPE_VAAPI,
+    AV_HWDEVICE_TYPE_VDPAU,
+#endif
+    AV_HWDEVICE_TYPE_VULKAN,
+};
+
+AudioDecodeTimer::AudioDecodeTimer()
+    : start(std::chrono::steady_clock::now()) {}
+
+AudioDecodeTimer::~AudioDecodeTimer() {
+    const uint32_t decode_time = audio_stats_elapsed_us(start);
+    audio_pipeline_stats.add_decode(decode_time);
+#ifdef TRACY_ENABLE
+    TracyPlot("Audio decode (us)", static_cast<int64_t>(decode_time));
+#endif
+}
+
 uint32_t DecoderState::get(DecoderQuery query) {
     return 0;
 }
@@ -37,10 +76,109 @@ void DecoderState::flush() {
         avcodec_flush_buffers(context);
 }
 
+AVPacket *DecoderState::get_packet() {
+    if (packet)
+        av_packet_unref(packet);
+    else
+        packet = av_packet_alloc();
+    return packet;
+}
+
+AVFrame *DecoderState::get_frame() {
+    if (frame)
+        av_frame_unref(frame);
+    else
+        frame = av_frame_alloc();
+    return frame;
+}
+
+uint8_t *DecoderState::pad_input(const uint8_t *data, uint32_t size) {
+    // the capacity is kept, this only allocates when the input gets larger
+    padded_input.resize(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    memcpy(padded_input.data(), data, size);
+    memset(padded_input.data() + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    return padded_input.data();
+}
+
 DecoderState::~DecoderState() {
+    av_packet_free(&packet);
+    av_frame_free(&frame);
     avcodec_free_context(&context);
 }
 
+void set_codec_threads(AVCodecContext *context, int nb_threads, bool allow_frame_threads) {
+    // FFmpeg would use one thread per core, the emulated CPU threads and the renderer need them too
+    if (nb_threads <= 0)
+        nb_threads = static_cast<int>(std::min(std::thread::hardware_concurrency(), 4U));
+
+    context->thread_count = nb_threads;
+    context->thread_type = FF_THREAD_SLICE;
+    if (allow_frame_threads)
+        context->thread_type |= FF_THREAD_FRAME;
+}
+
+static AVPixelFormat get_hw_format(AVCodecContext *context, const AVPixelFormat *formats) {
+    const AVPixelFormat hw_format = static_cast<AVPixelFormat>(reinterpret_cast<intptr_t>(context->opaque));
+    for (const AVPixelFormat *format = formats; *format != AV_PIX_FMT_NONE; format++) {
+        if (*format == hw_format)
+            return hw_format;
+    }
+
+    // the hardware can't decode this stream (profile or size not supported), use the software decoder
+    LOG_WARN("The hardware decoder does not support this stream, falling back to the software decoder");
+    for (const AVPixelFormat *format = formats; *format != AV_PIX_FMT_NONE; format++) {
+        if (!(av_pix_fmt_desc_get(*format)->flags & AV_PIX_FMT_FLAG_HWACCEL))
+            return *format;
+    }
+    return AV_PIX_FMT_NONE;
+}
+
+bool init_hw_decoding(AVCodecContext *context, const AVCodec *codec) {
+    for (const AVHWDeviceType type : HW_DEVICE_TYPES) {
+        for (int i = 0;; i++) {
+            const AVCodecHWConfig *config = avcodec_get_hw_config(codec, i);
+            if (!config)
+                break;
+            if (config->device_type != type || !(config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX))
+                continue;
+
+            AVBufferRef *device = nullptr;
+            if (av_hwdevice_ctx_create(&device, type, nullptr, nullptr, 0) < 0)
+                break;
+
+            // the context owns the device from now on
+            context->hw_device_ctx = device;
+            context->opaque = reinterpret_cast<void *>(static_cast<intptr_t>(config->pix_fmt));
+            context->get_format = get_hw_format;
+            LOG_INFO("Using {} to decode {}", av_hwdevice_get_type_name(type), codec->name);
+            return true;
+        }
+    }
+
+    LOG_INFO("No hardware decoder available for {}, using the software decoder", codec->name);
+    return false;
+}
+
+bool download_hw_frame(AVFrame **frame) {
+    if (!(*frame)->hw_frames_ctx)
+        return true;
+
+    // the format is chosen by the hardware, usually nv12
+    AVFrame *sw_frame = av_frame_alloc();
+    int error = av_hwframe_transfer_data(sw_frame, *frame, 0);
+    if (error == 0)
+        error = av_frame_copy_props(sw_frame, *frame);
+    if (error < 0) {
+        LOG_WARN("Error transferring the decoded frame from the hardware: {}.", codec_error_name(error));
+        av_frame_free(&sw_frame);
+        return false;
+    }
+
+    av_frame_free(frame);
+    *frame = sw_frame;
+    return true;
+}
+
 // Handy to have this in logs, some debuggers don't seem to be able to evaluate there error macros properly.
 std::string codec_error_name(int error) {
     switch (error) {
@@ -31,7 +31,26 @@ void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest, const uint32_t widt
         dest += width;
     }
 
-    if (is_p3) {
+    if (frame->format == AV_PIX_FMT_NV12) {
+        // output of the hardware decoders, U and V are already interleaved
+        if (is_p3) {
+            uint8_t *dest_v = dest + (width / 2) * (height / 2);
+            for (size_t i = 0; i < height / 2; i++) {
+                const uint8_t *src = &frame->data[1][frame->linesize[1] * i];
+                for (size_t j = 0; j < width / 2; j++) {
+                    dest[j] = src[j * 2];
+                    dest_v[j] = src[j * 2 + 1];
+                }
+                dest += width / 2;
+                dest_v += width / 2;
+            }
+        } else {
+            for (size_t i = 0; i < height / 2; i++) {
+                memcpy(dest, &frame->data[1][frame->linesize[1] * i], width);
+                dest += width;
+            }
+        }
+    } else if (is_p3) {
         for (size_t i = 0; i < height / 2; i++) {
             memcpy(dest, &frame->data[1][frame->linesize[1] * i], width / 2);
             dest += width / 2;
@@ -71,10 +90,9 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
 
     int error = 0;
 
-    std::vector<uint8_t> au_frame(size + AV_INPUT_BUFFER_PADDING_SIZE);
-    memcpy(au_frame.data(), data, size);
+    const uint8_t *au_frame = pad_input(data, size);
 
-    AVPacket *packet = av_packet_alloc();
+    AVPacket *packet = get_packet();
     if (!packet) {
         LOG_ERROR("Error allocating H264 packet.");
         return false;
@@ -84,7 +102,7 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
         context, // AVCodecContext *avctx,
         &packet->data, // uint8_t **poutbuf,
         &packet->size, // int *poutbuf_size,
-        au_frame.data(), // const uint8_t *buf,
+        au_frame, // const uint8_t *buf,
         size, // int buf_size,
         pts == ~0ull ? AV_NOPTS_VALUE : pts, // int64_t pts,
         dts == ~0ull ? AV_NOPTS_VALUE : dts, // int64_t dts,
@@ -92,7 +110,6 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
     );
     if (error < 0) {
         LOG_WARN("Error parsing H264 packet: {}.", codec_error_name(error));
-        av_packet_free(&packet);
         return false;
     }
 
@@ -100,7 +117,6 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
     packet->dts = parser->dts;
 
     error = avcodec_send_packet(context, packet);
-    av_packet_free(&packet);
     if (error < 0) {
         LOG_WARN("Error sending H264 packet: {}.", codec_error_name(error));
         return false;
@@ -110,15 +126,18 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool H264DecoderState::receive(uint8_t *data, DecoderSize *size) {
-    AVFrame *frame = av_frame_alloc();
+    get_frame();
 
     int error = avcodec_receive_frame(context, frame);
     if (error < 0) {
         LOG_WARN("Error receiving H264 frame: {}.", codec_error_name(error));
-        av_frame_free(&frame);
         return false;
     }
 
+    // the frame member is replaced by the downloaded copy
+    if (!download_hw_frame(&frame))
+        return false;
+
     if (data) {
         copy_yuv_data_from_frame(frame, data, width_in, height_in, output_yuvp3);
     }
@@ -132,7 +151,6 @@ bool H264DecoderState::receive(uint8_t *data, DecoderSize *size) {
 
     pts_out = frame->pts;
 
-    av_frame_free(&frame);
     return true;
 }
 
@@ -162,7 +180,7 @@ void H264DecoderState::set_output_format(bool is_yuv_p3) {
     this->output_yuvp3 = is_yuv_p3;
 }
 
-H264DecoderState::H264DecoderState(uint32_t width, uint32_t height) {
+H264DecoderState::H264DecoderState(uint32_t width, uint32_t height, bool use_hw_decoding, int nb_threads) {
     const AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
     assert(codec);
 
@@ -174,6 +192,10 @@ H264DecoderState::H264DecoderState(uint32_t width, uint32_t height) {
     assert(context);
     context->width = width;
     context->height = height;
+    // each frame sent is expected to be received right after it, only the slices can be decoded in parallel
+    set_codec_threads(context, nb_threads, false);
+    if (use_hw_decoding)
+        init_hw_decoding(context, codec);
 
     int result = avcodec_open2(context, codec, nullptr);
     assert(result == 0);
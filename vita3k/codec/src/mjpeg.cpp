@@ -27,8 +27,55 @@ extern "C" {
 #include <util/align.h>
 #include <util/log.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 
+struct JpegSwsContext {
+    int width = 0;
+    int height = 0;
+    AVPixelFormat src_format = AV_PIX_FMT_NONE;
+    AVPixelFormat dst_format = AV_PIX_FMT_NONE;
+    SwsContext *context = nullptr;
+};
+
+// creating a context computes the conversion tables, which takes longer than converting a small picture,
+// photo viewers and camera apps convert pictures of the same few sizes and formats over and over
+static constexpr size_t MAX_SWS_CONTEXTS = 4;
+
+struct JpegSwsContextCache {
+    // sorted from the most recently used to the least recently used
+    std::array<JpegSwsContext, MAX_SWS_CONTEXTS> contexts;
+
+    ~JpegSwsContextCache() {
+        for (JpegSwsContext &entry : contexts)
+            sws_freeContext(entry.context);
+    }
+};
+
+// a context can't be used by two threads at the same time, each guest thread has its own contexts
+static SwsContext *get_sws_context(int width, int height, AVPixelFormat src_format, AVPixelFormat dst_format) {
+    thread_local JpegSwsContextCache cache;
+    auto &contexts = cache.contexts;
+
+    auto it = std::find_if(contexts.begin(), contexts.end(), [&](const JpegSwsContext &entry) {
+        return entry.context && entry.width == width && entry.height == height && entry.src_format == src_format && entry.dst_format == dst_format;
+    });
+
+    if (it == contexts.end()) {
+        // replace the least recently used context
+        it = contexts.end() - 1;
+        if (it->context)
+            sws_freeContext(it->context);
+
+        *it = JpegSwsContext{ width, height, src_format, dst_format,
+            sws_getContext(width, height, src_format, width, height, dst_format, SWS_FULL_CHR_H_INT | SWS_ACCURATE_RND, nullptr, nullptr, nullptr) };
+    }
+
+    std::rotate(contexts.begin(), it, it + 1);
+    return contexts.front().context;
+}
+
 void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t frame_width, const DecoderColorSpace color_space, const bool is_bgra, MJpegPitch pitch[4]) {
     AVPixelFormat format = AV_PIX_FMT_YUVJ444P;
     int width = pitch[0].x, height = pitch[0].y;
@@ -37,18 +84,28 @@ void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t frame_width,
     case COLORSPACE_YUV444P:
         format = AV_PIX_FMT_YUV444P;
         break;
+    case COLORSPACE_YUV440P:
+        format = AV_PIX_FMT_YUV440P;
+        break;
     case COLORSPACE_YUV422P:
         format = AV_PIX_FMT_YUV422P;
         break;
     case COLORSPACE_YUV420P:
         format = AV_PIX_FMT_YUV420P;
         break;
+    case COLORSPACE_YUV411P:
+        format = AV_PIX_FMT_YUV411P;
+        break;
+    case COLORSPACE_GRAYSCALE:
+        // only the Y slice is read
+        format = AV_PIX_FMT_GRAY8;
+        break;
     default:
         LOG_WARN("An attempt was made to use an unsupported color space.");
         return;
     }
 
-    SwsContext *context = sws_getContext(width, height, format, width, height, is_bgra ? AV_PIX_FMT_BGRA : AV_PIX_FMT_RGBA, SWS_FULL_CHR_H_INT | SWS_ACCURATE_RND, nullptr, nullptr, nullptr);
+    SwsContext *context = get_sws_context(width, height, format, is_bgra ? AV_PIX_FMT_BGRA : AV_PIX_FMT_RGBA);
     assert(context);
 
     const uint8_t *slices[] = {
@@ -73,7 +130,6 @@ void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t frame_width,
 
     int error = sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides);
     assert(error == height);
-    sws_freeContext(context);
 }
 
 void convert_rgb_to_yuv(const uint8_t *rgba, uint8_t *yuv, uint32_t width, uint32_t height, const DecoderColorSpace color_space, int32_t in_pitch) {
@@ -102,8 +158,7 @@ void convert_rgb_to_yuv(const uint8_t *rgba, uint8_t *yuv, uint32_t width, uint3
         return;
     }
 
-    SwsContext *context = sws_getContext(width, height, AV_PIX_FMT_RGBA, width, height, format,
-        SWS_FULL_CHR_H_INT | SWS_ACCURATE_RND, nullptr, nullptr, nullptr);
+    SwsContext *context = get_sws_context(width, height, AV_PIX_FMT_RGBA, format);
     assert(context);
 
     const uint8_t *slices[] = {
@@ -127,7 +182,6 @@ void convert_rgb_to_yuv(const uint8_t *rgba, uint8_t *yuv, uint32_t width, uint3
     };
 
     int error = sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides);
-    sws_freeContext(context);
     assert(error == height);
 }
 
@@ -343,14 +397,10 @@ void MjpegDecoderState::configure(void *options) {
 }
 
 bool MjpegDecoderState::send(const uint8_t *data, uint32_t size) {
-    std::vector<uint8_t> jpeg_buffer(size + AV_INPUT_BUFFER_PADDING_SIZE);
-    std::memcpy(jpeg_buffer.data(), data, size);
-
-    AVPacket *packet = av_packet_alloc();
-    packet->data = jpeg_buffer.data();
+    AVPacket *packet = get_packet();
+    packet->data = pad_input(data, size);
     packet->size = size;
     int error = avcodec_send_packet(context, packet);
-    av_packet_free(&packet);
 
     if (error < 0) {
         LOG_WARN("Error sending Mjpeg packet: {}.", codec_error_name(error));
@@ -361,18 +411,16 @@ bool MjpegDecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool MjpegDecoderState::receive(uint8_t *data, DecoderSize *size) {
-    AVFrame *frame = av_frame_alloc();
+    AVFrame *frame = get_frame();
     int error = avcodec_receive_frame(context, frame);
     if (error < 0) {
         LOG_WARN("Error receiving Mjpeg frame: {}.", codec_error_name(error));
-        av_frame_free(&frame);
         return false;
     }
 
     this->color_space_out = av_pixel_format_to_colorspace(static_cast<AVPixelFormat>(frame->format));
     if (this->color_space_out == COLORSPACE_UNKNOWN) {
         LOG_WARN("Mjpeg frame is in unimplemented format {}.", frame->format);
-        av_frame_free(&frame);
         return false;
     }
 
@@ -505,8 +553,6 @@ bool MjpegDecoderState::receive(uint8_t *data, DecoderSize *size) {
         size->height = original_height;
     }
 
-    av_frame_free(&frame);
-
     return true;
 }
 
@@ -131,22 +131,18 @@ uint32_t Mp3DecoderState::get(DecoderQuery query) {
 }
 
 bool Mp3DecoderState::send(const uint8_t *data, uint32_t size) {
-    AVPacket *packet = av_packet_alloc();
-
+    const AudioDecodeTimer timer;
     es_size_used = get_mp3_data_size(data);
     if (es_size_used != 0)
         size = std::min(size, es_size_used);
     else
         es_size_used = size;
 
-    std::vector<uint8_t> temporary(size + AV_INPUT_BUFFER_PADDING_SIZE);
-    memcpy(temporary.data(), data, size);
-
+    AVPacket *packet = get_packet();
     packet->size = size;
-    packet->data = temporary.data();
+    packet->data = pad_input(data, size);
 
     int err = avcodec_send_packet(context, packet);
-    av_packet_free(&packet);
     if (err < 0) {
         LOG_WARN("Error sending Mp3 packet: {}.", log_hex(static_cast<uint32_t>(err)));
         return false;
@@ -156,12 +152,12 @@ bool Mp3DecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool Mp3DecoderState::receive(uint8_t *data, DecoderSize *size) {
-    AVFrame *frame = av_frame_alloc();
+    const AudioDecodeTimer timer;
+    AVFrame *frame = get_frame();
 
     int err = avcodec_receive_frame(context, frame);
     if (err < 0) {
         LOG_WARN("Error receiving Mp3 frame: {}.", log_hex(static_cast<uint32_t>(err)));
-        av_frame_free(&frame);
         return false;
     }
 
@@ -181,7 +177,6 @@ bool Mp3DecoderState::receive(uint8_t *data, DecoderSize *size) {
         size->samples = frame->nb_samples;
     }
 
-    av_frame_free(&frame);
     return true;
 }
 
@@ -166,6 +166,7 @@ static int nibble_lookup[16] = { 0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3,
  * Implementation used from vgmstream project, code by bnnm and korenkonder.
  */
 bool PCMDecoderState::send(const uint8_t *data, uint32_t size) {
+    const AudioDecodeTimer timer;
     const std::uint8_t *source_transformed = data;
     std::uint32_t produced_samples = 0;
 
@@ -280,6 +281,7 @@ bool PCMDecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool PCMDecoderState::receive(uint8_t *data, DecoderSize *size) {
+    const AudioDecodeTimer timer;
     if (data) {
         std::memcpy(data, final_result.data(), final_result.size());
     }
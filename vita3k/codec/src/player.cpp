@@ -88,6 +88,10 @@ void PlayerState::switch_video(const std::string &path) {
         const AVCodec *video_codec = avcodec_find_decoder(video_stream->codecpar->codec_id);
         video_context = avcodec_alloc_context3(video_codec);
         avcodec_parameters_to_context(video_context, video_stream->codecpar);
+        // the frames are pulled until one is available, the delay of frame threading does not matter
+        set_codec_threads(video_context, nb_threads, true);
+        if (use_hw_decoding)
+            init_hw_decoding(video_context, video_codec);
         avcodec_open2(video_context, video_codec, nullptr);
     }
 
@@ -188,15 +192,15 @@ std::vector<int16_t> PlayerState::receive_audio() {
     return data;
 }
 
-std::vector<uint8_t> PlayerState::receive_video() {
+const std::vector<uint8_t> &PlayerState::receive_video() {
+    video_frame.clear();
     if (video_stream_id < 0)
-        return {};
+        return video_frame;
 
     if (video_playing.empty())
-        return {};
+        return video_frame;
 
     AVFrame *frame = av_frame_alloc();
-    std::vector<uint8_t> data;
     while (true) {
         int error = avcodec_receive_frame(video_context, frame);
 
@@ -216,17 +220,21 @@ std::vector<uint8_t> PlayerState::receive_video() {
             }
         }
 
+        if (!download_hw_frame(&frame))
+            break;
+
         last_timestamp = frame->best_effort_timestamp;
 
-        data.resize(H264DecoderState::buffer_size(
+        // the capacity is kept, this only allocates when the video gets larger
+        video_frame.resize(H264DecoderState::buffer_size(
             { { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) } }));
-        copy_yuv_data_from_frame(frame, data.data(), frame->width, frame->height, false);
+        copy_yuv_data_from_frame(frame, video_frame.data(), frame->width, frame->height, false);
 
         break;
     }
 
     av_frame_free(&frame);
-    return data;
+    return video_frame;
 }
 
 void PlayerState::queue(const std::string &path) {
@@ -0,0 +1,494 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/recorder.h>
+#include <codec/state.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/hwcontext.h>
+#include <libswscale/swscale.h>
+}
+
+#include <util/log.h>
+
+#include <algorithm>
+
+static constexpr int MIX_RATE = 48000;
+// the ports queue their samples ahead of the host, the mix is only encoded once they all had the time to output
+static constexpr int64_t MIX_LATENCY = MIX_RATE / 4;
+// a port more late than this stopped outputting for a while, it starts again from the current time
+static constexpr int64_t MAX_PORT_DELAY = MIX_RATE / 5;
+// frames waiting for the encoder (about 2 MB each), the new ones are dropped if the encoder is too slow
+static constexpr size_t MAX_QUEUED_FRAMES = 60;
+static constexpr int64_t VIDEO_BIT_RATE = 8'000'000;
+static constexpr int64_t AUDIO_BIT_RATE = 192'000;
+
+struct VideoEncoder {
+    const char *name;
+    // AV_HWDEVICE_TYPE_NONE for the encoders taking the frames from the host memory
+    AVHWDeviceType device_type;
+    AVPixelFormat hw_format;
+    AVPixelFormat sw_format;
+};
+
+// tried in this order, the first one which can be opened is used
+static constexpr VideoEncoder VIDEO_ENCODERS[] = {
+#ifdef _WIN32
+    { "h264_nvenc", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_NV12 },
+    { "h264_amf", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_NV12 },
+    { "h264_qsv", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_NV12 },
+    { "h264_mf", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_NV12 },
+#elif defined(__APPLE__)
+    { "h264_videotoolbox", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_NV12 },
+#elif defined(__ANDROID__)
+    { "h264_mediacodec", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_NV12 },
+#else
+    { "h264_nvenc", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_NV12 },
+    { "h264_vaapi", AV_HWDEVICE_TYPE_VAAPI, AV_PIX_FMT_VAAPI, AV_PIX_FMT_NV12 },
+#endif
+    { "libx264", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_YUV420P },
+    { "libopenh264", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_YUV420P },
+    { "mpeg4", AV_HWDEVICE_TYPE_NONE, AV_PIX_FMT_NONE, AV_PIX_FMT_YUV420P },
+};
+
+static bool init_hw_frames(AVCodecContext *context, const VideoEncoder &encoder, AVBufferRef **device) {
+    if (av_hwdevice_ctx_create(device, encoder.device_type, nullptr, nullptr, 0) < 0)
+        return false;
+
+    AVBufferRef *frames_ref = av_hwframe_ctx_alloc(*device);
+    if (!frames_ref)
+        return false;
+
+    auto *frames = reinterpret_cast<AVHWFramesContext *>(frames_ref->data);
+    frames->format = encoder.hw_format;
+    frames->sw_format = encoder.sw_format;
+    frames->width = context->width;
+    frames->height = context->height;
+    frames->initial_pool_size = 8;
+    if (av_hwframe_ctx_init(frames_ref) < 0) {
+        av_buffer_unref(&frames_ref);
+        return false;
+    }
+
+    // the context owns the frames from now on
+    context->hw_frames_ctx = frames_ref;
+    context->pix_fmt = encoder.hw_format;
+    return true;
+}
+
+VideoRecorder::~VideoRecorder() {
+    stop();
+}
+
+bool VideoRecorder::start(const fs::path &path, int fps) {
+    stop();
+
+    packet = av_packet_alloc();
+    video_frame = av_frame_alloc();
+    audio_frame = av_frame_alloc();
+    if (!packet || !video_frame || !audio_frame) {
+        close();
+        return false;
+    }
+
+    this->path = path;
+    this->fps = fps;
+    start_time = Clock::now();
+    frames.clear();
+    last_frame_pts = -1;
+    audio_ports.clear();
+    mix.clear();
+    mix_start = 0;
+    audio_pts = 0;
+    recording = true;
+    stopping = false;
+    thread = std::thread(&VideoRecorder::encode_thread, this);
+
+    LOG_INFO("Recording the app to {}", path);
+    return true;
+}
+
+void VideoRecorder::stop() {
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    cond.notify_one();
+    if (thread.joinable())
+        thread.join();
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    recording = false;
+}
+
+int64_t VideoRecorder::get_mix_position(Clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - start_time).count() * MIX_RATE / 1'000'000;
+}
+
+void VideoRecorder::add_frame(std::vector<uint32_t> &&frame, uint32_t width, uint32_t height) {
+    if (frame.size() != static_cast<size_t>(width) * height || width < 2 || height < 2)
+        return;
+
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        if (!recording || stopping)
+            return;
+
+        const int64_t pts = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_time).count() * fps / 1'000'000;
+        if (pts <= last_frame_pts)
+            return;
+        if (frames.size() >= MAX_QUEUED_FRAMES) {
+            LOG_WARN_ONCE("The video encoder is too slow, some frames are not recorded");
+            return;
+        }
+
+        last_frame_pts = pts;
+        frames.push_back({ std::move(frame), width, height, pts });
+    }
+    cond.notify_one();
+}
+
+void VideoRecorder::add_audio(const void *port, const int16_t *samples, uint32_t nb_frames, int nb_channels, int freq, float volume) {
+    if (nb_frames == 0 || nb_channels <= 0 || freq <= 0)
+        return;
+
+    std::vector<float> input(nb_frames * 2);
+    const float scale = volume / 32768.0f;
+    const int right_channel = nb_channels > 1 ? 1 : 0;
+    for (uint32_t i = 0; i < nb_frames; i++) {
+        input[i * 2] = samples[i * nb_channels] * scale;
+        input[i * 2 + 1] = samples[i * nb_channels + right_channel] * scale;
+    }
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (!recording || stopping)
+        return;
+
+    AudioPort &audio_port = audio_ports[port];
+    const int64_t now = get_mix_position(Clock::now());
+    if (audio_port.freq != freq) {
+        audio_port.resampler.reset();
+        audio_port.resampler.set_rates(freq, MIX_RATE);
+        audio_port.freq = freq;
+        audio_port.position = now;
+    } else if (audio_port.position + MAX_PORT_DELAY < now) {
+        audio_port.resampler.reset();
+        audio_port.position = now;
+    }
+
+    std::vector<float> output(audio_port.resampler.get_max_output(nb_frames) * 2);
+    const uint32_t written = audio_port.resampler.process(input.data(), nb_frames, output.data(), static_cast<uint32_t>(output.size() / 2));
+    for (uint32_t i = 0; i < written; i++) {
+        const int64_t position = audio_port.position + i;
+        // this part of the track is already encoded
+        if (position < mix_start)
+            continue;
+
+        const size_t index = static_cast<size_t>(position - mix_start) * 2;
+        if (index + 2 > mix.size())
+            mix.resize(index + 2, 0.0f);
+        mix[index] += output[i * 2];
+        mix[index + 1] += output[i * 2 + 1];
+    }
+    audio_port.position += written;
+}
+
+bool VideoRecorder::open_video_encoder(uint32_t width, uint32_t height) {
+    for (const VideoEncoder &encoder : VIDEO_ENCODERS) {
+        const AVCodec *codec = avcodec_find_encoder_by_name(encoder.name);
+        if (!codec)
+            continue;
+
+        AVCodecContext *context = avcodec_alloc_context3(codec);
+        context->width = static_cast<int>(width);
+        context->height = static_cast<int>(height);
+        context->time_base = { 1, fps };
+        context->framerate = { fps, 1 };
+        context->pix_fmt = encoder.sw_format;
+        context->bit_rate = VIDEO_BIT_RATE;
+        context->gop_size = fps * 2;
+        // no reordering, the frames are written as soon as they are encoded
+        context->max_b_frames = 0;
+        if (format->oformat->flags & AVFMT_GLOBALHEADER)
+            context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+        if (encoder.device_type != AV_HWDEVICE_TYPE_NONE && !init_hw_frames(context, encoder, &hw_device)) {
+            avcodec_free_context(&context);
+            av_buffer_unref(&hw_device);
+            continue;
+        }
+
+        const int error = avcodec_open2(context, codec, nullptr);
+        if (error < 0) {
+            LOG_INFO("Cannot open the {} encoder: {}", encoder.name, codec_error_name(error));
+            avcodec_free_context(&context);
+            av_buffer_unref(&hw_device);
+            continue;
+        }
+
+        video_frame->format = encoder.sw_format;
+        video_frame->width = context->width;
+        video_frame->height = context->height;
+        if (av_frame_get_buffer(video_frame, 0) < 0) {
+            avcodec_free_context(&context);
+            av_buffer_unref(&hw_device);
+            return false;
+        }
+
+        video_stream = avformat_new_stream(format, nullptr);
+        if (!video_stream || avcodec_parameters_from_context(video_stream->codecpar, context) < 0) {
+            avcodec_free_context(&context);
+            return false;
+        }
+        video_stream->time_base = context->time_base;
+        video_context = context;
+
+        LOG_INFO("Recording the video with the {} encoder", encoder.name);
+        return true;
+    }
+
+    LOG_ERROR("No video encoder of this build can be opened to record the app");
+    return false;
+}
+
+bool VideoRecorder::open_audio_encoder() {
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+    if (!codec)
+        return false;
+
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    context->sample_rate = MIX_RATE;
+    context->sample_fmt = AV_SAMPLE_FMT_FLTP;
+    context->bit_rate = AUDIO_BIT_RATE;
+    context->time_base = { 1, MIX_RATE };
+    av_channel_layout_default(&context->ch_layout, 2);
+    if (format->oformat->flags & AVFMT_GLOBALHEADER)
+        context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    int error = avcodec_open2(context, codec, nullptr);
+    if (error < 0) {
+        LOG_WARN("Cannot open the {} encoder: {}", codec->name, codec_error_name(error));
+        avcodec_free_context(&context);
+        return false;
+    }
+
+    audio_frame->format = context->sample_fmt;
+    audio_frame->sample_rate = context->sample_rate;
+    audio_frame->nb_samples = context->frame_size;
+    av_channel_layout_copy(&audio_frame->ch_layout, &context->ch_layout);
+    error = av_frame_get_buffer(audio_frame, 0);
+
+    audio_stream = error < 0 ? nullptr : avformat_new_stream(format, nullptr);
+    if (!audio_stream || avcodec_parameters_from_context(audio_stream->codecpar, context) < 0) {
+        avcodec_free_context(&context);
+        return false;
+    }
+    audio_stream->time_base = context->time_base;
+    audio_context = context;
+    return true;
+}
+
+bool VideoRecorder::open_output(uint32_t width, uint32_t height) {
+    const std::string path_utf8 = fs_utils::path_to_utf8(path);
+    int error = avformat_alloc_output_context2(&format, nullptr, nullptr, path_utf8.c_str());
+    if (error < 0) {
+        LOG_ERROR("Cannot record the app to {}: {}", path, codec_error_name(error));
+        return false;
+    }
+
+    // the encoders need an even size
+    if (!open_video_encoder(width & ~1U, height & ~1U))
+        return false;
+    if (!open_audio_encoder())
+        LOG_WARN("No AAC encoder can be opened, the app is recorded without sound");
+
+    if (!(format->oformat->flags & AVFMT_NOFILE)) {
+        error = avio_open(&format->pb, path_utf8.c_str(), AVIO_FLAG_WRITE);
+        if (error < 0) {
+            LOG_ERROR("Cannot open {} for writing: {}", path, codec_error_name(error));
+            return false;
+        }
+    }
+
+    error = avformat_write_header(format, nullptr);
+    if (error < 0) {
+        LOG_ERROR("Cannot write the header of {}: {}", path, codec_error_name(error));
+        return false;
+    }
+
+    header_written = true;
+    return true;
+}
+
+bool VideoRecorder::write_packets(AVCodecContext *context, AVStream *stream) {
+    while (true) {
+        int error = avcodec_receive_packet(context, packet);
+        if (error == AVERROR(EAGAIN) || error == AVERROR_EOF)
+            return true;
+        if (error < 0) {
+            LOG_WARN("Error encoding the recording: {}", codec_error_name(error));
+            return false;
+        }
+
+        av_packet_rescale_ts(packet, context->time_base, stream->time_base);
+        packet->stream_index = stream->index;
+        // the packet is unreferenced by the muxer
+        error = av_interleaved_write_frame(format, packet);
+        if (error < 0) {
+            LOG_WARN("Error writing the recording: {}", codec_error_name(error));
+            return false;
+        }
+    }
+}
+
+void VideoRecorder::encode_video(const QueuedFrame &frame) {
+    const auto sw_format = static_cast<AVPixelFormat>(video_frame->format);
+    sws_context = sws_getCachedContext(sws_context, static_cast<int>(frame.width), static_cast<int>(frame.height), AV_PIX_FMT_RGBA,
+        video_context->width, video_context->height, sw_format, SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!sws_context || av_frame_make_writable(video_frame) < 0)
+        return;
+
+    const uint8_t *const src_slices[] = { reinterpret_cast<const uint8_t *>(frame.pixels.data()) };
+    const int src_strides[] = { static_cast<int>(frame.width * sizeof(uint32_t)) };
+    sws_scale(sws_context, src_slices, src_strides, 0, static_cast<int>(frame.height), video_frame->data, video_frame->linesize);
+    video_frame->pts = frame.pts;
+
+    AVFrame *input = video_frame;
+    AVFrame *hw_frame = nullptr;
+    if (video_context->hw_frames_ctx) {
+        hw_frame = av_frame_alloc();
+        int error = hw_frame ? av_hwframe_get_buffer(video_context->hw_frames_ctx, hw_frame, 0) : AVERROR(ENOMEM);
+        if (error == 0)
+            error = av_hwframe_transfer_data(hw_frame, video_frame, 0);
+        if (error < 0) {
+            LOG_WARN("Error uploading a recorded frame to the encoder: {}", codec_error_name(error));
+            av_frame_free(&hw_frame);
+            return;
+        }
+        hw_frame->pts = frame.pts;
+        input = hw_frame;
+    }
+
+    const int error = avcodec_send_frame(video_context, input);
+    av_frame_free(&hw_frame);
+    if (error < 0) {
+        LOG_WARN("Error encoding a recorded frame: {}", codec_error_name(error));
+        return;
+    }
+    write_packets(video_context, video_stream);
+}
+
+void VideoRecorder::encode_audio(std::unique_lock<std::mutex> &lock, bool flush) {
+    if (!audio_context)
+        return;
+
+    const int64_t frame_size = audio_context->frame_size;
+    const int64_t end = flush ? mix_start + static_cast<int64_t>(mix.size() / 2) : get_mix_position(Clock::now()) - MIX_LATENCY;
+    while (mix_start < end) {
+        // the time nothing was output to is silent, the end of the last frame too
+        if (mix.size() < static_cast<size_t>(frame_size * 2))
+            mix.resize(frame_size * 2, 0.0f);
+
+        if (av_frame_make_writable(audio_frame) < 0)
+            return;
+        auto *left = reinterpret_cast<float *>(audio_frame->data[0]);
+        auto *right = reinterpret_cast<float *>(audio_frame->data[1]);
+        for (int64_t i = 0; i < frame_size; i++) {
+            left[i] = std::clamp(mix[i * 2], -1.0f, 1.0f);
+            right[i] = std::clamp(mix[i * 2 + 1], -1.0f, 1.0f);
+        }
+        mix.erase(mix.begin(), mix.begin() + frame_size * 2);
+        mix_start += frame_size;
+        audio_frame->pts = audio_pts;
+        audio_pts += frame_size;
+
+        lock.unlock();
+        const int error = avcodec_send_frame(audio_context, audio_frame);
+        if (error < 0)
+            LOG_WARN("Error encoding the recorded sound: {}", codec_error_name(error));
+        else
+            write_packets(audio_context, audio_stream);
+        lock.lock();
+    }
+}
+
+void VideoRecorder::encode_thread() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cond.wait_for(lock, std::chrono::milliseconds(20), [&] { return stopping || !frames.empty(); });
+
+        while (!frames.empty()) {
+            const QueuedFrame frame = std::move(frames.front());
+            frames.pop_front();
+            lock.unlock();
+            bool opened = header_written || open_output(frame.width, frame.height);
+            if (opened)
+                encode_video(frame);
+            lock.lock();
+
+            if (!opened) {
+                // nothing more is queued, the rest of the recording is ignored
+                recording = false;
+                frames.clear();
+                mix.clear();
+                break;
+            }
+        }
+
+        // the sound is only written once the file has its header, it is kept in the mix until then
+        if (header_written)
+            encode_audio(lock, stopping);
+        if (stopping || !recording)
+            break;
+    }
+    lock.unlock();
+
+    close();
+}
+
+void VideoRecorder::close() {
+    if (header_written) {
+        if (avcodec_send_frame(video_context, nullptr) == 0)
+            write_packets(video_context, video_stream);
+        if (audio_context && avcodec_send_frame(audio_context, nullptr) == 0)
+            write_packets(audio_context, audio_stream);
+
+        const int error = av_write_trailer(format);
+        if (error < 0)
+            LOG_WARN("Error finishing the recording: {}", codec_error_name(error));
+        else
+            LOG_INFO("Recording saved to {}", path);
+    }
+
+    if (format && !(format->oformat->flags & AVFMT_NOFILE))
+        avio_closep(&format->pb);
+    avformat_free_context(format);
+    format = nullptr;
+    video_stream = nullptr;
+    audio_stream = nullptr;
+    avcodec_free_context(&video_context);
+    avcodec_free_context(&audio_context);
+    av_buffer_unref(&hw_device);
+    av_frame_free(&video_frame);
+    av_frame_free(&audio_frame);
+    av_packet_free(&packet);
+    sws_freeContext(sws_context);
+    sws_context = nullptr;
+    header_written = false;
+}
@@ -0,0 +1,220 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/resampler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RESAMPLER_AVX
+#include <util/instrset_detect.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX __attribute__((__target__("avx")))
+#include <immintrin.h>
+#else
+#define TARGET_AVX
+#include <intrin.h>
+#endif
+#endif
+
+// number of filters the fractional position is split into, the filters between them are interpolated
+static constexpr uint32_t NB_PHASES = 128;
+// part of the band kept below the Nyquist frequency, the rest is the transition band of the filter
+static constexpr double PASSBAND = 0.95;
+// the filter is only rebuilt when the cutoff changes more than this, small pitch changes keep it
+static constexpr double CUTOFF_TOLERANCE = 0.02;
+
+// all the filters have a multiple of 8 taps
+#if !defined(__aarch64__)
+static void resample_frame_basic(const float *left, const float *right, const float *filter0, const float *filter1, float factor, uint32_t taps, float *output) {
+    float left_sum = 0.0f;
+    float right_sum = 0.0f;
+    for (uint32_t k = 0; k < taps; k++) {
+        const float coef = filter0[k] + (filter1[k] - filter0[k]) * factor;
+        left_sum += left[k] * coef;
+        right_sum += right[k] * coef;
+    }
+    output[0] = left_sum;
+    output[1] = right_sum;
+}
+#endif
+
+#if defined(__aarch64__)
+static void resample_frame(const float *left, const float *right, const float *filter0, const float *filter1, float factor, uint32_t taps, float *output) {
+    const float32x4_t factors = vdupq_n_f32(factor);
+    float32x4_t left_sum = vdupq_n_f32(0.0f);
+    float32x4_t right_sum = vdupq_n_f32(0.0f);
+    for (uint32_t k = 0; k < taps; k += 4) {
+        const float32x4_t coef0 = vld1q_f32(filter0 + k);
+        const float32x4_t coefs = vmlaq_f32(coef0, vsubq_f32(vld1q_f32(filter1 + k), coef0), factors);
+        left_sum = vmlaq_f32(left_sum, vld1q_f32(left + k), coefs);
+        right_sum = vmlaq_f32(right_sum, vld1q_f32(right + k), coefs);
+    }
+    output[0] = vaddvq_f32(left_sum);
+    output[1] = vaddvq_f32(right_sum);
+}
+#elif defined(RESAMPLER_AVX)
+static void TARGET_AVX resample_frame_avx(const float *left, const float *right, const float *filter0, const float *filter1, float factor, uint32_t taps, float *output) {
+    const __m256 factors = _mm256_set1_ps(factor);
+    __m256 left_sum = _mm256_setzero_ps();
+    __m256 right_sum = _mm256_setzero_ps();
+    for (uint32_t k = 0; k < taps; k += 8) {
+        const __m256 coef0 = _mm256_loadu_ps(filter0 + k);
+        const __m256 coefs = _mm256_add_ps(coef0, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(filter1 + k), coef0), factors));
+        left_sum = _mm256_add_ps(left_sum, _mm256_mul_ps(_mm256_loadu_ps(left + k), coefs));
+        right_sum = _mm256_add_ps(right_sum, _mm256_mul_ps(_mm256_loadu_ps(right + k), coefs));
+    }
+
+    // left sums in the low half of each lane, right sums in the high half
+    const __m256 sums = _mm256_hadd_ps(left_sum, right_sum);
+    const __m128 lanes = _mm_add_ps(_mm256_castps256_ps128(sums), _mm256_extractf128_ps(sums, 1));
+    const __m128 result = _mm_hadd_ps(lanes, lanes);
+    _mm_storel_pi(reinterpret_cast<__m64 *>(output), result);
+}
+
+// same as in gxm/stream.cpp, the implementation is chosen the first time it is used
+static void resample_frame_init(const float *left, const float *right, const float *filter0, const float *filter1, float factor, uint32_t taps, float *output);
+
+static void (*resample_frame)(const float *left, const float *right, const float *filter0, const float *filter1, float factor, uint32_t taps, float *output) = resample_frame_init;
+
+void resample_frame_init(const float *left, const float *right, const float *filter0, const float *filter1, float factor, uint32_t taps, float *output) {
+    if (util::instrset::instrset_detect() >= util::instrset::instrset_AVX)
+        resample_frame = resample_frame_avx;
+    else
+        resample_frame = resample_frame_basic;
+    resample_frame(left, right, filter0, filter1, factor, taps, output);
+}
+#else
+static void resample_frame(const float *left, const float *right, const float *filter0, const float *filter1, float factor, uint32_t taps, float *output) {
+    resample_frame_basic(left, right, filter0, filter1, factor, taps, output);
+}
+#endif
+
+static uint32_t get_taps(ResamplerQuality quality) {
+    switch (quality) {
+    case ResamplerQuality::Low: return 8;
+    case ResamplerQuality::High: return 32;
+    default: return 16;
+    }
+}
+
+Resampler::Resampler(ResamplerQuality quality)
+    : taps(get_taps(quality)) {
+    build_filter(PASSBAND);
+    reset();
+}
+
+void Resampler::build_filter(double cutoff) {
+    filter_cutoff = cutoff;
+    filter.resize((NB_PHASES + 1) * taps);
+
+    const double pi = std::numbers::pi;
+    for (uint32_t phase = 0; phase <= NB_PHASES; phase++) {
+        float *coefs = &filter[phase * taps];
+        double sum = 0.0;
+        for (uint32_t k = 0; k < taps; k++) {
+            // distance to the interpolated point, which is between the taps taps / 2 - 1 and taps / 2
+            const double distance = static_cast<double>(k) - (taps / 2 - 1) - static_cast<double>(phase) / NB_PHASES;
+            const double x = distance * cutoff;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+            // blackman window over the length of the filter
+            const double u = (distance + taps / 2) / taps;
+            const double window = 0.42 - 0.5 * std::cos(2 * pi * u) + 0.08 * std::cos(4 * pi * u);
+            coefs[k] = static_cast<float>(sinc * window);
+            sum += coefs[k];
+        }
+
+        // no gain on a constant signal
+        for (uint32_t k = 0; k < taps; k++)
+            coefs[k] = static_cast<float>(coefs[k] / sum);
+    }
+}
+
+void Resampler::set_rates(double in_rate, double out_rate) {
+    step = in_rate / out_rate;
+
+    // when downsampling, the frequencies above the output Nyquist frequency must be removed
+    const double cutoff = std::min(1.0, out_rate / in_rate) * PASSBAND;
+    if (std::abs(cutoff - filter_cutoff) > CUTOFF_TOLERANCE)
+        build_filter(cutoff);
+}
+
+void Resampler::reset() {
+    // the first output frame is the first input frame
+    for (std::vector<float> &channel : history)
+        channel.assign(taps / 2 - 1, 0.0f);
+    position = 0.0;
+}
+
+uint32_t Resampler::get_input_needed(uint32_t out_frames) const {
+    if (out_frames == 0)
+        return 0;
+
+    const uint32_t last_frame = static_cast<uint32_t>(position + (out_frames - 1) * step);
+    const uint32_t needed = last_frame + taps;
+    const uint32_t available = static_cast<uint32_t>(history[0].size());
+    return needed > available ? needed - available : 0;
+}
+
+uint32_t Resampler::get_max_output(uint32_t in_frames) const {
+    const uint32_t available = static_cast<uint32_t>(history[0].size()) + in_frames;
+    if (available < taps)
+        return 0;
+
+    // the output frames at a position lower than this have all their taps
+    const double end = static_cast<double>(available - taps + 1);
+    if (end <= position)
+        return 0;
+    return static_cast<uint32_t>(std::ceil((end - position) / step));
+}
+
+uint32_t Resampler::process(const float *input, uint32_t in_frames, float *output, uint32_t max_out_frames) {
+    const size_t old_size = history[0].size();
+    history[0].resize(old_size + in_frames);
+    history[1].resize(old_size + in_frames);
+    for (uint32_t i = 0; i < in_frames; i++) {
+        history[0][old_size + i] = input[i * 2];
+        history[1][old_size + i] = input[i * 2 + 1];
+    }
+
+    const size_t history_size = history[0].size();
+    uint32_t out_frames = 0;
+    for (; out_frames < max_out_frames; out_frames++) {
+        const uint32_t first_frame = static_cast<uint32_t>(position);
+        if (first_frame + taps > history_size)
+            break;
+
+        const double phase_position = (position - first_frame) * NB_PHASES;
+        const uint32_t phase = std::min(static_cast<uint32_t>(phase_position), NB_PHASES - 1);
+        const float factor = static_cast<float>(phase_position - phase);
+        resample_frame(&history[0][first_frame], &history[1][first_frame], &filter[phase * taps], &filter[(phase + 1) * taps],
+            factor, taps, output + out_frames * 2);
+        position += step;
+    }
+
+    // forget the frames which will not be used anymore
+    const size_t consumed = std::min(static_cast<size_t>(position), history_size);
+    for (std::vector<float> &channel : history)
+        channel.erase(channel.begin(), channel.begin() + consumed);
+    position -= static_cast<double>(consumed);
+
+    return out_frames;
+}
@@ -91,13 +91,14 @@ static bool extract_zip_file(const char *zip_filename, const fs::path &output_pa
     return true;
 }
 
-bool load_app_compat_db(GuiState &gui, EmuEnvState &emuenv) {
-    const auto app_compat_db_path = emuenv.cache_path / "app_compat_db.xml";
-    if (!fs::exists(app_compat_db_path)) {
-        LOG_WARN("Compatibility database not found at {}.", app_compat_db_path);
-        return false;
-    }
+struct CompatDb {
+    uint32_t version = 0;
+    uint32_t issue_count = 0;
+    std::string updated_at;
+    std::map<std::string, Compatibility> apps;
+};
 
+static bool parse_app_compat_db(const fs::path &app_compat_db_path, EmuEnvState &emuenv, CompatDb &db) {
     // Parse and load file of compatibility database
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_file(app_compat_db_path.c_str());
@@ -106,28 +107,13 @@ bool load_app_compat_db(GuiState &gui, EmuEnvState &emuenv) {
         return false;
     }
 
-    // Check compatibility database version
     const auto compatibility = doc.child("compatibility");
-    const auto version = compatibility.attribute("version").as_uint();
-    db_issue_count = compatibility.attribute("issue_count").as_uint();
-    if (db_version != version) {
-        LOG_WARN("Compatibility database version {} is outdated, download it again.", version);
-        return update_app_compat_db(gui, emuenv);
-    }
-
-    // Check if compatibility database is up to date in first load
-    if (db_updated_at.empty()) {
-        db_updated_at = compatibility.attribute("iso_db_updated_at").as_string();
-        if (update_app_compat_db(gui, emuenv))
-            return true;
-    }
-
-    // Clear old compat database
-    gui.compat.compat_db_loaded = false;
-    gui.compat.app_compat_db.clear();
+    db.version = compatibility.attribute("version").as_uint();
+    db.issue_count = compatibility.attribute("issue_count").as_uint();
+    db.updated_at = compatibility.attribute("iso_db_updated_at").as_string();
 
     //  Load compatibility database
-    for (const auto &app : doc.child("compatibility")) {
+    for (const auto &app : compatibility) {
         const std::string title_id = app.attribute("title_id").as_string();
         const auto issue_id = app.child("issue_id").text().as_uint();
 
@@ -161,12 +147,155 @@ bool load_app_compat_db(GuiState &gui, EmuEnvState &emuenv) {
             LOG_WARN_IF(emuenv.cfg.log_compat_warn, "App with Title ID {} has an issue but no status label. Please check GitHub issue {} and request a status label be added.", title_id, issue_id);
 
         // Check if app already exists in compatibility database
-        if (gui.compat.app_compat_db.contains(title_id))
-            LOG_WARN_IF(emuenv.cfg.log_compat_warn, "App with Title ID {} already exists in compatibility database. Please check and close GitHub issue {}.", title_id, gui.compat.app_compat_db[title_id].issue_id);
+        if (db.apps.contains(title_id))
+            LOG_WARN_IF(emuenv.cfg.log_compat_warn, "App with Title ID {} already exists in compatibility database. Please check and close GitHub issue {}.", title_id, db.apps[title_id].issue_id);
 
-        gui.compat.app_compat_db[title_id] = { issue_id, state, updated_at };
+        db.apps[title_id] = { issue_id, state, updated_at };
     }
 
+    return true;
+}
+
+// The parsed database is kept in a binary index next to it, used as long as the XML file does not change
+static constexpr uint32_t INDEX_MAGIC = 0x58444343; // CCDX
+static constexpr uint32_t INDEX_VERSION = 1;
+
+struct CompatIndexKey {
+    uint64_t xml_size;
+    int64_t xml_write_time;
+};
+
+static bool get_index_key(const fs::path &app_compat_db_path, CompatIndexKey &key) {
+    boost::system::error_code error_code;
+    key.xml_size = fs::file_size(app_compat_db_path, error_code);
+    if (error_code)
+        return false;
+    key.xml_write_time = static_cast<int64_t>(fs::last_write_time(app_compat_db_path, error_code));
+    return !error_code;
+}
+
+template <typename T>
+static void write_value(fs::ofstream &index, const T &value) {
+    index.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool read_value(fs::ifstream &index, T &value) {
+    return static_cast<bool>(index.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+static void write_string(fs::ofstream &index, const std::string &str) {
+    write_value(index, static_cast<uint32_t>(str.size()));
+    index.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+static bool read_string(fs::ifstream &index, std::string &str) {
+    uint32_t size;
+    // the strings are a title ID or a date
+    if (!read_value(index, size) || size > 256)
+        return false;
+    str.resize(size);
+    return static_cast<bool>(index.read(str.data(), size));
+}
+
+static bool read_app_compat_index(const fs::path &index_path, const fs::path &app_compat_db_path, CompatDb &db) {
+    CompatIndexKey key;
+    if (!get_index_key(app_compat_db_path, key))
+        return false;
+
+    fs::ifstream index(index_path, std::ios::binary);
+    if (!index)
+        return false;
+
+    uint32_t magic, index_version, app_count;
+    CompatIndexKey index_key;
+    if (!read_value(index, magic) || magic != INDEX_MAGIC || !read_value(index, index_version) || index_version != INDEX_VERSION
+        || !read_value(index, index_key.xml_size) || !read_value(index, index_key.xml_write_time)
+        || index_key.xml_size != key.xml_size || index_key.xml_write_time != key.xml_write_time)
+        return false;
+
+    if (!read_value(index, db.version) || !read_value(index, db.issue_count) || !read_string(index, db.updated_at) || !read_value(index, app_count))
+        return false;
+
+    for (uint32_t i = 0; i < app_count; i++) {
+        std::string title_id;
+        Compatibility compat;
+        int32_t state;
+        int64_t updated_at;
+        if (!read_string(index, title_id) || !read_value(index, compat.issue_id) || !read_value(index, state) || !read_value(index, updated_at))
+            return false;
+        compat.state = static_cast<CompatibilityState>(state);
+        compat.updated_at = static_cast<time_t>(updated_at);
+        db.apps.emplace(std::move(title_id), compat);
+    }
+
+    return true;
+}
+
+static void write_app_compat_index(const fs::path &index_path, const fs::path &app_compat_db_path, const CompatDb &db) {
+    CompatIndexKey key;
+    if (!get_index_key(app_compat_db_path, key))
+        return;
+
+    fs::ofstream index(index_path, std::ios::binary);
+    write_value(index, INDEX_MAGIC);
+    write_value(index, INDEX_VERSION);
+    write_value(index, key.xml_size);
+    write_value(index, key.xml_write_time);
+    write_value(index, db.version);
+    write_value(index, db.issue_count);
+    write_string(index, db.updated_at);
+    write_value(index, static_cast<uint32_t>(db.apps.size()));
+    for (const auto &[title_id, compat] : db.apps) {
+        write_string(index, title_id);
+        write_value(index, compat.issue_id);
+        write_value(index, static_cast<int32_t>(compat.state));
+        write_value(index, static_cast<int64_t>(compat.updated_at));
+    }
+
+    if (!index) {
+        LOG_WARN("Failed to write the compatibility database index {}", index_path);
+        index.close();
+        fs::remove(index_path);
+    }
+}
+
+bool load_app_compat_db(GuiState &gui, EmuEnvState &emuenv) {
+    const auto app_compat_db_path = emuenv.cache_path / "app_compat_db.xml";
+    if (!fs::exists(app_compat_db_path)) {
+        LOG_WARN("Compatibility database not found at {}.", app_compat_db_path);
+        return false;
+    }
+
+    // the warnings about the entries are only given when parsing the XML file
+    const auto index_path = emuenv.cache_path / "app_compat_db.bin";
+    CompatDb db;
+    if (emuenv.cfg.log_compat_warn || !read_app_compat_index(index_path, app_compat_db_path, db)) {
+        db = {};
+        if (!parse_app_compat_db(app_compat_db_path, emuenv, db))
+            return false;
+        if (db.version == db_version)
+            write_app_compat_index(index_path, app_compat_db_path, db);
+    }
+
+    // Check compatibility database version
+    db_issue_count = db.issue_count;
+    if (db_version != db.version) {
+        LOG_WARN("Compatibility database version {} is outdated, download it again.", db.version);
+        return update_app_compat_db(gui, emuenv);
+    }
+
+    // Check if compatibility database is up to date in first load
+    if (db_updated_at.empty()) {
+        db_updated_at = db.updated_at;
+        if (update_app_compat_db(gui, emuenv))
+            return true;
+    }
+
+    // Replace old compat database
+    gui.compat.compat_db_loaded = false;
+    gui.compat.app_compat_db = std::move(db.apps);
+
     // Update compatibility status of all user apps
     for (auto &app : gui.app_selector.user_apps)
         app.compat = gui.compat.app_compat_db.contains(app.title_id) ? gui.compat.app_compat_db[app.title_id].state : CompatibilityState::UNKNOWN;
@@ -30,6 +30,12 @@ enum PerformanceOverlayDetail {
     LOW,
     MEDIUM,
     MAXIMUM,
+    // maximum with the GPU timings
+    GPU_TIMINGS,
+    // maximum with the audio pipeline stats
+    AUDIO_TIMINGS,
+    // maximum with the breakdown of the frame time between the emulation stages
+    FRAME_TIMINGS,
 };
 
 enum PerformanceOverlayPosition {
@@ -78,22 +84,50 @@ enum ScreenshotFormat {
     code(int, "gpu-idx", 0, gpu_idx)                                                                    \
     code(bool, "high-accuracy", false, high_accuracy)                                                   \
     code(float, "resolution-multiplier", 1.0f, resolution_multiplier)                                   \
+    code(int, "surface-cache-budget", 0, surface_cache_budget)                                          \
+    code(int, "pipeline-stutter-threshold-ms", 50, pipeline_stutter_threshold_ms)                       \
     code(bool, "disable-surface-sync", true, disable_surface_sync)                                      \
     code(std::string, "screen-filter", "Bilinear", screen_filter)                                       \
     code(bool, "v-sync", true, v_sync)                                                                  \
     code(int, "anisotropic-filtering", 1, anisotropic_filtering)                                        \
     code(bool, "texture-cache", true, texture_cache)                                                    \
     code(bool, "async-pipeline-compilation", true, async_pipeline_compilation)                          \
+    code(int, "scene-chunk-draws", 0, scene_chunk_draws)                                                \
+    code(bool, "async-texture-upload", false, async_texture_upload)                                     \
+    code(bool, "transcode-bcn-to-etc2", false, transcode_bcn_to_etc2)                                   \
+    code(bool, "async-texture-import", false, async_texture_import)                                     \
+    code(bool, "optimize-spirv", false, optimize_spirv)                                                 \
+    code(bool, "soft-dirty-tracking", false, soft_dirty_tracking)                                       \
+    code(bool, "huge-pages", false, huge_pages)                                                         \
+    code(bool, "reclaim-cold-pages", false, reclaim_cold_pages)                                         \
+    code(bool, "hle-malloc-slabs", false, hle_malloc_slabs)                                             \
+    code(int, "renderer-capture-frames", 0, renderer_capture_frames)                                    \
+    code(std::string, "present-mode", "Auto", present_mode)                                             \
+    code(int, "max-frames-in-flight", 3, max_frames_in_flight)                                          \
+    code(bool, "decouple-display-rate", false, decouple_display_rate)                                   \
+    code(int, "thread-block-pool-size", 16, thread_block_pool_size)                                     \
     code(bool, "show-compile-shaders", true, show_compile_shaders)                                      \
     code(bool, "hashless-texture-cache", false, hashless_texture_cache)                                 \
     code(bool, "import-textures", false, import_textures)                                               \
     code(bool, "export-textures", false, export_textures)                                               \
     code(bool, "export-as-png", true, export_as_png)                                                    \
     code(std::string, "memory-mapping", "double-buffer", memory_mapping)                                \
+    code(bool, "page-table-fastmem", true, page_table_fastmem)                                          \
+    code(bool, "map-app-files", true, map_app_files)                                                    \
+    code(int, "io-write-buffer-size", 64, io_write_buffer_size)                                         \
+    code(bool, "io-stats", false, io_stats)                                                             \
+    code(bool, "hle-profiler", false, hle_profiler)                                                     \
+    code(bool, "import-trace", false, import_trace)                                                     \
+    code(bool, "guest-profiler", false, guest_profiler)                                                 \
+    code(bool, "boot-trace", false, boot_trace)                                                         \
     code(bool, "boot-apps-full-screen", false, boot_apps_full_screen)                                   \
     code(std::string, "audio-backend", "SDL", audio_backend)                                            \
     code(int, "audio-volume", 100, audio_volume)                                                        \
+    code(int, "audio-latency", 0, audio_latency)                                                        \
     code(bool, "ngs-enable", true, ngs_enable)                                                          \
+    code(bool, "atrac9-decode-ahead", false, atrac9_decode_ahead)                                       \
+    code(bool, "video-hw-decoding", false, video_hw_decoding)                                           \
+    code(int, "video-decoder-threads", 0, video_decoder_threads)                                        \
     code(int,  "bgm-volume", 65, bgm_volume)                                                            \
     code(int, "sys-button", static_cast<int>(SCE_SYSTEM_PARAM_ENTER_BUTTON_CROSS), sys_button)          \
     code(int, "sys-lang", static_cast<int>(SCE_SYSTEM_PARAM_LANG_ENGLISH_US), sys_lang)                 \
@@ -101,11 +135,20 @@ enum ScreenshotFormat {
     code(int, "sys-time-format", (int)SCE_SYSTEM_PARAM_TIME_FORMAT_12HOUR, sys_time_format)             \
     code(int, "cpu-pool-size", 10, cpu_pool_size)                                                       \
     code(int, "modules-mode", static_cast<int>(ModulesMode::AUTOMATIC), modules_mode)                   \
+    code(bool, "lazy-load-modules", true, lazy_load_modules)                                            \
+    code(bool, "prefetch-boot-modules", true, prefetch_boot_modules)                                    \
     code(int, "delay-background", 4, delay_background)                                                  \
     code(int, "delay-start", 30, delay_start)                                                           \
     code(float, "background-alpha", .300f, background_alpha)                                            \
     code(int, "log-level", 0 /*SPDLOG_LEVEL_TRACE*/, log_level)                                         \
     code(bool, "cpu-opt", true, cpu_opt)                                                                \
+    code(std::string, "cpu-profile", "auto", cpu_profile)                                               \
+    code(bool, "jit-block-cache", false, jit_block_cache)                                               \
+    code(bool, "shared-jit-cache", false, shared_jit_cache)                                             \
+    code(std::string, "host-core-sets", std::string{}, host_core_sets)                                  \
+    code(bool, "mirror-thread-priority", false, mirror_thread_priority)                                 \
+    code(std::string, "thread-priority-policy", "coarse", thread_priority_policy)                       \
+    code(bool, "spin-loop-fast-forward", true, spin_loop_fast_forward)                                  \
     code(std::string, "pref-path", std::string{}, pref_path)                                            \
     code(bool, "discord-rich-presence", true, discord_rich_presence)                                    \
     code(bool, "wait-for-debugger", false, wait_for_debugger)                                           \
@@ -151,6 +194,8 @@ enum ScreenshotFormat {
     code(int, "keyboard-gui-toggle-touch", 23, keyboard_gui_toggle_touch)                               \
     code(int, "keyboard-toggle-texture-replacement", 0, keyboard_toggle_texture_replacement)            \
     code(int, "keyboard-take-screenshot", 0, keyboard_take_screenshot)                                  \
+    code(int, "keyboard-save-state", 0, keyboard_save_state)                                            \
+    code(int, "keyboard-load-state", 0, keyboard_load_state)                                            \
     code(int, "keyboard-pinch-modifier", 0, keyboard_pinch_modifier)                                    \
     code(int, "keyboard-alternate-pinch-in", 0, keyboard_alternate_pinch_in)                            \
     code(int, "keyboard-alternate-pinch-out", 0, keyboard_alternate_pinch_out)                          \
@@ -184,6 +229,8 @@ enum ScreenshotFormat {
     code(int, "keyboard-gui-toggle-touch-alt", 0, keyboard_gui_toggle_touch_alt)                        \
     code(int, "keyboard-toggle-texture-replacement-alt", 0, keyboard_toggle_texture_replacement_alt)    \
     code(int, "keyboard-take-screenshot-alt", 0, keyboard_take_screenshot_alt)                          \
+    code(int, "keyboard-save-state-alt", 0, keyboard_save_state_alt)                                    \
+    code(int, "keyboard-load-state-alt", 0, keyboard_load_state_alt)                                    \
     code(int, "keyboard-pinch-modifier-alt", 0, keyboard_pinch_modifier_alt)                            \
     code(int, "keyboard-alternate-pinch-in-alt", 0, keyboard_alternate_pinch_in_alt)                    \
     code(int, "keyboard-alternate-pinch-out-alt", 0, keyboard_alternate_pinch_out_alt)                 \
@@ -197,6 +244,7 @@ enum ScreenshotFormat {
     code(bool, "asia-font-support", false, asia_font_support)                                           \
     code(bool, "shader-cache", true, shader_cache)                                                      \
     code(bool, "spirv-shader", false, spirv_shader)                                                     \
+    code(bool, "preload-shaders", true, preload_shaders)                                                \
     code(bool, "fps-hack", false, fps_hack)                                                             \
     code(uint64_t, "current-ime-lang", 4, current_ime_lang)                                             \
     code(int, "psn-signed-in", false, psn_signed_in)                                                    \
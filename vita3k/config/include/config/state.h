@@ -29,6 +29,14 @@ struct Config {
     std::optional<fs::path> content_path;
     std::optional<std::string> run_app_path;
     std::optional<std::string> recompile_shader_path;
+    std::optional<std::string> import_shader_cache_path;
+    std::optional<std::string> export_shader_cache_path;
+    std::optional<std::string> input_script_path;
+    std::optional<int> perf_run_seconds;
+    std::optional<std::string> perf_report_path;
+    std::optional<std::string> record_video_path;
+    std::optional<int> benchmark_cpu_profiles_seconds;
+    std::optional<float> fast_forward_speed;
     std::optional<std::string> delete_title_id;
     std::optional<std::string> pkg_path;
     std::optional<std::string> pkg_zrif;
@@ -43,6 +51,8 @@ struct Config {
     bool load_config = false;
     bool fullscreen = false;
     bool console = false;
+    bool headless = false;
+    bool log_frame_hashes = false;
     bool load_app_list = false;
 
     fs::path get_pref_path() const {
@@ -60,6 +70,7 @@ struct Config {
      */
     struct CurrentConfig {
         bool cpu_opt = true;
+        std::string cpu_profile = "auto";
         int modules_mode = ModulesMode::AUTOMATIC;
         std::vector<std::string> lle_modules = {};
         int audio_volume = 100;
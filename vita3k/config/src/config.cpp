@@ -74,6 +74,22 @@ static void check_members(Config &self, const Config &rhs) {
         self.run_app_path = rhs.run_app_path;
     if (rhs.recompile_shader_path.has_value())
         self.recompile_shader_path = rhs.recompile_shader_path;
+    if (rhs.import_shader_cache_path.has_value())
+        self.import_shader_cache_path = rhs.import_shader_cache_path;
+    if (rhs.export_shader_cache_path.has_value())
+        self.export_shader_cache_path = rhs.export_shader_cache_path;
+    if (rhs.input_script_path.has_value())
+        self.input_script_path = rhs.input_script_path;
+    if (rhs.perf_run_seconds.has_value())
+        self.perf_run_seconds = rhs.perf_run_seconds;
+    if (rhs.perf_report_path.has_value())
+        self.perf_report_path = rhs.perf_report_path;
+    if (rhs.record_video_path.has_value())
+        self.record_video_path = rhs.record_video_path;
+    if (rhs.benchmark_cpu_profiles_seconds.has_value())
+        self.benchmark_cpu_profiles_seconds = rhs.benchmark_cpu_profiles_seconds;
+    if (rhs.fast_forward_speed.has_value())
+        self.fast_forward_speed = rhs.fast_forward_speed;
     if (rhs.delete_title_id.has_value())
         self.delete_title_id = rhs.delete_title_id;
     if (rhs.pkg_path.has_value())
@@ -88,6 +104,8 @@ static void check_members(Config &self, const Config &rhs) {
     self.load_config = rhs.load_config;
     self.fullscreen = rhs.fullscreen;
     self.console = rhs.console;
+    self.headless = rhs.headless;
+    self.log_frame_hashes = rhs.log_frame_hashes;
     self.app_args = rhs.app_args;
     self.load_app_list = rhs.load_app_list;
     self.self_path = rhs.self_path;
@@ -251,6 +269,10 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
     auto input = app.add_option_group("Input", "Special options for Vita3K");
     input->add_flag("--console,-z", command_line.console, "Start the emulator in console mode.")
        ->default_val(false)->group("Input");
+    input->add_flag("--headless", command_line.headless, "Run the app without the GUI and without presenting its frames, for automated runs.")
+       ->default_val(false)->group("Input");
+    input->add_flag("--log-frame-hashes", command_line.log_frame_hashes, "Log a hash of each frame displayed by the app, to compare runs.")
+       ->default_val(false)->group("Input");
     input->add_option("--app-args,-Z", command_line.app_args, "Argument for app, use ', ' to separate arguments.")
         ->default_str("")->group("Input");
     input->add_option("--load-app-list,-a", command_line.load_app_list, "Starts the emulator with load app list.")
@@ -261,6 +283,22 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
         ->default_str({})->check(CLI::IsMember(get_file_set(cfg.get_pref_path() / "ux0/app")))->group("Input");
     input->add_option("--recompile-shader,-s", command_line.recompile_shader_path, "Recompile the given PS Vita shader (GXP format) to SPIR_V / GLSL and quit")
         ->default_str({})->group("Input");
+    input->add_option("--import-shader-cache", command_line.import_shader_cache_path, "Merge a shader cache exported from another machine into the cache of the app to run")
+        ->default_str({})->group("Input");
+    input->add_option("--export-shader-cache", command_line.export_shader_cache_path, "Export the shader cache of the app to run to the given file when it is closed")
+        ->default_str({})->group("Input");
+    input->add_option("--input-script", command_line.input_script_path, "Replay the controller input of the given script, one line per change: <vblank> <buttons> [lx ly rx ry]")
+        ->default_str({})->group("Input");
+    input->add_option("--perf-run", command_line.perf_run_seconds, "With --headless, measure the app for this many seconds after its first frame, save a performance report and quit")
+        ->default_str({})->check(CLI::PositiveNumber)->group("Input");
+    input->add_option("--perf-report", command_line.perf_report_path, "Path of the report of --perf-run, perf_report.json in the log folder by default")
+        ->default_str({})->group("Input");
+    input->add_option("--record-video", command_line.record_video_path, "Record the frames and the sound of the app to the given video file (.mp4 or .mkv) until it is closed")
+        ->default_str({})->group("Input");
+    input->add_option("--benchmark-cpu-profiles", command_line.benchmark_cpu_profiles_seconds, "Measure each CPU optimization profile on the app for this many seconds after its first frame, and record the fastest stable one for the auto profile")
+        ->default_str({})->check(CLI::PositiveNumber)->group("Input");
+    input->add_option("--fast-forward", command_line.fast_forward_speed, "Run the clock of the app (time, timers, delays and vblanks) this many times faster than real time, for automated runs")
+        ->default_str({})->check(CLI::Range(1.0f, 16.0f))->group("Input");
     input->add_option("--deleted-id,-d", command_line.delete_title_id, "Title ID of installed app to delete")
         ->default_str({})->check(CLI::IsMember(get_file_set(cfg.get_pref_path() / "ux0/app")))->group("Input");
     input->add_option("--firmware", command_line.pup_path, "Path to the firmware file (.pup extension) to install");
@@ -348,6 +386,22 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
         return InitConfigFailed;
     }
 
+    if (command_line.headless && (command_line.console || (!command_line.run_app_path && !command_line.content_path))) {
+        LOG_ERROR("Headless mode needs an app to run, given with its content path or --installed-path.");
+        return InitConfigFailed;
+    }
+
+    // the shader counters are reset by the GUI, they are only meaningful without it
+    if (command_line.perf_run_seconds && !command_line.headless) {
+        LOG_ERROR("--perf-run needs --headless.");
+        return InitConfigFailed;
+    }
+
+    if ((command_line.import_shader_cache_path || command_line.export_shader_cache_path) && !command_line.run_app_path && !command_line.content_path) {
+        LOG_ERROR("The shader cache can only be imported or exported for an app given with its content path or --installed-path.");
+        return InitConfigFailed;
+    }
+
     // Get LLE modules from the command line, otherwise get the modules from the YML file
     if (!lle_modules.empty()) {
         if (command_line.load_config) {
@@ -373,6 +427,7 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
         LOG_INFO("log-level: {}", LIST_LOG_LEVEL[cfg.log_level]);
         LOG_INFO_IF(cfg.log_active_shaders, "log-active-shaders: enabled");
         LOG_INFO_IF(cfg.log_uniforms, "log-uniforms: enabled");
+        LOG_INFO_IF(cfg.headless, "headless: enabled");
     }
     // Save any changes made in command-line arguments
     if (cfg.overwrite_config || !fs::exists(check_path(cfg.config_path))) {
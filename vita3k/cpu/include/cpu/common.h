@@ -39,10 +39,37 @@ typedef std::unique_ptr<CPUState, std::function<void(CPUState *)>> CPUStatePtr;
 typedef std::unique_ptr<CPUInterface> CPUInterfacePtr;
 typedef void *ExclusiveMonitorPtr;
 
+// Optional optimizations of the jit, combined in the profiles below. None of them is used when cpu-opt is off.
+enum JitOptimization : uint32_t {
+    // the generated code accesses the guest memory directly, or through the page table inlined in it
+    JIT_OPT_FASTMEM = 1 << 0,
+    JIT_OPT_BLOCK_LINKING = 1 << 1,
+    JIT_OPT_RETURN_STACK_BUFFER = 1 << 2,
+    // faster floating point operations, less accurate for NaNs and fused multiply-adds
+    JIT_OPT_UNSAFE_FP = 1 << 3,
+    // exclusive loads and stores behave like plain ones, only fine for apps that do not race on them
+    JIT_OPT_UNSAFE_IGNORE_GLOBAL_MONITOR = 1 << 4,
+};
+
+struct JitProfile {
+    const char *name;
+    uint32_t optimizations;
+};
+
+// the profiles which can be chosen per app, the first one is the default
+constexpr std::array<JitProfile, 5> JIT_PROFILES = { {
+    { "default", JIT_OPT_FASTMEM | JIT_OPT_BLOCK_LINKING | JIT_OPT_RETURN_STACK_BUFFER },
+    { "unsafe-fp", JIT_OPT_FASTMEM | JIT_OPT_BLOCK_LINKING | JIT_OPT_RETURN_STACK_BUFFER | JIT_OPT_UNSAFE_FP },
+    { "unsafe", JIT_OPT_FASTMEM | JIT_OPT_BLOCK_LINKING | JIT_OPT_RETURN_STACK_BUFFER | JIT_OPT_UNSAFE_FP | JIT_OPT_UNSAFE_IGNORE_GLOBAL_MONITOR },
+    { "no-fastmem", JIT_OPT_BLOCK_LINKING | JIT_OPT_RETURN_STACK_BUFFER },
+    { "no-block-linking", JIT_OPT_FASTMEM },
+} };
+
 struct CPUProtocolBase {
     virtual void call_svc(CPUState &cpu, uint32_t svc, Address pc, ThreadState &thread) = 0;
     virtual Address get_watch_memory_addr(Address addr) = 0;
     virtual ExclusiveMonitorPtr get_exclusive_monitor() = 0;
+    virtual void record_sample(CPUState &cpu, Address pc, Address lr) = 0;
     virtual ~CPUProtocolBase() = default;
 };
 
@@ -106,6 +133,12 @@ struct CPUContext {
     }
 };
 
+// registers the arguments of a call are read from, taken at once by the HLE bridge
+struct ArgRegs {
+    std::array<uint32_t, 4> gpr{};
+    uint32_t sp = 0;
+};
+
 union DoubleReg {
     double d;
     float f[2];
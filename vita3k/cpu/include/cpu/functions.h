@@ -23,10 +23,12 @@
 #include <cpu/common.h>
 
 #include <cstdint>
+#include <string_view>
 
 struct MemState;
 
-CPUStatePtr init_cpu(bool cpu_opt, SceUID thread_id, std::size_t processor_id, MemState &mem, CPUProtocolBase *protocol);
+// jit_optimizations is a combination of JitOptimization
+CPUStatePtr init_cpu(uint32_t jit_optimizations, SceUID thread_id, std::size_t processor_id, MemState &mem, CPUProtocolBase *protocol);
 int run(CPUState &state);
 int step(CPUState &state);
 void stop(CPUState &state);
@@ -36,6 +38,7 @@ uint32_t read_reg(CPUState &state, size_t index);
 float read_float_reg(CPUState &state, size_t index);
 void write_float_reg(CPUState &state, size_t index, float value);
 uint32_t read_sp(CPUState &state);
+ArgRegs read_arg_regs(CPUState &state);
 uint32_t read_pc(CPUState &state);
 uint32_t read_lr(CPUState &state);
 uint32_t read_tpidruro(CPUState &state);
@@ -49,6 +52,13 @@ CPUContext save_context(CPUState &state);
 void load_context(CPUState &state, const CPUContext &ctx);
 std::size_t get_processor_id(CPUState &state);
 void invalidate_jit_cache(CPUState &state, Address start, size_t length);
+void warm_up_jit(CPUState &state);
+// thread-safe, the CPU gives its PC and LR to record_sample of its protocol at the next block boundary
+void request_sample(CPUState &state);
+// thread-safe, the jit is created again with these optimizations at the next block boundary
+void set_jit_optimizations(CPUState &state, uint32_t jit_optimizations);
+// optimizations of the profile with this name, the ones of the default profile if there is none
+uint32_t get_jit_profile_optimizations(std::string_view name);
 
 uint32_t read_fpscr(CPUState &state);
 void write_fpscr(CPUState &state, uint32_t value);
@@ -58,9 +68,19 @@ void write_cpsr(CPUState &state, uint32_t value);
 uint32_t stack_alloc(CPUState &state, size_t size);
 uint32_t stack_free(CPUState &state, size_t size);
 
+struct ExclusiveStats {
+    // store exclusives done while holding the reservation, the ones failing because it was lost are not counted
+    uint64_t stores = 0;
+    // stores that failed because the memory changed since the load exclusive
+    uint64_t failed_stores = 0;
+};
+
 ExclusiveMonitorPtr new_exclusive_monitor(int max_num_cores);
 void free_exclusive_monitor(ExclusiveMonitorPtr monitor);
 void clear_exclusive(ExclusiveMonitorPtr monitor, std::size_t core_num);
+// drops the reservation of this cpu without locking the monitor shared by all the cores
+void clear_exclusive(CPUState &state);
+ExclusiveStats get_exclusive_stats(ExclusiveMonitorPtr monitor);
 
 // Debugging helpers
 std::string disassemble(CPUState &state, uint64_t at, bool thumb, uint16_t *insn_size = nullptr);
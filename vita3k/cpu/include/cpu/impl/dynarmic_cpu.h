@@ -18,15 +18,34 @@
 #pragma once
 
 #include <dynarmic/interface/A32/a32.h>
+#include <dynarmic/interface/exclusive_monitor.h>
 
 #include <cpu/functions.h>
 #include <cpu/impl/interface.h>
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 class ArmDynarmicCallback;
 class ArmDynarmicCP15;
 
+// The monitor shared by all the cores, with the counters of the store exclusives of each core
+// kept on their own cache line so that counting does not add contention between the cores
+struct DynarmicExclusiveMonitor {
+    struct alignas(64) CoreCounters {
+        std::atomic<uint64_t> stores = 0;
+        std::atomic<uint64_t> failed_stores = 0;
+    };
+
+    explicit DynarmicExclusiveMonitor(std::size_t max_num_cores)
+        : monitor(max_num_cores)
+        , counters(max_num_cores) {}
+
+    Dynarmic::ExclusiveMonitor monitor;
+    std::vector<CoreCounters> counters;
+};
+
 class DynarmicCPU : public CPUInterface {
     friend class ArmDynarmicCallback;
 
@@ -35,7 +54,7 @@ class DynarmicCPU : public CPUInterface {
     std::unique_ptr<Dynarmic::A32::Jit> jit;
     std::unique_ptr<ArmDynarmicCallback> cb;
     std::shared_ptr<ArmDynarmicCP15> cp15;
-    Dynarmic::ExclusiveMonitor *monitor;
+    DynarmicExclusiveMonitor *monitor;
 
     std::size_t core_id = 0;
 
@@ -44,12 +63,14 @@ class DynarmicCPU : public CPUInterface {
 
     bool log_mem = false;
     bool log_code = false;
-    bool cpu_opt;
+    // combination of JitOptimization the jit was created with, and the one it must be created again with
+    uint32_t optimizations;
+    std::atomic<uint32_t> requested_optimizations;
 
     std::unique_ptr<Dynarmic::A32::Jit> make_jit();
 
 public:
-    DynarmicCPU(CPUState *state, std::size_t processor_id, Dynarmic::ExclusiveMonitor *monitor, bool cpu_opt);
+    DynarmicCPU(CPUState *state, std::size_t processor_id, DynarmicExclusiveMonitor *monitor, uint32_t optimizations);
     ~DynarmicCPU() override;
     int run() override;
     void stop() override;
@@ -58,6 +79,7 @@ public:
     void set_reg(uint8_t idx, uint32_t val) override;
 
     uint32_t get_sp() override;
+    ArgRegs get_arg_regs() override;
     void set_sp(uint32_t val) override;
 
     uint32_t get_pc() override;
@@ -93,4 +115,8 @@ public:
 
     std::size_t processor_id() const override;
     void invalidate_jit_cache(Address start, size_t length) override;
+    void translate_blocks(const JitBlockEntries &entries) override;
+    void request_sample() override;
+    void clear_exclusive() override;
+    void set_optimizations(uint32_t optimizations) override;
 };
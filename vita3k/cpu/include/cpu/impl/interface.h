@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cpu/common.h>
+#include <cpu/jit_cache.h>
 
 #include <cstdint>
 
@@ -32,6 +33,11 @@ struct CPUInterface {
     virtual void set_reg(uint8_t idx, uint32_t val) = 0;
 
     virtual uint32_t get_sp() = 0;
+
+    // r0-r3 and sp, with a single virtual call
+    virtual ArgRegs get_arg_regs() {
+        return { { get_reg(0), get_reg(1), get_reg(2), get_reg(3) }, get_sp() };
+    }
     virtual void set_sp(uint32_t val) = 0;
 
     virtual uint32_t get_pc() = 0;
@@ -55,6 +61,10 @@ struct CPUInterface {
     virtual CPUContext save_context() = 0;
     virtual void load_context(const CPUContext &ctx) = 0;
     virtual void invalidate_jit_cache(Address start, size_t length) = 0;
+    virtual void translate_blocks(const JitBlockEntries &entries) = 0;
+    virtual void request_sample() = 0;
+    virtual void clear_exclusive() = 0;
+    virtual void set_optimizations(uint32_t optimizations) = 0;
 
     virtual bool is_thumb_mode() = 0;
     virtual int step() = 0;
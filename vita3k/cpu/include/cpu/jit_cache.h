@@ -0,0 +1,75 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h> // Address.
+#include <util/containers.h>
+#include <util/fs.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct MemState;
+
+// Location of a translated guest block, enough to make dynarmic translate it again
+struct JitBlockEntry {
+    Address pc;
+    uint32_t cpsr; // only the T, E and IT bits are meaningful
+    uint32_t fpscr; // only the mode bits are meaningful
+    uint32_t code_check; // checksum of the first guest instructions, used to detect stale entries
+};
+
+typedef std::vector<JitBlockEntry> JitBlockEntries;
+
+/**
+ * @brief Persistent profile of the blocks translated by the JIT
+ *
+ * Dynarmic cannot serialize its host code, so instead of storing the code itself we
+ * store the location of every block that was translated, grouped by guest thread name.
+ * On the next boot a thread with the same name translates these blocks ahead of time
+ * before running any guest code, which moves the translation cost out of gameplay.
+ */
+struct JitBlockCache {
+    bool enabled = false;
+
+    // returns true if some entries were loaded
+    bool load(const fs::path &path);
+    void save();
+
+    // called by the cpu backend each time a new block is translated
+    void record(const std::string &thread_name, const JitBlockEntry &entry);
+    // remove the entries starting in the given range, must be called when guest code is modified
+    void invalidate(Address start, size_t length);
+    // get the entries recorded for a thread with this name during the previous runs
+    JitBlockEntries get_entries(const std::string &thread_name);
+
+    static uint32_t compute_code_check(MemState &mem, Address pc);
+
+private:
+    static uint64_t get_key(const JitBlockEntry &entry) {
+        return (static_cast<uint64_t>(entry.cpsr) << 32) | entry.pc;
+    }
+
+    std::mutex mutex;
+    fs::path cache_path;
+    bool dirty = false;
+    std::map<std::string, unordered_map_fast<uint64_t, JitBlockEntry>> blocks;
+};
@@ -23,6 +23,10 @@
 #include <mem/state.h>
 #include <util/types.h>
 
+#include <string>
+
+struct JitBlockCache;
+
 struct CPUState {
     CPUState() = default;
 
@@ -35,6 +39,11 @@ struct CPUState {
     Address halt_instruction_pc; // thumb mode pc
 
     CPUInterfacePtr cpu;
+
+    // used to record the translated blocks, null if the block cache is disabled
+    JitBlockCache *block_cache = nullptr;
+    std::string block_cache_name;
+
     bool svc_called;
     uint32_t svc;
 };
@@ -38,7 +38,7 @@ SceUID get_thread_id(CPUState &state) {
     return state.thread_id;
 }
 
-CPUStatePtr init_cpu(bool cpu_opt, SceUID thread_id, std::size_t processor_id, MemState &mem, CPUProtocolBase *protocol) {
+CPUStatePtr init_cpu(uint32_t jit_optimizations, SceUID thread_id, std::size_t processor_id, MemState &mem, CPUProtocolBase *protocol) {
     CPUStatePtr state(new CPUState(), delete_cpu_state);
     state->mem = &mem;
     state->protocol = protocol;
@@ -56,8 +56,8 @@ CPUStatePtr init_cpu(bool cpu_opt, SceUID thread_id, std::size_t processor_id, M
         return CPUStatePtr();
     }
 
-    Dynarmic::ExclusiveMonitor *monitor = static_cast<Dynarmic::ExclusiveMonitor *>(protocol->get_exclusive_monitor());
-    state->cpu = std::make_unique<DynarmicCPU>(state.get(), processor_id, monitor, cpu_opt);
+    DynarmicExclusiveMonitor *monitor = static_cast<DynarmicExclusiveMonitor *>(protocol->get_exclusive_monitor());
+    state->cpu = std::make_unique<DynarmicCPU>(state.get(), processor_id, monitor, jit_optimizations);
 
     return state;
 }
@@ -98,6 +98,10 @@ uint32_t read_sp(CPUState &state) {
     return state.cpu->get_sp();
 }
 
+ArgRegs read_arg_regs(CPUState &state) {
+    return state.cpu->get_arg_regs();
+}
+
 uint32_t read_pc(CPUState &state) {
     return state.cpu->get_pc();
 }
@@ -174,6 +178,37 @@ void invalidate_jit_cache(CPUState &state, Address start, size_t length) {
     state.cpu->invalidate_jit_cache(start, length);
 }
 
+void warm_up_jit(CPUState &state) {
+    if (!state.block_cache)
+        return;
+
+    const JitBlockEntries entries = state.block_cache->get_entries(state.block_cache_name);
+    if (entries.empty())
+        return;
+
+    state.cpu->translate_blocks(entries);
+}
+
+void request_sample(CPUState &state) {
+    state.cpu->request_sample();
+}
+
+void set_jit_optimizations(CPUState &state, uint32_t jit_optimizations) {
+    state.cpu->set_optimizations(jit_optimizations);
+}
+
+uint32_t get_jit_profile_optimizations(std::string_view name) {
+    for (const auto &profile : JIT_PROFILES) {
+        if (profile.name == name)
+            return profile.optimizations;
+    }
+    return JIT_PROFILES[0].optimizations;
+}
+
+void clear_exclusive(CPUState &state) {
+    state.cpu->clear_exclusive();
+}
+
 std::string disassemble(CPUState &state, uint64_t at, bool thumb, uint16_t *insn_size) {
     MemState &mem = *state.mem;
     const uint8_t *const code = Ptr<const uint8_t>(static_cast<Address>(at)).get(mem);
@@ -31,6 +31,10 @@
 #include <optional>
 #include <string>
 
+// UserDefined7 translates the blocks ahead of time and UserDefined8 is a svc call
+static constexpr Dynarmic::HaltReason OPTIMIZATIONS_HALT_REASON = Dynarmic::HaltReason::UserDefined5;
+static constexpr Dynarmic::HaltReason SAMPLE_HALT_REASON = Dynarmic::HaltReason::UserDefined6;
+
 class ArmDynarmicCP15 : public Dynarmic::A32::Coprocessor {
     uint32_t tpidruro;
 
@@ -125,6 +129,23 @@ public:
         if (cpu->log_code) {
             ir.CallHostFunction(&TraceInstruction, ir.Imm64((uint64_t)this), ir.Imm64(pc), ir.Imm64(is_thumb));
         }
+
+        if (parent->block_cache) {
+            // this hook is called for every instruction, only record the first one of each block
+            const Dynarmic::A32::LocationDescriptor location{ ir.block.Location() };
+            if (location.PC() == pc)
+                record_block(location);
+        }
+    }
+
+    void record_block(const Dynarmic::A32::LocationDescriptor &location) {
+        const uint8_t it = location.IT().Value();
+        JitBlockEntry entry;
+        entry.pc = location.PC();
+        entry.cpsr = (location.TFlag() ? 0x20 : 0) | (location.EFlag() ? 0x200 : 0) | ((it & 0b11) << 25) | ((it >> 2) << 10);
+        entry.fpscr = location.FPSCR().Value();
+        entry.code_check = JitBlockCache::compute_code_check(*parent->mem, entry.pc);
+        parent->block_cache->record(parent->block_cache_name, entry);
     }
 
     template <typename T>
@@ -214,7 +235,12 @@ public:
             return false;
         }
 
+        // only the stores of cores still holding their reservation reach this point
+        auto &counters = cpu->monitor->counters[cpu->core_id];
+        counters.stores.fetch_add(1, std::memory_order_relaxed);
         auto result = Ptr<T>(addr).atomic_compare_and_swap(*parent->mem, value, expected);
+        if (!result)
+            counters.failed_stores.fetch_add(1, std::memory_order_relaxed);
         if (cpu->log_mem) {
             LOG_TRACE("Write uint{}_t at addr: 0x{:x}, val = 0x{:x}, expected = 0x{:x}", sizeof(T) * 8, addr, value, expected);
         }
@@ -298,34 +324,55 @@ public:
     }
 };
 
+static Dynarmic::OptimizationFlag get_dynarmic_optimizations(uint32_t optimizations) {
+    if (optimizations == 0)
+        return Dynarmic::no_optimizations;
+
+    Dynarmic::OptimizationFlag flags = Dynarmic::all_safe_optimizations;
+    if (!(optimizations & JIT_OPT_BLOCK_LINKING))
+        flags = flags & ~Dynarmic::OptimizationFlag::BlockLinking;
+    if (!(optimizations & JIT_OPT_RETURN_STACK_BUFFER))
+        flags = flags & ~Dynarmic::OptimizationFlag::ReturnStackBuffer;
+    if (optimizations & JIT_OPT_UNSAFE_FP)
+        flags = flags | Dynarmic::OptimizationFlag::Unsafe_UnfuseFMA | Dynarmic::OptimizationFlag::Unsafe_ReducedErrorFP
+            | Dynarmic::OptimizationFlag::Unsafe_InaccurateNaN | Dynarmic::OptimizationFlag::Unsafe_IgnoreStandardFPCRValue;
+    if (optimizations & JIT_OPT_UNSAFE_IGNORE_GLOBAL_MONITOR)
+        flags = flags | Dynarmic::OptimizationFlag::Unsafe_IgnoreGlobalMonitor;
+    return flags;
+}
+
 std::unique_ptr<Dynarmic::A32::Jit> DynarmicCPU::make_jit() {
     Dynarmic::A32::UserConfig config{};
     config.arch_version = Dynarmic::A32::ArchVersion::v7;
     config.callbacks = cb.get();
+    const bool fastmem = !log_mem && (optimizations & JIT_OPT_FASTMEM);
     if (parent->mem->use_page_table) {
-        config.page_table = (log_mem || !cpu_opt) ? nullptr : reinterpret_cast<decltype(config.page_table)>(parent->mem->page_table.get());
+        config.page_table = fastmem ? reinterpret_cast<decltype(config.page_table)>(parent->mem->page_table.get()) : nullptr;
         config.absolute_offset_page_table = true;
-    } else if (!log_mem && cpu_opt) {
+    } else if (fastmem) {
         config.fastmem_pointer = std::bit_cast<uintptr_t>(parent->mem->memory.get());
     }
     config.hook_hint_instructions = true;
     config.enable_cycle_counting = false;
-    config.global_monitor = monitor;
+    config.global_monitor = &monitor->monitor;
     config.coprocessors[15] = cp15;
     config.processor_id = core_id;
-    config.optimizations = cpu_opt ? Dynarmic::all_safe_optimizations : Dynarmic::no_optimizations;
+    config.optimizations = get_dynarmic_optimizations(optimizations);
+    // the unsafe optimizations are ignored otherwise
+    config.unsafe_optimizations = true;
     config.enable_cycle_counting = false;
 
     return std::make_unique<Dynarmic::A32::Jit>(config);
 }
 
-DynarmicCPU::DynarmicCPU(CPUState *state, std::size_t processor_id, Dynarmic::ExclusiveMonitor *monitor, bool cpu_opt)
+DynarmicCPU::DynarmicCPU(CPUState *state, std::size_t processor_id, DynarmicExclusiveMonitor *monitor, uint32_t optimizations)
     : parent(state)
     , cb(std::make_unique<ArmDynarmicCallback>(*state, *this))
     , cp15(std::make_shared<ArmDynarmicCP15>())
     , monitor(monitor)
     , core_id(processor_id)
-    , cpu_opt(cpu_opt) {
+    , optimizations(optimizations)
+    , requested_optimizations(optimizations) {
     jit = make_jit();
 }
 
@@ -338,7 +385,19 @@ int DynarmicCPU::run() {
     Dynarmic::HaltReason halt_reason;
     do {
         halt_reason = jit->Run();
-    } while ((halt_reason == Dynarmic::HaltReason::Step) || (halt_reason == Dynarmic::HaltReason::CacheInvalidation));
+        if (Dynarmic::Has(halt_reason, SAMPLE_HALT_REASON)) {
+            parent->protocol->record_sample(*parent, get_pc(), get_lr());
+            halt_reason = halt_reason & ~SAMPLE_HALT_REASON;
+        }
+        if (Dynarmic::Has(halt_reason, OPTIMIZATIONS_HALT_REASON)) {
+            // the jit can only be replaced by its own thread, outside of Run
+            const CPUContext ctx = save_context();
+            optimizations = requested_optimizations.load();
+            jit = make_jit();
+            load_context(ctx);
+            halt_reason = halt_reason & ~OPTIMIZATIONS_HALT_REASON;
+        }
+    } while ((halt_reason == Dynarmic::HaltReason{}) || (halt_reason == Dynarmic::HaltReason::Step) || (halt_reason == Dynarmic::HaltReason::CacheInvalidation));
 
     return halted;
 }
@@ -394,6 +453,11 @@ uint32_t DynarmicCPU::get_sp() {
     return jit->Regs()[13];
 }
 
+ArgRegs DynarmicCPU::get_arg_regs() {
+    const auto &regs = jit->Regs();
+    return { { regs[0], regs[1], regs[2], regs[3] }, regs[13] };
+}
+
 uint32_t DynarmicCPU::get_pc() {
     return jit->Regs()[15];
 }
@@ -488,17 +552,66 @@ void DynarmicCPU::invalidate_jit_cache(Address start, size_t length) {
     jit->InvalidateCacheRange(start, length);
 }
 
+void DynarmicCPU::translate_blocks(const JitBlockEntries &entries) {
+    const CPUContext ctx = save_context();
+
+    size_t nb_translated = 0;
+    for (const auto &entry : entries) {
+        // skip the blocks whose guest code changed since they were recorded
+        if (JitBlockCache::compute_code_check(*parent->mem, entry.pc) != entry.code_check)
+            continue;
+
+        jit->Regs()[15] = entry.pc;
+        jit->SetCpsr(entry.cpsr);
+        jit->SetFpscr(entry.fpscr);
+        // the halt request is checked after the block lookup but before executing it
+        // so this only translates the block
+        jit->HaltExecution(Dynarmic::HaltReason::UserDefined7);
+        jit->Run();
+        nb_translated++;
+    }
+
+    load_context(ctx);
+    LOG_DEBUG("Thread {} translated {}/{} blocks ahead of time", parent->thread_id, nb_translated, entries.size());
+}
+
+void DynarmicCPU::request_sample() {
+    // the halt is only checked between blocks, where the registers are up to date
+    jit->HaltExecution(SAMPLE_HALT_REASON);
+}
+
+void DynarmicCPU::set_optimizations(uint32_t optimizations) {
+    if (requested_optimizations.exchange(optimizations) != optimizations)
+        jit->HaltExecution(OPTIMIZATIONS_HALT_REASON);
+}
+
+void DynarmicCPU::clear_exclusive() {
+    // the store exclusives check the state of the jit before the monitor, clearing it is enough
+    // to make the next one fail and does not take the lock of the monitor
+    jit->ClearExclusiveState();
+}
+
 // TODO: proper abstraction
 ExclusiveMonitorPtr new_exclusive_monitor(int max_num_cores) {
-    return new Dynarmic::ExclusiveMonitor(max_num_cores);
+    return new DynarmicExclusiveMonitor(max_num_cores);
 }
 
 void free_exclusive_monitor(ExclusiveMonitorPtr monitor) {
-    Dynarmic::ExclusiveMonitor *monitor_ = static_cast<Dynarmic::ExclusiveMonitor *>(monitor);
+    DynarmicExclusiveMonitor *monitor_ = static_cast<DynarmicExclusiveMonitor *>(monitor);
     delete monitor_;
 }
 
 void clear_exclusive(ExclusiveMonitorPtr monitor, std::size_t core_num) {
-    Dynarmic::ExclusiveMonitor *monitor_ = static_cast<Dynarmic::ExclusiveMonitor *>(monitor);
-    monitor_->ClearProcessor(core_num);
+    DynarmicExclusiveMonitor *monitor_ = static_cast<DynarmicExclusiveMonitor *>(monitor);
+    monitor_->monitor.ClearProcessor(core_num);
+}
+
+ExclusiveStats get_exclusive_stats(ExclusiveMonitorPtr monitor) {
+    const DynarmicExclusiveMonitor *monitor_ = static_cast<const DynarmicExclusiveMonitor *>(monitor);
+    ExclusiveStats stats;
+    for (const auto &counters : monitor_->counters) {
+        stats.stores += counters.stores.load(std::memory_order_relaxed);
+        stats.failed_stores += counters.failed_stores.load(std::memory_order_relaxed);
+    }
+    return stats;
 }
@@ -0,0 +1,157 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <cpu/jit_cache.h>
+
+#include <mem/ptr.h>
+#include <util/log.h>
+
+// Increase this value when the file layout changes
+static constexpr uint32_t JIT_CACHE_VERSION = 1;
+static constexpr uint32_t JIT_CACHE_MAGIC = 0x4B33544A; // "JT3K"
+
+// Number of bytes of guest code used to validate an entry
+static constexpr uint32_t CODE_CHECK_SIZE = 16;
+
+bool JitBlockCache::load(const fs::path &path) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    cache_path = path;
+    blocks.clear();
+    dirty = false;
+
+    fs::ifstream file(cache_path, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t nb_threads = 0;
+    file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    file.read(reinterpret_cast<char *>(&nb_threads), sizeof(nb_threads));
+    if (!file || magic != JIT_CACHE_MAGIC || version != JIT_CACHE_VERSION) {
+        LOG_WARN("JIT block cache {} is outdated, discarding it", cache_path);
+        return false;
+    }
+
+    size_t nb_entries_total = 0;
+    for (uint32_t i = 0; i < nb_threads; i++) {
+        uint32_t name_size = 0;
+        file.read(reinterpret_cast<char *>(&name_size), sizeof(name_size));
+        std::string name(name_size, '\0');
+        file.read(name.data(), name_size);
+
+        uint32_t nb_entries = 0;
+        file.read(reinterpret_cast<char *>(&nb_entries), sizeof(nb_entries));
+        if (!file)
+            break;
+
+        JitBlockEntries entries(nb_entries);
+        file.read(reinterpret_cast<char *>(entries.data()), nb_entries * sizeof(JitBlockEntry));
+        if (!file)
+            break;
+
+        auto &thread_blocks = blocks[name];
+        for (const auto &entry : entries)
+            thread_blocks[get_key(entry)] = entry;
+        nb_entries_total += nb_entries;
+    }
+
+    LOG_INFO("Loaded {} JIT block entries for {} threads", nb_entries_total, blocks.size());
+    return nb_entries_total > 0;
+}
+
+void JitBlockCache::save() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (!enabled || !dirty || cache_path.empty())
+        return;
+
+    fs::create_directories(cache_path.parent_path());
+    fs::ofstream file(cache_path, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open JIT block cache {} for writing", cache_path);
+        return;
+    }
+
+    const uint32_t nb_threads = static_cast<uint32_t>(blocks.size());
+    file.write(reinterpret_cast<const char *>(&JIT_CACHE_MAGIC), sizeof(JIT_CACHE_MAGIC));
+    file.write(reinterpret_cast<const char *>(&JIT_CACHE_VERSION), sizeof(JIT_CACHE_VERSION));
+    file.write(reinterpret_cast<const char *>(&nb_threads), sizeof(nb_threads));
+    for (const auto &[name, thread_blocks] : blocks) {
+        const uint32_t name_size = static_cast<uint32_t>(name.size());
+        file.write(reinterpret_cast<const char *>(&name_size), sizeof(name_size));
+        file.write(name.data(), name_size);
+
+        const uint32_t nb_entries = static_cast<uint32_t>(thread_blocks.size());
+        file.write(reinterpret_cast<const char *>(&nb_entries), sizeof(nb_entries));
+        for (const auto &[_, entry] : thread_blocks)
+            file.write(reinterpret_cast<const char *>(&entry), sizeof(JitBlockEntry));
+    }
+
+    dirty = false;
+}
+
+void JitBlockCache::record(const std::string &thread_name, const JitBlockEntry &entry) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    auto &thread_blocks = blocks[thread_name];
+    auto [it, inserted] = thread_blocks.try_emplace(get_key(entry), entry);
+    if (!inserted) {
+        if (it->second.code_check == entry.code_check)
+            return;
+        it->second = entry;
+    }
+    dirty = true;
+}
+
+void JitBlockCache::invalidate(Address start, size_t length) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    const Address end = start + static_cast<Address>(length);
+    for (auto &[_, thread_blocks] : blocks) {
+        const size_t nb_erased = boost::unordered::erase_if(thread_blocks, [&](const auto &item) {
+            return item.second.pc >= start && item.second.pc < end;
+        });
+        dirty |= nb_erased > 0;
+    }
+}
+
+JitBlockEntries JitBlockCache::get_entries(const std::string &thread_name) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    JitBlockEntries entries;
+    const auto it = blocks.find(thread_name);
+    if (it == blocks.end())
+        return entries;
+
+    entries.reserve(it->second.size());
+    for (const auto &[_, entry] : it->second)
+        entries.push_back(entry);
+    return entries;
+}
+
+uint32_t JitBlockCache::compute_code_check(MemState &mem, Address pc) {
+    const Ptr<uint8_t> code(pc);
+    if (!code.valid(mem) || !Ptr<uint8_t>(pc + CODE_CHECK_SIZE - 1).valid(mem))
+        return 0;
+
+    // FNV-1a, we only need to detect that the code at this address changed
+    const uint8_t *data = code.get(mem);
+    uint32_t hash = 0x811C9DC5;
+    for (uint32_t i = 0; i < CODE_CHECK_SIZE; i++) {
+        hash ^= data[i];
+        hash *= 0x01000193;
+    }
+    return hash;
+}
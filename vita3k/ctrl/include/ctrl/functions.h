@@ -19,6 +19,7 @@
 
 #include <ctrl/state.h>
 #include <emuenv/state.h>
+#include <util/fs.h>
 
 #include <array>
 
@@ -26,3 +27,6 @@ std::array<ControllerBinding, 15> get_controller_bindings_ext(EmuEnvState &emuen
 SceCtrlExternalInputMode get_type_of_controller(const int idx);
 int ctrl_get(const SceUID thread_id, EmuEnvState &emuenv, int port, SceCtrlData2 *pData, SceUInt32 count, bool negative, bool is_peek, bool is_v2, bool from_ext);
 void refresh_controllers(CtrlState &state, EmuEnvState &emuenv);
+// called by the vblank thread at each vblank, records the input returned later by the read buffer functions
+void sample_ctrl(EmuEnvState &emuenv);
+bool load_input_script(CtrlState &state, const fs::path &path);
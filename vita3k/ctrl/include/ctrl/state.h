@@ -22,10 +22,12 @@
 #include <SDL3/SDL_gamepad.h>
 #include <SDL3/SDL_haptic.h>
 
+#include <array>
 #include <cstring>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 typedef std::shared_ptr<SDL_Gamepad> GamepadPtr;
 typedef std::shared_ptr<SDL_Haptic> HapticPtr;
@@ -52,6 +54,25 @@ struct SDL_GUIDComparator {
 
 typedef std::map<SDL_GUID, Controller, SDL_GUIDComparator> ControllerList;
 
+// input of the first controller from this vblank until the next entry of the input script
+struct ScriptedInput {
+    uint64_t vblank;
+    uint32_t buttons;
+    std::array<uint8_t, 4> axes; // lx, ly, rx, ry
+};
+
+// input of a port, in the two button layouts since the app chooses one when reading it
+struct CtrlSample {
+    uint64_t vblank = 0;
+    uint64_t timestamp = 0;
+    uint32_t buttons = 0;
+    uint32_t buttons_ext = 0;
+    std::array<float, 4> axes{}; // lx, ly, rx, ry
+};
+
+// one sample is taken at each vblank, like the hardware does, for the read buffer functions
+constexpr size_t CTRL_SAMPLE_BUFFER_SIZE = 64;
+
 struct CtrlState {
     std::mutex mutex;
     ControllerList controllers;
@@ -64,4 +85,9 @@ struct CtrlState {
 
     // last vsync the data was read
     uint64_t last_vcount[5] = {}; // sceCtrl ports.
+    // samples of the last vblanks for each 1-based port, indexed by vblank
+    std::array<std::array<CtrlSample, CTRL_SAMPLE_BUFFER_SIZE>, 5> samples{};
+
+    // replayed along the real input of port 1 when not empty, sorted by vblank
+    std::vector<ScriptedInput> input_script;
 };
@@ -28,6 +28,10 @@
 
 #include <SDL3/SDL_keyboard.h>
 
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
 #ifdef ANDROID
 #include <SDL3/SDL_joystick.h>
 #include <jni.h>
@@ -327,59 +331,92 @@ static void apply_controller(EmuEnvState &emuenv, uint32_t *buttons, float axes[
     axes[3] += axis_to_axis(SDL_GetGamepadAxis(controller, SDL_GAMEPAD_AXIS_RIGHTY), analog_multiplier);
 }
 
-static void retrieve_ctrl_data(EmuEnvState &emuenv, int port, bool is_v2, bool negative, bool from_ext_function, SceUInt32 &buttons, SceUInt8 &lx, SceUInt8 &ly, SceUInt8 &rx, SceUInt8 &ry) {
-    std::lock_guard<std::mutex> guard(emuenv.ctrl.mutex);
-
-    if (port == 0) {
-        port++;
-    }
-    CtrlState &state = emuenv.ctrl;
-
-    std::array<float, 4> axes{};
-    axes.fill(0);
-
-    const auto reset_axes = [&]() {
-        // Re-center joysticks to (128,128). Range is (0-255,0-255).
-        SceCtrlPadInputMode mode = from_ext_function ? state.input_mode_ext : state.input_mode;
-        if (mode == SCE_CTRL_MODE_DIGITAL) {
-            lx = 0x80;
-            ly = 0x80;
-            rx = 0x80;
-            ry = 0x80;
-        } else {
-            lx = float_to_byte(axes[0]);
-            ly = float_to_byte(axes[1]);
-            rx = float_to_byte(axes[2]);
-            ry = float_to_byte(axes[3]);
-        }
-        if (negative)
-            buttons ^= ~0;
-    };
-
-    if ((emuenv.common_dialog.status == SCE_COMMON_DIALOG_STATUS_RUNNING) || emuenv.drop_inputs) {
-        reset_axes();
+static void apply_input_script(EmuEnvState &emuenv, uint32_t *buttons, float axes[4]) {
+    const auto &script = emuenv.ctrl.input_script;
+    const uint64_t vblank = emuenv.display.vblank_count.load();
+    // the entry in effect is the last one which started at or before this vblank
+    const auto next = std::upper_bound(script.begin(), script.end(), vblank, [](uint64_t vblank, const ScriptedInput &input) { return vblank < input.vblank; });
+    if (next == script.begin())
         return;
+
+    const ScriptedInput &input = *std::prev(next);
+    *buttons |= input.buttons;
+    for (int i = 0; i < 4; i++) {
+        // centered sticks leave the real ones usable
+        if (input.axes[i] != 0x80)
+            axes[i] = input.axes[i] / 255.0f * 2.0f - 1.0f;
     }
+}
 
+// buttons and axes of the port, converted to the format asked by the app in sample_to_data
+static void read_input(EmuEnvState &emuenv, int port, bool is_v2, uint32_t &buttons, float axes[4]) {
     if (emuenv.cfg.current_config.pstv_mode) {
         if (port == 1) {
-            apply_keyboard(&buttons, axes.data(), is_v2, emuenv);
+            apply_keyboard(&buttons, axes, is_v2, emuenv);
+            apply_input_script(emuenv, &buttons, axes);
         }
-        for (const auto &[_, controller] : state.controllers) {
+        for (const auto &[_, controller] : emuenv.ctrl.controllers) {
             if (controller.port + 1 == port) {
                 // sceCtrl ports are 1-based and SDL_GameController index is 0-based. Need to convert.
-                apply_controller(emuenv, &buttons, axes.data(), controller.controller.get(), is_v2);
+                apply_controller(emuenv, &buttons, axes, controller.controller.get(), is_v2);
             }
         }
     } else if (port == 1) {
         // If not in PSTV mode, every controller input is considered as a port 1 input
-        apply_keyboard(&buttons, axes.data(), is_v2, emuenv);
-        for (const auto &[_, controller] : state.controllers) {
-            apply_controller(emuenv, &buttons, axes.data(), controller.controller.get(), is_v2);
+        apply_keyboard(&buttons, axes, is_v2, emuenv);
+        apply_input_script(emuenv, &buttons, axes);
+        for (const auto &[_, controller] : emuenv.ctrl.controllers) {
+            apply_controller(emuenv, &buttons, axes, controller.controller.get(), is_v2);
         }
     }
+}
+
+// ctrl.mutex must be held, port is 1-based
+static CtrlSample read_sample(EmuEnvState &emuenv, int port) {
+    CtrlSample sample;
+    sample.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if ((emuenv.common_dialog.status == SCE_COMMON_DIALOG_STATUS_RUNNING) || emuenv.drop_inputs)
+        return sample;
 
-    reset_axes();
+    // the axes do not depend on the buttons asked
+    std::array<float, 4> axes{};
+    read_input(emuenv, port, false, sample.buttons, axes.data());
+    read_input(emuenv, port, true, sample.buttons_ext, sample.axes.data());
+    return sample;
+}
+
+static void sample_to_data(const CtrlState &state, const CtrlSample &sample, bool is_v2, bool negative, bool from_ext_function, SceCtrlData2 &data) {
+    data.timeStamp = sample.timestamp;
+    data.buttons = is_v2 ? sample.buttons_ext : sample.buttons;
+
+    // Re-center joysticks to (128,128). Range is (0-255,0-255).
+    const SceCtrlPadInputMode mode = from_ext_function ? state.input_mode_ext : state.input_mode;
+    if (mode == SCE_CTRL_MODE_DIGITAL) {
+        data.lx = 0x80;
+        data.ly = 0x80;
+        data.rx = 0x80;
+        data.ry = 0x80;
+    } else {
+        data.lx = float_to_byte(sample.axes[0]);
+        data.ly = float_to_byte(sample.axes[1]);
+        data.rx = float_to_byte(sample.axes[2]);
+        data.ry = float_to_byte(sample.axes[3]);
+    }
+    if (negative)
+        data.buttons ^= ~0;
+}
+
+void sample_ctrl(EmuEnvState &emuenv) {
+    CtrlState &state = emuenv.ctrl;
+    const uint64_t vblank = emuenv.display.vblank_count.load();
+    const int nb_ports = emuenv.cfg.current_config.pstv_mode ? SCE_CTRL_MAX_WIRELESS_NUM : 1;
+
+    const std::lock_guard<std::mutex> guard(state.mutex);
+    for (int port = 1; port <= nb_ports; port++) {
+        CtrlSample &sample = state.samples[port][vblank % CTRL_SAMPLE_BUFFER_SIZE];
+        sample = read_sample(emuenv, port);
+        sample.vblank = vblank;
+    }
 }
 
 int ctrl_get(const SceUID thread_id, EmuEnvState &emuenv, int port, SceCtrlData2 *pData, SceUInt32 count, bool negative, bool is_peek, bool is_v2, bool from_ext) {
@@ -393,31 +430,83 @@ int ctrl_get(const SceUID thread_id, EmuEnvState &emuenv, int port, SceCtrlData2
     CtrlState &state = emuenv.ctrl;
 
     int nb_returned_data = 1;
+    uint64_t vblank_count = emuenv.display.vblank_count.load();
     if (is_peek) {
         nb_returned_data = count;
     } else {
-        if (emuenv.display.vblank_count.load() <= state.last_vcount[port]) {
+        if (vblank_count <= state.last_vcount[port]) {
             // sceCtrlRead is blocking, wait for the next vsync for the buffer to be updated
             auto thread = emuenv.kernel.get_thread(thread_id);
 
             wait_vblank(emuenv.display, emuenv.kernel, thread, state.last_vcount[port] + 1, false);
+            vblank_count = emuenv.display.vblank_count.load();
         }
-        uint64_t vblank_count = emuenv.display.vblank_count.load();
         nb_returned_data = std::min<int32_t>(count, vblank_count - state.last_vcount[port]);
         state.last_vcount[port] = vblank_count;
     }
 
-    std::chrono::time_point<std::chrono::steady_clock> ts = std::chrono::steady_clock::now();
-    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(ts.time_since_epoch()).count();
-    pData->timeStamp = timestamp;
-    retrieve_ctrl_data(emuenv, port, is_v2, negative, from_ext, pData->buttons, pData->lx, pData->ly, pData->rx, pData->ry);
-
+    const int sample_port = std::max(port, 1);
+    const std::lock_guard<std::mutex> guard(state.mutex);
+    // the newest data is read now, the older ones are the samples taken at the previous vblanks
+    sample_to_data(state, read_sample(emuenv, sample_port), is_v2, negative, from_ext, pData[0]);
     for (int i = 1; i < nb_returned_data; i++) {
-        memcpy(&pData[i], &pData[0], sizeof(SceCtrlData2));
+        const uint64_t vblank = vblank_count - i;
+        const CtrlSample &sample = state.samples[sample_port][vblank % CTRL_SAMPLE_BUFFER_SIZE];
+        if (vblank_count >= static_cast<uint64_t>(i) && sample.vblank == vblank && sample.timestamp != 0) {
+            sample_to_data(state, sample, is_v2, negative, from_ext, pData[i]);
+        } else {
+            memcpy(&pData[i], &pData[0], sizeof(SceCtrlData2));
 
-        // update the timestamp, 1 vsync = 1/60 sec = 16 667 us earlier
-        pData[i].timeStamp -= i * 16667ULL;
+            // update the timestamp, 1 vsync = 1/60 sec = 16 667 us earlier
+            pData[i].timeStamp -= i * 16667ULL;
+        }
     }
 
     return nb_returned_data;
 }
+
+bool load_input_script(CtrlState &state, const fs::path &path) {
+    fs::ifstream file(path);
+    if (!file) {
+        LOG_ERROR("Cannot open the input script {}", path);
+        return false;
+    }
+
+    std::vector<ScriptedInput> script;
+    std::string line;
+    for (uint32_t line_number = 1; std::getline(file, line); line_number++) {
+        const auto comment = line.find('#');
+        if (comment != std::string::npos)
+            line.resize(comment);
+
+        std::istringstream fields(line);
+        std::string vblank, buttons;
+        if (!(fields >> vblank))
+            continue;
+
+        ScriptedInput input{ 0, 0, { 0x80, 0x80, 0x80, 0x80 } };
+        try {
+            fields >> buttons;
+            input.vblank = std::stoull(vblank);
+            // base 0 so that the buttons can be written in hexadecimal
+            input.buttons = static_cast<uint32_t>(std::stoul(buttons, nullptr, 0));
+            for (auto &axis : input.axes) {
+                uint32_t value;
+                if (!(fields >> value))
+                    break;
+                axis = static_cast<uint8_t>(std::min<uint32_t>(value, 0xFF));
+            }
+        } catch (const std::exception &) {
+            LOG_ERROR("Invalid line {} in the input script {}: {}", line_number, path, line);
+            return false;
+        }
+        script.push_back(input);
+    }
+
+    std::stable_sort(script.begin(), script.end(), [](const ScriptedInput &a, const ScriptedInput &b) { return a.vblank < b.vblank; });
+
+    const std::lock_guard<std::mutex> guard(state.mutex);
+    state.input_script = std::move(script);
+    LOG_INFO("Replaying {} input changes from {}", state.input_script.size(), path);
+    return true;
+}
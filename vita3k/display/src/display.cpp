@@ -17,16 +17,25 @@
 
 #include <display/functions.h>
 
+#include <ctrl/functions.h>
 #include <dialog/state.h>
 #include <display/state.h>
 #include <emuenv/state.h>
 #include <kernel/state.h>
+#include <mem/functions.h>
 #include <renderer/state.h>
+#include <rtc/rtc.h>
+#include <util/profile.h>
 
+#include <algorithm>
 #include <chrono>
 #include <motion/functions.h>
 #include <touch/functions.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 // Code heavily influenced by PPSSSPP's SceDisplay.cpp
 
 static constexpr int TARGET_FPS = 60;
@@ -35,8 +44,55 @@ static constexpr int64_t TARGET_MICRO_PER_FRAME = 1000000LL / TARGET_FPS;
 static constexpr int predict_threshold = 3;
 static constexpr int max_expected_swapchain_size = 6;
 
+using VblankClock = std::chrono::steady_clock;
+
+// Waits until the deadline, the sleep of the host can otherwise be late by a whole scheduler tick
+class VblankTimer {
+public:
+    VblankTimer() {
+#ifdef _WIN32
+        // high resolution timers are available since Windows 10 1803, the default ones have a 15.6 ms resolution
+        timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+    }
+
+    ~VblankTimer() {
+#ifdef _WIN32
+        if (timer)
+            CloseHandle(timer);
+#endif
+    }
+
+    VblankTimer(const VblankTimer &) = delete;
+    VblankTimer &operator=(const VblankTimer &) = delete;
+
+    void wait_until(VblankClock::time_point deadline) {
+#ifdef _WIN32
+        const auto time_left = deadline - VblankClock::now();
+        if (timer && time_left > VblankClock::duration::zero()) {
+            // relative due time, in 100 ns units
+            LARGE_INTEGER due_time;
+            due_time.QuadPart = -std::max<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(time_left).count() / 100, 1);
+            if (SetWaitableTimerEx(timer, &due_time, 0, nullptr, nullptr, nullptr, 0)) {
+                WaitForSingleObject(timer, INFINITE);
+                return;
+            }
+        }
+#endif
+        std::this_thread::sleep_until(deadline);
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE timer = nullptr;
+#endif
+};
+
 static void vblank_sync_thread(EmuEnvState &emuenv) {
+    PROFILE_THREAD_NAME("Vblank");
     DisplayState &display = emuenv.display;
+    VblankTimer timer;
+    auto next_vblank = VblankClock::now();
 
     while (!display.abort.load()) {
         {
@@ -57,6 +113,7 @@ static void vblank_sync_thread(EmuEnvState &emuenv) {
 
             // maybe we should also use a mutex for this part, but it shouldn't be an issue
             touch_vsync_update(emuenv);
+            sample_ctrl(emuenv);
             refresh_motion(emuenv.motion, emuenv.ctrl);
 
             // Notify Vblank callback in each VBLANK start
@@ -75,9 +132,20 @@ static void vblank_sync_thread(EmuEnvState &emuenv) {
                 }
             }
         }
-        const auto time_ms = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-        const auto time_left = TARGET_MICRO_PER_FRAME - (time_ms % TARGET_MICRO_PER_FRAME);
-        std::this_thread::sleep_for(std::chrono::microseconds(time_left));
+
+        // once per frame is enough, a write not collected yet is still seen by was_written_since
+        collect_written_pages(emuenv.mem);
+        advise_cold_pages(emuenv.mem);
+
+        // the vblanks follow a fixed schedule, so that the time spent above and the late wakeups do not add up
+        // they follow the guest clock, which is faster in fast forward
+        const auto frame_duration = std::chrono::microseconds(static_cast<int64_t>(TARGET_MICRO_PER_FRAME / rtc_get_speed()));
+        next_vblank += frame_duration;
+        const auto now = VblankClock::now();
+        if (now >= next_vblank + frame_duration)
+            // more than a frame late (the host was suspended or very busy), restart the schedule instead of catching up
+            next_vblank = now + frame_duration;
+        timer.wait_until(next_vblank);
     }
 }
 
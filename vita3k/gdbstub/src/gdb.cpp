@@ -51,7 +51,11 @@
 
 // Credit to jfhs for their GDB stub for RPCS3 which this stub is based on.
 
-typedef char PacketData[4096];
+// Largest packet the client may send, advertised in qSupported. The receive buffer
+// holds two of them so that a packet which arrives in several parts fits.
+constexpr int64_t GDB_PACKET_SIZE = 0x4000;
+
+typedef char PacketData[GDB_PACKET_SIZE * 2];
 
 struct PacketCommand {
     char *data{};
@@ -100,6 +104,27 @@ static uint32_t parse_hex(const std::string &hex) {
     return static_cast<uint32_t>(std::strtoul(hex.c_str(), nullptr, 16));
 }
 
+static void append_hex(std::string &str, const uint8_t *data, size_t size) {
+    static constexpr char digits[] = "0123456789abcdef";
+    for (size_t a = 0; a < size; a++) {
+        str += digits[data[a] >> 4];
+        str += digits[data[a] & 0xf];
+    }
+}
+
+static uint8_t parse_hex_byte(const char *hex) {
+    const auto nibble = [](char c) -> uint8_t {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return 0;
+    };
+    return (nibble(hex[0]) << 4) | nibble(hex[1]);
+}
+
 static uint8_t make_checksum(const char *data, int64_t length) {
     size_t sum = 0;
 
@@ -176,14 +201,36 @@ static PacketCommand parse_command(char *data, int64_t length) {
     return command;
 }
 
-static int64_t server_reply(GDBState &state, const char *data, int64_t length) {
-    uint8_t checksum = make_checksum(data, length);
-    std::string packet_data = fmt::format("${}#{:0>2x}", std::string(data, length), checksum);
-    return send(state.client_socket, &packet_data[0], packet_data.size(), 0);
+// Replaces each run of 4 to 98 identical bytes by the byte, '*' and the repeat count + 29.
+// The counts which would give '#' or '$' are not allowed, those runs are shortened to 6 bytes.
+static std::string run_length_encode(const std::string &data) {
+    std::string encoded;
+    encoded.reserve(data.size());
+    for (size_t a = 0; a < data.size();) {
+        const char c = data[a];
+        size_t run = 1;
+        while ((a + run < data.size()) && (data[a + run] == c) && (run < 98))
+            run++;
+        if (run == 7 || run == 8)
+            run = 6;
+
+        if (run >= 4) {
+            encoded += c;
+            encoded += '*';
+            encoded += static_cast<char>(run - 1 + 29);
+        } else {
+            encoded.append(run, c);
+        }
+        a += run;
+    }
+    return encoded;
 }
 
-static int64_t server_reply(GDBState &state, const char *text) {
-    return server_reply(state, text, strlen(text));
+static int64_t server_reply(GDBState &state, const std::string &data) {
+    const std::string encoded = run_length_encode(data);
+    const uint8_t checksum = make_checksum(encoded.data(), encoded.size());
+    const std::string packet_data = fmt::format("${}#{:0>2x}", encoded, checksum);
+    return send(state.client_socket, packet_data.data(), packet_data.size(), 0);
 }
 
 static int64_t server_ack(GDBState &state, char ack = '+') {
@@ -197,9 +244,11 @@ static std::string cmd_supported(EmuEnvState &state, PacketCommand &command) {
     // or without xml parsing Thumb detection. If arm-vita-eabi-gdb gets
     // updated to support xml parsing in the future we can advertise
     // "qXfer:features:read+".
-    return "multiprocess-;swbreak+;hwbreak-;qRelocInsn-;fork-events-;vfork-events-;"
-           "exec-events-;vContSupported+;QThreadEvents-;no-resumed-;"
-           "qXfer:libraries:read+";
+    return fmt::format("multiprocess-;swbreak+;hwbreak-;qRelocInsn-;fork-events-;vfork-events-;"
+                       "exec-events-;vContSupported+;QThreadEvents-;no-resumed-;"
+                       "qXfer:libraries:read+;qXfer:memory-map:read+;qXfer:threads:read+;binary-upload+;"
+                       "PacketSize={:x}",
+        GDB_PACKET_SIZE);
 }
 
 // clang-format off
@@ -265,6 +314,35 @@ static constexpr const char TARGET_XML[] =
     "</target>";
 // clang-format on
 
+// Reply to a qXfer read of the given annex, params is the "offset,length" part of the packet
+static std::string xfer_chunk(const std::string &annex, const std::string &params) {
+    const size_t comma = params.find(',');
+    const uint32_t offset = parse_hex(params.substr(0, comma));
+    const uint32_t length = parse_hex(params.substr(comma + 1));
+
+    if (offset >= annex.size())
+        return "l";
+
+    const std::string chunk = annex.substr(offset, length);
+    const bool last = (offset + chunk.size()) >= annex.size();
+    return (last ? "l" : "m") + chunk;
+}
+
+static std::string escape_xml(const std::string &str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (const char c : str) {
+        switch (c) {
+        case '&': escaped += "&amp;"; break;
+        case '<': escaped += "&lt;"; break;
+        case '>': escaped += "&gt;"; break;
+        case '"': escaped += "&quot;"; break;
+        default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
 static std::string cmd_xfer_features(EmuEnvState &state, PacketCommand &command) {
     const std::string content = content_string(command);
     const std::string prefix = "qXfer:features:read:target.xml:";
@@ -273,18 +351,7 @@ static std::string cmd_xfer_features(EmuEnvState &state, PacketCommand &command)
 
     state.gdb.client_has_xml = true;
 
-    const std::string params = content.substr(prefix.size());
-    const size_t comma = params.find(',');
-    const uint32_t offset = parse_hex(params.substr(0, comma));
-    const uint32_t length = parse_hex(params.substr(comma + 1));
-
-    const std::string xml(TARGET_XML);
-    if (offset >= xml.size())
-        return "l";
-
-    const std::string chunk = xml.substr(offset, length);
-    const bool last = (offset + chunk.size()) >= xml.size();
-    return (last ? "l" : "m") + chunk;
+    return xfer_chunk(TARGET_XML, content.substr(prefix.size()));
 }
 
 static std::string cmd_xfer_libraries(EmuEnvState &state, PacketCommand &command) {
@@ -293,11 +360,6 @@ static std::string cmd_xfer_libraries(EmuEnvState &state, PacketCommand &command
     if (content.substr(0, prefix.size()) != prefix)
         return "E00";
 
-    const std::string params = content.substr(prefix.size());
-    const size_t comma = params.find(',');
-    const uint32_t offset = parse_hex(params.substr(0, comma));
-    const uint32_t length = parse_hex(params.substr(comma + 1));
-
     std::string xml = "<library-list>";
     {
         const auto guard = std::lock_guard(state.kernel.mutex);
@@ -309,12 +371,64 @@ static std::string cmd_xfer_libraries(EmuEnvState &state, PacketCommand &command
     }
     xml += "</library-list>";
 
-    if (offset >= xml.size())
-        return "l";
+    return xfer_chunk(xml, content.substr(prefix.size()));
+}
 
-    const std::string chunk = xml.substr(offset, length);
-    const bool last = (offset + chunk.size()) >= xml.size();
-    return (last ? "l" : "m") + chunk;
+static std::string cmd_xfer_memory_map(EmuEnvState &state, PacketCommand &command) {
+    const std::string content = content_string(command);
+    const std::string prefix = "qXfer:memory-map:read::";
+    if (content.substr(0, prefix.size()) != prefix)
+        return "E00";
+
+    // gdb does not access the memory outside of the map, so it lists all the allocated blocks,
+    // the adjacent ones being merged into a single region
+    std::string xml = "<memory-map>";
+    {
+        MemState &mem = state.mem;
+        const std::lock_guard<std::mutex> lock(mem.generation_mutex);
+        uint32_t region_start = 0;
+        uint32_t region_end = 0;
+        for (uint32_t page_num = 0; page_num < mem.allocator.max_offset;) {
+            const AllocMemPage &page = mem.alloc_table[page_num];
+            if (!page.allocated) {
+                page_num++;
+                continue;
+            }
+
+            if (page_num != region_end) {
+                if (region_end != region_start)
+                    xml += fmt::format("<memory type=\"ram\" start=\"{:#x}\" length=\"{:#x}\"/>",
+                        static_cast<uint64_t>(region_start) * mem.page_size, static_cast<uint64_t>(region_end - region_start) * mem.page_size);
+                region_start = page_num;
+            }
+            page_num += page.size;
+            region_end = page_num;
+        }
+        if (region_end != region_start)
+            xml += fmt::format("<memory type=\"ram\" start=\"{:#x}\" length=\"{:#x}\"/>",
+                static_cast<uint64_t>(region_start) * mem.page_size, static_cast<uint64_t>(region_end - region_start) * mem.page_size);
+    }
+    xml += "</memory-map>";
+
+    return xfer_chunk(xml, content.substr(prefix.size()));
+}
+
+static std::string cmd_xfer_threads(EmuEnvState &state, PacketCommand &command) {
+    const std::string content = content_string(command);
+    const std::string prefix = "qXfer:threads:read::";
+    if (content.substr(0, prefix.size()) != prefix)
+        return "E00";
+
+    // the whole list in one reply, instead of a qsThreadInfo round trip per thread
+    std::string xml = "<threads>";
+    {
+        const auto guard = std::lock_guard(state.kernel.mutex);
+        for (const auto &[id, thread] : state.kernel.threads)
+            xml += fmt::format("<thread id=\"{}\" name=\"{}\"/>", to_hex(id), escape_xml(thread->name));
+    }
+    xml += "</threads>";
+
+    return xfer_chunk(xml, content.substr(prefix.size()));
 }
 
 static std::string cmd_reply_empty(EmuEnvState &state, PacketCommand &command) {
@@ -546,19 +660,32 @@ static std::string cmd_write_register(EmuEnvState &state, PacketCommand &command
 }
 
 static bool check_memory_region(Address address, Address length, MemState &mem) {
-    if (!address) {
+    if (!address || (address + length < address)) {
         return false;
     }
 
-    Address it = address;
-    bool valid = true;
-    for (; it < address + length; it += mem.page_size) {
-        if (!is_valid_addr(mem, it)) {
-            valid = false;
-            break;
-        }
+    return is_valid_addr_range(mem, address, address + length);
+}
+
+// The memory is copied 4 KiB page by page, as the pages are not contiguous with the page table
+static void read_guest_memory(MemState &mem, Address address, uint32_t length, uint8_t *dst) {
+    while (length > 0) {
+        const uint32_t size = std::min<uint32_t>(length, KiB(4) - (address % KiB(4)));
+        std::memcpy(dst, Ptr<uint8_t>(address).get(mem), size);
+        address += size;
+        dst += size;
+        length -= size;
+    }
+}
+
+static void write_guest_memory(MemState &mem, Address address, uint32_t length, const uint8_t *src) {
+    while (length > 0) {
+        const uint32_t size = std::min<uint32_t>(length, KiB(4) - (address % KiB(4)));
+        std::memcpy(Ptr<uint8_t>(address).get(mem), src, size);
+        address += size;
+        src += size;
+        length -= size;
     }
-    return valid;
 }
 
 static std::string cmd_read_memory(EmuEnvState &state, PacketCommand &command) {
@@ -573,11 +700,41 @@ static std::string cmd_read_memory(EmuEnvState &state, PacketCommand &command) {
     if (!check_memory_region(address, length, state.mem))
         return "EAA";
 
+    std::vector<uint8_t> data(length);
+    read_guest_memory(state.mem, address, length, data.data());
+
     std::string str;
     str.reserve(length * 2);
+    append_hex(str, data.data(), data.size());
+
+    return str;
+}
+
+// Binary read (x packet): half the size of the hex reply of the m packet
+static std::string cmd_read_binary(EmuEnvState &state, PacketCommand &command) {
+    const std::string content = content_string(command);
+    const size_t pos = content.find(',');
 
-    for (uint32_t a = 0; a < length; a++) {
-        fmt::format_to(std::back_inserter(str), "{:02x}", *Ptr<uint8_t>(address + a).get(state.mem));
+    const uint32_t address = parse_hex(content.substr(1, pos - 1));
+    const uint32_t length = parse_hex(content.substr(pos + 1));
+
+    if (length == 0)
+        return "b";
+    if (!check_memory_region(address, length, state.mem))
+        return "EAA";
+
+    std::vector<uint8_t> data(length);
+    read_guest_memory(state.mem, address, length, data.data());
+
+    std::string str = "b";
+    str.reserve(length + length / 8 + 1);
+    for (const uint8_t byte : data) {
+        if (byte == '$' || byte == '#' || byte == '}' || byte == '*') {
+            str += '}';
+            str += static_cast<char>(byte ^ 0x20);
+        } else {
+            str += static_cast<char>(byte);
+        }
     }
 
     return str;
@@ -594,12 +751,13 @@ static std::string cmd_write_memory(EmuEnvState &state, PacketCommand &command)
     const uint32_t length = parse_hex(second);
     const std::string hex_data = content.substr(pos_second + 1);
 
-    if (!check_memory_region(address, length, state.mem))
+    if (!check_memory_region(address, length, state.mem) || hex_data.size() < length * 2)
         return "EAA";
 
-    for (uint32_t a = 0; a < length; a++) {
-        *Ptr<uint8_t>(address + a).get(state.mem) = static_cast<uint8_t>(parse_hex(hex_data.substr(a * 2, 2)));
-    }
+    std::vector<uint8_t> data(length);
+    for (uint32_t a = 0; a < length; a++)
+        data[a] = parse_hex_byte(&hex_data[a * 2]);
+    write_guest_memory(state.mem, address, length, data.data());
 
     return "OK";
 }
@@ -615,12 +773,12 @@ static std::string cmd_write_binary(EmuEnvState &state, PacketCommand &command)
     const uint32_t length = parse_hex(second);
     const char *data = command.content_start + pos_second + 1;
 
-    if (!check_memory_region(address, length, state.mem))
+    if (length == 0)
+        return "OK";
+    if (!check_memory_region(address, length, state.mem) || (content.size() - pos_second - 1 < length))
         return "EAA";
 
-    for (uint32_t a = 0; a < length; a++) {
-        *Ptr<uint8_t>(address + a).get(state.mem) = data[a];
-    }
+    write_guest_memory(state.mem, address, length, reinterpret_cast<const uint8_t *>(data));
 
     return "OK";
 }
@@ -939,10 +1097,13 @@ const static PacketFunctionBundle functions[] = {
     { "m", cmd_read_memory },
     { "M", cmd_write_memory },
     { "X", cmd_write_binary },
+    { "x", cmd_read_binary },
 
     // Query Packets
     { "qXfer:libraries:read:", cmd_xfer_libraries },
     { "qXfer:features:read:", cmd_xfer_features },
+    { "qXfer:memory-map:read:", cmd_xfer_memory_map },
+    { "qXfer:threads:read:", cmd_xfer_threads },
     { "qfThreadInfo", cmd_get_first_thread },
     { "qsThreadInfo", cmd_get_next_thread },
     { "qSupported", cmd_supported },
@@ -988,6 +1149,18 @@ static bool command_begins_with(PacketCommand &command, const std::string_view s
     return std::memcmp(command.content_start, small_str.data(), small_str.size()) == 0;
 }
 
+// '$' is always escaped inside of a packet, so only the last one can be missing its end
+static bool is_last_packet_complete(const char *data, int64_t length) {
+    int64_t begin = length - 1;
+    while (begin >= 0 && data[begin] != '$')
+        begin--;
+    if (begin < 0)
+        return true;
+
+    const void *end = std::memchr(data + begin, '#', length - begin);
+    return end && (static_cast<const char *>(end) - data + 2 < length);
+}
+
 static int64_t server_next(EmuEnvState &state) {
     PacketData buffer;
 
@@ -1001,11 +1174,27 @@ static int64_t server_next(EmuEnvState &state) {
     if (state.gdb.server_die)
         return -1;
 
-    const int64_t length = recv(state.gdb.client_socket, buffer, sizeof(buffer), 0);
+    int64_t length = recv(state.gdb.client_socket, buffer, sizeof(buffer) - 1, 0);
     if (length <= 0) {
         LOG_INFO("GDB Server Connection Closed");
         return -1;
     }
+
+    // A packet of up to GDB_PACKET_SIZE bytes can arrive in several parts, wait for its checksum
+    while (!is_last_packet_complete(buffer, length) && (length < static_cast<int64_t>(sizeof(buffer)) - 1)) {
+        readSet = { 0 };
+        FD_SET(state.gdb.client_socket, &readSet);
+        timeout = { 1, 0 };
+        if (select(state.gdb.client_socket + 1, &readSet, nullptr, nullptr, &timeout) < 1)
+            break;
+
+        const int64_t received = recv(state.gdb.client_socket, buffer + length, sizeof(buffer) - 1 - length, 0);
+        if (received <= 0) {
+            LOG_INFO("GDB Server Connection Closed");
+            return -1;
+        }
+        length += received;
+    }
     buffer[length] = '\0';
 
     for (int64_t a = 0; a < length; a++) {
@@ -1018,7 +1207,7 @@ static int64_t server_next(EmuEnvState &state) {
         }
         case '-': {
             LOG_WARN("GDB Server Transmission Error. {}", std::string(buffer, length));
-            server_reply(state.gdb, state.gdb.last_reply.c_str());
+            server_reply(state.gdb, state.gdb.last_reply);
             break;
         }
         case '$': {
@@ -1035,14 +1224,14 @@ static int64_t server_next(EmuEnvState &state) {
                         state.gdb.last_reply = function.function(state, command);
                         if (state.gdb.server_die)
                             break;
-                        server_reply(state.gdb, state.gdb.last_reply.c_str());
+                        server_reply(state.gdb, state.gdb.last_reply);
                         break;
                     }
                 }
                 if (!found_command) {
                     LOG_GDB_PACKET(state, "GDB Server Unrecognized Command. {}", std::string(command.content_start, command.content_length));
                     state.gdb.last_reply = "";
-                    server_reply(state.gdb, state.gdb.last_reply.c_str());
+                    server_reply(state.gdb, state.gdb.last_reply);
                 }
                 a += command.raw_length + 3;
 
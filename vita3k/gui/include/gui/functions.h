@@ -73,7 +73,7 @@ void init_app_background(GuiState &gui, EmuEnvState &emuenv, const std::string &
 void init_app_icon(GuiState &gui, EmuEnvState &emuenv, const std::string &app_path);
 void init_apps_icon(GuiState &gui, EmuEnvState &emuenv, const std::vector<gui::App> &app_list);
 bool init_bgm(GuiState &gui, EmuEnvState &emuenv);
-void init_bgm_player(const float vol);
+void init_bgm_player(EmuEnvState &emuenv, const float vol);
 void init_config(GuiState &gui, EmuEnvState &emuenv, const std::string &app_path);
 void init_content_manager(GuiState &gui, EmuEnvState &emuenv);
 vfs::FileBuffer init_default_icon(GuiState &gui, EmuEnvState &emuenv);
@@ -146,6 +146,8 @@ void draw_touchpad_cursor(EmuEnvState &emuenv);
 void draw_perf_overlay(GuiState &gui, EmuEnvState &emuenv);
 
 ImTextureID load_image(GuiState &gui, const uint8_t *data, const int size);
+// The images are decoded on a few threads, an image is nullptr if its file is missing and has no data if it is invalid
+std::vector<std::shared_ptr<const IconData>> load_images(GuiState &gui, const std::vector<fs::path> &paths);
 
 } // namespace gui
 
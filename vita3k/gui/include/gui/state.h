@@ -29,6 +29,8 @@
 #include <gui/imgui_impl_sdl_state.h>
 
 #include <atomic>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <thread>
@@ -99,6 +101,27 @@ struct IconAsyncLoader {
     ~IconAsyncLoader();
 };
 
+// Images decoded from the files of the apps, so that opening a screen again does not decode them again.
+// The least recently used images are dropped once the cache takes more than MAX_SIZE.
+struct DecodedImageCache {
+    static constexpr size_t MAX_SIZE = 64 * 1024 * 1024;
+
+    struct Entry {
+        std::shared_ptr<const IconData> image;
+        int64_t file_time;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> lru; // most recently used first
+    size_t size = 0;
+
+    // returns nullptr if the image is not cached or if its file changed since
+    std::shared_ptr<const IconData> get(const std::string &path, int64_t file_time);
+    void put(const std::string &path, int64_t file_time, const std::shared_ptr<const IconData> &image);
+};
+
 struct AppsSelector {
     std::vector<App> sys_apps;
     std::vector<App> user_apps;
@@ -142,6 +165,8 @@ struct DebugMenuState {
     bool lwmutexes_dialog = false;
     bool eventflags_dialog = false;
     bool allocations_dialog = false;
+    bool io_stats_dialog = false;
+    bool hle_profiler_dialog = false;
     bool memory_editor_dialog = false;
     bool disassembly_dialog = false;
 };
@@ -344,6 +369,7 @@ struct GuiState {
     ImGui_Texture start_background;
 
     std::map<std::string, ImGui_Texture> apps_background;
+    gui::DecodedImageCache image_cache;
 
     InfoBarColor information_bar_color;
 
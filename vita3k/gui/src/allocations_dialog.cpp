@@ -17,6 +17,7 @@
 
 #include "private.h"
 
+#include <mem/functions.h>
 #include <util/vector_utils.h>
 
 #include <imgui_memory_editor.h>
@@ -32,6 +33,18 @@ void draw_allocations_dialog(GuiState &gui, EmuEnvState &emuenv) {
     ImGui::Begin("Memory Allocations", &gui.debug_menu.allocations_dialog);
 
     const std::lock_guard<std::mutex> lock(emuenv.mem.generation_mutex);
+
+    // the host only commits the pages of an allocation once they are touched
+    size_t allocated_size = 0;
+    size_t resident_size = 0;
+    for (const auto &[generation_num, _] : emuenv.mem.page_name_map) {
+        const auto &page = emuenv.mem.alloc_table[generation_num];
+        allocated_size += page.size * KiB(4);
+        resident_size += get_resident_size(emuenv.mem, generation_num * KiB(4), page.size * KiB(4)).value_or(0);
+    }
+    ImGui::Text("Allocated: %zu KiB, resident: %zu KiB", allocated_size / KiB(1), resident_size / KiB(1));
+    ImGui::Separator();
+
     for (const auto &[generation_num, generation_name] : emuenv.mem.page_name_map) {
         if (vector_utils::contains(blacklist, generation_name))
             continue;
@@ -40,6 +53,9 @@ void draw_allocations_dialog(GuiState &gui, EmuEnvState &emuenv) {
         if (ImGui::TreeNode(fmt::format("{}: {}", generation_num, generation_name).c_str())) {
             ImGui::Text("Range 0x%08zx - 0x%08zx.", generation_num * KiB(4), (generation_num + page.size) * KiB(4));
             ImGui::Text("Size: %i KiB (%i page[s])", page.size * 4, page.size);
+            const auto resident = get_resident_size(emuenv.mem, generation_num * KiB(4), page.size * KiB(4));
+            if (resident)
+                ImGui::Text("Resident: %zu KiB", *resident / KiB(1));
             if (ImGui::Selectable("View/Edit")) {
                 gui.memory_editor_start = generation_num * KiB(4);
                 gui.memory_editor_count = page.size * KiB(4);
@@ -19,28 +19,12 @@
 
 #include <audio/state.h>
 #include <codec/state.h>
-#include <cubeb/cubeb.h>
 #include <gui/functions.h>
 #include <io/VitaIoDevice.h>
 #include <io/state.h>
 
 namespace gui {
 
-struct PcmBuffer {
-    std::vector<uint8_t> data;
-    uint32_t filled_size = 0;
-    uint32_t buffer_position = 0;
-};
-
-struct PcmData {
-    static constexpr int NUM_BUFFERS = 8;
-    PcmBuffer buffers[NUM_BUFFERS];
-    uint32_t write_buffer_index = 0;
-    uint32_t next_audio_buffer = 0;
-    uint32_t nb_buffers_ready = 0;
-    std::condition_variable buffers_cv;
-};
-
 struct At9Stream {
     std::shared_ptr<Atrac9DecoderState> decoder;
     std::vector<uint8_t> es_data;
@@ -50,39 +34,32 @@ struct At9Stream {
     uint32_t channels = 0;
     uint32_t sample_per_frame = 0;
     bool initialized = false;
-    bool stop_requested;
-    PcmData pcm_data;
+    bool paused = true;
+    bool stop_requested = false;
 
-    std::condition_variable init_cv;
+    std::condition_variable cond;
     std::mutex mutex;
 };
 
-// Functon to decode the next frame
-static uint32_t decode_next_frame(At9Stream *at9_stream) {
+static std::thread decode_thread;
+static AudioState *audio = nullptr;
+// port of the mixer shared with the apps, only opened while the music is playing
+static AudioOutPortPtr bgm_port;
+static float bgm_volume = 1.0f;
+static At9Stream at9_stream;
+
+// Function to decode the next frame into pcm, called with the mutex held
+static uint32_t decode_next_frame(At9Stream *at9_stream, std::vector<uint8_t> &pcm) {
     // Check if we reached the end of the data stream and reset the position
     if (at9_stream->current_pos >= at9_stream->data_size)
         at9_stream->current_pos = 0;
 
-    auto &pcm_data = at9_stream->pcm_data;
-
-    std::unique_lock<std::mutex> lock(at9_stream->mutex);
-    if (pcm_data.nb_buffers_ready >= PcmData::NUM_BUFFERS) {
-        // Wait for a buffer to be available
-        pcm_data.buffers_cv.wait(lock, [&] {
-            return pcm_data.nb_buffers_ready < PcmData::NUM_BUFFERS;
-        });
-    }
-
-    // Check if we should stop decoding
-    if (at9_stream->stop_requested || !at9_stream->initialized)
-        return 0;
-
-    auto &write_buffer = pcm_data.buffers[pcm_data.write_buffer_index];
+    pcm.resize(static_cast<size_t>(at9_stream->sample_per_frame * at9_stream->channels * sizeof(uint16_t)));
     DecoderSize size{};
     const uint8_t *frame_data = at9_stream->es_data.data() + at9_stream->current_pos;
 
     if (!at9_stream->decoder->send(frame_data)
-        || !at9_stream->decoder->receive(write_buffer.data.data(), &size)) {
+        || !at9_stream->decoder->receive(pcm.data(), &size)) {
         LOG_ERROR("Failed to decode frame");
         return 0;
     }
@@ -90,147 +67,66 @@ static uint32_t decode_next_frame(At9Stream *at9_stream) {
     uint32_t es_size_used = std::min(at9_stream->decoder->get_es_size(), at9_stream->super_frame_size);
     at9_stream->current_pos += es_size_used;
 
-    write_buffer.filled_size = size.samples * at9_stream->channels * static_cast<uint32_t>(sizeof(uint16_t));
-    write_buffer.buffer_position = 0;
-
-    // Set the next buffer to be used for writing
-    pcm_data.write_buffer_index = (pcm_data.write_buffer_index + 1) % PcmData::NUM_BUFFERS;
-    pcm_data.nb_buffers_ready++;
-
-    // Unlock the mutex to allow the audio callback to access the buffer
-    lock.unlock();
-
-    // Notify the audio callback that a new buffer is available
-    pcm_data.buffers_cv.notify_one();
-
     // return the number of samples decoded
     return size.samples;
 }
 
-// Callback function called by Cubeb when audio data is needed
-static long audio_callback(cubeb_stream *stream, void *user_ptr, const void *input_buffer, void *output_buffer, long nframes) {
-    At9Stream *at9 = static_cast<At9Stream *>(user_ptr);
-    auto &pcm_data = at9->pcm_data;
-    uint8_t *output = static_cast<uint8_t *>(output_buffer);
-
-    // Set the bytes needed for the output buffer
-    const uint32_t bytes_needed = nframes * at9->channels * sizeof(uint16_t);
-    uint32_t bytes_given = 0;
-
-    std::unique_lock<std::mutex> lock(at9->mutex);
-    while (bytes_given < bytes_needed && (pcm_data.nb_buffers_ready > 0)) {
-        auto &buf = pcm_data.buffers[pcm_data.next_audio_buffer];
-
-        // Set the bytes available in the buffer
-        uint32_t bytes_available = buf.filled_size - buf.buffer_position;
-        uint32_t bytes_to_copy = std::min(bytes_needed - bytes_given, bytes_available);
-
-        // Copy the data from the buffer to the output buffer
-        std::memcpy(output + bytes_given, buf.data.data() + buf.buffer_position, bytes_to_copy);
-
-        // Update the buffer position and bytes given
-        buf.buffer_position += bytes_to_copy;
-        bytes_given += bytes_to_copy;
-
-        // Check if have reached the end of the buffer
-        if (buf.buffer_position == buf.filled_size) {
-            // Reset the buffer position and filled size
-            buf.filled_size = 0;
-            buf.buffer_position = 0;
-
-            // Move to the next buffer
-            pcm_data.next_audio_buffer = (pcm_data.next_audio_buffer + 1) % PcmData::NUM_BUFFERS;
-
-            // Decrement the number of buffers ready
-            pcm_data.nb_buffers_ready--;
-
-            lock.unlock();
-
-            // Notify the audio callback that a buffer is available for writing again
-            pcm_data.buffers_cv.notify_one();
-
-            lock.lock();
-        }
-    }
-
-    // If we have not given enough bytes, fill the rest with zeros
-    if (bytes_given < bytes_needed) {
-        std::memset(output + bytes_given, 0, bytes_needed - bytes_given);
-    }
-
-    return nframes;
-}
-
-static std::thread playback_handle_thread;
-static cubeb_stream *stream = nullptr;
-static cubeb *ctx = nullptr;
-static At9Stream at9_stream;
+// Function to handle the decoding thread
+// the frames are decoded ahead of the mixer as much as its port lets, the output blocks once the port is full
+static void bgm_decode_thread() {
+    // only used by this thread, the stream may change while the frame is being output
+    std::vector<uint8_t> pcm;
+    while (true) {
+        AudioOutPortPtr port;
+        {
+            // Wait for the stream to be ready
+            std::unique_lock<std::mutex> lock(at9_stream.mutex);
+            at9_stream.cond.wait(lock, [] { return (at9_stream.initialized && !at9_stream.paused) || at9_stream.stop_requested; });
+
+            // If the stream is stopped, exit the thread
+            if (at9_stream.stop_requested)
+                break;
 
-// Function to handle the playback thread
-static void pcm_playback_handle_thread() {
-    // While the stream is not stopped, decode the next frame
-    while (!at9_stream.stop_requested) {
-        // Wait for the stream to be ready
-        std::unique_lock<std::mutex> lock(at9_stream.mutex);
-        at9_stream.init_cv.wait(lock, [] { return at9_stream.initialized || at9_stream.stop_requested; });
-        lock.unlock();
-
-        // If the stream is stopped, exit the thread
-        if (at9_stream.stop_requested)
-            break;
-
-        while (true) {
-            const uint32_t samples = decode_next_frame(&at9_stream);
-            if (samples == 0) {
+            if (decode_next_frame(&at9_stream, pcm) == 0) {
                 at9_stream.initialized = false;
-                break;
+                continue;
+            }
+
+            if (!bgm_port) {
+                bgm_port = audio->adapter->open_port(at9_stream.channels, 48000, at9_stream.sample_per_frame);
+                if (!bgm_port) {
+                    LOG_ERROR("Failed to open the background music audio port");
+                    at9_stream.initialized = false;
+                    continue;
+                }
+                audio->adapter->set_volume(*bgm_port, bgm_volume);
             }
+            port = bgm_port;
         }
-    }
-}
 
-// Callback called when the stream state changes
-static void state_callback(cubeb_stream *stream, void *user_ptr, cubeb_state state) {
-    switch (state) {
-    case CUBEB_STATE_DRAINED:
-        LOG_INFO("Playback drained.");
-        break;
-    case CUBEB_STATE_ERROR:
-        LOG_ERROR("Playback error.");
-        break;
-    default:
-        break;
+        // the adapter is used directly, the music is not part of the app output (recording, audio stats)
+        audio->adapter->audio_output(*port, pcm.data());
     }
 }
 
 // Function to stop the background music
 void stop_bgm() {
-    if (!stream) {
+    if (!audio)
         return;
-    }
-
-    cubeb_stream_stop(stream);
 
     // Reset the stream state
-    {
-        // We lock the mutex to protect access to the stream state
-        std::lock_guard<std::mutex> lock(at9_stream.mutex);
-        at9_stream.es_data.clear();
-        at9_stream.data_size = 0;
-        at9_stream.current_pos = 0;
-        at9_stream.initialized = false;
-        at9_stream.pcm_data.write_buffer_index = 0;
-        at9_stream.pcm_data.next_audio_buffer = 0;
-        at9_stream.pcm_data.nb_buffers_ready = 0;
-    }
-
-    // Notify the audio callback that the stream has stopped
-    at9_stream.pcm_data.buffers_cv.notify_one();
+    std::lock_guard<std::mutex> lock(at9_stream.mutex);
+    at9_stream.es_data.clear();
+    at9_stream.data_size = 0;
+    at9_stream.current_pos = 0;
+    at9_stream.initialized = false;
+    // the port is removed from the mixer once the decoding thread is done with it
+    bgm_port.reset();
 }
 
-// Function to destroy the Cubeb context
+// Function to destroy the decoding thread
 void destroy_bgm_player() {
-    if (!stream)
+    if (!audio)
         return;
 
     // Stop the Background Music
@@ -242,77 +138,63 @@ void destroy_bgm_player() {
         at9_stream.stop_requested = true;
     }
 
-    // Wake up the playback thread if it's waiting on init_cv
-    at9_stream.init_cv.notify_one();
+    // Wake up the decoding thread if it's waiting
+    at9_stream.cond.notify_one();
 
-    // Wait for the playback handle thread to finish
-    if (playback_handle_thread.joinable())
-        playback_handle_thread.join();
+    // Wait for the decoding thread to finish
+    if (decode_thread.joinable())
+        decode_thread.join();
 
-    // Destroy the stream and Cubeb context
-    cubeb_stream_destroy(stream);
-    stream = nullptr;
-    cubeb_destroy(ctx);
-    ctx = nullptr;
+    audio = nullptr;
 }
 
 void switch_bgm_state(const bool pause) {
-    if (!stream) {
-        LOG_ERROR("The background music stream is not initialized!");
+    if (!audio) {
+        LOG_ERROR("The background music player is not initialized!");
         return;
     }
 
-    if (!at9_stream.initialized)
-        return;
-
-    if (pause)
-        cubeb_stream_stop(stream);
-    else
-        cubeb_stream_start(stream);
-}
+    {
+        std::lock_guard<std::mutex> lock(at9_stream.mutex);
+        if (!at9_stream.initialized)
+            return;
 
-void set_bgm_volume(const float vol) {
-    if (!stream) {
-        LOG_ERROR("The background music stream is not initialized!");
-        return;
+        at9_stream.paused = pause;
+        // the mixer keeps running for the app, the port is closed instead so that it does not count as an underrun
+        if (pause)
+            bgm_port.reset();
     }
 
-    cubeb_stream_set_volume(stream, vol / 100.f);
+    // the mixer is stopped while an app is paused
+    if (!pause)
+        audio->switch_state(false);
+    at9_stream.cond.notify_one();
 }
 
-void init_bgm_player(const float vol) {
-    // Create a new Cubeb context
-    if (cubeb_init(&ctx, "BGM Player", nullptr) != CUBEB_OK) {
-        LOG_ERROR("Failed to initialize Cubeb context");
+void set_bgm_volume(const float vol) {
+    if (!audio) {
+        LOG_ERROR("The background music player is not initialized!");
         return;
     }
 
-    // Configure the audio output parameters
-    cubeb_stream_params output_params{
-        .format = CUBEB_SAMPLE_S16LE, // Format PCM 16-bit, little-endian
-        .rate = 48000, // Sample rate 48 kHz
-        .channels = 2, // Stereo
-        .layout = CUBEB_LAYOUT_STEREO, // Stereo layout
-        .prefs = CUBEB_STREAM_PREF_NONE // No special preferences
-    };
-
-    // Get the minimum latency for the output parameters
-    uint32_t latency;
-    cubeb_get_min_latency(ctx, &output_params, &latency);
-
-    // Lock the mutex to protect initialization of the Cubeb stream
     std::lock_guard<std::mutex> lock(at9_stream.mutex);
-    if (cubeb_stream_init(ctx, &stream, "BGM Stream", nullptr, nullptr,
-            nullptr, &output_params, latency, audio_callback, state_callback, &at9_stream)
-        != CUBEB_OK) {
-        LOG_ERROR("Failed to initialize Cubeb stream");
+    bgm_volume = vol / 100.f;
+    if (bgm_port)
+        audio->adapter->set_volume(*bgm_port, bgm_volume);
+}
+
+void init_bgm_player(EmuEnvState &emuenv, const float vol) {
+    // the music goes through the mixer of the app audio
+    if (!emuenv.audio.adapter) {
+        LOG_ERROR("The audio is not initialized, the background music is disabled");
         return;
     }
+    audio = &emuenv.audio;
 
     set_bgm_volume(vol);
 
-    // Start playback in a new thread
-    playback_handle_thread = std::thread(pcm_playback_handle_thread);
+    // Start decoding in a new thread
+    decode_thread = std::thread(bgm_decode_thread);
 }
 
 struct RiffHeader {
@@ -402,19 +284,11 @@ bool init_bgm_streaming(uint8_t *at9_data, uint32_t size) {
     at9_stream.channels = at9_stream.decoder->get(DecoderQuery::CHANNELS);
     at9_stream.sample_per_frame = at9_stream.decoder->get(DecoderQuery::AT9_SAMPLE_PER_FRAME);
 
-    // Initialize the PCM data buffers
-    for (auto &data : at9_stream.pcm_data.buffers) {
-        data.buffer_position = 0;
-        data.filled_size = 0;
-        data.data.clear();
-        data.data.reserve(static_cast<size_t>(at9_stream.sample_per_frame * at9_stream.channels * sizeof(uint16_t)));
-    }
-
     {
         std::lock_guard<std::mutex> lock(at9_stream.mutex);
         at9_stream.initialized = true;
     }
-    at9_stream.init_cv.notify_one();
+    at9_stream.cond.notify_one();
 
     return true;
 }
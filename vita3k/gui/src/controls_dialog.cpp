@@ -219,6 +219,8 @@ void draw_controls_dialog(GuiState &gui, EmuEnvState &emuenv) {
         ImGui::TableSetupColumn("mapped_button_alt");
         remapper_button(gui, emuenv, &emuenv.cfg.keyboard_toggle_texture_replacement, &emuenv.cfg.keyboard_toggle_texture_replacement_alt, lang["toggle_texture_replacement"].c_str());
         remapper_button(gui, emuenv, &emuenv.cfg.keyboard_take_screenshot, &emuenv.cfg.keyboard_take_screenshot_alt, lang["take_screenshot"].c_str());
+        remapper_button(gui, emuenv, &emuenv.cfg.keyboard_save_state, &emuenv.cfg.keyboard_save_state_alt, lang["save_state"].c_str());
+        remapper_button(gui, emuenv, &emuenv.cfg.keyboard_load_state, &emuenv.cfg.keyboard_load_state_alt, lang["load_state"].c_str());
         remapper_button(gui, emuenv, &emuenv.cfg.keyboard_pinch_modifier, &emuenv.cfg.keyboard_pinch_modifier_alt, lang["pinch_modifier"].c_str());
         remapper_button(gui, emuenv, &emuenv.cfg.keyboard_alternate_pinch_in, &emuenv.cfg.keyboard_alternate_pinch_in_alt, lang["alternate_pinch_in"].c_str());
         remapper_button(gui, emuenv, &emuenv.cfg.keyboard_alternate_pinch_out, &emuenv.cfg.keyboard_alternate_pinch_out_alt, lang["alternate_pinch_out"].c_str());
@@ -28,11 +28,13 @@
 #include <dialog/state.h>
 #include <display/state.h>
 #include <io/VitaIoDevice.h>
+#include <io/device.h>
 #include <io/state.h>
 #include <io/vfs.h>
 #include <lang/functions.h>
 #include <packages/sfo.h>
 #include <regmgr/functions.h>
+#include <threads/job_pool.h>
 #include <touch/functions.h>
 #include <util/fs.h>
 #include <util/log.h>
@@ -44,6 +46,7 @@
 #include <stb_image.h>
 
 #include <fstream>
+#include <future>
 #include <string>
 #include <vector>
 
@@ -407,19 +410,25 @@ IconAsyncLoader::IconAsyncLoader(GuiState &gui, EmuEnvState &emuenv, const std::
 
     quit = false;
     thread = std::thread([&, paths = paths()]() {
+        // decoding the png is what takes time, spread it over a few threads
+        JobPool pool;
+        pool.start(std::clamp(std::thread::hardware_concurrency(), 1U, 4U));
         for (const auto &path : paths) {
-            if (quit)
-                return;
-
-            // load the actual texture
-            IconData data = load_app_icon(gui, emuenv, path);
-
-            // Duplicate code here from init_app_icon
-            {
-                std::lock_guard<std::mutex> lock(mutex);
-                icon_data[path] = std::move(data);
-            }
+            pool.submit([&, path]() {
+                if (quit)
+                    return;
+
+                // load the actual texture
+                IconData data = load_app_icon(gui, emuenv, path);
+
+                // Duplicate code here from init_app_icon
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    icon_data[path] = std::move(data);
+                }
+            });
         }
+        pool.stop();
     });
 }
 
@@ -428,6 +437,77 @@ IconAsyncLoader::~IconAsyncLoader() {
     thread.join();
 }
 
+std::shared_ptr<const IconData> DecodedImageCache::get(const std::string &path, int64_t file_time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto entry = entries.find(path);
+    if ((entry == entries.end()) || (entry->second.file_time != file_time))
+        return nullptr;
+
+    lru.splice(lru.begin(), lru, entry->second.lru_it);
+    return entry->second.image;
+}
+
+static size_t get_image_size(const IconData &image) {
+    return static_cast<size_t>(image.width) * image.height * 4;
+}
+
+void DecodedImageCache::put(const std::string &path, int64_t file_time, const std::shared_ptr<const IconData> &image) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto [entry, inserted] = entries.try_emplace(path);
+    if (inserted) {
+        lru.push_front(path);
+        entry->second.lru_it = lru.begin();
+    } else {
+        size -= get_image_size(*entry->second.image);
+        lru.splice(lru.begin(), lru, entry->second.lru_it);
+    }
+    entry->second.image = image;
+    entry->second.file_time = file_time;
+    size += get_image_size(*image);
+
+    // an image dropped while it is being turned into a texture is kept alive by its shared_ptr
+    while ((size > MAX_SIZE) && (lru.size() > 1)) {
+        const auto last = entries.find(lru.back());
+        size -= get_image_size(*last->second.image);
+        entries.erase(last);
+        lru.pop_back();
+    }
+}
+
+std::vector<std::shared_ptr<const IconData>> load_images(GuiState &gui, const std::vector<fs::path> &paths) {
+    std::vector<std::shared_ptr<const IconData>> images(paths.size());
+
+    JobPool pool;
+    if (paths.size() > 1)
+        pool.start(std::clamp(std::thread::hardware_concurrency(), 1U, 4U));
+    for (size_t i = 0; i < paths.size(); i++) {
+        pool.submit([&, i]() {
+            boost::system::error_code err;
+            const auto file_time = static_cast<int64_t>(fs::last_write_time(paths[i], err));
+            if (err)
+                return;
+
+            const auto key = paths[i].generic_string();
+            images[i] = gui.image_cache.get(key, file_time);
+            if (images[i])
+                return;
+
+            vfs::FileBuffer buffer;
+            if (!fs_utils::read_data(paths[i], buffer) || buffer.empty())
+                return;
+
+            auto image = std::make_shared<IconData>();
+            image->data.reset(stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &image->width, &image->height, nullptr, STBI_rgb_alpha));
+            if (image->data)
+                gui.image_cache.put(key, file_time, image);
+            images[i] = std::move(image);
+        });
+    }
+    pool.stop();
+
+    return images;
+}
+
 void init_apps_icon(GuiState &gui, EmuEnvState &emuenv, const std::vector<gui::App> &app_list) {
     gui.app_selector.icon_async_loader.emplace(gui, emuenv, app_list);
 }
@@ -437,30 +517,23 @@ void init_app_background(GuiState &gui, EmuEnvState &emuenv, const std::string &
         return;
 
     const auto APP_INDEX = get_app_index(gui, app_path);
-    int32_t width = 0;
-    int32_t height = 0;
-    vfs::FileBuffer buffer;
 
     const auto is_sys = app_path.starts_with("NPXS") && (app_path != "NPXS10007");
-    if (is_sys)
-        vfs::read_file(VitaIoDevice::vs0, buffer, emuenv.pref_path, "app/" + app_path + "/sce_sys/pic0.png");
-    else
-        vfs::read_app_file(buffer, emuenv.pref_path, app_path, "sce_sys/pic0.png");
+    const auto device = is_sys ? VitaIoDevice::vs0 : VitaIoDevice::ux0;
+    const auto image = load_images(gui, { device::construct_emulated_path(device, "app/" + app_path + "/sce_sys/pic0.png", emuenv.pref_path).generic_path() }).front();
 
     const auto &title = APP_INDEX ? APP_INDEX->title : app_path;
 
-    if (buffer.empty()) {
+    if (!image) {
         LOG_WARN("Background not found for application {} [{}].", title, app_path);
         return;
     }
 
-    stbi_uc *data = stbi_load_from_memory(&buffer[0], static_cast<int>(buffer.size()), &width, &height, nullptr, STBI_rgb_alpha);
-    if (!data) {
+    if (!image->data) {
         LOG_ERROR("Invalid background for application {} [{}].", title, app_path);
         return;
     }
-    gui.apps_background[app_path] = ImGui_Texture(gui.imgui_state.get(), data, width, height);
-    stbi_image_free(data);
+    gui.apps_background[app_path] = ImGui_Texture(gui.imgui_state.get(), image->data.get(), image->width, image->height);
 }
 
 std::string get_sys_lang_name(uint32_t lang_id) {
@@ -471,58 +544,91 @@ std::string get_sys_lang_name(uint32_t lang_id) {
     return current_sys_lang->second;
 }
 
-static bool get_user_apps(GuiState &gui, EmuEnvState &emuenv) {
-    const auto apps_cache_path{ emuenv.pref_path / "ux0/temp/apps.dat" };
-    fs::ifstream apps_cache(apps_cache_path, std::ios::in | std::ios::binary);
-    if (apps_cache.is_open()) {
-        gui.app_selector.user_apps.clear();
-        // Read size of apps list
-        size_t size;
-        apps_cache.read((char *)&size, sizeof(size));
-
-        // Check version of cache
-        uint32_t versionInFile;
-        apps_cache.read((char *)&versionInFile, sizeof(uint32_t));
-        if (versionInFile != 1) {
-            LOG_WARN("Current version of cache: {}, is outdated, recreate it.", versionInFile);
-            return false;
-        }
+// Version 2 added the time of the param.sfo of each app, to only read again the apps which changed
+static constexpr uint32_t APPS_CACHE_VERSION = 2;
 
-        // Read language of cache
-        apps_cache.read((char *)&gui.app_selector.apps_cache_lang, sizeof(uint32_t));
-        if (gui.app_selector.apps_cache_lang != emuenv.cfg.sys_lang) {
-            LOG_WARN("Current lang of cache: {}, is different configuration: {}, recreate it.", get_sys_lang_name(gui.app_selector.apps_cache_lang), get_sys_lang_name(emuenv.cfg.sys_lang));
-            return false;
-        }
+struct CachedApp {
+    App app;
+    int64_t param_time;
+};
 
-        // Read App info value
-        for (size_t a = 0; a < size; a++) {
-            auto read = [&apps_cache]() {
-                size_t size;
+static int64_t get_param_time(EmuEnvState &emuenv, const std::string &app_path) {
+    boost::system::error_code err;
+    const auto time = fs::last_write_time(emuenv.pref_path / "ux0/app" / app_path / "sce_sys/param.sfo", err);
+    return err ? 0 : static_cast<int64_t>(time);
+}
 
-                apps_cache.read((char *)&size, sizeof(size));
+static bool read_apps_cache(GuiState &gui, EmuEnvState &emuenv, std::vector<CachedApp> &cached_apps) {
+    const auto apps_cache_path{ emuenv.pref_path / "ux0/temp/apps.dat" };
+    fs::ifstream apps_cache(apps_cache_path, std::ios::in | std::ios::binary);
+    if (!apps_cache.is_open())
+        return false;
+
+    // Read size of apps list
+    size_t size;
+    apps_cache.read((char *)&size, sizeof(size));
+
+    // Check version of cache
+    uint32_t versionInFile;
+    apps_cache.read((char *)&versionInFile, sizeof(uint32_t));
+    if (versionInFile != APPS_CACHE_VERSION) {
+        LOG_WARN("Current version of cache: {}, is outdated, recreate it.", versionInFile);
+        return false;
+    }
 
-                std::vector<char> buffer(size); // dont trust std::string to hold buffer enough
-                apps_cache.read(buffer.data(), size);
+    // Read language of cache
+    apps_cache.read((char *)&gui.app_selector.apps_cache_lang, sizeof(uint32_t));
+    if (gui.app_selector.apps_cache_lang != emuenv.cfg.sys_lang) {
+        LOG_WARN("Current lang of cache: {}, is different configuration: {}, recreate it.", get_sys_lang_name(gui.app_selector.apps_cache_lang), get_sys_lang_name(emuenv.cfg.sys_lang));
+        return false;
+    }
 
-                return std::string(buffer.begin(), buffer.end());
-            };
+    // Read App info value
+    cached_apps.clear();
+    for (size_t a = 0; a < size; a++) {
+        auto read = [&apps_cache]() {
+            size_t size;
+
+            apps_cache.read((char *)&size, sizeof(size));
+
+            std::vector<char> buffer(size); // dont trust std::string to hold buffer enough
+            apps_cache.read(buffer.data(), size);
+
+            return std::string(buffer.begin(), buffer.end());
+        };
+
+        CachedApp cached_app{};
+        App &app = cached_app.app;
+
+        app.app_ver = read();
+        app.category = read();
+        app.content_id = read();
+        app.addcont = read();
+        app.savedata = read();
+        app.parental_level = read();
+        app.stitle = read();
+        app.title = read();
+        app.title_id = read();
+        app.path = read();
+        apps_cache.read((char *)&cached_app.param_time, sizeof(int64_t));
+
+        if (!apps_cache) {
+            LOG_WARN("Cache of apps list is truncated, recreate it.");
+            return false;
+        }
 
-            App app;
+        cached_apps.push_back(std::move(cached_app));
+    }
 
-            app.app_ver = read();
-            app.category = read();
-            app.content_id = read();
-            app.addcont = read();
-            app.savedata = read();
-            app.parental_level = read();
-            app.stitle = read();
-            app.title = read();
-            app.title_id = read();
-            app.path = read();
+    return true;
+}
 
-            gui.app_selector.user_apps.push_back(app);
-        }
+static bool get_user_apps(GuiState &gui, EmuEnvState &emuenv) {
+    std::vector<CachedApp> cached_apps;
+    if (read_apps_cache(gui, emuenv, cached_apps)) {
+        gui.app_selector.user_apps.clear();
+        for (auto &cached_app : cached_apps)
+            gui.app_selector.user_apps.push_back(std::move(cached_app.app));
 
         init_apps_icon(gui, emuenv, gui.app_selector.user_apps);
         load_and_update_compat_user_apps(gui, emuenv);
@@ -542,7 +648,7 @@ void save_apps_cache(GuiState &gui, EmuEnvState &emuenv) {
         apps_cache.write(reinterpret_cast<const char *>(&size), sizeof(size));
 
         // Write version of cache
-        const uint32_t versionInFile = 1;
+        const uint32_t versionInFile = APPS_CACHE_VERSION;
         apps_cache.write(reinterpret_cast<const char *>(&versionInFile), sizeof(uint32_t));
 
         // Write language of cache
@@ -568,6 +674,9 @@ void save_apps_cache(GuiState &gui, EmuEnvState &emuenv) {
             write(app.title);
             write(app.title_id);
             write(app.path);
+
+            const int64_t param_time = get_param_time(emuenv, app.path);
+            apps_cache.write(reinterpret_cast<const char *>(&param_time), sizeof(int64_t));
         }
         apps_cache.close();
     }
@@ -680,7 +789,7 @@ App *get_app_index(GuiState &gui, const std::string &app_path) {
     return (app_index != app_type.end()) ? &(*app_index) : nullptr;
 }
 
-void get_app_param(GuiState &gui, EmuEnvState &emuenv, const std::string &app_path) {
+static App read_app_param(EmuEnvState &emuenv, const std::string &app_path) {
     sfo::SfoAppInfo app_info;
     vfs::FileBuffer param;
     if (vfs::read_app_file(param, emuenv.pref_path, app_path, "sce_sys/param.sfo")) {
@@ -691,7 +800,11 @@ void get_app_param(GuiState &gui, EmuEnvState &emuenv, const std::string &app_pa
         app_info.app_version = "0.00"; // Default Version
         app_info.app_category = "-"; // Default Category
     }
-    gui.app_selector.user_apps.push_back({ app_info.app_version, app_info.app_category, app_info.app_content_id, app_info.app_addcont, app_info.app_savedata, app_info.app_parental_level, app_info.app_short_title, app_info.app_title, app_info.app_title_id, app_path });
+    return { app_info.app_version, app_info.app_category, app_info.app_content_id, app_info.app_addcont, app_info.app_savedata, app_info.app_parental_level, app_info.app_short_title, app_info.app_title, app_info.app_title_id, app_path };
+}
+
+void get_app_param(GuiState &gui, EmuEnvState &emuenv, const std::string &app_path) {
+    gui.app_selector.user_apps.push_back(read_app_param(emuenv, app_path));
 }
 
 ImU32 get_selectable_color_pulse(const float max_alpha) {
@@ -714,14 +827,41 @@ void get_user_apps_title(GuiState &gui, EmuEnvState &emuenv) {
     if (!fs::exists(app_path))
         return;
 
-    gui.app_selector.user_apps.clear();
+    // the apps whose param.sfo did not change since the cache was saved are taken from it
+    std::map<std::string, CachedApp> cached_apps;
+    {
+        std::vector<CachedApp> cache;
+        if (read_apps_cache(gui, emuenv, cache)) {
+            for (auto &cached_app : cache)
+                cached_apps[cached_app.app.path] = std::move(cached_app);
+        }
+    }
+
+    JobPool pool;
+    pool.start(std::clamp(std::thread::hardware_concurrency(), 1U, 4U));
+    std::vector<App> user_apps;
+    std::vector<std::pair<size_t, std::future<App>>> read_apps;
     for (const auto &app : fs::directory_iterator(app_path)) {
         if (!app.path().empty() && fs::is_directory(app.path())
             && !app.path().filename_is_dot() && !app.path().filename_is_dot_dot()) {
-            get_app_param(gui, emuenv, app.path().stem().generic_string());
+            const auto path = app.path().stem().generic_string();
+            const auto cached_app = cached_apps.find(path);
+            if ((cached_app != cached_apps.end()) && (cached_app->second.param_time == get_param_time(emuenv, path)))
+                user_apps.push_back(std::move(cached_app->second.app));
+            else {
+                read_apps.emplace_back(user_apps.size(), pool.submit([&emuenv, path]() { return read_app_param(emuenv, path); }));
+                user_apps.emplace_back();
+            }
         }
     }
 
+    for (auto &[index, app] : read_apps)
+        user_apps[index] = app.get();
+    pool.stop();
+
+    LOG_INFO("Apps list: {} read, {} taken from the cache", read_apps.size(), user_apps.size() - read_apps.size());
+    gui.app_selector.user_apps = std::move(user_apps);
+
     save_apps_cache(gui, emuenv);
 }
 
@@ -863,6 +1003,16 @@ void init(GuiState &gui, EmuEnvState &emuenv) {
 
     // Initialize trophy callback
     emuenv.np.trophy_state.trophy_unlock_callback = [&gui](NpTrophyUnlockCallbackData &callback_data) {
+        // called by the trophy worker, the icon is decoded here and only its texture is created by the main thread
+        int width, height;
+        stbi_uc *pixels = stbi_load_from_memory(callback_data.icon_buf.data(), static_cast<int>(callback_data.icon_buf.size()), &width, &height, nullptr, STBI_rgb_alpha);
+        if (pixels) {
+            callback_data.icon_pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+            callback_data.icon_width = width;
+            callback_data.icon_height = height;
+            stbi_image_free(pixels);
+        }
+
         const std::lock_guard<std::mutex> guard(gui.trophy_unlock_display_requests_access_mutex);
         gui.trophy_unlock_display_requests.insert(gui.trophy_unlock_display_requests.begin(), callback_data);
     };
@@ -1012,6 +1162,10 @@ void draw_ui(GuiState &gui, EmuEnvState &emuenv) {
         draw_event_flags_dialog(gui, emuenv);
     if (gui.debug_menu.allocations_dialog)
         draw_allocations_dialog(gui, emuenv);
+    if (gui.debug_menu.io_stats_dialog)
+        draw_io_stats_dialog(gui, emuenv);
+    if (gui.debug_menu.hle_profiler_dialog)
+        draw_hle_profiler_dialog(gui, emuenv);
     if (gui.debug_menu.disassembly_dialog)
         draw_disassembly_dialog(gui, emuenv);
 
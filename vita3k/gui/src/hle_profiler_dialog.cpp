@@ -0,0 +1,115 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include "private.h"
+
+#include <kernel/state.h>
+#include <nids/functions.h>
+
+#include <algorithm>
+#include <string_view>
+
+namespace gui {
+
+enum HleProfilerColumn {
+    HLE_PROFILER_FUNCTION,
+    HLE_PROFILER_NID,
+    HLE_PROFILER_CALLS,
+    HLE_PROFILER_TOTAL,
+    HLE_PROFILER_AVERAGE
+};
+
+static void sort_functions(std::vector<HleProfiler::FunctionStats> &functions, const ImGuiTableColumnSortSpecs &spec) {
+    const auto get_average = [](const HleProfiler::FunctionStats &function) {
+        return static_cast<double>(function.total_ns) / static_cast<double>(function.count);
+    };
+    std::sort(functions.begin(), functions.end(), [&](const HleProfiler::FunctionStats &lhs, const HleProfiler::FunctionStats &rhs) {
+        bool is_less;
+        switch (spec.ColumnUserID) {
+        case HLE_PROFILER_FUNCTION:
+            is_less = std::string_view(import_name(import_slot_nid(lhs.slot))) < import_name(import_slot_nid(rhs.slot));
+            break;
+        case HLE_PROFILER_NID:
+            is_less = import_slot_nid(lhs.slot) < import_slot_nid(rhs.slot);
+            break;
+        case HLE_PROFILER_CALLS:
+            is_less = lhs.count < rhs.count;
+            break;
+        case HLE_PROFILER_AVERAGE:
+            is_less = get_average(lhs) < get_average(rhs);
+            break;
+        default:
+            is_less = lhs.total_ns < rhs.total_ns;
+            break;
+        }
+        return spec.SortDirection == ImGuiSortDirection_Ascending ? is_less : !is_less;
+    });
+}
+
+void draw_hle_profiler_dialog(GuiState &gui, EmuEnvState &emuenv) {
+    ImGui::Begin("HLE Profiler", &gui.debug_menu.hle_profiler_dialog);
+
+    HleProfiler &profiler = emuenv.kernel.hle_profiler;
+    bool enabled = profiler.enabled;
+    if (ImGui::Checkbox("Record", &enabled))
+        profiler.enabled = enabled;
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+        profiler.reset();
+    ImGui::SameLine();
+    if (ImGui::Button("Save CSV"))
+        profiler.save_csv(emuenv.log_path / "hle_profile.csv");
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_NoSavedSettings | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV
+        | ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("functions", 5, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Function", ImGuiTableColumnFlags_None, 0.0f, HLE_PROFILER_FUNCTION);
+        ImGui::TableSetupColumn("NID", ImGuiTableColumnFlags_None, 0.0f, HLE_PROFILER_NID);
+        ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, HLE_PROFILER_CALLS);
+        ImGui::TableSetupColumn("Total ms", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending, 0.0f, HLE_PROFILER_TOTAL);
+        ImGui::TableSetupColumn("Avg us", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, HLE_PROFILER_AVERAGE);
+        ImGui::TableHeadersRow();
+
+        std::vector<HleProfiler::FunctionStats> functions = profiler.get_stats();
+        const ImGuiTableSortSpecs *sort_specs = ImGui::TableGetSortSpecs();
+        if (sort_specs && sort_specs->SpecsCount > 0)
+            sort_functions(functions, sort_specs->Specs[0]);
+
+        for (const auto &function : functions) {
+            const uint32_t nid = import_slot_nid(function.slot);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(import_name(nid));
+            ImGui::TableNextColumn();
+            ImGui::Text("%08X", nid);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(function.count));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", function.total_ns / 1'000'000.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", function.total_ns / 1000.0 / function.count);
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+} // namespace gui
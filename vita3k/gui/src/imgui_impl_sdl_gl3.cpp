@@ -51,6 +51,10 @@
 void ImGui_ImplSdlGL3_RenderDrawData(ImGui_GLState &state) {
     ImDrawData *draw_data = ImGui::GetDrawData();
 
+    // Nothing of the gui is visible, do not query and restore the whole GL state for it
+    if (draw_data->TotalVtxCount == 0)
+        return;
+
     // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
     ImGuiIO &io = ImGui::GetIO();
     int fb_width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
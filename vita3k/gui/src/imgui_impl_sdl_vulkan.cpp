@@ -441,6 +441,10 @@ IMGUI_API void ImGui_ImplSdlVulkan_RenderDrawData(ImGui_VulkanState &state) {
         return;
     }
 
+    // Nothing of the gui is visible, the swapchain image is still acquired above so that it can be presented
+    if (draw_data->TotalVtxCount == 0)
+        return;
+
     state.CommandBuffer = vk_state.screen_renderer.current_cmd_buffer;
     // uint32_t image_index = vk_state.screen_renderer.swapchain_image_idx;
 
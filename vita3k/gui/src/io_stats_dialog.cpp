@@ -0,0 +1,90 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "private.h"
+
+#include <io/state.h>
+
+#include <fmt/format.h>
+
+namespace gui {
+
+static void draw_path_stats_table(const char *id, const std::map<std::string, IoStats::PathStats> &all_stats) {
+    if (!ImGui::BeginTable(id, 7, ImGuiTableFlags_NoSavedSettings | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+        return;
+
+    ImGui::TableSetupColumn("Path");
+    ImGui::TableSetupColumn("Op");
+    ImGui::TableSetupColumn("Count");
+    ImGui::TableSetupColumn("KiB");
+    ImGui::TableSetupColumn("Total ms");
+    ImGui::TableSetupColumn("p50 us");
+    ImGui::TableSetupColumn("p99 us");
+    ImGui::TableHeadersRow();
+
+    for (const auto &[path, path_stats] : all_stats) {
+        bool first_op = true;
+        for (size_t op = 0; op < path_stats.size(); op++) {
+            const auto &stats = path_stats[op];
+            if (stats.count == 0)
+                continue;
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (first_op)
+                ImGui::TextUnformatted(path.c_str());
+            first_op = false;
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(get_io_op_name(static_cast<IoOp>(op)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(stats.count));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(stats.bytes / 1024));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", stats.total_us / 1000.0);
+            // the percentiles are the upper bounds of the histogram buckets
+            ImGui::TableNextColumn();
+            ImGui::Text("<%llu", static_cast<unsigned long long>(stats.get_latency_percentile(0.5)));
+            ImGui::TableNextColumn();
+            ImGui::Text("<%llu", static_cast<unsigned long long>(stats.get_latency_percentile(0.99)));
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+void draw_io_stats_dialog(GuiState &gui, EmuEnvState &emuenv) {
+    ImGui::Begin("IO Statistics", &gui.debug_menu.io_stats_dialog);
+
+    IoStats &stats = emuenv.io.stats;
+    ImGui::Checkbox("Record", &stats.enabled);
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+        stats.reset();
+    ImGui::SameLine();
+    if (ImGui::Button("Save report"))
+        stats.save_report(emuenv.log_path / "io_stats.json");
+
+    if (ImGui::CollapsingHeader("Devices", ImGuiTreeNodeFlags_DefaultOpen))
+        draw_path_stats_table("devices", stats.get_device_stats());
+    if (ImGui::CollapsingHeader("Directories", ImGuiTreeNodeFlags_DefaultOpen))
+        draw_path_stats_table("directories", stats.get_directory_stats());
+
+    ImGui::End();
+}
+
+} // namespace gui
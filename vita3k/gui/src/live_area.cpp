@@ -31,6 +31,7 @@
 #include <renderer/state.h>
 
 #include <io/VitaIoDevice.h>
+#include <io/device.h>
 #include <io/vfs.h>
 
 #include <util/log.h>
@@ -39,7 +40,6 @@
 
 #include <chrono>
 #include <imgui_internal.h>
-#include <stb_image.h>
 
 void GateAnimation::start(GateAnimationState anim_state) {
     state = anim_state;
@@ -268,36 +268,44 @@ void init_live_area(GuiState &gui, EmuEnvState &emuenv, const std::string &app_p
                 name["livearea-background"].erase(remove(name["livearea-background"].begin(), name["livearea-background"].end(), '\n'), name["livearea-background"].end());
             name["livearea-background"].erase(remove_if(name["livearea-background"].begin(), name["livearea-background"].end(), isspace), name["livearea-background"].end());
 
-            for (const auto &contents : name) {
-                int32_t width = 0;
-                int32_t height = 0;
-                vfs::FileBuffer buffer;
+            // host path of a file of the live area contents of the app
+            const auto get_app_contents_path = [&](const std::string &file_name) {
+                if (app_device == VitaIoDevice::vs0)
+                    return device::construct_emulated_path(VitaIoDevice::vs0, fmt::format("app/{}/sce_sys/livearea/contents/{}", app_path, file_name), emuenv.pref_path).generic_path();
+                else
+                    return device::construct_emulated_path(VitaIoDevice::ux0, fs::path("app") / app_path / live_area_path / "contents" / file_name, emuenv.pref_path).generic_path();
+            };
 
+            std::vector<std::pair<std::string, std::string>> contents_list;
+            std::vector<fs::path> contents_paths;
+            for (const auto &contents : name) {
                 if (contents.second.empty()) {
                     LOG_WARN("Content '{}' is empty for title {} [{}].", contents.first, app_path, APP_INDEX->title);
                     continue;
                 }
 
+                contents_list.push_back(contents);
                 if (default_contents)
-                    vfs::read_file(VitaIoDevice::vs0, buffer, emuenv.pref_path, "data/internal/livearea/default/sce_sys/livearea/contents/" + contents.second);
-                else if (app_device == VitaIoDevice::vs0)
-                    vfs::read_file(VitaIoDevice::vs0, buffer, emuenv.pref_path, "app/" + app_path + "/sce_sys/livearea/contents/" + contents.second);
+                    contents_paths.push_back(device::construct_emulated_path(VitaIoDevice::vs0, "data/internal/livearea/default/sce_sys/livearea/contents/" + contents.second, emuenv.pref_path).generic_path());
                 else
-                    vfs::read_app_file(buffer, emuenv.pref_path, app_path, live_area_path / "contents" / contents.second);
+                    contents_paths.push_back(get_app_contents_path(contents.second));
+            }
 
-                if (buffer.empty()) {
+            const auto contents_images = load_images(gui, contents_paths);
+            for (size_t i = 0; i < contents_list.size(); i++) {
+                const auto &contents = contents_list[i];
+                const auto &image = contents_images[i];
+                if (!image) {
                     if (is_ps_app || is_sys_app)
                         LOG_WARN("Contents {} '{}' Not found for title {} [{}].", contents.first, contents.second, app_path, APP_INDEX->title);
                     continue;
                 }
-                stbi_uc *data = stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &width, &height, nullptr, STBI_rgb_alpha);
-                if (!data) {
+                if (!image->data) {
                     LOG_ERROR("Invalid Live Area Contents '{}' for title {} [{}].", contents.second, app_path, APP_INDEX->title);
                     continue;
                 }
 
-                gui.live_area_contents[app_path][contents.first] = ImGui_Texture(gui.imgui_state.get(), data, width, height);
-                stbi_image_free(data);
+                gui.live_area_contents[app_path][contents.first] = ImGui_Texture(gui.imgui_state.get(), image->data.get(), image->width, image->height);
             }
 
             std::map<std::string, std::map<std::string, std::vector<std::string>>> items_name;
@@ -455,73 +463,46 @@ void init_live_area(GuiState &gui, EmuEnvState &emuenv, const std::string &app_p
                 }
             }
 
+            struct ItemImage {
+                std::string frame;
+                std::string kind;
+                std::string name;
+            };
+            std::vector<ItemImage> item_images;
+            std::vector<fs::path> item_paths;
             for (auto &item : items_name) {
                 current_item[app_path][item.first] = 0;
-                if (!item.second.empty()) {
-                    for (auto &bg_name : item.second["background"]) {
-                        if (!bg_name.empty()) {
-                            if (bg_name.find('\n') != std::string::npos)
-                                bg_name.erase(remove(bg_name.begin(), bg_name.end(), '\n'), bg_name.end());
-                            bg_name.erase(remove_if(bg_name.begin(), bg_name.end(), isspace), bg_name.end());
-
-                            int32_t width = 0;
-                            int32_t height = 0;
-                            vfs::FileBuffer buffer;
-
-                            if (app_device == VitaIoDevice::vs0)
-                                vfs::read_file(VitaIoDevice::vs0, buffer, emuenv.pref_path, fmt::format("app/{}/sce_sys/livearea/contents/{}", app_path, bg_name));
-                            else
-                                vfs::read_app_file(buffer, emuenv.pref_path, app_path, live_area_path / "contents" / bg_name);
+                for (const std::string kind : { "background", "image" }) {
+                    for (auto &item_name : item.second[kind]) {
+                        if (item_name.empty())
+                            continue;
 
-                            if (buffer.empty()) {
-                                if (is_ps_app || is_sys_app)
-                                    LOG_WARN("background, Id: {}, Name: '{}', Not found for title: {} [{}].", item.first, bg_name, app_path, APP_INDEX->title);
-                                continue;
-                            }
-                            stbi_uc *data = stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &width, &height, nullptr, STBI_rgb_alpha);
-                            if (!data) {
-                                LOG_ERROR("Frame: {}, Invalid Live Area Contents for title: {} [{}].", item.first, app_path, APP_INDEX->title);
-                                continue;
-                            }
+                        if (item_name.find('\n') != std::string::npos)
+                            item_name.erase(remove(item_name.begin(), item_name.end(), '\n'), item_name.end());
+                        item_name.erase(remove_if(item_name.begin(), item_name.end(), isspace), item_name.end());
 
-                            items_size[app_path][item.first]["background"] = ImVec2(static_cast<float>(width), static_cast<float>(height));
-                            gui.live_items[app_path][item.first]["background"].emplace_back(gui.imgui_state.get(), data, width, height);
-                            stbi_image_free(data);
-                        }
+                        item_images.push_back({ item.first, kind, item_name });
+                        item_paths.push_back(get_app_contents_path(item_name));
                     }
+                }
+            }
 
-                    for (auto &img_name : item.second["image"]) {
-                        if (!img_name.empty()) {
-                            if (img_name.find('\n') != std::string::npos)
-                                img_name.erase(remove(img_name.begin(), img_name.end(), '\n'), img_name.end());
-                            img_name.erase(remove_if(img_name.begin(), img_name.end(), isspace), img_name.end());
-
-                            int32_t width = 0;
-                            int32_t height = 0;
-                            vfs::FileBuffer buffer;
-
-                            if (app_device == VitaIoDevice::vs0)
-                                vfs::read_file(VitaIoDevice::vs0, buffer, emuenv.pref_path, fmt::format("app/{}/sce_sys/livearea/contents/{}", app_path, img_name));
-                            else
-                                vfs::read_app_file(buffer, emuenv.pref_path, app_path, live_area_path / "contents" / img_name);
-
-                            if (buffer.empty()) {
-                                if (is_ps_app || is_sys_app)
-                                    LOG_WARN("Image, Id: {} Name: '{}', Not found for title {} [{}].", item.first, img_name, app_path, APP_INDEX->title);
-                                continue;
-                            }
-                            stbi_uc *data = stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &width, &height, nullptr, STBI_rgb_alpha);
-                            if (!data) {
-                                LOG_ERROR("Frame: {}, Invalid Live Area Contents for title: {} [{}].", item.first, app_path, APP_INDEX->title);
-                                continue;
-                            }
-
-                            items_size[app_path][item.first]["image"] = ImVec2(static_cast<float>(width), static_cast<float>(height));
-                            gui.live_items[app_path][item.first]["image"].emplace_back(gui.imgui_state.get(), data, width, height);
-                            stbi_image_free(data);
-                        }
-                    }
+            const auto images = load_images(gui, item_paths);
+            for (size_t i = 0; i < item_images.size(); i++) {
+                const auto &item = item_images[i];
+                const auto &image = images[i];
+                if (!image) {
+                    if (is_ps_app || is_sys_app)
+                        LOG_WARN("{}, Id: {}, Name: '{}', Not found for title: {} [{}].", item.kind, item.frame, item.name, app_path, APP_INDEX->title);
+                    continue;
                 }
+                if (!image->data) {
+                    LOG_ERROR("Frame: {}, Invalid Live Area Contents for title: {} [{}].", item.frame, app_path, APP_INDEX->title);
+                    continue;
+                }
+
+                items_size[app_path][item.frame][item.kind] = ImVec2(static_cast<float>(image->width), static_cast<float>(image->height));
+                gui.live_items[app_path][item.frame][item.kind].emplace_back(gui.imgui_state.get(), image->data.get(), image->width, image->height);
             }
         }
     }
@@ -115,6 +115,8 @@ static void draw_debug_menu(GuiState &gui, DebugMenuState &state) {
         ImGui::MenuItem(lang["lightweight_condition_variables"].c_str(), nullptr, &state.lwcondvars_dialog);
         ImGui::MenuItem(lang["event_flags"].c_str(), nullptr, &state.eventflags_dialog);
         ImGui::MenuItem(lang["memory_allocations"].c_str(), nullptr, &state.allocations_dialog);
+        ImGui::MenuItem(lang["io_statistics"].c_str(), nullptr, &state.io_stats_dialog);
+        ImGui::MenuItem(lang["hle_profiler"].c_str(), nullptr, &state.hle_profiler_dialog);
         ImGui::MenuItem(lang["disassembly"].c_str(), nullptr, &state.disassembly_dialog);
         ImGui::EndMenu();
     }
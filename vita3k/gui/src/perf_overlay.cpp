@@ -17,11 +17,68 @@
 
 #include "private.h"
 
+#include <audio/state.h>
 #include <config/state.h>
+#include <cpu/functions.h>
+#include <kernel/state.h>
+#include <mem/util.h>
+#include <renderer/state.h>
+#include <util/frame_timings.h>
+
+#include <algorithm>
+#include <numeric>
 
 namespace gui {
 static const ImVec2 PERF_OVERLAY_PAD = ImVec2(12.f, 12.f);
 static const ImVec4 PERF_OVERLAY_BG_COLOR = ImVec4(0.282f, 0.239f, 0.545f, 0.8f);
+// one color per stage of the frame timings, the time left in the frame is drawn in gray
+static const std::array<ImU32, frame_timings::STAGE_COUNT> FRAME_STAGE_COLORS = {
+    IM_COL32(80, 170, 255, 255),
+    IM_COL32(255, 170, 60, 255),
+    IM_COL32(255, 80, 80, 255),
+    IM_COL32(120, 220, 120, 255),
+    IM_COL32(220, 120, 255, 255),
+    IM_COL32(255, 235, 100, 255),
+};
+static const ImU32 FRAME_OTHER_COLOR = IM_COL32(150, 150, 150, 160);
+// frame time histogram buckets of 2 ms, the last one counts the slower frames
+constexpr int FRAME_HISTOGRAM_BUCKETS = 25;
+constexpr float FRAME_HISTOGRAM_BUCKET_MS = 2.f;
+
+static void draw_frame_timings_bars(const std::vector<frame_timings::Frame> &frames, const ImVec2 &size) {
+    const ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImGui::Dummy(size);
+    if (frames.empty())
+        return;
+
+    float max_ms = 1000.f / 60.f;
+    for (const auto &frame : frames)
+        max_ms = std::max(max_ms, frame.total_ms);
+
+    // one stacked bar per frame, the most recent on the right
+    ImDrawList *draw_list = ImGui::GetWindowDrawList();
+    const float bar_width = size.x / frame_timings::HISTORY_SIZE;
+    const float bottom = pos.y + size.y;
+    float left = pos.x + size.x - frames.size() * bar_width;
+    for (const auto &frame : frames) {
+        float top = bottom;
+        float stages_ms = 0.f;
+        for (size_t i = 0; i < frame_timings::STAGE_COUNT; i++) {
+            // the stages run on several threads, only what fits in the frame time is drawn
+            const float stage_ms = std::min(frame.stage_ms[i], frame.total_ms - stages_ms);
+            if (stage_ms <= 0.f)
+                continue;
+            stages_ms += stage_ms;
+            const float height = stage_ms / max_ms * size.y;
+            draw_list->AddRectFilled(ImVec2(left, top - height), ImVec2(left + bar_width, top), FRAME_STAGE_COLORS[i]);
+            top -= height;
+        }
+        const float total_top = bottom - frame.total_ms / max_ms * size.y;
+        if (total_top < top)
+            draw_list->AddRectFilled(ImVec2(left, total_top), ImVec2(left + bar_width, top), FRAME_OTHER_COLOR);
+        left += bar_width;
+    }
+}
 
 static ImVec2 get_perf_pos(ImVec2 window_size, EmuEnvState &emuenv) {
     const auto TOP = emuenv.logical_viewport_pos.y - PERF_OVERLAY_PAD.y;
@@ -53,15 +110,111 @@ void draw_perf_overlay(GuiState &gui, EmuEnvState &emuenv) {
     const auto FONT_SCALE = SCALED_FONT_SIZE / ImGui::GetFontSize();
 
     const auto FPS_TEXT = emuenv.cfg.performance_overlay_detail == MINIMUM ? fmt::format("FPS: {}", emuenv.fps) : fmt::format("FPS: {} {}: {}", emuenv.fps, lang["avg"], emuenv.avg_fps);
-    const auto MIN_MAX_FPS_TEXT = fmt::format("{}: {} {}: {}", lang["min"], emuenv.min_fps, lang["max"], emuenv.max_fps);
+    const bool is_vulkan = emuenv.renderer->current_backend == renderer::Backend::Vulkan;
+
+    // lines displayed below the fps, separated from each other
+    std::vector<std::string> detail_lines;
+    if (emuenv.cfg.performance_overlay_detail >= MEDIUM)
+        detail_lines.push_back(fmt::format("{}: {} {}: {}", lang["min"], emuenv.min_fps, lang["max"], emuenv.max_fps));
+    // per frame descriptor set usage, only tracked by the Vulkan renderer
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM && is_vulkan)
+        detail_lines.push_back(fmt::format("{}: {} {}: {}", lang["descriptor_sets"], emuenv.renderer->descriptor_sets_allocated.load(), lang["pushed"], emuenv.renderer->descriptor_sets_pushed.load()));
+    // per frame draws using programmable blending, only tracked by the Vulkan renderer
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM && is_vulkan && emuenv.renderer->color_read_draws > 0)
+        detail_lines.push_back(fmt::format("{}: {} {}: {}", lang["color_reads"], emuenv.renderer->color_read_draws.load(), lang["barriers"], emuenv.renderer->color_read_barriers.load()));
+    // per frame copies of the guest data to the mapped buffers, only done with the double buffer memory mapping
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM && is_vulkan && emuenv.renderer->mapping_method == renderer::MappingMethod::DoubleBuffer)
+        detail_lines.push_back(fmt::format("{}: {} KiB", lang["mapped_copies"], emuenv.renderer->mapped_bytes_copied.load() / KiB(1)));
+    // surface cache memory, only tracked by the Vulkan renderer
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM && is_vulkan && emuenv.renderer->surface_cache_budget > 0)
+        detail_lines.push_back(fmt::format("{}: {}/{} MiB {}: {}", lang["surface_cache"], emuenv.renderer->surface_cache_bytes.load() / MiB(1),
+            emuenv.renderer->surface_cache_budget.load() / MiB(1), lang["evicted"], emuenv.renderer->surface_cache_evictions.load()));
+    // per frame pipeline compilations and the last frame above the stutter threshold, only tracked by the Vulkan renderer
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM && is_vulkan) {
+        const std::lock_guard<std::mutex> guard(emuenv.renderer->pipeline_stats_mutex);
+        const renderer::PipelineStats &stats = emuenv.renderer->pipeline_stats;
+        detail_lines.push_back(fmt::format("{}: {} {}: {} {}: {} ({:.1f} ms) {}: {}", lang["pipelines"], stats.pipeline_hits, lang["misses"], stats.pipeline_misses,
+            lang["sync"], stats.sync_compiles, stats.sync_compile_ms, lang["async"], stats.async_compiles));
+        detail_lines.push_back(fmt::format("{}: {} {}: {} ({:.1f} ms)", lang["shaders"], stats.shader_hits, lang["misses"], stats.shader_misses, stats.shader_retrieve_ms));
+        const renderer::Stutter &stutter = emuenv.renderer->last_stutter;
+        if (stutter.frame_ms > 0.0f)
+            detail_lines.push_back(fmt::format("{}: {:.1f} ms ({})", lang["last_stutter"], stutter.frame_ms, stutter.caused_by_compilation ? lang["compilation"] : lang["other"]));
+    }
+    // per frame ring buffer stalls, only tracked by the OpenGL renderer
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM && !is_vulkan)
+        detail_lines.push_back(fmt::format("{}: {}", lang["ring_buffer_stalls"], emuenv.renderer->ring_buffer_stalls.load()));
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM && emuenv.cfg.performance_overlay_detail != AUDIO_TIMINGS && (emuenv.audio.underrun_count > 0 || emuenv.audio.overrun_count > 0))
+        detail_lines.push_back(fmt::format("{}: {} {}: {}", lang["audio_underruns"], emuenv.audio.underrun_count.load(), lang["overruns"], emuenv.audio.overrun_count.load()));
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM) {
+        const ExclusiveStats exclusive_stats = get_exclusive_stats(emuenv.kernel.exclusive_monitor);
+        if (exclusive_stats.stores > 0)
+            detail_lines.push_back(fmt::format("{}: {} {}: {}", lang["exclusive_stores"], exclusive_stats.stores, lang["failed"], exclusive_stats.failed_stores));
+    }
+    if (emuenv.cfg.performance_overlay_detail >= MAXIMUM && emuenv.renderer->present_latency_ms > 0.0f)
+        detail_lines.push_back(fmt::format("{}: {:.1f} ms", lang["latency"], emuenv.renderer->present_latency_ms.load()));
+    if (emuenv.cfg.performance_overlay_detail == GPU_TIMINGS && is_vulkan) {
+        // the timings are read back a few frames later, ask for the ones of the next frame
+        emuenv.renderer->gpu_timings_requested = true;
+
+        const std::lock_guard<std::mutex> guard(emuenv.renderer->gpu_timings_mutex);
+        const renderer::GpuTimings &timings = emuenv.renderer->gpu_timings;
+        const float total_ms = timings.scene_ms + timings.transfer_ms + timings.surface_sync_ms;
+        detail_lines.push_back(fmt::format("{}: {:.2f} ms ({}: {:.2f} ms {}: {:.2f} ms)", lang["gpu"], total_ms,
+            lang["transfer"], timings.transfer_ms, lang["surface_sync"], timings.surface_sync_ms));
+        detail_lines.push_back(fmt::format("{} ({}): {:.2f} ms", lang["screen_filter"], emuenv.cfg.current_config.screen_filter, emuenv.renderer->screen_filter_gpu_ms.load()));
+        // only show the render targets taking most of the time
+        constexpr size_t max_render_targets = 3;
+        for (size_t i = 0; i < std::min(timings.render_targets.size(), max_render_targets); i++) {
+            const auto &target = timings.render_targets[i];
+            detail_lines.push_back(fmt::format("{}x{}: {:.2f} ms ({} {})", target.width, target.height, target.time_ms, target.scene_count, lang["scenes"]));
+        }
+    }
+    std::vector<frame_timings::Frame> frames;
+    std::array<float, FRAME_HISTOGRAM_BUCKETS> frame_histogram = {};
+    if (emuenv.cfg.performance_overlay_detail == FRAME_TIMINGS) {
+        frames = frame_timings::get_history();
+
+        std::vector<float> frame_times;
+        std::array<float, frame_timings::STAGE_COUNT> stage_avg_ms = {};
+        for (const auto &frame : frames) {
+            frame_times.push_back(frame.total_ms);
+            for (size_t i = 0; i < frame_timings::STAGE_COUNT; i++)
+                stage_avg_ms[i] += frame.stage_ms[i] / frames.size();
+            const auto bucket = std::min(static_cast<int>(frame.total_ms / FRAME_HISTOGRAM_BUCKET_MS), FRAME_HISTOGRAM_BUCKETS - 1);
+            frame_histogram[bucket]++;
+        }
+        std::sort(frame_times.begin(), frame_times.end());
+        const float avg_ms = frame_times.empty() ? 0.f : std::accumulate(frame_times.begin(), frame_times.end(), 0.f) / frame_times.size();
+        const float p99_ms = frame_times.empty() ? 0.f : frame_times[frame_times.size() * 99 / 100];
+
+        detail_lines.push_back(fmt::format("{}: {:.2f} ms (p99: {:.2f} ms)", lang["frame"], avg_ms, p99_ms));
+        detail_lines.push_back(fmt::format("{}: {:.2f} ms {}: {:.2f} ms", lang["guest_cpu"], stage_avg_ms[static_cast<size_t>(frame_timings::Stage::GuestCpu)],
+            lang["render_commands"], stage_avg_ms[static_cast<size_t>(frame_timings::Stage::RenderCommands)]));
+        detail_lines.push_back(fmt::format("{}: {:.2f} ms {}: {:.2f} ms", lang["pipeline_wait"], stage_avg_ms[static_cast<size_t>(frame_timings::Stage::PipelineWait)],
+            lang["texture_upload"], stage_avg_ms[static_cast<size_t>(frame_timings::Stage::TextureUpload)]));
+        detail_lines.push_back(fmt::format("{}: {:.2f} ms {}: {:.2f} ms", lang["surface_sync"], stage_avg_ms[static_cast<size_t>(frame_timings::Stage::SurfaceSync)],
+            lang["present_wait"], stage_avg_ms[static_cast<size_t>(frame_timings::Stage::PresentWait)]));
+    }
+    if (emuenv.cfg.performance_overlay_detail == AUDIO_TIMINGS) {
+        // the loads are refreshed every second, along with the fps
+        detail_lines.push_back(fmt::format("{}: {:.1f}% ({}: {} us)", lang["ngs"], emuenv.audio.ngs_load, lang["max"], emuenv.audio.ngs_update_max_time));
+        detail_lines.push_back(fmt::format("{}: {:.1f}%", lang["decoders"], emuenv.audio.decode_load));
+        detail_lines.push_back(fmt::format("{}: {} ms {}: {} {}: {}", lang["queued"], emuenv.audio.queued_ms.load(),
+            lang["audio_underruns"], emuenv.audio.underrun_count.load(), lang["overruns"], emuenv.audio.overrun_count.load()));
+    }
 
     const ImVec2 TOTAL_WINDOW_PADDING(ImGui::GetStyle().WindowPadding.x * 2, ImGui::GetStyle().WindowPadding.y * 2);
 
-    const auto MAX_TEXT_WIDTH_SCALED = std::max(ImGui::CalcTextSize(FPS_TEXT.c_str()).x, emuenv.cfg.performance_overlay_detail == MINIMUM ? 0.f : ImGui::CalcTextSize(MIN_MAX_FPS_TEXT.c_str()).x) * FONT_SCALE;
-    const auto MAX_TEXT_HEIGHT_SCALED = SCALED_FONT_SIZE + (emuenv.cfg.performance_overlay_detail >= MEDIUM ? SCALED_FONT_SIZE + (ImGui::GetStyle().ItemSpacing.y * 2.f) : 0.f);
+    float max_text_width = ImGui::CalcTextSize(FPS_TEXT.c_str()).x;
+    for (const auto &line : detail_lines)
+        max_text_width = std::max(max_text_width, ImGui::CalcTextSize(line.c_str()).x);
+    const auto MAX_TEXT_WIDTH_SCALED = max_text_width * FONT_SCALE;
+    const auto MAX_TEXT_HEIGHT_SCALED = SCALED_FONT_SIZE + detail_lines.size() * (SCALED_FONT_SIZE + (ImGui::GetStyle().ItemSpacing.y * 2.f));
 
     const ImVec2 WINDOW_SIZE(MAX_TEXT_WIDTH_SCALED + TOTAL_WINDOW_PADDING.x, MAX_TEXT_HEIGHT_SCALED + TOTAL_WINDOW_PADDING.y);
-    const ImVec2 MAIN_WINDOW_SIZE(WINDOW_SIZE.x + TOTAL_WINDOW_PADDING.x, WINDOW_SIZE.y + TOTAL_WINDOW_PADDING.y + (emuenv.cfg.performance_overlay_detail == MAXIMUM ? WINDOW_SIZE.y : 0.f));
+    // the frame timings have the stacked bars and the frame time histogram below the fps graph
+    const float GRAPHS_HEIGHT = emuenv.cfg.performance_overlay_detail == FRAME_TIMINGS ? 3.f * WINDOW_SIZE.y : (emuenv.cfg.performance_overlay_detail >= MAXIMUM ? WINDOW_SIZE.y : 0.f);
+    const ImVec2 MAIN_WINDOW_SIZE(WINDOW_SIZE.x + TOTAL_WINDOW_PADDING.x, WINDOW_SIZE.y + TOTAL_WINDOW_PADDING.y + GRAPHS_HEIGHT);
 
     const auto WINDOW_POS = get_perf_pos(MAIN_WINDOW_SIZE, emuenv);
     ImGui::SetNextWindowSize(MAIN_WINDOW_SIZE);
@@ -75,17 +228,22 @@ void draw_perf_overlay(GuiState &gui, EmuEnvState &emuenv) {
     ImGui::SetWindowFontScale(0.7f * RES_SCALE.y);
 
     ImGui::Text("%s", FPS_TEXT.c_str());
-    if (emuenv.cfg.performance_overlay_detail >= PerformanceOverlayDetail::MEDIUM) {
+    for (const auto &line : detail_lines) {
         ImGui::Separator();
-        ImGui::Text("%s", MIN_MAX_FPS_TEXT.c_str());
+        ImGui::Text("%s", line.c_str());
     }
     ImGui::EndChild();
     ImGui::PopStyleVar();
     ImGui::PopStyleColor();
-    if (emuenv.cfg.performance_overlay_detail == PerformanceOverlayDetail::MAXIMUM) {
+    if (emuenv.cfg.performance_overlay_detail >= PerformanceOverlayDetail::MAXIMUM) {
         ImGui::SetCursorPosY(ImGui::GetCursorPosY() - ImGui::GetStyle().ItemSpacing.y);
         ImGui::PlotLines("##fps_graphic", emuenv.fps_values, IM_ARRAYSIZE(emuenv.fps_values), emuenv.current_fps_offset, nullptr, 0.f, static_cast<float>(emuenv.max_fps), WINDOW_SIZE);
     }
+    if (emuenv.cfg.performance_overlay_detail == FRAME_TIMINGS) {
+        draw_frame_timings_bars(frames, WINDOW_SIZE);
+        // frames slower than the others stand out on the right of the histogram
+        ImGui::PlotHistogram("##frame_histogram", frame_histogram.data(), FRAME_HISTOGRAM_BUCKETS, 0, nullptr, 0.f, FLT_MAX, WINDOW_SIZE);
+    }
     ImGui::End();
     ImGui::PopStyleVar();
 }
@@ -20,6 +20,7 @@
 #include <dialog/state.h>
 #include <gui/functions.h>
 #include <host/dialog/filesystem.h>
+#include <interface.h>
 #include <misc/cpp/imgui_stdlib.h>
 #include <packages/pkg.h>
 #include <packages/sfo.h>
@@ -37,6 +38,10 @@ void draw_pkg_install_dialog(GuiState &gui, EmuEnvState &emuenv) {
     static const auto progress_callback = [&](float updated_progress) {
         progress = updated_progress;
     };
+    static std::atomic<uint64_t> throughput(0);
+    static const auto throughput_callback = [&](uint64_t bytes_per_second) {
+        throughput = bytes_per_second;
+    };
     static fs::path pkg_path{};
     static fs::path license_path{};
     static std::string title, zRIF;
@@ -162,8 +167,11 @@ void draw_pkg_install_dialog(GuiState &gui, EmuEnvState &emuenv) {
             break;
         }
         case State::INSTALL: {
+            throughput = 0;
             std::thread installation([&emuenv]() {
-                if (install_pkg(pkg_path, emuenv, zRIF, progress_callback)) {
+                if (install_pkg(pkg_path, emuenv, zRIF, progress_callback, throughput_callback)) {
+                    if ((emuenv.app_info.app_category.find("gd") != std::string::npos) || (emuenv.app_info.app_category.find("gp") != std::string::npos))
+                        preload_app_shaders(emuenv, emuenv.app_info.app_title_id);
                     std::lock_guard<std::mutex> lock(install_mutex);
                     state = State::SUCCESS;
                 } else {
@@ -238,6 +246,8 @@ void draw_pkg_install_dialog(GuiState &gui, EmuEnvState &emuenv) {
             ImGui::ProgressBar(progress / 100.f, ImVec2(PROGRESS_BAR_WIDTH, 15.f * SCALE.x), "");
             ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 16.f * SCALE.y);
             TextColoredCentered(GUI_COLOR_TEXT, std::to_string(static_cast<uint32_t>(progress)).append("%").c_str());
+            if (throughput > 0)
+                TextColoredCentered(GUI_COLOR_TEXT, fmt::format("{:.1f} MiB/s", throughput / (1024.f * 1024.f)).c_str());
             ImGui::PopStyleColor();
         }
         }
@@ -56,6 +56,8 @@ void draw_lw_condvars_dialog(GuiState &gui, EmuEnvState &emuenv);
 void draw_condvars_dialog(GuiState &gui, EmuEnvState &emuenv);
 void draw_event_flags_dialog(GuiState &gui, EmuEnvState &emuenv);
 void draw_allocations_dialog(GuiState &gui, EmuEnvState &emuenv);
+void draw_io_stats_dialog(GuiState &gui, EmuEnvState &emuenv);
+void draw_hle_profiler_dialog(GuiState &gui, EmuEnvState &emuenv);
 void draw_disassembly_dialog(GuiState &gui, EmuEnvState &emuenv);
 void draw_settings_dialog(GuiState &gui, EmuEnvState &emuenv);
 void draw_overlay_dialog(GuiState &gui, EmuEnvState &emuenv);
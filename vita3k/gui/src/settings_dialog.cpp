@@ -21,6 +21,7 @@
 #include <audio/state.h>
 #include <config/functions.h>
 #include <config/state.h>
+#include <cpu/common.h>
 #include <dialog/state.h>
 #include <display/state.h>
 #include <host/dialog/filesystem.h>
@@ -167,6 +168,7 @@ static bool get_custom_config(EmuEnvState &emuenv, const std::string &app_path)
             if (!config_child.child("cpu").empty()) {
                 const auto cpu_child = config_child.child("cpu");
                 config.cpu_opt = cpu_child.attribute("cpu-opt").as_bool();
+                config.cpu_profile = cpu_child.attribute("cpu-profile").as_string("auto");
             }
 
             // Load GPU Config
@@ -252,6 +254,7 @@ void init_config(GuiState &gui, EmuEnvState &emuenv, const std::string &app_path
     // set up `config` with the values set in the global emulator configuration
     if (!get_custom_config(emuenv, app_path)) {
         config.cpu_opt = emuenv.cfg.cpu_opt;
+        config.cpu_profile = emuenv.cfg.cpu_profile;
         config.modules_mode = emuenv.cfg.modules_mode;
         config.lle_modules = emuenv.cfg.lle_modules;
         config.backend_renderer = emuenv.cfg.backend_renderer;
@@ -345,6 +348,7 @@ static void save_config(GuiState &gui, EmuEnvState &emuenv) {
         // CPU
         auto cpu_child = config_child.append_child("cpu");
         cpu_child.append_attribute("cpu-opt") = config.cpu_opt;
+        cpu_child.append_attribute("cpu-profile") = config.cpu_profile.c_str();
 
         // GPU
         auto gpu_child = config_child.append_child("gpu");
@@ -388,6 +392,7 @@ static void save_config(GuiState &gui, EmuEnvState &emuenv) {
             LOG_ERROR("Failed to save custom config xml for app path: {}, in path: {}", emuenv.app_path, CONFIG_PATH);
     } else {
         emuenv.cfg.cpu_opt = config.cpu_opt;
+        emuenv.cfg.cpu_profile = config.cpu_profile;
         emuenv.cfg.modules_mode = config.modules_mode;
         emuenv.cfg.lle_modules = config.lle_modules;
         emuenv.cfg.backend_renderer = config.backend_renderer;
@@ -453,6 +458,7 @@ void set_current_config(EmuEnvState &emuenv, const std::string &app_path) {
     else {
         // Else inherit the values from the global emulator config
         emuenv.cfg.current_config.cpu_opt = emuenv.cfg.cpu_opt;
+        emuenv.cfg.current_config.cpu_profile = emuenv.cfg.cpu_profile;
         emuenv.cfg.current_config.modules_mode = emuenv.cfg.modules_mode;
         emuenv.cfg.current_config.lle_modules = emuenv.cfg.lle_modules;
         emuenv.cfg.current_config.backend_renderer = emuenv.cfg.backend_renderer;
@@ -659,6 +665,17 @@ void draw_settings_dialog(GuiState &gui, EmuEnvState &emuenv) {
         ImGui::Spacing();
         ImGui::Checkbox(lang.cpu["cpu_opt"].c_str(), &config.cpu_opt);
         SetTooltipEx(lang.cpu["cpu_opt_description"].c_str());
+        if (config.cpu_opt) {
+            std::vector<const char *> profiles = { "auto" };
+            for (const auto &profile : JIT_PROFILES)
+                profiles.push_back(profile.name);
+            int current_profile = static_cast<int>(std::find_if(profiles.begin(), profiles.end(), [](const char *name) { return config.cpu_profile == name; }) - profiles.begin());
+            if (current_profile == static_cast<int>(profiles.size()))
+                current_profile = 0;
+            if (ImGui::Combo(lang.cpu["cpu_profile"].c_str(), &current_profile, profiles.data(), static_cast<int>(profiles.size())))
+                config.cpu_profile = profiles[current_profile];
+            SetTooltipEx(lang.cpu["cpu_profile_description"].c_str());
+        }
         ImGui::EndTabItem();
     } else
         ImGui::PopStyleColor();
@@ -1164,7 +1181,7 @@ void draw_settings_dialog(GuiState &gui, EmuEnvState &emuenv) {
         ImGui::Checkbox(lang.emulator["performance_overlay"].c_str(), &emuenv.cfg.performance_overlay);
         SetTooltipEx(lang.emulator["performance_overlay_description"].c_str());
         if (emuenv.cfg.performance_overlay) {
-            const char *LIST_OVERLAY_DETAIL[] = { lang.emulator["minimum"].c_str(), lang.emulator["low"].c_str(), lang.emulator["medium"].c_str(), lang.emulator["maximum"].c_str() };
+            const char *LIST_OVERLAY_DETAIL[] = { lang.emulator["minimum"].c_str(), lang.emulator["low"].c_str(), lang.emulator["medium"].c_str(), lang.emulator["maximum"].c_str(), lang.emulator["gpu_timings"].c_str(), lang.emulator["audio_timings"].c_str(), lang.emulator["frame_timings"].c_str() };
             ImGui::Combo(lang.emulator["detail"].c_str(), &emuenv.cfg.performance_overlay_detail, LIST_OVERLAY_DETAIL, IM_ARRAYSIZE(LIST_OVERLAY_DETAIL));
             SetTooltipEx(lang.emulator["select_detail"].c_str());
             const char *LIST_OVERLAY_POSITION[] = { lang.emulator["top_left"].c_str(), lang.emulator["top_center"].c_str(), lang.emulator["top_right"].c_str(), lang.emulator["bottom_left"].c_str(), lang.emulator["bottom_center"].c_str(), lang.emulator["bottom_right"].c_str() };
@@ -1451,17 +1468,17 @@ void draw_settings_dialog(GuiState &gui, EmuEnvState &emuenv) {
         ImGui::Spacing();
         if (ImGui::Button(emuenv.kernel.debugger.watch_code ? lang.debug["unwatch_code"].c_str() : lang.debug["watch_code"].c_str())) {
             emuenv.kernel.debugger.watch_code = !emuenv.kernel.debugger.watch_code;
-            emuenv.kernel.debugger.update_watches();
+            emuenv.kernel.debugger.update_watches(emuenv.mem);
         }
         ImGui::SameLine();
         if (ImGui::Button(emuenv.kernel.debugger.watch_memory ? lang.debug["unwatch_memory"].c_str() : lang.debug["watch_memory"].c_str())) {
             emuenv.kernel.debugger.watch_memory = !emuenv.kernel.debugger.watch_memory;
-            emuenv.kernel.debugger.update_watches();
+            emuenv.kernel.debugger.update_watches(emuenv.mem);
         }
         ImGui::SameLine();
         if (ImGui::Button(emuenv.kernel.debugger.watch_import_calls ? lang.debug["unwatch_import_calls"].c_str() : lang.debug["watch_import_calls"].c_str())) {
             emuenv.kernel.debugger.watch_import_calls = !emuenv.kernel.debugger.watch_import_calls;
-            emuenv.kernel.debugger.update_watches();
+            emuenv.kernel.debugger.update_watches(emuenv.mem);
         }
 
 #ifdef TRACY_ENABLE
@@ -63,9 +63,9 @@ void draw_thread_details_dialog(GuiState &gui, EmuEnvState &emuenv) {
 void draw_threads_dialog(GuiState &gui, EmuEnvState &emuenv) {
     ImGui::Begin("Threads", &gui.debug_menu.threads_dialog);
     ImGui::TextColored(GUI_COLOR_TEXT_TITLE,
-        "%-16s %-32s   %-16s   %-16s", "ID", "Thread Name", "Status", "Stack Pointer");
+        "%-16s %-32s   %-16s   %-16s   %-16s", "ID", "Thread Name", "Status", "Stack Pointer", "Callbacks/s");
 
-    const std::lock_guard<std::mutex> lock(emuenv.kernel.mutex);
+    const std::shared_lock<std::shared_mutex> lock(emuenv.kernel.threads_mutex);
 
     for (const auto &[id, th_state] : emuenv.kernel.threads) {
         std::string run_state;
@@ -82,8 +82,8 @@ void draw_threads_dialog(GuiState &gui, EmuEnvState &emuenv) {
         case ThreadStatus::suspend:
             run_state = "Suspended";
         }
-        if (ImGui::Selectable(fmt::format("{:0>8X}         {:<32}   {:<16}   {:0>8X}",
-                id, th_state->name, run_state, th_state->stack.get())
+        if (ImGui::Selectable(fmt::format("{:0>8X}         {:<32}   {:<16}   {:0>8X}           {}",
+                id, th_state->name, run_state, th_state->stack.get(), th_state->callbacks_per_second.load())
                                   .c_str())) {
             gui.thread_watch_index = id;
             gui.debug_menu.thread_details_dialog = true;
@@ -329,25 +329,26 @@ static void get_trophy_list(GuiState &gui, EmuEnvState &emuenv, const std::strin
         }
     }
 
+    std::vector<fs::path> icon_paths;
+    for (const auto &[trophy_id, _] : trophy_info)
+        icon_paths.push_back(trophy_conf_id_path / fmt::format("TROP{}.PNG", trophy_id));
+    const auto icons = load_images(gui, icon_paths);
+
+    auto icon = icons.begin();
     for (const auto &[trophy_id, _] : trophy_info) {
-        int32_t width = 0;
-        int32_t height = 0;
-        vfs::FileBuffer buffer;
+        const auto &image = *icon++;
         const std::string icon_name = fmt::format("TROP{}.PNG", trophy_id);
 
-        vfs::read_file(VitaIoDevice::ux0, buffer, emuenv.pref_path, fmt::format("user/{}/trophy/conf/{}/{}", emuenv.io.user_id, np_com_id, icon_name));
-        if (buffer.empty()) {
+        if (!image) {
             LOG_WARN("Trophy icon, Name: '{}', Not found for trophy id: {}.", icon_name, trophy_id);
             continue;
         }
-        stbi_uc *data = stbi_load_from_memory(&buffer[0], static_cast<int>(buffer.size()), &width, &height, nullptr, STBI_rgb_alpha);
-        if (!data) {
+        if (!image->data) {
             LOG_ERROR("Invalid trophy icon for trophy id {} [{}].", icon_name, trophy_id);
             continue;
         }
 
-        gui.trophy_list[trophy_id] = ImGui_Texture(gui.imgui_state.get(), data, width, height);
-        stbi_image_free(data);
+        gui.trophy_list[trophy_id] = ImGui_Texture(gui.imgui_state.get(), image->data.get(), image->width, image->height);
 
         auto &common = gui.lang.common.main;
         const auto trophy_type = np_com_id_info[np_com_id].context.trophy_kinds[string_utils::stoi_def(trophy_id, 0, "trophy id")];
@@ -47,6 +47,8 @@ bool is_paletted_format(SceGxmTextureBaseFormat base_format);
 bool is_yuv_format(SceGxmTextureBaseFormat base_format);
 uint32_t attribute_format_size(SceGxmAttributeFormat format);
 bool is_stream_instancing(SceGxmIndexSource source);
+// highest index used by a draw, the scan is vectorized when the cpu allows it
+uint32_t get_max_index(const void *indices, uint32_t count, SceGxmIndexFormat format);
 bool convert_color_format_to_texture_format(SceGxmColorFormat format, SceGxmTextureFormat &dest_format);
 
 // Transfer
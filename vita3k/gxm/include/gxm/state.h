@@ -19,7 +19,7 @@
 
 #include <gxm/types.h>
 #include <mem/ptr.h>
-#include <threads/queue.h>
+#include <threads/ring_queue.h>
 
 #include <map>
 #include <mutex>
@@ -50,7 +50,7 @@ struct MemoryMapInfo {
 struct GxmState {
     SceGxmInitializeParams params;
 
-    Queue<DisplayCallback> display_queue;
+    RingQueue<DisplayCallback> display_queue;
     SceUID display_queue_thread;
 
     // global timestamp used by sync objects
@@ -424,6 +424,8 @@ enum SceGxmTextureBaseFormat : uint32_t {
     SCE_GXM_TEXTURE_BASE_FORMAT_ASTC10x10 = 0xFF00000F,
     SCE_GXM_TEXTURE_BASE_FORMAT_ASTC12x10 = 0xFF000010,
     SCE_GXM_TEXTURE_BASE_FORMAT_ASTC12x12 = 0xFF000011,
+    // BCn textures transcoded on upload for GPUs which only support ETC2
+    SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8 = 0xFF000012,
     SCE_GXM_TEXTURE_BASE_FORMAT_INVALID = 0xFFFFFFFF,
 };
 
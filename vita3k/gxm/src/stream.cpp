@@ -15,10 +15,119 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <gxm/functions.h>
 #include <gxm/types.h>
 
+#include <algorithm>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GXM_INDEX_AVX2
+#include <util/instrset_detect.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((__target__("avx2")))
+#include <immintrin.h>
+#else
+#define TARGET_AVX2
+#include <intrin.h>
+#endif
+#endif
+
 namespace gxm {
 bool is_stream_instancing(SceGxmIndexSource source) {
     return (source == SCE_GXM_INDEX_SOURCE_EACH_INSTANCE_16BIT) || (source == SCE_GXM_INDEX_SOURCE_EACH_INSTANCE_32BIT);
 }
+
+template <typename T>
+static uint32_t get_max_index_basic(const T *indices, uint32_t count) {
+    T max_index = 0;
+    for (uint32_t i = 0; i < count; i++)
+        max_index = std::max(max_index, indices[i]);
+    return max_index;
+}
+
+#if defined(__aarch64__)
+static uint32_t get_max_index_u16(const uint16_t *indices, uint32_t count) {
+    uint16x8_t max_vector = vdupq_n_u16(0);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        max_vector = vmaxq_u16(max_vector, vld1q_u16(indices + i));
+
+    return std::max<uint32_t>(vmaxvq_u16(max_vector), get_max_index_basic(indices + i, count - i));
+}
+
+static uint32_t get_max_index_u32(const uint32_t *indices, uint32_t count) {
+    uint32x4_t max_vector = vdupq_n_u32(0);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        max_vector = vmaxq_u32(max_vector, vld1q_u32(indices + i));
+
+    return std::max<uint32_t>(vmaxvq_u32(max_vector), get_max_index_basic(indices + i, count - i));
+}
+#elif defined(GXM_INDEX_AVX2)
+static uint32_t TARGET_AVX2 get_max_index_u16_avx2(const uint16_t *indices, uint32_t count) {
+    __m256i max_vector = _mm256_setzero_si256();
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16)
+        max_vector = _mm256_max_epu16(max_vector, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + i)));
+
+    alignas(32) uint16_t lanes[16];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), max_vector);
+    return std::max(get_max_index_basic(lanes, 16), get_max_index_basic(indices + i, count - i));
+}
+
+static uint32_t TARGET_AVX2 get_max_index_u32_avx2(const uint32_t *indices, uint32_t count) {
+    __m256i max_vector = _mm256_setzero_si256();
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        max_vector = _mm256_max_epu32(max_vector, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + i)));
+
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), max_vector);
+    return std::max(get_max_index_basic(lanes, 8), get_max_index_basic(indices + i, count - i));
+}
+
+// same as in float_to_half, the implementation is chosen the first time it is used
+static uint32_t get_max_index_u16_init(const uint16_t *indices, uint32_t count);
+static uint32_t get_max_index_u32_init(const uint32_t *indices, uint32_t count);
+
+static uint32_t (*get_max_index_u16)(const uint16_t *indices, uint32_t count) = get_max_index_u16_init;
+static uint32_t (*get_max_index_u32)(const uint32_t *indices, uint32_t count) = get_max_index_u32_init;
+
+static void select_max_index_impl() {
+    if (util::instrset::instrset_detect() >= util::instrset::instrset_AVX2) {
+        get_max_index_u16 = get_max_index_u16_avx2;
+        get_max_index_u32 = get_max_index_u32_avx2;
+    } else {
+        get_max_index_u16 = get_max_index_basic<uint16_t>;
+        get_max_index_u32 = get_max_index_basic<uint32_t>;
+    }
+}
+
+uint32_t get_max_index_u16_init(const uint16_t *indices, uint32_t count) {
+    select_max_index_impl();
+    return get_max_index_u16(indices, count);
+}
+
+uint32_t get_max_index_u32_init(const uint32_t *indices, uint32_t count) {
+    select_max_index_impl();
+    return get_max_index_u32(indices, count);
+}
+#else
+static uint32_t get_max_index_u16(const uint16_t *indices, uint32_t count) {
+    return get_max_index_basic(indices, count);
+}
+
+static uint32_t get_max_index_u32(const uint32_t *indices, uint32_t count) {
+    return get_max_index_basic(indices, count);
+}
+#endif
+
+uint32_t get_max_index(const void *indices, uint32_t count, SceGxmIndexFormat format) {
+    if (format == SCE_GXM_INDEX_FORMAT_U16)
+        return get_max_index_u16(static_cast<const uint16_t *>(indices), count);
+    else
+        return get_max_index_u32(static_cast<const uint32_t *>(indices), count);
+}
 } // namespace gxm
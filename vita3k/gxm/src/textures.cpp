@@ -197,6 +197,7 @@ uint32_t bits_per_pixel(SceGxmTextureBaseFormat base_format) {
     case SCE_GXM_TEXTURE_BASE_FORMAT_UBC6H:
     case SCE_GXM_TEXTURE_BASE_FORMAT_SBC6H:
     case SCE_GXM_TEXTURE_BASE_FORMAT_UBC7:
+    case SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8:
         return 8;
     case SCE_GXM_TEXTURE_BASE_FORMAT_YUV420P2:
     case SCE_GXM_TEXTURE_BASE_FORMAT_YUV420P3:
@@ -228,6 +229,7 @@ std::pair<uint32_t, uint32_t> get_block_size(SceGxmTextureBaseFormat base_format
     case SCE_GXM_TEXTURE_BASE_FORMAT_UBC6H:
     case SCE_GXM_TEXTURE_BASE_FORMAT_SBC6H:
     case SCE_GXM_TEXTURE_BASE_FORMAT_UBC7:
+    case SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8:
         return { 4, 4 };
 
     case SCE_GXM_TEXTURE_BASE_FORMAT_PVRT2BPP:
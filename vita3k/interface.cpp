@@ -19,7 +19,9 @@
 
 #include "module/load_module.h"
 
+#include <app/cpu_profile_benchmark.h>
 #include <app/functions.h>
+#include <app/save_state.h>
 #include <audio/state.h>
 #include <config/state.h>
 #include <ctime>
@@ -32,25 +34,34 @@
 #include <gxm/state.h>
 #include <io/functions.h>
 #include <io/vfs.h>
+#include <kernel/load_self.h>
 #include <kernel/state.h>
 #include <packages/functions.h>
 #include <packages/license.h>
 #include <packages/pkg.h>
 #include <packages/sfo.h>
+#include <renderer/shaders.h>
 #include <renderer/state.h>
 #include <renderer/texture_cache.h>
+#include <rtc/rtc.h>
+#include <threads/job_pool.h>
 
 #include <modules/module_parent.h>
 #include <motion/event_handler.h>
 #include <string>
 #include <touch/functions.h>
+#include <util/boot_trace.h>
 #include <util/log.h>
 #include <util/string_utils.h>
 #include <util/vector_utils.h>
 
 #include <gui/imgui_impl_sdl.h>
 
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <regex>
+#include <thread>
 
 #include <SDL3/SDL_events.h>
 #include <SDL3/SDL_system.h>
@@ -79,6 +90,66 @@ static const char *miniz_get_error(const ZipPtr &zip) {
     return mz_zip_get_error_string(mz_zip_get_last_error(zip.get()));
 }
 
+static constexpr size_t ARCHIVE_BUFFER_SIZE = 1024 * 1024;
+
+// miniz keeps the layout of the local file header private
+static constexpr size_t ZIP_LOCAL_HEADER_SIZE = 30;
+static constexpr uint32_t ZIP_LOCAL_HEADER_SIG = 0x04034b50;
+
+static size_t write_to_file(void *pOpaque, mz_uint64 file_ofs, const void *pBuf, size_t n) {
+    return fwrite(pBuf, 1, n, static_cast<FILE *>(pOpaque));
+}
+
+// stored entries are copied from the archive in large blocks, miniz would go through its 64 KiB buffer
+static bool copy_stored_entry(FILE *archive_fp, const mz_zip_archive_file_stat &file_stat, FILE *output_fp, std::vector<uint8_t> &buffer, std::atomic<uint64_t> &extracted_size) {
+    uint8_t local_header[ZIP_LOCAL_HEADER_SIZE];
+    if (fseek(archive_fp, static_cast<int64_t>(file_stat.m_local_header_ofs), SEEK_SET) != 0 || fread(local_header, sizeof(local_header), 1, archive_fp) != 1)
+        return false;
+
+    const auto read_le16 = [&](size_t offset) { return static_cast<uint32_t>(local_header[offset] | (local_header[offset + 1] << 8)); };
+    if ((read_le16(0) | (read_le16(2) << 16)) != ZIP_LOCAL_HEADER_SIG)
+        return false;
+
+    const auto data_offset = file_stat.m_local_header_ofs + ZIP_LOCAL_HEADER_SIZE + read_le16(26) + read_le16(28);
+    if (fseek(archive_fp, static_cast<int64_t>(data_offset), SEEK_SET) != 0)
+        return false;
+
+    mz_ulong crc = MZ_CRC32_INIT;
+    for (uint64_t remaining = file_stat.m_comp_size; remaining != 0;) {
+        const auto size = static_cast<size_t>(std::min<uint64_t>(remaining, buffer.size()));
+        if (fread(buffer.data(), 1, size, archive_fp) != size || fwrite(buffer.data(), 1, size, output_fp) != size)
+            return false;
+        crc = mz_crc32(crc, buffer.data(), size);
+        remaining -= size;
+        extracted_size += size;
+    }
+
+    return crc == file_stat.m_crc32;
+}
+
+static bool extract_archive_entry(const ZipPtr &zip, FILE *archive_fp, mz_uint index, const fs::path &file_output, std::vector<uint8_t> &buffer, std::atomic<uint64_t> &extracted_size) {
+    mz_zip_archive_file_stat file_stat;
+    if (!mz_zip_reader_file_stat(zip.get(), index, &file_stat))
+        return false;
+
+    FILE *output_fp = FOPEN(file_output.c_str(), "wb");
+    if (!output_fp)
+        return false;
+    // the writes reach the disk in large blocks instead of the default stdio buffer size
+    setvbuf(output_fp, nullptr, _IOFBF, ARCHIVE_BUFFER_SIZE);
+
+    bool extracted;
+    if (file_stat.m_method == 0) {
+        extracted = copy_stored_entry(archive_fp, file_stat, output_fp, buffer, extracted_size);
+    } else {
+        extracted = mz_zip_reader_extract_to_callback(zip.get(), index, &write_to_file, output_fp, 0);
+        extracted_size += file_stat.m_uncomp_size;
+    }
+
+    extracted &= fclose(output_fp) == 0;
+    return extracted;
+}
+
 static void set_theme_name(EmuEnvState &emuenv, vfs::FileBuffer &buf) {
     emuenv.app_info.app_title = gui::get_theme_title_from_buffer(buf);
     emuenv.app_info.app_title_id = string_utils::remove_special_chars(emuenv.app_info.app_title);
@@ -133,7 +204,7 @@ static bool set_content_path(EmuEnvState &emuenv, const bool is_theme, fs::path
     return true;
 }
 
-static bool install_archive_content(EmuEnvState &emuenv, GuiState *gui, const ZipPtr &zip, const std::string &content_path, const std::function<void(ArchiveContents)> &progress_callback) {
+static bool install_archive_content(EmuEnvState &emuenv, GuiState *gui, const fs::path &archive_path, const ZipPtr &zip, const std::string &content_path, const std::function<void(ArchiveContents)> &progress_callback) {
     std::string sfo_path = "sce_sys/param.sfo";
     std::string theme_path = "theme.xml";
     vfs::FileBuffer buffer, theme;
@@ -189,6 +260,15 @@ static bool install_archive_content(EmuEnvState &emuenv, GuiState *gui, const Zi
             progress_callback({ {}, {}, { file_progress * 0.7f + decrypt_progress * 0.3f } });
     };
 
+    // the directories are created first, then the files are extracted in parallel,
+    // each worker streams its entries straight to their destination files
+    struct ArchiveEntry {
+        mz_uint index;
+        fs::path file_output;
+    };
+    std::vector<ArchiveEntry> entries;
+    uint64_t total_size = 0;
+
     mz_uint num_files = mz_zip_reader_get_num_files(zip.get());
     for (mz_uint i = 0; i < num_files; i++) {
         mz_zip_archive_file_stat file_stat;
@@ -197,21 +277,74 @@ static bool install_archive_content(EmuEnvState &emuenv, GuiState *gui, const Zi
         }
         const std::string m_filename = file_stat.m_filename;
         if (m_filename.find(content_path) != std::string::npos) {
-            file_progress = static_cast<float>(i) / num_files * 100.0f;
-            update_progress();
-
             std::string replace_filename = m_filename.substr(content_path.size());
             const fs::path file_output = (output_path / fs_utils::utf8_to_path(replace_filename)).generic_path();
-            if (mz_zip_reader_is_file_a_directory(zip.get(), i)) {
+            if (file_stat.m_is_directory) {
                 fs::create_directories(file_output);
             } else {
                 fs::create_directories(file_output.parent_path());
-                LOG_INFO("Extracting {}", file_output);
-                mz_zip_reader_extract_to_file(zip.get(), i, fs_utils::path_to_utf8(file_output).c_str(), 0);
+                entries.push_back({ i, file_output });
+                total_size += file_stat.m_uncomp_size;
             }
         }
     }
 
+    std::atomic<size_t> next_entry = 0;
+    std::atomic<uint64_t> extracted_size = 0;
+    const auto extract_entries = [&]() {
+        // a miniz reader can't be shared between threads, each worker opens the archive on its own
+        FILE *archive_fp = FOPEN(archive_path.c_str(), "rb");
+        if (!archive_fp)
+            return false;
+        const ZipPtr worker_zip(new mz_zip_archive, delete_zip);
+        std::memset(worker_zip.get(), 0, sizeof(*worker_zip));
+        if (!mz_zip_reader_init_cfile(worker_zip.get(), archive_fp, 0, 0)) {
+            fclose(archive_fp);
+            return false;
+        }
+
+        std::vector<uint8_t> buffer(ARCHIVE_BUFFER_SIZE);
+        bool extracted = true;
+        for (size_t i = next_entry++; i < entries.size(); i = next_entry++) {
+            const auto &entry = entries[i];
+            LOG_INFO("Extracting {}", entry.file_output);
+            if (!extract_archive_entry(worker_zip, archive_fp, entry.index, entry.file_output, buffer, extracted_size)) {
+                LOG_ERROR("miniz error: {} extracting file: {}", miniz_get_error(worker_zip), entry.file_output);
+                extracted = false;
+            }
+        }
+
+        worker_zip.reset();
+        fclose(archive_fp);
+        return extracted;
+    };
+
+    // inflating is the bottleneck for compressed archives, a few threads are enough to reach the storage speed
+    const auto nb_workers = std::min<size_t>(std::clamp(std::thread::hardware_concurrency(), 1U, 4U), entries.size());
+    JobPool pool;
+    pool.start(static_cast<int>(nb_workers));
+    std::vector<std::future<bool>> results;
+    for (size_t i = 0; i < nb_workers; i++)
+        results.push_back(pool.submit(extract_entries));
+
+    bool extracted = true;
+    for (auto &result : results) {
+        while (result.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+            file_progress = total_size ? extracted_size.load() * 100.f / total_size : 0.f;
+            update_progress();
+        }
+        extracted &= result.get();
+    }
+    pool.stop();
+
+    if (!extracted) {
+        LOG_ERROR("Failed to extract the archive contents to {}", output_path);
+        fs::remove_all(output_path);
+        return false;
+    }
+    file_progress = 100.f;
+    update_progress();
+
     if (fs::exists(output_path / "sce_sys/package/") && emuenv.app_info.app_title_id.starts_with("PCS")) {
         update_progress();
         if (is_nonpdrm(emuenv, output_path))
@@ -226,6 +359,9 @@ static bool install_archive_content(EmuEnvState &emuenv, GuiState *gui, const Zi
 
     LOG_INFO("{} [{}] installed successfully!", emuenv.app_info.app_title, emuenv.app_info.app_title_id);
 
+    if ((emuenv.app_info.app_category.find("gd") != std::string::npos) || (emuenv.app_info.app_category.find("gp") != std::string::npos))
+        preload_app_shaders(emuenv, emuenv.app_info.app_title_id);
+
     if (!gui->file_menu.archive_install_dialog && (emuenv.app_info.app_category != "theme")) {
         gui::update_notice_info(*gui, emuenv, "content");
         if ((emuenv.app_info.app_category.find("gd") != std::string::npos) || (emuenv.app_info.app_category.find("gp") != std::string::npos)) {
@@ -303,7 +439,7 @@ std::vector<ContentInfo> install_archive(EmuEnvState &emuenv, GuiState *gui, con
     for (auto &path : content_path) {
         current++;
         update_progress();
-        bool state = install_archive_content(emuenv, gui, zip, path, progress_callback);
+        bool state = install_archive_content(emuenv, gui, archive_path, zip, path, progress_callback);
         // Can't use emplace_back due to Clang 15 for macos
         content_installed.push_back({ emuenv.app_info.app_title, emuenv.app_info.app_title_id, emuenv.app_info.app_category, emuenv.app_info.app_content_id, path, state });
     }
@@ -367,6 +503,7 @@ static bool install_content(EmuEnvState &emuenv, GuiState *gui, const fs::path &
     if ((emuenv.app_info.app_category.find("gd") != std::string::npos) || (emuenv.app_info.app_category.find("gp") != std::string::npos)) {
         gui::init_user_app(*gui, emuenv, emuenv.app_info.app_title_id);
         gui::save_apps_cache(*gui, emuenv);
+        preload_app_shaders(emuenv, emuenv.app_info.app_title_id);
     }
 
     if (emuenv.app_info.app_category != "theme")
@@ -394,14 +531,72 @@ uint32_t install_contents(EmuEnvState &emuenv, GuiState *gui, const fs::path &pa
     return installed;
 }
 
+void preload_app_shaders(EmuEnvState &emuenv, const std::string &title_id) {
+    if (!emuenv.cfg.preload_shaders || !emuenv.cfg.shader_cache || !emuenv.renderer)
+        return;
+
+    std::thread preload([&emuenv, title_id]() {
+        const auto start = std::chrono::steady_clock::now();
+        const fs::path app_path = emuenv.pref_path / "ux0/app" / title_id;
+
+        // the GXP programs are either in their own files or embedded in the executables
+        std::vector<std::vector<uint8_t>> binaries;
+        for (const auto &entry : fs::recursive_directory_iterator(app_path)) {
+            const fs::path &path = entry.path();
+            if (!fs::is_regular_file(path))
+                continue;
+
+            const std::string extension = string_utils::tolower(path.extension().string());
+            const bool is_self = (path.filename() == "eboot.bin") || (extension == ".suprx") || (extension == ".self");
+            if (!is_self && (extension != ".gxp"))
+                continue;
+
+            std::vector<uint8_t> data;
+            if (!fs_utils::read_data(path, data))
+                continue;
+
+            if (is_self) {
+                for (auto &segment : read_self_segments(data))
+                    binaries.push_back(std::move(segment));
+            } else {
+                binaries.push_back(std::move(data));
+            }
+        }
+
+        const fs::path shaders_path = emuenv.renderer->cache_path / "shaders" / title_id / "eboot.bin";
+        const fs::path shaders_log_path = emuenv.renderer->log_path / "shaderlog" / title_id / "eboot.bin";
+        const uint32_t count = renderer::build_app_shader_cache(*emuenv.renderer, binaries, shaders_path, shaders_log_path);
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        LOG_INFO_IF(count > 0, "Preloaded {} shaders of {} in {} ms", count, title_id, elapsed.count());
+    });
+    preload.detach();
+}
+
 static ExitCode load_app_impl(SceUID &main_module_id, EmuEnvState &emuenv) {
     const auto call_import = [&emuenv](CPUState &cpu, uint32_t nid, SceUID thread_id) {
         ::call_import(emuenv, cpu, nid, thread_id);
     };
-    if (!emuenv.kernel.init(emuenv.mem, call_import, emuenv.kernel.cpu_opt)) {
+    const auto call_import_slot = [&emuenv](CPUState &cpu, uint32_t slot, SceUID thread_id) {
+        ::call_import_slot(emuenv, cpu, slot, thread_id);
+    };
+    if (!emuenv.kernel.init(emuenv.mem, call_import, call_import_slot, emuenv.kernel.cpu_opt)) {
         LOG_WARN("Failed to init kernel!");
         return KernelInitFailed;
     }
+    emuenv.kernel.jit_optimizations = app::get_cpu_profile_optimizations(emuenv);
+    emuenv.kernel.cpu_pool.enabled = emuenv.cfg.shared_jit_cache;
+    emuenv.kernel.thread_block_pool.max_size = static_cast<size_t>(std::max(emuenv.cfg.thread_block_pool_size, 0)) * MiB(1);
+    emuenv.kernel.libc_heap.use_slabs = emuenv.cfg.hle_malloc_slabs;
+    if (!emuenv.kernel.host_thread_policy.set_core_sets(emuenv.cfg.host_core_sets))
+        LOG_WARN("Host core sets are ignored");
+    emuenv.kernel.host_thread_policy.mirror_priority = emuenv.cfg.mirror_thread_priority;
+    emuenv.kernel.host_thread_policy.native_priority = emuenv.cfg.thread_priority_policy == "native";
+    emuenv.kernel.spin_loop_fast_forward = emuenv.cfg.spin_loop_fast_forward;
+    if (emuenv.cfg.fast_forward_speed.has_value()) {
+        rtc_set_speed(*emuenv.cfg.fast_forward_speed);
+        LOG_INFO("Fast forward: the clock of the app runs {}x faster than real time", *emuenv.cfg.fast_forward_speed);
+    }
 
     if (emuenv.cfg.archive_log) {
         const fs::path log_directory{ emuenv.log_path / "logs" };
@@ -448,6 +643,7 @@ static ExitCode load_app_impl(SceUID &main_module_id, EmuEnvState &emuenv) {
 
     init_device_paths(emuenv.io);
     init_savedata_app_path(emuenv.io, emuenv.pref_path);
+    index_app_files(emuenv.io, emuenv.pref_path);
 
     // Load param.sfo
     vfs::FileBuffer param_sfo;
@@ -456,6 +652,20 @@ static ExitCode load_app_impl(SceUID &main_module_id, EmuEnvState &emuenv) {
 
     init_exported_vars(emuenv);
 
+    // the modules the app loaded the last time are read while the first ones are loaded and started
+    if (emuenv.cfg.prefetch_boot_modules)
+        prefetch_boot_modules(emuenv);
+
+    // the font libraries are preloaded for every application but few of them use these,
+    // their modules are only loaded and relocated at the first call to one of their functions
+    if (emuenv.cfg.lazy_load_modules) {
+        for (const auto &[library_name, module_name] : { std::pair{ "SceFt2", "libSceFt2" }, std::pair{ "ScePvf", "libpvf" } }) {
+            const auto module_name_file = fmt::format("{}.suprx", module_name);
+            if (is_lle_module(module_name, emuenv) && fs::exists(emuenv.pref_path / "vs0/sys/external" / module_name_file))
+                defer_module_load(emuenv, library_name, fmt::format("vs0:sys/external/{}", module_name_file));
+        }
+    }
+
     // Load main executable
     emuenv.self_path = !emuenv.cfg.self_path.empty() ? emuenv.cfg.self_path : EBOOT_PATH;
     main_module_id = load_module(emuenv, "app0:" + emuenv.self_path);
@@ -467,6 +677,10 @@ static ExitCode load_app_impl(SceUID &main_module_id, EmuEnvState &emuenv) {
     // Set self name from self path, can contain folder, get file name only
     emuenv.self_name = fs::path(emuenv.self_path).filename().string();
 
+    emuenv.kernel.jit_block_cache.enabled = emuenv.cfg.jit_block_cache;
+    if (emuenv.cfg.jit_block_cache)
+        emuenv.kernel.jit_block_cache.load(emuenv.cache_path / "jit" / emuenv.io.title_id / emuenv.self_name / "blocks.dat");
+
     // get list of preload modules
     SceUInt32 process_preload_disabled = 0;
     auto process_param = emuenv.kernel.process_param.get(emuenv.mem);
@@ -486,8 +700,11 @@ static ExitCode load_app_impl(SceUID &main_module_id, EmuEnvState &emuenv) {
                 const auto module_name_file = fmt::format("{}.suprx", name);
                 if (load_from_app && fs::exists(module_app_path / module_name_file))
                     lib_load_list.emplace_back(fmt::format("app0:sce_module/{}", module_name_file));
-                else if (fs::exists(emuenv.pref_path / "vs0/sys/external" / module_name_file))
-                    lib_load_list.emplace_back(fmt::format("vs0:sys/external/{}", module_name_file));
+                else if (fs::exists(emuenv.pref_path / "vs0/sys/external" / module_name_file)) {
+                    const auto module_path = fmt::format("vs0:sys/external/{}", module_name_file);
+                    if (!is_module_load_deferred(emuenv, module_path))
+                        lib_load_list.emplace_back(module_path);
+                }
             }
 
             if (module_id != SCE_SYSMODULE_INVALID)
@@ -534,12 +751,14 @@ static std::vector<uint32_t> get_current_app_frame(EmuEnvState &emuenv, uint32_t
         return {};
     }
 
+    return frame;
+}
+
+static void force_opaque(std::vector<uint32_t> &frame) {
     // Force alpha channel to 255 (fully opaque) for every pixel
     for (uint32_t &pixel : frame) {
         pixel |= 0xFF000000;
     }
-
-    return frame;
 }
 
 static void update_live_area_last_app_frame(EmuEnvState &emuenv, GuiState &gui) {
@@ -551,11 +770,17 @@ static void update_live_area_last_app_frame(EmuEnvState &emuenv, GuiState &gui)
         LOG_ERROR("Failed to dump current app frame for live area");
         return;
     }
+    force_opaque(frame);
 
     // Create and assign a new texture with the captured frame
     gui.live_area_last_app_frame = ImGui_Texture(gui.imgui_state.get(), frame.data(), width, height);
 }
 
+// a single state per app, saving a new one replaces it
+static fs::path get_save_state_path(EmuEnvState &emuenv) {
+    return emuenv.shared_path / "savestates" / fmt::format("{}.v3kstate", emuenv.io.title_id);
+}
+
 static void take_screenshot(EmuEnvState &emuenv) {
     if (emuenv.cfg.screenshot_format == None)
         return;
@@ -573,7 +798,6 @@ static void take_screenshot(EmuEnvState &emuenv) {
     }
 
     const fs::path save_folder = emuenv.shared_path / "screenshots" / fmt::format("{}", string_utils::remove_special_chars(emuenv.current_app_title));
-    fs::create_directories(save_folder);
 
     auto t = std::time(nullptr);
     struct tm localtime;
@@ -583,20 +807,31 @@ static void take_screenshot(EmuEnvState &emuenv) {
     localtime_r(&t, &localtime);
 #endif
 
-    const auto img_format = emuenv.cfg.screenshot_format == JPEG ? ".jpg" : ".png";
+    const bool is_jpeg = emuenv.cfg.screenshot_format == JPEG;
+    const auto img_format = is_jpeg ? ".jpg" : ".png";
     const fs::path save_file = save_folder / fmt::format("{}_{:%Y-%m-%d-%H%M%OS}{}", string_utils::remove_special_chars(emuenv.current_app_title), localtime, img_format);
-    constexpr int quality = 85; // google recommended value
-    if (emuenv.cfg.screenshot_format == JPEG) {
-        if (stbi_write_jpg(fs_utils::path_to_utf8(save_file).c_str(), width, height, 4, frame.data(), quality) == 1)
-            LOG_INFO("Successfully saved screenshot to {}", save_file);
-        else
-            LOG_INFO("Failed to save screenshot");
-    } else {
-        if (stbi_write_png(fs_utils::path_to_utf8(save_file).c_str(), width, height, 4, frame.data(), width * 4) == 1)
-            LOG_INFO("Successfully saved screenshot to {}", save_file);
-        else
-            LOG_INFO("Failed to save screenshot");
-    }
+
+    // only the readback has to be done here, encoding a frame takes long enough to drop a few of them
+    // a single worker keeps the screenshots in order, the pending ones are still saved on exit
+    static JobPool screenshot_encoder;
+    screenshot_encoder.start(1);
+    screenshot_encoder.submit([frame = std::move(frame), width, height, is_jpeg, save_folder, save_file]() mutable {
+        force_opaque(frame);
+        fs::create_directories(save_folder);
+
+        constexpr int quality = 85; // google recommended value
+        if (is_jpeg) {
+            if (stbi_write_jpg(fs_utils::path_to_utf8(save_file).c_str(), width, height, 4, frame.data(), quality) == 1)
+                LOG_INFO("Successfully saved screenshot to {}", save_file);
+            else
+                LOG_INFO("Failed to save screenshot");
+        } else {
+            if (stbi_write_png(fs_utils::path_to_utf8(save_file).c_str(), width, height, 4, frame.data(), width * 4) == 1)
+                LOG_INFO("Successfully saved screenshot to {}", save_file);
+            else
+                LOG_INFO("Failed to save screenshot");
+        }
+    });
 }
 
 bool handle_events(EmuEnvState &emuenv, GuiState &gui) {
@@ -774,6 +1009,10 @@ bool handle_events(EmuEnvState &emuenv, GuiState &gui) {
                 toggle_texture_replacement(emuenv);
             if ((event.key.scancode == emuenv.cfg.keyboard_take_screenshot || event.key.scancode == emuenv.cfg.keyboard_take_screenshot_alt) && !gui.is_key_capture_dropped)
                 take_screenshot(emuenv);
+            if ((event.key.scancode == emuenv.cfg.keyboard_save_state || event.key.scancode == emuenv.cfg.keyboard_save_state_alt) && !gui.is_key_capture_dropped)
+                app::save_state(emuenv, get_save_state_path(emuenv));
+            if ((event.key.scancode == emuenv.cfg.keyboard_load_state || event.key.scancode == emuenv.cfg.keyboard_load_state_alt) && !gui.is_key_capture_dropped)
+                app::load_state(emuenv, get_save_state_path(emuenv));
             if ((event.key.scancode == emuenv.cfg.keyboard_pinch_modifier || event.key.scancode == emuenv.cfg.keyboard_pinch_modifier_alt || event.key.scancode == emuenv.cfg.keyboard_alternate_pinch_in || event.key.scancode == emuenv.cfg.keyboard_alternate_pinch_in_alt || event.key.scancode == emuenv.cfg.keyboard_alternate_pinch_out || event.key.scancode == emuenv.cfg.keyboard_alternate_pinch_out_alt) && !gui.is_key_capture_dropped)
                 pinch_modifier(true);
 
@@ -885,6 +1124,7 @@ bool handle_events(EmuEnvState &emuenv, GuiState &gui) {
 }
 
 ExitCode load_app(int32_t &main_module_id, EmuEnvState &emuenv) {
+    const boot_trace::Span span("load_app");
     if (load_app_impl(main_module_id, emuenv) != Success) {
         std::string message = fmt::format(fmt::runtime(emuenv.common_dialog.lang.message["load_app_failed"]), emuenv.pref_path / "ux0/app" / emuenv.io.app_path / emuenv.self_path);
         app::error_dialog(message, emuenv.window.get());
@@ -916,6 +1156,7 @@ static std::vector<std::string> split(const std::string &input, const std::strin
 }
 
 ExitCode run_app(EmuEnvState &emuenv, int32_t main_module_id) {
+    const boot_trace::Span span("run_app");
     auto entry_point = emuenv.kernel.loaded_modules[main_module_id]->info.start_entry;
     auto process_param = emuenv.kernel.process_param.get(emuenv.mem);
 
@@ -944,6 +1185,7 @@ ExitCode run_app(EmuEnvState &emuenv, int32_t main_module_id) {
         return InitThreadFailed;
     }
     emuenv.main_thread_id = main_thread->id;
+    main_thread->is_main_thread = true;
 
     // Run `module_start` export (entry point) of loaded libraries
     for (auto &[_, module] : emuenv.kernel.loaded_modules) {
@@ -24,6 +24,7 @@
 
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
 struct GuiState;
@@ -55,6 +56,8 @@ bool handle_events(EmuEnvState &emuenv, GuiState &gui);
 
 std::vector<ContentInfo> install_archive(EmuEnvState &emuenv, GuiState *gui, const fs::path &archive_path, const std::function<void(ArchiveContents)> &progress_callback = nullptr);
 uint32_t install_contents(EmuEnvState &emuenv, GuiState *gui, const fs::path &path);
+// build the shader cache of a newly installed app in the background
+void preload_app_shaders(EmuEnvState &emuenv, const std::string &title_id);
 
 ExitCode load_app(int32_t &main_module_id, EmuEnvState &emuenv);
 ExitCode run_app(EmuEnvState &emuenv, int32_t main_module_id);
@@ -17,7 +17,15 @@
 
 #pragma once
 
-#include <util/log.h>
+#include <util/fs.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // Credits to relan for their original work on this https://github.com/relan/exfat
 
@@ -94,6 +102,11 @@ enum ExFATAttrib {
     EXFAT_ATTRIB_ARCH = 0x20
 };
 
+enum ExFATFlag {
+    EXFAT_FLAG_ALWAYS1 = 0x01,
+    EXFAT_FLAG_CONTIGUOUS = 0x02
+};
+
 enum ExFATEntryType {
     EXFAT_ENTRY_VALID = 0x80,
     EXFAT_ENTRY_CONTINUED = 0x40,
@@ -109,5 +122,93 @@ enum ExFATEntryType {
 };
 
 namespace exfat {
-void extract_exfat(const fs::path &partition_path, const std::string &partition, const fs::path &pref_path);
+
+/**
+ * @brief Read-only access to the files of an exFAT image, without extracting them
+ *
+ * The directory tree is indexed once when the image is opened. The reads of the files can come from any thread,
+ * the small ones go through a cache of the blocks of the image so that the reads which share a block only read it once.
+ */
+class Image {
+public:
+    struct Entry {
+        std::string name;
+        bool is_dir = false;
+        uint64_t size = 0;
+        // clusters of the data, in order
+        std::vector<uint32_t> clusters;
+        // indexes of the entries of a directory
+        std::vector<uint32_t> children;
+        // in the FAT format
+        uint16_t crdate = 0, crtime = 0;
+        uint16_t mdate = 0, mtime = 0;
+        uint16_t adate = 0, atime = 0;
+    };
+
+    Image(const Image &) = delete;
+    Image &operator=(const Image &) = delete;
+
+    // the images are indexed once and shared, nullptr if the image does not exist or is not valid
+    static std::shared_ptr<Image> open(const fs::path &path);
+    // forget the shared image, its file is closed once it is not used anymore and can then be replaced
+    static void release(const fs::path &path);
+
+    // path relative to the root of the image, the case is ignored like on exFAT; an empty path is the root
+    const Entry *find(std::string path) const;
+    const Entry &get_entry(uint32_t index) const { return entries[index]; }
+    // returns the number of bytes read
+    size_t read(const Entry &entry, void *data, size_t size, uint64_t offset);
+
+private:
+    struct CachedBlock {
+        uint64_t index;
+        std::vector<char> data;
+    };
+
+    Image() = default;
+
+    bool load(const fs::path &path);
+    void index_directory(uint32_t dir_index, const std::string &dir_path);
+    std::vector<uint32_t> get_clusters(uint32_t first_cluster, uint64_t size, bool contiguous) const;
+    uint64_t get_cluster_offset(uint32_t cluster) const;
+    // called with the lock held once the image is loaded
+    bool read_image(uint64_t offset, char *data, uint64_t size);
+    const CachedBlock *get_cached_block(uint64_t index);
+    bool read_raw(uint64_t offset, char *data, uint64_t size);
+
+    ExFATSuperBlock super_block{};
+    uint64_t cluster_size = 0;
+    uint64_t image_size = 0;
+    std::vector<uint32_t> fat;
+    // the root is the first entry
+    std::vector<Entry> entries;
+    // lowercase path -> entry
+    std::unordered_map<std::string, uint32_t> index;
+
+    std::mutex mutex;
+    fs::ifstream image;
+    // most recently used first
+    std::list<CachedBlock> cached_blocks;
+    std::unordered_map<uint64_t, std::list<CachedBlock>::iterator> cached_block_index;
+};
+
+// File of an image, it is read like a MappedFile
+class ImageFile {
+    std::shared_ptr<Image> image;
+    const Image::Entry *entry;
+    uint64_t currentPos = 0;
+
+public:
+    ImageFile(std::shared_ptr<Image> image, const Image::Entry &entry);
+
+    uint64_t tell() const { return currentPos; }
+    uint64_t size() const { return entry->size; }
+    const Image::Entry &get_entry() const { return *entry; }
+
+    size_t read(void *ibuf, size_t size);
+    // does not move the current position
+    size_t read_at(void *ibuf, size_t size, uint64_t offset) const;
+    bool seek(int64_t offset, int origin);
+};
+
 } // namespace exfat
@@ -17,7 +17,10 @@
 
 #pragma once
 
+#include <util/fs.h>
+
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 class ReadOnlyInMemFile {
@@ -40,3 +43,36 @@ public:
     const char *data();
     bool seek(int offset, int origin);
 };
+
+// Whole host file mapped in memory, reads are a copy from the mapping
+// The file must not be modified while it is mapped
+class MappedFile {
+    const char *mapping = nullptr;
+    size_t mapping_size = 0;
+    size_t currentPos = 0;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // fails for empty files, which can't be mapped
+    bool map(const fs::path &path);
+
+    size_t tell() const { return currentPos; }
+    size_t size() const { return mapping_size; }
+
+    bool valid() const { return mapping != nullptr; }
+    operator bool() const { return valid(); }
+
+    size_t read(void *ibuf, size_t size);
+    // does not move the current position
+    size_t read_at(void *ibuf, size_t size, size_t offset) const;
+    const char *data() const { return mapping; }
+    bool seek(int64_t offset, int origin);
+};
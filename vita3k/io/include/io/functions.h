@@ -34,6 +34,8 @@ struct IOState;
 inline SceUID invalid_fd = -1;
 
 void init_device_paths(IOState &io);
+// build the case-insensitive index of the application files
+void index_app_files(IOState &io, const fs::path &pref_path);
 bool init_savedata_app_path(IOState &io, const fs::path &pref_path);
 bool init(IOState &io, const fs::path &cache_path, const fs::path &log_path, const fs::path &pref_path, bool redirect_stdio);
 
@@ -41,6 +43,8 @@ bool find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &tra
 fs::path find_in_cache(IOState &io, const std::string &system_path);
 
 fs::path expand_path(IOState &io, const char *path, const fs::path &pref_path);
+// size of the files below a directory, only computed the first time it is asked for
+uint64_t get_directory_used_size(IOState &io, const VitaIoDevice device, const std::string &vfs_path, const fs::path &pref_path);
 std::string translate_path(const char *path, VitaIoDevice &device, const IOState::DevicePaths &device_paths);
 
 /**
@@ -68,13 +72,20 @@ bool copy_path(const fs::path &src_path, const fs::path &pref_path, const std::s
 
 SceUID open_file(IOState &io, const char *path, const int flags, const fs::path &pref_path, const char *export_name);
 int read_file(void *data, IOState &io, SceUID fd, SceSize size, const char *export_name);
-int write_file(SceUID fd, const void *data, SceSize size, const IOState &io, const char *export_name);
+int write_file(SceUID fd, const void *data, SceSize size, IOState &io, const char *export_name);
+// read and write at the given offset without moving the position of the file
+int read_file_at(void *data, IOState &io, SceUID fd, SceSize size, SceOff offset, const char *export_name);
+int write_file_at(SceUID fd, const void *data, SceSize size, SceOff offset, IOState &io, const char *export_name);
 int truncate_file(SceUID fd, unsigned long long length, const IOState &io, const char *export_name);
 SceOff seek_file(SceUID fd, SceOff offset, SceIoSeekMode whence, IOState &io, const char *export_name);
 SceOff tell_file(IOState &io, const SceUID fd, const char *export_name);
 int stat_file(IOState &io, const char *file, SceIoStat *statp, const fs::path &pref_path, const char *export_name, SceUID fd = invalid_fd);
 int stat_file_by_fd(IOState &io, const SceUID fd, SceIoStat *statp, const fs::path &pref_path, const char *export_name);
 int close_file(IOState &io, SceUID fd, const char *export_name);
+// flush the writes of a file to the host
+int sync_file(IOState &io, SceUID fd, const char *export_name);
+// flush the writes of the files of a device to the host
+int sync_files(IOState &io, const char *device, const char *export_name);
 int remove_file(IOState &io, const char *file, const fs::path &pref_path, const char *export_name);
 int rename(IOState &io, const char *old_name, const char *new_name, const fs::path &pref_path, const char *export_name);
 
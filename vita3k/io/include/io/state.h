@@ -17,31 +17,38 @@
 
 #pragma once
 
+#include <io/exfat.h>
+#include <io/file.h>
 #include <io/filesystem.h>
+#include <io/stats.h>
 #include <io/types.h>
 #include <io/util.h>
 
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 
 // Class for all needed information to access files on Vita3K.
 class FileStats : public VitaStats {
+    // buffer given to the host file of the writable files, it must outlive the file pointer
+    std::shared_ptr<char[]> write_buffer;
     // Shared file pointer
     FilePtr wrapped_file;
+    // used instead of the file pointer for the read-only files which could be mapped
+    std::shared_ptr<MappedFile> mapped_file;
+    // used instead of the file pointer for the files read from a device image
+    std::shared_ptr<exfat::ImageFile> image_file;
+    // copy of the file which is written instead of it, renamed over it on close
+    fs::path temp_file;
+    // size of the writable files when they were opened, see get_size_at_open
+    uint64_t size_at_open = 0;
 
 public:
     // Constructor used for files
     // Based on https://codereview.stackexchange.com/questions/4679/
-    explicit FileStats(const char *vita, const std::string &t, const fs::path &file, const int open) {
-        wrapped_file = create_shared_file(file, open);
-
-        file_info.vita_loc = vita;
-        file_info.translated = t;
-        file_info.sys_loc = file;
-        file_info.open_mode = open;
-        file_info.file_mode = SCE_SO_IFREG | SCE_SO_IROTH;
-        file_info.access_mode = SCE_S_IFREG;
-    }
+    explicit FileStats(const char *vita, const std::string &t, const fs::path &file, const int open, const bool map_file = false, const size_t write_buffer_size = 0, const bool write_to_temp = false);
+    // Constructor used for the files of a device image, they are read-only
+    FileStats(const char *vita, const std::string &t, const fs::path &image_path, std::shared_ptr<exfat::ImageFile> file);
 
     bool is_regular_file() const {
         return file_info.file_mode & SCE_SO_IFREG;
@@ -60,22 +67,47 @@ public:
         return wrapped_file.get();
     }
 
+    const exfat::ImageFile *get_image_file() const {
+        return image_file.get();
+    }
+
+    uint64_t get_size_at_open() const {
+        return size_at_open;
+    }
+
+    // location of the host file actually read and written
+    const fs::path &get_host_location() const {
+        return temp_file.empty() ? get_system_location() : temp_file;
+    }
+
     // File functions
     SceOff read(void *input_data, int element_size, SceSize element_count) const;
     SceOff write(const void *data, SceSize size, int count) const;
+    // positional versions, the position of the file is left untouched
+    SceOff read_at(void *data, SceSize size, SceOff offset) const;
+    SceOff write_at(const void *data, SceSize size, SceOff offset) const;
     int truncate(const SceSize size) const;
     bool seek(SceOff offset, SceIoSeekMode seek_mode) const;
     SceOff tell() const;
+    bool flush() const;
+    // close the host file, and replace the file with its written copy if there is one
+    bool close();
 };
 
-// Class for implementing Directory structure; path names are wide for Windows, normal for else
+// Entry of a directory with its stat data
+struct DirEntry {
+    std::string name;
+    SceIoStat stat;
+};
+
+// Class for implementing Directory structure; the entries are listed once when the directory is opened
 class DirStats : public VitaStats {
-    // Shared directory pointer
-    DirPtr dir_ptr;
+    std::shared_ptr<std::vector<DirEntry>> entries;
+    size_t next_entry = 0;
 
 public:
-    DirStats(const char *vita, const std::string &t, const fs::path &file, DirPtr ptr) {
-        dir_ptr = std::move(ptr);
+    DirStats(const char *vita, const std::string &t, const fs::path &file, std::vector<DirEntry> dir_entries) {
+        entries = std::make_shared<std::vector<DirEntry>>(std::move(dir_entries));
 
         file_info.vita_loc = vita;
         file_info.translated = t;
@@ -85,8 +117,11 @@ public:
         file_info.access_mode = SCE_S_IFDIR | SCE_S_IRUSR;
     }
 
-    auto get_dir_ptr() const {
-        return get_system_dir_ptr(dir_ptr);
+    // nullptr once all the entries were read
+    const DirEntry *read_entry() {
+        if (next_entry >= entries->size())
+            return nullptr;
+        return &(*entries)[next_entry++];
     }
 
     bool is_directory() const {
@@ -121,9 +156,27 @@ struct IOState {
     StdFiles std_files;
     DirEntries dir_entries;
 
+    // lowercase host path -> host path of the files in the directories below
     std::unordered_map<std::string, std::string> cachemap;
+    // directories already added to cachemap
+    std::unordered_set<std::string> case_isens_scanned_dirs;
     bool case_isens_find_enabled = false;
 
+    struct TranslatedPath {
+        std::string normalized_path;
+        fs::path system_path;
+    };
+    // guest path -> host path of the files which were opened, see add_translation
+    std::unordered_map<std::string, TranslatedPath> translation_cache;
+    // map the files opened read-only from app0 and pd0 in memory
+    bool map_app_files = false;
+    // size of the buffer of the writable files, 0 keeps the default buffering of the host
+    size_t write_buffer_size = 0;
+    // host directory -> size of the files below it, kept up to date when they are written or removed
+    std::unordered_map<std::string, uint64_t> used_size_cache;
+
+    IoStats stats;
+
     std::mutex overlay_mutex;
     SceUID next_overlay_id = 1;
     // overlay in the order they should be applied
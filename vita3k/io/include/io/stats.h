@@ -0,0 +1,88 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+enum class IoOp {
+    Open,
+    Read,
+    Seek,
+    Write,
+    Close,
+    Count
+};
+
+const char *get_io_op_name(IoOp op);
+
+/**
+ * @brief Counters of the file operations of the application
+ *
+ * Each operation is counted for the device and for the directory of the file, with the bytes
+ * it moved and its latency. The latencies are kept in a histogram with power of two buckets
+ * in microseconds, so that the slow operations are not hidden by the average.
+ * Nothing is recorded unless the statistics are enabled.
+ */
+class IoStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // bucket i counts the latencies below 2^i us, the last one counts the rest
+    static constexpr size_t NB_LATENCY_BUCKETS = 16;
+
+    struct OpStats {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+        uint64_t total_us = 0;
+        std::array<uint64_t, NB_LATENCY_BUCKETS> latency_buckets = {};
+
+        // upper bound of the bucket in which the given share of the operations ended, in us
+        uint64_t get_latency_percentile(double share) const;
+    };
+
+    using PathStats = std::array<OpStats, static_cast<size_t>(IoOp::Count)>;
+
+    bool enabled = false;
+
+    // returns a default time point when the statistics are disabled, it is ignored by record
+    Clock::time_point start() const {
+        return enabled ? Clock::now() : Clock::time_point{};
+    }
+
+    // path is the normalized path of the file (ux0:/app/...)
+    void record(IoOp op, const std::string &path, uint64_t bytes, Clock::time_point start);
+    void reset();
+
+    // copies of the statistics per device and per directory, for display
+    std::map<std::string, PathStats> get_device_stats();
+    std::map<std::string, PathStats> get_directory_stats();
+
+    bool save_report(const fs::path &path);
+
+private:
+    std::mutex mutex;
+    std::map<std::string, PathStats> device_stats;
+    std::map<std::string, PathStats> directory_stats;
+};
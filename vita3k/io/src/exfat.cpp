@@ -0,0 +1,320 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/exfat.h>
+#include <io/types.h>
+
+#include <util/log.h>
+#include <util/string_utils.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace exfat {
+
+static constexpr uint64_t CACHE_BLOCK_SIZE = 64 * 1024;
+static constexpr size_t MAX_CACHED_BLOCKS = 128;
+
+static constexpr uint32_t FIRST_CLUSTER = 2;
+static constexpr uint64_t ENTRY_SIZE = 32;
+
+static std::mutex images_mutex;
+static std::map<std::string, std::shared_ptr<Image>> images;
+
+std::shared_ptr<Image> Image::open(const fs::path &path) {
+    const std::lock_guard<std::mutex> guard(images_mutex);
+    const auto image = images.find(path.string());
+    if (image != images.end())
+        return image->second;
+
+    if (!fs::exists(path))
+        return nullptr;
+
+    std::shared_ptr<Image> opened(new Image());
+    if (!opened->load(path)) {
+        LOG_ERROR("{} is not a valid exFAT image", path);
+        opened.reset();
+    }
+
+    // an invalid image is not loaded again until it is released
+    images.emplace(path.string(), opened);
+    return opened;
+}
+
+void Image::release(const fs::path &path) {
+    const std::lock_guard<std::mutex> guard(images_mutex);
+    images.erase(path.string());
+}
+
+uint64_t Image::get_cluster_offset(const uint32_t cluster) const {
+    return (static_cast<uint64_t>(super_block.cluster_sector_start) << super_block.sector_bits) + static_cast<uint64_t>(cluster - FIRST_CLUSTER) * cluster_size;
+}
+
+bool Image::read_raw(const uint64_t offset, char *data, const uint64_t size) {
+    if (offset > image_size || size > image_size - offset)
+        return false;
+
+    image.clear();
+    image.seekg(static_cast<std::streamoff>(offset));
+    image.read(data, static_cast<std::streamsize>(size));
+    return static_cast<uint64_t>(image.gcount()) == size;
+}
+
+std::vector<uint32_t> Image::get_clusters(const uint32_t first_cluster, const uint64_t size, const bool contiguous) const {
+    std::vector<uint32_t> clusters;
+    const uint32_t end_cluster = FIRST_CLUSTER + super_block.cluster_count;
+    if (first_cluster < FIRST_CLUSTER || first_cluster >= end_cluster)
+        return clusters;
+
+    const uint64_t cluster_count = (size + cluster_size - 1) / cluster_size;
+    if (contiguous) {
+        for (uint64_t i = 0; (i < cluster_count) && (first_cluster + i < end_cluster); i++)
+            clusters.push_back(static_cast<uint32_t>(first_cluster + i));
+        return clusters;
+    }
+
+    // the size of the root directory is not known, its chain is followed to the end
+    // a chain longer than the image is a loop
+    for (uint32_t cluster = first_cluster; (cluster >= FIRST_CLUSTER) && (cluster < end_cluster) && (cluster < fat.size()); cluster = fat[cluster]) {
+        if (((size != 0) && (clusters.size() >= cluster_count)) || (clusters.size() >= super_block.cluster_count))
+            break;
+        clusters.push_back(cluster);
+    }
+
+    return clusters;
+}
+
+void Image::index_directory(const uint32_t dir_index, const std::string &dir_path) {
+    const std::vector<uint32_t> dir_clusters = entries[dir_index].clusters;
+    std::vector<char> data(dir_clusters.size() * cluster_size);
+    for (size_t i = 0; i < dir_clusters.size(); i++) {
+        if (!read_raw(get_cluster_offset(dir_clusters[i]), data.data() + i * cluster_size, cluster_size)) {
+            LOG_ERROR("Cannot read the directory {} of the exFAT image", dir_path);
+            return;
+        }
+    }
+
+    for (uint64_t pos = 0; pos + ENTRY_SIZE <= data.size(); pos += ENTRY_SIZE) {
+        const uint8_t type = static_cast<uint8_t>(data[pos]);
+        // the end of the directory
+        if (type == 0)
+            break;
+        if (type != EXFAT_ENTRY_FILE)
+            continue;
+
+        ExFATFileEntry file_entry;
+        memcpy(&file_entry, data.data() + pos, sizeof(file_entry));
+        // the continuations are the info entry followed by the name entries
+        if ((file_entry.continuations < 2) || (pos + (file_entry.continuations + 1) * ENTRY_SIZE > data.size()))
+            continue;
+
+        ExFATFileEntryInfo file_info;
+        memcpy(&file_info, data.data() + pos + ENTRY_SIZE, sizeof(file_info));
+        if (file_info.type != EXFAT_ENTRY_FILE_INFO)
+            continue;
+
+        std::u16string name;
+        for (uint32_t cont = 2; (cont <= file_entry.continuations) && (name.size() < file_info.name_length); cont++) {
+            ExFATEntryName name_entry;
+            memcpy(&name_entry, data.data() + pos + cont * ENTRY_SIZE, sizeof(name_entry));
+            if (name_entry.type != EXFAT_ENTRY_FILE_NAME)
+                break;
+
+            const size_t copy_char_count = std::min<size_t>(file_info.name_length - name.size(), EXFAT_ENAME_MAX);
+            name.insert(name.end(), name_entry.name, name_entry.name + copy_char_count);
+        }
+        pos += file_entry.continuations * ENTRY_SIZE;
+
+        Entry entry;
+        entry.name = string_utils::utf16_to_utf8(name);
+        entry.is_dir = file_entry.attrib & EXFAT_ATTRIB_DIR;
+        entry.size = file_info.size;
+        entry.clusters = get_clusters(file_info.start_cluster, file_info.size, file_info.flags & EXFAT_FLAG_CONTIGUOUS);
+        entry.crdate = file_entry.crdate;
+        entry.crtime = file_entry.crtime;
+        entry.mdate = file_entry.mdate;
+        entry.mtime = file_entry.mtime;
+        entry.adate = file_entry.adate;
+        entry.atime = file_entry.atime;
+
+        const std::string path = dir_path.empty() ? entry.name : dir_path + '/' + entry.name;
+        const auto entry_index = static_cast<uint32_t>(entries.size());
+        const bool is_dir = entry.is_dir;
+        entries.push_back(std::move(entry));
+        entries[dir_index].children.push_back(entry_index);
+        index.emplace(string_utils::tolower(path), entry_index);
+
+        if (is_dir)
+            index_directory(entry_index, path);
+    }
+}
+
+bool Image::load(const fs::path &path) {
+    image.open(path, std::ios::binary);
+    if (!image.is_open())
+        return false;
+
+    image_size = fs::file_size(path);
+    if (image_size < sizeof(ExFATSuperBlock))
+        return false;
+    image.read(reinterpret_cast<char *>(&super_block), sizeof(ExFATSuperBlock));
+
+    if ((memcmp(super_block.oem_name, "EXFAT   ", sizeof(super_block.oem_name)) != 0) || (super_block.boot_signature != 0xAA55)
+        || (super_block.sector_bits < 9) || (super_block.sector_bits > 12) || (super_block.spc_bits > 25 - super_block.sector_bits))
+        return false;
+    cluster_size = 1ULL << (super_block.sector_bits + super_block.spc_bits);
+
+    // the whole FAT is kept, it is only needed for the files which are not contiguous
+    fat.resize(FIRST_CLUSTER + static_cast<uint64_t>(super_block.cluster_count));
+    const uint64_t fat_size = std::min<uint64_t>(fat.size() * sizeof(uint32_t), static_cast<uint64_t>(super_block.fat_sector_count) << super_block.sector_bits);
+    if (!read_raw(static_cast<uint64_t>(super_block.fat_sector_start) << super_block.sector_bits, reinterpret_cast<char *>(fat.data()), fat_size))
+        return false;
+
+    entries.emplace_back();
+    entries[0].is_dir = true;
+    entries[0].clusters = get_clusters(super_block.rootdir_cluster, 0, false);
+    index.emplace(std::string{}, 0);
+    index_directory(0, {});
+
+    LOG_INFO("Indexed {} entries of the exFAT image {}", entries.size() - 1, path);
+    return true;
+}
+
+const Image::Entry *Image::find(std::string path) const {
+    std::replace(path.begin(), path.end(), '\\', '/');
+    while (!path.empty() && (path.front() == '/'))
+        path.erase(0, 1);
+    while (!path.empty() && (path.back() == '/'))
+        path.pop_back();
+
+    const auto entry = index.find(string_utils::tolower(path));
+    return (entry != index.end()) ? &entries[entry->second] : nullptr;
+}
+
+const Image::CachedBlock *Image::get_cached_block(const uint64_t block_index) {
+    const auto cached = cached_block_index.find(block_index);
+    if (cached != cached_block_index.end()) {
+        cached_blocks.splice(cached_blocks.begin(), cached_blocks, cached->second);
+        return &*cached->second;
+    }
+
+    // the last block of the image can be shorter
+    const uint64_t offset = block_index * CACHE_BLOCK_SIZE;
+    std::vector<char> data(CACHE_BLOCK_SIZE);
+    if (!read_raw(offset, data.data(), std::min(CACHE_BLOCK_SIZE, image_size - std::min(offset, image_size))))
+        return nullptr;
+
+    if (cached_blocks.size() >= MAX_CACHED_BLOCKS) {
+        cached_block_index.erase(cached_blocks.back().index);
+        cached_blocks.pop_back();
+    }
+    cached_blocks.push_front({ block_index, std::move(data) });
+    cached_block_index.emplace(block_index, cached_blocks.begin());
+    return &cached_blocks.front();
+}
+
+bool Image::read_image(uint64_t offset, char *data, uint64_t size) {
+    while (size > 0) {
+        const uint64_t offset_in_block = offset % CACHE_BLOCK_SIZE;
+        if ((offset_in_block == 0) && (size >= CACHE_BLOCK_SIZE)) {
+            // the whole blocks are read directly, the cache is for the small reads which share blocks
+            const uint64_t direct_size = size - size % CACHE_BLOCK_SIZE;
+            if (!read_raw(offset, data, direct_size))
+                return false;
+            offset += direct_size;
+            data += direct_size;
+            size -= direct_size;
+            continue;
+        }
+
+        const CachedBlock *block = get_cached_block(offset / CACHE_BLOCK_SIZE);
+        if (!block)
+            return false;
+        const uint64_t copy_size = std::min(size, CACHE_BLOCK_SIZE - offset_in_block);
+        memcpy(data, block->data.data() + offset_in_block, copy_size);
+        offset += copy_size;
+        data += copy_size;
+        size -= copy_size;
+    }
+
+    return true;
+}
+
+size_t Image::read(const Entry &entry, void *data, size_t size, const uint64_t offset) {
+    if (entry.is_dir || (offset >= entry.size))
+        return 0;
+    size = static_cast<size_t>(std::min<uint64_t>(size, entry.size - offset));
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    char *output = static_cast<char *>(data);
+    size_t done = 0;
+    while (done < size) {
+        const uint64_t pos = offset + done;
+        const uint64_t first = pos / cluster_size;
+        if (first >= entry.clusters.size())
+            break;
+
+        // the clusters which follow each other in the image are read at once
+        uint64_t last = first;
+        uint64_t run_size = cluster_size - pos % cluster_size;
+        while ((run_size < size - done) && (last + 1 < entry.clusters.size()) && (entry.clusters[last + 1] == entry.clusters[last] + 1)) {
+            last++;
+            run_size += cluster_size;
+        }
+        run_size = std::min<uint64_t>(run_size, size - done);
+
+        if (!read_image(get_cluster_offset(entry.clusters[first]) + pos % cluster_size, output + done, run_size))
+            break;
+        done += run_size;
+    }
+
+    return done;
+}
+
+ImageFile::ImageFile(std::shared_ptr<Image> image, const Image::Entry &entry)
+    : image(std::move(image))
+    , entry(&entry) {
+}
+
+size_t ImageFile::read(void *ibuf, size_t size) {
+    const size_t res = read_at(ibuf, size, currentPos);
+    currentPos += res;
+
+    return res;
+}
+
+size_t ImageFile::read_at(void *ibuf, size_t size, uint64_t offset) const {
+    return image->read(*entry, ibuf, size, offset);
+}
+
+bool ImageFile::seek(int64_t offset, int origin) {
+    int64_t base = 0;
+    if (origin == SCE_SEEK_CUR)
+        base = static_cast<int64_t>(currentPos);
+    else if (origin == SCE_SEEK_END)
+        base = static_cast<int64_t>(entry->size);
+
+    // like with the host file functions, seeking past the end is allowed
+    if (base + offset < 0)
+        return false;
+
+    currentPos = static_cast<uint64_t>(base + offset);
+    return true;
+}
+
+} // namespace exfat
@@ -18,6 +18,22 @@
 #include <io/file.h>
 #include <io/types.h>
 
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// reads larger than this ask the host to fetch the pages of the whole range at once
+static constexpr size_t PREFETCH_MIN_SIZE = 64 * 1024;
+#endif
+
 ReadOnlyInMemFile::ReadOnlyInMemFile() = default;
 
 ReadOnlyInMemFile::ReadOnlyInMemFile(const char *data, size_t size)
@@ -64,3 +80,114 @@ bool ReadOnlyInMemFile::seek(int offset, int origin) {
     currentPos = buf.size() + offset;
     return true;
 }
+
+MappedFile::~MappedFile() {
+    if (!mapping)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+#else
+    munmap(const_cast<char *>(mapping), mapping_size);
+#endif
+}
+
+bool MappedFile::map(const fs::path &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE file_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file_mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    mapping = static_cast<const char *>(MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mapping) {
+        CloseHandle(file_mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    mapping_handle = file_mapping;
+    mapping_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the file is closed
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    mapping = static_cast<const char *>(data);
+    mapping_size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+    currentPos = 0;
+    return true;
+}
+
+size_t MappedFile::read(void *ibuf, size_t size) {
+    const size_t res = read_at(ibuf, size, currentPos);
+    currentPos += res;
+
+    return res;
+}
+
+size_t MappedFile::read_at(void *ibuf, size_t size, size_t offset) const {
+    if (offset >= mapping_size)
+        return 0;
+
+    const size_t res = std::min(size, mapping_size - offset);
+#ifndef _WIN32
+    if (res >= PREFETCH_MIN_SIZE) {
+        // the range given to madvise must start on a page boundary
+        const uintptr_t page_mask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+        const uintptr_t start = reinterpret_cast<uintptr_t>(mapping + offset) & ~page_mask;
+        madvise(reinterpret_cast<void *>(start), reinterpret_cast<uintptr_t>(mapping + offset + res) - start, MADV_WILLNEED);
+    }
+#endif
+
+    // unlike the host file functions, a write fault on the guest buffer is handled like any other guest access
+    memcpy(ibuf, mapping + offset, res);
+
+    return res;
+}
+
+bool MappedFile::seek(int64_t offset, int origin) {
+    if (!valid())
+        return false;
+
+    int64_t base = 0;
+    if (origin == SCE_SEEK_CUR)
+        base = static_cast<int64_t>(currentPos);
+    else if (origin == SCE_SEEK_END)
+        base = static_cast<int64_t>(mapping_size);
+
+    // like with the host file functions, seeking past the end is allowed
+    if (base + offset < 0)
+        return false;
+
+    currentPos = static_cast<size_t>(base + offset);
+    return true;
+}
@@ -26,6 +26,7 @@
 #include <rtc/rtc.h>
 #include <util/log.h>
 #include <util/preprocessor.h>
+#include <util/profile.h>
 #include <util/string_utils.h>
 
 #ifdef _WIN32
@@ -62,11 +63,26 @@ constexpr bool log_file_read = false;
 constexpr bool log_file_seek = false;
 constexpr bool log_file_stat = false;
 
+// the content of a device can be kept as an exFAT image next to its directory (pd0.img for pd0:), which is read in place
+// the files of the directory come first
+static std::shared_ptr<exfat::Image> get_device_image(const VitaIoDevice device, const fs::path &pref_path) {
+    return exfat::Image::open(pref_path / fmt::format("{}.img", device._to_string()));
+}
+
 namespace vfs {
 
 bool read_file(const VitaIoDevice device, FileBuffer &buf, const fs::path &pref_path, const fs::path &vfs_file_path) {
     const auto host_file_path = device::construct_emulated_path(device, vfs_file_path, pref_path).generic_path();
-    return fs_utils::read_data(host_file_path, buf);
+    if (fs_utils::read_data(host_file_path, buf))
+        return true;
+
+    const auto image = get_device_image(device, pref_path);
+    const auto entry = image ? image->find(vfs_file_path.generic_path().string()) : nullptr;
+    if (!entry || entry->is_dir || (entry->size == 0))
+        return false;
+
+    buf.resize(entry->size);
+    return image->read(*entry, buf.data(), buf.size(), 0) == buf.size();
 }
 
 bool read_app_file(FileBuffer &buf, const fs::path &pref_path, const std::string &app_path, const fs::path &vfs_file_path) {
@@ -131,6 +147,23 @@ void init_device_paths(IOState &io) {
     io.device_paths.savedata0 = "user/" + io.user_id + "/savedata/" + io.savedata;
     io.device_paths.app0 = "app/" + io.app_path;
     io.device_paths.addcont0 = "addcont/" + io.addcont;
+
+    // the translations depend on the device paths
+    io.translation_cache.clear();
+    io.used_size_cache.clear();
+}
+
+void index_app_files(IOState &io, const fs::path &pref_path) {
+    if (!io.case_isens_find_enabled)
+        return;
+
+    // done once at boot so that the first file which is not found with its exact case doesn't pay for it
+    const std::string app_root = device::construct_emulated_path(VitaIoDevice::ux0, io.device_paths.app0, pref_path, false).string();
+    if (!fs::exists(app_root) || !io.case_isens_scanned_dirs.insert(app_root).second)
+        return;
+
+    for (const auto &file : fs::recursive_directory_iterator(app_root))
+        io.cachemap.emplace(string_utils::tolower(file.path().string()), file.path().string());
 }
 
 bool init_savedata_app_path(IOState &io, const fs::path &pref_path) {
@@ -170,9 +203,15 @@ bool find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &tra
     }
     }
 
+    if (final_path.ends_with('/'))
+        final_path.pop_back();
     if (!fs::exists(final_path))
         return false;
 
+    // the index is kept up to date when files are created, renamed or removed, a directory is only scanned once
+    if (!io.case_isens_scanned_dirs.insert(final_path).second)
+        return true;
+
     for (const auto &file : fs::recursive_directory_iterator(final_path)) {
         io.cachemap.emplace(string_utils::tolower(file.path().string()), file.path().string());
     }
@@ -190,6 +229,63 @@ fs::path find_in_cache(IOState &io, const std::string &system_path) {
     }
 }
 
+// the translations are all dropped when the cache is full, most applications only use a few hundred files
+static constexpr size_t MAX_TRANSLATION_CACHE_SIZE = 4096;
+
+static void add_translation(IOState &io, const char *path, const std::string &normalized_path, const fs::path &system_path) {
+    if (io.translation_cache.size() >= MAX_TRANSLATION_CACHE_SIZE)
+        io.translation_cache.clear();
+    io.translation_cache.insert_or_assign(path, IOState::TranslatedPath{ normalized_path, system_path });
+}
+
+// add a path created by the application, and its parent directories, to the case-insensitive index
+static void add_created_path(IOState &io, const fs::path &system_path) {
+    if (!io.case_isens_find_enabled)
+        return;
+
+    for (fs::path path = system_path; !path.empty(); path = path.parent_path()) {
+        if (!io.cachemap.emplace(string_utils::tolower(path.string()), path.string()).second)
+            break;
+    }
+}
+
+// forget a path which was removed or renamed, along with everything below it
+static void remove_cached_paths(IOState &io, const fs::path &system_path) {
+    io.translation_cache.clear();
+    if (!io.case_isens_find_enabled)
+        return;
+
+    const std::string removed = string_utils::tolower(system_path.string());
+    std::erase_if(io.cachemap, [&](const auto &entry) {
+        const std::string &path = entry.first;
+        return path.starts_with(removed) && (path.size() == removed.size() || path[removed.size()] == '/');
+    });
+}
+
+// apply the change of size of a file to the cached used sizes of the directories it is in
+static void update_used_size(IOState &io, const fs::path &system_path, const int64_t size_change) {
+    if (size_change == 0)
+        return;
+
+    const std::string path = system_path.string();
+    for (auto &[dir, used_size] : io.used_size_cache) {
+        if (path.starts_with(dir) && (path.size() > dir.size()) && (path[dir.size()] == '/'))
+            used_size += size_change;
+    }
+}
+
+uint64_t get_directory_used_size(IOState &io, const VitaIoDevice device, const std::string &vfs_path, const fs::path &pref_path) {
+    const auto dir_path = device::construct_emulated_path(device, vfs_path, pref_path).remove_trailing_separator().string();
+    const auto cached_size = io.used_size_cache.find(dir_path);
+    if (cached_size != io.used_size_cache.end())
+        return cached_size->second;
+
+    // the directory is only walked the first time, the size is then updated when its files change
+    const uint64_t used_size = vfs::get_directory_used_size(device, vfs_path, pref_path);
+    io.used_size_cache.emplace(dir_path, used_size);
+    return used_size;
+}
+
 std::string translate_path(const char *path, VitaIoDevice &device, const IOState::DevicePaths &device_paths) {
     auto relative_path = device::remove_duplicate_device(path, device);
 
@@ -281,6 +377,8 @@ fs::path expand_path(IOState &io, const char *path, const fs::path &pref_path) {
 }
 
 SceUID open_file(IOState &io, const char *path, const int flags, const fs::path &pref_path, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     auto device = device::get_device(path);
     auto device_for_icase = device;
     if (device == VitaIoDevice::_INVALID) {
@@ -304,67 +402,103 @@ SceUID open_file(IOState &io, const char *path, const int flags, const fs::path
         return fd;
     }
 
-    const auto translated_path = translate_path(path, device, io.device_paths);
-    if (translated_path.empty()) {
-        LOG_ERROR("Cannot translate path: {}", path);
-        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-    }
+    const auto start = io.stats.start();
+    std::string normalized_path;
+    fs::path system_path;
+    const auto cached_translation = io.translation_cache.find(path);
+    if (cached_translation != io.translation_cache.end() && fs::exists(cached_translation->second.system_path)) {
+        normalized_path = cached_translation->second.normalized_path;
+        system_path = cached_translation->second.system_path;
+    } else {
+        const auto translated_path = translate_path(path, device, io.device_paths);
+        if (translated_path.empty()) {
+            LOG_ERROR("Cannot translate path: {}", path);
+            return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+        }
 
-    auto system_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
-    if (fs::is_directory(system_path)) {
-        LOG_ERROR("Cannot open directory: {}", system_path);
-        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-    }
+        system_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
+        if (fs::is_directory(system_path)) {
+            LOG_ERROR("Cannot open directory: {}", system_path);
+            return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+        }
 
-    // Do not allow any new files if they do not have a write flag.
-    if (!fs::exists(system_path)) {
-        if (!(flags & SCE_O_CREAT)) {
-            if (io.case_isens_find_enabled) {
-                // Attempt a case-insensitive file search.
-                const auto original_system_path = system_path;
-                const auto cached_path = find_in_cache(io, string_utils::tolower(system_path.string()));
-                if (!cached_path.empty()) {
-                    system_path = cached_path;
-                    LOG_TRACE("Found cached filepath at {}", system_path);
-                } else {
-                    const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, system_path);
-                    system_path = find_in_cache(io, string_utils::tolower(system_path.string()));
-                    if (!system_path.empty() && path_found) {
-                        LOG_TRACE("Found file on case-sensitive filesystem at {}", system_path);
+        // Do not allow any new files if they do not have a write flag.
+        if (!fs::exists(system_path)) {
+            const bool read_only = !(flags & (SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC | SCE_O_APPEND));
+            const auto image = read_only ? get_device_image(device, pref_path) : nullptr;
+            const auto image_entry = image ? image->find(translated_path) : nullptr;
+            if (image_entry && !image_entry->is_dir) {
+                normalized_path = device::construct_normalized_path(device, translated_path);
+                const FileStats f{ path, normalized_path, system_path, std::make_shared<exfat::ImageFile>(image, *image_entry) };
+                const auto fd = io.next_fd++;
+                io.std_files.emplace(fd, f);
+                io.stats.record(IoOp::Open, normalized_path, 0, start);
+
+                LOG_TRACE_IF(log_file_op, "{}: Opening file {} ({}) from the device image, fd: {}", export_name, path, normalized_path, log_hex(fd));
+                return fd;
+            }
+
+            if (!(flags & SCE_O_CREAT)) {
+                if (io.case_isens_find_enabled) {
+                    // Attempt a case-insensitive file search.
+                    const auto original_system_path = system_path;
+                    const auto cached_path = find_in_cache(io, string_utils::tolower(system_path.string()));
+                    if (!cached_path.empty()) {
+                        system_path = cached_path;
+                        LOG_TRACE("Found cached filepath at {}", system_path);
                     } else {
-                        LOG_ERROR("Missing file at {} (target path: {})", original_system_path, path);
-                        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+                        const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, system_path);
+                        system_path = find_in_cache(io, string_utils::tolower(system_path.string()));
+                        if (!system_path.empty() && path_found) {
+                            LOG_TRACE("Found file on case-sensitive filesystem at {}", system_path);
+                        } else {
+                            LOG_ERROR("Missing file at {} (target path: {})", original_system_path, path);
+                            return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+                        }
                     }
+                } else {
+                    LOG_ERROR("Missing file at {} (target path: {})", system_path, path);
+                    return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
                 }
             } else {
-                LOG_ERROR("Missing file at {} (target path: {})", system_path, path);
-                return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-            }
-        } else {
-            if (!fs::exists(system_path.parent_path())) {
-                fs::create_directories(system_path.parent_path());
+                if (!fs::exists(system_path.parent_path())) {
+                    fs::create_directories(system_path.parent_path());
+                }
+                fs::ofstream file(system_path);
+                add_created_path(io, system_path);
             }
-            fs::ofstream file(system_path);
         }
-    }
 
-    const auto normalized_path = device::construct_normalized_path(device, translated_path);
+        normalized_path = device::construct_normalized_path(device, translated_path);
+        add_translation(io, path, normalized_path, system_path);
+    }
 
-    FileStats f{ path, normalized_path, system_path, flags };
+    // the application files are never modified while it is running
+    // translate_path redirects app0 to ux0, check the device of the guest path
+    const bool is_app_file = (device_for_icase == VitaIoDevice::app0) || (device_for_icase == VitaIoDevice::pd0);
+    const bool map_file = io.map_app_files && is_app_file && !(flags & (SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC | SCE_O_APPEND));
+    // the savedata is written to a copy which replaces it on close, so that it is never left half written
+    const bool is_savedata_file = normalized_path.starts_with("ux0:") && (normalized_path.find("/savedata/") != std::string::npos);
+    FileStats f{ path, normalized_path, system_path, flags, map_file, io.write_buffer_size, is_savedata_file };
     const auto fd = io.next_fd++;
     io.std_files.emplace(fd, f);
+    io.stats.record(IoOp::Open, normalized_path, 0, start);
 
     LOG_TRACE_IF(log_file_op, "{}: Opening file {} ({}), fd: {}", export_name, path, normalized_path, log_hex(fd));
     return fd;
 }
 
 int read_file(void *data, IOState &io, const SceUID fd, const SceSize size, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     assert(data != nullptr);
     assert(size >= 0);
 
     const auto file = io.std_files.find(fd);
     if (file != io.std_files.end()) {
+        const auto start = io.stats.start();
         const auto read = file->second.read(data, 1, size);
+        io.stats.record(IoOp::Read, file->second.get_translated_path(), read, start);
         LOG_TRACE_IF(log_file_op && log_file_read, "{}: Reading {} bytes of fd {}", export_name, read, log_hex(fd));
         return static_cast<int>(read);
     }
@@ -382,7 +516,9 @@ int read_file(void *data, IOState &io, const SceUID fd, const SceSize size, cons
     return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 }
 
-int write_file(SceUID fd, const void *data, const SceSize size, const IOState &io, const char *export_name) {
+int write_file(SceUID fd, const void *data, const SceSize size, IOState &io, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     assert(data != nullptr);
     assert(size >= 0);
 
@@ -419,7 +555,9 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
     }
 
     if (file->second.can_write_file()) {
+        const auto start = io.stats.start();
         const auto written = file->second.write(data, 1, size);
+        io.stats.record(IoOp::Write, file->second.get_translated_path(), written, start);
         LOG_TRACE_IF(log_file_op, "{}: Writing to fd: {}, size: {}", export_name, log_hex(fd), size);
         return static_cast<int>(written);
     }
@@ -427,6 +565,51 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
     return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 }
 
+int read_file_at(void *data, IOState &io, const SceUID fd, const SceSize size, const SceOff offset, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
+    assert(data != nullptr);
+
+    const auto file = io.std_files.find(fd);
+    if (file == io.std_files.end())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    const auto start = io.stats.start();
+    const auto read = file->second.read_at(data, size, offset);
+    if (read < 0)
+        return IO_ERROR_UNK();
+
+    io.stats.record(IoOp::Read, file->second.get_translated_path(), read, start);
+    LOG_TRACE_IF(log_file_op && log_file_read, "{}: Reading {} bytes of fd {} at offset {}", export_name, read, log_hex(fd), offset);
+    return static_cast<int>(read);
+}
+
+int write_file_at(SceUID fd, const void *data, const SceSize size, const SceOff offset, IOState &io, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
+    assert(data != nullptr);
+
+    const auto file = io.std_files.find(fd);
+    if (file == io.std_files.end())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    if (!fs::is_directory(file->second.get_system_location().parent_path())) {
+        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT); // TODO: Is it the right error code?
+    }
+
+    if (!file->second.can_write_file())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    const auto start = io.stats.start();
+    const auto written = file->second.write_at(data, size, offset);
+    if (written < 0)
+        return IO_ERROR_UNK();
+
+    io.stats.record(IoOp::Write, file->second.get_translated_path(), written, start);
+    LOG_TRACE_IF(log_file_op, "{}: Writing to fd: {}, size: {}, offset: {}", export_name, log_hex(fd), size, offset);
+    return static_cast<int>(written);
+}
+
 int truncate_file(const SceUID fd, unsigned long long length, const IOState &io, const char *export_name) {
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
@@ -440,6 +623,8 @@ int truncate_file(const SceUID fd, unsigned long long length, const IOState &io,
 }
 
 SceOff seek_file(const SceUID fd, const SceOff offset, const SceIoSeekMode whence, IOState &io, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     if (!(whence == SCE_SEEK_SET || whence == SCE_SEEK_CUR || whence == SCE_SEEK_END))
         return IO_ERROR(SCE_ERROR_ERRNO_EOPNOTSUPP);
 
@@ -449,8 +634,10 @@ SceOff seek_file(const SceUID fd, const SceOff offset, const SceIoSeekMode whenc
     const auto file = io.std_files.find(fd);
     if (file == io.std_files.end())
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+    const auto start = io.stats.start();
     if (!file->second.seek(offset, whence))
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+    io.stats.record(IoOp::Seek, file->second.get_translated_path(), 0, start);
 
     const auto log_mode = [](const SceIoSeekMode whence) -> const char * {
         switch (whence) {
@@ -479,7 +666,83 @@ SceOff tell_file(IOState &io, const SceUID fd, const char *export_name) {
     return std_file->second.tell();
 }
 
+// fill the stat data of a host file, returns -1 if it can't be statted
+static int stat_host_file(const fs::path &file_path, SceIoStat *statp) {
+    std::uint64_t last_access_time_ticks;
+    std::uint64_t creation_time_ticks;
+    std::uint64_t last_modification_time_ticks;
+
+#ifdef _WIN32
+    struct _stati64 sb;
+    if (_wstati64(file_path.generic_path().wstring().c_str(), &sb) < 0)
+        return -1;
+#else
+    struct stat64 sb;
+    if (stat64(file_path.generic_path().string().c_str(), &sb) < 0)
+        return -1;
+#endif
+
+    last_access_time_ticks = RTC_OFFSET + (uint64_t)sb.st_atime * VITA_CLOCKS_PER_SEC;
+    creation_time_ticks = RTC_OFFSET + (uint64_t)sb.st_ctime * VITA_CLOCKS_PER_SEC;
+    last_modification_time_ticks = RTC_OFFSET + (uint64_t)sb.st_mtime * VITA_CLOCKS_PER_SEC;
+
+#ifndef _WIN32
+#undef st_atime
+#undef st_mtime
+#undef st_ctime
+#endif
+
+    statp->st_mode = SCE_S_IRUSR | SCE_S_IRGRP | SCE_S_IROTH | SCE_S_IXUSR | SCE_S_IXGRP | SCE_S_IXOTH;
+
+    // everything comes from the single stat call
+    if ((sb.st_mode & S_IFMT) == S_IFREG) {
+        statp->st_size = sb.st_size;
+        statp->st_attr = SCE_SO_IFREG;
+        statp->st_mode |= SCE_S_IFREG;
+    }
+    if ((sb.st_mode & S_IFMT) == S_IFDIR) {
+        statp->st_attr = SCE_SO_IFDIR;
+        statp->st_mode |= SCE_S_IFDIR;
+    }
+
+    __RtcTicksToPspTime(&statp->st_atime, last_access_time_ticks);
+    __RtcTicksToPspTime(&statp->st_mtime, last_modification_time_ticks);
+    __RtcTicksToPspTime(&statp->st_ctime, creation_time_ticks);
+
+    return 0;
+}
+
+static SceDateTime get_image_date_time(const uint16_t date, const uint16_t time) {
+    SceDateTime date_time{};
+    date_time.year = 1980 + (date >> 9);
+    date_time.month = (date >> 5) & 0xF;
+    date_time.day = date & 0x1F;
+    date_time.hour = time >> 11;
+    date_time.minute = (time >> 5) & 0x3F;
+    date_time.second = (time & 0x1F) * 2;
+    return date_time;
+}
+
+// fill the stat data of a file or directory of a device image
+static void stat_image_entry(const exfat::Image::Entry &entry, SceIoStat *statp) {
+    statp->st_mode = SCE_S_IRUSR | SCE_S_IRGRP | SCE_S_IROTH | SCE_S_IXUSR | SCE_S_IXGRP | SCE_S_IXOTH;
+    if (entry.is_dir) {
+        statp->st_attr = SCE_SO_IFDIR;
+        statp->st_mode |= SCE_S_IFDIR;
+    } else {
+        statp->st_size = entry.size;
+        statp->st_attr = SCE_SO_IFREG;
+        statp->st_mode |= SCE_S_IFREG;
+    }
+
+    statp->st_atime = get_image_date_time(entry.adate, entry.atime);
+    statp->st_mtime = get_image_date_time(entry.mdate, entry.mtime);
+    statp->st_ctime = get_image_date_time(entry.crdate, entry.crtime);
+}
+
 int stat_file(IOState &io, const char *file, SceIoStat *statp, const fs::path &pref_path, const char *export_name, const SceUID fd) {
+    PROFILE_SCOPE(__func__);
+
     assert(statp != nullptr);
 
     memset(statp, '\0', sizeof(SceIoStat));
@@ -497,6 +760,14 @@ int stat_file(IOState &io, const char *file, SceIoStat *statp, const fs::path &p
         file_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
 
         if (!fs::exists(file_path)) {
+            const auto image = get_device_image(device, pref_path);
+            const auto image_entry = image ? image->find(translated_path) : nullptr;
+            if (image_entry) {
+                LOG_TRACE_IF(log_file_op && log_file_stat, "{}: Statting file: {} ({}) from the device image", export_name, file, device::construct_normalized_path(device, translated_path));
+                stat_image_entry(*image_entry, statp);
+                return 0;
+            }
+
             if (io.case_isens_find_enabled) {
                 // Attempt a case-insensitive file search.
                 const auto original_file_path = file_path;
@@ -525,51 +796,22 @@ int stat_file(IOState &io, const char *file, SceIoStat *statp, const fs::path &p
         if (fd_file == io.std_files.end())
             return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-        file_path = fd_file->second.get_system_location();
+        if (const auto image_file = fd_file->second.get_image_file()) {
+            LOG_TRACE_IF(log_file_op && log_file_stat, "{}: Statting fd: {}", export_name, log_hex(fd));
+            stat_image_entry(image_file->get_entry(), statp);
+            return 0;
+        }
+
+        // the size must include the writes still in the buffer
+        fd_file->second.flush();
+        file_path = fd_file->second.get_host_location();
         LOG_TRACE_IF(log_file_op && log_file_stat, "{}: Statting fd: {}", export_name, log_hex(fd));
 
         statp->st_attr = fd_file->second.get_file_mode();
     }
 
-    std::uint64_t last_access_time_ticks;
-    std::uint64_t creation_time_ticks;
-    std::uint64_t last_modification_time_ticks;
-
-#ifdef _WIN32
-    struct _stati64 sb;
-    if (_wstati64(file_path.generic_path().wstring().c_str(), &sb) < 0)
-        return IO_ERROR_UNK();
-#else
-    struct stat64 sb;
-    if (stat64(file_path.generic_path().string().c_str(), &sb) < 0)
+    if (stat_host_file(file_path, statp) < 0)
         return IO_ERROR_UNK();
-#endif
-
-    last_access_time_ticks = RTC_OFFSET + (uint64_t)sb.st_atime * VITA_CLOCKS_PER_SEC;
-    creation_time_ticks = RTC_OFFSET + (uint64_t)sb.st_ctime * VITA_CLOCKS_PER_SEC;
-    last_modification_time_ticks = RTC_OFFSET + (uint64_t)sb.st_mtime * VITA_CLOCKS_PER_SEC;
-
-#ifndef _WIN32
-#undef st_atime
-#undef st_mtime
-#undef st_ctime
-#endif
-
-    statp->st_mode = SCE_S_IRUSR | SCE_S_IRGRP | SCE_S_IROTH | SCE_S_IXUSR | SCE_S_IXGRP | SCE_S_IXOTH;
-
-    if (fs::is_regular_file(file_path)) {
-        statp->st_size = fs::file_size(file_path);
-        statp->st_attr = SCE_SO_IFREG;
-        statp->st_mode |= SCE_S_IFREG;
-    }
-    if (fs::is_directory(file_path)) {
-        statp->st_attr = SCE_SO_IFDIR;
-        statp->st_mode |= SCE_S_IFDIR;
-    }
-
-    __RtcTicksToPspTime(&statp->st_atime, last_access_time_ticks);
-    __RtcTicksToPspTime(&statp->st_mtime, last_modification_time_ticks);
-    __RtcTicksToPspTime(&statp->st_ctime, creation_time_ticks);
 
     return 0;
 }
@@ -587,18 +829,66 @@ int stat_file_by_fd(IOState &io, const SceUID fd, SceIoStat *statp, const fs::pa
 }
 
 int close_file(IOState &io, const SceUID fd, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
 
     LOG_TRACE_IF(log_file_op, "{}: Closing file fd: {}", export_name, log_hex(fd));
 
     io.tty_files.erase(fd);
-    io.std_files.erase(fd);
+    auto file = io.std_files.extract(fd);
+    if (file.empty())
+        return 0;
+
+    FileStats &closed_file = file.mapped();
+    const auto start = io.stats.start();
+    const bool closed = closed_file.close();
+    io.stats.record(IoOp::Close, closed_file.get_translated_path(), 0, start);
+    if (closed_file.can_write_file() && !io.used_size_cache.empty()) {
+        boost::system::error_code error_code{};
+        const auto size = fs::file_size(closed_file.get_system_location(), error_code);
+        if (!error_code)
+            update_used_size(io, closed_file.get_system_location(), static_cast<int64_t>(size) - static_cast<int64_t>(closed_file.get_size_at_open()));
+    }
+    if (!closed)
+        return IO_ERROR(SCE_ERROR_ERRNO_EIO);
+
+    return 0;
+}
+
+int sync_file(IOState &io, const SceUID fd, const char *export_name) {
+    if (fd < 0)
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    if (io.tty_files.contains(fd))
+        return 0;
+
+    const auto file = io.std_files.find(fd);
+    if (file == io.std_files.end())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    LOG_TRACE_IF(log_file_op, "{}: Syncing fd: {}", export_name, log_hex(fd));
+    if (!file->second.flush())
+        return IO_ERROR(SCE_ERROR_ERRNO_EIO);
 
     return 0;
 }
 
+int sync_files(IOState &io, const char *device, const char *export_name) {
+    LOG_TRACE_IF(log_file_op, "{}: Syncing device: {}", export_name, device);
+
+    // the writes of all the files are flushed, whichever device they are on
+    bool flushed = true;
+    for (const auto &[fd, file] : io.std_files)
+        flushed &= file.flush();
+
+    return flushed ? 0 : IO_ERROR(SCE_ERROR_ERRNO_EIO);
+}
+
 int remove_file(IOState &io, const char *file, const fs::path &pref_path, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     auto device = device::get_device(file);
     if (device == VitaIoDevice::_INVALID) {
         LOG_ERROR("Cannot find device for path: {}", file);
@@ -619,6 +909,11 @@ int remove_file(IOState &io, const char *file, const fs::path &pref_path, const
     LOG_TRACE_IF(log_file_op, "{}: Removing file {} ({})", export_name, file, device::construct_normalized_path(device, translated_path));
 
     boost::system::error_code error_code{};
+    const auto removed_size = fs::file_size(emulated_path, error_code);
+    if (error_code)
+        error_code.clear();
+    else
+        update_used_size(io, emulated_path, -static_cast<int64_t>(removed_size));
     auto res = fs::detail::remove(emulated_path, &error_code);
 
     if (!(res && !(error_code.value()))) {
@@ -626,11 +921,14 @@ int remove_file(IOState &io, const char *file, const fs::path &pref_path, const
         LOG_ERROR("Error code: {} ({})", error_code.value(), error_code.message());
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
+    remove_cached_paths(io, emulated_path);
 
     return 0;
 }
 
 int rename(IOState &io, const char *old_name, const char *new_name, const fs::path &pref_path, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     auto device = device::get_device(old_name);
     if (device == VitaIoDevice::_INVALID) {
         LOG_ERROR("Cannot find device for path: {}", old_name);
@@ -659,7 +957,13 @@ int rename(IOState &io, const char *old_name, const char *new_name, const fs::pa
 
     LOG_TRACE_IF(log_file_op, "{}: Renaming file {} to {} ({} to {})", export_name, old_name, new_name, emulated_old_path, emulated_new_path);
 
+    // only the files are moved between the cached used sizes, a directory drops them
     boost::system::error_code error_code{};
+    const bool is_file = fs::is_regular_file(emulated_old_path, error_code);
+    const auto old_size = is_file ? fs::file_size(emulated_old_path, error_code) : 0;
+    const auto replaced_size = (is_file && fs::is_regular_file(emulated_new_path, error_code)) ? fs::file_size(emulated_new_path, error_code) : 0;
+    error_code.clear();
+
     fs::rename(emulated_old_path, emulated_new_path, error_code);
 
     if (error_code.value()) {
@@ -668,16 +972,34 @@ int rename(IOState &io, const char *old_name, const char *new_name, const fs::pa
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
 
+    remove_cached_paths(io, emulated_old_path);
+    add_created_path(io, emulated_new_path);
+    if (is_file) {
+        update_used_size(io, emulated_old_path, -static_cast<int64_t>(old_size));
+        update_used_size(io, emulated_new_path, static_cast<int64_t>(old_size) - static_cast<int64_t>(replaced_size));
+    } else {
+        io.used_size_cache.clear();
+    }
+    if (io.case_isens_find_enabled && fs::is_directory(emulated_new_path)) {
+        for (const auto &file : fs::recursive_directory_iterator(emulated_new_path))
+            io.cachemap.emplace(string_utils::tolower(file.path().string()), file.path().string());
+    }
+
     return 0;
 }
 
 SceUID open_dir(IOState &io, const char *path, const fs::path &pref_path, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     auto device = device::get_device(path);
     auto device_for_icase = device;
     const auto translated_path = translate_path(path, device, io.device_paths);
 
     auto dir_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio) / "";
-    if (!fs::exists(dir_path)) {
+    const auto image = get_device_image(device, pref_path);
+    const auto image_dir = image ? image->find(translated_path) : nullptr;
+    const bool in_image = image_dir && image_dir->is_dir;
+    if (!fs::exists(dir_path) && !in_image) {
         if (io.case_isens_find_enabled) {
             // Attempt a case-insensitive file search.
             const auto original_dir_path = dir_path;
@@ -701,14 +1023,45 @@ SceUID open_dir(IOState &io, const char *path, const fs::path &pref_path, const
         }
     }
 
-    const DirPtr opened = create_shared_dir(dir_path);
-    if (!opened) {
+    const DirPtr opened = fs::exists(dir_path) ? create_shared_dir(dir_path) : DirPtr();
+    if (!opened && !in_image) {
         LOG_ERROR("Failed to open directory at: {} (target path: {})", dir_path, path);
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
 
+    // all the entries are listed and statted now, reading them doesn't go through the host anymore
+    std::vector<DirEntry> entries;
+    while (const auto d = opened ? get_system_dir_ptr(opened) : nullptr) {
+        DirEntry entry{ get_file_in_dir(d), {} };
+        if ((entry.name == ".") || (entry.name == ".."))
+            continue;
+
+        if (stat_host_file(dir_path / entry.name, &entry.stat) < 0) {
+            LOG_WARN("Cannot stat {} in directory {}", entry.name, dir_path);
+            continue;
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    // the entries of the device image which are not in the directory come after its own
+    if (in_image) {
+        std::unordered_set<std::string> host_names;
+        for (const auto &entry : entries)
+            host_names.insert(string_utils::tolower(entry.name));
+
+        for (const auto child : image_dir->children) {
+            const auto &image_entry = image->get_entry(child);
+            if (host_names.contains(string_utils::tolower(image_entry.name)))
+                continue;
+
+            DirEntry entry{ image_entry.name, {} };
+            stat_image_entry(image_entry, &entry.stat);
+            entries.push_back(std::move(entry));
+        }
+    }
+
     const auto normalized = device::construct_normalized_path(device, translated_path);
-    const DirStats d{ path, normalized, dir_path, opened };
+    const DirStats d{ path, normalized, dir_path, std::move(entries) };
     const auto fd = io.next_fd++;
     io.dir_entries.emplace(fd, d);
 
@@ -718,6 +1071,8 @@ SceUID open_dir(IOState &io, const char *path, const fs::path &pref_path, const
 }
 
 SceUID read_dir(IOState &io, const SceUID fd, SceIoDirent *dent, const fs::path &pref_path, const char *export_name) {
+    PROFILE_SCOPE(__func__);
+
     assert(dent != nullptr);
 
     memset(dent->d_name, '\0', sizeof(dent->d_name));
@@ -729,24 +1084,15 @@ SceUID read_dir(IOState &io, const SceUID fd, SceIoDirent *dent, const fs::path
         if (!dir->second.is_directory())
             return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-        const auto d = dir->second.get_dir_ptr();
-        if (!d)
+        const auto entry = dir->second.read_entry();
+        if (!entry)
             return 0;
 
-        const auto d_name_utf8 = get_file_in_dir(d);
-        strncpy(dent->d_name, d_name_utf8.c_str(), sizeof(dent->d_name));
-
-        const auto cur_path = dir->second.get_system_location() / d_name_utf8;
-        if (!(cur_path.filename_is_dot() || cur_path.filename_is_dot_dot())) {
-            const auto file_path = std::string(dir->second.get_vita_loc()) + '/' + d_name_utf8;
+        strncpy(dent->d_name, entry->name.c_str(), sizeof(dent->d_name));
+        dent->d_stat = entry->stat;
 
-            LOG_TRACE_IF(log_file_op, "{}: Reading entry {} of fd: {}", export_name, file_path, log_hex(fd));
-            if (stat_file(io, file_path.c_str(), &dent->d_stat, pref_path, export_name) < 0)
-                return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
-            else
-                return 1; // move to the next file
-        }
-        return read_dir(io, fd, dent, pref_path, export_name);
+        LOG_TRACE_IF(log_file_op, "{}: Reading entry {}/{} of fd: {}", export_name, dir->second.get_vita_loc(), entry->name, log_hex(fd));
+        return 1; // move to the next file
     }
 
     return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
@@ -790,6 +1136,8 @@ bool copy_path(const fs::path &src_path, const fs::path &pref_path, const std::s
 }
 
 int create_dir(IOState &io, const char *dir, int mode, const fs::path &pref_path, const char *export_name, const bool recursive) {
+    PROFILE_SCOPE(__func__);
+
     auto device = device::get_device(dir);
     const auto translated_path = translate_path(dir, device, io.device_paths);
     if (translated_path.empty()) {
@@ -798,8 +1146,11 @@ int create_dir(IOState &io, const char *dir, int mode, const fs::path &pref_path
     }
 
     const auto emulated_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
-    if (recursive)
-        return fs::create_directories(emulated_path);
+    if (recursive) {
+        const bool created = fs::create_directories(emulated_path);
+        add_created_path(io, fs::path(emulated_path).remove_trailing_separator());
+        return created;
+    }
     if (fs::exists(emulated_path))
         return IO_ERROR(SCE_ERROR_ERRNO_EEXIST);
 
@@ -813,6 +1164,7 @@ int create_dir(IOState &io, const char *dir, int mode, const fs::path &pref_path
         LOG_ERROR("Failed to create directory at {} (target path: {})", emulated_path, dir);
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
+    add_created_path(io, fs::path(emulated_path).remove_trailing_separator());
 
     return 0;
 }
@@ -846,10 +1198,13 @@ int remove_dir(IOState &io, const char *dir, const fs::path &pref_path, const ch
 
     LOG_TRACE_IF(log_file_op, "{}: Removing dir {} ({})", export_name, dir, device::construct_normalized_path(device, translated_path));
 
-    if (!fs::remove_all(device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio))) {
+    const auto emulated_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
+    if (!fs::remove_all(emulated_path)) {
         LOG_ERROR("Cannot remove dir: {} ({})", dir, device::construct_normalized_path(device, translated_path));
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
+    remove_cached_paths(io, fs::path(emulated_path).remove_trailing_separator());
+    io.used_size_cache.clear();
 
     return 0;
 }
@@ -26,7 +26,84 @@
 
 #include <io/state.h>
 
+#include <util/log.h>
+
+#include <algorithm>
+
+// host io does not work well with memory trapping and read-only buffer
+// so set 1 byte to 0 in all pages to trigger all possible pagefaults in this range
+// todo: call a mem function to check this instead
+static void touch_pages(void *data, const uint64_t size) {
+    volatile uint8_t *input_addr = reinterpret_cast<volatile uint8_t *>(data);
+    for (uint64_t i = 0; i < size; i += 0x1000)
+        input_addr[i] = 0;
+    input_addr[size - 1] = 0;
+}
+
+FileStats::FileStats(const char *vita, const std::string &t, const fs::path &file, const int open, const bool map_file, const size_t write_buffer_size, const bool write_to_temp) {
+    if (map_file) {
+        mapped_file = std::make_shared<MappedFile>();
+        if (!mapped_file->map(file))
+            mapped_file.reset();
+    }
+    if (!mapped_file) {
+        if (can_write(open)) {
+            boost::system::error_code error_code{};
+            size_at_open = fs::file_size(file, error_code);
+            if (error_code)
+                size_at_open = 0;
+        }
+        if (write_to_temp && can_write(open)) {
+            // the file is left untouched until the copy is complete, in case the emulator stops in between
+            temp_file = file;
+            temp_file += ".tmp";
+            boost::system::error_code error_code{};
+            fs::copy_file(file, temp_file, fs::copy_options::overwrite_existing, error_code);
+            if (error_code) {
+                LOG_WARN("Cannot copy {} to {}, it is written in place: {}", file, temp_file, error_code.message());
+                temp_file.clear();
+            }
+        }
+        wrapped_file = create_shared_file(get_host_location(), open);
+
+        // the writes of the applications are often small, they are given to the host in large chunks
+        if (wrapped_file && write_buffer_size > 0 && can_write(open)) {
+            write_buffer.reset(new char[write_buffer_size]);
+            setvbuf(wrapped_file.get(), write_buffer.get(), _IOFBF, write_buffer_size);
+        }
+    }
+
+    file_info.vita_loc = vita;
+    file_info.translated = t;
+    file_info.sys_loc = file;
+    file_info.open_mode = open;
+    file_info.file_mode = SCE_SO_IFREG | SCE_SO_IROTH;
+    file_info.access_mode = SCE_S_IFREG;
+}
+
+FileStats::FileStats(const char *vita, const std::string &t, const fs::path &image_path, std::shared_ptr<exfat::ImageFile> file)
+    : image_file(std::move(file)) {
+    file_info.vita_loc = vita;
+    file_info.translated = t;
+    file_info.sys_loc = image_path;
+    file_info.open_mode = SCE_O_RDONLY;
+    file_info.file_mode = SCE_SO_IFREG | SCE_SO_IROTH;
+    file_info.access_mode = SCE_S_IFREG;
+}
+
 SceOff FileStats::read(void *input_data, const int element_size, const SceSize element_count) const {
+    if (mapped_file)
+        return mapped_file->read(input_data, static_cast<size_t>(element_size) * element_count) / std::max(element_size, 1);
+
+    if (image_file) {
+        const size_t size = static_cast<size_t>(element_size) * element_count;
+        if (size == 0)
+            return 0;
+        // the whole blocks are read from the image file directly to the buffer
+        touch_pages(input_data, size);
+        return image_file->read(input_data, size) / element_size;
+    }
+
     if (!wrapped_file)
         return -1;
 
@@ -34,17 +111,50 @@ SceOff FileStats::read(void *input_data, const int element_size, const SceSize e
         return 0;
 
     // we are filling this buffer this data, why would we have to set some parts to 0 before ?
-    // that's because host io does not work well with memory trapping and read-only buffer
-    // so set 1 byte to 0 in all pages to trigger all possible pagefaults in this range
-    // todo: call a mem function to check this instead
-    volatile uint8_t *input_addr = reinterpret_cast<volatile uint8_t *>(input_data);
-    for (int i = 0; i < element_size * element_count; i += 0x1000)
-        input_addr[i] = 0;
-    input_addr[element_size * element_count - 1] = 0;
+    // see touch_pages
+    touch_pages(input_data, static_cast<uint64_t>(element_size) * element_count);
 
     return fread(input_data, element_size, element_count, wrapped_file.get());
 }
 
+SceOff FileStats::read_at(void *data, const SceSize size, const SceOff offset) const {
+    if (mapped_file)
+        return offset < 0 ? -1 : mapped_file->read_at(data, size, static_cast<size_t>(offset));
+
+    if (image_file) {
+        if (offset < 0)
+            return -1;
+        if (size == 0)
+            return 0;
+        touch_pages(data, size);
+        return image_file->read_at(data, size, static_cast<uint64_t>(offset));
+    }
+
+    if (!wrapped_file)
+        return -1;
+
+#ifdef _WIN32
+    const SceOff pos = tell();
+    if (pos < 0 || !seek(offset, SCE_SEEK_SET))
+        return -1;
+    const SceOff res = read(data, 1, size);
+    seek(pos, SCE_SEEK_SET);
+    return res;
+#else
+    if (size == 0)
+        return 0;
+
+    // the buffered writes must reach the host file first
+    if (fflush(wrapped_file.get()) != 0)
+        return -1;
+
+    // pread does not work well with memory trapping either
+    touch_pages(data, size);
+
+    return pread(fileno(wrapped_file.get()), data, size, offset);
+#endif
+}
+
 SceOff FileStats::write(const void *data, const SceSize size, const int count) const {
     if (!can_write_file())
         return -1;
@@ -52,7 +162,33 @@ SceOff FileStats::write(const void *data, const SceSize size, const int count) c
     return fwrite(data, size, count, get_file_pointer());
 }
 
+SceOff FileStats::write_at(const void *data, const SceSize size, const SceOff offset) const {
+    if (!can_write_file())
+        return -1;
+
+#ifdef _WIN32
+    const SceOff pos = tell();
+    if (pos < 0 || !seek(offset, SCE_SEEK_SET))
+        return -1;
+    const SceOff res = write(data, 1, size);
+    seek(pos, SCE_SEEK_SET);
+    return res;
+#else
+    FILE *file = get_file_pointer();
+    if (fflush(file) != 0)
+        return -1;
+
+    const SceOff res = pwrite(fileno(file), data, size, offset);
+    // the data read ahead by the file pointer may be stale now, seeking to the current position drops it
+    fseeko(file, ftello(file), SEEK_SET);
+    return res;
+#endif
+}
+
 int FileStats::truncate(const SceSize size) const {
+    if (!wrapped_file)
+        return -1;
+
 #ifdef _WIN32
     return _chsize_s(_fileno(get_file_pointer()), size);
 #else
@@ -61,6 +197,12 @@ int FileStats::truncate(const SceSize size) const {
 }
 
 bool FileStats::seek(const SceOff offset, const SceIoSeekMode seek_mode) const {
+    if (mapped_file)
+        return mapped_file->seek(offset, seek_mode);
+
+    if (image_file)
+        return image_file->seek(offset, seek_mode);
+
     if (!wrapped_file)
         return false;
 
@@ -87,6 +229,12 @@ bool FileStats::seek(const SceOff offset, const SceIoSeekMode seek_mode) const {
 }
 
 SceOff FileStats::tell() const {
+    if (mapped_file)
+        return static_cast<SceOff>(mapped_file->tell());
+
+    if (image_file)
+        return static_cast<SceOff>(image_file->tell());
+
     if (!wrapped_file)
         return -1;
 
@@ -96,3 +244,35 @@ SceOff FileStats::tell() const {
     return ftello(wrapped_file.get());
 #endif
 }
+
+bool FileStats::flush() const {
+    if (!wrapped_file)
+        return true;
+
+    return fflush(wrapped_file.get()) == 0;
+}
+
+bool FileStats::close() {
+    // the file pointer is shared with the copies of this object, they must be gone
+    const bool flushed = flush();
+    wrapped_file.reset();
+    write_buffer.reset();
+    mapped_file.reset();
+    image_file.reset();
+
+    if (temp_file.empty())
+        return flushed;
+
+    boost::system::error_code error_code{};
+    if (flushed)
+        fs::rename(temp_file, get_system_location(), error_code);
+    if (!flushed || error_code) {
+        LOG_ERROR("Cannot replace {} with its written copy", get_system_location());
+        fs::remove(temp_file, error_code);
+        temp_file.clear();
+        return false;
+    }
+
+    temp_file.clear();
+    return true;
+}
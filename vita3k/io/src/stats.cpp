@@ -0,0 +1,147 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/stats.h>
+
+#include <util/log.h>
+
+#include <fmt/ranges.h>
+
+#include <algorithm>
+#include <bit>
+
+const char *get_io_op_name(IoOp op) {
+    switch (op) {
+    case IoOp::Open:
+        return "open";
+    case IoOp::Read:
+        return "read";
+    case IoOp::Seek:
+        return "seek";
+    case IoOp::Write:
+        return "write";
+    case IoOp::Close:
+        return "close";
+    default:
+        return "unknown";
+    }
+}
+
+uint64_t IoStats::OpStats::get_latency_percentile(double share) const {
+    const auto target = static_cast<uint64_t>(static_cast<double>(count) * share);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NB_LATENCY_BUCKETS; i++) {
+        seen += latency_buckets[i];
+        if (seen > target)
+            return uint64_t(1) << i;
+    }
+    return uint64_t(1) << (NB_LATENCY_BUCKETS - 1);
+}
+
+static void add_op(IoStats::OpStats &stats, uint64_t bytes, uint64_t latency_us) {
+    stats.count++;
+    stats.bytes += bytes;
+    stats.total_us += latency_us;
+    // bit_width(0) is 0: a latency below 1 us goes to the first bucket
+    const size_t bucket = std::min<size_t>(std::bit_width(latency_us), IoStats::NB_LATENCY_BUCKETS - 1);
+    stats.latency_buckets[bucket]++;
+}
+
+void IoStats::record(IoOp op, const std::string &path, uint64_t bytes, Clock::time_point start) {
+    if (!enabled || start == Clock::time_point{})
+        return;
+
+    const auto latency_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    const auto device_end = path.find(':');
+    const auto directory_end = path.rfind('/');
+    const auto op_index = static_cast<size_t>(op);
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    add_op(device_stats[path.substr(0, device_end)][op_index], bytes, latency_us);
+    add_op(directory_stats[path.substr(0, directory_end)][op_index], bytes, latency_us);
+}
+
+void IoStats::reset() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    device_stats.clear();
+    directory_stats.clear();
+}
+
+std::map<std::string, IoStats::PathStats> IoStats::get_device_stats() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return device_stats;
+}
+
+std::map<std::string, IoStats::PathStats> IoStats::get_directory_stats() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return directory_stats;
+}
+
+static std::string escape_json(const std::string &str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (const char c : str) {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+static void write_path_stats(fs::ofstream &report, const std::map<std::string, IoStats::PathStats> &all_stats) {
+    bool first_path = true;
+    for (const auto &[path, path_stats] : all_stats) {
+        report << (first_path ? "\n" : ",\n") << fmt::format("    \"{}\": {{", escape_json(path));
+        first_path = false;
+
+        bool first_op = true;
+        for (size_t op = 0; op < path_stats.size(); op++) {
+            const auto &stats = path_stats[op];
+            if (stats.count == 0)
+                continue;
+
+            report << (first_op ? "\n" : ",\n")
+                   << fmt::format("      \"{}\": {{ \"count\": {}, \"bytes\": {}, \"total_us\": {}, \"latency_buckets_us\": [{}] }}",
+                          get_io_op_name(static_cast<IoOp>(op)), stats.count, stats.bytes, stats.total_us, fmt::join(stats.latency_buckets, ", "));
+            first_op = false;
+        }
+        report << "\n    }";
+    }
+}
+
+bool IoStats::save_report(const fs::path &path) {
+    const auto devices = get_device_stats();
+    const auto directories = get_directory_stats();
+
+    fs::ofstream report(path);
+    if (!report) {
+        LOG_ERROR("Cannot write the IO report to {}", path);
+        return false;
+    }
+
+    report << "{\n  \"devices\": {";
+    write_path_stats(report, devices);
+    report << "\n  },\n  \"directories\": {";
+    write_path_stats(report, directories);
+    report << "\n  }\n}\n";
+
+    LOG_INFO("IO report saved to {}", path);
+    return static_cast<bool>(report);
+}
@@ -107,11 +107,12 @@ struct Callback {
     uint32_t get_num_notifications();
 
     /**
-     * @brief Runs callback in the context of creator thread
-     * @note Calling this method when Callback.executable() == false returns false and does nothing
-     * @note This should be called only in the creator thread
+     * @brief Takes the pending notifications so that the callback can be run
+     * @param args Set to the arguments the callback function must be called with
+     * @return false if the callback was not notified, args is left untouched in this case
+     * @note The callback returns to its default state, notifications received while it runs are kept for the next time
      */
-    void execute(KernelState &kernel, const std::function<void()> &deleter);
+    bool take_notifications(std::vector<uint32_t> &args);
 
 private:
     void reset();
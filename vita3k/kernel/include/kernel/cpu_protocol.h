@@ -23,16 +23,30 @@ struct MemState;
 struct KernelState;
 typedef int SceUID;
 typedef std::function<void(CPUState &cpu, uint32_t nid, SceUID thread_id)> CallImportFunc;
+typedef std::function<void(CPUState &cpu, uint32_t slot, SceUID thread_id)> CallImportSlotFunc;
+
+// svc immediates starting from this value encode the import slot of the called function
+// so that it can be dispatched without reading and resolving the NID
+constexpr uint32_t IMPORT_SLOT_SVC_BASE = 0x100;
+
+// Get the first instruction of an import stub calling the HLE implementation of this NID
+// the NID must still be written after the return instruction of the stub
+uint32_t encode_import_svc(uint32_t nid);
+
+// Get the first instruction of an import stub which always resolves the NID written in the stub at call time
+uint32_t encode_import_resolve_svc();
 
 struct CPUProtocol : public CPUProtocolBase {
-    CPUProtocol(KernelState &kernel, MemState &mem, const CallImportFunc &func);
+    CPUProtocol(KernelState &kernel, MemState &mem, const CallImportFunc &func, const CallImportSlotFunc &slot_func);
     ~CPUProtocol() override = default;
     void call_svc(CPUState &cpu, uint32_t svc, Address pc, ThreadState &thread) override;
     Address get_watch_memory_addr(Address addr) override;
     ExclusiveMonitorPtr get_exclusive_monitor() override;
+    void record_sample(CPUState &cpu, Address pc, Address lr) override;
 
 private:
     CallImportFunc call_import;
+    CallImportSlotFunc call_import_slot;
     KernelState *kernel;
     MemState *mem;
 };
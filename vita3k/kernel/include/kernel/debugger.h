@@ -23,6 +23,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <map>
+#include <memory>
 
 constexpr uint32_t TRAMPOLINE_JUMPER_SVC = 0x54;
 constexpr uint32_t TRAMPOLINE_HANDLER_SVC = 0x53;
@@ -46,12 +47,18 @@ struct Breakpoint {
     unsigned char data[4];
 };
 
+// The pages of a watched range are protected, the callback of the protection logs the access.
+// A protection only fires once: the range is protected again the next time the thread which accessed it goes through the kernel.
 struct WatchMemory {
     Address start;
     size_t size;
+    // set while the pages of the range are protected
+    std::atomic<bool> armed = false;
+    // a protection can not be removed, the range is only not protected again after its next access
+    std::atomic<bool> removed = false;
 };
 
-typedef std::map<Address, WatchMemory> WatchMemoryAddrs;
+typedef std::map<Address, std::shared_ptr<WatchMemory>> WatchMemoryAddrs;
 typedef std::map<Address, Breakpoint> Breakpoints;
 typedef std::map<Address, std::unique_ptr<Trampoline>> Trampolines;
 
@@ -68,7 +75,7 @@ struct Debugger {
     bool log_exports = false;
     bool dump_elfs = false;
 
-    void add_watch_memory_addr(Address addr, size_t size);
+    void add_watch_memory_addr(MemState &mem, Address addr, size_t size);
     void remove_watch_memory_addr(KernelState &state, Address addr);
     void add_breakpoint(MemState &mem, uint32_t addr, bool thumb_mode);
     void remove_breakpoint(MemState &mem, uint32_t addr);
@@ -77,7 +84,12 @@ struct Debugger {
     Trampoline *get_trampoline(Address addr);
     void remove_trampoline(MemState &mem, uint32_t addr);
     Address get_watch_memory_addr(Address addr);
-    void update_watches();
+    void update_watches(MemState &mem);
+    // protects the watched ranges which were accessed since they were last protected
+    void rearm_watches(MemState &mem);
+
+    // set by the protection of a watched range when it fires
+    std::atomic<bool> watch_fired{ false };
 
     // GDB breakpoint notification: signaled from the thread loop when a
     // thread hits a breakpoint and transitions to suspend.
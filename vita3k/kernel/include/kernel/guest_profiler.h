@@ -0,0 +1,83 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#pragma once
+
+#include <mem/util.h>
+#include <util/fs.h>
+#include <util/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+
+struct KernelState;
+
+/**
+ * @brief Sampling profiler of the guest code
+ *
+ * A host thread periodically asks the CPU of each running guest thread for a sample. The JIT
+ * stops at the next block boundary, the guest thread records its PC and LR and goes on, so the
+ * registers are never read while the JIT runs. A thread inside a non-blocking HLE call takes
+ * its sample when it returns to the guest, at the instruction after the call.
+ * The samples are symbolized with the loaded modules and their exported functions when saved,
+ * as folded stacks (thread;caller;function count) that flamegraph.pl or speedscope can open.
+ */
+class GuestProfiler {
+public:
+    static constexpr auto DEFAULT_INTERVAL = std::chrono::microseconds(1000);
+
+    ~GuestProfiler();
+
+    bool is_running() const {
+        return running;
+    }
+
+    void start(KernelState &kernel, std::chrono::microseconds interval = DEFAULT_INTERVAL);
+    void stop();
+
+    // called by the guest thread itself when its CPU stopped for a sample
+    void record(SceUID thread_id, Address pc, Address lr);
+    void reset();
+
+    uint64_t get_sample_count();
+
+    bool save_folded(KernelState &kernel, const fs::path &path);
+
+private:
+    // thread, pc, lr
+    using Sample = std::tuple<SceUID, Address, Address>;
+
+    void sampler_thread(KernelState &kernel, std::chrono::microseconds interval);
+
+    std::atomic<bool> running = false;
+    std::thread sampler;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cond;
+
+    std::mutex mutex;
+    std::map<Sample, uint64_t> samples;
+    // the names are kept as the threads may be deleted before the samples are saved
+    std::map<SceUID, std::string> thread_names;
+};
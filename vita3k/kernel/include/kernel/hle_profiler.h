@@ -0,0 +1,70 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Call counts and host time of the HLE functions, per import slot
+ *
+ * Each host thread adds its calls to thread-local counters, which are moved to the shared ones
+ * every few hundred calls or milliseconds, so that recording a call never takes a lock.
+ * The time of a call includes the time the guest thread spent blocked in it.
+ * Nothing is recorded unless the profiler is enabled.
+ */
+class HleProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct FunctionStats {
+        uint32_t slot = 0;
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+    };
+
+    std::atomic<bool> enabled = false;
+
+    // returns a default time point when the profiler is disabled, it is ignored by record
+    Clock::time_point start() const {
+        return enabled ? Clock::now() : Clock::time_point{};
+    }
+
+    // slot is the import slot of the function (see import_slot)
+    void record(uint32_t slot, Clock::time_point start);
+    void reset();
+
+    // copy of the statistics of the functions called at least once, for display
+    // the calls still in the thread-local counters are not included
+    std::vector<FunctionStats> get_stats();
+
+    bool save_csv(const fs::path &path);
+
+private:
+    std::mutex mutex;
+    // indexed by slot, allocated with the first calls
+    std::vector<FunctionStats> stats;
+    // incremented by reset, the thread-local counters of the previous generations are dropped
+    std::atomic<uint32_t> generation = 0;
+};
@@ -0,0 +1,45 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#pragma once
+
+#include <util/types.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr size_t VITA_CORE_COUNT = 4;
+
+// Optional policy binding the host threads running guest threads to host cores
+struct HostThreadPolicy {
+    // host cores used for each of the vita cores, an empty set means no pinning
+    std::array<std::vector<uint32_t>, VITA_CORE_COUNT> core_sets;
+    // translate the guest thread priority into a host thread priority
+    bool mirror_priority = false;
+    // use 5 priority levels of the host (thread priority, nice value or QoS class) instead of the 3 ones of SDL
+    bool native_priority = false;
+
+    // parse a list like "0-3;4-7;8,9;10", one core set per vita core, separated by ';'
+    // returns false if the string is not well formed, core_sets is left empty in this case
+    bool set_core_sets(const std::string &config);
+
+    // apply the policy to the calling host thread
+    void apply(SceInt32 affinity_mask, int priority) const;
+};
@@ -0,0 +1,68 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#pragma once
+
+#include <kernel/import_trace_format.h>
+#include <kernel/types.h>
+#include <mem/util.h>
+
+#include <util/fs.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Binary trace of the calls to the HLE functions
+ *
+ * Each host thread writes its calls to a ring buffer of its own, without taking any lock or formatting anything,
+ * so that the trace can stay enabled during a whole session. Only the last calls of each thread are kept.
+ * The trace is saved in the format of import_trace_format.h, the import-trace tool converts it to text.
+ * Nothing is recorded unless the trace is enabled.
+ */
+class ImportTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // calls kept per host thread, a power of 2
+    static constexpr uint32_t RING_SIZE = 16384;
+
+    ImportTrace();
+
+    std::atomic<bool> enabled = false;
+
+    void record(uint32_t nid, SceUID thread_id, Address lr, const uint32_t (&args)[4]);
+
+    // the calls recorded while saving may be missing from the file
+    bool save(const fs::path &path);
+
+private:
+    struct ThreadRing {
+        std::unique_ptr<import_trace::Entry[]> entries;
+        std::atomic<uint64_t> written = 0;
+    };
+
+    const Clock::time_point start_time;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+
+    ThreadRing &get_thread_ring();
+};
@@ -0,0 +1,57 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Layout of the binary import trace files, also read by the import-trace tool
+ *
+ * The file is the header, the entries sorted by time, then the name of each nid found in the entries,
+ * stored as its nid, the length of its name and the name without a terminating null.
+ * All the values are little endian.
+ */
+namespace import_trace {
+
+constexpr char FILE_MAGIC[4] = { 'V', 'I', 'T', 'R' };
+constexpr uint32_t FILE_VERSION = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t entry_count;
+    uint32_t name_count;
+    uint32_t reserved;
+};
+
+struct Entry {
+    // since the start of the emulator
+    uint64_t time_ns;
+    uint32_t nid;
+    int32_t thread_id;
+    uint32_t lr;
+    // r0 to r3
+    uint32_t args[4];
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 24);
+static_assert(sizeof(Entry) == 40);
+
+} // namespace import_trace
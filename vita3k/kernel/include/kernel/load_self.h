@@ -21,7 +21,9 @@
 #include <util/fs.h>
 #include <util/types.h>
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 struct KernelState;
 struct MemState;
@@ -29,3 +31,5 @@ struct KernelModule;
 
 SceUID load_self(KernelState &kernel, MemState &mem, const void *self, const std::string &self_path, const fs::path &log_path, const std::vector<Patch> &patches);
 int unload_self(KernelState &kernel, MemState &mem, KernelModule &module);
+// the content of the loadable segments of a SELF, without loading it in the emulated memory
+std::vector<std::vector<uint8_t>> read_self_segments(const std::vector<uint8_t> &self);
@@ -17,13 +17,19 @@
 
 #pragma once
 
+#include <cpu/jit_cache.h>
 #include <kernel/callback.h>
 #include <kernel/cpu_protocol.h>
 #include <kernel/debugger.h>
+#include <kernel/guest_profiler.h>
+#include <kernel/hle_profiler.h>
+#include <kernel/import_trace.h>
+#include <kernel/host_thread_policy.h>
 #include <kernel/object_store.h>
 #include <kernel/sync_primitives.h>
 #include <kernel/types.h>
 #include <mem/allocator.h>
+#include <mem/guest_heap.h>
 #include <mem/ptr.h>
 #include <mem/util.h>
 #include <rtc/rtc.h>
@@ -31,8 +37,11 @@
 #include <util/types.h>
 
 #include <atomic>
+#include <future>
 #include <map>
 #include <mutex>
+#include <shared_mutex>
+#include <string>
 #include <vector>
 
 struct ThreadState;
@@ -81,6 +90,39 @@ struct CorenumAllocator {
     void free_corenum(const int num);
 };
 
+// Keeps the cpus of the deleted threads so that new threads can reuse their JIT code cache
+// instead of translating the same code again, only the register state is reset
+struct CPUPool {
+    bool enabled = false;
+
+    // get an idle cpu, preferably one last used by a thread with the same name
+    CPUStatePtr acquire(const std::string &thread_name);
+    // returns false if the pool is full, cpu is left untouched in this case
+    bool release(const std::string &thread_name, CPUStatePtr &cpu);
+    void invalidate_jit_cache(Address start, size_t length);
+
+private:
+    std::mutex mutex;
+    std::vector<std::pair<std::string, CPUStatePtr>> cpus;
+};
+
+// Keeps the stacks and TLS blocks of the deleted threads so that threads created later
+// do not have to go through the guest allocator again, a block is only reused for the same size
+struct ThreadBlockPool {
+    // guest memory the pool can keep, 0 disables it
+    size_t max_size = 0;
+
+    // the returned block is not cleared
+    Block acquire(MemState &mem, uint32_t size, const char *name);
+    // the block is freed if the pool is full
+    void release(Block &block, uint32_t size);
+
+private:
+    std::mutex mutex;
+    std::map<uint32_t, std::vector<Block>> blocks;
+    size_t pooled_size = 0;
+};
+
 struct VarBindingInfo {
     void *entries;
     uint32_t size;
@@ -91,6 +133,9 @@ typedef std::multimap<uint32_t, VarBindingInfo> VarBindingInfos;
 typedef std::multimap<uint32_t, Address> FuncBindingInfos;
 
 typedef std::map<uint32_t, uint32_t> ModuleUidByNid;
+typedef std::map<std::string, std::string> LazyModuleByLibrary;
+typedef std::map<uint32_t, std::string> LazyModuleByNid;
+typedef std::map<std::string, std::shared_future<SceUID>> LazyModuleLoads;
 
 struct KernelState {
     KernelState();
@@ -119,6 +164,12 @@ struct KernelState {
     MsgPipePtrs msgpipes;
     CallbackPtrs callbacks;
 
+    // must be declared before threads as deleted threads give back their cpu, stack and TLS to them
+    CPUPool cpu_pool;
+    ThreadBlockPool thread_block_pool;
+    // threads are looked up on most HLE calls, so they have their own lock instead of mutex
+    // and the lookups of different guest threads do not wait for each other
+    std::shared_mutex threads_mutex;
     ThreadStatePtrs threads;
     void *jni_env;
     void *jni_activity;
@@ -133,9 +184,25 @@ struct KernelState {
     FuncBindingInfos func_binding_infos;
     VarBindingInfos var_binding_infos;
     ModuleUidByNid module_uid_by_nid;
+    // path of the module serving each imported library whose loading is deferred to the first call of one of its functions
+    LazyModuleByLibrary lazy_module_by_library;
+    // path of the deferred module for each function imported from the libraries above
+    LazyModuleByNid lazy_module_by_nid;
+
+    // deferred modules being loaded or already loaded, the other callers wait for the first one
+    std::mutex lazy_modules_mutex;
+    LazyModuleLoads lazy_module_loads;
 
     bool cpu_opt;
+    // optimizations of the jit of the threads when cpu_opt is set, a combination of JitOptimization
+    std::atomic<uint32_t> jit_optimizations = JIT_PROFILES[0].optimizations;
+    JitBlockCache jit_block_cache;
     CorenumAllocator corenum_allocator;
+    HostThreadPolicy host_thread_policy;
+    // the threads polling the time in a tight loop sleep between their polls
+    bool spin_loop_fast_forward = false;
+    std::atomic<uint64_t> spin_loop_sleeps = 0;
+    GuestHeap libc_heap;
     CPUProtocolPtr cpu_protocol;
     ExclusiveMonitorPtr exclusive_monitor;
 
@@ -146,12 +213,16 @@ struct KernelState {
     Ptr<SceProcessParam> process_param;
 
     Debugger debugger;
+    HleProfiler hle_profiler;
+    ImportTrace import_trace;
+    // declared after threads so that the sampler is stopped before they are destroyed
+    GuestProfiler guest_profiler;
 
     SceUID get_next_uid() {
         return next_uid++;
     }
 
-    bool init(MemState &mem, const CallImportFunc &call_import, bool cpu_opt);
+    bool init(MemState &mem, const CallImportFunc &call_import, const CallImportSlotFunc &call_import_slot, bool cpu_opt);
     void load_process_param(MemState &mem, Ptr<uint32_t> ptr);
     ThreadStatePtr create_thread(MemState &mem, const char *name, Ptr<const void> entry_point = Ptr<const void>(0));
     ThreadStatePtr create_thread(MemState &mem, const char *name, Ptr<const void> entry_point, int init_priority, SceInt32 affinity_mask, int stack_size, const SceKernelThreadOptParam *option);
@@ -163,6 +234,11 @@ struct KernelState {
     bool is_threads_paused() { return !paused_threads_status.empty(); }
     void pause_threads();
     void resume_threads();
+    uint32_t get_jit_optimizations() const;
+    // the running threads switch to these optimizations at their next block boundary
+    void set_jit_optimizations(uint32_t optimizations);
+    // called by the functions returning the time, sleeps the calling thread when it busy waits on them
+    void on_time_polled(SceUID thread_id);
 
     void set_memory_watch(bool enabled);
     void invalidate_jit_cache(Address start, size_t length);
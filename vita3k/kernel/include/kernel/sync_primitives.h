@@ -21,6 +21,8 @@
 #include <kernel/types.h>
 #include <util/byte_ring_buffer.h>
 
+#include <atomic>
+
 struct KernelState;
 
 struct WaitingThreadData {
@@ -81,6 +83,8 @@ struct SyncPrimitive {
     uint32_t attr{};
     std::mutex mutex;
     char name[KERNELOBJECT_MAX_NAME_LENGTH + 1];
+    // set once removed from the kernel, for the lookup caches of the threads
+    std::atomic<bool> deleted = false;
     virtual ~SyncPrimitive() = default;
 };
 
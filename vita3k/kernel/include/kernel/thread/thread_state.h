@@ -22,17 +22,23 @@
 #include <kernel/types.h>
 #include <mem/block.h>
 #include <mem/ptr.h>
+#include <util/containers.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 struct CPUContext;
 
 struct ThreadState;
 struct ThreadParams;
 struct KernelState;
+struct Mutex;
+struct Condvar;
 
 typedef std::unique_ptr<CPUState, std::function<void(CPUState *)>> CPUStatePtr;
 typedef std::function<void(CPUState &, uint32_t, SceUID)> CallImport;
@@ -59,6 +65,11 @@ private:
 };
 
 // Internal
+struct CallbackCall {
+    Address address;
+    std::vector<uint32_t> args;
+};
+
 enum class ThreadToDo {
     remove,
     run,
@@ -76,13 +87,25 @@ struct ThreadState {
     Block stack;
     int stack_size;
     Block tls;
+    uint32_t tls_size = 0;
 
     int priority;
     SceInt32 affinity_mask;
+    // set when another thread changed the priority or the affinity, only the host thread itself can apply them
+    std::atomic<bool> host_policy_changed = false;
     uint64_t start_tick;
     uint64_t last_vblank_waited;
     // set to true if thread is processing kernel callbacks
     bool is_processing_callbacks = false;
+    // statistics of the callbacks run by process_callbacks, written by the thread itself
+    uint64_t callback_window_start = 0;
+    uint32_t callbacks_in_window = 0;
+    std::atomic<uint32_t> callbacks_per_second = 0;
+    std::atomic<uint64_t> callbacks_run = 0;
+    // detection of a loop busy waiting on the time, written by the thread itself
+    Address time_poll_lr = 0;
+    std::chrono::steady_clock::time_point last_time_poll;
+    uint32_t time_polls_in_row = 0;
 
     CPUStatePtr cpu;
     ThreadStatus status = ThreadStatus::dormant;
@@ -93,8 +116,13 @@ struct ThreadState {
     std::vector<std::shared_ptr<ThreadState>> waiting_threads;
     uint32_t returned_value = 0;
 
+    // lightweight mutexes and condvars used by this thread, only accessed by the thread itself
+    unordered_map_fast<SceUID, std::shared_ptr<Mutex>> lw_mutex_cache;
+    unordered_map_fast<SceUID, std::shared_ptr<Condvar>> lw_cond_cache;
+
     ThreadState() = delete;
     explicit ThreadState(SceUID id, KernelState &kernel, MemState &mem);
+    ~ThreadState();
 
     int init(const char *name, Ptr<const void> entry_point, int init_priority, SceInt32 affinity_mask, int stack_size, const SceKernelThreadOptParam *option);
     int start(SceSize arglen, const Ptr<void> argp, bool run_entry_callback = false);
@@ -109,6 +137,8 @@ struct ThreadState {
 
     // this function must be called from the thread itself (inside a svc call)
     uint32_t run_callback(Address callback_address, const std::vector<uint32_t> &args);
+    // same as run_callback for several functions in a row, returns the value returned by each of them
+    std::vector<uint32_t> run_callbacks(const std::vector<CallbackCall> &calls);
 
     // this function is called from another thread when this one is dormant
     // it is only used for module loading and gxm display queue right now
@@ -125,7 +155,8 @@ private:
     KernelState &kernel;
 
     CPUContext init_cpu_ctx;
-    ThreadToDo to_do = ThreadToDo::wait;
+    // only written with mutex locked, but it can be read without it to check if anything changed
+    std::atomic<ThreadToDo> to_do = ThreadToDo::wait;
     std::condition_variable something_to_do;
 
     // if looking at the thread stack, the number of times run_loop appear
@@ -135,6 +166,12 @@ private:
     // gxm callbacked memory inside a kernel callback), call_level is 2
     int call_level = 0;
 
+    // set once the blocks from the jit block cache have been translated
+    bool jit_warmed_up = false;
+
+    // only the guest code of the main thread of the app is counted in the frame timings
+    bool is_main_thread = false;
+
     // when calling sceKernelStartThread
     bool run_start_callback = false;
     // when calling sceKernelExitThread or sceKernelExitDeleteThread
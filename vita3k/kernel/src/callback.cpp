@@ -22,24 +22,46 @@
 
 #include <mutex>
 
+static void update_callback_stats(KernelState &kernel, ThreadState &thread, uint32_t num_callbacks) {
+    const uint64_t now = rtc_get_ticks(kernel.base_tick.tick);
+    if (now - thread.callback_window_start >= 1'000'000) {
+        thread.callbacks_per_second = thread.callbacks_in_window;
+        thread.callbacks_in_window = 0;
+        thread.callback_window_start = now;
+    }
+    thread.callbacks_in_window += num_callbacks;
+    thread.callbacks_run += num_callbacks;
+}
+
 uint32_t process_callbacks(KernelState &kernel, SceUID thread_id) {
     ThreadStatePtr thread = kernel.get_thread(thread_id);
     if (thread->is_processing_callbacks)
         return 0;
 
-    thread->is_processing_callbacks = true;
-    uint32_t num_callbacks_processed = 0;
+    // all the notified callbacks are run in a single guest entry
+    std::vector<CallbackCall> calls;
+    std::vector<const Callback *> notified;
     for (CallbackPtr &cb : thread->callbacks) {
-        if (cb->is_executable()) {
-            std::string name = cb->get_name();
-            cb->execute(kernel, [name]() {
-                LOG_WARN("Callback with name {} requested to be deleted, but this is not supported yet!", name);
-            });
-            num_callbacks_processed++;
+        CallbackCall call{ cb->get_callback_function().address() };
+        if (cb->take_notifications(call.args)) {
+            calls.push_back(std::move(call));
+            notified.push_back(cb.get());
         }
     }
+    if (calls.empty())
+        return 0;
+
+    thread->is_processing_callbacks = true;
+    const std::vector<uint32_t> results = thread->run_callbacks(calls);
     thread->is_processing_callbacks = false;
 
+    for (size_t i = 0; i < results.size(); i++) {
+        if (results[i] != 0)
+            LOG_WARN("Callback with name {} requested to be deleted, but this is not supported yet!", notified[i]->get_name());
+    }
+
+    const uint32_t num_callbacks_processed = static_cast<uint32_t>(calls.size());
+    update_callback_stats(kernel, *thread, num_callbacks_processed);
     return num_callbacks_processed;
 }
 
@@ -85,17 +107,14 @@ uint32_t Callback::get_num_notifications() {
     return this->num_notifications;
 }
 
-void Callback::execute(KernelState &kernel, const std::function<void()> &deleter) {
+bool Callback::take_notifications(std::vector<uint32_t> &args) {
     std::lock_guard lock(this->_mutex);
     if (!this->is_notified())
-        return;
+        return false;
 
-    std::vector<uint32_t> args = { (uint32_t)(this->notifier_id), this->num_notifications, (uint32_t)this->notification_arg, this->userdata.address() };
-    int ret = kernel.get_thread(this->thread_id)->run_callback(this->cb_func.address(), args);
-    if (ret != 0) {
-        deleter();
-    }
-    this->reset(); // Callbacks return to their default state after running
+    args = { (uint32_t)(this->notifier_id), this->num_notifications, (uint32_t)this->notification_arg, this->userdata.address() };
+    this->reset(); // Callbacks return to their default state when they are run
+    return true;
 }
 
 /** Private methods **/
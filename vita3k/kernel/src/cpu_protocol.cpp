@@ -19,9 +19,23 @@
 
 #include <cpu/functions.h>
 #include <kernel/state.h>
+#include <nids/functions.h>
 
-CPUProtocol::CPUProtocol(KernelState &kernel, MemState &mem, const CallImportFunc &func)
+uint32_t encode_import_svc(uint32_t nid) {
+    const uint32_t slot = import_slot(nid);
+    if (slot == INVALID_IMPORT_SLOT)
+        return encode_import_resolve_svc();
+
+    return 0xef000000 | (IMPORT_SLOT_SVC_BASE + slot); // svc #slot - Call the import directly.
+}
+
+uint32_t encode_import_resolve_svc() {
+    return 0xef000000; // svc #0 - Resolve the NID written in the stub.
+}
+
+CPUProtocol::CPUProtocol(KernelState &kernel, MemState &mem, const CallImportFunc &func, const CallImportSlotFunc &slot_func)
     : call_import(func)
+    , call_import_slot(slot_func)
     , kernel(&kernel)
     , mem(&mem) {
 }
@@ -49,6 +63,13 @@ void CPUProtocol::call_svc(CPUState &cpu, uint32_t svc, Address pc, ThreadState
         return;
     }
 
+    // Import already resolved when the stub was written, the debugger needs the nid so use the slow path
+    if (svc >= IMPORT_SLOT_SVC_BASE && !kernel->debugger.watch_import_calls) {
+        call_import_slot(cpu, svc - IMPORT_SLOT_SVC_BASE, thread.id);
+        clear_exclusive(cpu);
+        return;
+    }
+
     // This is usual service call
     uint32_t nid = *Ptr<uint32_t>(pc + 4).get(*mem);
     // TODO: just supply ThreadStatePtr to call_import
@@ -56,7 +77,7 @@ void CPUProtocol::call_svc(CPUState &cpu, uint32_t svc, Address pc, ThreadState
     call_import(cpu, nid, thread.id);
 
     // ARM recommends clearing exclusive state inside interrupt handler
-    clear_exclusive(kernel->exclusive_monitor, get_processor_id(cpu));
+    clear_exclusive(cpu);
 }
 
 Address CPUProtocol::get_watch_memory_addr(Address addr) {
@@ -66,3 +87,7 @@ Address CPUProtocol::get_watch_memory_addr(Address addr) {
 ExclusiveMonitorPtr CPUProtocol::get_exclusive_monitor() {
     return kernel->exclusive_monitor;
 }
+
+void CPUProtocol::record_sample(CPUState &cpu, Address pc, Address lr) {
+    kernel->guest_profiler.record(get_thread_id(cpu), pc, lr);
+}
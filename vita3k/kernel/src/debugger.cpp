@@ -18,6 +18,7 @@
 #include <kernel/debugger.h>
 #include <kernel/state.h>
 #include <util/align.h>
+#include <util/log.h>
 
 constexpr unsigned char THUMB_BREAKPOINT[2] = { 0x00, 0xBE };
 constexpr unsigned char ARM_BREAKPOINT[4] = { 0x70, 0x00, 0x20, 0xE1 };
@@ -140,27 +141,78 @@ void Debugger::notify_breakpoint(SceUID thread_id) {
     break_cv.notify_one();
 }
 
-void Debugger::add_watch_memory_addr(Address addr, size_t size) {
+// Called with the protect lock held, from the access violation handler of the thread which accessed the range
+static bool on_watch_access(Debugger &debugger, WatchMemory &watch, Address addr, bool write) {
+    watch.armed = false;
+    if (watch.removed || !debugger.watch_memory)
+        return true;
+
+    // the whole page is protected, only the accesses inside of the range are reported
+    if (watch.start <= addr && addr < watch.start + watch.size)
+        LOG_INFO("Memory watch at {}: {} at {}", log_hex(watch.start), write ? "write" : "read", log_hex(addr));
+    debugger.watch_fired = true;
+    return true;
+}
+
+static void arm_watch(Debugger &debugger, MemState &mem, const std::shared_ptr<WatchMemory> &watch) {
+    if (watch->armed.exchange(true))
+        return;
+
+    add_protect(mem, watch->start, static_cast<uint32_t>(watch->size), MemPerm::None, [&debugger, watch](Address addr, bool write) {
+        return on_watch_access(debugger, *watch, addr, write);
+    });
+}
+
+void Debugger::add_watch_memory_addr(MemState &mem, Address addr, size_t size) {
     std::lock_guard<std::mutex> lock(mutex);
-    watch_memory_addrs.emplace(addr, WatchMemory{ addr, size });
+    auto watch = std::make_shared<WatchMemory>();
+    watch->start = addr;
+    watch->size = size;
+    watch_memory_addrs.emplace(addr, watch);
+    if (watch_memory)
+        arm_watch(*this, mem, watch);
 }
 
 void Debugger::remove_watch_memory_addr(KernelState &state, Address addr) {
     std::lock_guard<std::mutex> lock(mutex);
-    watch_memory_addrs.erase(addr);
+    const auto it = watch_memory_addrs.find(addr);
+    if (it != watch_memory_addrs.end()) {
+        it->second->removed = true;
+        watch_memory_addrs.erase(it);
+    }
 }
 
 // TODO use boost icl or interval tree instead if this turns out to be a significant bottleneck
 Address Debugger::get_watch_memory_addr(Address addr) {
     std::lock_guard<std::mutex> lock(mutex);
     for (const auto &item : watch_memory_addrs) {
-        if (item.second.start <= addr && addr < item.second.start + item.second.size) {
-            return item.second.start;
+        if (item.second->start <= addr && addr < item.second->start + item.second->size) {
+            return item.second->start;
         }
     }
     return 0;
 }
 
-void Debugger::update_watches() {
-    parent.set_memory_watch(watch_memory);
+void Debugger::update_watches(MemState &mem) {
+    std::unique_lock<std::mutex> lock(mutex);
+    // without any watched range every access is logged by the JIT, which then can not use fastmem
+    // otherwise only the pages of the watched ranges are protected and the other accesses keep using fastmem
+    const bool log_all = watch_memory && watch_memory_addrs.empty();
+    if (watch_memory)
+        for (auto &[_, watch] : watch_memory_addrs)
+            arm_watch(*this, mem, watch);
+    lock.unlock();
+
+    parent.set_memory_watch(log_all);
+}
+
+void Debugger::rearm_watches(MemState &mem) {
+    if (!watch_fired.exchange(false))
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!watch_memory)
+        return;
+    for (auto &[_, watch] : watch_memory_addrs)
+        arm_watch(*this, mem, watch);
 }
@@ -0,0 +1,186 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <kernel/guest_profiler.h>
+
+#include <cpu/functions.h>
+#include <kernel/state.h>
+#include <nids/functions.h>
+#include <util/log.h>
+#include <util/profile.h>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+GuestProfiler::~GuestProfiler() {
+    stop();
+}
+
+void GuestProfiler::start(KernelState &kernel, std::chrono::microseconds interval) {
+    if (running)
+        return;
+
+    running = true;
+    sampler = std::thread(&GuestProfiler::sampler_thread, this, std::ref(kernel), interval);
+}
+
+void GuestProfiler::stop() {
+    if (!running)
+        return;
+
+    {
+        const std::lock_guard<std::mutex> guard(stop_mutex);
+        running = false;
+    }
+    stop_cond.notify_all();
+    sampler.join();
+}
+
+void GuestProfiler::sampler_thread(KernelState &kernel, std::chrono::microseconds interval) {
+    PROFILE_THREAD_NAME("Guest profiler");
+    std::vector<std::pair<SceUID, std::string>> new_threads;
+
+    std::unique_lock<std::mutex> stop_lock(stop_mutex);
+    while (!stop_cond.wait_for(stop_lock, interval, [&] { return !running; })) {
+        {
+            const std::shared_lock<std::shared_mutex> threads_lock(kernel.threads_mutex);
+            for (const auto &[id, thread] : kernel.threads) {
+                {
+                    const std::lock_guard<std::mutex> thread_lock(thread->mutex);
+                    if (thread->status != ThreadStatus::run || !thread->cpu)
+                        continue;
+                }
+                request_sample(*thread->cpu);
+                new_threads.emplace_back(id, thread->name);
+            }
+        }
+
+        const std::lock_guard<std::mutex> guard(mutex);
+        for (auto &[id, name] : new_threads)
+            thread_names.try_emplace(id, std::move(name));
+        new_threads.clear();
+    }
+}
+
+void GuestProfiler::record(SceUID thread_id, Address pc, Address lr) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    samples[{ thread_id, pc, lr }]++;
+}
+
+void GuestProfiler::reset() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    samples.clear();
+}
+
+uint64_t GuestProfiler::get_sample_count() {
+    uint64_t count = 0;
+    const std::lock_guard<std::mutex> guard(mutex);
+    for (const auto &[_, sample_count] : samples)
+        count += sample_count;
+    return count;
+}
+
+namespace {
+
+// names the guest functions with the exported functions of the loaded modules
+class Symbolizer {
+public:
+    explicit Symbolizer(KernelState &kernel)
+        : kernel(kernel) {
+        const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+        exports.reserve(kernel.export_nids.size());
+        for (const auto &[nid, address] : kernel.export_nids) {
+            // the thumb bit is not part of the code address
+            if (address != 0)
+                exports.emplace_back(address & ~1U, nid);
+        }
+        std::sort(exports.begin(), exports.end());
+    }
+
+    const std::string &get_name(Address address) {
+        address &= ~1U;
+        const auto cached = names.find(address);
+        if (cached != names.end())
+            return cached->second;
+
+        return names.emplace(address, make_name(address)).first->second;
+    }
+
+private:
+    std::string make_name(Address address) {
+        const SceKernelModuleInfo *mod = kernel.find_module_by_addr(address);
+        if (!mod)
+            return fmt::format("0x{:08X}", address);
+
+        const std::string module_name(mod->module_name, strnlen(mod->module_name, sizeof(mod->module_name)));
+
+        // the closest export before the address is the function only if it is in the same module,
+        // the functions of the application itself are rarely exported
+        auto export_it = std::upper_bound(exports.begin(), exports.end(), std::make_pair(address, ~0U));
+        if (export_it != exports.begin()) {
+            --export_it;
+            if (kernel.find_module_by_addr(export_it->first) == mod)
+                return fmt::format("{}`{}", module_name, import_name(export_it->second));
+        }
+
+        return fmt::format("{}+0x{:X}", module_name, address - mod->segments[0].vaddr.address());
+    }
+
+    KernelState &kernel;
+    std::vector<std::pair<Address, uint32_t>> exports;
+    std::unordered_map<Address, std::string> names;
+};
+
+} // namespace
+
+bool GuestProfiler::save_folded(KernelState &kernel, const fs::path &path) {
+    std::map<Sample, uint64_t> saved_samples;
+    std::map<SceUID, std::string> saved_thread_names;
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        saved_samples = samples;
+        saved_thread_names = thread_names;
+    }
+
+    // samples at different addresses of the same functions are merged
+    Symbolizer symbolizer(kernel);
+    std::map<std::string, uint64_t> stacks;
+    for (const auto &[sample, count] : saved_samples) {
+        const auto &[thread_id, pc, lr] = sample;
+        const auto thread_name = saved_thread_names.find(thread_id);
+        std::string thread = thread_name != saved_thread_names.end() ? thread_name->second : fmt::format("thread_{}", thread_id);
+        // the frames are separated by semicolons
+        std::replace(thread.begin(), thread.end(), ';', '_');
+        // the LR is the caller only until the function calls another one, it is the best guess without unwinding
+        stacks[fmt::format("{};{};{}", thread, symbolizer.get_name(lr), symbolizer.get_name(pc))] += count;
+    }
+
+    fs::ofstream folded(path);
+    if (!folded) {
+        LOG_ERROR("Cannot write the guest profile to {}", path);
+        return false;
+    }
+
+    for (const auto &[stack, count] : stacks)
+        folded << fmt::format("{} {}\n", stack, count);
+
+    LOG_INFO("Guest profile saved to {}", path);
+    return static_cast<bool>(folded);
+}
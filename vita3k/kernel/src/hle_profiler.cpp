@@ -0,0 +1,129 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <kernel/hle_profiler.h>
+
+#include <nids/functions.h>
+#include <util/log.h>
+
+// the thread-local counters are moved to the shared ones after this many calls or this long
+static constexpr uint32_t FLUSH_CALL_COUNT = 256;
+static constexpr auto FLUSH_PERIOD = std::chrono::milliseconds(100);
+
+static constexpr uint32_t NO_ENTRY = ~0U;
+
+namespace {
+
+struct ThreadCounters {
+    const HleProfiler *profiler = nullptr;
+    uint32_t generation = 0;
+    uint32_t calls = 0;
+    HleProfiler::Clock::time_point last_flush;
+    // the functions called since the last flush, and the index of the entry of each slot
+    std::vector<HleProfiler::FunctionStats> entries;
+    std::vector<uint32_t> entry_of_slot;
+};
+
+} // namespace
+
+static thread_local ThreadCounters thread_counters;
+
+void HleProfiler::record(uint32_t slot, Clock::time_point start) {
+    if (start == Clock::time_point{} || slot >= import_slot_count())
+        return;
+
+    const auto now = Clock::now();
+    const auto elapsed_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count());
+
+    ThreadCounters &counters = thread_counters;
+    const uint32_t current_generation = generation.load(std::memory_order_relaxed);
+    if (counters.profiler != this || counters.generation != current_generation) {
+        counters.profiler = this;
+        counters.generation = current_generation;
+        counters.calls = 0;
+        counters.last_flush = now;
+        counters.entries.clear();
+        counters.entry_of_slot.assign(import_slot_count(), NO_ENTRY);
+    }
+
+    uint32_t &entry_idx = counters.entry_of_slot[slot];
+    if (entry_idx == NO_ENTRY) {
+        entry_idx = static_cast<uint32_t>(counters.entries.size());
+        counters.entries.push_back({ slot, 0, 0 });
+    }
+    counters.entries[entry_idx].count++;
+    counters.entries[entry_idx].total_ns += elapsed_ns;
+
+    if (++counters.calls < FLUSH_CALL_COUNT && now - counters.last_flush < FLUSH_PERIOD)
+        return;
+
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        // the counters are dropped if a reset happened since the generation was checked
+        if (generation == counters.generation) {
+            if (stats.empty())
+                stats.resize(import_slot_count());
+            for (const FunctionStats &entry : counters.entries) {
+                stats[entry.slot].count += entry.count;
+                stats[entry.slot].total_ns += entry.total_ns;
+            }
+        }
+    }
+
+    for (const FunctionStats &entry : counters.entries)
+        counters.entry_of_slot[entry.slot] = NO_ENTRY;
+    counters.entries.clear();
+    counters.calls = 0;
+    counters.last_flush = now;
+}
+
+void HleProfiler::reset() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    generation++;
+    stats.clear();
+}
+
+std::vector<HleProfiler::FunctionStats> HleProfiler::get_stats() {
+    std::vector<FunctionStats> called;
+    const std::lock_guard<std::mutex> guard(mutex);
+    for (uint32_t slot = 0; slot < stats.size(); slot++) {
+        if (stats[slot].count > 0)
+            called.push_back({ slot, stats[slot].count, stats[slot].total_ns });
+    }
+    return called;
+}
+
+bool HleProfiler::save_csv(const fs::path &path) {
+    const auto called = get_stats();
+
+    fs::ofstream csv(path);
+    if (!csv) {
+        LOG_ERROR("Cannot write the HLE profile to {}", path);
+        return false;
+    }
+
+    csv << "nid,name,calls,total_us,average_us\n";
+    for (const FunctionStats &function : called) {
+        const uint32_t nid = import_slot_nid(function.slot);
+        csv << fmt::format("0x{:08X},{},{},{},{:.3f}\n", nid, import_name(nid), function.count, function.total_ns / 1000,
+            static_cast<double>(function.total_ns) / 1000.0 / static_cast<double>(function.count));
+    }
+
+    LOG_INFO("HLE profile saved to {}", path);
+    return static_cast<bool>(csv);
+}
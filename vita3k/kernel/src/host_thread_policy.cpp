@@ -0,0 +1,164 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <kernel/host_thread_policy.h>
+
+#include <kernel/types.h>
+
+#include <util/log.h>
+#include <util/string_utils.h>
+
+#include <SDL3/SDL_thread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#include <cstdio>
+
+static bool set_current_thread_affinity(const std::vector<uint32_t> &host_cores) {
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (const uint32_t core : host_cores) {
+        if (core < sizeof(DWORD_PTR) * 8)
+            mask |= static_cast<DWORD_PTR>(1) << core;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const uint32_t core : host_cores) {
+        if (core < CPU_SETSIZE)
+            CPU_SET(core, &set);
+    }
+    // pid 0 is the calling thread
+    return CPU_COUNT(&set) != 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    // macOS only has affinity hints, which are not applied on Apple silicon
+    return false;
+#endif
+}
+
+static SDL_ThreadPriority get_host_priority(int priority) {
+    // lower values mean higher priority, the game threads have a default priority of 160
+    if (priority < SCE_KERNEL_GAME_DEFAULT_PRIORITY_ACTUAL - 32)
+        return SDL_THREAD_PRIORITY_HIGH;
+    if (priority > SCE_KERNEL_GAME_DEFAULT_PRIORITY_ACTUAL)
+        return SDL_THREAD_PRIORITY_LOW;
+    return SDL_THREAD_PRIORITY_NORMAL;
+}
+
+// from -2 (lowest) to 2 (highest), most game threads use a priority between 128 and 191
+static int get_host_priority_level(int priority) {
+    if (priority <= SCE_KERNEL_GAME_DEFAULT_PRIORITY_ACTUAL - 64)
+        return 2;
+    if (priority < SCE_KERNEL_GAME_DEFAULT_PRIORITY_ACTUAL - 16)
+        return 1;
+    if (priority <= SCE_KERNEL_GAME_DEFAULT_PRIORITY_ACTUAL + 8)
+        return 0;
+    if (priority <= SCE_KERNEL_GAME_DEFAULT_PRIORITY_ACTUAL + 20)
+        return -1;
+    return -2;
+}
+
+static bool set_current_thread_native_priority(int level) {
+#ifdef _WIN32
+    static const int priorities[] = { THREAD_PRIORITY_LOWEST, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_HIGHEST };
+    return SetThreadPriority(GetCurrentThread(), priorities[level + 2]) != 0;
+#elif defined(__linux__)
+    // the nice value of a linux thread is set with its tid
+    const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+    static const int nice_values[] = { 10, 5, 0, -5, -10 };
+    if (setpriority(PRIO_PROCESS, tid, nice_values[level + 2]) == 0)
+        return true;
+    // a negative nice value needs CAP_SYS_NICE or a high enough RLIMIT_NICE, keep the default one instead
+    LOG_WARN_ONCE("The host threads cannot be given a higher priority than the default one");
+    return nice_values[level + 2] < 0 && setpriority(PRIO_PROCESS, tid, 0) == 0;
+#elif defined(__APPLE__)
+    static const qos_class_t classes[] = { QOS_CLASS_BACKGROUND, QOS_CLASS_UTILITY, QOS_CLASS_DEFAULT, QOS_CLASS_USER_INITIATED, QOS_CLASS_USER_INTERACTIVE };
+    return pthread_set_qos_class_self_np(classes[level + 2], 0) == 0;
+#else
+    return false;
+#endif
+}
+
+bool HostThreadPolicy::set_core_sets(const std::string &config) {
+    for (auto &core_set : core_sets)
+        core_set.clear();
+    if (config.empty())
+        return true;
+
+    const std::vector<std::string> sets = string_utils::split_string(config, ';');
+    if (sets.size() > VITA_CORE_COUNT) {
+        LOG_ERROR("Host core sets {} define more than {} sets", config, VITA_CORE_COUNT);
+        return false;
+    }
+
+    std::array<std::vector<uint32_t>, VITA_CORE_COUNT> parsed;
+    for (size_t i = 0; i < sets.size(); i++) {
+        for (const std::string &range : string_utils::split_string(sets[i], ',')) {
+            // an empty set leaves the threads of this vita core unpinned
+            if (range.empty())
+                continue;
+            uint32_t first = 0;
+            uint32_t last = 0;
+            const int nb_read = std::sscanf(range.c_str(), "%u-%u", &first, &last);
+            if (nb_read < 1 || (nb_read == 2 && last < first)) {
+                LOG_ERROR("Invalid host core range {} in {}", range, config);
+                return false;
+            }
+            if (nb_read == 1)
+                last = first;
+            for (uint32_t core = first; core <= last; core++)
+                parsed[i].push_back(core);
+        }
+    }
+
+    core_sets = std::move(parsed);
+    return true;
+}
+
+void HostThreadPolicy::apply(SceInt32 affinity_mask, int priority) const {
+    // the default affinity lets the thread run on any user core
+    if (affinity_mask == SCE_KERNEL_THREAD_CPU_AFFINITY_MASK_DEFAULT)
+        affinity_mask = SCE_KERNEL_CPU_MASK_USER_ALL;
+
+    // the vita cores are the bits 16 to 19 of the mask
+    std::vector<uint32_t> host_cores;
+    for (size_t i = 0; i < VITA_CORE_COUNT; i++) {
+        if (affinity_mask & (0x10000 << i))
+            host_cores.insert(host_cores.end(), core_sets[i].begin(), core_sets[i].end());
+    }
+
+    if (!host_cores.empty() && !set_current_thread_affinity(host_cores))
+        LOG_WARN_ONCE("Failed to set the affinity of the host threads, the host core sets are ignored");
+
+    if (!mirror_priority)
+        return;
+
+    if (native_priority && set_current_thread_native_priority(get_host_priority_level(priority)))
+        return;
+    SDL_SetCurrentThreadPriority(get_host_priority(priority));
+}
@@ -0,0 +1,115 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <kernel/import_trace.h>
+
+#include <nids/functions.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <set>
+
+namespace {
+
+struct ThreadRingRef {
+    const ImportTrace *trace = nullptr;
+    void *ring = nullptr;
+};
+
+} // namespace
+
+static thread_local ThreadRingRef thread_ring;
+
+ImportTrace::ImportTrace()
+    : start_time(Clock::now()) {
+}
+
+ImportTrace::ThreadRing &ImportTrace::get_thread_ring() {
+    if (thread_ring.trace == this)
+        return *static_cast<ThreadRing *>(thread_ring.ring);
+
+    // first call of this host thread, the ring is kept after the thread ends so that its calls are saved
+    auto ring = std::make_shared<ThreadRing>();
+    ring->entries = std::make_unique<import_trace::Entry[]>(RING_SIZE);
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        rings.push_back(ring);
+    }
+    thread_ring = { this, ring.get() };
+    return *ring;
+}
+
+void ImportTrace::record(uint32_t nid, SceUID thread_id, Address lr, const uint32_t (&args)[4]) {
+    ThreadRing &ring = get_thread_ring();
+    const uint64_t index = ring.written.load(std::memory_order_relaxed);
+
+    import_trace::Entry &entry = ring.entries[index & (RING_SIZE - 1)];
+    entry.time_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time).count());
+    entry.nid = nid;
+    entry.thread_id = thread_id;
+    entry.lr = lr;
+    std::copy(std::begin(args), std::end(args), entry.args);
+    entry.reserved = 0;
+
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+bool ImportTrace::save(const fs::path &path) {
+    std::vector<import_trace::Entry> entries;
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        for (const auto &ring : rings) {
+            const uint64_t written = ring->written.load(std::memory_order_acquire);
+            const uint64_t count = std::min<uint64_t>(written, RING_SIZE);
+            for (uint64_t index = written - count; index < written; index++)
+                entries.push_back(ring->entries[index & (RING_SIZE - 1)]);
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const import_trace::Entry &a, const import_trace::Entry &b) {
+        return a.time_ns < b.time_ns;
+    });
+
+    std::set<uint32_t> nids;
+    for (const auto &entry : entries)
+        nids.insert(entry.nid);
+
+    fs::ofstream file(path, std::ios::binary);
+    if (!file) {
+        LOG_ERROR("Cannot write the import trace to {}", path);
+        return false;
+    }
+
+    import_trace::FileHeader header{};
+    std::copy(std::begin(import_trace::FILE_MAGIC), std::end(import_trace::FILE_MAGIC), header.magic);
+    header.version = import_trace::FILE_VERSION;
+    header.entry_count = entries.size();
+    header.name_count = static_cast<uint32_t>(nids.size());
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(import_trace::Entry)));
+
+    for (const uint32_t nid : nids) {
+        const std::string_view name = import_name(nid);
+        const uint32_t length = static_cast<uint32_t>(name.size());
+        file.write(reinterpret_cast<const char *>(&nid), sizeof(nid));
+        file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        file.write(name.data(), length);
+    }
+
+    LOG_INFO("Import trace of {} calls saved to {}", entries.size(), path);
+    return static_cast<bool>(file);
+}
@@ -30,6 +30,9 @@
 
 #include <SDL3/SDL_mutex.h>
 
+#include <algorithm>
+#include <thread>
+
 int CorenumAllocator::new_corenum() {
     const std::lock_guard<std::mutex> guard(lock);
 
@@ -47,6 +50,67 @@ void CorenumAllocator::set_max_core_count(const std::size_t max) {
     alloc.set_maximum(max);
 }
 
+// Avoid keeping too many code caches alive when a title creates a lot of threads at once
+static constexpr size_t MAX_POOLED_CPUS = 16;
+
+CPUStatePtr CPUPool::acquire(const std::string &thread_name) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (cpus.empty())
+        return nullptr;
+
+    auto it = std::find_if(cpus.begin(), cpus.end(), [&](const auto &item) { return item.first == thread_name; });
+    if (it == cpus.end())
+        it = std::prev(cpus.end());
+
+    CPUStatePtr cpu = std::move(it->second);
+    cpus.erase(it);
+    return cpu;
+}
+
+bool CPUPool::release(const std::string &thread_name, CPUStatePtr &cpu) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (cpus.size() >= MAX_POOLED_CPUS)
+        return false;
+
+    cpus.emplace_back(thread_name, std::move(cpu));
+    return true;
+}
+
+void CPUPool::invalidate_jit_cache(Address start, size_t length) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    for (const auto &[_, cpu] : cpus)
+        ::invalidate_jit_cache(*cpu, start, length);
+}
+
+Block ThreadBlockPool::acquire(MemState &mem, uint32_t size, const char *name) {
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        const auto it = blocks.find(size);
+        if (it != blocks.end() && !it->second.empty()) {
+            Block block = std::move(it->second.back());
+            it->second.pop_back();
+            pooled_size -= size;
+            return block;
+        }
+    }
+
+    return alloc_block(mem, size, name);
+}
+
+void ThreadBlockPool::release(Block &block, uint32_t size) {
+    if (!block)
+        return;
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (pooled_size + size > max_size) {
+        block = nullptr;
+        return;
+    }
+
+    blocks[size].push_back(std::move(block));
+    pooled_size += size;
+}
+
 // TODO implement cross platform debug thread name setter and eliminate SDL thread
 struct ThreadParams {
     KernelState *kernel = nullptr;
@@ -67,13 +131,19 @@ static int SDLCALL thread_function(void *data) {
         tracy::SetThreadName(th_name.c_str());
     }
 #endif
+    params.kernel->host_thread_policy.apply(thread->affinity_mask, thread->priority);
 
     thread->run_loop();
     const uint32_t r0 = read_reg(*thread->cpu, 0);
+    // a mutex still owned by the thread would keep it alive otherwise
+    thread->lw_mutex_cache.clear();
+    thread->lw_cond_cache.clear();
 
-    std::lock_guard<std::mutex> lock(params.kernel->mutex);
+    const std::lock_guard<std::shared_mutex> lock(params.kernel->threads_mutex);
     params.kernel->threads.erase(thread->id);
-    params.kernel->corenum_allocator.free_corenum(get_processor_id(*thread->cpu));
+    // with the cpu pool, the core number stays with the cpu and is freed when the cpu is destroyed
+    if (!params.kernel->cpu_pool.enabled)
+        params.kernel->corenum_allocator.free_corenum(get_processor_id(*thread->cpu));
 
     return r0;
 }
@@ -82,14 +152,14 @@ KernelState::KernelState()
     : debugger(*this) {
 }
 
-bool KernelState::init(MemState &mem, const CallImportFunc &call_import, bool cpu_opt) {
+bool KernelState::init(MemState &mem, const CallImportFunc &call_import, const CallImportSlotFunc &call_import_slot, bool cpu_opt) {
     constexpr std::size_t MAX_CORE_COUNT = 150;
 
     corenum_allocator.set_max_core_count(MAX_CORE_COUNT);
     exclusive_monitor = new_exclusive_monitor(MAX_CORE_COUNT);
     start_tick = rtc_get_ticks(rtc_base_ticks());
     base_tick = { rtc_base_ticks() };
-    cpu_protocol = std::make_unique<CPUProtocol>(*this, mem, call_import);
+    cpu_protocol = std::make_unique<CPUProtocol>(*this, mem, call_import, call_import_slot);
     this->cpu_opt = cpu_opt;
 
     return true;
@@ -109,7 +179,7 @@ void KernelState::load_process_param(MemState &mem, Ptr<uint32_t> ptr) {
 }
 
 void KernelState::set_memory_watch(bool enabled) {
-    std::lock_guard<std::mutex> lock(mutex);
+    const std::shared_lock<std::shared_mutex> lock(threads_mutex);
     for (const auto &thread : threads) {
         auto &cpu = *thread.second->cpu;
         if (enabled != get_log_mem(cpu)) {
@@ -122,14 +192,17 @@ void KernelState::set_memory_watch(bool enabled) {
 }
 
 void KernelState::invalidate_jit_cache(Address start, size_t length) {
-    std::lock_guard<std::mutex> lock(mutex);
+    jit_block_cache.invalidate(start, length);
+    cpu_pool.invalidate_jit_cache(start, length);
+
+    const std::shared_lock<std::shared_mutex> lock(threads_mutex);
     for (const auto &[_, thread] : threads) {
         ::invalidate_jit_cache(*thread->cpu, start, length);
     }
 }
 
 ThreadStatePtr KernelState::get_thread(SceUID thread_id) {
-    return lock_and_find(thread_id, threads, mutex);
+    return lock_and_find(thread_id, threads, threads_mutex);
 }
 
 ThreadStatePtr KernelState::create_thread(MemState &mem, const char *name, Ptr<const void> entry_point) {
@@ -140,7 +213,7 @@ ThreadStatePtr KernelState::create_thread(MemState &mem, const char *name, Ptr<c
     ThreadStatePtr thread = std::make_shared<ThreadState>(get_next_uid(), *this, mem);
     if (thread->init(name, entry_point, init_priority, affinity_mask, stack_size, option) < 0)
         return nullptr;
-    const auto lock = std::lock_guard(mutex);
+    const auto lock = std::lock_guard(threads_mutex);
     threads.emplace(thread->id, thread);
 
     ThreadParams params;
@@ -167,14 +240,15 @@ Ptr<Ptr<void>> KernelState::get_thread_tls_addr(MemState &mem, SceUID thread_id,
 }
 
 void KernelState::exit_delete_all_threads() {
-    const std::lock_guard<std::mutex> lock(mutex);
+    const std::shared_lock<std::shared_mutex> lock(threads_mutex);
     for (auto &[_, thread] : threads)
         // Skip end callbacks; running guest code can access torn-down state
         thread->exit_delete(false);
 }
 
 void KernelState::pause_threads() {
-    const std::lock_guard<std::mutex> lock(mutex);
+    // exclusive as paused_threads_status is modified
+    const std::lock_guard<std::shared_mutex> lock(threads_mutex);
     for (auto &[_, thread] : threads) {
         paused_threads_status[thread->id] = thread->status;
         if (thread->status == ThreadStatus::run)
@@ -183,7 +257,7 @@ void KernelState::pause_threads() {
 }
 
 void KernelState::resume_threads() {
-    const std::lock_guard<std::mutex> lock(mutex);
+    const std::lock_guard<std::shared_mutex> lock(threads_mutex);
     for (auto &[_, thread] : threads) {
         if (paused_threads_status[thread->id] == ThreadStatus::run)
             thread->resume();
@@ -191,6 +265,47 @@ void KernelState::resume_threads() {
     paused_threads_status.clear();
 }
 
+uint32_t KernelState::get_jit_optimizations() const {
+    return cpu_opt ? jit_optimizations.load() : 0;
+}
+
+void KernelState::set_jit_optimizations(uint32_t optimizations) {
+    jit_optimizations = optimizations;
+    const std::shared_lock<std::shared_mutex> lock(threads_mutex);
+    for (auto &[_, thread] : threads) {
+        if (thread->cpu)
+            ::set_jit_optimizations(*thread->cpu, get_jit_optimizations());
+    }
+}
+
+// a poll from the same call site this soon after the previous one continues a busy wait
+static constexpr auto SPIN_POLL_INTERVAL = std::chrono::microseconds(20);
+static constexpr uint32_t SPIN_POLLS_THRESHOLD = 64;
+// short enough for the loops waiting for a deadline to stay accurate
+static constexpr auto SPIN_SLEEP = std::chrono::microseconds(100);
+
+void KernelState::on_time_polled(SceUID thread_id) {
+    if (!spin_loop_fast_forward)
+        return;
+
+    const ThreadStatePtr thread = get_thread(thread_id);
+    if (!thread || !thread->cpu)
+        return;
+
+    const Address lr = read_lr(*thread->cpu);
+    if (lr != thread->time_poll_lr || std::chrono::steady_clock::now() - thread->last_time_poll > SPIN_POLL_INTERVAL)
+        thread->time_polls_in_row = 0;
+    else if (thread->time_polls_in_row < SPIN_POLLS_THRESHOLD && ++thread->time_polls_in_row == SPIN_POLLS_THRESHOLD)
+        LOG_DEBUG("Thread {} busy waits on the time at {}", thread->name, log_hex(lr));
+    thread->time_poll_lr = lr;
+
+    if (thread->time_polls_in_row == SPIN_POLLS_THRESHOLD) {
+        spin_loop_sleeps++;
+        std::this_thread::sleep_for(SPIN_SLEEP);
+    }
+    thread->last_time_poll = std::chrono::steady_clock::now();
+}
+
 SceKernelModuleInfo *KernelState::find_module_by_addr(Address address) {
     const auto lock = std::lock_guard(mutex);
     for (auto &[_, mod] : loaded_modules) {
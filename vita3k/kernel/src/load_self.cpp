@@ -23,6 +23,7 @@
 
 #include <nids/functions.h>
 #include <util/arm.h>
+#include <util/boot_trace.h>
 #include <util/fs.h>
 #include <util/log.h>
 
@@ -125,8 +126,11 @@ static bool unload_var_imports(const uint32_t *nids, const Ptr<uint32_t> *entrie
     return true;
 }
 
-static bool load_func_imports(const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, const SegmentInfosForReloc &segments, KernelState &kernel, const MemState &mem) {
+static bool load_func_imports(const char *lib_name, const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, const SegmentInfosForReloc &segments, KernelState &kernel, const MemState &mem) {
     const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+    // the stubs of a deferred module must reach call_import so that the module gets loaded at the first call
+    const auto lazy_module = lib_name ? kernel.lazy_module_by_library.find(lib_name) : kernel.lazy_module_by_library.end();
+    const bool is_lazy = lazy_module != kernel.lazy_module_by_library.end();
     for (size_t i = 0; i < count; ++i) {
         const uint32_t nid = nids[i];
         const Ptr<uint32_t> entry = entries[i];
@@ -141,7 +145,9 @@ static bool load_func_imports(const uint32_t *nids, const Ptr<uint32_t> *entries
 
         kernel.func_binding_infos.emplace(nid, entry.address());
         if (export_address == kernel.export_nids.end()) {
-            stub[0] = 0xef000000; // svc #0 - Call our interrupt hook.
+            if (is_lazy)
+                kernel.lazy_module_by_nid.emplace(nid, lazy_module->second);
+            stub[0] = is_lazy ? encode_import_resolve_svc() : encode_import_svc(nid); // svc - Call our interrupt hook.
             stub[1] = 0xe1a0f00e; // mov pc, lr - Return to the caller.
             stub[2] = nid; // Our interrupt hook will read this.
         } else {
@@ -212,17 +218,15 @@ static bool load_imports(const sce_module_info_raw &module, Ptr<const void> segm
             var_entry_table = long_imports->var_entry_table;
         }
 
-        std::string lib_name;
-        if (kernel.debugger.log_imports) {
-            lib_name = Ptr<const char>(library_name).get(mem);
-            LOG_INFO("Loading func imports from {}", lib_name);
-        }
+        const char *const lib_name = Ptr<const char>(library_name).get(mem);
+        if (kernel.debugger.log_imports)
+            LOG_INFO("Loading func imports from {}", lib_name ? lib_name : "unknown");
 
         const uint32_t *const nids = Ptr<const uint32_t>(func_nid_table).get(mem);
         const Ptr<uint32_t> *const entries = Ptr<Ptr<uint32_t>>(func_entry_table).get(mem);
 
         const size_t num_syms_funcs = imports->num_syms_funcs;
-        if (!is_unload && !load_func_imports(nids, entries, num_syms_funcs, segments, kernel, mem))
+        if (!is_unload && !load_func_imports(lib_name, nids, entries, num_syms_funcs, segments, kernel, mem))
             return false;
         if (is_unload && !unload_func_imports(nids, entries, num_syms_funcs, segments, kernel, mem))
             return false;
@@ -233,7 +237,7 @@ static bool load_imports(const sce_module_info_raw &module, Ptr<const void> segm
         const auto var_count = imports->num_syms_vars;
 
         if (kernel.debugger.log_imports && var_count > 0)
-            LOG_INFO("Loading var imports from {}", lib_name);
+            LOG_INFO("Loading var imports from {}", lib_name ? lib_name : "unknown");
 
         if (!is_unload && !load_var_imports(var_nids, var_entries, var_count, segments, kernel, mem, module.module_nid))
             return false;
@@ -301,7 +305,7 @@ static bool unload_func_exports(SceKernelModuleInfo *kernel_module_info, const u
             Address entry = it->second;
             uint32_t *stub = Ptr<uint32_t>(entry).get(mem);
 
-            stub[0] = 0xef000000; // svc #0 - Call our interrupt hook.
+            stub[0] = kernel.lazy_module_by_nid.contains(nid) ? encode_import_resolve_svc() : encode_import_svc(nid); // svc - Call our interrupt hook.
             stub[1] = 0xe1a0f00e; // mov pc, lr - Return to the caller.
             stub[2] = nid; // Our interrupt hook will read this.
             kernel.invalidate_jit_cache(entry, 3 * sizeof(uint32_t));
@@ -473,6 +477,7 @@ static bool load_exports(SceKernelModuleInfo *kernel_module_info, const sce_modu
  * \return Negative on failure
  */
 SceUID load_self(KernelState &kernel, MemState &mem, const void *self, const std::string &self_path, const fs::path &log_path, const std::vector<Patch> &patches) {
+    const boot_trace::Span span("load_self");
     // TODO: use raw I/O from path when io becomes less bad
     const uint8_t *const self_bytes = static_cast<const uint8_t *>(self);
     const SCE_header &self_header = *static_cast<const SCE_header *>(self);
@@ -641,6 +646,7 @@ SceUID load_self(KernelState &kernel, MemState &mem, const void *self, const std
                 segment_reloc_info[seg_index] = { segment_address, seg_header.p_vaddr, seg_header.p_memsz };
             }
         } else if (seg_header.p_type == PT_SCE_RELA) {
+            const boot_trace::Span relocate_span("relocate");
             if (seg_infos[seg_index].compression == 2) {
                 unsigned long dest_bytes = seg_header.p_filesz;
                 const uint8_t *const compressed_segment_bytes = self_bytes + seg_infos[seg_index].offset;
@@ -814,3 +820,47 @@ int unload_self(KernelState &kernel, MemState &mem, KernelModule &module) {
 
     return 0;
 }
+
+std::vector<std::vector<uint8_t>> read_self_segments(const std::vector<uint8_t> &self) {
+    std::vector<std::vector<uint8_t>> loaded_segments;
+    if (self.size() < sizeof(SCE_header))
+        return loaded_segments;
+
+    const uint8_t *const self_bytes = self.data();
+    const SCE_header &self_header = *reinterpret_cast<const SCE_header *>(self_bytes);
+    if (self_header.version != 3 || self_header.header_type != 1 || self_header.elf_offset + sizeof(Elf32_Ehdr) > self.size())
+        return loaded_segments;
+
+    const Elf32_Ehdr &elf = *reinterpret_cast<const Elf32_Ehdr *>(self_bytes + self_header.elf_offset);
+    if (!EHDR_HAS_VALID_MAGIC(elf)
+        || self_header.phdr_offset + elf.e_phnum * sizeof(Elf32_Phdr) > self.size()
+        || self_header.section_info_offset + elf.e_phnum * sizeof(segment_info) > self.size())
+        return loaded_segments;
+
+    const Elf32_Phdr *const segments = reinterpret_cast<const Elf32_Phdr *>(self_bytes + self_header.phdr_offset);
+    const segment_info *const seg_infos = reinterpret_cast<const segment_info *>(self_bytes + self_header.section_info_offset);
+    for (Elf_Half seg_index = 0; seg_index < elf.e_phnum; ++seg_index) {
+        const Elf32_Phdr &seg_header = segments[seg_index];
+        // the segments are only readable from the decrypted SELF Vita3K installs
+        if (seg_header.p_type != PT_LOAD || seg_header.p_filesz == 0 || seg_infos[seg_index].encryption != 2)
+            continue;
+
+        std::vector<uint8_t> segment(seg_header.p_filesz);
+        if (seg_infos[seg_index].compression == 2) {
+            if (seg_infos[seg_index].offset + seg_infos[seg_index].length > self.size())
+                continue;
+
+            mz_ulong dest_bytes = seg_header.p_filesz;
+            if (mz_uncompress(segment.data(), &dest_bytes, self_bytes + seg_infos[seg_index].offset, static_cast<mz_ulong>(seg_infos[seg_index].length)) != MZ_OK)
+                continue;
+        } else {
+            if (self_header.header_len + seg_header.p_offset + seg_header.p_filesz > self.size())
+                continue;
+
+            memcpy(segment.data(), self_bytes + self_header.header_len + seg_header.p_offset, seg_header.p_filesz);
+        }
+        loaded_segments.push_back(std::move(segment));
+    }
+
+    return loaded_segments;
+}
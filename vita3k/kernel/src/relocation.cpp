@@ -19,6 +19,7 @@
 #include <mem/ptr.h>
 #include <util/log.h>
 
+#include <array>
 #include <cassert>
 #include <cstring>
 #include <string>
@@ -244,6 +245,48 @@ static void write_thumb_mov_abs(void *data, uint16_t symbol) {
     pair->upper.imm4 = symbol >> 12;
 }
 
+// The segment indices of the entries are 4 bits wide, so the segments are looked up in a flat table
+// instead of the map: large modules have hundreds of thousands of relocations.
+struct SegmentTable {
+    std::array<const SegmentInfoForReloc *, 16> segments = {};
+
+    explicit SegmentTable(const SegmentInfosForReloc &infos) {
+        for (const auto &[index, info] : infos) {
+            if (index < segments.size())
+                segments[index] = &info;
+        }
+    }
+
+    Address start(uint32_t index) const {
+        return segments[index] ? segments[index]->addr : 0;
+    }
+
+    // segment whose original virtual address range contains this address
+    const SegmentInfoForReloc *find_by_vaddr(uint32_t vaddr) const {
+        for (const SegmentInfoForReloc *seg : segments) {
+            if (seg && vaddr >= seg->p_vaddr && vaddr < seg->p_vaddr + seg->size)
+                return seg;
+        }
+        return nullptr;
+    }
+};
+
+// Formats 6 to 9 are absolute 32-bit relocations whose target holds the original virtual address:
+// they are the bulk of the relocations and are applied here without going through relocate_entry.
+static void relocate_original_abs32(void *data, const SegmentTable &table, Address &saddr) {
+    uint32_t orgval;
+    memcpy(&orgval, data, sizeof(orgval));
+
+    uint32_t segbase = 0;
+    if (const SegmentInfoForReloc *seg = table.find_by_vaddr(orgval)) {
+        segbase = seg->p_vaddr;
+        saddr = seg->addr;
+    }
+
+    assert(orgval >= segbase);
+    write(data, saddr + orgval - segbase);
+}
+
 static bool relocate_entry(void *data, uint32_t code, uint32_t symval, uint32_t addend, uint32_t addr) {
     LOG_DEBUG_IF(LOG_RELOCATIONS, "code: {}, *data: {}, data: {}, addr: {}, symval: {}, addend: {}", code, log_hex(*static_cast<uint32_t *>(data)), data, log_hex(addr), log_hex(symval), log_hex(addend));
     switch (code) {
@@ -305,6 +348,7 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
     const Entry *entry = static_cast<const Entry *>(entries);
 
     const auto segment_count = segments.size();
+    const SegmentTable table(segments);
 
     if (LOG_RELOCATIONS) {
         LOG_DEBUG("Relocating patch of size: {}, # of segments: {}", log_hex(size), segment_count);
@@ -314,8 +358,7 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
 
     // initialized in format 1 and 2
     Address g_addr = 0,
-            g_offset = 0,
-            g_patchseg = 0;
+            g_offset = 0;
 
     // initialized in format 0, 1, 2, and 3
     Address g_saddr = 0,
@@ -335,9 +378,9 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
             const EntryFormat0 *const format0_entry = static_cast<const EntryFormat0 *>(entry);
 
             const auto symbol_seg = format0_entry->symbol_segment;
-            const auto symbol_seg_start = segments.find(symbol_seg)->second.addr;
+            const auto symbol_seg_start = table.start(symbol_seg);
             const auto patch_seg = format0_entry->patch_segment;
-            const auto patch_seg_start = segments.find(patch_seg)->second.addr;
+            const auto patch_seg_start = table.start(patch_seg);
 
             const Address s = (format0_entry->symbol_segment == 0xf) ? 0 : symbol_seg_start;
             const Address p = patch_seg_start + format0_entry->offset;
@@ -363,7 +406,6 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
 
             g_addr = patch_seg_start;
             g_offset = format0_entry->offset;
-            g_patchseg = format0_entry->patch_segment;
             g_saddr = s;
             g_addend = a;
             g_type = format0_entry->code;
@@ -376,9 +418,9 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
                 const EntryFormat1 *const format1_entry = static_cast<const EntryFormat1 *>(entry);
 
                 const auto symbol_seg = format1_entry->symbol_segment;
-                const auto symbol_seg_start = segments.find(symbol_seg)->second.addr;
+                const auto symbol_seg_start = table.start(symbol_seg);
                 const auto patch_seg = format1_entry->patch_segment;
-                const auto patch_seg_start = segments.find(patch_seg)->second.addr;
+                const auto patch_seg_start = table.start(patch_seg);
                 const Address s = (format1_entry->symbol_segment == 0xf) ? 0 : symbol_seg_start;
 
                 const Address offset = format1_entry->offset_lo | (format1_entry->offset_hi << 12);
@@ -394,7 +436,6 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
 
                 g_addr = patch_seg_start;
                 g_offset = offset;
-                g_patchseg = format1_entry->patch_segment;
                 g_saddr = s;
                 g_addend = a;
                 g_type = format1_entry->code;
@@ -428,7 +469,6 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
 
                 g_addr = patch_seg_start;
                 g_offset = offset;
-                g_patchseg = format1_entry->patch_segment;
                 g_saddr = s;
                 g_addend = a;
                 g_type = format1_entry->code;
@@ -442,7 +482,7 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
                 const EntryFormat2 *const format2_entry = static_cast<const EntryFormat2 *>(entry);
 
                 const auto symbol_seg = format2_entry->symbol_segment;
-                const auto symbol_seg_start = segments.find(symbol_seg)->second.addr;
+                const auto symbol_seg_start = table.start(symbol_seg);
 
                 g_offset += format2_entry->offset;
                 g_saddr = (format2_entry->symbol_segment == 0xf) ? 0 : symbol_seg_start;
@@ -489,7 +529,6 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
 
                 g_addr = patch_seg_start;
                 g_offset = offset;
-                g_patchseg = format1_entry->patch_segment;
                 g_saddr = s;
                 g_addend = a;
                 g_type = format1_entry->code;
@@ -504,7 +543,7 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
                 log_hex(format3_entry->symbol_segment), format3_entry->mode, format3_entry->mode ? "THUMB" : "ARM", log_hex(format3_entry->offset), log_hex(format3_entry->dist2), log_hex(format3_entry->addend));
 
             const auto symbol_seg = format3_entry->symbol_segment;
-            const auto symbol_seg_start = segments.find(symbol_seg)->second.addr;
+            const auto symbol_seg_start = table.start(symbol_seg);
             const Address s = (format3_entry->symbol_segment == 0xf) ? 0 : symbol_seg_start;
             const auto mode = format3_entry->mode;
             const auto offset = format3_entry->offset;
@@ -595,32 +634,10 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
 
             g_offset += format6_entry->offset;
 
-            const auto patch_seg_start = segments.find(g_patchseg)->second.addr;
-
-            const uint32_t orgval = *Ptr<uint32_t>(patch_seg_start + g_offset).get(mem);
-
-            uint32_t segbase = 0;
-            for (const auto &seg_ : segments) {
-                const auto seg = seg_.second;
-                if (orgval >= seg.p_vaddr && orgval < seg.p_vaddr + seg.size) {
-                    segbase = seg.p_vaddr;
-                    g_saddr = seg.addr;
-                }
-            }
-
-            assert((uint32_t)orgval >= (uint32_t)segbase);
-            const auto addend = orgval - segbase;
-
             g_type2 = 0;
             g_type = Abs32;
 
-            const auto s = g_saddr;
-            const auto a = addend;
-            const auto p = g_addr + g_offset;
-
-            if (!relocate_entry(Ptr<uint32_t>(p).get(mem), g_type, s, a, p)) {
-                return false;
-            }
+            relocate_original_abs32(Ptr<uint32_t>(g_addr + g_offset).get(mem), table, g_saddr);
 
             break;
         }
@@ -643,36 +660,14 @@ bool relocate(const void *entries, uint32_t size, const SegmentInfosForReloc &se
             }
             // clang-format on
 
+            g_type2 = 0;
+            g_type = Abs32;
+
             do {
                 auto offset = (offsets & mask) * sizeof(uint32_t);
                 g_offset += static_cast<Address>(offset);
 
-                const auto patch_seg_start = segments.find(g_patchseg)->second.addr;
-
-                const uint32_t orgval = *Ptr<uint32_t>(patch_seg_start + g_offset).get(mem);
-
-                uint32_t segbase = 0;
-                for (const auto &seg_ : segments) {
-                    const auto seg = seg_.second;
-                    if (orgval >= seg.p_vaddr && orgval < seg.p_vaddr + seg.size) {
-                        segbase = seg.p_vaddr;
-                        g_saddr = seg.addr;
-                    }
-                }
-
-                assert((uint32_t)orgval >= (uint32_t)segbase);
-                const auto addend = orgval - segbase;
-
-                g_type2 = 0;
-                g_type = Abs32;
-
-                const auto s = g_saddr;
-                const auto a = addend;
-                const auto p = g_addr + g_offset;
-
-                if (!relocate_entry(Ptr<uint32_t>(p).get(mem), g_type, s, a, p)) {
-                    return false;
-                }
+                relocate_original_abs32(Ptr<uint32_t>(g_addr + g_offset).get(mem), table, g_saddr);
             } while (offsets >>= bitsize);
 
             break;
@@ -20,6 +20,7 @@
 #include <kernel/sync_primitives.h>
 
 #include <kernel/types.h>
+#include <rtc/rtc.h>
 #include <util/lock_and_find.h>
 #include <util/log.h>
 
@@ -49,9 +50,35 @@ inline static CondvarPtrs &get_condvars(KernelState &kernel, SyncWeight weight)
     return weight == SyncWeight::Light ? kernel.lwcondvars : kernel.condvars;
 }
 
-inline static int find_mutex(MutexPtr &mutex_out, MutexPtrs **mutexes_out, KernelState &kernel, const char *export_name, SceUID mutexid, SyncWeight weight) {
+// lightweight objects are looked up on every lock and unlock, so the calling thread keeps
+// the ones it used to find them again without taking the kernel lock
+template <typename T>
+static std::shared_ptr<T> find_cached(unordered_map_fast<SceUID, std::shared_ptr<T>> &cache, KernelState &kernel, SceUID uid, const std::map<SceUID, std::shared_ptr<T>> &objects) {
+    constexpr size_t MAX_CACHED_OBJECTS = 64;
+
+    const auto it = cache.find(uid);
+    if (it != cache.end()) {
+        if (!it->second->deleted)
+            return it->second;
+        cache.erase(it);
+    }
+
+    std::shared_ptr<T> object = lock_and_find(uid, objects, kernel.mutex);
+    if (object) {
+        if (cache.size() >= MAX_CACHED_OBJECTS)
+            cache.clear();
+        cache.emplace(uid, object);
+    }
+    return object;
+}
+
+// thread must be the calling thread, it can be null if the lookup is not done often
+inline static int find_mutex(MutexPtr &mutex_out, MutexPtrs **mutexes_out, KernelState &kernel, const char *export_name, SceUID mutexid, SyncWeight weight, ThreadState *thread = nullptr) {
     MutexPtrs &mutexes = get_mutexes(kernel, weight);
-    mutex_out = lock_and_find(mutexid, mutexes, kernel.mutex);
+    if (thread && weight == SyncWeight::Light)
+        mutex_out = find_cached(thread->lw_mutex_cache, kernel, mutexid, mutexes);
+    else
+        mutex_out = lock_and_find(mutexid, mutexes, kernel.mutex);
     if (!mutex_out) {
         return unknown_mutex_id(export_name, weight);
     }
@@ -62,9 +89,12 @@ inline static int find_mutex(MutexPtr &mutex_out, MutexPtrs **mutexes_out, Kerne
     return SCE_KERNEL_OK;
 }
 
-inline static int find_condvar(CondvarPtr &condvar_out, CondvarPtrs **condvars_out, KernelState &kernel, const char *export_name, SceUID condid, SyncWeight weight) {
+inline static int find_condvar(CondvarPtr &condvar_out, CondvarPtrs **condvars_out, KernelState &kernel, const char *export_name, SceUID condid, SyncWeight weight, ThreadState *thread = nullptr) {
     CondvarPtrs &condvars = get_condvars(kernel, weight);
-    condvar_out = lock_and_find(condid, condvars, kernel.mutex);
+    if (thread && weight == SyncWeight::Light)
+        condvar_out = find_cached(thread->lw_cond_cache, kernel, condid, condvars);
+    else
+        condvar_out = lock_and_find(condid, condvars, kernel.mutex);
     if (!condvar_out) {
         return unknown_cond_id(export_name, weight);
     }
@@ -75,22 +105,25 @@ inline static int find_condvar(CondvarPtr &condvar_out, CondvarPtrs **condvars_o
     return SCE_KERNEL_OK;
 }
 
-// TODO: Write remaining time to timeout ptr when it's successfully signaled
+// Waits until the thread is given back the run status or the timeout expires, returns false in the latter case.
+// The deadline is computed once so that spurious wake ups do not extend the wait, the remaining time is written back to timeout.
+template <typename Lock>
+static bool wait_run_status(const ThreadStatePtr &thread, Lock &lock, SceUInt *const timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds{ *timeout };
+    const bool status = *timeout > 0 && thread->status_cond.wait_until(lock, deadline, [&] { return thread->status == ThreadStatus::run; });
+
+    const auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()).count();
+    *timeout = status && remaining > 0 ? static_cast<SceUInt>(remaining) : 0;
+    return status;
+}
+
 // Assumes primitive_lock is locked and thread_lock is unlocked
 inline static int handle_timeout(const ThreadStatePtr &thread, std::unique_lock<std::mutex> &thread_lock,
     std::unique_lock<std::mutex> &primitive_lock, WaitingThreadQueuePtr &queue,
     const ThreadDataQueueInterator<WaitingThreadData> &data_it, const char *export_name,
     SceUInt *const timeout) {
     if (timeout) {
-        bool status = false;
-        auto start = std::chrono::steady_clock::now();
-        if (*timeout > 0) {
-            status = thread->status_cond.wait_for(primitive_lock, std::chrono::microseconds{ *timeout }, [&] { return thread->status == ThreadStatus::run; });
-        }
-
-        if (!status) {
-            *timeout = 0; // Time run out, so remaining time is 0
-
+        if (!wait_run_status(thread, primitive_lock, timeout)) {
             thread_lock.lock();
             thread->update_status(ThreadStatus::run, ThreadStatus::wait);
             thread_lock.unlock();
@@ -98,14 +131,6 @@ inline static int handle_timeout(const ThreadStatePtr &thread, std::unique_lock<
             queue->erase(data_it);
 
             return RET_ERROR(SCE_KERNEL_ERROR_WAIT_TIMEOUT);
-        } else {
-            auto end = std::chrono::steady_clock::now();
-            uint32_t real_timeout = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
-            if (real_timeout > *timeout) {
-                *timeout = 0;
-            } else {
-                *timeout = *timeout - real_timeout;
-            }
         }
     } else {
         thread->status_cond.wait(primitive_lock, [&] { return thread->status == ThreadStatus::run; });
@@ -311,9 +336,7 @@ SceInt32 simple_event_delete(KernelState &kernel, const char *export_name, SceUI
 // *********
 
 inline uint64_t get_current_time() {
-    return std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch())
-        .count();
+    return rtc_ticks_since_epoch();
 }
 
 SceUID timer_create(KernelState &kernel, MemState &mem, const char *export_name, const char *name, SceUID thread_id, SceUInt32 attr) {
@@ -462,13 +485,18 @@ SceInt32 timer_waitorpoll(KernelState &kernel, const char *export_name, SceUID t
 
         bool got_event = false;
         while (!got_event) {
-            uint64_t wait_time = timer->next_event - current_time;
-            // wait before we got an event and we are the first thread in the waiting list
-            timer->condvar.wait_for(lock, std::chrono::microseconds(wait_time), [&] {
-                return (*timer->waiting_threads->begin()).thread->id == thread_id;
-            });
+            const bool is_first_waiting = (*timer->waiting_threads->begin()).thread->id == thread_id;
+            if (!is_first_waiting || timer->next_event == std::numeric_limits<uint64_t>::max()) {
+                // only the first waiting thread sleeps until the event, the others are notified when it got it
+                timer->condvar.wait(lock);
+            } else {
+                // woken up earlier if the timer is changed
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timer->next_event - current_time);
+                timer->condvar.wait_until(lock, deadline);
+            }
             current_time = get_current_time();
-            got_event = timer->event_set || current_time > timer->next_event;
+            got_event = (*timer->waiting_threads->begin()).thread->id == thread_id
+                && (timer->event_set || current_time > timer->next_event);
         }
 
         timer->waiting_threads->pop();
@@ -611,15 +639,13 @@ SceUID mutex_find(KernelState &kernel, const char *export_name, const char *pNam
     return RET_ERROR(SCE_KERNEL_ERROR_UID_CANNOT_FIND_BY_NAME);
 }
 
-inline static int mutex_lock_impl(KernelState &kernel, MemState &mem, const char *export_name, SceUID thread_id, int lock_count, MutexPtr &mutex, SyncWeight weight, SceUInt *timeout, bool only_try) {
+inline static int mutex_lock_impl(KernelState &kernel, MemState &mem, const char *export_name, const ThreadStatePtr &thread, SceUID thread_id, int lock_count, MutexPtr &mutex, SyncWeight weight, SceUInt *timeout, bool only_try) {
     if (LOG_SYNC_PRIMITIVES) {
         LOG_DEBUG("{}: uid: {} thread_id: {} name: \"{}\" attr: {} lock_count: {} timeout: {} waiting_threads: {}",
             export_name, mutex->uid, thread_id, mutex->name, mutex->attr, mutex->lock_count, timeout ? *timeout : 0,
             mutex->waiting_threads->size());
     }
 
-    const ThreadStatePtr thread = kernel.get_thread(thread_id);
-
     std::unique_lock<std::mutex> mutex_lock(mutex->mutex);
 
     bool is_recursive = (mutex->attr & SCE_KERNEL_MUTEX_ATTR_RECURSIVE);
@@ -692,26 +718,26 @@ inline static int mutex_lock_impl(KernelState &kernel, MemState &mem, const char
 int mutex_lock(KernelState &kernel, MemState &mem, const char *export_name, SceUID thread_id, SceUID mutexid, int lock_count, unsigned int *timeout, SyncWeight weight) {
     assert(mutexid >= 0);
 
+    const ThreadStatePtr thread = kernel.get_thread(thread_id);
     MutexPtr mutex;
-    if (auto error = find_mutex(mutex, nullptr, kernel, export_name, mutexid, weight))
+    if (auto error = find_mutex(mutex, nullptr, kernel, export_name, mutexid, weight, thread.get()))
         return error;
 
-    return mutex_lock_impl(kernel, mem, export_name, thread_id, lock_count, mutex, weight, timeout, false);
+    return mutex_lock_impl(kernel, mem, export_name, thread, thread_id, lock_count, mutex, weight, timeout, false);
 }
 
 int mutex_try_lock(KernelState &kernel, MemState &mem, const char *export_name, SceUID thread_id, SceUID mutexid, int lock_count, SyncWeight weight) {
     assert(mutexid >= 0);
 
+    const ThreadStatePtr thread = kernel.get_thread(thread_id);
     MutexPtr mutex;
-    if (auto error = find_mutex(mutex, nullptr, kernel, export_name, mutexid, weight))
+    if (auto error = find_mutex(mutex, nullptr, kernel, export_name, mutexid, weight, thread.get()))
         return error;
 
-    return mutex_lock_impl(kernel, mem, export_name, thread_id, lock_count, mutex, weight, nullptr, true);
+    return mutex_lock_impl(kernel, mem, export_name, thread, thread_id, lock_count, mutex, weight, nullptr, true);
 }
 
-inline static int mutex_unlock_impl(KernelState &kernel, const char *export_name, SceUID thread_id, int unlock_count, MutexPtr &mutex) {
-    const ThreadStatePtr current_thread = kernel.get_thread(thread_id);
-
+inline static int mutex_unlock_impl(const char *export_name, const ThreadStatePtr &current_thread, int unlock_count, MutexPtr &mutex) {
     const std::lock_guard<std::mutex> mutex_lock(mutex->mutex);
 
     if (current_thread == mutex->owner) {
@@ -745,8 +771,9 @@ inline static int mutex_unlock_impl(KernelState &kernel, const char *export_name
 int mutex_unlock(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID mutexid, int unlock_count, SyncWeight weight) {
     assert(mutexid >= 0);
 
+    const ThreadStatePtr thread = kernel.get_thread(thread_id);
     MutexPtr mutex;
-    if (auto error = find_mutex(mutex, nullptr, kernel, export_name, mutexid, weight))
+    if (auto error = find_mutex(mutex, nullptr, kernel, export_name, mutexid, weight, thread.get()))
         return error;
 
     if (LOG_SYNC_PRIMITIVES) {
@@ -755,7 +782,7 @@ int mutex_unlock(KernelState &kernel, const char *export_name, SceUID thread_id,
             mutex->waiting_threads->size());
     }
 
-    return mutex_unlock_impl(kernel, export_name, thread_id, unlock_count, mutex);
+    return mutex_unlock_impl(export_name, thread, unlock_count, mutex);
 }
 
 int mutex_delete(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID mutexid, SyncWeight weight) {
@@ -775,6 +802,7 @@ int mutex_delete(KernelState &kernel, const char *export_name, SceUID thread_id,
     if (mutex->waiting_threads->empty()) {
         const std::lock_guard<std::mutex> kernel_guard(kernel.mutex);
         mutexes->erase(mutexid);
+        mutex->deleted = true;
     } else {
         // TODO:
         LOG_WARN("Can't delete sync object, it has waiting threads.");
@@ -1225,9 +1253,10 @@ SceUID condvar_create(SceUID *uid_out, KernelState &kernel, const char *export_n
 int condvar_wait(KernelState &kernel, MemState &mem, const char *export_name, SceUID thread_id, SceUID condid, SceUInt *timeout, SyncWeight weight) {
     assert(condid >= 0);
 
+    const ThreadStatePtr thread = kernel.get_thread(thread_id);
     CondvarPtr condvar;
     CondvarPtrs *condvars;
-    if (auto error = find_condvar(condvar, &condvars, kernel, export_name, condid, weight))
+    if (auto error = find_condvar(condvar, &condvars, kernel, export_name, condid, weight, thread.get()))
         return error;
 
     if (LOG_SYNC_PRIMITIVES) {
@@ -1236,11 +1265,9 @@ int condvar_wait(KernelState &kernel, MemState &mem, const char *export_name, Sc
             timeout ? *timeout : 0, condvar->waiting_threads->size());
     }
 
-    const ThreadStatePtr thread = kernel.get_thread(thread_id);
-
     std::unique_lock<std::mutex> condition_variable_lock(condvar->mutex);
 
-    if (auto error = mutex_unlock_impl(kernel, export_name, thread_id, 1, condvar->associated_mutex))
+    if (auto error = mutex_unlock_impl(export_name, thread, 1, condvar->associated_mutex))
         return error;
 
     std::unique_lock<std::mutex> thread_lock(thread->mutex);
@@ -1257,15 +1284,16 @@ int condvar_wait(KernelState &kernel, MemState &mem, const char *export_name, Sc
         return error;
 
     condition_variable_lock.unlock();
-    return mutex_lock_impl(kernel, mem, export_name, thread_id, 1, condvar->associated_mutex, weight, timeout, false);
+    return mutex_lock_impl(kernel, mem, export_name, thread, thread_id, 1, condvar->associated_mutex, weight, timeout, false);
 }
 
 int condvar_signal(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID condid, Condvar::SignalTarget signal_target, SyncWeight weight) {
     assert(condid >= 0);
 
+    const ThreadStatePtr thread = kernel.get_thread(thread_id);
     CondvarPtr condvar;
     CondvarPtrs *condvars;
-    if (auto error = find_condvar(condvar, &condvars, kernel, export_name, condid, weight))
+    if (auto error = find_condvar(condvar, &condvars, kernel, export_name, condid, weight, thread.get()))
         return error;
 
     if (LOG_SYNC_PRIMITIVES) {
@@ -1280,7 +1308,7 @@ int condvar_signal(KernelState &kernel, const char *export_name, SceUID thread_i
     auto &waiting_threads = condvar->waiting_threads;
 
     if (target_type == Condvar::SignalTarget::Type::Specific) {
-        ThreadStatePtr waiting_thread = lock_and_find(signal_target.thread_id, kernel.threads, kernel.mutex);
+        ThreadStatePtr waiting_thread = kernel.get_thread(signal_target.thread_id);
         // Search for specified waiting thread
         auto waiting_thread_iter = waiting_threads->find(waiting_thread);
         if (waiting_thread_iter != waiting_threads->end()) {
@@ -1324,6 +1352,7 @@ int condvar_delete(KernelState &kernel, const char *export_name, SceUID thread_i
     if (condvar->waiting_threads->empty()) {
         const std::lock_guard<std::mutex> kernel_lock(kernel.mutex);
         condvars->erase(condid);
+        condvar->deleted = true;
     } else {
         // TODO:
         LOG_WARN("Can't delete sync object, it has waiting threads.");
@@ -1758,7 +1787,7 @@ SceSize msgpipe_recv(KernelState &kernel, const char *export_name, SceUID thread
             return finish();
         } else { // There's a timeout - wait until we can fill buffer or timeout
             msgpipe_lock.unlock(); // Unlock message pipe object, else we'll deadlock
-            auto status = thread->status_cond.wait_for(thread_lock, std::chrono::microseconds{ *pTimeout }, [&] { return thread->status == ThreadStatus::run; });
+            const bool status = wait_run_status(thread, thread_lock, pTimeout);
             if (msgpipe->beingDeleted) {
                 std::atomic_fetch_add(&msgpipe->remainingThreads, static_cast<size_t>(-1));
                 return SCE_KERNEL_ERROR_WAIT_DELETE;
@@ -1862,7 +1891,7 @@ SceSize msgpipe_send(KernelState &kernel, const char *export_name, SceUID thread
             return finish();
         } else { // There's a timeout - wait until we can fill buffer or timeout
             msgpipe_lock.unlock(); // Unlock message pipe object, else we'll deadlock
-            auto status = thread->status_cond.wait_for(thread_lock, std::chrono::microseconds{ *pTimeout }, [&] { return thread->status == ThreadStatus::run; });
+            const bool status = wait_run_status(thread, thread_lock, pTimeout);
             if (msgpipe->beingDeleted) {
                 std::atomic_fetch_add(&msgpipe->remainingThreads, static_cast<size_t>(-1));
                 return SCE_KERNEL_ERROR_WAIT_DELETE;
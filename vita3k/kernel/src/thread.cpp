@@ -21,6 +21,7 @@
 #include <kernel/state.h>
 #include <mem/ptr.h>
 #include <util/align.h>
+#include <util/frame_timings.h>
 
 #include <util/log.h>
 
@@ -54,11 +55,6 @@ int ThreadState::init(const char *name, Ptr<const void> entry_point, int init_pr
     this->name = name;
     this->entry_point = entry_point.address();
 
-    int core_num = kernel.corenum_allocator.new_corenum();
-    if (core_num < 0) {
-        LOG_ERROR("Out of core number to allocate, use 0");
-        core_num = 0;
-    }
 
     if (init_priority > SCE_KERNEL_LOWEST_PRIORITY_USER) {
         assert(SCE_KERNEL_HIGHEST_DEFAULT_PRIORITY <= init_priority && init_priority <= SCE_KERNEL_LOWEST_DEFAULT_PRIORITY);
@@ -71,24 +67,41 @@ int ThreadState::init(const char *name, Ptr<const void> entry_point, int init_pr
     start_tick = rtc_get_ticks(kernel.base_tick.tick);
     last_vblank_waited = 0;
 
-    cpu = init_cpu(kernel.cpu_opt, id, static_cast<std::size_t>(core_num), mem, kernel.cpu_protocol.get());
-    if (!cpu) {
-        return SCE_KERNEL_ERROR_ERROR;
-    }
-    if (kernel.debugger.watch_code) {
-        set_log_code(*cpu, true);
+    if (kernel.cpu_pool.enabled)
+        cpu = kernel.cpu_pool.acquire(this->name);
+
+    if (cpu) {
+        // reuse the jit of a deleted thread, only the register state is reset by start()
+        set_thread_id(*cpu, id);
+        clear_exclusive(kernel.exclusive_monitor, get_processor_id(*cpu));
+        // the profile may have changed since the jit was created
+        set_jit_optimizations(*cpu, kernel.get_jit_optimizations());
+    } else {
+        int core_num = kernel.corenum_allocator.new_corenum();
+        if (core_num < 0) {
+            LOG_ERROR("Out of core number to allocate, use 0");
+            core_num = 0;
+        }
+
+        cpu = init_cpu(kernel.get_jit_optimizations(), id, static_cast<std::size_t>(core_num), mem, kernel.cpu_protocol.get());
+        if (!cpu) {
+            return SCE_KERNEL_ERROR_ERROR;
+        }
     }
-    if (kernel.debugger.watch_memory) {
-        set_log_mem(*cpu, true);
+    set_log_code(*cpu, kernel.debugger.watch_code);
+    set_log_mem(*cpu, kernel.debugger.watch_memory);
+    if (kernel.jit_block_cache.enabled) {
+        cpu->block_cache = &kernel.jit_block_cache;
+        cpu->block_cache_name = this->name;
     }
 
     std::string alloc_name = fmt::format("Stack for thread {} (#{})", name, id);
-    stack = alloc_block(mem, stack_size, alloc_name.c_str());
+    stack = kernel.thread_block_pool.acquire(mem, stack_size, alloc_name.c_str());
     memset(stack.get_ptr<void>().get(mem), 0xcc, stack_size);
 
     alloc_name = fmt::format("TLS for thread {} (#{})", name, id);
-    const size_t tls_size = KERNEL_TLS_SIZE + kernel.tls_msize;
-    tls = alloc_block(mem, tls_size, alloc_name.c_str());
+    tls_size = KERNEL_TLS_SIZE + kernel.tls_msize;
+    tls = kernel.thread_block_pool.acquire(mem, tls_size, alloc_name.c_str());
     const Ptr<uint8_t> base_tls_ptr = tls.get_ptr<uint8_t>();
     memset(base_tls_ptr.get(mem), 0, tls_size);
 
@@ -246,6 +259,12 @@ bool ThreadState::run_loop() {
 
             lock.unlock();
 
+            if (!jit_warmed_up) {
+                // translate the blocks this thread used during the previous runs before running any guest code
+                jit_warmed_up = true;
+                warm_up_jit(*cpu);
+            }
+
             if (run_start_callback) {
                 run_start_callback = false;
 
@@ -257,16 +276,24 @@ bool ThreadState::run_loop() {
             }
 
             // Run the cpu — lock is NOT held on entry, HELD on exit
+            // most exits are svc calls after which the cpu is run again right away, so the lock is
+            // only taken when to_do, which is written with the lock held, says something changed
             while (true) {
-                lock.lock();
-                const bool do_step = (to_do == ThreadToDo::step);
-                if (do_step)
-                    to_do = ThreadToDo::suspend;
-                lock.unlock();
+                bool do_step = false;
+                if (to_do.load(std::memory_order_acquire) == ThreadToDo::step) {
+                    lock.lock();
+                    do_step = (to_do == ThreadToDo::step);
+                    if (do_step)
+                        to_do = ThreadToDo::suspend;
+                    lock.unlock();
+                }
 
                 if (do_step)
                     res = step(*cpu);
-                else
+                else if (is_main_thread) {
+                    const frame_timings::Scope timing(frame_timings::Stage::GuestCpu);
+                    res = run(*cpu);
+                } else
                     res = run(*cpu);
 
                 // handle svc call if this was what stopped the cpu
@@ -274,6 +301,18 @@ bool ThreadState::run_loop() {
                     cpu->protocol->call_svc(*cpu, cpu->svc, read_pc(*cpu), *this);
                 }
 
+                if (host_policy_changed.load(std::memory_order_relaxed)) {
+                    host_policy_changed = false;
+                    kernel.host_thread_policy.apply(affinity_mask, priority);
+                }
+
+                // the access which fired a memory watch is done, its range can be protected again
+                if (kernel.debugger.watch_fired.load(std::memory_order_relaxed))
+                    kernel.debugger.rearm_watches(mem);
+
+                if (to_do.load(std::memory_order_acquire) == ThreadToDo::run && res == 0 && call_level == run_level && !hit_breakpoint(*cpu))
+                    continue;
+
                 lock.lock();
                 if (to_do != ThreadToDo::run || res != 0 || call_level != run_level || hit_breakpoint(*cpu))
                     break;
@@ -342,37 +381,51 @@ void ThreadState::push_arguments(const std::vector<uint32_t> &args) {
 }
 
 uint32_t ThreadState::run_callback(Address callback_address, const std::vector<uint32_t> &args) {
+    std::vector<uint32_t> results = run_callbacks({ { callback_address, args } });
+    return results.empty() ? 0 : results[0];
+}
+
+std::vector<uint32_t> ThreadState::run_callbacks(const std::vector<CallbackCall> &calls) {
     if (call_level == 0) {
         LOG_ERROR("run_callback should not be called as the first thread entry");
-        return 0;
+        return {};
     }
 
     // first save the current context
     const CPUContext previous_ctx = save_context(*cpu);
     const uint32_t previous_tpidruro = read_tpidruro(*cpu);
 
-    std::unique_lock<std::mutex> thread_lock(mutex);
-    call_level++;
-    // we shouldn't have to clean the context I believe
-    write_pc(*cpu, callback_address);
-    write_lr(*cpu, cpu->halt_instruction_pc);
-    push_arguments(args);
-    thread_lock.unlock();
-
-    // unlock but then immediately lock back in the run_loop function
-    // shouldn't cause an issue, but maybe we could use a recursive mutex instead
-    run_loop();
+    std::vector<uint32_t> results;
+    results.reserve(calls.size());
+    std::unique_lock<std::mutex> thread_lock(mutex, std::defer_lock);
+    for (const CallbackCall &call : calls) {
+        thread_lock.lock();
+        call_level++;
+        // we shouldn't have to clean the context I believe
+        write_pc(*cpu, call.address);
+        write_lr(*cpu, cpu->halt_instruction_pc);
+        push_arguments(call.args);
+        thread_lock.unlock();
+
+        // unlock but then immediately lock back in the run_loop function
+        // shouldn't cause an issue, but maybe we could use a recursive mutex instead
+        run_loop();
+
+        thread_lock.lock();
+        results.push_back(returned_value);
+        thread_lock.unlock();
+    }
 
     thread_lock.lock();
 
-    // restore the previous context
+    // restore the previous context, only once for all the callbacks
     // actually, in most case I don't think this is necessary as the caller
     // and the callee should respect the same calling convention
     // but do it just in case
     load_context(*cpu, previous_ctx);
     write_tpidruro(*cpu, previous_tpidruro);
 
-    return returned_value;
+    return results;
 }
 
 uint32_t ThreadState::run_guest_function(Address callback_address, SceSize args, const Ptr<void> argp) {
@@ -401,6 +454,18 @@ ThreadState::ThreadState(SceUID id, KernelState &kernel, MemState &mem)
     , mem(mem) {
 }
 
+ThreadState::~ThreadState() {
+    kernel.thread_block_pool.release(stack, stack_size);
+    kernel.thread_block_pool.release(tls, tls_size);
+
+    if (!cpu || !kernel.cpu_pool.enabled)
+        return;
+
+    const std::size_t core_num = get_processor_id(*cpu);
+    if (!kernel.cpu_pool.release(name, cpu))
+        kernel.corenum_allocator.free_corenum(static_cast<int>(core_num));
+}
+
 void ThreadState::update_status(ThreadStatus status, std::optional<ThreadStatus> expected) {
     if (expected)
         assert(expected.value() == this->status);
@@ -126,6 +126,8 @@ struct LangState {
             { "lightweight_condition_variables", "Lightweight Condition Variables" },
             { "event_flags", "Event Flags" },
             { "memory_allocations", "Memory Allocations" },
+            { "io_statistics", "IO Statistics" },
+            { "hle_profiler", "HLE Profiler" },
             { "disassembly", "Disassembly" }
         };
         std::map<std::string, std::string> configuration = {
@@ -332,6 +334,8 @@ struct LangState {
         { "miscellaneous", "Miscellaneous" },
         { "toggle_texture_replacement", "Toggle Texture Replacement" },
         { "take_screenshot", "Take A Screenshot" },
+        { "save_state", "Save State" },
+        { "load_state", "Load State" },
         { "pinch_modifier", "Pinch modifier" },
         { "alternate_pinch_in", "Alternate pinch in key" },
         { "alternate_pinch_out", "Alternate pinch out/stretch key" },
@@ -484,7 +488,42 @@ struct LangState {
     std::map<std::string, std::string> performance_overlay = {
         { "avg", "Avg" },
         { "min", "Min" },
-        { "max", "Max" }
+        { "max", "Max" },
+        { "descriptor_sets", "Descriptor sets" },
+        { "pushed", "Pushed" },
+        { "color_reads", "Color reads" },
+        { "barriers", "barriers" },
+        { "gpu", "GPU" },
+        { "transfer", "Transfer" },
+        { "surface_sync", "Surface sync" },
+        { "scenes", "scenes" },
+        { "screen_filter", "Screen filter" },
+        { "latency", "Latency" },
+        { "ring_buffer_stalls", "Ring buffer stalls" },
+        { "mapped_copies", "Mapped memory copies" },
+        { "surface_cache", "Surface cache" },
+        { "evicted", "evicted" },
+        { "audio_underruns", "Audio underruns" },
+        { "overruns", "overruns" },
+        { "ngs", "NGS" },
+        { "decoders", "Decoders" },
+        { "queued", "Queued" },
+        { "frame", "Frame" },
+        { "guest_cpu", "Guest CPU" },
+        { "render_commands", "Render commands" },
+        { "pipeline_wait", "Pipeline wait" },
+        { "texture_upload", "Texture upload" },
+        { "present_wait", "Present wait" },
+        { "pipelines", "Pipelines" },
+        { "shaders", "Shaders" },
+        { "misses", "misses" },
+        { "sync", "sync" },
+        { "async", "async" },
+        { "last_stutter", "Last stutter" },
+        { "compilation", "compilation" },
+        { "other", "other" },
+        { "exclusive_stores", "Exclusive stores" },
+        { "failed", "failed" }
     };
     struct Settings {
         std::map<std::string, std::string> main = { { "title", "Settings" } };
@@ -578,7 +617,9 @@ struct LangState {
         };
         std::map<std::string, std::string> cpu = {
             { "cpu_opt", "Enable optimizations" },
-            { "cpu_opt_description", "Check the box to enable additional CPU JIT optimizations." }
+            { "cpu_opt_description", "Check the box to enable additional CPU JIT optimizations." },
+            { "cpu_profile", "Optimization profile" },
+            { "cpu_profile_description", "The unsafe profiles are faster but less accurate. Auto uses the profile recorded by the last benchmark of the app (--benchmark-cpu-profiles), or the default one." }
         };
         std::map<std::string, std::string> gpu = {
             { "reset", "Reset" },
@@ -696,6 +737,9 @@ struct LangState {
             { "low", "Low" },
             { "medium", "Medium" },
             { "maximum", "Maximum" },
+            { "gpu_timings", "GPU Timings" },
+            { "audio_timings", "Audio Timings" },
+            { "frame_timings", "Frame Timings" },
             { "detail", "Detail" },
             { "select_detail", "Select your preferred performance overlay detail." },
             { "top_left", "Top Left" },
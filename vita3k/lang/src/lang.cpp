@@ -97,17 +97,22 @@ void init_lang(LangState &lang, EmuEnvState &emuenv) {
             // Lang
             const auto lang_child = lang_xml.child("lang");
             if (!lang_child.empty()) {
+                // Walk the children of the section once and look each of them up in the strings of the dialog,
+                // instead of searching the section for every string. The children are walked from the last one
+                // so that the first of duplicated ids wins, like with child(id).
                 const auto set_lang_string = [](std::map<std::string, std::string> &lang_dest, const pugi::xml_node child) {
                     if (!child.empty()) {
-                        for (auto &dest : lang_dest) {
-                            if (dest.first == "title") {
-                                if (!child.attribute("name").empty())
-                                    dest.second = child.attribute("name").as_string();
-                            } else {
-                                const auto id = dest.first.c_str();
-                                if (!child.child(id).empty())
-                                    dest.second = child.child(id).text().as_string();
-                            }
+                        if (!child.attribute("name").empty()) {
+                            const auto title = lang_dest.find("title");
+                            if (title != lang_dest.end())
+                                title->second = child.attribute("name").as_string();
+                        }
+                        for (auto node = child.last_child(); node; node = node.previous_sibling()) {
+                            if (node.type() != pugi::node_element)
+                                continue;
+                            const auto dest = lang_dest.find(node.name());
+                            if ((dest != lang_dest.end()) && (dest->first != "title"))
+                                dest->second = node.text().as_string();
                         }
                     }
                 };
@@ -17,9 +17,15 @@
 
 #include "interface.h"
 
+#include <app/cpu_profile_benchmark.h>
 #include <app/functions.h>
+#include <app/perf_run.h>
+#include <app/save_state.h>
+#include <audio/state.h>
+#include <codec/recorder.h>
 #include <config/functions.h>
 #include <config/version.h>
+#include <ctrl/functions.h>
 #include <dialog/state.h>
 #include <display/state.h>
 #include <emuenv/state.h>
@@ -38,6 +44,8 @@
 #include <renderer/shaders.h>
 #include <renderer/state.h>
 #include <shader/spirv_recompiler.h>
+#include <util/boot_trace.h>
+#include <util/frame_timings.h>
 #include <util/log.h>
 #include <util/string_utils.h>
 
@@ -59,18 +67,40 @@
 #include <SDL3/SDL_system.h>
 #include <jni.h>
 #include <unistd.h>
-#include <xxh3.h>
 #endif
 
 #include <SDL3/SDL_cpuinfo.h>
 #include <SDL3/SDL_hints.h>
 #include <SDL3/SDL_init.h>
 #include <SDL3/SDL_main.h>
+#include <SDL3/SDL_video.h>
+
+#include <xxh3.h>
 
 #include <chrono>
 #include <cstdlib>
+#include <memory>
+#include <optional>
 #include <thread>
 
+// used with --log-frame-hashes, two runs of an app can be compared frame by frame
+static void log_frame_hash(EmuEnvState &emuenv) {
+    uint32_t width, height;
+    const std::vector<uint32_t> frame = emuenv.renderer->dump_frame(emuenv.display, width, height);
+    if (frame.empty())
+        return;
+
+    const uint64_t hash = XXH3_64bits(frame.data(), frame.size() * sizeof(uint32_t));
+    LOG_INFO("Frame {} ({}x{}) hash: {:016X}", emuenv.frame_count, width, height, hash);
+}
+
+// used with --record-video, the frame is read back here and encoded by the thread of the recorder
+static void record_frame(EmuEnvState &emuenv, VideoRecorder &recorder) {
+    uint32_t width, height;
+    std::vector<uint32_t> frame = emuenv.renderer->dump_frame(emuenv.display, width, height);
+    recorder.add_frame(std::move(frame), width, height);
+}
+
 #ifdef __ANDROID__
 static void set_current_game_id(const std::string_view game_id) {
     // retrieve the JNI environment.
@@ -326,8 +356,8 @@ int main(int argc, char *argv[]) {
 
     if (!cfg.console) {
         gui::pre_init(gui, emuenv);
-        gui::init_bgm_player(emuenv.cfg.bgm_volume);
-        if (!emuenv.cfg.initial_setup) {
+        gui::init_bgm_player(emuenv, emuenv.cfg.bgm_volume);
+        if (!emuenv.cfg.initial_setup && !cfg.headless) {
             emuenv.cfg.system_music.emplace(false);
             if (gui::init_bgm(gui, emuenv))
                 gui::switch_bgm_state(true);
@@ -381,6 +411,12 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // there is no app selector to fall back to
+    if (cfg.headless && (run_type == app::AppRunType::Unknown)) {
+        LOG_ERROR("Headless mode could not find an app to run.");
+        return InvalidApplicationPath;
+    }
+
     if (run_type == app::AppRunType::Extracted) {
         emuenv.io.app_path = cfg.run_app_path ? *cfg.run_app_path : emuenv.app_info.app_title_id;
         gui::init_user_app(gui, emuenv, emuenv.io.app_path);
@@ -474,6 +510,7 @@ int main(int argc, char *argv[]) {
     gui::init_app_background(gui, emuenv, emuenv.io.app_path);
     gui::update_last_time_app_used(gui, emuenv, emuenv.io.app_path);
 
+    boot_trace::begin_app_boot();
     if (!app::late_init(emuenv)) {
         app::error_dialog("Failed to initialize Vita3K", emuenv.window.get());
         return 1;
@@ -501,10 +538,18 @@ int main(int argc, char *argv[]) {
 
     // Pre-Compile Shaders
     emuenv.renderer->set_app(emuenv.io.title_id.c_str(), emuenv.self_name.c_str());
-    if (renderer::get_shaders_cache_hashs(*emuenv.renderer) && cfg.shader_cache) {
+    bool has_shaders_cache = renderer::get_shaders_cache_hashs(*emuenv.renderer);
+    if (cfg.import_shader_cache_path.has_value())
+        has_shaders_cache = renderer::import_shader_cache(*emuenv.renderer, fs_utils::utf8_to_path(*cfg.import_shader_cache_path)) || has_shaders_cache;
+    if (has_shaders_cache && cfg.shader_cache) {
+        const boot_trace::Span span("Shader cache preload");
         SDL_SetWindowTitle(emuenv.window.get(), fmt::format("{} | {} ({}) | Please wait, compiling shaders...", window_title, emuenv.current_app_title, emuenv.io.title_id).c_str());
         for (const auto &hash : emuenv.renderer->shaders_cache_hashs) {
             handle_events(emuenv, gui);
+            if (cfg.headless) {
+                emuenv.renderer->precompile_shader(hash);
+                continue;
+            }
             gui::draw_begin(gui, emuenv);
             draw_app_background(gui, emuenv);
 
@@ -514,6 +559,46 @@ int main(int argc, char *argv[]) {
             gui::draw_end(gui);
             emuenv.renderer->swap_window(emuenv.window.get());
         }
+
+        // Pre-Compile Pipelines
+        const uint32_t pipelines_count = emuenv.renderer->get_pipelines_to_preload_count();
+        if (pipelines_count > 0) {
+            SDL_SetWindowTitle(emuenv.window.get(), fmt::format("{} | {} ({}) | Please wait, compiling pipelines...", window_title, emuenv.current_app_title, emuenv.io.title_id).c_str());
+            emuenv.renderer->programs_count_pre_compiled = 0;
+            bool pipelines_left = true;
+            while (pipelines_left) {
+                handle_events(emuenv, gui);
+                if (cfg.headless) {
+                    pipelines_left = emuenv.renderer->preload_pipelines();
+                    continue;
+                }
+                gui::draw_begin(gui, emuenv);
+                draw_app_background(gui, emuenv);
+
+                pipelines_left = emuenv.renderer->preload_pipelines();
+                gui::draw_pre_compiling_shaders_progress(gui, emuenv, pipelines_count);
+
+                gui::draw_end(gui);
+                emuenv.renderer->swap_window(emuenv.window.get());
+            }
+        }
+    }
+    if (cfg.input_script_path.has_value() && !load_input_script(emuenv.ctrl, fs_utils::utf8_to_path(*cfg.input_script_path)))
+        return InitConfigFailed;
+    // shared with the audio callback, which can still be called by the guest threads once the recording is stopped
+    std::shared_ptr<VideoRecorder> video_recorder;
+    if (cfg.record_video_path.has_value()) {
+        video_recorder = std::make_shared<VideoRecorder>();
+        if (video_recorder->start(fs_utils::utf8_to_path(*cfg.record_video_path), 60)) {
+            emuenv.audio.output_callback = [video_recorder](const AudioOutPort &out_port, const void *buffer) {
+                if (out_port.len <= 0)
+                    return;
+                const int nb_channels = out_port.len_bytes / (out_port.len * static_cast<int>(sizeof(int16_t)));
+                video_recorder->add_audio(&out_port, static_cast<const int16_t *>(buffer), out_port.len, nb_channels, out_port.freq, out_port.volume);
+            };
+        } else {
+            video_recorder.reset();
+        }
     }
     {
         const auto err = run_app(emuenv, main_module_id);
@@ -522,11 +607,15 @@ int main(int argc, char *argv[]) {
     }
     SDL_SetWindowTitle(emuenv.window.get(), fmt::format("{} | {} ({}) | Please wait, loading...", window_title, emuenv.current_app_title, emuenv.io.title_id).c_str());
 
+    std::optional<boot_trace::Span> first_frame_span;
+    first_frame_span.emplace("Waiting for the first frame");
     while (handle_events(emuenv, gui) && (emuenv.frame_count == 0) && !emuenv.load_exec) {
 #ifdef TRACY_ENABLE
         ZoneScopedN("Game loading"); // Tracy - Track game loading loop scope
 #endif
-        wait_for_frame_done();
+        // nothing is presented in headless mode, no need to wait for the screen
+        if (!cfg.headless)
+            wait_for_frame_done();
 
         // Driver acto!
         renderer::process_batches(*emuenv.renderer.get(), emuenv.renderer->features, emuenv.mem, emuenv.cfg);
@@ -535,17 +624,40 @@ int main(int argc, char *argv[]) {
         const SceFVector2 viewport_size = { emuenv.drawable_viewport_size.x, emuenv.drawable_viewport_size.y };
         emuenv.renderer->render_frame(viewport_pos, viewport_size, emuenv.display, emuenv.gxm, emuenv.mem);
 
-        gui::draw_begin(gui, emuenv);
-        gui::draw_common_dialog(gui, emuenv);
-        draw_app_background(gui, emuenv);
+        if (!cfg.headless) {
+            gui::draw_begin(gui, emuenv);
+            gui::draw_common_dialog(gui, emuenv);
+            draw_app_background(gui, emuenv);
 
-        gui::draw_end(gui);
+            gui::draw_end(gui);
+        }
         emuenv.renderer->swap_window(emuenv.window.get());
 #ifdef TRACY_ENABLE
         FrameMark; // Tracy - Frame end mark for game loading loop
 #endif
     }
 
+    first_frame_span.reset();
+    if (emuenv.frame_count != 0)
+        boot_trace::end(emuenv.cfg.boot_trace ? emuenv.log_path / "boot_trace.json" : fs::path{});
+    end_boot_modules_prefetch(emuenv);
+
+    // present the last frame of the game at each host refresh, the game still runs at its own rate
+    if (emuenv.cfg.decouple_display_rate && !cfg.headless) {
+        const SDL_DisplayMode *display_mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(emuenv.window.get()));
+        if (display_mode && display_mode->refresh_rate > 0.0f) {
+            emuenv.renderer->display_interval = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<float>(1.0f / display_mode->refresh_rate));
+            LOG_INFO("Display rate decoupled from the game, presenting at {} Hz", display_mode->refresh_rate);
+        }
+    }
+
+    std::optional<app::PerfRun> perf_run;
+    if (cfg.perf_run_seconds.has_value() && emuenv.frame_count != 0)
+        perf_run.emplace(emuenv, std::chrono::seconds(*cfg.perf_run_seconds));
+    std::optional<app::CpuProfileBenchmark> cpu_profile_benchmark;
+    if (cfg.benchmark_cpu_profiles_seconds.has_value() && emuenv.frame_count != 0)
+        cpu_profile_benchmark.emplace(emuenv, std::chrono::seconds(*cfg.benchmark_cpu_profiles_seconds));
+
     while (handle_events(emuenv, gui) && !emuenv.load_exec) {
 #ifdef TRACY_ENABLE
         ZoneScopedN("Game rendering"); // Tracy - Track game rendering loop scope
@@ -556,12 +668,41 @@ int main(int argc, char *argv[]) {
         // Driver acto!
         renderer::process_batches(*emuenv.renderer.get(), emuenv.renderer->features, emuenv.mem, emuenv.cfg);
 
+        const bool has_new_frame = emuenv.renderer->should_display;
         const SceFVector2 viewport_pos = { emuenv.drawable_viewport_pos.x, emuenv.drawable_viewport_pos.y };
         const SceFVector2 viewport_size = { emuenv.drawable_viewport_size.x, emuenv.drawable_viewport_size.y };
         emuenv.renderer->render_frame(viewport_pos, viewport_size, emuenv.display, emuenv.gxm, emuenv.mem);
+        if (cfg.log_frame_hashes && has_new_frame)
+            log_frame_hash(emuenv);
+        if (video_recorder && has_new_frame)
+            record_frame(emuenv, *video_recorder);
+        // the timers only run while the breakdown is shown by the performance overlay
+        frame_timings::enabled = cfg.performance_overlay && cfg.performance_overlay_detail == FRAME_TIMINGS;
+        if (has_new_frame)
+            frame_timings::end_frame();
+        if (perf_run) {
+            if (has_new_frame)
+                perf_run->on_frame();
+            if (perf_run->is_done())
+                break;
+        }
+        if (cpu_profile_benchmark && !cpu_profile_benchmark->is_done()) {
+            if (has_new_frame)
+                cpu_profile_benchmark->on_frame();
+            cpu_profile_benchmark->update(emuenv);
+        }
+
         // Calculate FPS
         app::calculate_fps(emuenv);
 
+        if (cfg.headless) {
+            emuenv.renderer->swap_window(emuenv.window.get());
+#ifdef TRACY_ENABLE
+            FrameMark; // Tracy - Frame end mark for game rendering loop
+#endif
+            continue;
+        }
+
         // Set shaders compiled display
         gui::set_shaders_compiled_display(gui, emuenv);
 
@@ -594,7 +735,16 @@ int main(int argc, char *argv[]) {
     CoUninitialize();
 #endif
 
+    if (video_recorder)
+        video_recorder->stop();
+
+    if (perf_run)
+        perf_run->save_report(emuenv, cfg.perf_report_path.has_value() ? fs_utils::utf8_to_path(*cfg.perf_report_path) : emuenv.log_path / "perf_report.json");
+
+    app::wait_for_save_state();
     emuenv.renderer->preclose_action();
+    if (cfg.export_shader_cache_path.has_value())
+        renderer::export_shader_cache(*emuenv.renderer, fs_utils::utf8_to_path(*cfg.export_shader_cache_path));
     app::destroy(emuenv, gui.imgui_state.get());
 
     if (emuenv.load_exec)
@@ -20,12 +20,32 @@
 #include <cstdint>
 #include <vector>
 
+// Each bit tells if a slot is free (1) or not (0), the first slot being the most significant bit of the first word
 struct BitmapAllocator {
     std::vector<std::uint32_t> words;
     std::size_t max_offset;
 
 protected:
+    // free runs of a group of 64 words, used to skip the groups where an allocation cannot fit
+    // these are upper bounds: words may have been modified directly, only to allocate slots
+    struct GroupSummary {
+        std::uint16_t prefix; // free slots at the beginning of the group
+        std::uint16_t suffix; // free slots at the end of the group
+        std::uint16_t max_run; // longest run of free slots inside the group
+    };
+    static constexpr std::uint32_t GROUP_WORDS = 64;
+    static constexpr std::uint32_t GROUP_BITS = GROUP_WORDS * 32;
+    std::vector<GroupSummary> groups;
+
     int force_fill(const std::uint32_t offset, const std::uint32_t size, const bool or_mode = false);
+    int fill_words(const std::uint32_t offset, const std::uint32_t size, const bool or_mode);
+    void update_groups(const std::size_t first_word, const std::size_t last_word);
+    // first free slot at or after offset, -1 if none
+    int find_free_slot(std::uint32_t offset) const;
+    // number of consecutive free slots starting at offset, stops counting once max_length is reached
+    std::uint32_t free_run_length(const std::uint32_t offset, const std::uint32_t max_length) const;
+    int find_first_fit(const std::uint32_t start_offset, const std::uint32_t size) const;
+    int find_best_fit(const std::uint32_t start_offset, const std::uint32_t size) const;
 
 public:
     BitmapAllocator() = default;
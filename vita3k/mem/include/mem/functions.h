@@ -21,6 +21,7 @@
 #include <mem/util.h>
 
 #include <functional>
+#include <optional>
 
 struct MemState;
 
@@ -55,9 +56,32 @@ void unprotect_inner(MemState &state, Address addr, uint32_t size);
 bool add_protect(MemState &state, Address addr, const uint32_t size, const MemPerm perm, const ProtectCallback &callback);
 void open_access_parent_protect_segment(MemState &state, Address addr);
 void close_access_parent_protect_segment(MemState &state, Address addr);
+// Linux only, true if the host mapping of size bytes at addr_ptr (memory mapped by the graphics driver for example)
+// can be moved into the guest memory, so that external mappings keep the fastmem accesses without a page table.
+// The mapping is back at addr_ptr when this returns.
+bool can_move_external_mapping(uint8_t *addr_ptr, uint32_t size);
 void add_external_mapping(MemState &mem, Address addr, uint32_t size, uint8_t *addr_ptr);
 void remove_external_mapping(MemState &mem, uint8_t *addr_ptr, uint32_t size);
 bool is_protecting(MemState &state, Address addr, MemPerm *perm = nullptr);
+// Lightweight alternative to add_protect when the only thing needed is to know if a range was written to.
+// Faults on these pages only unprotect the page and bump its write sequence, no callback is involved and
+// pages which are already tracked are not protected again.
+// Returns the current write sequence, to be given to was_written_since.
+uint32_t track_writes(MemState &state, Address addr, uint32_t size);
+// true if a page of the range was written to after the call to track_writes which returned this sequence
+bool was_written_since(const MemState &state, Address addr, uint32_t size, uint32_t sequence);
+// To be called by the host before it writes a large buffer to the guest memory (a decoded video frame for example).
+// The tracked pages of the range are marked as written and made writable at once instead of faulting one by one.
+void mark_written(MemState &state, Address addr, uint32_t size);
+// Linux only: use the soft-dirty bits of the kernel for track_writes, so that writes do not fault anymore.
+// Returns false if this is not supported, in which case page protection keeps being used.
+bool enable_soft_dirty_tracking(MemState &state);
+// must be called regularly (once per frame) when soft-dirty tracking is used, does nothing otherwise
+void collect_written_pages(MemState &state);
+// Linux only, to be called regularly (once per frame) when use_cold_pages is set. When the host is low on memory, the
+// allocated guest memory is regularly marked as cold: the kernel reclaims the pages which are not accessed again before
+// it needs memory (to zram on Android, where they are compressed), the others stay resident.
+void advise_cold_pages(MemState &state);
 bool is_valid_addr(const MemState &state, Address addr);
 bool is_valid_addr_range(const MemState &state, Address start, Address end);
 bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcept;
@@ -66,4 +90,13 @@ Address alloc_at(MemState &state, Address address, uint32_t size, const char *na
 Address try_alloc_at(MemState &state, Address address, uint32_t size, const char *name);
 void free(MemState &state, Address address);
 uint32_t mem_available(MemState &state);
+// how much of the range is backed by host memory, the pages are only committed by the host when first touched
+std::optional<size_t> get_resident_size(const MemState &state, Address addr, uint32_t size);
+// log the protect_mutex contention and how much of the guest memory is actually backed by huge pages
+void log_mem_stats(const MemState &state);
 const char *mem_name(Address address, MemState &state);
+
+// The following functions handle guest ranges which are not contiguous on the host (when the page table is used)
+void copy_guest_memory(MemState &state, Address dst, Address src, uint32_t size);
+void move_guest_memory(MemState &state, Address dst, Address src, uint32_t size);
+void fill_guest_memory(MemState &state, Address dst, uint8_t value, uint32_t size);
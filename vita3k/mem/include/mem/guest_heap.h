@@ -0,0 +1,84 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h>
+#include <util/containers.h>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct MemState;
+
+/**
+ * @brief Heap behind the HLE libc malloc
+ *
+ * Each allocation used to get its own pages from the guest memory allocator, so a 16 bytes
+ * allocation took a whole page. When slabs are enabled, small allocations are packed in
+ * 64 KiB slabs, one slab holding blocks of a single size class, larger ones still get their own pages.
+ * Statistics are kept in both modes so that the waste of each mode can be compared.
+ */
+class GuestHeap {
+public:
+    static constexpr uint32_t SLAB_SIZE = KiB(64);
+    static constexpr std::array<uint32_t, 14> SIZE_CLASSES = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048 };
+
+    bool use_slabs = false;
+
+    // returns 0 if the guest memory is full
+    Address allocate(MemState &mem, uint32_t size, uint32_t alignment = 0);
+    // returns false if the address was not allocated by this heap
+    bool free(MemState &mem, Address address);
+    // returns 0 if the address was not allocated by this heap
+    uint32_t usable_size(Address address);
+
+    void log_stats();
+
+private:
+    struct SizeClass {
+        std::vector<Address> free_blocks;
+        // next block never used in the last slab of this class
+        Address next_block = 0;
+        Address slab_end = 0;
+    };
+
+    // allocations counted by requested size, the last entry is for the ones larger than every class
+    struct ClassStats {
+        uint64_t nb_allocs = 0;
+        uint32_t nb_live = 0;
+    };
+
+    // index of the smallest class fitting this allocation, SIZE_CLASSES.size() if there is none
+    static uint32_t get_size_class(uint32_t size, uint32_t alignment);
+
+    std::mutex mutex;
+    std::array<SizeClass, SIZE_CLASSES.size()> classes;
+    std::array<ClassStats, SIZE_CLASSES.size() + 1> class_stats;
+    // size class of each slab, indexed by slab base address
+    unordered_map_fast<Address, uint8_t> slabs;
+    // size requested for each allocation, needed to keep the statistics right when it is freed
+    unordered_map_fast<Address, uint32_t> sizes;
+
+    uint64_t live_size = 0;
+    uint64_t peak_live_size = 0;
+    // guest memory taken from the allocator, slabs included
+    uint64_t reserved_size = 0;
+    uint64_t peak_reserved_size = 0;
+};
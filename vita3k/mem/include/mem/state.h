@@ -21,9 +21,12 @@
 #include <mem/functions.h>
 #include <mem/util.h>
 
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 struct AllocMemPage {
     uint32_t allocated : 4;
@@ -44,7 +47,8 @@ struct ProtectBlockInfo {
 };
 
 struct ProtectSegmentInfo {
-    std::multimap<Address, ProtectBlockInfo> blocks;
+    // only iterated when the segment is triggered, so no need for them to be sorted
+    std::vector<ProtectBlockInfo> blocks;
     uint32_t size = 0;
     MemPerm perm = MemPerm::None;
 
@@ -71,10 +75,37 @@ struct MemState {
     AllocPageTable alloc_table;
     BitmapAllocator allocator;
     ProtectSegmentTrees protect_tree;
+    // one bit per page, set if the page is covered by a segment of protect_tree
+    // written with protect_mutex locked, but can be read without it
+    std::unique_ptr<std::atomic<uint64_t>[]> protected_pages;
+    // how many times protect_mutex was taken, and how many times another thread was already holding it
+    std::atomic<uint64_t> protect_lock_count = 0;
+    std::atomic<uint64_t> protect_lock_contended = 0;
+
+    // see track_writes, everything except page_write_sequence is guarded by protect_mutex
+    // one bit per page, set if the page is protected only to know when it is written to
+    std::unique_ptr<uint64_t[]> write_tracked_pages;
+    // for each page, the sequence number of the last write detected on it
+    std::unique_ptr<std::atomic<uint32_t>[]> page_write_sequence;
+    uint32_t write_sequence = 0;
+    // the kernel soft-dirty bits are used instead of protecting the pages, see enable_soft_dirty_tracking
+    bool use_soft_dirty = false;
 
     PageNameMap page_name_map;
 
     bool use_page_table = false;
+    // Linux only, back the allocated guest memory with transparent huge pages when possible
+    bool use_huge_pages = false;
+    // how much of the allocated memory was advised to use huge pages
+    size_t huge_page_advised_size = 0;
+    // Linux only, let the kernel reclaim the guest pages which are not accessed anymore when the host is low on memory
+    bool use_cold_pages = false;
+    std::chrono::steady_clock::time_point last_cold_pages_pass;
     PageTable page_table;
     std::map<uint64_t, MemExternalMapping, std::greater<>> external_mapping;
+    // Linux only, the external mappings are moved into the guest memory instead of going through the page table,
+    // see can_move_external_mapping
+    bool move_external_mappings = false;
+    // for each moved external mapping, the host address it came from, where it goes back when removed
+    std::map<Address, uint8_t *> moved_mappings;
 };
@@ -17,9 +17,58 @@
 
 #include <mem/allocator.h>
 
+#include <algorithm>
+#include <bit>
+
 BitmapAllocator::BitmapAllocator(const std::size_t total_bits)
     : words((total_bits >> 5) + ((total_bits % 32 != 0) ? 1 : 0), 0xFFFFFFFF)
     , max_offset(total_bits) {
+    update_groups(0, words.size() - 1);
+}
+
+// longest run of set bits
+static std::uint32_t longest_run(std::uint32_t word) {
+    std::uint32_t length = 0;
+    while (word != 0) {
+        word &= word << 1;
+        length++;
+    }
+    return length;
+}
+
+void BitmapAllocator::update_groups(const std::size_t first_word, const std::size_t last_word) {
+    groups.resize((words.size() + GROUP_WORDS - 1) / GROUP_WORDS);
+    if (words.empty())
+        return;
+
+    const std::size_t last_group = std::min(last_word, words.size() - 1) / GROUP_WORDS;
+    for (std::size_t group = first_word / GROUP_WORDS; group <= last_group; group++) {
+        const std::size_t begin = group * GROUP_WORDS;
+        const std::size_t end = std::min<std::size_t>(begin + GROUP_WORDS, words.size());
+
+        std::uint32_t prefix = 0;
+        std::uint32_t run = 0;
+        std::uint32_t max_run = 0;
+        bool is_prefix = true;
+        for (std::size_t i = begin; i < end; i++) {
+            const std::uint32_t word = words[i];
+            if (word == 0xFFFFFFFFU) {
+                run += 32;
+                if (is_prefix)
+                    prefix += 32;
+            } else {
+                const std::uint32_t lead = std::countl_one(word);
+                max_run = std::max({ max_run, run + lead, longest_run(word) });
+                if (is_prefix)
+                    prefix += lead;
+                is_prefix = false;
+                run = std::countr_one(word);
+            }
+            max_run = std::max(max_run, run);
+        }
+
+        groups[group] = { static_cast<std::uint16_t>(prefix), static_cast<std::uint16_t>(run), static_cast<std::uint16_t>(max_run) };
+    }
 }
 
 void BitmapAllocator::set_maximum(const std::size_t total_bits) {
@@ -35,13 +84,23 @@ void BitmapAllocator::set_maximum(const std::size_t total_bits) {
     }
 
     max_offset = total_bits;
+    update_groups(0, words.size() - 1);
 }
 
 void BitmapAllocator::reset() {
     words.clear();
+    groups.clear();
 }
 
 int BitmapAllocator::force_fill(const std::uint32_t offset, const std::uint32_t size, const bool or_mode) {
+    const std::size_t first_word = offset >> 5;
+    const std::size_t last_word = (static_cast<std::size_t>(offset) + std::max<std::uint32_t>(size, 1) - 1) >> 5;
+    const int filled = fill_words(offset, size, or_mode);
+    update_groups(first_word, last_word);
+    return filled;
+}
+
+int BitmapAllocator::fill_words(const std::uint32_t offset, const std::uint32_t size, const bool or_mode) {
     std::uint32_t *word = &words[0] + (offset >> 5);
     const std::uint32_t set_bit = offset & 31;
     std::uint32_t end_bit = set_bit + size;
@@ -97,84 +156,109 @@ void BitmapAllocator::free(const std::uint32_t offset, const std::uint32_t size)
     force_fill(offset, size, true);
 }
 
-int BitmapAllocator::allocate_from(const std::uint32_t start_offset, std::uint32_t &size, const bool best_fit) {
-    if (words.empty()) {
+int BitmapAllocator::find_free_slot(std::uint32_t offset) const {
+    if (offset >= max_offset)
         return -1;
+
+    std::size_t word_index = offset >> 5;
+    // only keep the slots at or after offset
+    std::uint32_t word = words[word_index] & (0xFFFFFFFFU >> (offset & 31));
+    while (word == 0) {
+        word_index++;
+        if (word_index % GROUP_WORDS == 0) {
+            // skip the groups without any free slot
+            std::size_t group = word_index / GROUP_WORDS;
+            while (group < groups.size() && groups[group].max_run == 0)
+                group++;
+            word_index = group * GROUP_WORDS;
+        }
+
+        if (word_index >= words.size())
+            return -1;
+        word = words[word_index];
     }
 
-    std::uint32_t *word = &words[0] + (start_offset >> 5);
-
-    // We have arrived at le word that still have free position (bit 1)
-    std::uint32_t *word_end = &words[words.size() - 1];
-
-    int bflmin = 0xFFFFFF;
-    int bofmin = -1;
-    std::uint32_t *wordmin = nullptr;
-
-    // Keep finding
-    while (word <= word_end) {
-        std::uint32_t wv = *word;
-
-        if (wv != 0) {
-            // Still have free stuff
-            int bflen = 0;
-            int boff = 0;
-            std::uint32_t *bword = nullptr;
-
-            int cursor = 31;
-
-            while (cursor >= 0) {
-                if (((wv >> cursor) & 1) == 1) {
-                    boff = cursor;
-                    bflen = 0;
-                    bword = word;
-
-                    while (cursor >= 0 && (((wv >> cursor) & 1) == 1)) {
-                        bflen++;
-                        cursor--;
-
-                        if (cursor < 0 && (word + 1 <= word_end)) {
-                            cursor = 31;
-                            word++;
-                            wv = *word;
-                        }
-                    }
-
-                    if (bflen >= size) {
-                        if (!best_fit) {
-                            // Force allocate and then return
-                            const int offset = static_cast<int>(31 - boff + ((bword - &words[0]) << 5));
-                            if ((static_cast<std::size_t>(offset) + size) <= max_offset) {
-                                size = force_fill(static_cast<const std::uint32_t>(offset), size, false);
-                                return offset;
-                            }
-                        } else {
-                            if (bflen < bflmin) {
-                                bflmin = bflen;
-                                bofmin = boff;
-                                wordmin = bword;
-                            }
-                        }
-                    }
-                }
-
-                cursor--;
+    return static_cast<int>((word_index << 5) + std::countl_zero(word));
+}
+
+std::uint32_t BitmapAllocator::free_run_length(const std::uint32_t offset, const std::uint32_t max_length) const {
+    std::size_t word_index = offset >> 5;
+    const std::uint32_t first_bit = offset & 31;
+    std::uint32_t length = std::countl_one(words[word_index] << first_bit);
+    length = std::min(length, 32 - first_bit);
+    if (length < 32 - first_bit)
+        return length;
+
+    word_index++;
+    while (length < max_length && word_index < words.size()) {
+        const std::uint32_t word_length = std::countl_one(words[word_index]);
+        length += word_length;
+        if (word_length < 32)
+            break;
+        word_index++;
+    }
+
+    return length;
+}
+
+int BitmapAllocator::find_first_fit(const std::uint32_t start_offset, const std::uint32_t size) const {
+    int offset = find_free_slot(start_offset);
+    while (offset >= 0 && static_cast<std::size_t>(offset) + size <= max_offset) {
+        const std::uint32_t group = offset / GROUP_BITS;
+        const std::uint32_t group_end = (group + 1) * GROUP_BITS;
+        const GroupSummary &summary = groups[group];
+        if (summary.max_run < size) {
+            // no run starting in this group fits inside it, only the one going past its end may be long enough
+            if (summary.suffix == 0) {
+                offset = find_free_slot(group_end);
+                continue;
             }
+            offset = std::max<int>(offset, group_end - summary.suffix);
         }
 
-        word++;
+        const std::uint32_t length = free_run_length(offset, size);
+        if (length >= size)
+            return offset;
+
+        // the slot after the run is allocated
+        offset = find_free_slot(offset + length + 1);
     }
 
-    if (best_fit && bofmin != -1) {
-        // Force allocate and then return
-        const int offset = static_cast<int>(31 - bofmin + ((wordmin - &words[0]) << 5));
-        if ((static_cast<std::size_t>(offset) + size) <= max_offset) {
-            size = force_fill(static_cast<std::uint32_t>(offset), size, false);
-            return offset;
+    return -1;
+}
+
+int BitmapAllocator::find_best_fit(const std::uint32_t start_offset, const std::uint32_t size) const {
+    std::uint32_t best_length = 0xFFFFFFFFU;
+    int best_offset = -1;
+
+    int offset = find_free_slot(start_offset);
+    while (offset >= 0 && static_cast<std::size_t>(offset) + size <= max_offset) {
+        // the whole run must be measured to compare it
+        const std::uint32_t length = free_run_length(offset, 0xFFFFFFFFU);
+        if (length >= size && length < best_length) {
+            best_length = length;
+            best_offset = offset;
+            if (length == size)
+                // can't do better
+                break;
         }
+
+        offset = find_free_slot(offset + length + 1);
     }
 
-    return -1;
+    return best_offset;
+}
+
+int BitmapAllocator::allocate_from(const std::uint32_t start_offset, std::uint32_t &size, const bool best_fit) {
+    if (words.empty()) {
+        return -1;
+    }
+
+    const int offset = best_fit ? find_best_fit(start_offset, size) : find_first_fit(start_offset, size);
+    if (offset >= 0)
+        size = force_fill(static_cast<std::uint32_t>(offset), size, false);
+
+    return offset;
 }
 
 int BitmapAllocator::allocate_at(const std::uint32_t start_offset, std::uint32_t size) {
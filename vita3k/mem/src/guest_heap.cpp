@@ -0,0 +1,132 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/guest_heap.h>
+
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <util/align.h>
+#include <util/log.h>
+
+#include <algorithm>
+
+uint32_t GuestHeap::get_size_class(uint32_t size, uint32_t alignment) {
+    const auto it = std::lower_bound(SIZE_CLASSES.begin(), SIZE_CLASSES.end(), std::max(size, 1U));
+    // the blocks of a class are only aligned on the largest power of two dividing its size
+    auto class_it = std::find_if(it, SIZE_CLASSES.end(), [&](uint32_t class_size) {
+        return alignment == 0 || class_size % alignment == 0;
+    });
+    return static_cast<uint32_t>(class_it - SIZE_CLASSES.begin());
+}
+
+Address GuestHeap::allocate(MemState &mem, uint32_t size, uint32_t alignment) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    const uint32_t class_index = use_slabs ? get_size_class(size, alignment) : SIZE_CLASSES.size();
+
+    Address address = 0;
+    if (class_index < SIZE_CLASSES.size()) {
+        SizeClass &size_class = classes[class_index];
+        const uint32_t block_size = SIZE_CLASSES[class_index];
+        if (!size_class.free_blocks.empty()) {
+            address = size_class.free_blocks.back();
+            size_class.free_blocks.pop_back();
+        } else {
+            if (size_class.next_block + block_size > size_class.slab_end) {
+                // slabs are kept for the whole run, the freed blocks are reused by the same class
+                const Address slab = alloc_aligned(mem, SLAB_SIZE, "libc slab", SLAB_SIZE);
+                if (!slab)
+                    return 0;
+                slabs[slab] = static_cast<uint8_t>(class_index);
+                size_class.next_block = slab;
+                size_class.slab_end = slab + SLAB_SIZE;
+                reserved_size += SLAB_SIZE;
+            }
+            address = size_class.next_block;
+            size_class.next_block += block_size;
+        }
+    } else {
+        address = alignment ? alloc_aligned(mem, size, "libc heap", alignment) : alloc(mem, size, "libc heap");
+        if (!address)
+            return 0;
+        reserved_size += align(size, mem.page_size);
+    }
+
+    ClassStats &stats = class_stats[get_size_class(size, 0)];
+    stats.nb_allocs++;
+    stats.nb_live++;
+    sizes[address] = size;
+    live_size += size;
+    peak_live_size = std::max(peak_live_size, live_size);
+    peak_reserved_size = std::max(peak_reserved_size, reserved_size);
+    return address;
+}
+
+bool GuestHeap::free(MemState &mem, Address address) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    const auto it = sizes.find(address);
+    if (it == sizes.end())
+        return false;
+
+    const uint32_t size = it->second;
+    sizes.erase(it);
+    class_stats[get_size_class(size, 0)].nb_live--;
+    live_size -= size;
+
+    const auto slab_it = slabs.find(align_down(address, SLAB_SIZE));
+    if (slab_it != slabs.end()) {
+        classes[slab_it->second].free_blocks.push_back(address);
+    } else {
+        ::free(mem, address);
+        reserved_size -= align(size, mem.page_size);
+    }
+    return true;
+}
+
+uint32_t GuestHeap::usable_size(Address address) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    const auto it = sizes.find(address);
+    if (it == sizes.end())
+        return 0;
+
+    const auto slab_it = slabs.find(align_down(address, SLAB_SIZE));
+    if (slab_it != slabs.end())
+        return SIZE_CLASSES[slab_it->second];
+    return it->second;
+}
+
+void GuestHeap::log_stats() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    uint64_t nb_allocs = 0;
+    for (const ClassStats &stats : class_stats)
+        nb_allocs += stats.nb_allocs;
+    if (nb_allocs == 0)
+        return;
+
+    LOG_INFO("libc heap ({}): {} allocations, {} live using {} KiB, peak {} KiB requested, peak {} KiB reserved",
+        use_slabs ? "slabs" : "pages", nb_allocs, sizes.size(), live_size / KiB(1), peak_live_size / KiB(1), peak_reserved_size / KiB(1));
+    if (reserved_size > 0)
+        LOG_INFO("libc heap fragmentation: {:.1f}% of the {} KiB reserved is unused", (reserved_size - live_size) * 100.0 / reserved_size, reserved_size / KiB(1));
+    for (size_t i = 0; i < class_stats.size(); i++) {
+        const ClassStats &stats = class_stats[i];
+        if (stats.nb_allocs == 0)
+            continue;
+        if (i < SIZE_CLASSES.size())
+            LOG_INFO("libc heap up to {} bytes: {} allocations, {} live", SIZE_CLASSES[i], stats.nb_allocs, stats.nb_live);
+        else
+            LOG_INFO("libc heap above {} bytes: {} allocations, {} live", SIZE_CLASSES.back(), stats.nb_allocs, stats.nb_live);
+    }
+}
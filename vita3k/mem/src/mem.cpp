@@ -20,12 +20,14 @@
 
 #include <util/align.h>
 #include <util/log.h>
+#include <util/profile.h>
 
 #include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -36,8 +38,15 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#endif
+
 constexpr uint32_t STANDARD_PAGE_SIZE = KiB(4);
 constexpr size_t TOTAL_MEM_SIZE = GiB(4);
+constexpr size_t HUGE_PAGE_SIZE = MiB(2);
 constexpr bool LOG_PROTECT = false;
 #ifdef NDEBUG
 constexpr bool PAGE_NAME_TRACKING = false;
@@ -50,6 +59,10 @@ static AccessViolationHandler access_violation_handler;
 static void register_access_violation_handler(const AccessViolationHandler &handler);
 
 static Address alloc_inner(MemState &state, uint32_t start_page, uint32_t page_count, const char *name, const bool force);
+
+// the guest allocations are shown at their guest address in the profiler
+#define PROFILE_GUEST_ALLOC(address, size) PROFILE_ALLOC(reinterpret_cast<void *>(static_cast<uintptr_t>(address)), size, "Guest memory")
+#define PROFILE_GUEST_FREE(address) PROFILE_FREE(reinterpret_cast<void *>(static_cast<uintptr_t>(address)), "Guest memory")
 static void delete_memory(uint8_t *memory);
 
 #ifdef _WIN32
@@ -75,6 +88,18 @@ bool init(MemState &state, const bool use_page_table) {
     assert(state.page_size >= 4096); // Limit imposed by Unicorn.
     assert(!use_page_table || state.page_size == KiB(4));
 
+#ifndef __linux__
+    if (state.use_huge_pages) {
+        // large pages on Windows cannot be protected with a 4 KiB granularity
+        LOG_WARN("Huge pages are only supported on Linux");
+        state.use_huge_pages = false;
+    }
+    if (state.use_cold_pages) {
+        LOG_WARN("Reclaiming the cold pages is only supported on Linux");
+        state.use_cold_pages = false;
+    }
+#endif
+
     void *preferred_address = reinterpret_cast<void *>(1ULL << 34);
 
 #ifdef _WIN32
@@ -108,6 +133,10 @@ bool init(MemState &state, const bool use_page_table) {
 
     state.allocator.set_maximum(table_length);
 
+    state.protected_pages = std::make_unique<std::atomic<uint64_t>[]>((table_length + 63) / 64);
+    state.write_tracked_pages = std::make_unique<uint64_t[]>((table_length + 63) / 64);
+    state.page_write_sequence = std::make_unique<std::atomic<uint32_t>[]>(table_length);
+
     const auto handler = [&state](uint8_t *addr, bool write) noexcept {
         return handle_access_violation(state, addr, write);
     };
@@ -156,6 +185,30 @@ bool is_valid_addr_range(const MemState &state, Address start, Address end) {
     return state.allocator.free_slot_count(start_page, end_page) == 0;
 }
 
+// only the 2 MiB aligned part of the range can use huge pages, protecting a page inside it later
+// makes the kernel split the huge page back, so this is always safe
+static size_t get_huge_page_range(Address addr, uint32_t size, Address &huge_begin) {
+    huge_begin = static_cast<Address>(align(static_cast<size_t>(addr), HUGE_PAGE_SIZE));
+    const size_t huge_end = align_down(static_cast<size_t>(addr) + size, HUGE_PAGE_SIZE);
+    return huge_end > huge_begin ? huge_end - huge_begin : 0;
+}
+
+static void advise_huge_pages(MemState &state, Address addr, uint32_t size) {
+#ifdef __linux__
+    Address huge_begin;
+    const size_t huge_size = get_huge_page_range(addr, size, huge_begin);
+    if (huge_size == 0)
+        return;
+
+    if (madvise(&state.memory[huge_begin], huge_size, MADV_HUGEPAGE) == -1) {
+        LOG_WARN("madvise failed, huge pages are disabled: {}", get_error_msg());
+        state.use_huge_pages = false;
+        return;
+    }
+    state.huge_page_advised_size += huge_size;
+#endif
+}
+
 static Address alloc_inner(MemState &state, uint32_t start_page, uint32_t page_count, const char *name, const bool force) {
     int page_num;
     if (force) {
@@ -181,7 +234,11 @@ static Address alloc_inner(MemState &state, uint32_t start_page, uint32_t page_c
     const int ret = mprotect(memory, size, PROT_READ | PROT_WRITE);
     LOG_CRITICAL_IF(ret == -1, "mprotect failed: {}", get_error_msg());
 #endif
-    std::memset(memory, 0, size);
+    // must be done before the memory is touched
+    if (state.use_huge_pages)
+        advise_huge_pages(state, addr, size);
+    // the memory is not touched here, the host only commits the pages the app uses
+    // they are already zeroed: never used so far or discarded when freed
 
     AllocMemPage &page = state.alloc_table[page_num];
     assert(!page.allocated);
@@ -216,6 +273,8 @@ Address alloc_aligned(MemState &state, uint32_t size, const char *name, unsigned
         align_page.size = page.size - remnant_front;
     }
 
+    if (addr != 0)
+        PROFILE_GUEST_ALLOC(align_addr, page_count * state.page_size);
     return align_addr;
 }
 
@@ -254,12 +313,102 @@ void protect_inner(MemState &state, Address addr, uint32_t size, const MemPerm p
 #endif
 }
 
+// protect_mutex is taken by every guest thread on access violations and by the renderer, keep track of how often it is contended
+static std::unique_lock<std::mutex> lock_protect(MemState &state) {
+    std::unique_lock<std::mutex> lock(state.protect_mutex, std::try_to_lock);
+    state.protect_lock_count.fetch_add(1, std::memory_order_relaxed);
+    if (!lock.owns_lock()) {
+        state.protect_lock_contended.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+    return lock;
+}
+
+static bool is_page_protected(const MemState &state, uint32_t page) {
+    return state.protected_pages[page / 64].load(std::memory_order_acquire) & (1ULL << (page % 64));
+}
+
+// must be called with protect_mutex locked each time a segment is added to or removed from protect_tree
+static void set_protected_pages(MemState &state, Address addr, uint32_t size, bool is_protected) {
+    const uint32_t first_page = addr / state.page_size;
+    const uint32_t last_page = (addr + size - 1) / state.page_size;
+    for (uint32_t page = first_page; page <= last_page; page++) {
+        if (is_protected)
+            state.protected_pages[page / 64].fetch_or(1ULL << (page % 64), std::memory_order_release);
+        else
+            state.protected_pages[page / 64].fetch_and(~(1ULL << (page % 64)), std::memory_order_release);
+    }
+}
+
+static bool is_write_tracked(const MemState &state, uint32_t page) {
+    return state.write_tracked_pages[page / 64] & (1ULL << (page % 64));
+}
+
+// must be called with protect_mutex locked when the protection of a range is removed
+static void release_write_tracking(MemState &state, Address addr, uint32_t size) {
+    const uint32_t first_page = addr / state.page_size;
+    const uint32_t last_page = (addr + size - 1) / state.page_size;
+    for (uint32_t page = first_page; page <= last_page; page++) {
+        if (!is_write_tracked(state, page))
+            continue;
+
+        state.write_tracked_pages[page / 64] &= ~(1ULL << (page % 64));
+        // we don't know if the page was written to, assume it was
+        state.page_write_sequence[page].store(++state.write_sequence, std::memory_order_release);
+    }
+}
+
+#ifdef __linux__
+// the soft-dirty bits are per process, so are these files
+static int pagemap_fd = -1;
+static int clear_refs_fd = -1;
+constexpr uint64_t PAGEMAP_SOFT_DIRTY = 1ULL << 55;
+
+static bool clear_soft_dirty() {
+    // 4 only clears the soft-dirty bits
+    return pwrite(clear_refs_fd, "4", 1, 0) == 1;
+}
+
+static bool read_pagemap(const void *host_addr, uint32_t page_count, uint64_t *entries) {
+    const size_t host_page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const off_t offset = static_cast<off_t>(reinterpret_cast<uintptr_t>(host_addr) / host_page_size * sizeof(uint64_t));
+    const ssize_t size = page_count * sizeof(uint64_t);
+    return pread(pagemap_fd, entries, size, offset) == size;
+}
+
+// true if one of the tracked pages of the range has its soft-dirty bit set
+static bool is_soft_dirty(const MemState &state, Address addr, uint32_t size) {
+    constexpr uint32_t PAGES_PER_READ = 64;
+    uint64_t entries[PAGES_PER_READ];
+
+    const uint32_t first_page = addr / state.page_size;
+    const uint32_t last_page = (addr + size - 1) / state.page_size;
+    for (uint32_t page = first_page; page <= last_page; page += PAGES_PER_READ) {
+        const uint32_t page_count = std::min(PAGES_PER_READ, last_page - page + 1);
+        if (!read_pagemap(&state.memory[page * state.page_size], page_count, entries))
+            // better upload something twice than missing a write
+            return true;
+
+        for (uint32_t i = 0; i < page_count; i++) {
+            if (entries[i] & PAGEMAP_SOFT_DIRTY)
+                return true;
+        }
+    }
+
+    return false;
+}
+#endif
+
+static bool is_in_protect_tree(const MemState &state, Address addr) {
+    return is_page_protected(state, addr / state.page_size);
+}
+
 bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcept {
     const uintptr_t memory_addr = reinterpret_cast<uintptr_t>(state.memory.get());
     const uintptr_t fault_addr = reinterpret_cast<uintptr_t>(addr);
 
     Address vaddr = 0;
-    const std::unique_lock<std::mutex> lock(state.protect_mutex);
+    const auto lock = lock_protect(state);
     if (fault_addr < memory_addr || fault_addr >= memory_addr + TOTAL_MEM_SIZE) {
         if (state.use_page_table) {
             // this may come from an external mapping
@@ -285,34 +434,43 @@ bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcep
     }
 
     auto it = state.protect_tree.lower_bound(vaddr);
-    if (it == state.protect_tree.end()) {
-        // HACK: keep going
-        unprotect_inner(state, align_down(vaddr, state.page_size), state.page_size);
-        LOG_CRITICAL("Unhandled write protected region was valid. Address=0x{:X}", vaddr);
-        return true;
-    }
+    if (it == state.protect_tree.end() || vaddr >= it->first + it->second.size) {
+        const Address page_addr = align_down(vaddr, state.page_size);
+        const uint32_t page = page_addr / state.page_size;
+        if (is_write_tracked(state, page)) {
+            if (state.use_soft_dirty)
+                // the page was protected by collect_written_pages, it stays tracked
+                state.page_write_sequence[page].store(++state.write_sequence, std::memory_order_release);
+            else
+                release_write_tracking(state, page_addr, state.page_size);
+
+            // only this page needs to be writable again
+            unprotect_inner(state, page_addr, state.page_size);
+            return true;
+        }
 
-    ProtectSegmentInfo &info = it->second;
-    if (vaddr < it->first || vaddr >= it->first + info.size) {
         // HACK: keep going
-        unprotect_inner(state, align_down(vaddr, state.page_size), state.page_size);
+        unprotect_inner(state, page_addr, state.page_size);
         LOG_CRITICAL("Unhandled write protected region was valid. Address=0x{:X}", vaddr);
         return true;
     }
 
-    Address previous_beg = it->first;
-    for (auto &[block_addr, block] : info.blocks) {
+    ProtectSegmentInfo &info = it->second;
+    for (auto &block : info.blocks) {
         block.callback(vaddr, write);
     }
 
     unprotect_inner(state, it->first, info.size);
+    // the write tracked pages of this segment are not protected anymore
+    release_write_tracking(state, it->first, info.size);
+    set_protected_pages(state, it->first, info.size, false);
     state.protect_tree.erase(it);
 
     return true;
 }
 
 bool add_protect(MemState &state, Address addr, const uint32_t size, const MemPerm perm, const ProtectCallback &callback) {
-    const std::lock_guard<std::mutex> lock(state.protect_mutex);
+    const auto lock = lock_protect(state);
     ProtectSegmentInfo protect(size, perm);
     align_to_page(state, addr, protect.size);
 
@@ -320,7 +478,7 @@ bool add_protect(MemState &state, Address addr, const uint32_t size, const MemPe
     block.size = size;
     block.callback = callback;
 
-    protect.blocks.emplace(addr, std::move(block));
+    protect.blocks.push_back(std::move(block));
 
     auto it = state.protect_tree.lower_bound(addr);
     if (it == state.protect_tree.end() || it->first + it->second.size <= addr) {
@@ -334,7 +492,8 @@ bool add_protect(MemState &state, Address addr, const uint32_t size, const MemPe
         const Address start = std::min(it->first, addr);
         protect.size = std::max(it->first + it->second.size, addr + protect.size) - start;
         addr = start;
-        protect.blocks.merge(it->second.blocks); // transfer blocks to the new protect
+        // transfer blocks to the new protect
+        protect.blocks.insert(protect.blocks.end(), std::make_move_iterator(it->second.blocks.begin()), std::make_move_iterator(it->second.blocks.end()));
         protect.perm = most_restrictive_perm(protect.perm, it->second.perm);
 
         if (it == state.protect_tree.begin()) {
@@ -348,12 +507,18 @@ bool add_protect(MemState &state, Address addr, const uint32_t size, const MemPe
 
     protect_inner(state, addr, protect.size, protect.perm);
 
+    // the merged segments are all inside this one
+    set_protected_pages(state, addr, protect.size, true);
     state.protect_tree.emplace(addr, std::move(protect));
     return true;
 }
 
 bool is_protecting(MemState &state, Address addr, MemPerm *perm) {
-    const std::lock_guard<std::mutex> lock(state.protect_mutex);
+    if (!is_page_protected(state, addr / state.page_size))
+        // most lookups end here, without taking the lock
+        return false;
+
+    const auto lock = lock_protect(state);
     auto ite = state.protect_tree.lower_bound(addr);
 
     if (ite != state.protect_tree.end() && addr < ite->first + ite->second.size) {
@@ -366,8 +531,294 @@ bool is_protecting(MemState &state, Address addr, MemPerm *perm) {
     return false;
 }
 
+uint32_t track_writes(MemState &state, Address addr, uint32_t size) {
+    const auto lock = lock_protect(state);
+    if (size == 0)
+        return state.write_sequence;
+
+    align_to_page(state, addr, size);
+
+    if (state.use_soft_dirty) {
+        // nothing to protect, the kernel keeps track of the written pages
+        const uint32_t last_page = (addr + size - 1) / state.page_size;
+        for (uint32_t page = addr / state.page_size; page <= last_page; page++)
+            state.write_tracked_pages[page / 64] |= 1ULL << (page % 64);
+        return state.write_sequence;
+    }
+
+    // consecutive pages are protected with a single call
+    Address run_start = 0;
+    uint32_t run_size = 0;
+    for (Address page_addr = addr; page_addr < addr + size; page_addr += state.page_size) {
+        const uint32_t page = page_addr / state.page_size;
+        // pages covered by add_protect are already protected, their tracking is released with the protect
+        const bool needs_protect = !is_write_tracked(state, page) && !is_in_protect_tree(state, page_addr);
+        state.write_tracked_pages[page / 64] |= 1ULL << (page % 64);
+
+        if (needs_protect) {
+            if (run_size == 0)
+                run_start = page_addr;
+            run_size += state.page_size;
+        } else if (run_size > 0) {
+            protect_inner(state, run_start, run_size, MemPerm::ReadOnly);
+            run_size = 0;
+        }
+    }
+    if (run_size > 0)
+        protect_inner(state, run_start, run_size, MemPerm::ReadOnly);
+
+    return state.write_sequence;
+}
+
+bool was_written_since(const MemState &state, Address addr, uint32_t size, uint32_t sequence) {
+    if (size == 0)
+        return false;
+
+    const uint32_t first_page = addr / state.page_size;
+    const uint32_t last_page = (addr + size - 1) / state.page_size;
+    for (uint32_t page = first_page; page <= last_page; page++) {
+        if (state.page_write_sequence[page].load(std::memory_order_acquire) > sequence)
+            return true;
+    }
+
+#ifdef __linux__
+    // the write may have happened after the last collect_written_pages, but it may also
+    // be a write done before track_writes, in which case the range is checked for nothing
+    if (state.use_soft_dirty)
+        return is_soft_dirty(state, addr, size);
+#endif
+
+    return false;
+}
+
+void mark_written(MemState &state, Address addr, uint32_t size) {
+    if (size == 0)
+        return;
+
+    const auto lock = lock_protect(state);
+    align_to_page(state, addr, size);
+
+    // consecutive pages are unprotected with a single call
+    Address run_start = 0;
+    uint32_t run_size = 0;
+    for (Address page_addr = addr; page_addr < addr + size; page_addr += state.page_size) {
+        const uint32_t page = page_addr / state.page_size;
+        // the pages covered by add_protect keep faulting, their callback must be called
+        const bool is_released = is_write_tracked(state, page) && !is_in_protect_tree(state, page_addr);
+        if (is_released) {
+            if (state.use_soft_dirty) {
+                // the page is not protected, the write could only be seen at the next collect_written_pages
+                state.page_write_sequence[page].store(++state.write_sequence, std::memory_order_release);
+                continue;
+            }
+
+            release_write_tracking(state, page_addr, state.page_size);
+            if (run_size == 0)
+                run_start = page_addr;
+            run_size += state.page_size;
+        } else if (run_size > 0) {
+            unprotect_inner(state, run_start, run_size);
+            run_size = 0;
+        }
+    }
+    if (run_size > 0)
+        unprotect_inner(state, run_start, run_size);
+}
+
+bool enable_soft_dirty_tracking(MemState &state) {
+#ifdef __linux__
+    if (state.use_page_table)
+        // the host pages do not match the guest memory
+        return false;
+
+    if (pagemap_fd < 0)
+        pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (clear_refs_fd < 0)
+        clear_refs_fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+    if (pagemap_fd < 0 || clear_refs_fd < 0) {
+        LOG_WARN("Soft-dirty tracking is not available: {}", get_error_msg());
+        return false;
+    }
+
+    // the kernel may have been built without soft-dirty support, check it actually works
+    const size_t host_page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    volatile uint8_t *test_page = static_cast<uint8_t *>(mmap(nullptr, host_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (test_page == MAP_FAILED)
+        return false;
+
+    uint64_t before = 0;
+    uint64_t after = 0;
+    test_page[0] = 1;
+    bool is_working = clear_soft_dirty() && read_pagemap(const_cast<uint8_t *>(test_page), 1, &before);
+    test_page[0] = 2;
+    is_working = is_working && read_pagemap(const_cast<uint8_t *>(test_page), 1, &after);
+    is_working = is_working && !(before & PAGEMAP_SOFT_DIRTY) && (after & PAGEMAP_SOFT_DIRTY);
+    munmap(const_cast<uint8_t *>(test_page), host_page_size);
+
+    if (!is_working) {
+        LOG_WARN("Soft-dirty tracking is not supported by the kernel");
+        return false;
+    }
+
+    const auto lock = lock_protect(state);
+    state.use_soft_dirty = true;
+    LOG_INFO("Using soft-dirty bits to track memory writes");
+    return true;
+#else
+    return false;
+#endif
+}
+
+void collect_written_pages(MemState &state) {
+#ifdef __linux__
+    if (!state.use_soft_dirty)
+        return;
+
+    const auto lock = lock_protect(state);
+
+    // runs of tracked pages, pages also covered by add_protect are already protected
+    std::vector<std::pair<Address, uint32_t>> runs;
+    const uint32_t page_count = static_cast<uint32_t>(TOTAL_MEM_SIZE / state.page_size);
+    for (uint32_t page = 0; page < page_count; page++) {
+        if ((page % 64) == 0 && state.write_tracked_pages[page / 64] == 0) {
+            page += 63;
+            continue;
+        }
+
+        const Address page_addr = page * state.page_size;
+        if (!is_write_tracked(state, page) || is_in_protect_tree(state, page_addr))
+            continue;
+
+        if (!runs.empty() && runs.back().first + runs.back().second == page_addr)
+            runs.back().second += state.page_size;
+        else
+            runs.emplace_back(page_addr, state.page_size);
+    }
+
+    // a write between the moment the bits are read and the moment they are cleared would be lost,
+    // so the pages are write protected meanwhile, such a write is caught by handle_access_violation
+    for (const auto &[addr, size] : runs)
+        protect_inner(state, addr, size, MemPerm::ReadOnly);
+
+    constexpr uint32_t PAGES_PER_READ = 64;
+    uint64_t entries[PAGES_PER_READ];
+    for (const auto &[addr, size] : runs) {
+        const uint32_t first_page = addr / state.page_size;
+        const uint32_t run_pages = size / state.page_size;
+        for (uint32_t offset = 0; offset < run_pages; offset += PAGES_PER_READ) {
+            const uint32_t nb_pages = std::min(PAGES_PER_READ, run_pages - offset);
+            const bool has_entries = read_pagemap(&state.memory[(first_page + offset) * state.page_size], nb_pages, entries);
+            for (uint32_t i = 0; i < nb_pages; i++) {
+                if (!has_entries || (entries[i] & PAGEMAP_SOFT_DIRTY))
+                    state.page_write_sequence[first_page + offset + i].store(++state.write_sequence, std::memory_order_release);
+            }
+        }
+    }
+
+    if (!clear_soft_dirty()) {
+        LOG_ERROR("Failed to clear the soft-dirty bits, going back to page protection: {}", get_error_msg());
+        // the pages are already protected, which is what the default tracking expects
+        state.use_soft_dirty = false;
+        return;
+    }
+
+    for (const auto &[addr, size] : runs)
+        unprotect_inner(state, addr, size);
+#endif
+}
+
+#ifdef __linux__
+// what was mapped at the destination is replaced
+static bool move_host_mapping(uint8_t *from, uint8_t *to, size_t size) {
+    return mremap(from, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, to) != MAP_FAILED;
+}
+
+// keeps the range a mapping was moved from for when it is moved back
+static bool reserve_host_range(uint8_t *addr, size_t size) {
+    return mmap(addr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0) != MAP_FAILED;
+}
+#endif
+
+bool can_move_external_mapping(uint8_t *addr_ptr, uint32_t size) {
+#ifdef __linux__
+    if ((std::bit_cast<uintptr_t>(addr_ptr) & 4095) != 0)
+        return false;
+
+    // moving a driver mapping works only if the driver does not forbid it, try it on an unused range
+    void *target = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (target == MAP_FAILED)
+        return false;
+
+    uint8_t *target_ptr = static_cast<uint8_t *>(target);
+    if (!move_host_mapping(addr_ptr, target_ptr, size)) {
+        munmap(target, size);
+        return false;
+    }
+
+    const bool moved_back = reserve_host_range(addr_ptr, size) && move_host_mapping(target_ptr, addr_ptr, size);
+    LOG_CRITICAL_IF(!moved_back, "Failed to move back the mapping at {}: {}", fmt::ptr(addr_ptr), get_error_msg());
+    munmap(target, size);
+    return moved_back;
+#else
+    return false;
+#endif
+}
+
+#ifdef __linux__
+static void add_moved_external_mapping(MemState &mem, Address addr, uint32_t size, uint8_t *addr_ptr) {
+    uint8_t *guest_ptr = &mem.memory[addr];
+    // this is not thread write safe, but hopefully not other thread is busy copying while this happens
+    memcpy(addr_ptr, guest_ptr, size);
+    if (!move_host_mapping(addr_ptr, guest_ptr, size)) {
+        LOG_CRITICAL("Failed to move the external mapping to {}: {}", log_hex(addr), get_error_msg());
+        return;
+    }
+    const bool reserved = reserve_host_range(addr_ptr, size);
+    LOG_ERROR_IF(!reserved, "Failed to reserve the range of the moved mapping: {}", get_error_msg());
+
+    const auto lock = lock_protect(mem);
+    // the protections of the guest range do not apply to the pages moved there
+    release_write_tracking(mem, addr, size);
+    auto prot_it = mem.protect_tree.lower_bound(addr + size - 1);
+    while (prot_it != mem.protect_tree.end() && prot_it->first + prot_it->second.size > addr) {
+        const Address start = std::max(prot_it->first, addr);
+        const Address end = std::min(prot_it->first + prot_it->second.size, addr + size);
+        protect_inner(mem, start, end - start, prot_it->second.perm);
+        ++prot_it;
+    }
+
+    mem.moved_mappings[addr] = addr_ptr;
+}
+
+static void remove_moved_external_mapping(MemState &mem, Address addr, uint32_t size) {
+    const auto it = mem.moved_mappings.find(addr);
+    if (it == mem.moved_mappings.end())
+        return;
+
+    // the content goes back to anonymous memory, and the mapping back where the driver expects it before it gets unmapped
+    uint8_t *guest_ptr = &mem.memory[addr];
+    void *copy = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (copy == MAP_FAILED) {
+        LOG_CRITICAL("mmap failed {}", get_error_msg());
+        return;
+    }
+    memcpy(copy, guest_ptr, size);
+    const bool moved_back = move_host_mapping(guest_ptr, it->second, size);
+    LOG_CRITICAL_IF(!moved_back, "Failed to move back the external mapping of {}: {}", log_hex(addr), get_error_msg());
+    const bool restored = move_host_mapping(static_cast<uint8_t *>(copy), guest_ptr, size);
+    LOG_CRITICAL_IF(!restored, "Failed to restore the memory at {}: {}", log_hex(addr), get_error_msg());
+    mem.moved_mappings.erase(it);
+}
+#endif
+
 void add_external_mapping(MemState &mem, Address addr, uint32_t size, uint8_t *addr_ptr) {
     assert((size & 4095) == 0);
+#ifdef __linux__
+    if (mem.move_external_mappings) {
+        add_moved_external_mapping(mem, addr, size, addr_ptr);
+        return;
+    }
+#endif
     if (!mem.use_page_table)
         return;
 
@@ -385,7 +836,7 @@ void add_external_mapping(MemState &mem, Address addr, uint32_t size, uint8_t *a
     protect_inner(mem, addr, size, MemPerm::None);
     mem.page_table[addr / KiB(4)] = page_table_entry;
 
-    const std::unique_lock<std::mutex> lock(mem.protect_mutex);
+    const auto lock = lock_protect(mem);
     mem.external_mapping[addr_value] = { addr, size };
 }
 
@@ -393,7 +844,7 @@ void remove_external_mapping(MemState &mem, uint8_t *addr_ptr, uint32_t size) {
     uint64_t addr_value = std::bit_cast<uint64_t>(addr_ptr);
     MemExternalMapping mapping;
     if (mem.use_page_table) {
-        const std::unique_lock<std::mutex> lock(mem.protect_mutex);
+        const auto lock = lock_protect(mem);
         auto it = mem.external_mapping.find(addr_value);
         assert(it != mem.external_mapping.end());
 
@@ -407,7 +858,7 @@ void remove_external_mapping(MemState &mem, uint8_t *addr_ptr, uint32_t size) {
     // remove all protections on this range
     unprotect_inner(mem, mapping.address, mapping.size);
     {
-        const std::unique_lock<std::mutex> lock(mem.protect_mutex);
+        const auto lock = lock_protect(mem);
         auto prot_it = mem.protect_tree.lower_bound(mapping.address);
         if (prot_it->first + prot_it->second.size <= mapping.address) {
             if (prot_it == mem.protect_tree.begin())
@@ -417,6 +868,7 @@ void remove_external_mapping(MemState &mem, uint8_t *addr_ptr, uint32_t size) {
         }
 
         while (prot_it != mem.protect_tree.end() && prot_it->first < mapping.address + mapping.size) {
+            set_protected_pages(mem, prot_it->first, prot_it->second.size, false);
             if (prot_it == mem.protect_tree.begin()) {
                 mem.protect_tree.erase(prot_it);
                 break;
@@ -424,8 +876,15 @@ void remove_external_mapping(MemState &mem, uint8_t *addr_ptr, uint32_t size) {
 
             mem.protect_tree.erase(prot_it--);
         }
+
+        release_write_tracking(mem, mapping.address, mapping.size);
     }
 
+#ifdef __linux__
+    if (mem.move_external_mappings)
+        remove_moved_external_mapping(mem, mapping.address, mapping.size);
+#endif
+
     if (mem.use_page_table) {
         // unprotect the original memory range
         mem.page_table[mapping.address / KiB(4)] = mem.memory.get();
@@ -443,6 +902,8 @@ Address alloc(MemState &state, uint32_t size, const char *name, Address start_ad
     const std::lock_guard<std::mutex> lock(state.generation_mutex);
     const uint32_t page_count = align(size, state.page_size) / state.page_size;
     const Address addr = alloc_inner(state, start_addr / state.page_size, page_count, name, false);
+    if (addr != 0)
+        PROFILE_GUEST_ALLOC(addr, page_count * state.page_size);
     return addr;
 }
 
@@ -452,6 +913,7 @@ Address alloc_at(MemState &state, Address address, uint32_t size, const char *na
     size += address % state.page_size;
     const uint32_t page_count = align(size, state.page_size) / state.page_size;
     alloc_inner(state, wanted_page, page_count, name, true);
+    PROFILE_GUEST_ALLOC(address, page_count * state.page_size);
     return address;
 }
 
@@ -463,6 +925,7 @@ Address try_alloc_at(MemState &state, Address address, uint32_t size, const char
         return 0;
     }
     (void)alloc_inner(state, wanted_page, page_count, name, true);
+    PROFILE_GUEST_ALLOC(address, page_count * state.page_size);
     return address;
 }
 
@@ -483,6 +946,7 @@ void free(MemState &state, Address address) {
         LOG_CRITICAL("Freeing unallocated page");
     }
     page.allocated = 0;
+    PROFILE_GUEST_FREE(address);
 
     state.allocator.free(page_num, page.size);
     if (PAGE_NAME_TRACKING) {
@@ -492,17 +956,130 @@ void free(MemState &state, Address address) {
     assert(!state.use_page_table || state.page_table[address / KiB(4)] == state.memory.get());
     uint8_t *const memory = &state.memory[page_num * state.page_size];
 
+    {
+        const auto protect_lock = lock_protect(state);
+        release_write_tracking(state, page_num * state.page_size, page.size * state.page_size);
+    }
+
 #ifdef _WIN32
     const BOOL ret = VirtualFree(memory, page.size * state.page_size, MEM_DECOMMIT);
     LOG_CRITICAL_IF(!ret, "VirtualFree failed: {}", get_error_msg());
 #else
     int ret = mprotect(memory, page.size * state.page_size, PROT_NONE);
     LOG_CRITICAL_IF(ret == -1, "mprotect failed: {}", get_error_msg());
+    if (state.use_huge_pages) {
+        Address huge_begin;
+        state.huge_page_advised_size -= std::min(state.huge_page_advised_size, get_huge_page_range(page_num * state.page_size, page.size * state.page_size, huge_begin));
+    }
     ret = madvise(memory, page.size * state.page_size, MADV_DONTNEED);
     LOG_CRITICAL_IF(ret == -1, "madvise failed: {}", get_error_msg());
 #endif
 }
 
+#ifdef __linux__
+// the host is considered low on memory when less than this share of its memory is still available
+static constexpr uint64_t LOW_MEMORY_PERCENT = 25;
+static constexpr auto COLD_PAGES_PERIOD = std::chrono::seconds(5);
+
+static bool is_host_memory_low() {
+    std::ifstream meminfo("/proc/meminfo");
+    uint64_t total_kb = 0;
+    uint64_t available_kb = 0;
+    std::string line;
+    while (std::getline(meminfo, line)) {
+        if (line.starts_with("MemTotal:"))
+            std::istringstream(line.substr(sizeof("MemTotal:") - 1)) >> total_kb;
+        else if (line.starts_with("MemAvailable:"))
+            std::istringstream(line.substr(sizeof("MemAvailable:") - 1)) >> available_kb;
+    }
+    return total_kb > 0 && available_kb * 100 < total_kb * LOW_MEMORY_PERCENT;
+}
+#endif
+
+void advise_cold_pages(MemState &state) {
+#if defined(__linux__) && defined(MADV_COLD)
+    if (!state.use_cold_pages)
+        return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - state.last_cold_pages_pass < COLD_PAGES_PERIOD)
+        return;
+    state.last_cold_pages_pass = now;
+    if (!is_host_memory_low())
+        return;
+
+    // the pages only go to the inactive list: the kernel still checks whether they were accessed before reclaiming them,
+    // and the faults on reclaimed pages are handled by the kernel, so the host and the GPU can keep accessing them
+    const std::lock_guard<std::mutex> lock(state.generation_mutex);
+    size_t advised_size = 0;
+    for (uint32_t page_num = 0; page_num < state.allocator.max_offset;) {
+        const AllocMemPage &page = state.alloc_table[page_num];
+        if (!page.allocated) {
+            page_num++;
+            continue;
+        }
+
+        const size_t size = static_cast<size_t>(page.size) * state.page_size;
+        if (madvise(&state.memory[static_cast<size_t>(page_num) * state.page_size], size, MADV_COLD) == -1) {
+            LOG_WARN("madvise failed, the cold pages are not reclaimed anymore: {}", get_error_msg());
+            state.use_cold_pages = false;
+            return;
+        }
+        advised_size += size;
+        page_num += page.size;
+    }
+    LOG_DEBUG("Host low on memory, {} MiB of guest memory marked as cold", advised_size / MiB(1));
+#endif
+}
+
+void log_mem_stats(const MemState &state) {
+    const uint64_t lock_count = state.protect_lock_count.load(std::memory_order_relaxed);
+    const uint64_t lock_contended = state.protect_lock_contended.load(std::memory_order_relaxed);
+    if (lock_count > 0)
+        LOG_INFO("Protect lock: taken {} times, contended {} times ({:.2f}%)", lock_count, lock_contended, lock_contended * 100.0 / lock_count);
+
+    if (!state.use_huge_pages)
+        return;
+
+    size_t huge_page_backed_size = 0;
+#ifdef __linux__
+    // AnonHugePages of the mappings inside the guest memory
+    const uintptr_t memory_begin = reinterpret_cast<uintptr_t>(state.memory.get());
+    const uintptr_t memory_end = memory_begin + TOTAL_MEM_SIZE;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool is_guest_mapping = false;
+    while (std::getline(smaps, line)) {
+        uintptr_t begin, end;
+        char dash;
+        std::istringstream header(line);
+        if (header >> std::hex >> begin >> dash >> end && dash == '-') {
+            is_guest_mapping = begin >= memory_begin && end <= memory_end;
+            continue;
+        }
+
+        if (is_guest_mapping && line.starts_with("AnonHugePages:")) {
+            size_t size_kb = 0;
+            std::istringstream(line.substr(sizeof("AnonHugePages:") - 1)) >> size_kb;
+            huge_page_backed_size += size_kb * KiB(1);
+        }
+    }
+#endif
+
+    LOG_INFO("Huge pages: {} MiB of guest memory backed by huge pages, {} MiB advised", huge_page_backed_size / MiB(1), state.huge_page_advised_size / MiB(1));
+}
+
+std::optional<size_t> get_resident_size(const MemState &state, Address addr, uint32_t size) {
+#ifdef _WIN32
+    return std::nullopt;
+#else
+    std::vector<unsigned char> resident_pages(align(size, state.page_size) / state.page_size);
+    if (mincore(&state.memory[addr], size, resident_pages.data()) == -1)
+        return std::nullopt;
+    return std::count_if(resident_pages.begin(), resident_pages.end(), [](unsigned char page) { return page & 1; }) * static_cast<size_t>(state.page_size);
+#endif
+}
+
 uint32_t mem_available(MemState &state) {
     return state.allocator.free_slot_count(0, state.allocator.max_offset) * state.page_size;
 }
@@ -514,6 +1091,65 @@ const char *mem_name(Address address, MemState &state) {
     return "";
 }
 
+// Call func on each part of [dst, dst + size) and [src, src + size) which does not cross a page boundary on both sides
+template <typename F>
+static void for_each_guest_chunk(const MemState &state, Address dst, Address src, uint32_t size, bool backward, F &&func) {
+    const uint32_t page_size = state.page_size;
+    while (size > 0) {
+        uint32_t chunk_size;
+        if (backward) {
+            const uint32_t dst_in_page = ((dst + size - 1) % page_size) + 1;
+            const uint32_t src_in_page = ((src + size - 1) % page_size) + 1;
+            chunk_size = std::min({ size, dst_in_page, src_in_page });
+            func(dst + size - chunk_size, src + size - chunk_size, chunk_size);
+        } else {
+            const uint32_t dst_in_page = page_size - (dst % page_size);
+            const uint32_t src_in_page = page_size - (src % page_size);
+            chunk_size = std::min({ size, dst_in_page, src_in_page });
+            func(dst, src, chunk_size);
+            dst += chunk_size;
+            src += chunk_size;
+        }
+        size -= chunk_size;
+    }
+}
+
+void copy_guest_memory(MemState &state, Address dst, Address src, uint32_t size) {
+    if (!state.use_page_table) {
+        // the host libc memcpy is already vectorized
+        memcpy(&state.memory[dst], &state.memory[src], size);
+        return;
+    }
+
+    for_each_guest_chunk(state, dst, src, size, false, [&](Address chunk_dst, Address chunk_src, uint32_t chunk_size) {
+        memcpy(state.page_table[chunk_dst / KiB(4)] + chunk_dst, state.page_table[chunk_src / KiB(4)] + chunk_src, chunk_size);
+    });
+}
+
+void move_guest_memory(MemState &state, Address dst, Address src, uint32_t size) {
+    if (!state.use_page_table) {
+        memmove(&state.memory[dst], &state.memory[src], size);
+        return;
+    }
+
+    // copy from the end if the destination overlaps the end of the source
+    const bool backward = dst > src && dst < src + size;
+    for_each_guest_chunk(state, dst, src, size, backward, [&](Address chunk_dst, Address chunk_src, uint32_t chunk_size) {
+        memmove(state.page_table[chunk_dst / KiB(4)] + chunk_dst, state.page_table[chunk_src / KiB(4)] + chunk_src, chunk_size);
+    });
+}
+
+void fill_guest_memory(MemState &state, Address dst, uint8_t value, uint32_t size) {
+    if (!state.use_page_table) {
+        memset(&state.memory[dst], value, size);
+        return;
+    }
+
+    for_each_guest_chunk(state, dst, dst, size, false, [&](Address chunk_dst, Address, uint32_t chunk_size) {
+        memset(state.page_table[chunk_dst / KiB(4)] + chunk_dst, value, chunk_size);
+    });
+}
+
 #ifdef _WIN32
 
 static LONG WINAPI exception_handler(PEXCEPTION_POINTERS pExp) noexcept {
@@ -15,6 +15,8 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <chrono>
+#include <iostream>
 #include <list>
 #include <mem/allocator.h>
 #include <mem/util.h>
@@ -243,3 +245,59 @@ TEST(bitmap_allocator, count_unaligned) {
     // 4 valid bits + 12 bits + 5 valid bits = 21
     ASSERT_EQ(alloc.free_slot_count(22, 92), 21);
 }
+
+// Fragmentation heavy workload, checked against a naive first fit and timed
+TEST(bitmap_allocator, fragmented_workload) {
+    constexpr uint32_t MEM_SIZE = 256 * 1024;
+    constexpr int TEST_EPOCH = 5000;
+
+    BitmapAllocator allocator(MEM_SIZE);
+    std::vector<bool> reference(MEM_SIZE, true);
+    const auto reference_first_fit = [&](uint32_t start, uint32_t size) -> int {
+        uint32_t run = 0;
+        for (uint32_t i = start; i < MEM_SIZE; i++) {
+            run = reference[i] ? run + 1 : 0;
+            if (run == size)
+                return i + 1 - size;
+        }
+        return -1;
+    };
+
+    // fill everything with one slot allocations and free one slot out of three
+    std::vector<std::pair<int, uint32_t>> allocations;
+    for (uint32_t i = 0; i < MEM_SIZE; i++) {
+        uint32_t size = 1;
+        ASSERT_EQ(allocator.allocate_from(i, size), i);
+        reference[i] = false;
+        if (i % 3 == 0) {
+            allocator.free(i, 1);
+            reference[i] = true;
+        }
+    }
+
+    srand(0);
+    std::chrono::steady_clock::duration elapsed{};
+    for (int i = 0; i < TEST_EPOCH; i++) {
+        if (!allocations.empty() && rand() % 3 == 0) {
+            const size_t index = rand() % allocations.size();
+            const auto [offset, size] = allocations[index];
+            allocator.free(offset, size);
+            std::fill_n(reference.begin() + offset, size, true);
+            allocations.erase(allocations.begin() + index);
+            continue;
+        }
+
+        uint32_t size = rand() % 8 + 1;
+        const uint32_t start = rand() % MEM_SIZE;
+        const int expected = reference_first_fit(start, size);
+        const auto start_time = std::chrono::steady_clock::now();
+        const int offset = allocator.allocate_from(start, size);
+        elapsed += std::chrono::steady_clock::now() - start_time;
+        ASSERT_EQ(offset, expected);
+        if (offset >= 0) {
+            std::fill_n(reference.begin() + offset, size, false);
+            allocations.emplace_back(offset, size);
+        }
+    }
+    std::cout << "fragmented workload: " << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << " us spent in allocate_from" << std::endl;
+}
@@ -0,0 +1,65 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/functions.h>
+#include <mem/guest_heap.h>
+#include <mem/state.h>
+
+#include <gtest/gtest.h>
+
+TEST(guest_heap, small_allocations_share_slabs) {
+    MemState state;
+    ASSERT_TRUE(init(state, false));
+    GuestHeap heap;
+    heap.use_slabs = true;
+
+    const Address first = heap.allocate(state, 20);
+    const Address second = heap.allocate(state, 24);
+    ASSERT_NE(first, 0);
+    ASSERT_EQ(second, first + 32);
+    ASSERT_EQ(heap.usable_size(first), 32);
+
+    // the freed block is given to the next allocation of the same class
+    ASSERT_TRUE(heap.free(state, first));
+    ASSERT_EQ(heap.allocate(state, 30), first);
+
+    const Address aligned = heap.allocate(state, 40, 64);
+    ASSERT_NE(aligned, 0);
+    ASSERT_EQ(aligned % 64, 0);
+
+    const Address large = heap.allocate(state, KiB(16));
+    ASSERT_NE(large, 0);
+    ASSERT_EQ(heap.usable_size(large), KiB(16));
+    ASSERT_TRUE(heap.free(state, large));
+
+    ASSERT_FALSE(heap.free(state, first + 1));
+    ASSERT_EQ(heap.usable_size(first + 1), 0);
+}
+
+TEST(guest_heap, pages_mode) {
+    MemState state;
+    ASSERT_TRUE(init(state, false));
+    GuestHeap heap;
+
+    const Address first = heap.allocate(state, 20);
+    const Address second = heap.allocate(state, 20);
+    ASSERT_NE(first, 0);
+    ASSERT_EQ(second % state.page_size, 0);
+    ASSERT_TRUE(heap.free(state, first));
+    ASSERT_TRUE(heap.free(state, second));
+    ASSERT_FALSE(heap.free(state, second));
+}
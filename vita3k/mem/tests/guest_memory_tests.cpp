@@ -0,0 +1,89 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/state.h>
+#include <mem/util.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t PAGE_COUNT = 4;
+
+// Guest pages mapped in reverse order on the host, so that no range larger than a page is contiguous
+struct ScatteredMemory {
+    MemState state;
+    std::array<std::vector<uint8_t>, PAGE_COUNT> pages;
+
+    ScatteredMemory() {
+        state.page_size = KiB(4);
+        state.use_page_table = true;
+        state.page_table = PageTable(new PagePtr[PAGE_COUNT]);
+        for (uint32_t i = 0; i < PAGE_COUNT; i++) {
+            pages[PAGE_COUNT - 1 - i].resize(KiB(4));
+            state.page_table[i] = pages[PAGE_COUNT - 1 - i].data() - i * KiB(4);
+        }
+        for (Address addr = 0; addr < PAGE_COUNT * KiB(4); addr++)
+            at(addr) = static_cast<uint8_t>(addr * 7);
+    }
+
+    uint8_t &at(Address addr) {
+        return state.page_table[addr / KiB(4)][addr];
+    }
+
+    std::vector<uint8_t> read(Address addr, uint32_t size) {
+        std::vector<uint8_t> data(size);
+        for (uint32_t i = 0; i < size; i++)
+            data[i] = at(addr + i);
+        return data;
+    }
+};
+
+} // namespace
+
+TEST(guest_memory, copy_across_pages) {
+    ScatteredMemory mem;
+    const auto expected = mem.read(0x10, KiB(5));
+
+    copy_guest_memory(mem.state, KiB(8) + 0x123, 0x10, KiB(5) - 0x200);
+    ASSERT_EQ(mem.read(KiB(8) + 0x123, KiB(5) - 0x200), std::vector<uint8_t>(expected.begin(), expected.end() - 0x200));
+}
+
+TEST(guest_memory, move_overlapping_forward_and_backward) {
+    ScatteredMemory mem;
+    const auto expected = mem.read(0xF00, KiB(6));
+
+    move_guest_memory(mem.state, 0xF80, 0xF00, KiB(6));
+    ASSERT_EQ(mem.read(0xF80, KiB(6)), expected);
+
+    move_guest_memory(mem.state, 0xF00, 0xF80, KiB(6));
+    ASSERT_EQ(mem.read(0xF00, KiB(6)), expected);
+}
+
+TEST(guest_memory, fill_across_pages) {
+    ScatteredMemory mem;
+    const uint8_t before = mem.at(0xFFF);
+    const uint8_t after = mem.at(KiB(12) + 1);
+
+    fill_guest_memory(mem.state, KiB(4), 0xAB, KiB(8) + 1);
+    ASSERT_EQ(mem.read(KiB(4), KiB(8) + 1), std::vector<uint8_t>(KiB(8) + 1, 0xAB));
+    ASSERT_EQ(mem.at(0xFFF), before);
+    ASSERT_EQ(mem.at(KiB(12) + 1), after);
+}
@@ -0,0 +1,140 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <mem/util.h>
+
+#include <gtest/gtest.h>
+
+TEST(write_tracking, detects_writes_per_page) {
+    MemState state;
+    ASSERT_TRUE(init(state, false));
+    const uint32_t page_size = state.page_size;
+    const Address addr = alloc(state, page_size * 4, "write_tracking");
+    ASSERT_NE(addr, 0);
+
+    const uint32_t sequence = track_writes(state, addr, page_size * 4);
+    ASSERT_FALSE(was_written_since(state, addr, page_size * 4, sequence));
+
+    state.memory[addr + page_size * 2 + 5] = 1;
+    ASSERT_TRUE(was_written_since(state, addr, page_size * 4, sequence));
+    ASSERT_TRUE(was_written_since(state, addr + page_size * 2, page_size, sequence));
+    ASSERT_FALSE(was_written_since(state, addr, page_size * 2, sequence));
+    ASSERT_FALSE(was_written_since(state, addr + page_size * 3, page_size, sequence));
+
+    // the page is writable again until it is tracked again
+    state.memory[addr + page_size * 2 + 6] = 2;
+
+    free(state, addr);
+}
+
+TEST(write_tracking, shared_pages) {
+    MemState state;
+    ASSERT_TRUE(init(state, false));
+    const uint32_t page_size = state.page_size;
+    const Address addr = alloc(state, page_size * 2, "write_tracking");
+    ASSERT_NE(addr, 0);
+
+    const uint32_t first_sequence = track_writes(state, addr, page_size * 2);
+    state.memory[addr] = 1;
+
+    // tracking the range again must not hide the write from the first user
+    const uint32_t second_sequence = track_writes(state, addr, page_size);
+    ASSERT_TRUE(was_written_since(state, addr, page_size * 2, first_sequence));
+    ASSERT_FALSE(was_written_since(state, addr, page_size, second_sequence));
+
+    state.memory[addr + 1] = 2;
+    ASSERT_TRUE(was_written_since(state, addr, page_size, second_sequence));
+
+    free(state, addr);
+}
+
+TEST(write_tracking, soft_dirty) {
+    MemState state;
+    ASSERT_TRUE(init(state, false));
+    if (!enable_soft_dirty_tracking(state))
+        GTEST_SKIP() << "soft-dirty bits are not supported on this host";
+
+    const uint32_t page_size = state.page_size;
+    const Address addr = alloc(state, page_size * 2, "write_tracking");
+    ASSERT_NE(addr, 0);
+
+    const uint32_t sequence = track_writes(state, addr, page_size * 2);
+    collect_written_pages(state);
+    ASSERT_FALSE(was_written_since(state, addr, page_size * 2, sequence));
+
+    // seen before and after the bits are collected
+    state.memory[addr + page_size] = 1;
+    ASSERT_TRUE(was_written_since(state, addr + page_size, page_size, sequence));
+    collect_written_pages(state);
+    ASSERT_TRUE(was_written_since(state, addr + page_size, page_size, sequence));
+    ASSERT_FALSE(was_written_since(state, addr, page_size, sequence));
+
+    free(state, addr);
+}
+
+TEST(write_tracking, protected_pages) {
+    MemState state;
+    ASSERT_TRUE(init(state, false));
+    const uint32_t page_size = state.page_size;
+    const Address addr = alloc(state, page_size * 4, "write_tracking");
+    ASSERT_NE(addr, 0);
+
+    int nb_calls = 0;
+    add_protect(state, addr + page_size, page_size, MemPerm::ReadOnly, [&](Address, bool) {
+        nb_calls++;
+        return true;
+    });
+    ASSERT_FALSE(is_protecting(state, addr));
+    ASSERT_TRUE(is_protecting(state, addr + page_size));
+
+    // the tracked pages covered by the protect are released with it
+    const uint32_t sequence = track_writes(state, addr, page_size * 2);
+    state.memory[addr + page_size] = 1;
+    ASSERT_EQ(nb_calls, 1);
+    ASSERT_FALSE(is_protecting(state, addr + page_size));
+    ASSERT_TRUE(was_written_since(state, addr + page_size, page_size, sequence));
+    ASSERT_FALSE(was_written_since(state, addr, page_size, sequence));
+
+    free(state, addr);
+}
+
+TEST(write_tracking, mark_written) {
+    MemState state;
+    ASSERT_TRUE(init(state, false));
+    const uint32_t page_size = state.page_size;
+    const Address addr = alloc(state, page_size * 4, "write_tracking");
+    ASSERT_NE(addr, 0);
+
+    const uint32_t sequence = track_writes(state, addr, page_size * 4);
+    mark_written(state, addr + page_size, page_size * 2);
+    ASSERT_TRUE(was_written_since(state, addr + page_size, page_size, sequence));
+    ASSERT_TRUE(was_written_since(state, addr + page_size * 2, page_size, sequence));
+    ASSERT_FALSE(was_written_since(state, addr, page_size, sequence));
+    ASSERT_FALSE(was_written_since(state, addr + page_size * 3, page_size, sequence));
+
+    // the host can write to the pages without faulting
+    memset(&state.memory[addr + page_size], 1, page_size * 2);
+
+    // the other pages are still tracked
+    state.memory[addr + page_size * 3] = 1;
+    ASSERT_TRUE(was_written_since(state, addr + page_size * 3, page_size, sequence));
+    ASSERT_FALSE(was_written_since(state, addr, page_size, sequence));
+
+    free(state, addr);
+}
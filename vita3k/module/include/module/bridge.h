@@ -29,20 +29,21 @@
 #include <emuenv/state.h>
 
 using ImportFn = std::function<void(EmuEnvState &emuenv, CPUState &cpu, SceUID thread_id)>;
+using ImportRawFn = void (*)(EmuEnvState &emuenv, CPUState &cpu, SceUID thread_id);
 using ImportVarFactory = std::function<Address(EmuEnvState &emuenv)>;
 using LibraryInitFn = std::function<void(EmuEnvState &emuenv)>;
 
 // Function returns a value that is written to CPU registers.
 template <typename Ret, typename... Args, size_t... indices>
-std::enable_if_t<!std::is_same_v<Ret, void>> call(Ret (*export_fn)(EmuEnvState &, SceUID, const char *, Args...), const char *export_name, const ArgsLayout<Args...> &args_layout, const LayoutArgsState &state, std::index_sequence<indices...>, SceUID thread_id, CPUState &cpu, EmuEnvState &emuenv) {
-    const Ret ret = (*export_fn)(emuenv, thread_id, export_name, read<Args, indices, Args...>(cpu, args_layout, state, emuenv.mem)...);
+std::enable_if_t<!std::is_same_v<Ret, void>> call(Ret (*export_fn)(EmuEnvState &, SceUID, const char *, Args...), const char *export_name, const ArgRegs &regs, const LayoutArgsState &state, std::index_sequence<indices...>, SceUID thread_id, CPUState &cpu, EmuEnvState &emuenv) {
+    const Ret ret = (*export_fn)(emuenv, thread_id, export_name, read<Args, indices, Args...>(cpu, regs, state, emuenv.mem)...);
     write_return_value(cpu, ret);
 }
 
 // Function does not return a value.
 template <typename... Args, size_t... indices>
-void call(void (*export_fn)(EmuEnvState &, SceUID, const char *, Args...), const char *export_name, const ArgsLayout<Args...> &args_layout, const LayoutArgsState &state, std::index_sequence<indices...>, SceUID thread_id, CPUState &cpu, EmuEnvState &emuenv) {
-    (*export_fn)(emuenv, thread_id, export_name, read<Args, indices, Args...>(cpu, args_layout, state, emuenv.mem)...);
+void call(void (*export_fn)(EmuEnvState &, SceUID, const char *, Args...), const char *export_name, const ArgRegs &regs, const LayoutArgsState &state, std::index_sequence<indices...>, SceUID thread_id, CPUState &cpu, EmuEnvState &emuenv) {
+    (*export_fn)(emuenv, thread_id, export_name, read<Args, indices, Args...>(cpu, regs, state, emuenv.mem)...);
 }
 
 template <typename Ret, typename... Args>
@@ -55,7 +56,8 @@ ImportFn bridge(Ret (*export_fn)(EmuEnvState &, SceUID, const char *, Args...),
         ZoneNameV(___tracy_scoped_zone, export_name, strlen(export_name)); // Tracy - Edit scope name based on export_name
 #endif
 
+        // the registers holding the arguments are read once, the layout of each argument is resolved at compile time
         using Indices = std::index_sequence_for<Args...>;
-        call(export_fn, export_name, std::get<0>(args_layout), std::get<1>(args_layout), Indices(), thread_id, cpu, emuenv);
+        call(export_fn, export_name, read_arg_regs(cpu), std::get<1>(args_layout), Indices(), thread_id, cpu, emuenv);
     };
 }
@@ -41,6 +41,15 @@
     extern const ImportFn import_##name = bridge(&export_##name, #name); \
     DECL_EXPORT(ret, name, ##__VA_ARGS__)
 
+// Export reading its arguments straight from the registers, without the argument marshalling
+// and the profiling zone of bridge(). The call is dispatched without going through the std::function.
+// Only use it for very hot and simple functions.
+#define DECL_RAW_EXPORT(name) void export_##name(EmuEnvState &emuenv, CPUState &cpu, SceUID thread_id)
+#define RAW_EXPORT(name)                                  \
+    DECL_RAW_EXPORT(name);                                \
+    extern const ImportFn import_##name = &export_##name; \
+    DECL_RAW_EXPORT(name)
+
 #define DECL_VAR_EXPORT(name) Address export_##name(EmuEnvState &emuenv)
 #define VAR_EXPORT(name)                                         \
     DECL_VAR_EXPORT(name);                                       \
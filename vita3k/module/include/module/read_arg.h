@@ -19,6 +19,7 @@
 
 #include "args_layout.h"
 #include "bridge_types.h"
+#include "lay_out_args.h"
 
 #include <cpu/functions.h>
 
@@ -68,11 +69,28 @@ T read(CPUState &cpu, const ArgLayout &arg, const MemState &mem) {
     return T();
 }
 
+// Read variable from the registers taken by the bridge, the layout is known at compile time.
+template <typename T, ArgLocation location, size_t offset>
+T read(CPUState &cpu, const ArgRegs &regs, const MemState &mem) {
+    if constexpr (location == ArgLocation::gpr) {
+        if constexpr (sizeof(T) == 8)
+            return static_cast<T>(regs.gpr[offset] | (static_cast<uint64_t>(regs.gpr[offset + 1]) << 32));
+        else
+            return static_cast<T>(regs.gpr[offset]);
+    } else if constexpr (location == ArgLocation::stack) {
+        return *Ptr<T>(static_cast<Address>(regs.sp + offset)).get(mem);
+    } else if constexpr (std::is_same_v<T, float>) {
+        return read_from_fp<T>(cpu, { location, offset });
+    } else {
+        return T();
+    }
+}
+
 template <typename T>
 T make_vargs(const LayoutArgsState &state);
 
 template <typename Arg, size_t index, typename... Args>
-Arg read(CPUState &cpu, const ArgsLayout<Args...> &args, const LayoutArgsState &state, const MemState &mem) {
+Arg read(CPUState &cpu, const ArgRegs &regs, const LayoutArgsState &state, const MemState &mem) {
     using ArmType = typename BridgeTypes<Arg>::ArmType;
 
     // Note (bentokun): The else block was intentionally made to workaround evaluation
@@ -80,7 +98,8 @@ Arg read(CPUState &cpu, const ArgsLayout<Args...> &args, const LayoutArgsState &
     if constexpr (std::is_same_v<Arg, module::vargs>) {
         return make_vargs<Arg>(state);
     } else {
-        const ArmType bridged = read<ArmType>(cpu, args[index], mem);
+        constexpr ArgLayout arg = std::get<0>(lay_out<typename BridgeTypes<Args>::ArmType...>())[index];
+        const ArmType bridged = read<ArmType, arg.location, arg.offset>(cpu, regs, mem);
         return BridgeTypes<Arg>::arm_to_host(bridged, mem);
     }
 }
@@ -337,7 +337,7 @@ EXPORT(int, sceAppUtilSaveDataGetQuota, SceSize *quotaSizeKiB, SceSize *usedSize
 
     // Used size from VFS
     if (usedSizeKiB) {
-        *usedSizeKiB = vfs::get_directory_used_size(VitaIoDevice::ux0, emuenv.io.device_paths.savedata0, emuenv.pref_path) / KiB(1);
+        *usedSizeKiB = get_directory_used_size(emuenv.io, VitaIoDevice::ux0, emuenv.io.device_paths.savedata0, emuenv.pref_path) / KiB(1);
 
         // Clamp used size to quota
         if (quotaSizeKiB && (*quotaSizeKiB > 0) && (*usedSizeKiB > *quotaSizeKiB))
@@ -20,6 +20,7 @@
 #include <audio/state.h>
 #include <codec/state.h>
 #include <kernel/state.h>
+#include <mem/functions.h>
 #include <util/lock_and_find.h>
 #include <util/tracy.h>
 
@@ -251,6 +252,14 @@ static int decode_audio_frames(EmuEnvState &emuenv, const char *export_name, Sce
         pcm_data += pcm_size_given;
     }
 
+    if (emuenv.cfg.atrac9_decode_ahead) {
+        // games usually decode their stream in order, the next frames are most likely right after
+        const Address next_frames = ctrl->es_data.address() + ctrl->es_size_used;
+        const uint32_t next_size = ctrl->es_size_max * 2;
+        if (is_valid_addr_range(emuenv.mem, next_frames, next_frames + next_size))
+            decoder->decode_ahead(es_data, next_size);
+    }
+
     return 0;
 }
 
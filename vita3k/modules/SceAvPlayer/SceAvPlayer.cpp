@@ -411,7 +411,9 @@ EXPORT(bool, sceAvPlayerGetVideoData, SceUID player_handle, SceAvPlayerFrameInfo
         } else {
             buffer = get_buffer(player_info, MediaType::VIDEO, emuenv.mem, H264DecoderState::buffer_size(size), true);
 
-            std::vector<uint8_t> data = player_info->player.receive_video();
+            const std::vector<uint8_t> &data = player_info->player.receive_video();
+            // the buffer is usually used as a texture, let the texture cache know it changed without a fault on each page
+            mark_written(emuenv.mem, buffer.address(), static_cast<uint32_t>(data.size()));
             std::memcpy(buffer.get(emuenv.mem), data.data(), data.size());
         }
     } else {
@@ -443,6 +445,8 @@ EXPORT(SceUID, sceAvPlayerInit, SceAvPlayerInfo *info) {
     state->players[player_handle] = player;
 
     player->last_frame_time = current_time();
+    player->player.use_hw_decoding = emuenv.cfg.video_hw_decoding;
+    player->player.nb_threads = emuenv.cfg.video_decoder_threads;
     player->memory_allocator = info->memory_allocator;
     player->file_manager = info->file_manager;
     player->event_manager = info->event_manager;
@@ -121,25 +121,7 @@ EXPORT(int, sceMotionGetState, SceMotionState *motionState) {
 
     if ((emuenv.ctrl.has_motion_support || emuenv.motion.has_device_motion_support) && !emuenv.cfg.disable_motion) {
         std::lock_guard<std::mutex> guard(emuenv.motion.mutex);
-        motionState->timestamp = emuenv.motion.last_accel_timestamp;
-
-        motionState->acceleration = get_acceleration(emuenv.motion);
-        motionState->angularVelocity = get_gyroscope(emuenv.motion);
-
-        Util::Quaternion dev_quat = get_orientation(emuenv.motion);
-        motionState->basicOrientation = get_basic_orientation(emuenv.motion);
-
-        static_assert(sizeof(motionState->deviceQuat) == sizeof(dev_quat));
-        memcpy(&motionState->deviceQuat, &dev_quat, sizeof(motionState->deviceQuat));
-
-        *reinterpret_cast<decltype(dev_quat.ToMatrix()) *>(&motionState->rotationMatrix) = dev_quat.ToMatrix();
-        // not right, but we can't do better without a magnetometer
-        memcpy(&motionState->nedMatrix, &motionState->rotationMatrix, sizeof(motionState->nedMatrix));
-
-        motionState->hostTimestamp = motionState->timestamp;
-        // set it as unstable because we don't have one
-        motionState->magnFieldStability = SCE_MOTION_MAGNETIC_FIELD_UNSTABLE;
-        motionState->dataInfo = 0;
+        *motionState = get_motion_state(emuenv.motion);
     } else {
         // put some default values
         memset(motionState, 0, sizeof(SceMotionState));
@@ -202,6 +184,7 @@ EXPORT(int, sceMotionReset) {
     std::lock_guard<std::mutex> guard(emuenv.motion.mutex);
     emuenv.motion.motion_data.ResetQuaternion();
     emuenv.motion.motion_data.ResetRotations();
+    emuenv.motion.is_cached_state_valid = false;
     return SCE_MOTION_OK;
 }
 
@@ -212,7 +195,9 @@ EXPORT(int, sceMotionResetExt) {
 
 EXPORT(int, sceMotionRotateYaw, const float radians) {
     TRACY_FUNC(sceMotionRotateYaw, radians);
+    std::lock_guard<std::mutex> guard(emuenv.motion.mutex);
     emuenv.motion.motion_data.RotateYaw(radians);
+    emuenv.motion.is_cached_state_valid = false;
     return SCE_MOTION_OK;
 }
 
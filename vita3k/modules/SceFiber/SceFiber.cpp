@@ -67,10 +67,15 @@ typedef struct SceFiber {
 
 static_assert(sizeof(SceFiber) <= 128, "SceFiber struct size is more than 128");
 
+// only accessed by its thread once created
+struct ThreadFiberState {
+    SceFiber *fiber = nullptr; // fiber currently run by the thread
+    CPUContext context; // context of the thread before it started running fibers
+};
+
 struct FiberState {
     std::mutex mutex;
-    std::map<SceUID, SceFiber *> thread_fibers;
-    std::map<SceUID, CPUContext> thread_contexts;
+    std::map<SceUID, ThreadFiberState> threads;
 };
 
 LIBRARY_INIT(SceFiber) {
@@ -79,39 +84,26 @@ LIBRARY_INIT(SceFiber) {
 
 constexpr bool LOG_FIBER = false;
 
-static void set_thread_fiber(FiberState &state, const SceUID &tid, SceFiber *fiber) {
-    state.thread_fibers[tid] = fiber;
-}
-
-static SceFiber *get_thread_fiber(FiberState &state, const SceUID &tid) {
-    auto fiber = state.thread_fibers.find(tid);
-    if (fiber == state.thread_fibers.end()) {
-        return nullptr;
-    }
-    return fiber->second;
-}
-
-static void set_thread_context(FiberState &state, const SceUID &tid, const CPUContext &ctx) {
-    state.thread_contexts[tid] = ctx;
-}
-
-static CPUContext get_thread_context(FiberState &state, const SceUID &tid) {
-    return state.thread_contexts[tid];
+// switches are only context copies on the calling thread, the lock is only taken to find the
+// state of the thread, which does not move afterwards as it is kept in a std::map
+static ThreadFiberState &get_thread_state(FiberState &state, SceUID tid) {
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    return state.threads[tid];
 }
 
-static std::string describe_fiber(FiberState &state, const ThreadStatePtr &thread, SceFiber *fiber) {
+static std::string describe_fiber(ThreadFiberState &thread_state, const ThreadStatePtr &thread, SceFiber *fiber) {
     std::string str;
     auto back_it = std::back_inserter(str);
     fmt::format_to(back_it, "Fiber (name: {})\n", fiber->name);
     fmt::format_to(back_it, "entry: 0x{:X}\n", fiber->entry.address());
     fmt::format_to(back_it, "CPU Context:\n{}", fiber->cpu->description());
     fmt::format_to(back_it, "Referenced from {}\n", thread->id);
-    fmt::format_to(back_it, "CPU Context:\n{}", get_thread_context(state, thread->id).description());
+    fmt::format_to(back_it, "CPU Context:\n{}", thread_state.context.description());
     return str;
 }
 
-static void log_fiber(FiberState &state, const ThreadStatePtr &thread, SceFiber *fiber, const std::string &function_name) {
-    LOG_INFO("{}\n{}", function_name, describe_fiber(state, thread, fiber));
+static void log_fiber(ThreadFiberState &thread_state, const ThreadStatePtr &thread, SceFiber *fiber, const std::string &function_name) {
+    LOG_INFO("{}\n{}", function_name, describe_fiber(thread_state, thread, fiber));
 }
 
 static void setup_fiber_to_run(EmuEnvState &emuenv, const ThreadStatePtr &thread, SceFiber *fiber, uint32_t thread_sp, const uint32_t &argOnRunTo) {
@@ -156,12 +148,12 @@ EXPORT(int, _sceFiberAttachContextAndRun, SceFiber *fiber, Address addrContext,
     // Maybe Need more check on real hw
     STUBBED("Todo: not sure for now");
     const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
     const auto thread = emuenv.kernel.get_thread(thread_id);
-    assert(!get_thread_fiber(*state, thread->id));
+    ThreadFiberState &thread_state = get_thread_state(*state, thread_id);
+    assert(!thread_state.fiber);
     assert(!fiber->addrContext);
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Attach context and run");
+        log_fiber(thread_state, thread, fiber, "Attach context and run");
     }
 
     fiber->addrContext = addrContext;
@@ -171,8 +163,8 @@ EXPORT(int, _sceFiberAttachContextAndRun, SceFiber *fiber, Address addrContext,
     }
 
     setup_fiber_to_run(emuenv, thread, fiber, read_sp(*thread->cpu), argOnRunTo);
-    set_thread_context(*state, thread->id, save_context(*thread->cpu));
-    set_thread_fiber(*state, thread->id, fiber);
+    thread_state.context = save_context(*thread->cpu);
+    thread_state.fiber = fiber;
 
     load_context(*thread->cpu, *fiber->cpu);
     return fiber->cpu->cpu_registers[0];
@@ -183,12 +175,11 @@ EXPORT(int, _sceFiberAttachContextAndSwitch, SceFiber *fiber, Address addrContex
     // Maybe Need more check on real hw
     STUBBED("Todo: not sure for now");
     const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
     const auto thread = emuenv.kernel.get_thread(thread_id);
-    auto ctx = get_thread_context(*state, thread->id);
-    SceFiber *thread_fiber = get_thread_fiber(*state, thread->id);
+    ThreadFiberState &thread_state = get_thread_state(*state, thread_id);
+    SceFiber *thread_fiber = thread_state.fiber;
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Attach context and switch");
+        log_fiber(thread_state, thread, fiber, "Attach context and switch");
     }
 
     assert(thread_fiber);
@@ -200,11 +191,11 @@ EXPORT(int, _sceFiberAttachContextAndSwitch, SceFiber *fiber, Address addrContex
     }
 
     *thread_fiber->cpu = save_context(*thread->cpu);
-    setup_fiber_to_run(emuenv, thread, fiber, ctx.get_sp(), argOnRunTo);
+    setup_fiber_to_run(emuenv, thread, fiber, thread_state.context.get_sp(), argOnRunTo);
     thread_fiber->status = FiberStatus::SUSPEND;
     thread_fiber->argOnRun = argOnRun;
     thread_fiber->cpu->cpu_registers[0] = SCE_FIBER_OK;
-    set_thread_fiber(*state, thread->id, fiber);
+    thread_state.fiber = fiber;
     load_context(*thread->cpu, *fiber->cpu);
 
     return fiber->cpu->cpu_registers[0];
@@ -305,7 +296,8 @@ EXPORT(SceUInt32, sceFiberGetSelf, Ptr<SceFiber> *fiber) {
     }
 
     const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
-    SceFiber *thread_fiber = get_thread_fiber(*state, thread->id);
+    ThreadFiberState &thread_state = get_thread_state(*state, thread_id);
+    SceFiber *thread_fiber = thread_state.fiber;
     if (thread_fiber)
         *fiber = Ptr<SceFiber>(thread_fiber, emuenv.mem);
     else
@@ -337,24 +329,24 @@ EXPORT(int, sceFiberRenameSelf) {
 EXPORT(SceInt32, sceFiberReturnToThread, uint32_t argOnReturnTo, Ptr<uint32_t> argOnRun) {
     TRACY_FUNC(sceFiberReturnToThread, argOnReturnTo, argOnRun);
     const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
     const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
-    SceFiber *fiber = get_thread_fiber(*state, thread->id);
+    ThreadFiberState &thread_state = get_thread_state(*state, thread_id);
+    SceFiber *fiber = thread_state.fiber;
     if (!fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_PERMISSION);
     }
 
-    CPUContext thread_context = get_thread_context(*state, thread->id);
+    const CPUContext &thread_context = thread_state.context;
     assert(fiber->status == FiberStatus::RUN);
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Return to thread");
+        log_fiber(thread_state, thread, fiber, "Return to thread");
     }
 
     *fiber->cpu = save_context(*thread->cpu);
     fiber->cpu->cpu_registers[0] = SCE_FIBER_OK;
     fiber->status = FiberStatus::SUSPEND;
     fiber->argOnRun = argOnRun;
-    set_thread_fiber(*state, thread->id, nullptr);
+    thread_state.fiber = nullptr;
 
     load_context(*thread->cpu, thread_context);
     Address argOnReturn = thread_context.cpu_registers[2];
@@ -368,8 +360,8 @@ EXPORT(SceInt32, sceFiberReturnToThread, uint32_t argOnReturnTo, Ptr<uint32_t> a
 EXPORT(SceUInt32, sceFiberRun, SceFiber *fiber, SceUInt32 argOnRunTo, Ptr<SceUInt32> argOnReturn) {
     TRACY_FUNC(sceFiberRun, fiber, argOnRunTo, argOnReturn);
     const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
     const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
+    ThreadFiberState &thread_state = get_thread_state(*state, thread_id);
     if (!fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_NULL);
     }
@@ -378,17 +370,17 @@ EXPORT(SceUInt32, sceFiberRun, SceFiber *fiber, SceUInt32 argOnRunTo, Ptr<SceUIn
         return RET_ERROR(SCE_FIBER_ERROR_STATE);
     }
 
-    if (get_thread_fiber(*state, thread->id)) {
+    if (thread_state.fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_PERMISSION);
     }
 
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Run");
+        log_fiber(thread_state, thread, fiber, "Run");
     }
 
     setup_fiber_to_run(emuenv, thread, fiber, read_sp(*thread->cpu), argOnRunTo);
-    set_thread_context(*state, thread->id, save_context(*thread->cpu));
-    set_thread_fiber(*state, thread->id, fiber);
+    thread_state.context = save_context(*thread->cpu);
+    thread_state.fiber = fiber;
 
     load_context(*thread->cpu, *fiber->cpu);
     return fiber->cpu->cpu_registers[0];
@@ -407,9 +399,8 @@ EXPORT(int, sceFiberStopContextSizeCheck) {
 EXPORT(SceUInt32, sceFiberSwitch, SceFiber *fiber, SceUInt32 argOnRunTo, Ptr<SceUInt32> argOnRun) {
     TRACY_FUNC(sceFiberSwitch, fiber, argOnRunTo, argOnRun);
     const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
     const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
-    auto ctx = get_thread_context(*state, thread->id);
+    ThreadFiberState &thread_state = get_thread_state(*state, thread_id);
     if (!fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_NULL);
     }
@@ -418,21 +409,21 @@ EXPORT(SceUInt32, sceFiberSwitch, SceFiber *fiber, SceUInt32 argOnRunTo, Ptr<Sce
         return RET_ERROR(SCE_FIBER_ERROR_STATE);
     }
 
-    SceFiber *thread_fiber = get_thread_fiber(*state, thread->id);
+    SceFiber *thread_fiber = thread_state.fiber;
     if (!thread_fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_PERMISSION);
     }
 
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Switch");
+        log_fiber(thread_state, thread, fiber, "Switch");
     }
 
     *thread_fiber->cpu = save_context(*thread->cpu);
     thread_fiber->status = FiberStatus::SUSPEND;
     thread_fiber->argOnRun = argOnRun;
     thread_fiber->cpu->cpu_registers[0] = SCE_FIBER_OK;
-    set_thread_fiber(*state, thread->id, fiber);
-    setup_fiber_to_run(emuenv, thread, fiber, ctx.get_sp(), argOnRunTo);
+    thread_state.fiber = fiber;
+    setup_fiber_to_run(emuenv, thread, fiber, thread_state.context.get_sp(), argOnRunTo);
     load_context(*thread->cpu, *fiber->cpu);
 
     return fiber->cpu->cpu_registers[0];
@@ -44,6 +44,7 @@
 #include <util/align.h>
 #include <util/bytes.h>
 #include <util/log.h>
+#include <util/profile.h>
 
 #include <util/tracy.h>
 TRACY_MODULE_NAME(SceGxm);
@@ -893,6 +894,7 @@ std::string to_debug_str<SceGxmTransferFlags>(const MemState &mem, SceGxmTransfe
 }
 
 static void display_entry_thread(EmuEnvState &emuenv) {
+    PROFILE_THREAD_NAME("Display queue");
     auto &display_queue = emuenv.gxm.display_queue;
     const Address callback_address = emuenv.gxm.params.displayQueueCallback.address();
     const ThreadStatePtr display_thread = emuenv.kernel.get_thread(emuenv.gxm.display_queue_thread);
@@ -1158,8 +1160,7 @@ struct SceGxmContext {
                 new_command = alloc_space.cast<renderer::Command>().get(mem) + offset;
                 new (new_command) renderer::Command;
             } else {
-                new_command = new renderer::Command;
-                new_command->flags |= renderer::Command::FLAG_FROM_HOST;
+                new_command = renderer::generic_command_allocate();
             }
         } else {
             new_command = linearly_allocate<renderer::Command>(kern, mem, current_thread_id);
@@ -1174,12 +1175,17 @@ struct SceGxmContext {
     void free_new_command(renderer::Command *cmd) {
         if (!(cmd->flags & renderer::Command::FLAG_NO_FREE)) {
             if (cmd->flags & renderer::Command::FLAG_FROM_HOST) {
-                delete cmd;
+                renderer::generic_command_free(cmd);
             } else {
                 command_last_free_pos.fetch_add(1, std::memory_order_release);
             }
         }
     }
+
+    // give back the count oldest commands taken from the vdm buffer
+    void release_commands(size_t count) {
+        command_last_free_pos.fetch_add(count, std::memory_order_release);
+    }
 };
 
 // the size of the context on a PS Vita is 2048 bytes
@@ -1807,6 +1813,10 @@ EXPORT(int, sceGxmCreateContext, const SceGxmContextParams *params, Ptr<SceGxmCo
         return ctx->free_new_command(cmd);
     };
 
+    ctx->renderer->release_func = [ctx](size_t count) {
+        ctx->release_commands(count);
+    };
+
     return 0;
 }
 
@@ -2178,13 +2188,7 @@ static int gxmDrawElementGeneral(EmuEnvState &emuenv, const char *export_name, c
     size_t max_index = 0;
     if (!emuenv.renderer->features.enable_memory_mapping) {
         // we don't need to get the vertex buffer size with memory mapping
-        if (indexType == SCE_GXM_INDEX_FORMAT_U16) {
-            const uint16_t *const data = static_cast<const uint16_t *>(indices_ptr);
-            max_index = *std::max_element(&data[0], &data[indexCount]);
-        } else {
-            const uint32_t *const data = static_cast<const uint32_t *>(indices_ptr);
-            max_index = *std::max_element(&data[0], &data[indexCount]);
-        }
+        max_index = gxm::get_max_index(indices_ptr, indexCount, indexType);
     }
 
     size_t max_data_length[SCE_GXM_MAX_VERTEX_STREAMS] = {};
@@ -2300,13 +2304,7 @@ EXPORT(int, sceGxmDrawPrecomputed, SceGxmContext *context, SceGxmPrecomputedDraw
     uint32_t max_index = 0;
     if (!emuenv.renderer->features.enable_memory_mapping) {
         // we don't need to get the vertex buffer size with memory mapping
-        if (draw->index_format == SCE_GXM_INDEX_FORMAT_U16) {
-            const uint16_t *const data = draw->index_data.cast<const uint16_t>().get(emuenv.mem);
-            max_index = *std::max_element(&data[0], &data[draw->vertex_count]);
-        } else {
-            const uint32_t *const data = draw->index_data.cast<const uint32_t>().get(emuenv.mem);
-            max_index = *std::max_element(&data[0], &data[draw->vertex_count]);
-        }
+        max_index = gxm::get_max_index(draw->index_data.get(emuenv.mem), draw->vertex_count, draw->index_format);
     }
 
     // set all textures that are used and mark them as dirty
@@ -3730,6 +3728,10 @@ EXPORT(void, sceGxmSetFragmentProgram, SceGxmContext *context, Ptr<const SceGxmF
     if (!context || !fragmentProgram)
         return;
 
+    // the renderer already uses this program, unless a precomputed draw replaced it since
+    if ((context->state.fragment_program == fragmentProgram) && !context->last_precomputed)
+        return;
+
     context->state.fragment_program = fragmentProgram;
     renderer::set_program(*emuenv.renderer, context->renderer.get(), fragmentProgram, true);
 }
@@ -4114,6 +4116,10 @@ EXPORT(void, sceGxmSetVertexProgram, SceGxmContext *context, Ptr<const SceGxmVer
     if (!context || !vertexProgram)
         return;
 
+    // the renderer already uses this program, unless a precomputed draw replaced it since
+    if ((context->state.vertex_program == vertexProgram) && !context->last_precomputed)
+        return;
+
     context->state.vertex_program = vertexProgram;
     renderer::set_program(*emuenv.renderer, context->renderer.get(), vertexProgram, false);
 }
@@ -4359,7 +4365,7 @@ EXPORT(int, sceGxmShaderPatcherCreateFragmentProgram, SceGxmShaderPatcher *shade
     fp->is_maskupdate = false;
     fp->program = programId->program;
 
-    if (!renderer::create(fp->renderer_data, *emuenv.renderer, *programId->program.get(mem), blendInfo, emuenv.renderer->gxp_ptr_map)) {
+    if (!renderer::create(fp->renderer_data, *emuenv.renderer, *programId->program.get(mem), programId->hash, blendInfo, emuenv.renderer->gxp_ptr_map)) {
         return RET_ERROR(SCE_GXM_ERROR_DRIVER);
     }
 
@@ -4386,7 +4392,8 @@ EXPORT(int, sceGxmShaderPatcherCreateMaskUpdateFragmentProgram, SceGxmShaderPatc
     fp->program = Ptr<const SceGxmProgram>(alloc_callbacked(emuenv, thread_id, shaderPatcher->params, size_mask_gxp));
     memcpy(const_cast<SceGxmProgram *>(fp->program.get(mem)), mask_gxp, size_mask_gxp);
 
-    if (!renderer::create(fp->renderer_data, *emuenv.renderer, *fp->program.get(mem), nullptr, emuenv.renderer->gxp_ptr_map)) {
+    const SceGxmProgram &mask_program = *fp->program.get(mem);
+    if (!renderer::create(fp->renderer_data, *emuenv.renderer, mask_program, sha256(&mask_program, mask_program.size), nullptr, emuenv.renderer->gxp_ptr_map)) {
         return RET_ERROR(SCE_GXM_ERROR_DRIVER);
     }
 
@@ -4438,7 +4445,7 @@ EXPORT(int, sceGxmShaderPatcherCreateVertexProgram, SceGxmShaderPatcher *shaderP
         vp->attributes.insert(vp->attributes.end(), &attributes[0], &attributes[attributeCount]);
     }
 
-    if (!renderer::create(vp->renderer_data, *emuenv.renderer, *programId->program.get(mem), emuenv.renderer->gxp_ptr_map, vp->attributes)) {
+    if (!renderer::create(vp->renderer_data, *emuenv.renderer, *programId->program.get(mem), programId->hash, emuenv.renderer->gxp_ptr_map, vp->attributes)) {
         return RET_ERROR(SCE_GXM_ERROR_DRIVER);
     }
 
@@ -4570,6 +4577,8 @@ EXPORT(int, sceGxmShaderPatcherRegisterProgram, SceGxmShaderPatcher *shaderPatch
 
     SceGxmRegisteredProgram *const rp = programId->get(emuenv.mem);
     rp->program = programHeader;
+    const SceGxmProgram &program = *programHeader.get(emuenv.mem);
+    rp->hash = sha256(&program, program.size);
 
     return 0;
 }
@@ -5294,28 +5303,25 @@ EXPORT(int, sceGxmTransferCopy, uint32_t width, uint32_t height, uint32_t colorK
         sync->last_operation_global = emuenv.gxm.global_timestamp.fetch_add(1, std::memory_order_relaxed);
     }
 
-    // needed, otherwise the command is not big enough
-    SceGxmTransferImage *images = new SceGxmTransferImage[2];
-
-    SceGxmTransferImage *src = &images[0];
-    src->format = srcFormat;
-    src->address = srcAddress;
-    src->x = srcX;
-    src->y = srcY;
-    src->width = width;
-    src->height = height;
-    src->stride = srcStride;
+    SceGxmTransferImage src;
+    src.format = srcFormat;
+    src.address = srcAddress;
+    src.x = srcX;
+    src.y = srcY;
+    src.width = width;
+    src.height = height;
+    src.stride = srcStride;
 
-    SceGxmTransferImage *dest = &images[1];
-    dest->format = destFormat;
-    dest->address = destAddress;
-    dest->x = destX;
-    dest->y = destY;
-    dest->width = width;
-    dest->height = height;
-    dest->stride = destStride;
+    SceGxmTransferImage dest;
+    dest.format = destFormat;
+    dest.address = destAddress;
+    dest.x = destX;
+    dest.y = destY;
+    dest.width = width;
+    dest.height = height;
+    dest.stride = destStride;
 
-    renderer::transfer_copy(*emuenv.renderer, colorKeyValue, colorKeyMask, colorKeyMode, images, srcType, destType);
+    renderer::transfer_copy(*emuenv.renderer, colorKeyValue, colorKeyMask, colorKeyMode, src, dest, srcType, destType);
 
     if (notification)
         renderer::send_single_command(*emuenv.renderer, nullptr, renderer::CommandOpcode::SignalNotification, false, *notification);
@@ -5356,23 +5362,23 @@ EXPORT(int, sceGxmTransferDownscale, SceGxmTransferFormat srcFormat, Ptr<void> s
         sync->last_operation_global = emuenv.gxm.global_timestamp.fetch_add(1, std::memory_order_relaxed);
     }
 
-    SceGxmTransferImage *src = new SceGxmTransferImage;
-    src->format = srcFormat;
-    src->address = srcAddress;
-    src->x = srcX;
-    src->y = srcY;
-    src->width = srcWidth;
-    src->height = srcHeight;
-    src->stride = srcStride;
-
-    SceGxmTransferImage *dest = new SceGxmTransferImage;
-    dest->format = destFormat;
-    dest->address = destAddress;
-    dest->x = destX;
-    dest->y = destY;
-    dest->width = srcWidth / 2;
-    dest->height = srcHeight / 2;
-    dest->stride = destStride;
+    SceGxmTransferImage src;
+    src.format = srcFormat;
+    src.address = srcAddress;
+    src.x = srcX;
+    src.y = srcY;
+    src.width = srcWidth;
+    src.height = srcHeight;
+    src.stride = srcStride;
+
+    SceGxmTransferImage dest;
+    dest.format = destFormat;
+    dest.address = destAddress;
+    dest.x = destX;
+    dest.y = destY;
+    dest.width = srcWidth / 2;
+    dest.height = srcHeight / 2;
+    dest.stride = destStride;
 
     renderer::transfer_downscale(*emuenv.renderer, src, dest);
 
@@ -5411,14 +5417,14 @@ EXPORT(int, sceGxmTransferFill, uint32_t fillColor, SceGxmTransferFormat destFor
         sync->last_operation_global = emuenv.gxm.global_timestamp.fetch_add(1, std::memory_order_relaxed);
     }
 
-    SceGxmTransferImage *dest = new SceGxmTransferImage;
-    dest->format = destFormat;
-    dest->address = destAddress;
-    dest->x = destX;
-    dest->y = destY;
-    dest->width = destWidth;
-    dest->height = destHeight;
-    dest->stride = destStride;
+    SceGxmTransferImage dest;
+    dest.format = destFormat;
+    dest.address = destAddress;
+    dest.x = destX;
+    dest.y = destY;
+    dest.width = destWidth;
+    dest.height = destHeight;
+    dest.stride = destStride;
     renderer::transfer_fill(*emuenv.renderer, fillColor, dest);
 
     if (notification)
@@ -29,6 +29,7 @@
 #define read(x, y, z) _read(x, y, z)
 #else
 #include <netdb.h>
+#include <poll.h>
 #include <sys/socket.h>
 #endif
 
@@ -937,6 +938,17 @@ EXPORT(SceInt, sceHttpRequestGetAllHeaders, SceInt reqId, Ptr<char> *header, Sce
     return 0;
 }
 
+// Returns as soon as the response can be read instead of sleeping for the whole delay
+static void wait_for_response(int sockfd, int timeout_ms) {
+#ifdef _WIN32
+    WSAPOLLFD fd{ static_cast<SOCKET>(sockfd), POLLIN, 0 };
+    WSAPoll(&fd, 1, timeout_ms);
+#else
+    pollfd fd{ sockfd, POLLIN, 0 };
+    poll(&fd, 1, timeout_ms);
+#endif
+}
+
 EXPORT(SceInt, sceHttpSendRequest, SceInt reqId, const char *postData, SceSize size) {
     TRACY_FUNC(sceHttpSendRequest, reqId, postData, size);
     if (!emuenv.http.inited)
@@ -1072,8 +1084,8 @@ EXPORT(SceInt, sceHttpSendRequest, SceInt reqId, const char *postData, SceSize s
                 if (errno == EWOULDBLOCK) {
                     if (attempts > emuenv.cfg.http_read_end_attempts)
                         break; // we can assume there is no more data to read
-                    LOG_TRACE("No data available. Sleep for {}. Attempt {}", emuenv.cfg.http_read_end_sleep_ms, attempts);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(emuenv.cfg.http_read_end_sleep_ms));
+                    LOG_TRACE("No data available. Wait up to {} ms. Attempt {}", emuenv.cfg.http_read_end_sleep_ms, attempts);
+                    wait_for_response(conn->second.sockfd, emuenv.cfg.http_read_end_sleep_ms);
                     attempts++;
                     continue;
                 } else {
@@ -1150,8 +1162,8 @@ EXPORT(SceInt, sceHttpSendRequest, SceInt reqId, const char *postData, SceSize s
                 if (errno == EWOULDBLOCK) {
                     if (attempts > emuenv.cfg.http_read_end_attempts)
                         break; // we can assume there is no more data to read
-                    LOG_TRACE("No data available. Sleep for {}. Attempt {}", emuenv.cfg.http_read_end_sleep_ms, attempts);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(emuenv.cfg.http_read_end_sleep_ms));
+                    LOG_TRACE("No data available. Wait up to {} ms. Attempt {}", emuenv.cfg.http_read_end_sleep_ms, attempts);
+                    wait_for_response(conn->second.sockfd, emuenv.cfg.http_read_end_sleep_ms);
                     attempts++;
                     continue;
                 } else {
@@ -305,9 +305,9 @@ EXPORT(int, sceIoSetThreadDefaultPriorityForSystem) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceIoSyncByFd) {
-    TRACY_FUNC(sceIoSyncByFd);
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoSyncByFd, const SceUID fd, int flag) {
+    TRACY_FUNC(sceIoSyncByFd, fd, flag);
+    return sync_file(emuenv.io, fd, export_name);
 }
 
 EXPORT(int, sceIoSyncByFdAsync) {
@@ -19,14 +19,18 @@
 #include <util/tracy.h>
 TRACY_MODULE_NAME(SceDmacmgr);
 
-EXPORT(int, sceDmacMemcpy, Ptr<void> dst, const void *src, SceSize len) {
+// The DMA transfers are usually large (textures, vertex buffers): the tracked pages of the destination
+// are marked as written at once instead of faulting one by one during the copy
+EXPORT(int, sceDmacMemcpy, Ptr<void> dst, Ptr<const void> src, SceSize len) {
     TRACY_FUNC(sceDmacMemcpy, dst, src, len);
-    memcpy(dst.get(emuenv.mem), src, len);
+    mark_written(emuenv.mem, dst.address(), len);
+    copy_guest_memory(emuenv.mem, dst.address(), src.address(), len);
     return 0;
 }
 
 EXPORT(int, sceDmacMemset, Ptr<void> dst, int ch, SceSize len) {
     TRACY_FUNC(sceDmacMemset, dst, ch, len);
-    memset(dst.get(emuenv.mem), ch, len);
+    mark_written(emuenv.mem, dst.address(), len);
+    fill_guest_memory(emuenv.mem, dst.address(), static_cast<uint8_t>(ch), len);
     return 0;
 }
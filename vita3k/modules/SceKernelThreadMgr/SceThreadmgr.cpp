@@ -23,6 +23,7 @@
 #include <kernel/sync_primitives.h>
 #include <kernel/types.h>
 #include <packages/functions.h>
+#include <rtc/rtc.h>
 
 #include <util/lock_and_find.h>
 
@@ -33,9 +34,7 @@
 TRACY_MODULE_NAME(SceThreadmgr);
 
 inline static uint64_t get_current_time() {
-    return std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch())
-        .count();
+    return rtc_ticks_since_epoch();
 }
 
 EXPORT(int, __sceKernelCreateLwMutex, Ptr<SceKernelLwMutexWork> workarea, const char *name, unsigned int attr, Ptr<SceKernelCreateLwMutex_opt> opt) {
@@ -903,6 +902,11 @@ EXPORT(SceInt32, sceKernelChangeThreadCpuAffinityMask, SceUID thid, SceInt32 aff
 
     thread->affinity_mask = affinity_mask;
     thread->tls.get_ptr<int>().get(emuenv.mem)[TLS_CPU_AFFINITY_MASK] = affinity_mask;
+    // only the calling host thread can be moved, the other threads apply it after their next kernel call
+    if (thread->id == thread_id)
+        emuenv.kernel.host_thread_policy.apply(affinity_mask, thread->priority);
+    else
+        thread->host_policy_changed = true;
     return old_affinity;
 }
 
@@ -928,6 +932,10 @@ EXPORT(SceInt32, sceKernelChangeThreadPriority2, SceUID thid, SceInt32 priority)
 
     thread->priority = priority;
     thread->tls.get_ptr<int>().get(emuenv.mem)[TLS_CURRENT_PRIORITY] = priority;
+    if (thread->id == thread_id)
+        emuenv.kernel.host_thread_policy.apply(thread->affinity_mask, priority);
+    else
+        thread->host_policy_changed = true;
 
     return old_priority;
 }
@@ -1048,25 +1056,27 @@ EXPORT(int, sceKernelCreateThreadForUser, const char *name, SceKernelThreadEntry
     return thread->id;
 }
 
+// the delays are as long on the guest clock, so they are shorter in fast forward
+static std::chrono::steady_clock::time_point get_delay_deadline(SceUInt delay_us) {
+    return std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(delay_us / rtc_get_speed()));
+}
+
 static int delay_thread(SceUInt delay_us) {
     if (delay_us == 0)
         return SCE_KERNEL_ERROR_INVALID_ARGUMENT;
 
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+    std::this_thread::sleep_until(get_delay_deadline(delay_us));
 
     return SCE_KERNEL_OK;
 }
 
 static int delay_thread_cb(EmuEnvState &emuenv, SceUID thread_id, SceUInt delay_us) {
-    auto start = std::chrono::high_resolution_clock::now(); // Meseaure the time taken to process callbacks
+    // the time taken to process the callbacks is part of the delay
+    const auto deadline = get_delay_deadline(delay_us);
     process_callbacks(emuenv.kernel, thread_id);
-    auto end = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    std::this_thread::sleep_until(deadline);
 
-    if (delay_us > elapsed.count()) // If we spent less time than requested processing callbacks, sleep the remaining time
-        return delay_thread(delay_us - elapsed.count());
-    else // Else return directly
-        return SCE_KERNEL_OK;
+    return SCE_KERNEL_OK;
 }
 
 EXPORT(int, sceKernelDelayThread, SceUInt delay) {
@@ -1192,6 +1202,7 @@ EXPORT(int, sceKernelGetProcessId) {
 
 EXPORT(uint64_t, sceKernelGetSystemTimeWide) {
     TRACY_FUNC(sceKernelGetSystemTimeWide);
+    emuenv.kernel.on_time_polled(thread_id);
     return get_current_time();
 }
 
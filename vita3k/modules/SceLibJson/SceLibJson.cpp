@@ -17,6 +17,9 @@
 
 #include <module/module.h>
 
+// libSceJson is loaded from the firmware by default (see auto_lle_modules): the documents are parsed
+// by the guest code into values allocated with the allocator given by the application
+
 EXPORT(int, _ZN3sce4Json11Initializer10initializeEPKNS0_13InitParameterE) {
     return UNIMPLEMENTED();
 }
@@ -17,6 +17,9 @@
 
 #include <module/module.h>
 
+// libmono_bridge is shipped in the sce_module folder of the Mono titles and runs from there: these are the
+// exports of its platform layer (eglib, pthread, pss_*), they are only called when the module could not be loaded.
+
 EXPORT(int, __aeabi_unwind_cpp_pr0) {
     return UNIMPLEMENTED();
 }
@@ -17,6 +17,8 @@
 
 #include <module/module.h>
 
+// libSceXml is loaded from the firmware by default (see auto_lle_modules), these are only used in manual modules mode
+
 EXPORT(int, _ZN3sce3Xml10SimpleDataC1EPKcj) {
     return UNIMPLEMENTED();
 }
@@ -477,7 +477,8 @@ EXPORT(int, fread) {
 
 EXPORT(void, free, Address mem) {
     TRACY_FUNC(free, mem);
-    free(emuenv.mem, mem);
+    if (!emuenv.kernel.libc_heap.free(emuenv.mem, mem))
+        free(emuenv.mem, mem);
 }
 
 EXPORT(int, freopen) {
@@ -768,12 +769,13 @@ EXPORT(int, longjmp) {
 
 EXPORT(int, malloc, SceSize size) {
     TRACY_FUNC(malloc, size);
-    return alloc(emuenv.mem, size, __FUNCTION__);
+    return emuenv.kernel.libc_heap.allocate(emuenv.mem, size);
 }
 
 EXPORT(int, malloc_stats) {
     TRACY_FUNC(malloc_stats);
-    return UNIMPLEMENTED();
+    emuenv.kernel.libc_heap.log_stats();
+    return 0;
 }
 
 EXPORT(int, malloc_stats_fast) {
@@ -781,9 +783,9 @@ EXPORT(int, malloc_stats_fast) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, malloc_usable_size) {
-    TRACY_FUNC(malloc_usable_size);
-    return UNIMPLEMENTED();
+EXPORT(SceSize, malloc_usable_size, Address mem) {
+    TRACY_FUNC(malloc_usable_size, mem);
+    return emuenv.kernel.libc_heap.usable_size(mem);
 }
 
 EXPORT(int, mblen) {
@@ -843,7 +845,7 @@ EXPORT(int, mbtowc) {
 
 EXPORT(Ptr<void>, memalign, uint32_t alignment, uint32_t size) {
     TRACY_FUNC(memalign, alignment, size);
-    Address address = alloc_aligned(emuenv.mem, size, "memalign", alignment);
+    Address address = emuenv.kernel.libc_heap.allocate(emuenv.mem, size, alignment);
 
     return Ptr<void>(address);
 }
@@ -858,9 +860,9 @@ EXPORT(int, memcmp) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(void, memcpy, void *destination, const void *source, uint32_t num) {
-    TRACY_FUNC(memcpy, destination, source, num);
-    memcpy(destination, source, num);
+// memcpy, memmove and memset return their destination which is already in r0
+RAW_EXPORT(memcpy) {
+    copy_guest_memory(emuenv.mem, read_reg(cpu, 0), read_reg(cpu, 1), read_reg(cpu, 2));
 }
 
 EXPORT(int, memcpy_s) {
@@ -868,9 +870,8 @@ EXPORT(int, memcpy_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(void, memmove, void *destination, const void *source, uint32_t num) {
-    TRACY_FUNC(memmove, destination, source, num);
-    memmove(destination, source, num);
+RAW_EXPORT(memmove) {
+    move_guest_memory(emuenv.mem, read_reg(cpu, 0), read_reg(cpu, 1), read_reg(cpu, 2));
 }
 
 EXPORT(int, memmove_s) {
@@ -878,9 +879,8 @@ EXPORT(int, memmove_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(void, memset, Ptr<void> str, int c, uint32_t n) {
-    TRACY_FUNC(memset, str, c, n);
-    memset(str.get(emuenv.mem), c, n);
+RAW_EXPORT(memset) {
+    fill_guest_memory(emuenv.mem, read_reg(cpu, 0), static_cast<uint8_t>(read_reg(cpu, 1)), read_reg(cpu, 2));
 }
 
 EXPORT(int, mktime) {
@@ -17,6 +17,8 @@
 
 #include <module/module.h>
 
+// libSceFt2 is always loaded from the firmware (see auto_lle_module_names), the glyphs are rasterized by the guest code
+
 EXPORT(int, FT_Activate_Size) {
     return UNIMPLEMENTED();
 }
@@ -18,6 +18,7 @@
 #include "SceNet.h"
 
 #include <kernel/state.h>
+#include <kernel/thread/thread_state.h>
 
 #include <net/state.h>
 
@@ -136,6 +137,18 @@ static int ret_net_errno(EmuEnvState &emuenv, int thread_id, int ret) {
         return (_r < 0 ? RET_ERROR(_r) : _r);             \
     } while (0)
 
+// The thread is shown as waiting while the socket call may wait for the host socket
+template <typename F>
+static auto wait_on_socket(EmuEnvState &emuenv, SceUID thread_id, F &&op) {
+    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
+    if (thread)
+        thread->update_status(ThreadStatus::wait);
+    auto res = op();
+    if (thread)
+        thread->update_status(ThreadStatus::run);
+    return res;
+}
+
 EXPORT(int, sceNetAccept, int sid, SceNetSockaddr *addr, unsigned int *addrlen) {
     TRACY_FUNC(sceNetAccept, sid, addr, addrlen);
     auto sock = lock_and_find(sid, emuenv.net.socks, emuenv.kernel.mutex);
@@ -143,7 +156,7 @@ EXPORT(int, sceNetAccept, int sid, SceNetSockaddr *addr, unsigned int *addrlen)
         RET_NET_ERRNO(SCE_NET_ERROR_EBADF);
 
     int err = 0;
-    auto newsock = sock->accept(addr, addrlen, err);
+    auto newsock = wait_on_socket(emuenv, thread_id, [&] { return sock->accept(addr, addrlen, err); });
     if (!newsock)
         RET_NET_ERRNO(err);
 
@@ -168,7 +181,10 @@ EXPORT(int, sceNetConnect, int sid, const SceNetSockaddr *addr, unsigned int add
     TRACY_FUNC(sceNetConnect, sid, addr, addrlen);
     auto sock = lock_and_find(sid, emuenv.net.socks, emuenv.kernel.mutex);
 
-    RET_NET_ERRNO(sock ? sock->connect(addr, addrlen) : SCE_NET_ERROR_EBADF);
+    if (!sock)
+        RET_NET_ERRNO(SCE_NET_ERROR_EBADF);
+
+    RET_NET_ERRNO(wait_on_socket(emuenv, thread_id, [&] { return sock->connect(addr, addrlen); }));
 }
 
 EXPORT(int, sceNetDumpAbort) {
@@ -251,7 +267,10 @@ EXPORT(int, sceNetEpollWait, int eid, SceNetEpollEvent *events, int maxevents, i
     TRACY_FUNC(sceNetEpollWait, eid, events, maxevents, timeout);
     auto epoll = lock_and_find(eid, emuenv.net.epolls, emuenv.kernel.mutex);
 
-    RET_NET_ERRNO(epoll ? epoll->wait(events, maxevents, timeout) : SCE_NET_ERROR_EBADF);
+    if (!epoll)
+        RET_NET_ERRNO(SCE_NET_ERROR_EBADF);
+
+    RET_NET_ERRNO(wait_on_socket(emuenv, thread_id, [&] { return epoll->wait(events, maxevents, timeout); }));
 }
 
 EXPORT(int, sceNetEpollWaitCB) {
@@ -517,14 +536,20 @@ EXPORT(int, sceNetRecv, int sid, void *buf, unsigned int len, int flags) {
     TRACY_FUNC(sceNetRecv, sid, buf, len, flags);
     auto sock = lock_and_find(sid, emuenv.net.socks, emuenv.kernel.mutex);
 
-    RET_NET_ERRNO(sock ? sock->recv_packet(buf, len, flags, nullptr, 0) : SCE_NET_ERROR_EBADF);
+    if (!sock)
+        RET_NET_ERRNO(SCE_NET_ERROR_EBADF);
+
+    RET_NET_ERRNO(wait_on_socket(emuenv, thread_id, [&] { return sock->recv_packet(buf, len, flags, nullptr, 0); }));
 }
 
 EXPORT(int, sceNetRecvfrom, int sid, void *buf, unsigned int len, int flags, SceNetSockaddr *from, unsigned int *fromlen) {
     TRACY_FUNC(sceNetRecvfrom, sid, buf, len, flags, from, fromlen);
     auto sock = lock_and_find(sid, emuenv.net.socks, emuenv.kernel.mutex);
 
-    RET_NET_ERRNO(sock ? sock->recv_packet(buf, len, flags, from, fromlen) : SCE_NET_ERROR_EBADF);
+    if (!sock)
+        RET_NET_ERRNO(SCE_NET_ERROR_EBADF);
+
+    RET_NET_ERRNO(wait_on_socket(emuenv, thread_id, [&] { return sock->recv_packet(buf, len, flags, from, fromlen); }));
 }
 
 EXPORT(int, sceNetRecvmsg) {
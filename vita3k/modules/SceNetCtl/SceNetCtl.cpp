@@ -29,6 +29,7 @@
 #include <rtc/rtc.h>
 #include <util/lock_and_find.h>
 #include <util/net_utils.h>
+#include <util/profile.h>
 
 #include <util/tracy.h>
 TRACY_MODULE_NAME(SceNetCtl);
@@ -137,6 +138,7 @@ struct SceNetCtlIfStat {
 };
 
 static void adhoc_thread(EmuEnvState &emuenv, int thread_id) {
+    PROFILE_THREAD_NAME("Adhoc");
     LOG_INFO("Adhoc thread started");
     constexpr uint16_t AUTH_RECV_VPORT = 0x8235;
     constexpr uint16_t AUTH_SEND_VPORT = 0x8236;
@@ -537,7 +537,9 @@ static int do_trophy_callback(EmuEnvState &emuenv, np::trophy::Context *context,
         callback_data.icon_buf.resize(buf_size);
         context->copy_file_data_from_trophy_file(trophy_icon_filename.c_str(), &callback_data.icon_buf[0], &buf_size);
 
-        emuenv.np.trophy_state.trophy_unlock_callback(callback_data);
+        emuenv.np.trophy_state.worker.submit([&trophy_state = emuenv.np.trophy_state, callback_data = std::move(callback_data)]() mutable {
+            trophy_state.trophy_unlock_callback(callback_data);
+        });
     }
 
     return 0;
@@ -588,6 +590,8 @@ EXPORT(int, sceNpTrophyUnlockTrophy, np::trophy::ContextHandle context_handle, S
     } else
         *platinum_id = np::SCE_NP_TROPHY_INVALID_TROPHY_ID;
 
+    context->queue_trophy_progress_save(emuenv.np.trophy_state.worker);
+
     const int err = do_trophy_callback(emuenv, context, trophy_id);
 
     if (err < 0) {
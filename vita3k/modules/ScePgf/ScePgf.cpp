@@ -17,6 +17,8 @@
 
 #include <module/module.h>
 
+// libpgf is loaded from the firmware by default (see auto_lle_modules), with the cache given in SceFontNewLibParams
+
 typedef void *SceFontLibHandle;
 typedef void *SceFontHandle;
 struct SceFontNewLibParams {
@@ -17,6 +17,8 @@
 
 #include <module/module.h>
 
+// libpvf is always loaded from the firmware (see auto_lle_module_names), it caches the glyph images itself
+
 EXPORT(int, __scePvfSetFt2DoneLibCHook) {
     return UNIMPLEMENTED();
 }
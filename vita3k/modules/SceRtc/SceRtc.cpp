@@ -154,6 +154,7 @@ EXPORT(int, _sceRtcGetCurrentRetainedNetworkTick) {
 
 EXPORT(int, _sceRtcGetCurrentTick, SceRtcTick *tick) {
     TRACY_FUNC(_sceRtcGetCurrentTick, tick);
+    emuenv.kernel.on_time_polled(thread_id);
     if (tick == nullptr) {
         return RET_ERROR(SCE_RTC_ERROR_INVALID_POINTER);
     }
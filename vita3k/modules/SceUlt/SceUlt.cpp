@@ -17,6 +17,9 @@
 
 #include <module/module.h>
 
+// libult is loaded from the firmware by default (see auto_lle_modules), its ulthreads are switched by the guest code
+// itself. These exports are only used when the module is missing or left out in the manual modules mode.
+
 EXPORT(int, _sceUltConditionVariableCreate) {
     return UNIMPLEMENTED();
 }
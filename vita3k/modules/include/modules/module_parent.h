@@ -28,6 +28,8 @@ struct KernelState;
 void init_libraries(EmuEnvState &emuenv);
 void init_exported_vars(EmuEnvState &emuenv);
 void call_import(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread_id);
+// call an import whose slot was resolved when writing its stub
+void call_import_slot(EmuEnvState &emuenv, CPUState &cpu, uint32_t slot, SceUID thread_id);
 
 /**
  * \brief Loads a dynamic module into memory if it wasn't already loaded. If it was, find it and return it.
@@ -38,6 +40,23 @@ void call_import(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread
 SceUID load_module(EmuEnvState &emuenv, const std::string &module_path);
 int unload_module(EmuEnvState &emuenv, SceUID module_id);
 
+/**
+ * \brief Defers the loading of the module serving a library to the first call of one of its imported functions
+ * \param emuenv PlayStation Vita emulated environment
+ * \param library_name Name of the imported library
+ * \param module_path Full path of module file (with device)
+ */
+void defer_module_load(EmuEnvState &emuenv, const std::string &library_name, const std::string &module_path);
+bool is_module_load_deferred(EmuEnvState &emuenv, const std::string &module_path);
+
+/**
+ * \brief Reads and decrypts in the background the modules loaded by the last boot of the app, and records the ones loaded by this boot
+ * \param emuenv PlayStation Vita emulated environment
+ */
+void prefetch_boot_modules(EmuEnvState &emuenv);
+// The boot is over, saves the list of the modules it loaded for the next one
+void end_boot_modules_prefetch(EmuEnvState &emuenv);
+
 uint32_t start_module(EmuEnvState &emuenv, const SceKernelModuleInfo &module, SceSize args = 0, Ptr<const void> argp = Ptr<const void>{});
 uint32_t stop_module(EmuEnvState &emuenv, const SceKernelModuleInfo &module, SceSize args = 0, Ptr<const void> argp = Ptr<const void>{});
 
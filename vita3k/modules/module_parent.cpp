@@ -33,11 +33,19 @@
 #include <packages/license.h>
 #include <packages/sce_types.h>
 #include <patch/patch.h>
+#include <threads/job_pool.h>
+#include <util/boot_trace.h>
 #include <util/find.h>
 #include <util/lock_and_find.h>
 #include <util/log.h>
 #include <util/string_utils.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <future>
+#include <map>
+#include <memory>
 #include <unordered_set>
 
 static constexpr bool LOG_UNK_NIDS_ALWAYS = false;
@@ -102,7 +110,7 @@ Ptr<void> create_vtable(const std::vector<uint32_t> &nids, MemState &mem) {
     for (uint32_t nid : nids) {
         *function_pointer = function_location;
         // encode svc call
-        function_svc[0] = 0xef000000; // svc #0 - Call our interrupt hook.
+        function_svc[0] = encode_import_svc(nid); // svc - Call our interrupt hook.
         function_svc[1] = 0xe1a0f00e; // mov pc, lr - Return to the caller.
         function_svc[2] = nid; // Our interrupt hook will read this.
 
@@ -161,10 +169,123 @@ static void log_import_call(char emulation_level, uint32_t nid, SceUID thread_id
     }
 }
 
+static void trace_import_call(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread_id) {
+    const uint32_t args[4] = { read_reg(cpu, 0), read_reg(cpu, 1), read_reg(cpu, 2), read_reg(cpu, 3) };
+    emuenv.kernel.import_trace.record(nid, thread_id, read_lr(cpu), args);
+}
+
+// Same order as the slots returned by import_slot
+static const ImportFn *const import_slots[] = {
+#define VAR_NID(name, nid)
+#define NID(name, nid) &import_##name,
+#include <nids/nids.inc>
+#undef NID
+#undef VAR_NID
+};
+
+// Plain function pointers of the imports declared with RAW_EXPORT, null for the other ones
+// built on first use as the imports are initialized dynamically in other translation units
+static const std::vector<ImportRawFn> &get_import_raw_slots() {
+    static const std::vector<ImportRawFn> raw_slots = []() {
+        std::vector<ImportRawFn> slots(std::size(import_slots), nullptr);
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (const ImportRawFn *raw_fn = import_slots[i]->target<ImportRawFn>())
+                slots[i] = *raw_fn;
+        }
+        return slots;
+    }();
+    return raw_slots;
+}
+
+void call_import_slot(EmuEnvState &emuenv, CPUState &cpu, uint32_t slot, SceUID thread_id) {
+    assert(slot < std::size(import_slots));
+    if (emuenv.kernel.import_trace.enabled)
+        trace_import_call(emuenv, cpu, import_slot_nid(slot), thread_id);
+    const HleProfiler::Clock::time_point start = emuenv.kernel.hle_profiler.start();
+    if (const ImportRawFn raw_fn = get_import_raw_slots()[slot])
+        raw_fn(emuenv, cpu, thread_id);
+    else
+        (*import_slots[slot])(emuenv, cpu, thread_id);
+    emuenv.kernel.hle_profiler.record(slot, start);
+}
+
+void defer_module_load(EmuEnvState &emuenv, const std::string &library_name, const std::string &module_path) {
+    const std::lock_guard<std::mutex> guard(emuenv.kernel.export_nids_mutex);
+    emuenv.kernel.lazy_module_by_library[library_name] = module_path;
+}
+
+bool is_module_load_deferred(EmuEnvState &emuenv, const std::string &module_path) {
+    const std::lock_guard<std::mutex> guard(emuenv.kernel.export_nids_mutex);
+    return std::any_of(emuenv.kernel.lazy_module_by_library.begin(), emuenv.kernel.lazy_module_by_library.end(), [&](const auto &library) {
+        return library.second == module_path;
+    });
+}
+
+static SceUID load_and_start_module(EmuEnvState &emuenv, const std::string &module_path) {
+    const SceUID module_id = load_module(emuenv, module_path);
+    if (module_id < 0)
+        return module_id;
+
+    const auto module = lock_and_find(module_id, emuenv.kernel.loaded_modules, emuenv.kernel.mutex);
+    start_module(emuenv, module->info);
+    return module_id;
+}
+
+// The first call to a function of a deferred module loads and starts it, then goes on in the export.
+// Loading the module binds the stubs of all its imports, so the next calls don't come here.
+static bool call_lazy_module_export(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid) {
+    KernelState &kernel = emuenv.kernel;
+    std::string module_path;
+    {
+        const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+        const auto module_it = kernel.lazy_module_by_nid.find(nid);
+        if (module_it == kernel.lazy_module_by_nid.end())
+            return false;
+        module_path = module_it->second;
+    }
+
+    // the mutex is not held during the load: module_start may call into another deferred module
+    std::shared_future<SceUID> module_load;
+    std::promise<SceUID> module_load_promise;
+    bool is_loader = false;
+    {
+        const std::lock_guard<std::mutex> guard(kernel.lazy_modules_mutex);
+        const auto load_it = kernel.lazy_module_loads.find(module_path);
+        if (load_it == kernel.lazy_module_loads.end()) {
+            module_load = module_load_promise.get_future().share();
+            kernel.lazy_module_loads.emplace(module_path, module_load);
+            is_loader = true;
+        } else {
+            module_load = load_it->second;
+        }
+    }
+    if (is_loader) {
+        LOG_INFO("Loading deferred module {} at the first call to {}", module_path, import_name(nid));
+        module_load_promise.set_value(load_and_start_module(emuenv, module_path));
+    }
+    if (module_load.get() < 0)
+        return false;
+
+    Address export_address;
+    {
+        const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+        const auto export_it = kernel.export_nids.find(nid);
+        if (export_it == kernel.export_nids.end())
+            return false;
+        export_address = export_it->second;
+    }
+
+    // the registers still hold the arguments and the return address of the call
+    write_pc(cpu, export_address);
+    return true;
+}
+
 void call_import(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread_id) {
     // HLE - call our C++ function
+    if (emuenv.kernel.import_trace.enabled)
+        trace_import_call(emuenv, cpu, nid, thread_id);
     if (emuenv.kernel.debugger.watch_import_calls) {
-        const std::unordered_set<uint32_t> hle_nid_blacklist = {
+        static const std::unordered_set<uint32_t> hle_nid_blacklist = {
             0xB295EB61, // sceKernelGetTLSAddr
             0x46E7BE7B, // sceKernelLockLwMutex
             0x91FA6614, // sceKernelUnlockLwMutex
@@ -172,9 +293,15 @@ void call_import(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread
         auto lr = read_lr(cpu);
         log_import_call('H', nid, thread_id, hle_nid_blacklist, lr);
     }
+    if (call_lazy_module_export(emuenv, cpu, nid))
+        return;
+
     const ImportFn *fn = resolve_import(nid);
     if (fn) {
+        const HleProfiler::Clock::time_point start = emuenv.kernel.hle_profiler.start();
         (*fn)(emuenv, cpu, thread_id);
+        if (start != HleProfiler::Clock::time_point{})
+            emuenv.kernel.hle_profiler.record(import_slot(nid), start);
     } else {
         const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
         // make the function return 0
@@ -188,22 +315,8 @@ void call_import(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread
     }
 }
 
-SceUID load_module(EmuEnvState &emuenv, const std::string &module_path) {
-    // Check if module is already loaded
-    {
-        const std::lock_guard<std::mutex> lock(emuenv.kernel.mutex);
-        const auto &loaded_modules = emuenv.kernel.loaded_modules;
-        auto module_iter = std::find_if(loaded_modules.begin(), loaded_modules.end(), [&](const auto &p) {
-            return module_path == p.second->info.path;
-        });
-
-        if (module_iter != loaded_modules.end()) {
-            return module_iter->first;
-        }
-    }
-
-    LOG_INFO("Loading module \"{}\"", module_path);
-    vfs::FileBuffer module_buffer;
+// reads the module file, decrypted if needed, returns a negative error if it failed
+static SceUID read_module(EmuEnvState &emuenv, const std::string &module_path, vfs::FileBuffer &module_buffer) {
     bool res;
     VitaIoDevice device = device::get_device(module_path);
     auto device_for_icase = device;
@@ -240,16 +353,181 @@ SceUID load_module(EmuEnvState &emuenv, const std::string &module_path) {
         return SCE_ERROR_ERRNO_ENOENT;
     }
 
-    // Decrypt module file if necessary
-    module_buffer = decrypt_fself(module_buffer, emuenv.license.rif[emuenv.io.title_id].key);
+    // Decrypt module file if necessary, the modules already decrypted once come from the cache
+    module_buffer = decrypt_fself_cached(module_buffer, emuenv.license.rif[emuenv.io.title_id].key, emuenv.cache_path);
     if (module_buffer.empty()) {
         LOG_ERROR("Failed to decrypt module file {}", module_path);
         return SCE_ERROR_ERRNO_ENOENT;
     }
+    return 0;
+}
+
+// modules read and decrypted ahead of their loading during the boot of the app, see prefetch_boot_modules
+static struct {
+    std::mutex mutex;
+    JobPool pool;
+    std::map<std::string, std::future<vfs::FileBuffer>> prefetched;
+    // modules loaded since the start of the boot, in order
+    std::vector<std::string> loaded;
+    bool recording = false;
+} boot_modules;
+
+static fs::path get_boot_modules_path(EmuEnvState &emuenv) {
+    return emuenv.cache_path / "boot_modules" / fmt::format("{}.txt", emuenv.io.title_id);
+}
+
+// same as read_module without the case-insensitive search, the modules which need it are read by load_module
+static vfs::FileBuffer prefetch_module(EmuEnvState &emuenv, const std::string &module_path, const std::array<uint8_t, 16> &klic) {
+    const VitaIoDevice device = device::get_device(module_path);
+    const fs::path translated_module_path = translate_path(module_path.c_str(), device, emuenv.io.device_paths);
+
+    vfs::FileBuffer module_buffer;
+    bool res;
+    if (device == VitaIoDevice::app0)
+        res = vfs::read_app_file(module_buffer, emuenv.pref_path, emuenv.io.app_path, translated_module_path);
+    else
+        res = vfs::read_file(device, module_buffer, emuenv.pref_path, translated_module_path);
+    if (!res)
+        return {};
+
+    return decrypt_fself_cached(module_buffer, klic.data(), emuenv.cache_path);
+}
+
+void prefetch_boot_modules(EmuEnvState &emuenv) {
+    const std::lock_guard<std::mutex> guard(boot_modules.mutex);
+    boot_modules.recording = true;
+    boot_modules.loaded.clear();
+    boot_modules.prefetched.clear();
+
+    fs::ifstream list(get_boot_modules_path(emuenv));
+    if (!list)
+        return;
+
+    // the jobs must not touch the license map, a lookup can insert in it
+    std::array<uint8_t, 16> klic;
+    std::copy_n(emuenv.license.rif[emuenv.io.title_id].key, klic.size(), klic.begin());
+
+    boot_modules.pool.start(static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 1U, 4U)));
+    std::string module_path;
+    while (std::getline(list, module_path)) {
+        if (module_path.empty() || boot_modules.prefetched.contains(module_path))
+            continue;
+        boot_modules.prefetched[module_path] = boot_modules.pool.submit([&emuenv, module_path, klic] {
+            return prefetch_module(emuenv, module_path, klic);
+        });
+    }
+    LOG_INFO("Prefetching {} modules loaded by the last boot", boot_modules.prefetched.size());
+}
+
+void end_boot_modules_prefetch(EmuEnvState &emuenv) {
+    std::vector<std::string> loaded;
+    {
+        const std::lock_guard<std::mutex> guard(boot_modules.mutex);
+        if (!boot_modules.recording)
+            return;
+        boot_modules.recording = false;
+        loaded = std::move(boot_modules.loaded);
+        // the modules not loaded this time are dropped with the rest
+        boot_modules.prefetched.clear();
+    }
+    boot_modules.pool.stop();
+
+    const auto list_path = get_boot_modules_path(emuenv);
+    boost::system::error_code error_code{};
+    fs::create_directories(list_path.parent_path(), error_code);
+    fs::ofstream list(list_path);
+    for (const auto &module_path : loaded)
+        list << module_path << '\n';
+}
+
+static void record_boot_module(const std::string &module_path) {
+    const std::lock_guard<std::mutex> guard(boot_modules.mutex);
+    if (boot_modules.recording)
+        boot_modules.loaded.push_back(module_path);
+}
+
+// an empty buffer if the module was not prefetched or could not be read that way
+static vfs::FileBuffer take_prefetched_module(const std::string &module_path) {
+    std::future<vfs::FileBuffer> prefetched;
+    {
+        const std::lock_guard<std::mutex> guard(boot_modules.mutex);
+        const auto it = boot_modules.prefetched.find(module_path);
+        if (it == boot_modules.prefetched.end())
+            return {};
+        prefetched = std::move(it->second);
+        boot_modules.prefetched.erase(it);
+    }
+    return prefetched.get();
+}
+
+// decrypted images of the firmware modules, shared by all the emulator instances of the process
+// unlike the modules of the apps, they only change when another firmware is installed
+static struct {
+    std::mutex mutex;
+    std::map<fs::path, std::pair<std::time_t, std::shared_ptr<const vfs::FileBuffer>>> images;
+} firmware_modules;
+
+static SceUID get_module_image(EmuEnvState &emuenv, const std::string &module_path, std::shared_ptr<const vfs::FileBuffer> &image) {
+    const VitaIoDevice device = device::get_device(module_path);
+    const bool is_firmware = (device == VitaIoDevice::vs0) || (device == VitaIoDevice::os0);
+    fs::path host_path;
+    std::time_t write_time = 0;
+    if (is_firmware) {
+        host_path = device::construct_emulated_path(device, translate_path(module_path.c_str(), device, emuenv.io.device_paths), emuenv.pref_path, emuenv.io.redirect_stdio);
+        boost::system::error_code error_code{};
+        write_time = fs::last_write_time(host_path, error_code);
+
+        const std::lock_guard<std::mutex> guard(firmware_modules.mutex);
+        const auto it = firmware_modules.images.find(host_path);
+        if (it != firmware_modules.images.end() && it->second.first == write_time) {
+            image = it->second.second;
+            return 0;
+        }
+    }
 
-    const std::vector<Patch> patches = get_patches(emuenv.patch_path, emuenv.io.title_id, module_path);
+    vfs::FileBuffer module_buffer = take_prefetched_module(module_path);
+    if (module_buffer.empty()) {
+        const SceUID error = read_module(emuenv, module_path, module_buffer);
+        if (error < 0)
+            return error;
+    }
+    image = std::make_shared<const vfs::FileBuffer>(std::move(module_buffer));
 
-    SceUID module_id = load_self(emuenv.kernel, emuenv.mem, module_buffer.data(), module_path, emuenv.log_path, patches);
+    if (is_firmware) {
+        const std::lock_guard<std::mutex> guard(firmware_modules.mutex);
+        firmware_modules.images[host_path] = { write_time, image };
+    }
+    return 0;
+}
+
+SceUID load_module(EmuEnvState &emuenv, const std::string &module_path) {
+    // Check if module is already loaded
+    {
+        const std::lock_guard<std::mutex> lock(emuenv.kernel.mutex);
+        const auto &loaded_modules = emuenv.kernel.loaded_modules;
+        auto module_iter = std::find_if(loaded_modules.begin(), loaded_modules.end(), [&](const auto &p) {
+            return module_path == p.second->info.path;
+        });
+
+        if (module_iter != loaded_modules.end()) {
+            return module_iter->first;
+        }
+    }
+
+    const boot_trace::Span span(fmt::format("load_module {}", module_path));
+    LOG_INFO("Loading module \"{}\"", module_path);
+    record_boot_module(module_path);
+    std::shared_ptr<const vfs::FileBuffer> module_image;
+    const SceUID error = get_module_image(emuenv, module_path, module_image);
+    if (error < 0)
+        return error;
+
+    // load_self only applies the patches to the eboot, there is no need to look for them for the other modules
+    std::vector<Patch> patches;
+    if (module_path.find("eboot.bin") != std::string::npos)
+        patches = get_patches(emuenv.patch_path, emuenv.io.title_id, module_path);
+
+    SceUID module_id = load_self(emuenv.kernel, emuenv.mem, module_image->data(), module_path, emuenv.log_path, patches);
 
     if (module_id >= 0) {
         const auto module = lock_and_find(module_id, emuenv.kernel.loaded_modules, emuenv.kernel.mutex);
@@ -268,6 +546,12 @@ int unload_module(EmuEnvState &emuenv, SceUID module_id) {
     }
     LOG_INFO("Unloading module {} ({})", module_id, module->info.module_name);
 
+    {
+        // a deferred module is loaded again at the next call to one of its functions
+        const std::lock_guard<std::mutex> guard(emuenv.kernel.lazy_modules_mutex);
+        emuenv.kernel.lazy_module_loads.erase(module->info.path);
+    }
+
     return unload_self(emuenv.kernel, emuenv.mem, *module);
 }
 
@@ -276,6 +560,7 @@ uint32_t start_module(EmuEnvState &emuenv, const SceKernelModuleInfo &module, Sc
     if (module_start) {
         const auto module_name = module.module_name;
 
+        const boot_trace::Span span(fmt::format("module_start {}", module_name));
         LOG_DEBUG("Running module_start of library: {} at address {}", module_name, log_hex(module_start.address()));
         SceInt32 priority = SCE_KERNEL_DEFAULT_PRIORITY_USER;
         SceInt32 stack_size = SCE_KERNEL_STACK_SIZE_USER_MAIN;
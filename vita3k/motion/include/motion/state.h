@@ -17,13 +17,18 @@
 
 #pragma once
 
+#include <motion/motion.h>
 #include <motion/motion_input.h>
 
 #include <mutex>
 
 struct MotionState {
+    // guards everything below, the sensor events, the fusion and the guest read it from different threads
     std::mutex mutex;
     MotionInput motion_data;
+    // what sceMotionGetState returns, computed once per update of the fusion instead of once per call
+    SceMotionState cached_state{};
+    bool is_cached_state_valid = false;
     uint32_t last_counter = 0;
     uint64_t last_gyro_timestamp = 0;
     uint64_t last_accel_timestamp = 0;
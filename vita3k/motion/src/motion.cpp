@@ -26,6 +26,7 @@
 #include <SDL3/SDL_gamepad.h>
 #include <SDL3/SDL_sensor.h>
 
+#include <cstring>
 #include <numbers>
 
 enum DeviceRotation : int32_t {
@@ -229,6 +230,35 @@ SceFVector3 get_basic_orientation(const MotionState &state) {
     return state.motion_data.GetBasicOrientation();
 }
 
+const SceMotionState &get_motion_state(MotionState &state) {
+    if (state.is_cached_state_valid)
+        return state.cached_state;
+
+    SceMotionState &motion_state = state.cached_state;
+    motion_state.timestamp = state.last_accel_timestamp;
+
+    motion_state.acceleration = get_acceleration(state);
+    motion_state.angularVelocity = get_gyroscope(state);
+
+    Util::Quaternion dev_quat = get_orientation(state);
+    motion_state.basicOrientation = get_basic_orientation(state);
+
+    static_assert(sizeof(motion_state.deviceQuat) == sizeof(dev_quat));
+    memcpy(&motion_state.deviceQuat, &dev_quat, sizeof(motion_state.deviceQuat));
+
+    *reinterpret_cast<decltype(dev_quat.ToMatrix()) *>(&motion_state.rotationMatrix) = dev_quat.ToMatrix();
+    // not right, but we can't do better without a magnetometer
+    memcpy(&motion_state.nedMatrix, &motion_state.rotationMatrix, sizeof(motion_state.nedMatrix));
+
+    motion_state.hostTimestamp = motion_state.timestamp;
+    // set it as unstable because we don't have one
+    motion_state.magnFieldStability = SCE_MOTION_MAGNETIC_FIELD_UNSTABLE;
+    motion_state.dataInfo = 0;
+
+    state.is_cached_state_valid = true;
+    return motion_state;
+}
+
 constexpr uint64_t to_microseconds(uint64_t ns) {
     return ns / 1000;
 }
@@ -274,6 +304,7 @@ static void handle_motion_event(EmuEnvState &emuenv, int32_t sensor_type, const
 
     auto sensor_data = get_processed_sensor_data();
 
+    const std::lock_guard<std::mutex> guard(emuenv.motion.mutex);
     if (sensor_type == SDL_SENSOR_ACCEL) {
         sensor_data /= -SDL_STANDARD_GRAVITY;
         emuenv.motion.motion_data.SetAcceleration(sensor_data);
@@ -283,6 +314,7 @@ static void handle_motion_event(EmuEnvState &emuenv, int32_t sensor_type, const
         emuenv.motion.motion_data.SetGyroscope(sensor_data);
         last_updated_gyro_timestamp = sensor_timestamp;
     }
+    emuenv.motion.is_cached_state_valid = false;
 }
 
 void handle_motion_event(EmuEnvState &emuenv, int32_t sensor_type, const SDL_SensorEvent &sensor) {
@@ -300,6 +332,7 @@ void refresh_motion(MotionState &state, CtrlState &ctrl_state) {
     if (!ctrl_state.has_motion_support && !state.has_device_motion_support)
         return;
 
+    const std::lock_guard<std::mutex> guard(state.mutex);
     state.motion_data.UpdateOrientation(last_updated_accel_timestamp - state.last_accel_timestamp);
     state.motion_data.UpdateBasicOrientation();
     state.motion_data.UpdateRotation(last_updated_gyro_timestamp - state.last_gyro_timestamp);
@@ -308,4 +341,5 @@ void refresh_motion(MotionState &state, CtrlState &ctrl_state) {
     state.last_gyro_timestamp = last_updated_gyro_timestamp;
 
     state.last_counter++;
+    state.is_cached_state_valid = false;
 }
@@ -2,19 +2,37 @@
 
 #include <net/socket.h>
 
+#include <map>
+#include <mutex>
+
 struct EpollSocket {
     unsigned int events;
     SceNetEpollData data;
     std::weak_ptr<Socket> sock;
 };
 
+// Level-triggered, the native epoll of the host is used on Linux and poll everywhere else
 struct Epoll {
+    std::mutex mutex;
     std::map<int, EpollSocket> eventEntries;
+#ifdef __linux__
+    // the sockets are registered with their id, -1 if it could not be created
+    int epoll_fd = -1;
+#endif
+
+    Epoll();
+    ~Epoll();
+    Epoll(const Epoll &) = delete;
+    Epoll &operator=(const Epoll &) = delete;
 
     int add(int id, std::weak_ptr<Socket> sock, SceNetEpollEvent *ev);
     int del(int id);
     int mod(int id, SceNetEpollEvent *ev);
+    // timeout is in microseconds, negative to wait without limit
     int wait(SceNetEpollEvent *events, int maxevents, int timeout);
+
+private:
+    int wait_poll(SceNetEpollEvent *events, int maxevents, int timeout_ms);
 };
 
 typedef std::shared_ptr<Epoll> EpollPtr;
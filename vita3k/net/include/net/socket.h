@@ -19,6 +19,11 @@
 
 #include <net/types.h>
 
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #define _WINSOCK_DEPRECATED_NO_WARNINGS
@@ -70,6 +75,8 @@ struct Socket {
 };
 
 // udp, tcp
+// The host socket is always non-blocking, the blocking calls of the guest wait for it to be ready
+// so that they can be aborted and time out like on the Vita.
 struct PosixSocket : public Socket {
     abs_socket sock;
 
@@ -78,23 +85,31 @@ struct PosixSocket : public Socket {
     int sockopt_so_usesignature = 0;
     int sockopt_so_tppolicy = 0;
     int sockopt_so_nbio = 0;
+    // in microseconds, 0 waits without limit
+    int sockopt_so_sndtimeo = 0;
+    int sockopt_so_rcvtimeo = 0;
     int sockopt_ip_ttlchk = 0;
     int sockopt_ip_maxttl = 0;
     int sockopt_tcp_mss_to_advertise = 0;
 
-    int abort_flags = 0;
-    bool is_aborted = false;
+    std::atomic<int> abort_flags = 0;
+    std::atomic<bool> is_aborted = false;
 
     explicit PosixSocket(int domain, int type, int protocol)
         : Socket(domain, type, protocol)
-        , sock(socket(domain, type, protocol)) {}
+        , sock(socket(domain, type, protocol)) { set_host_nonblocking(); }
 
     explicit PosixSocket(abs_socket sock, int type)
         : Socket(0, type, 0)
-        , sock(sock) {}
+        , sock(sock) { set_host_nonblocking(); }
 
     static int translate_return_value(int retval);
 
+    void set_host_nonblocking();
+    // waits until the host socket can be read or written, returns 0 or an error
+    int wait_ready(bool is_read, int timeout_us);
+    bool is_stream() const;
+
     int abort(int flags) override;
     int close() override;
     int shutdown_socket(int how) override;
@@ -110,11 +125,29 @@ struct PosixSocket : public Socket {
     int get_socket_address(SceNetSockaddr *addr, unsigned int *addrlen) override;
 };
 
+// Traffic exchanged with one adhoc peer, to diagnose the netplay sessions
+struct P2PPeerStats {
+    uint64_t packets_sent = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t packets_received = 0;
+    uint64_t bytes_received = 0;
+    std::chrono::steady_clock::time_point last_received;
+    // smoothed interval between the received packets and its mean deviation, in microseconds
+    double interval_us = 0;
+    double jitter_us = 0;
+};
+
 struct P2PSocket : public PosixSocket {
+    std::mutex peer_stats_mutex;
+    // indexed by the address and the virtual port of the peer
+    std::map<uint64_t, P2PPeerStats> peer_stats;
+
     explicit P2PSocket(int domain, int type, int protocol);
     explicit P2PSocket(abs_socket sock, int type)
         : PosixSocket(sock, type) {}
 
+    int close() override;
+
     int bind(const SceNetSockaddr *addr, unsigned int addrlen) override;
     int send_packet(const void *msg, unsigned int len, int flags, const SceNetSockaddr *to, unsigned int tolen) override;
     int recv_packet(void *buf, unsigned int len, int flags, SceNetSockaddr *from, unsigned int *fromlen) override;
@@ -18,101 +18,215 @@
 #include <net/epoll.h>
 
 #include <optional>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+static std::optional<abs_socket> get_valid_posix_socket(const std::weak_ptr<Socket> &weak_sock) {
+    const auto sock = weak_sock.lock();
+    if (!sock)
+        return std::nullopt;
+
+    const auto posixSocket = std::dynamic_pointer_cast<PosixSocket>(sock);
+    if (!posixSocket)
+        return std::nullopt;
+
+    return posixSocket->sock;
+}
+
+#ifdef __linux__
+static uint32_t to_native_events(unsigned int events) {
+    uint32_t native_events = 0;
+    if (events & SCE_NET_EPOLLIN)
+        native_events |= EPOLLIN;
+    if (events & SCE_NET_EPOLLOUT)
+        native_events |= EPOLLOUT;
+    // errors and hang-ups are always reported by epoll
+    return native_events;
+}
+#endif
+
+// only the events asked for are returned, a hang-up makes the socket readable
+static unsigned int from_native_events(unsigned int asked, bool readable, bool writable, bool error) {
+    unsigned int events = 0;
+    if (readable)
+        events |= SCE_NET_EPOLLIN;
+    if (writable)
+        events |= SCE_NET_EPOLLOUT;
+    if (error)
+        events |= SCE_NET_EPOLLERR;
+    return events & asked;
+}
+
+Epoll::Epoll() {
+#ifdef __linux__
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+}
+
+Epoll::~Epoll() {
+#ifdef __linux__
+    if (epoll_fd >= 0)
+        ::close(epoll_fd);
+#endif
+}
 
 int Epoll::add(int id, std::weak_ptr<Socket> sock, SceNetEpollEvent *ev) {
-    if (!eventEntries.try_emplace(id, EpollSocket{ ev->events, ev->data, sock }).second) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    const auto [it, inserted] = eventEntries.try_emplace(id, EpollSocket{ ev->events, ev->data, sock });
+    if (!inserted) {
         return SCE_NET_ERROR_EEXIST;
     }
 
+#ifdef __linux__
+    const auto posix_sock = get_valid_posix_socket(sock);
+    if (epoll_fd >= 0 && posix_sock) {
+        epoll_event native_event{};
+        native_event.events = to_native_events(ev->events);
+        native_event.data.u32 = static_cast<uint32_t>(id);
+        const int ret = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, *posix_sock, &native_event);
+        if (ret < 0) {
+            eventEntries.erase(it);
+            return PosixSocket::translate_return_value(ret);
+        }
+    }
+#endif
+
     return 0;
 }
 
 int Epoll::del(int id) {
-    if (eventEntries.erase(id) == 0) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    auto it = eventEntries.find(id);
+    if (it == eventEntries.end()) {
         return SCE_NET_ERROR_ENOENT;
     }
 
+#ifdef __linux__
+    // a closed socket is already removed by the host
+    const auto posix_sock = get_valid_posix_socket(it->second.sock);
+    if (epoll_fd >= 0 && posix_sock)
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, *posix_sock, nullptr);
+#endif
+
+    eventEntries.erase(it);
     return 0;
 }
 
 int Epoll::mod(int id, SceNetEpollEvent *ev) {
+    const std::lock_guard<std::mutex> guard(mutex);
     auto it = eventEntries.find(id);
     if (it == eventEntries.end()) {
         return SCE_NET_ERROR_ENOENT;
     }
 
+#ifdef __linux__
+    const auto posix_sock = get_valid_posix_socket(it->second.sock);
+    if (epoll_fd >= 0 && posix_sock) {
+        epoll_event native_event{};
+        native_event.events = to_native_events(ev->events);
+        native_event.data.u32 = static_cast<uint32_t>(id);
+        const int ret = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, *posix_sock, &native_event);
+        if (ret < 0)
+            return PosixSocket::translate_return_value(ret);
+    }
+#endif
+
     it->second.events = ev->events;
     it->second.data = ev->data;
     return 0;
 }
 
-static void add_event_fd_set(fd_set *set, int *maxFd, abs_socket sock) {
-    FD_SET(sock, set);
-    if (sock > *maxFd)
-        *maxFd = sock;
-}
+int Epoll::wait(SceNetEpollEvent *events, int maxevents, int timeout) {
+    if (maxevents <= 0)
+        return 0;
 
-int Epoll::wait(SceNetEpollEvent *events, int maxevents, int timeout_microseconds) {
-    fd_set readFds, writeFds, exceptFds;
-    FD_ZERO(&readFds);
-    FD_ZERO(&writeFds);
-    FD_ZERO(&exceptFds);
-    int maxFd = 0;
+    const int timeout_ms = timeout < 0 ? -1 : (timeout + 999) / 1000;
+#ifdef __linux__
+    if (epoll_fd < 0)
+        return wait_poll(events, maxevents, timeout_ms);
 
-    const auto get_valid_posix_socket = [](const std::weak_ptr<Socket> &weak_sock, int id) -> std::optional<abs_socket> {
-        const auto sock = weak_sock.lock();
-        if (!sock)
-            return std::nullopt;
+    std::vector<epoll_event> native_events(maxevents);
+    const int ret = epoll_wait(epoll_fd, native_events.data(), maxevents, timeout_ms);
+    if (ret < 0)
+        return errno == EINTR ? 0 : PosixSocket::translate_return_value(ret);
 
-        const auto posixSocket = std::dynamic_pointer_cast<PosixSocket>(sock);
-        if (!posixSocket)
-            return std::nullopt;
+    // the sockets may have been removed while waiting
+    const std::lock_guard<std::mutex> guard(mutex);
+    int eventCount = 0;
+    for (int i = 0; i < ret; i++) {
+        const auto it = eventEntries.find(static_cast<int>(native_events[i].data.u32));
+        if (it == eventEntries.end() || it->second.sock.expired())
+            continue;
 
-        return posixSocket->sock;
-    };
+        const uint32_t native = native_events[i].events;
+        const unsigned int eventTypes = from_native_events(it->second.events, native & (EPOLLIN | EPOLLHUP | EPOLLRDHUP), native & EPOLLOUT, native & EPOLLERR);
+        if (eventTypes != 0) {
+            events[eventCount].events = eventTypes;
+            events[eventCount].data = it->second.data;
+            eventCount++;
+        }
+    }
 
-    for (const auto &[id, entry] : eventEntries) {
-        const auto sock = get_valid_posix_socket(entry.sock, id);
-        if (!sock)
-            continue;
+    return eventCount;
+#else
+    return wait_poll(events, maxevents, timeout_ms);
+#endif
+}
 
-        if (entry.events & SCE_NET_EPOLLIN)
-            add_event_fd_set(&readFds, &maxFd, *sock);
-        if (entry.events & SCE_NET_EPOLLOUT)
-            add_event_fd_set(&writeFds, &maxFd, *sock);
-        if (entry.events & SCE_NET_EPOLLERR)
-            add_event_fd_set(&exceptFds, &maxFd, *sock);
+int Epoll::wait_poll(SceNetEpollEvent *events, int maxevents, int timeout_ms) {
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> fds;
+#else
+    std::vector<pollfd> fds;
+#endif
+    std::vector<int> ids;
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        for (const auto &[id, entry] : eventEntries) {
+            const auto sock = get_valid_posix_socket(entry.sock);
+            if (!sock)
+                continue;
+
+            short poll_events = 0;
+            if (entry.events & SCE_NET_EPOLLIN)
+                poll_events |= POLLIN;
+            if (entry.events & SCE_NET_EPOLLOUT)
+                poll_events |= POLLOUT;
+            fds.push_back({ *sock, poll_events, 0 });
+            ids.push_back(id);
+        }
     }
 
-    if (maxFd == 0)
+    if (fds.empty())
         return 0;
 
-    timeval timeout;
-    timeout.tv_sec = timeout_microseconds / 1000000;
-    timeout.tv_usec = timeout_microseconds % 1000000;
-    auto ret = select(maxFd + 1, &readFds, &writeFds, &exceptFds, &timeout);
+#ifdef _WIN32
+    const int ret = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+#else
+    const int ret = poll(fds.data(), fds.size(), timeout_ms);
+#endif
     if (ret < 0)
         return PosixSocket::translate_return_value(ret);
 
+    const std::lock_guard<std::mutex> guard(mutex);
     int eventCount = 0;
-    for (const auto &[id, entry] : eventEntries) {
-        unsigned int eventTypes = 0;
-        const auto sock = get_valid_posix_socket(entry.sock, id);
-        if (!sock)
+    for (size_t i = 0; i < fds.size() && eventCount < maxevents; i++) {
+        const auto it = eventEntries.find(ids[i]);
+        if (it == eventEntries.end())
             continue;
 
-        if (FD_ISSET(*sock, &readFds))
-            eventTypes |= SCE_NET_EPOLLIN;
-        if (FD_ISSET(*sock, &writeFds))
-            eventTypes |= SCE_NET_EPOLLOUT;
-        if (FD_ISSET(*sock, &exceptFds))
-            eventTypes |= SCE_NET_EPOLLERR;
-
-        if (eventTypes != 0 && eventCount < maxevents) {
-            auto i = eventCount++;
-
-            events[i].events = eventTypes;
-            events[i].data = entry.data;
+        const short revents = fds[i].revents;
+        const unsigned int eventTypes = from_native_events(it->second.events, revents & (POLLIN | POLLHUP), revents & POLLOUT, revents & (POLLERR | POLLNVAL));
+        if (eventTypes != 0) {
+            events[eventCount].events = eventTypes;
+            events[eventCount].data = it->second.data;
+            eventCount++;
         }
     }
 
@@ -17,6 +17,9 @@
 
 #include <net/socket.h>
 #include <util/bit_cast.h>
+#include <util/log.h>
+
+#include <cmath>
 
 static SceNetSockaddr convertP2PToPosix(const SceNetSockaddr *addr) {
     if (!addr) {
@@ -66,6 +69,26 @@ static int p2pSocketTypeToPosixSocketType(int type) {
     return hostSockType;
 }
 
+static uint64_t get_peer_key(const SceNetSockaddr *addr) {
+    const auto addr_in = reinterpret_cast<const SceNetSockaddrIn *>(addr);
+    return (static_cast<uint64_t>(addr_in->sin_addr.s_addr) << 16) | ntohs(addr_in->sin_vport);
+}
+
+static void update_received_stats(P2PPeerStats &stats, int bytes) {
+    const auto now = std::chrono::steady_clock::now();
+    if (stats.packets_received > 0) {
+        // same smoothing as the interarrival jitter of RFC 3550
+        const auto interval_us = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(now - stats.last_received).count());
+        if (stats.packets_received == 1)
+            stats.interval_us = interval_us;
+        stats.jitter_us += (std::abs(interval_us - stats.interval_us) - stats.jitter_us) / 16;
+        stats.interval_us += (interval_us - stats.interval_us) / 16;
+    }
+    stats.last_received = now;
+    stats.packets_received++;
+    stats.bytes_received += bytes;
+}
+
 P2PSocket::P2PSocket(int domain, int type, int protocol)
     : PosixSocket(domain, p2pSocketTypeToPosixSocketType(type), protocol) { sce_type = type; }
 
@@ -85,15 +108,45 @@ int P2PSocket::connect(const SceNetSockaddr *addr, unsigned int addrlen) {
 
 int P2PSocket::recv_packet(void *buf, unsigned int len, int flags, SceNetSockaddr *from, unsigned int *fromlen) {
     const auto res = PosixSocket::recv_packet(buf, len, flags, from, fromlen);
-    if ((res > 0) && from)
+    if ((res > 0) && from) {
         *from = convertPosixToP2P(from);
+        if (!(flags & SCE_NET_MSG_PEEK)) {
+            const std::lock_guard<std::mutex> guard(peer_stats_mutex);
+            update_received_stats(peer_stats[get_peer_key(from)], res);
+        }
+    }
 
     return res;
 }
 
 int P2PSocket::send_packet(const void *msg, unsigned int len, int flags, const SceNetSockaddr *to, unsigned int tolen) {
     const auto p2p_to = convertP2PToPosix(to);
-    return PosixSocket::send_packet(msg, len, flags, &p2p_to, tolen);
+    const auto res = PosixSocket::send_packet(msg, len, flags, &p2p_to, tolen);
+    if ((res > 0) && to) {
+        const std::lock_guard<std::mutex> guard(peer_stats_mutex);
+        auto &stats = peer_stats[get_peer_key(to)];
+        stats.packets_sent++;
+        stats.bytes_sent += res;
+    }
+
+    return res;
+}
+
+int P2PSocket::close() {
+    {
+        const std::lock_guard<std::mutex> guard(peer_stats_mutex);
+        for (const auto &[key, stats] : peer_stats) {
+            const auto addr = static_cast<uint32_t>(key >> 16);
+            const auto vport = static_cast<uint16_t>(key);
+            // s_addr is in network order, its first byte is the first part of the address
+            LOG_INFO("Adhoc peer {}.{}.{}.{}:{}: sent {} packets ({} bytes), received {} packets ({} bytes), interval {:.0f} us, jitter {:.0f} us",
+                addr & 0xFF, (addr >> 8) & 0xFF, (addr >> 16) & 0xFF, addr >> 24, vport, stats.packets_sent, stats.bytes_sent,
+                stats.packets_received, stats.bytes_received, stats.interval_us, stats.jitter_us);
+        }
+        peer_stats.clear();
+    }
+
+    return PosixSocket::close();
 }
 
 int P2PSocket::bind(const SceNetSockaddr *addr, unsigned int addrlen) {
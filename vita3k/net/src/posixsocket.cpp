@@ -18,6 +18,13 @@
 #include <cstring>
 #include <net/socket.h>
 
+#include <algorithm>
+#include <chrono>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
 // NOTE: This should be SCE_NET_##errname but it causes vitaQuake to softlock in online games
 #ifdef _WIN32
 #define ERROR_CASE(errname) \
@@ -143,26 +150,100 @@ static void convertPosixSockaddrToSce(sockaddr *src, SceNetSockaddr *dst) {
     memcpy(&dst_in->sin_addr, &src_in->sin_addr, sizeof(dst_in->sin_addr));
 }
 
-static bool abort_pending(bool &is_aborded) {
-    if (is_aborded) {
-        is_aborded = false; // Reset the flag for the next operation
-        return true;
-    }
-
-    return false;
+static bool abort_pending(std::atomic<bool> &is_aborded) {
+    // Reset the flag for the next operation
+    return is_aborded.exchange(false);
 }
 
 static bool should_abort(int abort_flags, int flags) {
     return (abort_flags & flags) != 0;
 }
 
+static bool would_block() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return (errno == EWOULDBLOCK) || (errno == EAGAIN);
+#endif
+}
+
+static void set_last_error(int error) {
+#ifdef _WIN32
+    WSASetLastError(error);
+#else
+    errno = error;
+#endif
+}
+
+void PosixSocket::set_host_nonblocking() {
+#ifdef _WIN32
+    u_long nonblocking = 1;
+    ioctlsocket(sock, FIONBIO, &nonblocking);
+#else
+    int nonblocking = 1;
+    ioctl(sock, FIONBIO, &nonblocking);
+#endif
+}
+
+// The wait is split in slices so that an abort from another thread is seen quickly
+static constexpr int ABORT_CHECK_INTERVAL_MS = 10;
+
+int PosixSocket::wait_ready(bool is_read, int timeout_us) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout_us);
+    while (true) {
+        if (abort_pending(is_aborted))
+            return SCE_NET_ERROR_EINTR;
+
+        int wait_ms = ABORT_CHECK_INTERVAL_MS;
+        if (timeout_us > 0) {
+            const auto remaining_us = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining_us <= 0)
+                return SCE_NET_ERROR_EWOULDBLOCK;
+            wait_ms = std::min(wait_ms, static_cast<int>((remaining_us + 999) / 1000));
+        }
+
+#ifdef _WIN32
+        WSAPOLLFD fd{ sock, static_cast<SHORT>(is_read ? POLLIN : POLLOUT), 0 };
+        const int res = WSAPoll(&fd, 1, wait_ms);
+#else
+        pollfd fd{ sock, static_cast<short>(is_read ? POLLIN : POLLOUT), 0 };
+        const int res = poll(&fd, 1, wait_ms);
+        if ((res < 0) && (errno == EINTR))
+            continue;
+#endif
+        // an error or a hang-up is reported by the operation itself
+        if (res != 0)
+            return res < 0 ? translate_return_value(res) : 0;
+    }
+}
+
+bool PosixSocket::is_stream() const {
+    return (sce_type == SCE_NET_SOCK_STREAM) || (sce_type == SCE_NET_SOCK_STREAM_P2P);
+}
+
 int PosixSocket::connect(const SceNetSockaddr *addr, unsigned int addrlen) {
     if (should_abort(abort_flags, SCE_NET_SOCKET_ABORT_FLAG_SND_PRESERVATION))
         return SCE_NET_ERROR_EINTR;
 
     sockaddr addr2{};
     convertSceSockaddrToPosix(addr, &addr2);
-    const auto res = ::connect(sock, &addr2, sizeof(sockaddr_in));
+    auto res = ::connect(sock, &addr2, sizeof(sockaddr_in));
+#ifdef _WIN32
+    const bool in_progress = (res < 0) && (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    const bool in_progress = (res < 0) && (errno == EINPROGRESS);
+#endif
+    if (in_progress && !sockopt_so_nbio) {
+        const int wait_res = wait_ready(false, 0);
+        if (wait_res < 0)
+            return wait_res;
+
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        getsockopt(sock, SOL_SOCKET, SO_ERROR, (char *)&error, &error_len);
+        set_last_error(error);
+        res = (error == 0) ? 0 : -1;
+    }
 
     if (abort_pending(is_aborted))
         return SCE_NET_ERROR_EINTR;
@@ -208,23 +289,10 @@ int PosixSocket::get_socket_address(SceNetSockaddr *addr, unsigned int *addrlen)
 }
 
 int PosixSocket::abort(int flags) {
+    // the blocking calls waiting on the socket return within ABORT_CHECK_INTERVAL_MS
     abort_flags |= flags;
     is_aborted = true;
-
-#ifdef _WIN32
-    auto res = CancelIoEx((HANDLE)sock, nullptr);
-    if (res == 0) {
-        DWORD err = WSAGetLastError();
-        if (err == ERROR_NOT_FOUND)
-            return SCE_NET_ERROR_ENOTBLK;
-        else
-            return SCE_NET_ERROR_EINTERNAL;
-    }
-
     return 0;
-#else
-    return translate_return_value(shutdown(sock, SHUT_RDWR));
-#endif
 }
 
 int PosixSocket::close() {
@@ -246,7 +314,19 @@ SocketPtr PosixSocket::accept(SceNetSockaddr *addr, unsigned int *addrlen, int &
         return nullptr;
     }
     sockaddr addr2{};
-    const abs_socket new_socket = ::accept(sock, &addr2, (socklen_t *)addrlen);
+    abs_socket new_socket = ::accept(sock, &addr2, (socklen_t *)addrlen);
+#ifdef _WIN32
+    while ((new_socket == INVALID_SOCKET) && would_block() && !sockopt_so_nbio) {
+#else
+    while ((new_socket < 0) && would_block() && !sockopt_so_nbio) {
+#endif
+        const int wait_res = wait_ready(true, sockopt_so_rcvtimeo);
+        if (wait_res < 0) {
+            err = wait_res;
+            return nullptr;
+        }
+        new_socket = ::accept(sock, &addr2, (socklen_t *)addrlen);
+    }
     if (abort_pending(is_aborted)) {
         err = SCE_NET_ERROR_EINTR;
         return nullptr;
@@ -311,41 +391,12 @@ int PosixSocket::set_socket_options(int level, int optname, const void *optval,
 
             // Sets the option to allow sending broadcast packets on a socket
             return translate_return_value(setsockopt(sock, level, SO_BROADCAST, (const char *)optval, optlen));
-        case SCE_NET_SO_SNDTIMEO:
-        case SCE_NET_SO_RCVTIMEO: {
-            if (optlen != sizeof(int))
-                return SCE_NET_ERROR_EFAULT;
-
-            std::vector<char> val;
-            const auto optname_nat = (optname == SCE_NET_SO_SNDTIMEO) ? SO_SNDTIMEO : SO_RCVTIMEO;
-            int timeout_us = *(const int *)optval;
-#ifdef _WIN32
-            DWORD timeout = timeout_us / 1000;
-            val.insert(val.end(), (char *)&timeout, (char *)&timeout + sizeof(timeout));
-            optlen = sizeof(timeout);
-#else
-            timeval timeout{
-                .tv_sec = timeout_us / 1000000,
-                .tv_usec = timeout_us % 1000000
-            };
-            val.insert(val.end(), (char *)&timeout, (char *)&timeout + sizeof(timeout));
-            optlen = sizeof(timeout);
-#endif
-            return translate_return_value(setsockopt(sock, level, optname_nat, val.data(), optlen));
-        }
+            // the timeouts are applied by wait_ready as the host socket never blocks
+            CASE_SETSOCKOPT_VALUE(SCE_NET_SO_SNDTIMEO, &sockopt_so_sndtimeo);
+            CASE_SETSOCKOPT_VALUE(SCE_NET_SO_RCVTIMEO, &sockopt_so_rcvtimeo);
         case SCE_NET_SO_NAME:
             return SCE_NET_ERROR_EINVAL; // don't support set for name
-        case SCE_NET_SO_NBIO: {
-            if (optlen != sizeof(sockopt_so_nbio))
-                return SCE_NET_ERROR_EFAULT;
-            memcpy(&sockopt_so_nbio, optval, optlen);
-#ifdef _WIN32
-            static_assert(sizeof(u_long) == sizeof(sockopt_so_nbio), "type used for ioctlsocket value does not have the expected size");
-            return translate_return_value(ioctlsocket(sock, FIONBIO, (u_long *)&sockopt_so_nbio));
-#else
-            return translate_return_value(ioctl(sock, FIONBIO, &sockopt_so_nbio));
-#endif
-        }
+            CASE_SETSOCKOPT_VALUE(SCE_NET_SO_NBIO, &sockopt_so_nbio);
         }
     } else if (level == IPPROTO_IP) {
         switch (optname) {
@@ -401,8 +452,8 @@ int PosixSocket::get_socket_options(int level, int optname, void *optval, unsign
             CASE_GETSOCKOPT(SO_RCVBUF);
             CASE_GETSOCKOPT(SO_SNDLOWAT);
             CASE_GETSOCKOPT(SO_RCVLOWAT);
-            CASE_GETSOCKOPT(SO_SNDTIMEO);
-            CASE_GETSOCKOPT(SO_RCVTIMEO);
+            CASE_GETSOCKOPT_VALUE(SCE_NET_SO_SNDTIMEO, sockopt_so_sndtimeo);
+            CASE_GETSOCKOPT_VALUE(SCE_NET_SO_RCVTIMEO, sockopt_so_rcvtimeo);
             CASE_GETSOCKOPT(SO_ERROR);
             CASE_GETSOCKOPT(SO_TYPE);
             CASE_GETSOCKOPT_VALUE(SCE_NET_SO_NBIO, sockopt_so_nbio);
@@ -436,64 +487,56 @@ int PosixSocket::get_socket_options(int level, int optname, void *optval, unsign
     return SCE_NET_ERROR_EINVAL;
 }
 
-static int convertSceFlagsToPosix(int sock_type, int sce_flags) {
+static int convertSceFlagsToPosix(int sce_flags) {
     int posix_flags = 0;
 
     if (sce_flags & SCE_NET_MSG_PEEK)
         posix_flags |= MSG_PEEK;
-#ifndef _WIN32
-    if (sce_flags & SCE_NET_MSG_DONTWAIT)
-        posix_flags |= MSG_DONTWAIT;
-#endif
-    // MSG_WAITALL is only valid for stream sockets
-    if ((sce_flags & SCE_NET_MSG_WAITALL) && ((sock_type == SCE_NET_SOCK_STREAM) || (sock_type == SCE_NET_SOCK_STREAM_P2P)))
-        posix_flags |= MSG_WAITALL;
+    // MSG_DONTWAIT and MSG_WAITALL are handled by recv_packet and send_packet, the host socket never blocks
 
     return posix_flags;
 }
 
-// On Windows, MSG_DONTWAIT is not handled natively by recv/send.
-// This function uses select() with zero timeout to simulate non-blocking behavior.
-static int socket_is_ready(int sock, bool is_read = true) {
-    fd_set fds;
-    FD_ZERO(&fds);
-    FD_SET(sock, &fds);
-    timeval timeout{ 0, 0 };
-    int res = select(sock + 1, is_read ? &fds : nullptr, is_read ? nullptr : &fds, nullptr, &timeout);
-    if (res == 0)
-        return SCE_NET_ERROR_EWOULDBLOCK;
-    else if (res < 0)
-        return PosixSocket::translate_return_value(res);
-
-    return res;
-}
-
 int PosixSocket::recv_packet(void *buf, unsigned int len, int flags, SceNetSockaddr *from, unsigned int *fromlen) {
     if (should_abort(abort_flags, SCE_NET_SOCKET_ABORT_FLAG_RCV_PRESERVATION))
         return SCE_NET_ERROR_EINTR;
 
+    const bool dont_wait = sockopt_so_nbio || (flags & SCE_NET_MSG_DONTWAIT);
+    // MSG_WAITALL is only valid for stream sockets
+    const bool wait_all = !dont_wait && (flags & SCE_NET_MSG_WAITALL) && is_stream();
+    const auto posix_flags = convertSceFlagsToPosix(flags);
+    unsigned int received = 0;
     int res = 0;
-#ifdef _WIN32
-    if (flags & SCE_NET_MSG_DONTWAIT) {
-        res = socket_is_ready(sock);
-        if (res <= 0)
-            return res;
-    }
-#endif
-    const auto posix_flags = convertSceFlagsToPosix(sce_type, flags);
-    if (from == nullptr) {
-        res = recv(sock, (char *)buf, len, posix_flags);
-    } else {
-        sockaddr addr{};
-        socklen_t addrlen = sizeof(addr);
-        res = recvfrom(sock, (char *)buf, len, posix_flags, &addr, (fromlen && *fromlen <= sizeof(addr) ? (socklen_t *)fromlen : &addrlen));
-        if (res > 0)
-            convertPosixSockaddrToSce(&addr, from);
+    while (true) {
+        if (from == nullptr) {
+            res = recv(sock, (char *)buf + received, len - received, posix_flags);
+        } else {
+            sockaddr addr{};
+            socklen_t addrlen = sizeof(addr);
+            res = recvfrom(sock, (char *)buf + received, len - received, posix_flags, &addr, (fromlen && *fromlen <= sizeof(addr) ? (socklen_t *)fromlen : &addrlen));
+            if (res > 0)
+                convertPosixSockaddrToSce(&addr, from);
+        }
+
+        if (res > 0 && wait_all) {
+            received += res;
+            if (received < len)
+                continue;
+        }
+        if (res >= 0 || dont_wait || !would_block())
+            break;
+
+        const int wait_res = wait_ready(true, sockopt_so_rcvtimeo);
+        if (wait_res < 0)
+            return received > 0 ? static_cast<int>(received) : wait_res;
     }
 
     if (abort_pending(is_aborted))
         return SCE_NET_ERROR_EINTR;
 
+    if (wait_all && (res >= 0 || received > 0))
+        return static_cast<int>(received);
+
     return translate_return_value(res);
 }
 
@@ -501,25 +544,39 @@ int PosixSocket::send_packet(const void *msg, unsigned int len, int flags, const
     if (should_abort(abort_flags, SCE_NET_SOCKET_ABORT_FLAG_SND_PRESERVATION))
         return SCE_NET_ERROR_EINTR;
 
+    const bool dont_wait = sockopt_so_nbio || (flags & SCE_NET_MSG_DONTWAIT);
+    // a blocking send on a stream socket only returns once everything has been sent
+    const bool send_all = !dont_wait && is_stream();
+    const auto posix_flags = convertSceFlagsToPosix(flags);
+    unsigned int sent = 0;
     int res = 0;
-#ifdef _WIN32
-    if (flags & SCE_NET_MSG_DONTWAIT) {
-        res = socket_is_ready(sock, false);
-        if (res <= 0)
-            return res;
-    }
-#endif
-    const auto posix_flags = convertSceFlagsToPosix(sce_type, flags);
-    if (to == nullptr) {
-        res = send(sock, (const char *)msg, len, posix_flags);
-    } else {
-        sockaddr addr{};
-        convertSceSockaddrToPosix(to, &addr);
-        res = sendto(sock, (const char *)msg, len, posix_flags, &addr, tolen);
+    while (true) {
+        if (to == nullptr) {
+            res = send(sock, (const char *)msg + sent, len - sent, posix_flags);
+        } else {
+            sockaddr addr{};
+            convertSceSockaddrToPosix(to, &addr);
+            res = sendto(sock, (const char *)msg + sent, len - sent, posix_flags, &addr, tolen);
+        }
+
+        if (res > 0 && send_all) {
+            sent += res;
+            if (sent < len)
+                continue;
+        }
+        if (res >= 0 || dont_wait || !would_block())
+            break;
+
+        const int wait_res = wait_ready(false, sockopt_so_sndtimeo);
+        if (wait_res < 0)
+            return sent > 0 ? static_cast<int>(sent) : wait_res;
     }
 
     if (abort_pending(is_aborted))
         return SCE_NET_ERROR_EINTR;
 
+    if (send_all && (res >= 0 || sent > 0))
+        return static_cast<int>(sent);
+
     return translate_return_value(res);
 }
@@ -0,0 +1,30 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+
+namespace ngs {
+// the buffers exchanged by the voices are interleaved stereo FLTP
+
+// add the source to the destination through the volume matrix of a patch, the result is clamped to [-1, 1]
+void mix_stereo(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count);
+void convert_stereo_to_s16(const float *source, int16_t *dest, uint32_t frame_count);
+// the s16 mono or stereo frames of a decoder to the voice format, with the gains of swresample
+void convert_s16_to_stereo(const int16_t *source, float *dest, uint32_t frame_count, uint32_t channel_count);
+} // namespace ngs
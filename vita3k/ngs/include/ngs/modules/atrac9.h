@@ -81,9 +81,9 @@ private:
     uint32_t last_config = 0;
     std::vector<uint8_t> temp_buffer;
     SceNgsAT9States *last_state = nullptr;
-
-    static SwrContext *swr_mono_to_stereo;
-    static SwrContext *swr_stereo;
+    // reused for each superframe, the voices of the rack are never decoded at the same time
+    std::vector<uint8_t> decoded_superframe_samples;
+    std::vector<uint8_t> frame_samples;
 
     // return false if data could not be decoded (error or no more data available)
     bool decode_more_data(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, const SceNgsAT9Params *params, SceNgsAT9States *state, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock);
@@ -91,6 +91,7 @@ private:
 public:
     bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override;
     uint32_t module_id() const override { return 0x5CAA; }
+    bool can_process_in_parallel() const override { return false; }
     void on_state_change(const MemState &mem, ModuleData &v, const VoiceState previous) override;
     void on_param_change(const MemState &mem, ModuleData &data) override;
 
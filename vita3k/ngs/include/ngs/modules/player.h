@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <codec/resampler.h>
 #include <codec/state.h>
 #include <ngs/system.h>
 #include <ngs/types.h>
@@ -58,9 +59,9 @@ struct SceNgsPlayerStates {
     // needed for he_adpcm because a same decoder can be used for many voices
     ADPCMHistory adpcm_history[SCE_NGS_PLAYER_MAX_PCM_CHANNELS] = {};
     // used if the input must be resampled
-    SwrContext *swr = nullptr;
-    // if we need at some point to reset the resampler params
-    bool reset_swr = false;
+    Resampler *resampler = nullptr;
+    // the history of the resampler must be dropped before its next use
+    bool reset_resampler = false;
 };
 
 struct SceNgsPlayerParams {
@@ -89,11 +90,14 @@ namespace ngs {
 class PlayerModule : public Module {
 private:
     std::unique_ptr<PCMDecoderState> decoder;
+    // reused for each decoded buffer which needs to be resampled
+    std::vector<uint8_t> decoded_data;
 
 public:
     void set_default_preset(const MemState &mem, ModuleData &data) override;
     bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override;
     uint32_t module_id() const override { return 0x5CE6; }
+    bool can_process_in_parallel() const override { return false; }
     void on_state_change(const MemState &mem, ModuleData &v, const VoiceState previous) override;
     void on_param_change(const MemState &mem, ModuleData &data) override;
 
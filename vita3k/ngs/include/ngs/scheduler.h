@@ -56,6 +56,9 @@ struct OperationPending {
     };
 };
 
+// levels of the voice graph with fewer voices than this are processed on a single thread
+static constexpr size_t PARALLEL_MIN_VOICES = 8;
+
 struct VoiceScheduler {
     std::vector<Voice *> queue;
     std::queue<OperationPending> operations_pending;
@@ -71,6 +74,9 @@ protected:
 
     std::int32_t get_position(Voice *v);
 
+    void finish_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, Voice *voice, uint32_t finished_module,
+        std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock);
+
 public:
     bool deque_voice(Voice *voice);
 
@@ -116,6 +116,9 @@ public:
     virtual void set_default_preset(const MemState &mem, ModuleData &data) {}
     virtual bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) = 0;
     virtual uint32_t module_id() const { return 0; }
+    // false if the module can invoke a callback or shares its state between the voices of the rack,
+    // the voices using it are then always processed by the thread updating the system
+    virtual bool can_process_in_parallel() const { return true; }
     virtual uint32_t get_buffer_parameter_size() const = 0;
     virtual void on_state_change(const MemState &mem, ModuleData &v, const VoiceState previous) {}
     virtual void on_param_change(const MemState &mem, ModuleData &data) {}
@@ -138,6 +141,8 @@ struct VoiceInputManager {
     using PCMInputs = std::vector<PCMInput>;
 
     PCMInputs inputs;
+    // inputs which received some data since they were last reset, the others are still cleared
+    std::vector<bool> received;
 
     void init(const uint32_t granularity, const uint16_t total_input);
     void reset_inputs();
@@ -156,6 +161,10 @@ struct Voice {
     bool is_keyed_off;
     uint32_t frame_count;
 
+    // set by the scheduler during an update, a voice only receives data from voices of lower levels
+    uint32_t graph_level;
+    bool is_graph_visited;
+
     using Patches = std::vector<Ptr<Patch>>;
 
     std::array<Patches, MAX_OUTPUT_PORT> patches;
@@ -171,6 +180,7 @@ struct Voice {
     void init(Rack *mama);
 
     ModuleData *module_storage(const uint32_t index);
+    bool can_process_in_parallel() const;
 
     bool remove_patch(const MemState &mem, const Ptr<Patch> patch);
     Ptr<Patch> patch(const MemState &mem, const int32_t index, int32_t subindex, int32_t dest_index, Voice *dest);
@@ -0,0 +1,184 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp.h>
+
+#include <algorithm>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NGS_AVX
+#include <util/instrset_detect.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX __attribute__((__target__("avx")))
+#include <immintrin.h>
+#else
+#define TARGET_AVX
+#include <intrin.h>
+#endif
+#endif
+
+namespace ngs {
+
+static void mix_stereo_basic(float *dest, const float *source, const float volume_matrix[2][2], uint32_t first_frame, uint32_t frame_count) {
+    for (uint32_t k = first_frame; k < frame_count; k++) {
+        dest[k * 2] = std::clamp(dest[k * 2] + source[k * 2] * volume_matrix[0][0] + source[k * 2 + 1] * volume_matrix[1][0], -1.0f, 1.0f);
+        dest[k * 2 + 1] = std::clamp(dest[k * 2 + 1] + source[k * 2] * volume_matrix[0][1] + source[k * 2 + 1] * volume_matrix[1][1], -1.0f, 1.0f);
+    }
+}
+
+static void convert_stereo_to_s16_basic(const float *source, int16_t *dest, uint32_t first_frame, uint32_t frame_count) {
+    for (uint32_t i = first_frame * 2; i < frame_count * 2; i++)
+        dest[i] = static_cast<int16_t>(std::clamp(source[i] * 32768.0f, -32768.0f, 32767.0f));
+}
+
+void convert_s16_to_stereo(const int16_t *source, float *dest, uint32_t frame_count, uint32_t channel_count) {
+    constexpr float scale = 1.0f / 32768.0f;
+    if (channel_count == 1) {
+        // the center channel goes to both sides at -3 dB, like the upmix of swresample
+        constexpr float mono_scale = scale * 0.70710678f;
+        for (uint32_t k = 0; k < frame_count; k++) {
+            const float sample = source[k] * mono_scale;
+            dest[k * 2] = sample;
+            dest[k * 2 + 1] = sample;
+        }
+    } else {
+        for (uint32_t i = 0; i < frame_count * 2; i++)
+            dest[i] = source[i] * scale;
+    }
+}
+
+// Each vector holds whole frames: the left samples of the source, duplicated to both channels, are multiplied by
+// the first row of the matrix, then the right ones by the second row. The operations are done in the same order
+// as the scalar version (no FMA) so that all the versions give the same result.
+
+#if defined(__aarch64__)
+void mix_stereo(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count) {
+    const float32x4_t left_volumes = { volume_matrix[0][0], volume_matrix[0][1], volume_matrix[0][0], volume_matrix[0][1] };
+    const float32x4_t right_volumes = { volume_matrix[1][0], volume_matrix[1][1], volume_matrix[1][0], volume_matrix[1][1] };
+    const float32x4_t min_value = vdupq_n_f32(-1.0f);
+    const float32x4_t max_value = vdupq_n_f32(1.0f);
+
+    uint32_t k = 0;
+    for (; k + 2 <= frame_count; k += 2) {
+        const float32x4_t samples = vld1q_f32(source + k * 2);
+        float32x4_t result = vaddq_f32(vld1q_f32(dest + k * 2), vmulq_f32(vtrn1q_f32(samples, samples), left_volumes));
+        result = vaddq_f32(result, vmulq_f32(vtrn2q_f32(samples, samples), right_volumes));
+        vst1q_f32(dest + k * 2, vminq_f32(vmaxq_f32(result, min_value), max_value));
+    }
+    mix_stereo_basic(dest, source, volume_matrix, k, frame_count);
+}
+
+void convert_stereo_to_s16(const float *source, int16_t *dest, uint32_t frame_count) {
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+    const float32x4_t min_value = vdupq_n_f32(-32768.0f);
+    const float32x4_t max_value = vdupq_n_f32(32767.0f);
+
+    uint32_t k = 0;
+    for (; k + 4 <= frame_count; k += 4) {
+        const float32x4_t low = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(source + k * 2), scale), min_value), max_value);
+        const float32x4_t high = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(source + k * 2 + 4), scale), min_value), max_value);
+        // the conversion truncates like the cast
+        vst1q_s16(dest + k * 2, vcombine_s16(vmovn_s32(vcvtq_s32_f32(low)), vmovn_s32(vcvtq_s32_f32(high))));
+    }
+    convert_stereo_to_s16_basic(source, dest, k, frame_count);
+}
+#elif defined(NGS_AVX)
+static void TARGET_AVX mix_stereo_avx(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count) {
+    const __m256 left_volumes = _mm256_setr_ps(volume_matrix[0][0], volume_matrix[0][1], volume_matrix[0][0], volume_matrix[0][1],
+        volume_matrix[0][0], volume_matrix[0][1], volume_matrix[0][0], volume_matrix[0][1]);
+    const __m256 right_volumes = _mm256_setr_ps(volume_matrix[1][0], volume_matrix[1][1], volume_matrix[1][0], volume_matrix[1][1],
+        volume_matrix[1][0], volume_matrix[1][1], volume_matrix[1][0], volume_matrix[1][1]);
+    const __m256 min_value = _mm256_set1_ps(-1.0f);
+    const __m256 max_value = _mm256_set1_ps(1.0f);
+
+    uint32_t k = 0;
+    for (; k + 4 <= frame_count; k += 4) {
+        const __m256 samples = _mm256_loadu_ps(source + k * 2);
+        __m256 result = _mm256_add_ps(_mm256_loadu_ps(dest + k * 2), _mm256_mul_ps(_mm256_moveldup_ps(samples), left_volumes));
+        result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_movehdup_ps(samples), right_volumes));
+        _mm256_storeu_ps(dest + k * 2, _mm256_min_ps(_mm256_max_ps(result, min_value), max_value));
+    }
+    mix_stereo_basic(dest, source, volume_matrix, k, frame_count);
+}
+
+static void TARGET_AVX convert_stereo_to_s16_avx(const float *source, int16_t *dest, uint32_t frame_count) {
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    const __m256 min_value = _mm256_set1_ps(-32768.0f);
+    const __m256 max_value = _mm256_set1_ps(32767.0f);
+
+    uint32_t k = 0;
+    for (; k + 4 <= frame_count; k += 4) {
+        const __m256 samples = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(source + k * 2), scale), min_value), max_value);
+        // the conversion truncates like the cast, the packing is done on the two halves as AVX has no 256-bit integer operations
+        const __m256i values = _mm256_cvttps_epi32(samples);
+        const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(values), _mm256_extractf128_si256(values, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + k * 2), packed);
+    }
+    convert_stereo_to_s16_basic(source, dest, k, frame_count);
+}
+
+static void mix_stereo_fallback(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count) {
+    mix_stereo_basic(dest, source, volume_matrix, 0, frame_count);
+}
+
+static void convert_stereo_to_s16_fallback(const float *source, int16_t *dest, uint32_t frame_count) {
+    convert_stereo_to_s16_basic(source, dest, 0, frame_count);
+}
+
+// same as in gxm/stream.cpp, the implementation is chosen the first time it is used
+static void mix_stereo_init(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count);
+static void convert_stereo_to_s16_init(const float *source, int16_t *dest, uint32_t frame_count);
+
+static void (*mix_stereo_var)(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count) = mix_stereo_init;
+static void (*convert_stereo_to_s16_var)(const float *source, int16_t *dest, uint32_t frame_count) = convert_stereo_to_s16_init;
+
+void mix_stereo_init(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count) {
+    if (util::instrset::instrset_detect() >= util::instrset::instrset_AVX)
+        mix_stereo_var = mix_stereo_avx;
+    else
+        mix_stereo_var = mix_stereo_fallback;
+    mix_stereo_var(dest, source, volume_matrix, frame_count);
+}
+
+void convert_stereo_to_s16_init(const float *source, int16_t *dest, uint32_t frame_count) {
+    if (util::instrset::instrset_detect() >= util::instrset::instrset_AVX)
+        convert_stereo_to_s16_var = convert_stereo_to_s16_avx;
+    else
+        convert_stereo_to_s16_var = convert_stereo_to_s16_fallback;
+    convert_stereo_to_s16_var(source, dest, frame_count);
+}
+
+void mix_stereo(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count) {
+    mix_stereo_var(dest, source, volume_matrix, frame_count);
+}
+
+void convert_stereo_to_s16(const float *source, int16_t *dest, uint32_t frame_count) {
+    convert_stereo_to_s16_var(source, dest, frame_count);
+}
+#else
+void mix_stereo(float *dest, const float *source, const float volume_matrix[2][2], uint32_t frame_count) {
+    mix_stereo_basic(dest, source, volume_matrix, 0, frame_count);
+}
+
+void convert_stereo_to_s16(const float *source, int16_t *dest, uint32_t frame_count) {
+    convert_stereo_to_s16_basic(source, dest, 0, frame_count);
+}
+#endif
+
+} // namespace ngs
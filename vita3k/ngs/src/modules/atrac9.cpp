@@ -15,6 +15,7 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <ngs/dsp.h>
 #include <ngs/modules/atrac9.h>
 #include <util/log.h>
 
@@ -24,9 +25,6 @@ extern "C" {
 
 namespace ngs {
 
-SwrContext *Atrac9Module::swr_mono_to_stereo = nullptr;
-SwrContext *Atrac9Module::swr_stereo = nullptr;
-
 void Atrac9Module::on_state_change(const MemState &mem, ModuleData &data, const VoiceState previous) {
     SceNgsAT9States *state = data.get_state<SceNgsAT9States>();
     if (data.parent->state == VOICE_STATE_ACTIVE && previous == VOICE_STATE_AVAILABLE) {
@@ -186,7 +184,7 @@ bool Atrac9Module::decode_more_data(KernelState &kern, const MemState &mem, cons
         }
     }
 
-    std::vector<uint8_t> decoded_superframe_samples(decoder->get(DecoderQuery::AT9_SAMPLE_PER_SUPERFRAME) * sizeof(float) * 2);
+    decoded_superframe_samples.assign(decoder->get(DecoderQuery::AT9_SAMPLE_PER_SUPERFRAME) * sizeof(float) * 2, 0);
     uint32_t decoded_superframe_pos = 0;
     bool got_decode_error = false;
     // decode a whole superframe at a time
@@ -198,44 +196,13 @@ bool Atrac9Module::decode_more_data(KernelState &kern, const MemState &mem, cons
 
         // convert from int16 to float
         uint32_t const channel_count = decoder->get(DecoderQuery::CHANNELS);
-        std::vector<uint8_t> temporary_bytes(samples_per_frame * sizeof(int16_t) * channel_count);
+        frame_samples.resize(samples_per_frame * sizeof(int16_t) * channel_count);
         DecoderSize decoder_size;
-        decoder->receive(temporary_bytes.data(), &decoder_size);
-
-        SwrContext *swr;
-        if (channel_count == 1) {
-            if (!swr_mono_to_stereo) {
-                AVChannelLayout layout_mono = AV_CHANNEL_LAYOUT_MONO;
-                AVChannelLayout layout_stereo = AV_CHANNEL_LAYOUT_STEREO;
-
-                int ret = swr_alloc_set_opts2(&swr_mono_to_stereo,
-                    &layout_stereo, AV_SAMPLE_FMT_FLT, 480000,
-                    &layout_mono, AV_SAMPLE_FMT_S16, 480000,
-                    0, nullptr);
-                assert(ret == 0);
-                ret = swr_init(swr_mono_to_stereo);
-                assert(ret == 0);
-            }
+        decoder->receive(frame_samples.data(), &decoder_size);
 
-            swr = swr_mono_to_stereo;
-        } else {
-            if (!swr_stereo) {
-                AVChannelLayout layout_stereo = AV_CHANNEL_LAYOUT_STEREO;
-                int ret = swr_alloc_set_opts2(&swr_stereo,
-                    &layout_stereo, AV_SAMPLE_FMT_FLT, 480000,
-                    &layout_stereo, AV_SAMPLE_FMT_S16, 480000,
-                    0, nullptr);
-                assert(ret == 0);
-                ret = swr_init(swr_stereo);
-                assert(ret == 0);
-            }
-
-            swr = swr_stereo;
-        }
-
-        const uint8_t *swr_data_in = temporary_bytes.data();
-        uint8_t *swr_data_out = decoded_superframe_samples.data() + decoded_superframe_pos;
-        const int result = swr_convert(swr, &swr_data_out, decoder_size.samples, &swr_data_in, decoder_size.samples);
+        // converted directly, going through swresample for each frame costs more than the conversion itself
+        float *superframe_data = reinterpret_cast<float *>(decoded_superframe_samples.data() + decoded_superframe_pos);
+        convert_s16_to_stereo(reinterpret_cast<const int16_t *>(frame_samples.data()), superframe_data, decoder_size.samples, channel_count);
 
         decoded_superframe_pos += decoder_size.samples * sizeof(float) * 2;
         input += decoder->get_es_size();
@@ -264,18 +231,15 @@ bool Atrac9Module::decode_more_data(KernelState &kern, const MemState &mem, cons
         }
         // assume the skipped samples happen before the scaling
         int scaled_samples_amount = swr_get_out_samples(state->swr, decoded_size);
-        std::vector<uint8_t> scaled_data(scaled_samples_amount * sizeof(float) * 2, 0);
 
-        uint8_t *scaled_dest_data = scaled_data.data();
+        // Scale the audio data directly into the queue for the final audio buffer, then only keep what was produced
+        data.extra_storage.resize(curr_pos + scaled_samples_amount * sizeof(float) * 2);
+        uint8_t *scaled_dest_data = data.extra_storage.data() + curr_pos;
         const uint8_t *scaled_src_data = decoded_superframe_samples.data() + decoded_start_offset * sizeof(float) * 2;
         scaled_samples_amount = swr_convert(state->swr, &scaled_dest_data, scaled_samples_amount, &scaled_src_data, decoded_size);
         assert(scaled_samples_amount > 0);
 
-        // Allocate memory to accommodate the result of the scaling process into the queue for the final audio buffer
         data.extra_storage.resize(curr_pos + scaled_samples_amount * sizeof(float) * 2);
-
-        // Pass scaled audio data into the queue for the final audio buffer
-        memcpy(data.extra_storage.data() + curr_pos, scaled_data.data(), scaled_samples_amount * sizeof(float) * 2);
         decoded_size = scaled_samples_amount;
 
     } else {
@@ -18,11 +18,7 @@
 #include <ngs/modules/player.h>
 #include <util/log.h>
 
-extern "C" {
-#include <libswresample/swresample.h>
-}
-
-#include <cassert>
+#include <cmath>
 #include <cstring>
 
 namespace ngs {
@@ -42,7 +38,7 @@ void PlayerModule::on_state_change(const MemState &mem, ModuleData &data, const
         state->current_buffer = params->start_buffer;
         state->current_byte_position_in_buffer = params->start_bytes;
         state->current_loop_count = 0;
-        state->reset_swr = true;
+        state->reset_resampler = true;
     }
 }
 
@@ -53,7 +49,7 @@ void PlayerModule::on_param_change(const MemState &mem, ModuleData &data) {
 
     // check for invalid playback values
     const auto is_invalid_playback_value = [](const float playback_value, const float max_value) {
-        return isnan(playback_value) || (playback_value < 0.f) || (playback_value > max_value);
+        return std::isnan(playback_value) || (playback_value < 0.f) || (playback_value > max_value);
     };
 
     if (is_invalid_playback_value(new_params->playback_scalar, 10.f)) {
@@ -72,12 +68,11 @@ void PlayerModule::on_param_change(const MemState &mem, ModuleData &data) {
         }
     }
 
-    // if playback scaling changed, reset the resampler
+    // if playback scaling changed, reset the adpcm history
+    // the resampler keeps its own history and switches to the new ratio by itself
     if (old_params->playback_frequency != new_params->playback_frequency || old_params->playback_scalar != new_params->playback_scalar) {
         ADPCMHistory hist_empty{};
         std::fill_n(state->adpcm_history, SCE_NGS_PLAYER_MAX_PCM_CHANNELS, hist_empty);
-
-        state->reset_swr = true;
     }
 }
 
@@ -273,10 +268,8 @@ bool PlayerModule::process(KernelState &kern, const MemState &mem, const SceUID
                 // Playback rate scaling
                 float src_sample_rate = params->playback_frequency;
                 if ((src_sample_rate >= 1.f) && ((params->playback_scalar != 1.f) || (static_cast<int>(src_sample_rate) != sample_rate))) {
-                    LOG_INFO_ONCE("The currently running game requests playback rate scaling when decoding audio. Audio might crackle.");
-
                     // Received decoded samples from decoder
-                    std::vector<uint8_t> decoded_data(samples_count.samples * sizeof(float) * 2, 0);
+                    decoded_data.assign(samples_count.samples * sizeof(float) * 2, 0);
 
                     // Receive the samples processed by the decoder
                     decoder->receive(decoded_data.data(), nullptr);
@@ -285,28 +278,15 @@ bool PlayerModule::process(KernelState &kern, const MemState &mem, const SceUID
                     if (params->playback_scalar != 1.0f)
                         src_sample_rate *= params->playback_scalar;
 
-                    if (!state->swr || state->reset_swr) {
-                        if (state->swr)
-                            swr_free(&state->swr);
-
-                        AVChannelLayout layout_stereo = AV_CHANNEL_LAYOUT_STEREO;
-                        int ret = swr_alloc_set_opts2(&state->swr,
-                            &layout_stereo, AV_SAMPLE_FMT_FLT, sample_rate,
-                            &layout_stereo, AV_SAMPLE_FMT_FLT, static_cast<int>(src_sample_rate),
-                            0, nullptr);
-                        assert(ret == 0);
-
-                        ret = swr_init(state->swr);
-                        assert(ret == 0);
-                        state->reset_swr = false;
+                    if (!state->resampler) {
+                        state->resampler = new Resampler(ResamplerQuality::Medium);
+                    } else if (state->reset_resampler) {
+                        state->resampler->reset();
                     }
-                    int scaled_samples_amount = swr_get_out_samples(state->swr, samples_count.samples);
-                    std::vector<uint8_t> scaled_data(scaled_samples_amount * sizeof(float) * 2, 0);
-
-                    uint8_t *scaled_dest_data = scaled_data.data();
-                    const uint8_t *scaled_src_data = decoded_data.data();
-                    scaled_samples_amount = swr_convert(state->swr, &scaled_dest_data, scaled_samples_amount, &scaled_src_data, samples_count.samples);
-                    assert(scaled_samples_amount > 0);
+                    state->reset_resampler = false;
+                    // nothing is rebuilt unless the ratio changes a lot
+                    state->resampler->set_rates(src_sample_rate, sample_rate);
+                    uint32_t scaled_samples_amount = state->resampler->get_max_output(samples_count.samples);
 
                     // Get current size of audio queue for processed samples in memory
                     const uint32_t current_count = state->decoded_samples_pending * sizeof(float) * 2;
@@ -314,8 +294,12 @@ bool PlayerModule::process(KernelState &kern, const MemState &mem, const SceUID
                     // Allocate memory to accommodate the result of the scaling process into the queue for the final audio buffer
                     data.extra_storage.resize(current_count + scaled_samples_amount * sizeof(float) * 2);
 
-                    // Pass scaled audio data into the queue for the final audio buffer
-                    memcpy(data.extra_storage.data() + current_count, scaled_data.data(), scaled_samples_amount * sizeof(float) * 2);
+                    // Scale the audio data directly into the queue, then only keep what was produced
+                    float *scaled_dest_data = reinterpret_cast<float *>(data.extra_storage.data() + current_count);
+                    const float *scaled_src_data = reinterpret_cast<const float *>(decoded_data.data());
+                    scaled_samples_amount = state->resampler->process(scaled_src_data, samples_count.samples, scaled_dest_data, scaled_samples_amount);
+
+                    data.extra_storage.resize(current_count + scaled_samples_amount * sizeof(float) * 2);
 
                 } else {
                     // Get current size of audio buffer for processed samples in memory
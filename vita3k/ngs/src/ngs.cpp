@@ -18,6 +18,7 @@
 #include <cpu/functions.h>
 #include <kernel/state.h>
 
+#include <ngs/dsp.h>
 #include <ngs/state.h>
 #include <ngs/system.h>
 #include <util/lock_and_find.h>
@@ -37,6 +38,7 @@ System::System(const Ptr<void> memspace, const uint32_t memspace_size)
 
 void VoiceInputManager::init(const uint32_t granularity, const uint16_t total_input) {
     inputs.resize(total_input);
+    received.assign(total_input, true);
 
     for (auto &input : inputs) {
         // FLTP and maximum channel count
@@ -47,8 +49,10 @@ void VoiceInputManager::init(const uint32_t granularity, const uint16_t total_in
 }
 
 void VoiceInputManager::reset_inputs() {
-    for (auto &input : inputs) {
-        std::fill(input.begin(), input.end(), 0);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (received[i])
+            std::fill(inputs[i].begin(), inputs[i].end(), 0);
+        received[i] = false;
     }
 }
 
@@ -66,6 +70,7 @@ int32_t VoiceInputManager::receive(ngs::Patch *patch, const VoiceProduct &produc
     if (!input) {
         return -1;
     }
+    received[patch->dest_index] = true;
 
     float *dest_buffer = reinterpret_cast<float *>(input->data());
     const float *data_to_mix_in = reinterpret_cast<const float *>(product.data);
@@ -86,12 +91,7 @@ int32_t VoiceInputManager::receive(ngs::Patch *patch, const VoiceProduct &produc
 
     // Try mixing, also with the use of this volume matrix
     // Dest is our voice to receive this data.
-    for (int32_t k = 0; k < patch->dest->rack->system->granularity; k++) {
-        dest_buffer[k * 2] = std::clamp(dest_buffer[k * 2] + data_to_mix_in[k * 2] * volume_matrix[0][0]
-                + data_to_mix_in[k * 2 + 1] * volume_matrix[1][0],
-            -1.0f, 1.0f);
-        dest_buffer[k * 2 + 1] = std::clamp(dest_buffer[k * 2 + 1] + data_to_mix_in[k * 2] * volume_matrix[0][1] + data_to_mix_in[k * 2 + 1] * volume_matrix[1][1], -1.0f, 1.0f);
-    }
+    mix_stereo(dest_buffer, data_to_mix_in, volume_matrix, patch->dest->rack->system->granularity);
 
     return 0;
 }
@@ -155,6 +155,8 @@ void Voice::init(Rack *mama) {
     is_pending = false;
     is_paused = false;
     is_keyed_off = false;
+    graph_level = 0;
+    is_graph_visited = false;
 
     datas.resize(mama->modules.size());
 
@@ -240,6 +242,15 @@ ModuleData *Voice::module_storage(const uint32_t index) {
     return &datas[index];
 }
 
+bool Voice::can_process_in_parallel() const {
+    for (const auto &module : rack->modules) {
+        if (module && !module->can_process_in_parallel())
+            return false;
+    }
+
+    return true;
+}
+
 void Voice::transition(const MemState &mem, const VoiceState new_state) {
     const VoiceState old = state;
     state = new_state;
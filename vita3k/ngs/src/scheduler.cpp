@@ -19,11 +19,20 @@
 #include <ngs/system.h>
 
 #include <kernel/state.h>
+#include <threads/job_pool.h>
+#include <util/audio_stats.h>
+#include <util/profile.h>
 
 #include <algorithm>
 #include <cstring>
+#include <future>
+#include <thread>
 #include <util/vector_utils.h>
 
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#endif
+
 namespace ngs {
 
 bool VoiceScheduler::deque_voice(Voice *voice) {
@@ -117,7 +126,58 @@ bool VoiceScheduler::off(const MemState &mem, Voice *voice) {
     return true;
 }
 
+// run the modules of the voice, return true if one of them finished
+static bool process_voice_modules(KernelState &kern, const MemState &mem, const SceUID thread_id, Voice *voice, std::unique_lock<std::recursive_mutex> &scheduler_lock,
+    std::unique_lock<std::mutex> &voice_lock, uint32_t &finished_module) {
+    memset(voice->products, 0, sizeof(voice->products));
+
+    bool finished = false;
+    for (size_t i = 0; i < voice->rack->modules.size(); i++) {
+        if (voice->rack->modules[i]) {
+            if (voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], scheduler_lock, voice_lock)) {
+                finished = true;
+                finished_module = voice->rack->modules[i]->module_id();
+            }
+        }
+    }
+
+    return finished;
+}
+
+static void deliver_voice_products(const MemState &mem, const std::vector<Voice *> &voice_queue, Voice *voice) {
+    for (size_t i = 0; i < voice->rack->vdef->output_count; i++) {
+        if (voice->products[i].data)
+            deliver_data(mem, voice_queue, voice, static_cast<uint8_t>(i), voice->products[i]);
+    }
+}
+
+void VoiceScheduler::finish_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, Voice *voice, uint32_t finished_module,
+    std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
+    voice->is_keyed_off = true;
+    voice->transition(mem, VOICE_STATE_FINALIZING);
+    if (voice->finished_callback) {
+        voice_lock.unlock();
+        scheduler_lock.unlock();
+        voice->invoke_callback(kern, mem, thread_id, voice->finished_callback, voice->finished_callback_user_data, finished_module);
+        scheduler_lock.lock();
+        voice_lock.lock();
+    }
+    voice->is_keyed_off = false;
+
+    stop(mem, voice);
+}
+
 void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID thread_id) {
+    // the workers are shared by all the systems and only started the first time a large enough level is processed
+    static JobPool pool;
+    static const int nb_threads = static_cast<int>(std::min(std::thread::hardware_concurrency(), 4U));
+
+#ifdef TRACY_ENABLE
+    ZoneScopedN("NGS update");
+#endif
+    // this includes the callbacks run by the voices
+    const auto update_start = std::chrono::steady_clock::now();
+
     std::unique_lock<std::recursive_mutex> scheduler_lock(mutex);
     is_updating = true;
 
@@ -127,45 +187,112 @@ void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID
     // Do a first routine to clear inputs from previous update session
     for (ngs::Voice *voice : queue_copy) {
         voice->inputs.reset_inputs();
+        voice->graph_level = 0;
+        voice->is_graph_visited = false;
     }
 
+    // The queue respects the dependencies, so the level of a voice is known once all the voices before it are visited.
+    // A patch to a voice which was already visited can't deliver anything during this update, it is ignored.
     for (ngs::Voice *voice : queue_copy) {
-        // Modify the state, in peace....
-        std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
-        memset(voice->products, 0, sizeof(voice->products));
-
-        bool finished = false;
-        uint32_t finished_module = 0;
-
-        for (size_t i = 0; i < voice->rack->modules.size(); i++) {
-            if (voice->rack->modules[i]) {
-                if (voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], scheduler_lock, voice_lock)) {
-                    finished = true;
-                    finished_module = voice->rack->modules[i]->module_id();
-                }
+        voice->is_graph_visited = true;
+        for (size_t i = 0; i < voice->rack->vdef->output_count; i++) {
+            for (const auto &patch_ptr : voice->patches[i]) {
+                const Patch *patch = patch_ptr.get(mem);
+                if (!patch || patch->output_sub_index == -1 || patch->dest->is_graph_visited)
+                    continue;
+
+                patch->dest->graph_level = std::max(patch->dest->graph_level, voice->graph_level + 1);
             }
         }
-        if (finished) {
-            voice->is_keyed_off = true;
-            voice->transition(mem, VOICE_STATE_FINALIZING);
-            if (voice->finished_callback) {
-                voice_lock.unlock();
-                scheduler_lock.unlock();
-                voice->invoke_callback(kern, mem, thread_id, voice->finished_callback, voice->finished_callback_user_data, finished_module);
-                scheduler_lock.lock();
-                voice_lock.lock();
+    }
+
+    // the order of the queue is kept inside of a level
+    std::vector<ngs::Voice *> level_order = queue_copy;
+    std::stable_sort(level_order.begin(), level_order.end(), [](const Voice *lhs, const Voice *rhs) {
+        return lhs->graph_level < rhs->graph_level;
+    });
+
+    std::vector<ngs::Voice *> parallel_voices;
+    std::vector<uint32_t> finished_modules;
+    for (auto level_begin = level_order.begin(); level_begin != level_order.end();) {
+        const uint32_t level = (*level_begin)->graph_level;
+        const auto level_end = std::find_if(level_begin, level_order.end(), [=](const Voice *voice) { return voice->graph_level != level; });
+
+        // the voices of a level don't depend on each other, the ones only running DSP modules can be processed by the workers
+        parallel_voices.clear();
+        if (nb_threads > 1 && static_cast<size_t>(level_end - level_begin) >= PARALLEL_MIN_VOICES) {
+            for (auto it = level_begin; it != level_end; it++) {
+                if ((*it)->can_process_in_parallel())
+                    parallel_voices.push_back(*it);
             }
-            voice->is_keyed_off = false;
+            if (parallel_voices.size() < PARALLEL_MIN_VOICES)
+                parallel_voices.clear();
+        }
+
+        for (auto it = level_begin; it != level_end; it++) {
+            ngs::Voice *voice = *it;
+            if (!parallel_voices.empty() && voice->can_process_in_parallel())
+                continue;
+
+            // Modify the state, in peace....
+            std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
+            uint32_t finished_module = 0;
+            if (process_voice_modules(kern, mem, thread_id, voice, scheduler_lock, voice_lock, finished_module))
+                finish_voice(kern, mem, thread_id, voice, finished_module, scheduler_lock, voice_lock);
 
-            stop(mem, voice);
+            deliver_voice_products(mem, queue_copy, voice);
+            voice->frame_count++;
         }
 
-        for (size_t i = 0; i < voice->rack->vdef->output_count; i++) {
-            if (voice->products[i].data)
-                deliver_data(mem, queue_copy, voice, static_cast<uint8_t>(i), voice->products[i]);
+        if (!parallel_voices.empty()) {
+            static std::once_flag pool_started;
+            std::call_once(pool_started, [] { pool.start(nb_threads - 1, [] { PROFILE_THREAD_NAME("NGS worker"); }); });
+
+            // a finished voice is left to this thread as finishing it modifies the queue and can invoke a callback
+            static constexpr uint32_t NOT_FINISHED = ~0U;
+            finished_modules.assign(parallel_voices.size(), NOT_FINISHED);
+            const auto process_voices = [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++) {
+                    ngs::Voice *voice = parallel_voices[i];
+                    std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
+                    uint32_t finished_module = 0;
+                    // the modules of these voices never release the scheduler lock
+                    if (process_voice_modules(kern, mem, thread_id, voice, scheduler_lock, voice_lock, finished_module)) {
+                        finished_modules[i] = finished_module;
+                        continue;
+                    }
+                    voice_lock.unlock();
+
+                    // the destinations are in the next levels, only the voices of this level can deliver to them concurrently
+                    deliver_voice_products(mem, queue_copy, voice);
+                    voice->frame_count++;
+                }
+            };
+
+            // the calling thread takes care of the first chunk
+            const size_t voices_per_chunk = (parallel_voices.size() + nb_threads - 1) / nb_threads;
+            std::vector<std::future<void>> chunks;
+            for (size_t first = voices_per_chunk; first < parallel_voices.size(); first += voices_per_chunk)
+                chunks.push_back(pool.submit([&, first] { process_voices(first, std::min(first + voices_per_chunk, parallel_voices.size())); }));
+            process_voices(0, voices_per_chunk);
+            for (auto &chunk : chunks)
+                chunk.wait();
+
+            for (size_t i = 0; i < parallel_voices.size(); i++) {
+                if (finished_modules[i] == NOT_FINISHED)
+                    continue;
+
+                ngs::Voice *voice = parallel_voices[i];
+                std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
+                finish_voice(kern, mem, thread_id, voice, finished_modules[i], scheduler_lock, voice_lock);
+                voice_lock.unlock();
+
+                deliver_voice_products(mem, queue_copy, voice);
+                voice->frame_count++;
+            }
         }
 
-        voice->frame_count++;
+        level_begin = level_end;
     }
 
     while (!operations_pending.empty()) {
@@ -184,6 +311,12 @@ void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID
 
     is_updating = false;
     condvar.notify_all();
+
+    const uint32_t update_time = audio_stats_elapsed_us(update_start);
+    audio_pipeline_stats.add_ngs_update(update_time);
+#ifdef TRACY_ENABLE
+    TracyPlot("NGS update (us)", static_cast<int64_t>(update_time));
+#endif
 }
 
 int32_t VoiceScheduler::get_position(Voice *v) {
@@ -20,3 +20,12 @@
 #include <cstdint>
 
 const char *import_name(uint32_t nid);
+
+constexpr uint32_t INVALID_IMPORT_SLOT = UINT32_MAX;
+
+// Index of the function NID in nids.inc (variable NIDs are skipped) or INVALID_IMPORT_SLOT if it is unknown.
+// The modules use the same order to build a flat table of the import functions.
+uint32_t import_slot(uint32_t nid);
+uint32_t import_slot_count();
+// NID of the function of an import slot, the reverse of import_slot
+uint32_t import_slot_nid(uint32_t slot);
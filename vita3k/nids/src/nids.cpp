@@ -15,6 +15,8 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <nids/functions.h>
+
 #include <cstdint>
 
 #define VAR_NID(name, nid) extern const char name_##name[] = #name;
@@ -23,6 +25,15 @@
 #undef NID
 #undef VAR_NID
 
+enum ImportSlot : uint32_t {
+#define VAR_NID(name, nid)
+#define NID(name, nid) IMPORT_SLOT_##name,
+#include <nids/nids.inc>
+#undef NID
+#undef VAR_NID
+    IMPORT_SLOT_COUNT
+};
+
 const char *import_name(uint32_t nid) {
     switch (nid) {
 #define VAR_NID(name, nid) \
@@ -38,3 +49,32 @@ const char *import_name(uint32_t nid) {
         return "UNRECOGNISED";
     }
 }
+
+uint32_t import_slot(uint32_t nid) {
+    switch (nid) {
+#define VAR_NID(name, nid)
+#define NID(name, nid) \
+    case nid:          \
+        return IMPORT_SLOT_##name;
+#include <nids/nids.inc>
+#undef NID
+#undef VAR_NID
+    default:
+        return INVALID_IMPORT_SLOT;
+    }
+}
+
+uint32_t import_slot_count() {
+    return IMPORT_SLOT_COUNT;
+}
+
+uint32_t import_slot_nid(uint32_t slot) {
+    static constexpr uint32_t slot_nids[] = {
+#define VAR_NID(name, nid)
+#define NID(name, nid) nid,
+#include <nids/nids.inc>
+#undef NID
+#undef VAR_NID
+    };
+    return slot < IMPORT_SLOT_COUNT ? slot_nids[slot] : 0;
+}
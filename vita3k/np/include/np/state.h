@@ -21,6 +21,7 @@
 #include <np/trophy/context.h>
 
 #include <mem/util.h> // Address.
+#include <threads/job_pool.h>
 
 #include <map>
 #include <mutex>
@@ -40,6 +41,10 @@ struct NpTrophyUnlockCallbackData {
     std::string trophy_detail;
     np::trophy::SceNpTrophyGrade trophy_kind{};
     std::vector<std::uint8_t> icon_buf;
+    // RGBA icon, decoded by the callback so that the GUI only has to create its texture
+    std::vector<std::uint8_t> icon_pixels;
+    int icon_width = 0;
+    int icon_height = 0;
 };
 
 using NpTrophyUnlockCallback = std::function<void(NpTrophyUnlockCallbackData &)>;
@@ -50,6 +55,9 @@ struct NpTrophyState {
 
     std::vector<np::trophy::Context> contexts;
     NpTrophyUnlockCallback trophy_unlock_callback;
+
+    // saves the progress files and runs the unlock callback in the order of the unlocks, the guest does not wait for them
+    JobPool worker;
 };
 
 enum SceNpServiceState : uint32_t {
@@ -23,7 +23,9 @@
 #include <util/types.h>
 
 #include <array>
+#include <vector>
 
+class JobPool;
 struct IOState;
 
 namespace np::trophy {
@@ -74,12 +76,16 @@ struct Context {
     IOState *io;
     fs::path pref_path;
 
+    std::vector<uint8_t> get_trophy_progress_data() const;
     void save_trophy_progress_file();
+    // the file is written by the worker with the progress at the time of the call
+    void queue_trophy_progress_save(JobPool &worker);
     bool load_trophy_progress_file(const SceUID &progress_input_file);
 
     int copy_file_data_from_trophy_file(const char *filename, void *buffer, SceSize *size);
     int install_trophy_conf(IOState *io, const fs::path &pref_path, const std::string &np_com_id);
     bool init_info_from_trp();
+    // only changes the progress in memory, it must be saved by the caller
     bool unlock_trophy(int32_t id, np::NpTrophyError *err, const bool force_unlock = false);
 
     bool is_trophy_hidden(const uint32_t &trophy_index);
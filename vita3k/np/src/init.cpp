@@ -35,11 +35,14 @@ bool deinit(NpState &state) {
 }
 
 bool init(NpTrophyState &state) {
+    state.worker.start(1);
     state.inited = true;
     return true;
 }
 
 bool deinit(NpTrophyState &state) {
+    // the pending saves are done before the worker exits
+    state.worker.stop();
     state.inited = false;
     return true;
 }
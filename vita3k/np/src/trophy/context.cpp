@@ -21,6 +21,8 @@
 #include <np/functions.h>
 #include <np/state.h>
 #include <np/trophy/context.h>
+#include <threads/job_pool.h>
+#include <util/log.h>
 
 #include <pugixml.hpp>
 
@@ -159,12 +161,10 @@ bool Context::init_info_from_trp() {
 
 static constexpr std::uint32_t TROPHY_USR_MAGIC = 0x12D5819A;
 
-void Context::save_trophy_progress_file() {
-    // Open the file
-    const SceUID output = open_file(*io, trophy_progress_output_file_path.c_str(), SCE_O_WRONLY | SCE_O_CREAT, pref_path, "save_trophy_progress");
-
-    auto write_stuff = [&](const void *data, std::uint32_t amount) -> int {
-        return write_file(output, data, amount, *io, "save_trophy_progress_file");
+std::vector<uint8_t> Context::get_trophy_progress_data() const {
+    std::vector<uint8_t> data;
+    auto write_stuff = [&](const void *source, std::uint32_t amount) {
+        data.insert(data.end(), static_cast<const uint8_t *>(source), static_cast<const uint8_t *>(source) + amount);
     };
 
     write_stuff(&TROPHY_USR_MAGIC, 4);
@@ -178,9 +178,30 @@ void Context::save_trophy_progress_file() {
     write_stuff(unlock_timestamps.data(), (std::uint32_t)unlock_timestamps.size() * 8);
     write_stuff(trophy_kinds.data(), (std::uint32_t)trophy_kinds.size() * 4);
 
+    return data;
+}
+
+void Context::save_trophy_progress_file() {
+    // Open the file
+    const SceUID output = open_file(*io, trophy_progress_output_file_path.c_str(), SCE_O_WRONLY | SCE_O_CREAT, pref_path, "save_trophy_progress");
+
+    const auto data = get_trophy_progress_data();
+    write_file(output, data.data(), static_cast<SceSize>(data.size()), *io, "save_trophy_progress_file");
+
     close_file(*io, output, "save_trophy_progress_file");
 }
 
+void Context::queue_trophy_progress_save(JobPool &worker) {
+    // the worker writes to the host file directly, the file descriptors of the IO state belong to the guest
+    const fs::path progress_path = expand_path(*io, trophy_progress_output_file_path.c_str(), pref_path);
+    worker.submit([progress_path, data = get_trophy_progress_data()]() {
+        fs::ofstream output(progress_path, std::ios::binary);
+        output.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!output)
+            LOG_ERROR("Failed to save the trophy progress to {}", progress_path);
+    });
+}
+
 bool Context::load_trophy_progress_file(const SceUID &progress_input_file) {
     // Check magic
     std::uint32_t magic;
@@ -258,8 +279,6 @@ bool Context::unlock_trophy(std::int32_t id, np::NpTrophyError *err, const bool
 
     unlock_timestamps[id] = std::time(nullptr);
 
-    save_trophy_progress_file();
-
     return true;
 }
 
@@ -81,6 +81,7 @@ struct PkgEntry {
     uint32_t padding;
 };
 
-bool install_pkg(const fs::path &pkg_path, EmuEnvState &emuenv, std::string &p_zRIF, const std::function<void(float)> &progress_callback = nullptr);
+// throughput_callback receives the extraction speed in bytes per second
+bool install_pkg(const fs::path &pkg_path, EmuEnvState &emuenv, std::string &p_zRIF, const std::function<void(float)> &progress_callback = nullptr, const std::function<void(uint64_t)> &throughput_callback = nullptr);
 
 bool decrypt_install_nonpdrm(EmuEnvState &emuenv, const fs::path &drmlicpath, const fs::path &title_path);
@@ -656,4 +656,6 @@ std::string decompress_segments(const std::vector<uint8_t> &decrypted_data, cons
 std::tuple<uint64_t, SelfType> get_key_type(std::ifstream &file, const SceHeader &sce_hdr);
 std::vector<SceSegment> get_segments(const uint8_t *input, const SceHeader &sce_hdr, KeyStore &SCE_KEYS, uint64_t sysver = -1, SelfType self_type = static_cast<SelfType>(0), int keytype = 0, const uint8_t *klic = 0);
 std::vector<uint8_t> decrypt_fself(const std::vector<uint8_t> &fself, const uint8_t *klic);
+// same as decrypt_fself, the decrypted selfs are kept in cache_path, keyed by the hash of the encrypted self and the klic
+std::vector<uint8_t> decrypt_fself_cached(const std::vector<uint8_t> &fself, const uint8_t *klic, const fs::path &cache_path);
 void decrypt_selfs(const fs::path &input_path, const fs::path &cache_path, const uint8_t *klic);
@@ -37,11 +37,20 @@
 #include <packages/sce_types.h>
 #include <packages/sfo.h>
 
+#include <threads/job_pool.h>
 #include <util/bytes.h>
 #include <util/log.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
 // Credits to mmozeiko https://github.com/mmozeiko/pkg2zip
 
+// the files are split in chunks extracted in parallel, each one is read and written by blocks
+static constexpr uint64_t PKG_CHUNK_SIZE = 16 * 1024 * 1024;
+static constexpr uint64_t PKG_BUFFER_SIZE = 1024 * 1024;
+
 static void ctr_init(uint8_t *counter, uint8_t *iv, uint64_t n) {
     for (int i = 15; i >= 0; i--) {
         n = n + iv[i];
@@ -76,7 +85,7 @@ bool decrypt_install_nonpdrm(EmuEnvState &emuenv, const fs::path &drmlicpath, co
     return true;
 }
 
-bool install_pkg(const fs::path &pkg_path, EmuEnvState &emuenv, std::string &p_zRIF, const std::function<void(float)> &progress_callback) {
+bool install_pkg(const fs::path &pkg_path, EmuEnvState &emuenv, std::string &p_zRIF, const std::function<void(float)> &progress_callback, const std::function<void(uint64_t)> &throughput_callback) {
     FILE *infile = FOPEN(pkg_path.c_str(), "rb");
     if (!infile) {
         LOG_CRITICAL("Failed to load pkg file in path: {}", fs_utils::path_to_utf8(pkg_path));
@@ -244,7 +253,17 @@ bool install_pkg(const fs::path &pkg_path, EmuEnvState &emuenv, std::string &p_z
         EVP_DecryptFinal_ex(cipher_ctx, data + dec_len, &dec_len);
     };
 
-    std::vector<uint8_t> buffer(0x10000);
+    // the entries and their names are small, they are read first, then the file contents are
+    // extracted in parallel: CTR blocks only depend on their offset so any part can be decrypted on its own
+    struct PkgChunk {
+        fs::path file_path;
+        uint64_t pkg_offset;
+        uint64_t file_offset;
+        uint64_t size;
+    };
+    std::vector<PkgChunk> chunks;
+    uint64_t total_data_size = 0;
+
     for (uint32_t i = 0; i < byte_swap(pkg_header.file_count); i++) {
         PkgEntry entry;
         uint64_t file_offset = items_offset + i * 32;
@@ -255,11 +274,10 @@ bool install_pkg(const fs::path &pkg_path, EmuEnvState &emuenv, std::string &p_z
 
         if (pkg_size < byte_swap(pkg_header.data_offset) + byte_swap(entry.name_offset) + byte_swap(entry.name_size) || pkg_size < byte_swap(pkg_header.data_offset) + byte_swap(entry.data_offset) + byte_swap(entry.data_size)) {
             LOG_ERROR("The pkg file size is too small, possibly corrupted");
+            fclose(infile);
             evp_cleanup();
             return false;
         }
-        const auto file_count = (float)byte_swap(pkg_header.file_count);
-        progress_callback(i / file_count * 100.f * 0.6f);
         std::vector<unsigned char> name(byte_swap(entry.name_size));
         fseek(infile, byte_swap(pkg_header.data_offset) + byte_swap(entry.name_offset), SEEK_SET);
         fread(name.data(), byte_swap(entry.name_size), 1, infile);
@@ -272,33 +290,81 @@ bool install_pkg(const fs::path &pkg_path, EmuEnvState &emuenv, std::string &p_z
         if ((byte_swap(entry.type) & 0xFF) == 4 || (byte_swap(entry.type) & 0xFF) == 18) { // Directory
             fs::create_directories(path / string_name);
         } else { // File
-            fs::ofstream outfile(path / string_name, std::ios::binary);
-
-            auto offset = byte_swap(entry.data_offset);
-            auto data_size = byte_swap(entry.data_size);
-
-            uint8_t counter[0x10];
-            ctr_init(counter, pkg_header.pkg_data_iv, offset / 16);
-            EVP_DecryptInit_ex(cipher_ctx, cipher_CTR, nullptr, main_key, counter);
-            EVP_CIPHER_CTX_set_padding(cipher_ctx, 0);
+            // the file gets its final size now so that its chunks can be written in any order
+            const auto file_path = path / string_name;
+            const auto data_size = byte_swap(entry.data_size);
+            fs::ofstream(file_path, std::ios::binary).close();
+            fs::resize_file(file_path, data_size);
+
+            for (uint64_t chunk_offset = 0; chunk_offset < data_size; chunk_offset += PKG_CHUNK_SIZE)
+                chunks.push_back({ file_path, byte_swap(entry.data_offset) + chunk_offset, chunk_offset, std::min(PKG_CHUNK_SIZE, data_size - chunk_offset) });
+            total_data_size += data_size;
+        }
+    }
+    fclose(infile);
 
-            fseek(infile, byte_swap(pkg_header.data_offset) + offset, SEEK_SET);
-            while (data_size != 0) {
-                size_t size = data_size < buffer.size() ? data_size : buffer.size();
-                fread(buffer.data(), size, 1, infile);
+    std::atomic<uint64_t> extracted_size = 0;
+    const auto extract_chunk = [&](const PkgChunk &chunk) {
+        fs::ifstream pkg_file(pkg_path, std::ios::binary);
+        fs::fstream outfile(chunk.file_path, std::ios::binary | std::ios::in | std::ios::out);
+        EVP_CIPHER_CTX *chunk_ctx = EVP_CIPHER_CTX_new();
+        if (!pkg_file || !outfile || !chunk_ctx) {
+            EVP_CIPHER_CTX_free(chunk_ctx);
+            return false;
+        }
 
-                EVP_DecryptUpdate(cipher_ctx, buffer.data(), &dec_len, buffer.data(), size);
+        uint8_t counter[0x10];
+        ctr_init(counter, pkg_header.pkg_data_iv, chunk.pkg_offset / 16);
+        EVP_DecryptInit_ex(chunk_ctx, cipher_CTR, nullptr, main_key, counter);
+        EVP_CIPHER_CTX_set_padding(chunk_ctx, 0);
+
+        pkg_file.seekg(byte_swap(pkg_header.data_offset) + chunk.pkg_offset);
+        outfile.seekp(chunk.file_offset);
+        std::vector<uint8_t> buffer(PKG_BUFFER_SIZE);
+        for (uint64_t remaining = chunk.size; remaining != 0;) {
+            const auto size = static_cast<int>(std::min<uint64_t>(remaining, buffer.size()));
+            int chunk_dec_len = 0;
+            pkg_file.read(reinterpret_cast<char *>(buffer.data()), size);
+            EVP_DecryptUpdate(chunk_ctx, buffer.data(), &chunk_dec_len, buffer.data(), size);
+            outfile.write(reinterpret_cast<char *>(buffer.data()), chunk_dec_len);
+            remaining -= size;
+            extracted_size += size;
+        }
+        EVP_CIPHER_CTX_free(chunk_ctx);
 
-                outfile.write(reinterpret_cast<char *>(buffer.data()), dec_len);
-                data_size -= size;
-            }
+        return static_cast<bool>(pkg_file) && static_cast<bool>(outfile);
+    };
 
-            EVP_DecryptFinal_ex(cipher_ctx, buffer.data(), &dec_len);
-            outfile.write(reinterpret_cast<char *>(buffer.data()), dec_len);
-            outfile.close();
+    // reading, decrypting and writing are spread over a few threads, the storage is the limit beyond that
+    const auto start = std::chrono::steady_clock::now();
+    JobPool pool;
+    pool.start(static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 1U, 4U)));
+    std::vector<std::future<bool>> results;
+    results.reserve(chunks.size());
+    for (const auto &chunk : chunks)
+        results.push_back(pool.submit([&] { return extract_chunk(chunk); }));
+
+    bool extracted = true;
+    for (auto &result : results) {
+        while (result.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+            const auto done = extracted_size.load();
+            progress_callback(total_data_size ? done * 100.f * 0.6f / total_data_size : 0.f);
+            const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (throughput_callback && elapsed > 0)
+                throughput_callback(static_cast<uint64_t>(done / elapsed));
         }
+        extracted &= result.get();
     }
-    fclose(infile);
+    pool.stop();
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Extracted {} MiB in {:.1f}s", total_data_size / (1024 * 1024), elapsed);
+    if (!extracted) {
+        LOG_ERROR("Failed to extract the pkg contents to {}", path);
+        evp_cleanup();
+        return false;
+    }
+    progress_callback(60);
 
     evp_cleanup();
     fs::path title_id_src = path;
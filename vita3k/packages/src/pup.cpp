@@ -23,10 +23,12 @@
  * contain firmware updates
  */
 
+#include <io/exfat.h>
 #include <openssl/evp.h>
-#include <packages/exfat.h>
 #include <packages/sce_types.h>
+#include <threads/job_pool.h>
 #include <util/fs.h>
+#include <util/log.h>
 
 #include <algorithm>
 #include <fstream>
@@ -236,6 +238,21 @@ static void join_files(const fs::path &path, const std::string &filename, const
     fileout.close();
 }
 
+// the exFAT partitions are not extracted, the io reads their files in place from the image
+static void install_exfat_image(const fs::path &partition_path, const std::string &partition, const fs::path &pref_path) {
+    const fs::path image_path{ pref_path / partition };
+    const fs::path device_path{ pref_path / partition.substr(0, 3) };
+
+    // the previous image must be closed before it is replaced, the files extracted by the older versions would hide the new ones
+    exfat::Image::release(image_path);
+    boost::system::error_code error_code{};
+    fs::remove_all(device_path, error_code);
+    fs::create_directories(device_path, error_code);
+    fs::rename(partition_path / partition, image_path, error_code);
+    if (error_code)
+        LOG_ERROR("Failed to install {}: {}", image_path, error_code.message());
+}
+
 static void decrypt_pup_packages(const fs::path &src, const fs::path &dest, KeyStore &SCE_KEYS) {
     std::vector<fs::path> pkgfiles;
 
@@ -289,14 +306,22 @@ std::string install_pup(const fs::path &pref_path, const fs::path &pup_path, con
     decrypt_pup_packages(pup_dest, pup_dec, SCE_KEYS);
 
     update_progress(70);
-    if (fs::file_size(pup_dec / "os0.img") > 0)
-        extract_fat(pup_dec, "os0.img", pref_path);
     if (fs::file_size(pup_dec / "pd0.img") > 0)
-        exfat::extract_exfat(pup_dec, "pd0.img", pref_path);
+        install_exfat_image(pup_dec, "pd0.img", pref_path);
+
+    // the partitions are separate images extracted to separate devices, each one gets its own thread
+    JobPool pool;
+    pool.start(4);
+    std::vector<std::future<void>> results;
+    if (fs::file_size(pup_dec / "os0.img") > 0)
+        results.push_back(pool.submit([&] { extract_fat(pup_dec, "os0.img", pref_path); }));
     if (fs::file_size(pup_dec / "sa0.img") > 0)
-        extract_fat(pup_dec, "sa0.img", pref_path);
+        results.push_back(pool.submit([&] { extract_fat(pup_dec, "sa0.img", pref_path); }));
     if (fs::file_size(pup_dec / "vs0.img") > 0)
-        extract_fat(pup_dec, "vs0.img", pref_path);
+        results.push_back(pool.submit([&] { extract_fat(pup_dec, "vs0.img", pref_path); }));
+    for (auto &result : results)
+        result.wait();
+    pool.stop();
     update_progress(100);
 
     // get firmware version
@@ -24,11 +24,15 @@
 #include <miniz.h>
 #include <openssl/evp.h>
 #include <packages/sce_types.h>
+#include <threads/job_pool.h>
+#include <util/hash.h>
 #include <util/string_utils.h>
 
 #include <self.h>
 
+#include <algorithm>
 #include <fstream>
+#include <mutex>
 
 // Credits to TeamMolecule for their original work on this https://github.com/TeamMolecule/sceutils
 
@@ -600,35 +604,60 @@ void register_keys(KeyStore &SCE_KEYS, int type) {
     }
 }
 
-static void extract_file(Fat16::Image &img, Fat16::Entry &entry, const fs::path &path) {
+static bool file_is_unchanged(const fs::path &filename, const std::vector<std::uint8_t> &data) {
+    if (!fs::is_regular_file(filename) || fs::file_size(filename) != data.size())
+        return false;
+
+    fs::ifstream file(filename, std::ios::binary);
+    std::vector<std::uint8_t> existing(data.size());
+    if (!file.read(reinterpret_cast<char *>(existing.data()), existing.size()))
+        return false;
+
+    return sha256(existing.data(), existing.size()) == sha256(data.data(), data.size());
+}
+
+// returns false when the file already had the same contents and was left untouched
+static bool extract_file(Fat16::Image &img, Fat16::Entry &entry, const fs::path &path) {
     const std::u16string filename_16 = entry.get_filename();
     const fs::path filename = path / std::wstring(filename_16.begin(), filename_16.end());
-    FILE *f = FOPEN(filename.native().c_str(), "wb");
 
-    static constexpr std::uint32_t CHUNK_SIZE = 0x10000;
+    static constexpr std::uint32_t CHUNK_SIZE = 0x100000;
 
-    std::vector<std::uint8_t> temp_buf;
-    temp_buf.resize(CHUNK_SIZE);
-
-    std::uint32_t size_left = entry.entry.file_size;
+    // the files of the system partitions are at most a few MiB, they are read whole
+    std::vector<std::uint8_t> data(entry.entry.file_size);
     std::uint32_t offset = 0;
 
-    while (size_left != 0) {
-        std::uint32_t size_to_take = std::min<std::uint32_t>(CHUNK_SIZE, size_left);
-        if (img.read_from_cluster(&temp_buf[0], offset, entry.entry.starting_cluster, size_to_take) != size_to_take) {
+    while (offset != data.size()) {
+        std::uint32_t size_to_take = std::min<std::uint32_t>(CHUNK_SIZE, static_cast<std::uint32_t>(data.size()) - offset);
+        if (img.read_from_cluster(&data[offset], offset, entry.entry.starting_cluster, size_to_take) != size_to_take) {
             break;
         }
 
-        size_left -= size_to_take;
         offset += size_to_take;
-
-        fwrite(&temp_buf[0], 1, size_to_take, f);
     }
+    data.resize(offset);
 
+    // a reinstall of the same firmware rewrites nothing
+    if (file_is_unchanged(filename, data))
+        return false;
+
+    FILE *f = FOPEN(filename.native().c_str(), "wb");
+    if (!f) {
+        LOG_ERROR("Failed to create {}", filename);
+        return true;
+    }
+    fwrite(data.data(), 1, data.size(), f);
     fclose(f);
+
+    return true;
 }
 
-static void traverse_directory(Fat16::Image &img, Fat16::Entry mee, const fs::path &dir_path) {
+struct FatExtractCount {
+    uint32_t written = 0;
+    uint32_t unchanged = 0;
+};
+
+static void traverse_directory(Fat16::Image &img, Fat16::Entry mee, const fs::path &dir_path, FatExtractCount &count) {
     fs::create_directories(dir_path);
 
     while (img.get_next_entry(mee)) {
@@ -642,18 +671,28 @@ static void traverse_directory(Fat16::Image &img, Fat16::Entry mee, const fs::pa
 
                 auto dir_name = mee.get_filename();
 
-                traverse_directory(img, baby, dir_path / std::wstring(dir_name.begin(), dir_name.end()) / "");
+                traverse_directory(img, baby, dir_path / std::wstring(dir_name.begin(), dir_name.end()) / "", count);
             }
         }
 
         if (mee.entry.file_attributes & (int)Fat16::EntryAttribute::ARCHIVE) {
-            extract_file(img, mee, dir_path / "");
+            if (extract_file(img, mee, dir_path / ""))
+                count.written++;
+            else
+                count.unchanged++;
         }
     }
 }
 
 void extract_fat(const fs::path &partition_path, const std::string &partition, const fs::path &pref_path) {
     FILE *f = FOPEN((partition_path / partition).native().c_str(), "rb");
+    if (!f) {
+        LOG_ERROR("Failed to open {}", partition_path / partition);
+        return;
+    }
+    // the image is read through small FAT records and clusters, a large buffer avoids a syscall for each of them
+    setvbuf(f, nullptr, _IOFBF, 0x100000);
+
     Fat16::Image img(
         f,
         // Read hook
@@ -668,7 +707,9 @@ void extract_fat(const fs::path &partition_path, const std::string &partition, c
         });
 
     Fat16::Entry first;
-    traverse_directory(img, first, pref_path / partition.substr(0, 3));
+    FatExtractCount count;
+    traverse_directory(img, first, pref_path / partition.substr(0, 3), count);
+    LOG_INFO("Extracted {}: {} files written, {} unchanged", partition, count.written, count.unchanged);
 
     fclose(f);
 }
@@ -833,6 +874,28 @@ std::tuple<uint64_t, SelfType> get_key_type(std::ifstream &file, const SceHeader
     }
 }
 
+// inflate a segment into a buffer which already has the size of the decompressed data
+static bool decompress_segment(const std::vector<uint8_t> &compressed_data, std::vector<uint8_t> &decompressed_data) {
+    mz_ulong decompressed_size = static_cast<mz_ulong>(decompressed_data.size());
+    const int ret = mz_uncompress(decompressed_data.data(), &decompressed_size, compressed_data.data(), static_cast<mz_ulong>(compressed_data.size()));
+    if (ret != MZ_OK) {
+        LOG_ERROR("Exception during zlib decompression: ({}) {}", ret, mz_error(ret));
+        return false;
+    }
+    decompressed_data.resize(decompressed_size);
+    return true;
+}
+
+// the workers are shared by all the selfs and only started the first time a self is decrypted
+// the jobs never wait on each other
+template <typename F>
+static auto submit_segment_job(F &&job) {
+    static JobPool pool;
+    static std::once_flag pool_started;
+    std::call_once(pool_started, [] { pool.start(static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 1U, 4U))); });
+    return pool.submit(std::forward<F>(job));
+}
+
 static bool is_fself_encrypted(const std::vector<uint8_t> &fself) {
     const SCE_header &self_header = *reinterpret_cast<const SCE_header *>(fself.data());
     const segment_info *const seg_infos = reinterpret_cast<const segment_info *>(&fself[self_header.section_info_offset]);
@@ -925,17 +988,43 @@ std::vector<uint8_t> decrypt_fself(const std::vector<uint8_t> &fself, const uint
     if (encrypted)
         scesegs = get_segments(fself.data(), sce_hdr, SCE_KEYS, app_info_hdr.sys_version, app_info_hdr.self_type, npdrmtype, klic);
 
-    EVP_CIPHER_CTX *cipher_ctx = EVP_CIPHER_CTX_new();
     EVP_CIPHER *cipher = EVP_CIPHER_fetch(nullptr, "AES-128-CTR", nullptr);
-    int dec_len = 0;
 
+    // the segments are decrypted and decompressed in parallel, then put together in order
+    const auto get_segment_index = [&](uint16_t i) {
+        return scesegs.empty() ? static_cast<int>(i) : scesegs[i].idx;
+    };
+    const auto process_segment = [&](uint16_t i) {
+        const int idx = get_segment_index(i);
+        std::vector<uint8_t> decrypted_data(segment_infos[idx].size);
+        if (segment_infos[idx].plaintext == SecureBool::NO) {
+            EVP_CIPHER_CTX *cipher_ctx = EVP_CIPHER_CTX_new();
+            int dec_len = 0;
+            EVP_DecryptInit_ex(cipher_ctx, cipher, nullptr, reinterpret_cast<const unsigned char *>(scesegs[i].key.c_str()), reinterpret_cast<const unsigned char *>(scesegs[i].iv.c_str()));
+            EVP_CIPHER_CTX_set_padding(cipher_ctx, 0);
+            EVP_DecryptUpdate(cipher_ctx, decrypted_data.data(), &dec_len, &fself[segment_infos[idx].offset], segment_infos[idx].size);
+            EVP_DecryptFinal_ex(cipher_ctx, decrypted_data.data() + dec_len, &dec_len);
+            EVP_CIPHER_CTX_free(cipher_ctx);
+        }
+
+        if (segment_infos[idx].compressed == SecureBool::YES) {
+            // the size of the decompressed segment is known from its program header
+            std::vector<uint8_t> decompressed_data(elf_phdrs[idx].p_filesz);
+            if (!decompress_segment(decrypted_data, decompressed_data))
+                decompressed_data.clear();
+            return decompressed_data;
+        }
+        return decrypted_data;
+    };
+
+    std::vector<std::future<std::vector<uint8_t>>> segments(elf_hdr.e_phnum);
     for (uint16_t i = 0; i < elf_hdr.e_phnum; i++) {
-        int idx = 0;
+        if (elf_phdrs[get_segment_index(i)].p_filesz != 0)
+            segments[i] = submit_segment_job([&process_segment, i] { return process_segment(i); });
+    }
 
-        if (!scesegs.empty())
-            idx = scesegs[i].idx;
-        else
-            idx = i;
+    for (uint16_t i = 0; i < elf_hdr.e_phnum; i++) {
+        const int idx = get_segment_index(i);
         if (elf_phdrs[idx].p_filesz == 0)
             continue;
 
@@ -947,26 +1036,13 @@ std::vector<uint8_t> decrypt_fself(const std::vector<uint8_t> &fself, const uint
 
         at += pad_len;
 
-        std::vector<unsigned char> decrypted_data(segment_infos[idx].size);
-        if (segment_infos[idx].plaintext == SecureBool::NO) {
-            EVP_DecryptInit_ex(cipher_ctx, cipher, nullptr, reinterpret_cast<const unsigned char *>(scesegs[i].key.c_str()), reinterpret_cast<const unsigned char *>(scesegs[i].iv.c_str()));
-            EVP_CIPHER_CTX_set_padding(cipher_ctx, 0);
-            EVP_DecryptUpdate(cipher_ctx, decrypted_data.data(), &dec_len, &fself[segment_infos[idx].offset], segment_infos[idx].size);
-            EVP_DecryptFinal_ex(cipher_ctx, decrypted_data.data() + dec_len, &dec_len);
-        }
-
-        if (segment_infos[idx].compressed == SecureBool::YES) {
-            const std::string decompressed_data = decompress_segments(decrypted_data, segment_infos[idx].size);
+        const std::vector<uint8_t> segment = segments[i].get();
+        if (segment_infos[idx].compressed == SecureBool::YES)
             segment_infos[idx].compressed = SecureBool::NO;
-            elf.insert(elf.end(), decompressed_data.begin(), decompressed_data.end());
-            at += decompressed_data.length();
-        } else {
-            elf.insert(elf.end(), decrypted_data.data(), &decrypted_data[segment_infos[idx].size]);
-            at += segment_infos[idx].size;
-        }
+        elf.insert(elf.end(), segment.begin(), segment.end());
+        at += segment.size();
     }
 
-    EVP_CIPHER_CTX_free(cipher_ctx);
     EVP_CIPHER_free(cipher);
 
     // Credits to the vitasdk team/contributors for vita-make-fself https://github.com/vitasdk/vita-toolchain/blob/master/src/vita-make-fself.c
@@ -1093,6 +1169,54 @@ std::vector<uint8_t> decrypt_fself(const std::vector<uint8_t> &fself, const uint
     return decrypted_self;
 }
 
+static std::vector<uint8_t> read_self(const fs::path &path) {
+    fs::ifstream f(path, std::ios::binary);
+    if (!f)
+        return {};
+
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+}
+
+std::vector<uint8_t> decrypt_fself_cached(const std::vector<uint8_t> &fself, const uint8_t *klic, const fs::path &cache_path) {
+    if ((fself.size() < sizeof(SCE_header)) || (reinterpret_cast<const SCE_header *>(fself.data())->magic != SCE_MAGIC) || !is_fself_encrypted(fself))
+        return decrypt_fself(fself, klic);
+
+    // the same self decrypted with another klic gives another result
+    const Sha256Hash self_hash = sha256(fself.data(), fself.size());
+    std::array<uint8_t, 32 + 16> key{};
+    std::copy(self_hash.begin(), self_hash.end(), key.begin());
+    std::copy(klic, klic + 16, key.begin() + 32);
+    const auto cached_path = cache_path / "self_cache" / (hex_string(sha256(key.data(), key.size())) + ".self");
+
+    if (fs::exists(cached_path)) {
+        auto cached_self = read_self(cached_path);
+        if ((cached_self.size() >= sizeof(SCE_header)) && (reinterpret_cast<const SCE_header *>(cached_self.data())->magic == SCE_MAGIC))
+            return cached_self;
+        LOG_WARN("Invalid cached self {}, decrypting it again", fs_utils::path_to_utf8(cached_path.filename()));
+    }
+
+    auto decrypted_self = decrypt_fself(fself, klic);
+    if (decrypted_self.empty())
+        return decrypted_self;
+
+    // written under another name first so that a partial file is never taken from the cache
+    boost::system::error_code error_code{};
+    fs::create_directories(cached_path.parent_path(), error_code);
+    const auto tmp_path = fs_utils::path_concat(cached_path, ".tmp");
+    {
+        fs::ofstream out(tmp_path, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(decrypted_self.data()), decrypted_self.size());
+        if (!out) {
+            out.close();
+            fs::remove(tmp_path, error_code);
+            return decrypted_self;
+        }
+    }
+    fs::rename(tmp_path, cached_path, error_code);
+
+    return decrypted_self;
+}
+
 void decrypt_selfs(const fs::path &input_path, const fs::path &cache_path, const uint8_t *klic) {
     const auto is_self = [](const fs::path &file_path) -> bool {
         const auto extension = file_path.filename().extension();
@@ -1107,49 +1231,59 @@ void decrypt_selfs(const fs::path &input_path, const fs::path &cache_path, const
 
     const auto output_path = cache_path / "decrypted_selfs" / input_path.stem();
 
+    std::vector<fs::path> self_paths;
     for (auto &entry : fs::recursive_directory_iterator(input_path)) {
-        if (entry.is_regular_file() && is_self(entry.path())) {
-            // Open the self file
-            fs::ifstream f(entry.path(), std::ios::binary);
-            if (!f) {
-                LOG_ERROR("Failed to open self {}", fs_utils::path_to_utf8(entry.path().filename()));
-                continue;
-            }
+        if (entry.is_regular_file() && is_self(entry.path()))
+            self_paths.push_back(entry.path());
+    }
 
-            // Read the entire self file into a vector
-            std::vector<uint8_t> fself;
-            fself.assign((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    const auto decrypt_self = [&](const fs::path &self_path) {
+        // Read the entire self file into a vector
+        std::vector<uint8_t> fself = read_self(self_path);
+        if (fself.empty()) {
+            LOG_ERROR("Failed to open self {}", fs_utils::path_to_utf8(self_path.filename()));
+            return;
+        }
 
-            // Ensure we have at least enough data for the SCE_header structure.
-            if (fself.size() < sizeof(SCE_header)) {
-                LOG_ERROR("Invalid SELF: buffer too small for SCE_header ({} bytes).", fself.size());
-                continue;
-            }
+        // Ensure we have at least enough data for the SCE_header structure.
+        if (fself.size() < sizeof(SCE_header)) {
+            LOG_ERROR("Invalid SELF: buffer too small for SCE_header ({} bytes).", fself.size());
+            return;
+        }
 
-            // Check if the self is encrypted before attempting decryption
-            if (!is_fself_encrypted(fself)) {
-                LOG_INFO("Self {} is already decrypted, skipping decryption", fs_utils::path_to_utf8(entry.path().filename()));
-                continue;
-            }
+        // Check if the self is encrypted before attempting decryption
+        if (!is_fself_encrypted(fself)) {
+            LOG_INFO("Self {} is already decrypted, skipping decryption", fs_utils::path_to_utf8(self_path.filename()));
+            return;
+        }
 
-            // Decrypt the self
-            fself = decrypt_fself(fself, klic);
-            if (fself.empty()) {
-                LOG_ERROR("Failed to decrypt self {}", fs_utils::path_to_utf8(entry.path().filename()));
-                continue;
-            }
+        // Decrypt the self, the selfs which didn't change since the last time come from the cache
+        fself = decrypt_fself_cached(fself, klic, cache_path);
+        if (fself.empty()) {
+            LOG_ERROR("Failed to decrypt self {}", fs_utils::path_to_utf8(self_path.filename()));
+            return;
+        }
 
-            // Write the decrypted self to the output path
-            const auto output_file_path = output_path / fs::relative(entry.path(), input_path);
-            fs::create_directories(output_file_path.parent_path());
-            fs::ofstream out(output_file_path, std::ios::binary);
-            if (!out) {
-                LOG_ERROR("Failed to write decrypted self {}", fs_utils::path_to_utf8(output_file_path));
-                continue;
-            }
-            out.write(reinterpret_cast<const char *>(fself.data()), fself.size());
-            const auto out_rel = fs::relative(output_file_path, cache_path);
-            LOG_INFO("Decrypted self to {}", fs_utils::path_to_utf8(out_rel));
+        // Write the decrypted self to the output path
+        const auto output_file_path = output_path / fs::relative(self_path, input_path);
+        boost::system::error_code error_code{};
+        fs::create_directories(output_file_path.parent_path(), error_code);
+        fs::ofstream out(output_file_path, std::ios::binary);
+        if (!out) {
+            LOG_ERROR("Failed to write decrypted self {}", fs_utils::path_to_utf8(output_file_path));
+            return;
         }
-    }
+        out.write(reinterpret_cast<const char *>(fself.data()), fself.size());
+        const auto out_rel = fs::relative(output_file_path, cache_path);
+        LOG_INFO("Decrypted self to {}", fs_utils::path_to_utf8(out_rel));
+    };
+
+    // the selfs are independent, a separate pool is used because their segments go to the segment pool
+    JobPool pool;
+    pool.start(static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 1U, 4U)));
+    std::vector<std::future<void>> results;
+    for (const auto &self_path : self_paths)
+        results.push_back(pool.submit([&] { decrypt_self(self_path); }));
+    for (auto &result : results)
+        result.wait();
 }
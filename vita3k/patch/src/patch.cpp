@@ -23,10 +23,62 @@
 #include <util/log.h>
 #include <util/string_utils.h>
 
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <utility>
+
+struct ParsedPatchFile {
+    std::time_t last_write_time = 0;
+    // every patch of the file with the header it is under, they are filtered for each binary
+    std::vector<std::pair<PatchHeader, Patch>> patches;
+};
+
+// the patch files are parsed again only when they change, a title loads many modules
+static std::mutex parsed_files_mutex;
+static std::map<fs::path, ParsedPatchFile> parsed_files;
+
+static void parse_patch_file(const fs::path &path, bool is_patchlist, ParsedPatchFile &parsed) {
+    parsed.patches.clear();
+
+    // Read the file
+    std::ifstream file(path.c_str());
+    PatchHeader patch_header = PatchHeader{
+        "",
+        "eboot.bin"
+    };
+
+    auto line_number = 0;
+    std::string line;
+    // Parse the file
+    while (std::getline(file, line)) {
+        line_number++;
+
+        // If this is a header, remember the binary the next patches are for
+        if (!line.empty() && line[0] == '[') {
+            patch_header = read_header(line, is_patchlist);
+            continue;
+        }
+
+        // Ignore comments
+        // And @ lines for now
+        if (line.empty() || line[0] == '#' || line[0] == '@')
+            continue;
+
+        try {
+            parsed.patches.emplace_back(patch_header, parse_patch(line));
+        } catch (std::exception &e) {
+            LOG_ERROR("Failed to parse patch line: {} [{}]", line_number, line);
+            LOG_ERROR("Failed with: {}", e.what());
+        }
+    }
+}
+
 std::vector<Patch> get_patches(fs::path &path, const std::string &titleid, const std::string &bin) {
     // Find a file in the path with the titleid
     std::vector<Patch> patches;
 
+    const std::lock_guard<std::mutex> guard(parsed_files_mutex);
     for (auto &entry : fs::directory_iterator(path)) {
         auto filename = fs_utils::path_to_utf8(entry.path().filename());
         // Just in case users decide to use lowercase filenames
@@ -35,36 +87,21 @@ std::vector<Patch> get_patches(fs::path &path, const std::string &titleid, const
         bool is_patchlist = filename.find("PATCHLIST.TXT") != std::string::npos;
 
         if ((filename.find(titleid) != std::string::npos && filename.ends_with(".TXT")) || is_patchlist) {
-            // Read the file
-            std::ifstream file(entry.path().c_str());
-            PatchHeader patch_header = PatchHeader{
-                "",
-                "eboot.bin"
-            };
-
-            auto line_number = 0;
-            std::string line;
-            // Parse the file
-            while (std::getline(file, line)) {
-                line_number++;
-
-                // If this is a header, remember the binary the next patches are for
-                if (!line.empty() && line[0] == '[') {
-                    patch_header = read_header(line, is_patchlist);
-                    continue;
-                }
+            boost::system::error_code error_code;
+            const std::time_t last_write_time = fs::last_write_time(entry.path(), error_code);
+
+            auto parsed = parsed_files.find(entry.path());
+            if (parsed == parsed_files.end() || parsed->second.last_write_time != last_write_time) {
+                parsed = parsed_files.try_emplace(entry.path()).first;
+                parsed->second.last_write_time = last_write_time;
+                parse_patch_file(entry.path(), is_patchlist, parsed->second);
+            }
 
-                // Ignore comments and patches for other binaries
-                // And @ lines for now
-                if (line.empty() || line[0] == '#' || line[0] == '@' || bin.find(patch_header.bin) == std::string::npos || (is_patchlist && patch_header.titleid != titleid))
+            // Ignore patches for other binaries
+            for (const auto &[patch_header, patch] : parsed->second.patches) {
+                if (bin.find(patch_header.bin) == std::string::npos || (is_patchlist && patch_header.titleid != titleid))
                     continue;
-
-                try {
-                    patches.push_back(parse_patch(line));
-                } catch (std::exception &e) {
-                    LOG_ERROR("Failed to parse patch line: {} [{}]", line_number, line);
-                    LOG_ERROR("Failed with: {}", e.what());
-                }
+                patches.push_back(patch);
             }
         }
     }
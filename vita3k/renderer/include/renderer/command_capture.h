@@ -0,0 +1,67 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <renderer/commands.h>
+#include <util/fs.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace renderer {
+
+struct GpuTimings;
+
+/**
+ * @brief Per frame statistics of the commands processed by the renderer
+ *
+ * For each captured frame, a line is written to a csv file with the number of commands of each opcode
+ * and the CPU time spent in their handlers, along with the GPU time when the renderer measures it.
+ * Captures of the same game scene can be compared to measure the effect of a renderer change.
+ */
+class CommandCapture {
+public:
+    bool start(const fs::path &path, uint32_t nb_frames);
+    bool is_active() const {
+        return file.is_open();
+    }
+
+    void record(CommandOpcode opcode, std::chrono::nanoseconds time) {
+        OpcodeStats &stats = frame_stats[static_cast<size_t>(opcode)];
+        stats.count++;
+        stats.time += time;
+    }
+
+    // write the line of the frame which just ended, the capture stops after the last frame
+    void end_frame(const GpuTimings *gpu_timings);
+
+private:
+    struct OpcodeStats {
+        uint32_t count = 0;
+        std::chrono::nanoseconds time{};
+    };
+
+    fs::ofstream file;
+    uint32_t frames_left = 0;
+    uint32_t frame_idx = 0;
+    std::array<OpcodeStats, COMMAND_OPCODE_COUNT> frame_stats;
+    std::chrono::steady_clock::time_point frame_start;
+};
+
+} // namespace renderer
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <vector>
@@ -30,6 +31,8 @@ struct Command;
 
 using CommandAllocFunc = std::function<Command *()>;
 using CommandFreeFunc = std::function<void(Command *)>;
+// release in one go a number of commands allocated by the context, in allocation order
+using CommandReleaseFunc = std::function<void(std::size_t)>;
 
 struct Context;
 struct State;
@@ -85,6 +88,8 @@ enum class CommandOpcode : std::uint8_t {
     DestroyContext
 };
 
+constexpr std::size_t COMMAND_OPCODE_COUNT = static_cast<std::size_t>(CommandOpcode::DestroyContext) + 1;
+
 enum CommandErrorCode {
     CommandErrorCodeNone = 0,
     CommandErrorCodePending = -1,
@@ -92,20 +97,39 @@ enum CommandErrorCode {
 };
 
 constexpr std::size_t MAX_COMMAND_DATA_SIZE = 0x20;
+// the commands allocated by the host are not limited by the size of the vdm buffer,
+// they carry bigger arguments (like the transfer images) in place of a pointer to a separate allocation
+constexpr std::size_t MAX_HOST_COMMAND_DATA_SIZE = 0x60;
 
 struct Command {
     enum {
+        // allocated as a HostCommand, deleted as soon as it has been processed
         FLAG_FROM_HOST = 1 << 0,
+        // owned by a buffer which is not released by the renderer
         FLAG_NO_FREE = 1 << 1
+        // otherwise the command belongs to the context allocator, see Context::release_func
     };
 
     CommandOpcode opcode;
     std::uint8_t flags = 0;
 
-    std::uint8_t data[MAX_COMMAND_DATA_SIZE];
     int *status;
 
     Command *next = nullptr;
+
+    // the data of a HostCommand goes on after the end of this array, so it must be the last member
+    alignas(8) std::uint8_t data[MAX_COMMAND_DATA_SIZE];
+
+    std::size_t data_capacity() const {
+        return (flags & FLAG_FROM_HOST) ? MAX_HOST_COMMAND_DATA_SIZE : MAX_COMMAND_DATA_SIZE;
+    }
+};
+
+static_assert(offsetof(Command, data) + MAX_COMMAND_DATA_SIZE == sizeof(Command));
+
+struct HostCommand {
+    Command command;
+    std::uint8_t extra_data[MAX_HOST_COMMAND_DATA_SIZE - MAX_COMMAND_DATA_SIZE];
 };
 
 using CommandPool = std::vector<Command>;
@@ -129,7 +153,7 @@ struct CommandHelper {
 
     template <typename T>
     bool push(T &val) {
-        if (point + sizeof(T) > MAX_COMMAND_DATA_SIZE) {
+        if (point + sizeof(T) > cmd->data_capacity()) {
             return false;
         }
 
@@ -141,7 +165,7 @@ struct CommandHelper {
 
     template <typename T>
     T pop() {
-        if (point + sizeof(T) > MAX_COMMAND_DATA_SIZE) {
+        if (point + sizeof(T) > cmd->data_capacity()) {
             // Shouldn't happen
             assert(false);
         }
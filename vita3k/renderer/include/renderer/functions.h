@@ -20,6 +20,8 @@
 #include <renderer/commands.h>
 #include <renderer/types.h>
 
+#include <functional>
+
 struct MemState;
 struct FeatureState;
 struct Config;
@@ -32,8 +34,9 @@ struct RenderTarget;
 struct State;
 struct VertexProgram;
 
-bool create(std::unique_ptr<FragmentProgram> &fp, State &state, const SceGxmProgram &program, const SceGxmBlendInfo *blend, GXPPtrMap &gxp_ptr_map);
-bool create(std::unique_ptr<VertexProgram> &vp, State &state, const SceGxmProgram &program, GXPPtrMap &gxp_ptr_map, const std::vector<SceGxmVertexAttribute> &attributes);
+// hash is the sha256 of the program
+bool create(std::unique_ptr<FragmentProgram> &fp, State &state, const SceGxmProgram &program, const Sha256Hash &hash, const SceGxmBlendInfo *blend, GXPPtrMap &gxp_ptr_map);
+bool create(std::unique_ptr<VertexProgram> &vp, State &state, const SceGxmProgram &program, const Sha256Hash &hash, GXPPtrMap &gxp_ptr_map, const std::vector<SceGxmVertexAttribute> &attributes);
 void create(SceGxmSyncObject *sync, State &state);
 void destroy(SceGxmSyncObject *sync, State &state);
 void finish(State &state, Context *context);
@@ -82,9 +85,9 @@ void set_visibility_index(State &state, Context *ctx, bool enable, uint32_t inde
 void set_context(State &state, Context *ctx, RenderTarget *target, SceGxmColorSurface *color_surface, SceGxmDepthStencilSurface *depth_stencil_surface);
 void set_vertex_stream(State &state, Context *ctx, const std::size_t index, const std::size_t data_len, const Ptr<const void> stream);
 void draw(State &state, Context *ctx, SceGxmPrimitiveType prim_type, SceGxmIndexFormat index_type, Ptr<const void> index_data, const std::uint32_t index_count, const std::uint32_t instance_count);
-void transfer_copy(State &state, uint32_t colorKeyValue, uint32_t colorKeyMask, SceGxmTransferColorKeyMode colorKeyMode, const SceGxmTransferImage *images, SceGxmTransferType srcType, SceGxmTransferType destType);
-void transfer_downscale(State &state, const SceGxmTransferImage *src, const SceGxmTransferImage *dest);
-void transfer_fill(State &state, uint32_t fillColor, const SceGxmTransferImage *dest);
+void transfer_copy(State &state, uint32_t colorKeyValue, uint32_t colorKeyMask, SceGxmTransferColorKeyMode colorKeyMode, const SceGxmTransferImage &src, const SceGxmTransferImage &dest, SceGxmTransferType srcType, SceGxmTransferType destType);
+void transfer_downscale(State &state, const SceGxmTransferImage &src, const SceGxmTransferImage &dest);
+void transfer_fill(State &state, uint32_t fillColor, const SceGxmTransferImage &dest);
 void sync_surface_data(State &state, Context *ctx, const SceGxmNotification vertex_notification, const SceGxmNotification fragment_notification);
 
 bool create_context(State &state, std::unique_ptr<Context> &context);
@@ -197,6 +200,27 @@ uint32_t decompress_compressed_texture(SceGxmTextureBaseFormat fmt, void *dest,
  */
 void decompress_bc_image(uint32_t width, uint32_t height, const uint8_t *block_storage, uint32_t *image, const uint8_t format_id);
 
+/**
+ * \brief Calls func(first_row, last_row) on ranges covering the block rows [0, block_count_y) of a texture.
+ *
+ * For large textures the ranges are processed by several threads at the same time.
+ *
+ * \param block_count_y     Number of block rows.
+ * \param block_count       Number of blocks of the texture.
+ * \param func              Function processing the block rows in [first_row, last_row).
+ */
+void for_each_block_rows(uint32_t block_count_y, uint32_t block_count, const std::function<void(uint32_t, uint32_t)> &func);
+
+/**
+ * \brief Compresses a 32-bit RGBA image to ETC2 RGBA8 blocks.
+ *
+ * \param width             Image width.
+ * \param height            Image height.
+ * \param image             Pointer to the pixels, laid out like the output of decompress_bc_image.
+ * \param block_storage     Pointer to the compressed blocks, 16 bytes per 4x4 block.
+ */
+void compress_etc2_rgba8_image(uint32_t width, uint32_t height, const uint32_t *image, uint8_t *block_storage);
+
 /**
  * \brief Try to decompress texture to 16-bit RGB floating point color.
  *
@@ -32,6 +32,8 @@ public:
 
     void insert();
     bool wait_for_signal();
+    // check without waiting if the GPU is done with the commands sent before the fence
+    bool is_signaled() const;
 
     bool empty() const {
         return !sync_;
@@ -20,6 +20,7 @@
 #include <glutil/object_array.h>
 #include <renderer/gl/fence.h>
 
+#include <array>
 #include <cstdint>
 #include <utility>
 
@@ -27,30 +28,45 @@ namespace renderer::gl {
 
 struct RingBuffer {
 private:
+    // the buffer is split in segments, a fence is inserted once the last draw call using a segment has been sent
+    // and it is waited for before the segment is written again
+    static constexpr std::size_t SEGMENT_COUNT = 4;
+
     GLObjectArray<1> buffer_;
-    Fence safe_segment_consumed_fence_;
+    std::array<Fence, SEGMENT_COUNT> segment_fences_;
+    // bitmask of the segments left since the last draw call, their fence can only be inserted once it has been sent
+    std::uint32_t segments_to_fence_;
 
     std::uint8_t *base_;
     std::size_t cursor_;
     std::size_t capacity_;
+    std::size_t segment_size_;
+    std::size_t current_segment_;
+    // number of allocations which had to wait for the GPU
+    std::uint32_t stall_count_;
 
     GLenum purpose_;
 
     void create_and_map();
+    void enter_segment(std::size_t segment);
 
 public:
     explicit RingBuffer(GLenum purpose, const std::size_t capacity);
     ~RingBuffer();
 
     // Allocate new data from ring buffer, return offset of the data resided in the buffer
-    // In case the data is full, it will wait for fence to notify previous draw commands has finished on previous buffer part
-    // and then reset the cursor
+    // When the data reaches a new segment, it will wait for the fence of the draw commands which used this segment last
+    // The data is written directly to the persistently mapped buffer
     std::pair<std::uint8_t *, std::size_t> allocate(const std::size_t data_size);
 
-    // Notify the buffer that a draw call is done. This inserts a fence depends on the amount of data that has been consumed
-    // previously by push
+    // Notify the buffer that a draw call is done. This inserts the fences of the segments the cursor has left
     void draw_call_done();
 
+    // number of allocations which had to wait for the GPU since the last call
+    std::uint32_t take_stall_count() {
+        return std::exchange(stall_count_, 0);
+    }
+
     GLint handle() const {
         return buffer_[0];
     }
@@ -24,6 +24,7 @@
 
 #include "types.h"
 
+#include <cstdint>
 #include <string_view>
 #include <vector>
 
@@ -34,6 +35,12 @@ struct GLState : public renderer::State {
     ShaderCache fragment_shader_cache;
     ShaderCache vertex_shader_cache;
     ProgramCache program_cache;
+    // hash of the driver the program binaries are saved for, 0 if the driver can't give program binaries
+    uint64_t program_binary_driver = 0;
+    PendingPrograms pending_programs;
+    // GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile
+    bool support_parallel_shader_compile = false;
+    bool async_compilation = false;
 
     GLTextureCache texture_cache;
     GLSurfaceCache surface_cache;
@@ -60,6 +67,8 @@ struct GLState : public renderer::State {
 
     std::string_view get_gpu_name() override;
 
+    void set_async_compilation(bool enable) override;
+
     void precompile_shader(const ShadersHash &hash) override;
     void preclose_action() override;
 };
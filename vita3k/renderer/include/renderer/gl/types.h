@@ -49,6 +49,15 @@ inline bool operator==(const ExcludedUniform &lhs, const ExcludedUniform &rhs) {
 typedef std::map<Sha256Hash, SharedGLObject> ShaderCache;
 typedef std::tuple<Sha256Hash, Sha256Hash> ProgramHashes;
 typedef std::map<ProgramHashes, SharedGLObject> ProgramCache;
+
+// program linked by the driver threads, the shaders are kept until its link is done
+struct PendingProgram {
+    SharedGLObject program;
+    SharedGLObject frag_shader;
+    SharedGLObject vert_shader;
+    bool save_binary;
+};
+typedef std::map<ProgramHashes, PendingProgram> PendingPrograms;
 typedef std::vector<ExcludedUniform> ExcludedUniforms; // vector instead of unordered_set since it's much faster for few elements
 typedef std::map<GLuint, GLenum> UniformTypes;
 
@@ -80,6 +89,11 @@ struct GLContext : public renderer::Context {
 
     GLObjectArray<SCE_GXM_MAX_VERTEX_STREAMS> stream_vertex_buffers;
     GLuint last_draw_program{ 0 };
+    // the vertex attribute formats set in the vertex array are the ones of this vertex program with this attribute layout
+    Sha256Hash vertex_format_program_hash{};
+    uint64_t vertex_format_key_hash{ 0 };
+    // bitmask of the attribute locations enabled in the vertex array
+    uint32_t enabled_vertex_attributes{ 0 };
     GLuint current_framebuffer{ 0 };
     GLuint current_color_attachment{ 0 };
     GLuint current_framebuffer_height{ 0 };
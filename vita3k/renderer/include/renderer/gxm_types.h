@@ -21,6 +21,7 @@
 #pragma once
 
 #include <mem/ptr.h>
+#include <util/hash.h>
 #include <util/types.h>
 
 #include <gxm/types.h>
@@ -294,6 +295,8 @@ struct SceGxmNotification {
 struct SceGxmRegisteredProgram {
     // TODO This is an opaque type.
     Ptr<const SceGxmProgram> program;
+    // the program can not change while it is registered, it is hashed once at its registration
+    Sha256Hash hash;
 };
 
 typedef Ptr<SceGxmRegisteredProgram> SceGxmShaderPatcherId;
@@ -0,0 +1,85 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/containers.h>
+#include <util/fs.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace renderer {
+
+/**
+ * @brief All the cached shaders of a folder packed in a single file
+ *
+ * The file is memory-mapped when opened so that a cached shader can be used without copying it.
+ * New shaders are appended at the end of the file, if the same name is found more than once, the last entry is used.
+ * The file is compacted when opened if most of it is made of such outdated entries.
+ */
+class ShaderPack {
+public:
+    ShaderPack() = default;
+    ShaderPack(const ShaderPack &) = delete;
+    ShaderPack &operator=(const ShaderPack &) = delete;
+    ~ShaderPack();
+
+    bool open(const fs::path &path);
+    void close();
+
+    // the returned view stays valid until the pack is closed, it is empty if the entry could not be found
+    std::span<const uint8_t> find(const std::string &name);
+    bool add(const std::string &name, const void *data, size_t size);
+    void for_each_entry(const std::function<void(const std::string &name, std::span<const uint8_t> data)> &callback);
+
+    // pack used for the shaders stored in this folder, opened the first time it is requested
+    static ShaderPack &get(const fs::path &folder);
+    // must be called before the folder is removed
+    static void close_folder(const fs::path &folder);
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    bool load(const fs::path &pack_path);
+    bool map_file();
+    void unmap_file();
+    void compact();
+
+    std::mutex mutex;
+    fs::path path;
+    const uint8_t *mapping = nullptr;
+    size_t mapping_size = 0;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+
+    // entries inside the mapped file
+    unordered_map_fast<std::string, Entry> entries;
+    // entries appended since the file was mapped, the vectors must not move so that views remain valid
+    unordered_map_stable<std::string, std::vector<uint8_t>> appended;
+};
+
+} // namespace renderer
@@ -18,8 +18,10 @@
 #pragma once
 
 #include <util/fs.h>
+#include <util/hash.h>
 
 #include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -38,9 +40,19 @@ struct State;
 // Shaders.
 bool get_shaders_cache_hashs(State &renderer);
 void save_shaders_cache_hashs(State &renderer, std::vector<ShadersHash> &shaders_cache_hashs);
-std::string load_glsl_shader(const SceGxmProgram &program, const FeatureState &features, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, bool shader_cache);
-std::vector<uint32_t> load_spirv_shader(const SceGxmProgram &program, const FeatureState &features, bool is_vulkan, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, bool shader_cache);
+// hash is the sha256 of the program, it names the shader in the cache
+std::string load_glsl_shader(const SceGxmProgram &program, const Sha256Hash &hash, const FeatureState &features, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, bool shader_cache);
+std::vector<uint32_t> load_spirv_shader(const SceGxmProgram &program, const Sha256Hash &hash, const FeatureState &features, bool is_vulkan, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, bool shader_cache);
 std::string pre_load_shader_glsl(const fs::path &shader_path);
 std::vector<uint32_t> pre_load_shader_spirv(const fs::path &shader_path);
+// look for the shader in the shader pack of its folder without copying it, the result is empty if it is not there
+std::span<const uint32_t> find_packed_shader_spirv(const fs::path &shader_path);
+// portable copy of the shader cache of the current app, which can be merged into the cache of another machine
+bool export_shader_cache(State &renderer, const fs::path &archive_path);
+// return true if the shader cache is not empty after the merge
+bool import_shader_cache(State &renderer, const fs::path &archive_path);
+// translate the GXP programs found in the binaries of an app which was never run and fill its shader cache with them,
+// return the number of shaders added to the cache
+uint32_t build_app_shader_cache(State &renderer, const std::vector<std::vector<uint8_t>> &binaries, const fs::path &shaders_path, const fs::path &shaders_log_path);
 
 } // namespace renderer
@@ -18,10 +18,13 @@
 #pragma once
 
 #include <features/state.h>
+#include <renderer/command_capture.h>
 #include <renderer/commands.h>
 #include <renderer/types.h>
-#include <threads/queue.h>
+#include <threads/ring_queue.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <string_view>
@@ -51,6 +54,46 @@ enum struct Filter : int {
     FSR = 1 << 4
 };
 
+// GPU time spent on a frame, measured with timestamp queries
+struct GpuTimings {
+    struct RenderTargetTimings {
+        uint16_t width;
+        uint16_t height;
+        uint32_t scene_count;
+        float time_ms;
+    };
+
+    float scene_ms = 0.0f;
+    float transfer_ms = 0.0f;
+    float surface_sync_ms = 0.0f;
+    // sorted by decreasing time
+    std::vector<RenderTargetTimings> render_targets;
+};
+
+// pipeline compilations during a frame, only filled by the Vulkan renderer
+struct PipelineStats {
+    // pipelines compiled on the render thread or sent to the compile threads
+    uint32_t sync_compiles = 0;
+    uint32_t async_compiles = 0;
+    // time the render thread spent compiling pipelines or waiting for the compile threads to finish one
+    float sync_compile_ms = 0.0f;
+    // time spent in retrieve_shader by all the threads
+    float shader_retrieve_ms = 0.0f;
+    // lookups of the pipelines and shader modules already created
+    uint32_t pipeline_hits = 0;
+    uint32_t pipeline_misses = 0;
+    uint32_t shader_hits = 0;
+    uint32_t shader_misses = 0;
+};
+
+// last frame which took longer than pipeline-stutter-threshold-ms
+struct Stutter {
+    float frame_ms = 0.0f;
+    // the pipeline compilations took most of the frame
+    bool caused_by_compilation = false;
+    PipelineStats pipeline_stats;
+};
+
 struct State {
     fs::path cache_path;
     fs::path log_path;
@@ -73,7 +116,7 @@ struct State {
     Context *context;
 
     GXPPtrMap gxp_ptr_map;
-    Queue<CommandList> command_buffer_queue;
+    RingQueue<CommandList> command_buffer_queue;
     std::condition_variable command_finish_one;
     std::mutex command_finish_one_mutex;
 
@@ -89,11 +132,59 @@ struct State {
     uint32_t shaders_count_compiled = 0;
     uint32_t programs_count_pre_compiled = 0;
 
+    // texture descriptor sets used during the last frame, only filled by the Vulkan renderer
+    std::atomic<uint32_t> descriptor_sets_allocated{ 0 };
+    std::atomic<uint32_t> descriptor_sets_pushed{ 0 };
+
+    // draws reading the color surface (programmable blending) during the last frame and the barriers
+    // or render pass restarts they needed, only filled by the Vulkan renderer
+    std::atomic<uint32_t> color_read_draws{ 0 };
+    std::atomic<uint32_t> color_read_barriers{ 0 };
+
+    // guest data copied to the GPU buffers during the last frame, only filled by the Vulkan renderer with the double buffer memory mapping
+    std::atomic<uint64_t> mapped_bytes_copied{ 0 };
+
+    // allocations of the streaming ring buffers which had to wait for the GPU during the last frame, only filled by the OpenGL renderer
+    std::atomic<uint32_t> ring_buffer_stalls{ 0 };
+
+    // GPU memory used by the surface cache and number of surfaces evicted to respect its budget, only filled by the Vulkan renderer
+    std::atomic<uint64_t> surface_cache_bytes{ 0 };
+    std::atomic<uint64_t> surface_cache_budget{ 0 };
+    std::atomic<uint32_t> surface_cache_evictions{ 0 };
+
+    // average time between the moment a game frame is picked for display and the moment it is shown on screen
+    // only available with the Vulkan renderer when VK_KHR_present_wait is supported, 0 otherwise
+    std::atomic<float> present_latency_ms{ 0.0f };
+    // GPU time of the screen filter, only measured along with the GPU timings
+    std::atomic<float> screen_filter_gpu_ms{ 0.0f };
+
+    // pipeline compilations of the last frame and last frame above the stutter threshold
+    std::mutex pipeline_stats_mutex;
+    PipelineStats pipeline_stats;
+    Stutter last_stutter;
+
+    // set by the performance overlay for each frame it needs the GPU timings of
+    std::atomic<bool> gpu_timings_requested{ false };
+    // GPU timings of the last frame read back, only filled by the Vulkan renderer
+    std::mutex gpu_timings_mutex;
+    GpuTimings gpu_timings;
+
+    // only started if renderer-capture-frames is set, once per run
+    CommandCapture command_capture;
+    bool command_capture_started = false;
+
     bool should_display;
+    // set with decouple-display-rate to the host refresh interval, process_batches then returns at least this often
+    // so that the last frame of the game is presented again at the host refresh rate
+    std::chrono::microseconds display_interval{ 0 };
+    // set with --headless, the frames are still rendered but never presented
+    bool headless = false;
 
     // only support disabled by default
     int supported_mapping_methods_mask = 1;
     MappingMethod mapping_method = MappingMethod::Disabled;
+    // with the page table mapping method, the mapped buffers are moved into the guest memory so that the page table is not needed
+    bool move_mapped_memory = false;
 
     // used for driver bug workaround
     bool is_adreno_stock = false;
@@ -153,6 +244,14 @@ struct State {
     virtual std::string_view get_gpu_name() = 0;
 
     virtual void precompile_shader(const ShadersHash &hash) = 0;
+    // number of pipelines saved during the previous runs which have not been created yet
+    virtual uint32_t get_pipelines_to_preload_count() {
+        return 0;
+    }
+    // create some of the pipelines saved during the previous runs, return false once all of them are done
+    virtual bool preload_pipelines() {
+        return false;
+    }
     virtual void preclose_action() = 0;
 
     virtual ~State() = default;
@@ -18,13 +18,17 @@
 #pragma once
 
 #include <gxm/types.h>
+#include <mem/util.h>
 #include <util/containers.h>
+#include <threads/job_pool.h>
 #include <util/fs.h>
 
 #include <array>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <string_view>
+#include <vector>
 
 namespace ddspp {
 struct Descriptor;
@@ -36,7 +40,8 @@ enum SceGxmTextureBaseFormat : uint32_t;
 
 namespace renderer {
 enum class Backend : uint32_t;
-static constexpr size_t TextureCacheSize = 1024;
+// maximum number of cached textures, the backend can also limit the memory they use with memory_budget
+static constexpr size_t TextureCacheSize = 4096;
 
 typedef std::array<uint32_t, 4> TextureGxmDataRepr;
 struct TextureCacheInfo {
@@ -44,11 +49,16 @@ struct TextureCacheInfo {
     SceGxmTexture texture;
     int index = 0;
     uint32_t texture_size = 0;
+    // memory used by the backend for this texture, see get_texture_memory_size
+    uint32_t memory_size = 0;
     bool use_hash = false;
-    // no need for it to be atomic
-    bool dirty = false;
+    // when the hash is not used, see track_writes
+    uint32_t write_sequence = 0;
     // used for texture importation
     bool is_imported = false;
+    // the replacement of this texture is being loaded, the original texture is used until it is ready
+    bool is_import_pending = false;
+    uint64_t pending_import_hash = 0;
     bool is_srgb = false;
     uint16_t width = 0;
     uint16_t height = 0;
@@ -67,6 +77,30 @@ struct AvailableTexture {
     std::shared_ptr<fs::path> folder_path;
 };
 
+// replacement texture read and decoded, this can be done by the import loader threads
+struct ImportedTexture {
+    bool is_dds = false;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint16_t mip_count = 1;
+    SceGxmTextureBaseFormat format;
+    bool is_srgb = false;
+    bool swap_rb = false;
+    // dds raw file
+    std::vector<uint8_t> raw_data;
+    // contain the decrypted header when loading dds
+    std::unique_ptr<ddspp::Descriptor> dds_descriptor;
+    // pointer to the decoded content, inside raw_data for dds, allocated by stb_image for png
+    uint8_t *decoded = nullptr;
+    // BC1/2/3 dds transcoded to ETC2, all the faces and mips in upload order
+    std::vector<uint8_t> transcoded_data;
+
+    ImportedTexture();
+    ImportedTexture(const ImportedTexture &) = delete;
+    ImportedTexture &operator=(const ImportedTexture &) = delete;
+    ~ImportedTexture();
+};
+
 class TextureCache {
 protected:
     // current texture info the cache is looking at
@@ -77,13 +111,9 @@ protected:
     // are we in the process of importing a texture
     bool importing_texture = false;
 
-    // dds/png raw file
-    std::vector<uint8_t> imported_texture_raw_data;
-    // pointer to the decoded content
-    uint8_t *imported_texture_decoded = nullptr;
-    // Info about the texture currently loading
-    AvailableTexture loading_texture;
-    // contain the decrypted header when loading dds
+    // replacement texture currently loading
+    std::shared_ptr<ImportedTexture> imported_texture;
+    // contain the decrypted header when exporting dds
     ddspp::Descriptor *dds_descriptor = nullptr;
     // file being written to when exporting dds
     fs::ofstream output_file;
@@ -95,6 +125,29 @@ protected:
     bool save_as_png = true;
     bool export_textures = false;
 
+    // replacement textures loaded in the background, see set_async_import
+    bool async_import = false;
+    JobPool import_pool;
+    // key = hash
+    unordered_map_fast<uint64_t, std::future<std::shared_ptr<ImportedTexture>>> pending_imports;
+
+    // read and decode a replacement file, only uses the support flags which do not change after init so that it can run on any thread
+    // return nullptr if there was an issue with the replacement texture
+    std::shared_ptr<ImportedTexture> load_imported_texture(uint64_t hash, const AvailableTexture &available, uint32_t nb_comp, bool is_cube) const;
+    // return the replacement texture if it is ready, set info->is_import_pending if it is still being loaded
+    // return nullptr if it is loading or it could not be loaded, the original texture is used in both cases
+    std::shared_ptr<ImportedTexture> get_imported_texture(TextureCacheInfo *info, const AvailableTexture &available);
+    // forget about the replacement being loaded for this texture
+    void cancel_pending_import(TextureCacheInfo *info);
+
+    // remove the texture from the cache, its slot can then be used by another texture
+    void evict(TextureCacheInfo *info);
+    // evict the least recently used textures until the memory budget is respected
+    void evict_over_budget();
+    // upload again only the rows of a hashless texture on the pages written since write_sequence
+    // return false if the texture can't be partially uploaded
+    bool upload_written_rows(const SceGxmTexture &gxm_texture, MemState &mem, Address range_begin, Address range_end, uint32_t texture_size, uint32_t write_sequence);
+
 public:
     Backend backend;
     bool use_protect = false;
@@ -105,6 +158,19 @@ public:
     // used to quickly get the info from a hash of a gxm_texture
     unordered_map_fast<TextureGxmDataRepr, TextureCacheInfo *> texture_lookup;
     lru::Queue<TextureCacheInfo> texture_queue;
+    uint32_t nb_textures = 0;
+
+    // if not 0, the least recently used textures are evicted so that the cached textures use at most this memory
+    uint64_t memory_budget = 0;
+    uint64_t memory_used = 0;
+
+    // texture cache statistics since init, see log_stats
+    uint64_t nb_hits = 0;
+    uint64_t nb_misses = 0;
+    uint64_t nb_evictions = 0;
+    uint64_t nb_partial_uploads = 0;
+    // guest texture data uploaded, the first mip of the full uploads and the rows of the partial ones
+    uint64_t upload_bytes = 0;
 
     // when use_sampler_cache is set to true, used to quickly get a cached sampler
     unordered_map_fast<uint32_t, SamplerCacheInfo *> sampler_lookup;
@@ -121,6 +187,9 @@ public:
     // hash of the textures that have already been exported
     unordered_set_fast<uint64_t> exported_textures_hash;
 
+    // folder where the textures transcoded to ETC2 are kept, so that they are only transcoded once
+    fs::path transcode_folder;
+
     // smartphone GPUs do not support DXT (BC1/2/3/4/5) textures, they must be decompressed on the GPU
     bool support_dxt = false;
     // format for replaced texture, supported mostly by smartphone GPUs
@@ -129,18 +198,34 @@ public:
     bool support_depth_linear_filtering = true;
     // powerVR only
     bool support_pvrt = false;
+    // supported by most smartphone GPUs
+    bool support_etc2 = false;
+    // when BCn textures are not supported, transcode BC1/2/3 textures to ETC2 instead of uploading them uncompressed
+    bool transcode_bcn_to_etc2 = false;
     // other color format
     bool support_x8d24 = false;
     bool support_e5rgb9 = false;
     bool support_a2rgb10 = false;
+    // the backend implements upload_texture_region_impl
+    bool support_partial_upload = false;
 
     bool init(const bool hashless_texture_cache, const fs::path &texture_folder, const std::string_view game_id, const size_t sampler_cache_size = 0);
     void set_replacement_state(bool import_textures, bool export_textures, bool export_as_png);
+    // read and decode the replacement textures on background threads instead of the render thread
+    void set_async_import(bool async_import);
+    // the texture is uploaded as SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8, see transcode_bcn_to_etc2
+    bool is_transcoded_to_etc2(SceGxmTextureBaseFormat base_format) const;
 
     virtual void select(size_t index, const SceGxmTexture &texture) = 0;
     virtual void configure_texture(const SceGxmTexture &texture) = 0;
     virtual void upload_texture_impl(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t height, uint32_t mip_index, const void *pixels, int face, uint32_t pixels_per_stride) = 0;
+    // upload rows [y, y + height) of the first mip, the other rows keep their content
+    virtual void upload_texture_region_impl(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t y, uint32_t height, const void *pixels, uint32_t pixels_per_stride) {}
     virtual void upload_done() {}
+    // memory used by the texture configured last
+    virtual uint32_t get_texture_memory_size() { return 0; }
+    // called when a texture is evicted, its resources can be freed
+    virtual void free_texture(size_t index) {}
 
     virtual void configure_sampler(size_t index, const SceGxmTexture &texture, bool no_linear) {}
 
@@ -150,6 +235,8 @@ public:
     // is called by cache_and_bind_texture if use_sampler_cache is set to true
     int cache_and_bind_sampler(const SceGxmTexture &gxm_texture, bool is_depth = false);
 
+    void log_stats() const;
+
     // look at the texture folder and update the available imported / exported hashes
     void refresh_available_textures();
 
@@ -158,8 +245,8 @@ public:
     void export_texture_impl(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t height, uint32_t mip_index, const void *pixels, int face, uint32_t pixels_per_stride);
     void export_done();
 
-    // return false if there was an issue with the replacement texture
-    bool import_configure_texture();
+    // functions used for texture importation, imported_texture must be set
+    void import_configure_texture();
     virtual void import_configure_impl(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t height, bool is_srgb, uint16_t nb_components, uint16_t mipcount, bool swap_rb) = 0;
     void import_upload_texture();
     void import_done();
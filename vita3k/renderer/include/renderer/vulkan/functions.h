@@ -46,6 +46,7 @@ void sync_clipping(VKContext &context);
 void sync_stencil_func(VKContext &context, const bool is_back);
 void sync_depth_bias(VKContext &context);
 void sync_depth_data(VKContext &context);
+void sync_extended_dynamic_state(VKContext &context);
 void sync_stencil_data(VKContext &context, const MemState &mem);
 void sync_point_line_width(VKContext &context, const bool is_front);
 void sync_texture(VKContext &context, MemState &mem, std::size_t index, SceGxmTexture texture, const Config &config);
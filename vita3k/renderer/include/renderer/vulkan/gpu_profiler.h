@@ -0,0 +1,98 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <renderer/vulkan/types.h>
+
+#include <array>
+#include <vector>
+
+namespace renderer::vulkan {
+
+struct VKState;
+
+/**
+ * @brief GPU time spent on each scene, measured with timestamp queries
+ *
+ * Each recorded scene writes a few timestamps around its prerender (transfers) part, its render part and the surface sync.
+ * The timestamps of a frame are read back when its frame object is used again, MAX_FRAMES_RENDERING frames later,
+ * at this point the GPU is done with them so this never waits.
+ */
+class GpuProfiler {
+public:
+    enum Timestamp : uint32_t {
+        PrerenderBegin,
+        PrerenderEnd,
+        RenderBegin,
+        SurfaceSyncBegin,
+        RenderEnd,
+        TimestampCount
+    };
+
+    // returned by begin_scene when the scene is not profiled
+    static constexpr uint32_t NO_SCENE = ~0U;
+
+    bool init(VKState &state);
+    void destroy(vk::Device device);
+
+    // read back the timestamps of the last frame which used this frame object then start using it again
+    void new_frame(VKState &state, int frame_idx, bool enable);
+
+    // reset the queries of a new scene in the prerender command buffer and write its first timestamps
+    uint32_t begin_scene(vk::CommandBuffer prerender_cmd, vk::CommandBuffer render_cmd, const VKRenderTarget *render_target, uint16_t width, uint16_t height);
+    void write_timestamp(vk::CommandBuffer cmd, uint32_t scene, Timestamp timestamp);
+
+    // true if the timings of the frame being recorded are requested
+    bool is_profiling() const {
+        return is_enabled;
+    }
+    // time between two timestamps read back from a query pool
+    float get_elapsed_ms(uint64_t begin, uint64_t end) const;
+
+private:
+    struct SceneInfo {
+        // only used to group the scenes, never dereferenced
+        const VKRenderTarget *render_target;
+        uint16_t width;
+        uint16_t height;
+    };
+
+    struct Frame {
+        vk::QueryPool query_pool;
+        std::vector<SceneInfo> scenes;
+    };
+
+    void collect(VKState &state, Frame &frame);
+
+    bool is_supported = false;
+    bool is_enabled = false;
+    // nanoseconds per tick
+    float timestamp_period = 1.0f;
+    uint64_t timestamp_mask = ~0ULL;
+
+    std::array<Frame, MAX_FRAMES_RENDERING> frames;
+    int current_frame_idx = 0;
+    std::vector<uint64_t> results;
+
+#ifdef TRACY_ENABLE
+    bool has_tracy_context = false;
+    uint16_t next_tracy_query = 0;
+#endif
+};
+
+} // namespace renderer::vulkan
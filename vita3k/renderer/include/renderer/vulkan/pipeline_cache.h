@@ -17,14 +17,24 @@
 
 #pragma once
 
-#include <blockingconcurrentqueue.h>
+#include <concurrentqueue.h>
+#include <lightweightsemaphore.h>
+#include <renderer/types.h>
+#include <threads/job_pool.h>
 #include <util/containers.h>
+#include <util/profile.h>
 #include <vkutil/vkutil.h>
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <limits>
 #include <map>
+#include <mutex>
+#include <optional>
 #include <set>
+#include <span>
+#include <vector>
 
 struct SceGxmProgram;
 struct SceGxmFragmentProgram;
@@ -39,15 +49,46 @@ struct Hints;
 }
 
 namespace renderer {
-
-struct GxmRecordState;
+struct PipelineStats;
 
 namespace vulkan {
 struct VKState;
 struct VKContext;
 struct CompileRequest;
 
-using PipelineCompileQueue = moodycamel::BlockingConcurrentQueue<CompileRequest *>;
+// Size of the record containing what is needed for the pipeline construction (what is after is dynamic state)
+constexpr size_t record_pipeline_len = offsetof(GxmRecordState, vertex_streams);
+
+// everything needed to create a pipeline once its shaders are loaded, without looking at the gxm programs
+// this is saved next to the pipeline cache so that the pipelines used by a game can be created again at boot
+struct PipelineDescription {
+    uint64_t key;
+    SceGxmPrimitiveType type;
+    // format used to retrieve a compatible render pass
+    vk::Format color_format;
+    bool use_shader_interlock;
+    bool is_fragment_disabled;
+    bool frag_has_no_output;
+    bool is_frag_color_used;
+    uint8_t vertex_texture_count;
+    uint8_t fragment_texture_count;
+    uint8_t binding_count;
+    uint8_t attribute_count;
+    vk::PipelineColorBlendAttachmentState blending;
+    std::array<vk::VertexInputBindingDescription, SCE_GXM_MAX_VERTEX_STREAMS> bindings;
+    // matrices used as attributes take more than one location
+    std::array<vk::VertexInputAttributeDescription, 32> attributes;
+
+    // the content of the record useful for the pipeline creation, this includes the shader hashes
+    alignas(8) uint8_t record_data[record_pipeline_len];
+
+    const GxmRecordState &get_record() const {
+        // note: this object is only half defined, but we are only looking at the part that's defined
+        return *reinterpret_cast<const GxmRecordState *>(record_data);
+    }
+};
+
+using PipelineCompileQueue = moodycamel::ConcurrentQueue<CompileRequest *>;
 
 class PipelineCache {
     friend struct VKState;
@@ -57,7 +98,7 @@ private:
 
     // are we performing pipeline compilation on a parallel thread?
     bool use_async_compilation = false;
-    // how many threads are used in case async compilation is enabled
+    // maximum number of threads used in case async compilation is enabled
     int nb_worker_threads = 0;
 
     // does the GPU support vertex attributes with 3 components (like R16G16B16_UNORM), some (like AMD GPUs) don't
@@ -84,27 +125,83 @@ private:
     std::map<vk::Format, vk::RenderPass> shader_interlock_pass;
 
     // only used when accessing the shaders map
-    std::mutex shaders_mutex;
+    PROFILE_LOCKABLE(std::mutex, shaders_mutex, "Shaders");
     // because of multithreading, we want the pointers to remain stable
     unordered_map_stable<Sha256Hash, vk::ShaderModule> shaders;
+    // every combination of shader, specialization constants and hints a module was retrieved for
+    // only used to report how many modules were not created thanks to a module being shared between variants
+    unordered_set_fast<uint64_t> shader_variants;
     unordered_map_stable<uint64_t, vk::Pipeline> pipelines;
 
+    // descriptions of all the pipelines created so far (or read from the disk), written by the compile threads
+    PROFILE_LOCKABLE(std::mutex, descriptions_mutex, "Pipeline descriptions");
+    unordered_map_fast<uint64_t, PipelineDescription> pipeline_descriptions;
+    // keys of the pipelines read from the disk which have not been preloaded yet
+    std::vector<uint64_t> pipelines_to_preload;
+
+    // while a pipeline is being compiled asynchronously, another pipeline made from the same shaders and vertex layout
+    // but for a different fixed-function state (blending, depth, stencil, culling) is used instead of skipping the draw
+    PROFILE_LOCKABLE(std::mutex, fallback_mutex, "Fallback pipelines");
+    unordered_map_fast<uint64_t, vk::Pipeline> fallback_pipelines;
+    void register_fallback_pipeline(uint64_t fallback_key, vk::Pipeline pipeline);
+    vk::Pipeline retrieve_fallback_pipeline(uint64_t fallback_key);
+
+    void read_pipeline_descriptions();
+    void save_pipeline_descriptions();
+    // keep the descriptions usable on this GPU which are not known yet and queue them for the preloading
+    void add_pipeline_descriptions(std::span<const PipelineDescription> descriptions);
+
     vk::PipelineShaderStageCreateInfo retrieve_shader(const SceGxmProgram *program, const Sha256Hash &hash, bool is_vertex, bool maskupdate, MemState &mem, const shader::Hints &hints, bool is_srgb = false);
     vk::PipelineVertexInputStateCreateInfo get_vertex_input_state(const SceGxmVertexProgram &vertex_program, MemState &mem);
 
-    // queue containing request sent by the main thread to the compile threads
-    PipelineCompileQueue pipeline_compile_queue;
-    moodycamel::ProducerToken pipeline_compile_queue_token;
+    // queues containing requests sent by the main thread to the compile threads
+    // the pipelines needed by the draws are compiled first, the ones preloaded from the disk only when nothing else is left
+    PipelineCompileQueue draw_compile_queue;
+    PipelineCompileQueue preload_compile_queue;
+    moodycamel::ProducerToken draw_compile_queue_token;
+    moodycamel::ProducerToken preload_compile_queue_token;
+    // counts the requests in both queues, the compile threads wait on it
+    moodycamel::LightweightSemaphore compile_requests_available;
+    std::atomic<int> pending_compile_requests = 0;
+
+    // the compile threads are started when the requests pile up, up to nb_worker_threads,
+    // and stop after being idle for a while, except the last one
+    PROFILE_LOCKABLE(std::mutex, compile_threads_mutex, "Pipeline compile threads");
+    int nb_compile_threads = 0;
+    void enqueue_compile_request(CompileRequest *request, bool is_preload);
+
+    // USSE to SPIR-V translation jobs, so that the vertex and fragment shaders of a pipeline are translated at the same time
+    JobPool shader_translation_pool;
 
     // each pipeline compiler thread uses this function as its entrypoint
     void compiler_thread(MemState &mem);
 
-    vk::Pipeline compile_pipeline(SceGxmPrimitiveType type, vk::RenderPass render_pass, const SceGxmVertexProgram &vertex_program_gxm, const SceGxmFragmentProgram &fragment_program_gxm, const GxmRecordState &record, const shader::Hints &hints, MemState &mem);
+    vk::Pipeline compile_pipeline(uint64_t key, SceGxmPrimitiveType type, vk::RenderPass render_pass, vk::Format color_format, const SceGxmVertexProgram &vertex_program_gxm, const SceGxmFragmentProgram &fragment_program_gxm, const GxmRecordState &record, const shader::Hints &hints, MemState &mem);
+    vk::Pipeline create_pipeline(const PipelineDescription &desc, vk::RenderPass render_pass, const vk::PipelineVertexInputStateCreateInfo &vertex_input, const vk::PipelineShaderStageCreateInfo *shader_stages);
+    // create the pipeline from its description only, using shader modules which are already loaded
+    vk::Pipeline preload_pipeline(const PipelineDescription &desc, vk::RenderPass render_pass, vk::ShaderModule vertex_module, vk::ShaderModule fragment_module);
 
 public:
     // if not 0, next time the pipeline cache should be saved (in seconds since epoch)
     uint64_t next_pipeline_cache_save = std::numeric_limits<uint64_t>::max();
 
+    // compilations of the current frame, see renderer::PipelineStats
+    // the compile threads add to them too, durations are in microseconds
+    struct FrameStats {
+        std::atomic<uint32_t> sync_compiles = 0;
+        std::atomic<uint32_t> async_compiles = 0;
+        std::atomic<uint64_t> sync_compile_us = 0;
+        std::atomic<uint64_t> shader_retrieve_us = 0;
+        std::atomic<uint32_t> pipeline_hits = 0;
+        std::atomic<uint32_t> pipeline_misses = 0;
+        std::atomic<uint32_t> shader_hits = 0;
+        std::atomic<uint32_t> shader_misses = 0;
+    };
+    FrameStats frame_stats;
+
+    // returns the statistics of the frame and starts the ones of the next frame
+    PipelineStats take_frame_stats();
+
     // modified by the surface cache, estimates if it is safe to use async pipeline compilation
     // (i.e that it does not causes permanent graphical issues)
     bool can_use_deferred_compilation;
@@ -125,11 +222,24 @@ public:
     void read_pipeline_cache();
     void save_pipeline_cache();
 
+    // pipeline part of a shader cache archive, the imported data is merged with what was read from the disk
+    std::vector<uint8_t> export_descriptions();
+    void import_descriptions(std::span<const uint8_t> data);
+    std::vector<uint8_t> export_pipeline_cache();
+    void import_pipeline_cache(std::span<const uint8_t> data);
+
     vk::RenderPass retrieve_render_pass(vk::Format format, bool force_load, bool force_store, bool is_color_transient, bool no_color = false);
     vk::Pipeline retrieve_pipeline(VKContext &context, SceGxmPrimitiveType &type, bool consider_for_async, MemState &mem);
 
     vk::ShaderModule precompile_shader(const Sha256Hash &hash, bool search_first = true);
 
+    size_t get_pipelines_to_preload_count() const {
+        return pipelines_to_preload.size();
+    }
+    // create the pipelines read from the disk (or send them to the compile threads if async compilation is enabled)
+    // for at most max_duration, returns false once there is nothing left to preload
+    bool preload_pipelines(std::chrono::milliseconds max_duration);
+
     void set_async_compilation(bool enable);
 };
 } // namespace vulkan
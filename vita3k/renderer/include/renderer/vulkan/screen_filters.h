@@ -143,6 +143,8 @@ private:
     vk::DescriptorSetLayout descriptor_set_layout;
     vk::DescriptorPool descriptor_pool;
     std::vector<vk::DescriptorSet> descriptor_sets;
+    // rcas reading the source image, used when it already has the output size
+    std::vector<vk::DescriptorSet> direct_descriptor_sets;
     vk::PipelineLayout pipeline_layout_easu;
     vk::PipelineLayout pipeline_layout_rcas;
     vk::Pipeline pipeline_easu;
@@ -21,7 +21,9 @@
 
 #include "screen_filters.h"
 
+#include <chrono>
 #include <memory>
+#include <string_view>
 
 struct SDL_Window;
 
@@ -69,6 +71,10 @@ public:
 
     vk::CommandBuffer current_cmd_buffer;
 
+    // timestamps before and after the screen filter of each swapchain image, for the GPU timings
+    vk::QueryPool filter_query_pool;
+    std::vector<bool> filter_timed;
+
     // these are used by the gui
     uint32_t swapchain_image_idx = ~0;
     // between 0 and swapchain_size - 1, used as the index for semaphores
@@ -76,11 +82,17 @@ public:
     // set to true after a window resize, in this case the pipeline needs to be rebuilt
     bool need_rebuild = false;
 
+    // id given to the last present with VK_KHR_present_id, reset with the swapchain
+    uint64_t present_id = 0;
+    // when the game frame rendered in the current swapchain image was taken, used for the latency stats
+    std::chrono::steady_clock::time_point frame_pickup_time;
+
     ScreenRenderer(VKState &state);
 
     bool create(SDL_Window *window);
     // called after the logical device has been created
-    bool setup();
+    // requested_present_mode is the value of the present-mode option, Auto or one of Fifo, Mailbox and Immediate
+    bool setup(std::string_view requested_present_mode);
     void cleanup();
 
     bool acquire_swapchain_image(bool start_render_pass = false);
@@ -99,5 +111,11 @@ private:
     void destroy_swapchain();
     bool rebuild_swapchain_if_visible();
     bool surface_matches_window_size();
+    void wait_for_previous_present();
+
+    // pickup time of the frame presented with present_id - 1
+    std::chrono::steady_clock::time_point previous_pickup_time;
+    float latency_sum_ms = 0.0f;
+    uint32_t latency_count = 0;
 };
 } // namespace renderer::vulkan
@@ -20,11 +20,14 @@
 #include <renderer/state.h>
 #include <renderer/types.h>
 
+#include <renderer/vulkan/gpu_profiler.h>
 #include <renderer/vulkan/pipeline_cache.h>
 #include <renderer/vulkan/screen_renderer.h>
 #include <renderer/vulkan/surface_cache.h>
 #include <renderer/vulkan/types.h>
 
+#include <threads/queue.h>
+
 struct Config;
 
 namespace renderer::vulkan {
@@ -41,12 +44,17 @@ struct Viewport {
 struct VKState : public renderer::State {
     MemState *mem;
 
+    // if not 0, the scenes are split and submitted every scene_chunk_draws draws
+    // so that the GPU can start working while the rest of the scene is recorded
+    uint32_t scene_chunk_draws = 0;
+
     // 0 = automatic, > 0 = order in instance.enumeratePhysicalDevices
     int gpu_idx;
 
     VKSurfaceCache surface_cache;
     PipelineCache pipeline_cache;
     VKTextureCache texture_cache;
+    GpuProfiler gpu_profiler;
 
     vk::Instance instance;
     vk::Device device;
@@ -70,6 +78,13 @@ struct VKState : public renderer::State {
     vk::Queue general_queue;
     vk::Queue transfer_queue;
 
+    // queue from a transfer only family, found on discrete GPUs
+    bool support_async_transfer = false;
+    // new textures are uploaded on the async transfer queue instead of the prerender command buffer
+    bool use_async_transfer = false;
+    uint32_t async_transfer_family_index = 0;
+    vk::Queue async_transfer_queue;
+
     // These might be merged into one queue, but for now they are different.
     vk::CommandPool general_command_pool;
     // Transfer pool has transient bit set.
@@ -82,6 +97,9 @@ struct VKState : public renderer::State {
     std::array<FrameObject, MAX_FRAMES_RENDERING> frames;
     // start at 1 because last_frame_waited is set to 0
     int current_frame_idx = 1;
+    // set with max-frames-in-flight, the frame objects are still reused every MAX_FRAMES_RENDERING frames
+    // but new_frame waits for the GPU to be at most this number of frames behind
+    int max_frames_in_flight = MAX_FRAMES_RENDERING;
 
     // vector of descriptor pools used for the frame descriptor, they are not really used anywhere
     // but it's better to keep a reference to them somewhere
@@ -104,6 +122,25 @@ struct VKState : public renderer::State {
     // support for the VK_KHR_uniform_buffer_standard_layout extension, needed for memory mapping and texture viewport
     bool support_standard_layout = false;
     bool support_rasterized_order_access = false;
+    // support for the VK_KHR_push_descriptor extension, used for the fragment textures
+    bool support_push_descriptor = false;
+    // support for the VK_EXT_memory_budget extension, used to size the texture cache
+    bool support_memory_budget = false;
+    // support for the VK_EXT_extended_dynamic_state extension, the cull, depth and stencil ops are then not part of the pipelines
+    bool support_extended_dynamic_state = false;
+    // support for the VK_KHR_present_id and VK_KHR_present_wait extensions, used to wait for the frames to be on screen
+    bool support_present_wait = false;
+
+    // texture descriptor sets used so far during the current frame
+    uint32_t frame_descriptor_sets_allocated = 0;
+    uint32_t frame_descriptor_sets_pushed = 0;
+    // draws reading the color surface so far during the current frame
+    uint32_t frame_color_read_draws = 0;
+    uint32_t frame_color_read_barriers = 0;
+
+    // frames taking longer than this are logged with their pipeline compilations, 0 to disable
+    uint32_t stutter_threshold_ms = 0;
+    std::chrono::steady_clock::time_point last_frame_start;
 
 #ifdef __ANDROID__
     bool support_android_buffer_import = false;
@@ -145,6 +182,8 @@ struct VKState : public renderer::State {
     uint32_t get_gpu_version() override;
 
     void precompile_shader(const ShadersHash &hash) override;
+    uint32_t get_pipelines_to_preload_count() override;
+    bool preload_pipelines() override;
     void preclose_action() override;
 #ifdef __ANDROID__
     bool support_custom_drivers() override;
@@ -23,6 +23,8 @@
 #include <util/containers.h>
 #include <vkutil/objects.h>
 
+#include <boost/container/flat_map.hpp>
+
 #include <optional>
 
 struct SwsContext;
@@ -51,6 +53,10 @@ struct SurfaceCacheInfo {
     SurfaceTiling tiling;
     // for d32s8 surfaces, this is the size of the depth part
     uint32_t total_bytes;
+    // GPU memory used by the surface and the images made from it
+    uint64_t allocated_bytes = 0;
+    // last frame this surface was rendered to or sampled from
+    uint64_t last_frame_used = 0;
 };
 
 struct Framebuffer {
@@ -163,16 +169,23 @@ private:
     // only have 20 color surfaces and 20 depth surfaces allocated at most at a given time
     static constexpr uint32_t max_surfaces_allowed = 20;
 
-    std::map<Address, ColorSurfaceCacheInfo *> color_address_lookup;
+    // surfaces do not overlap, so the surface containing an address is the one right before its upper bound
+    // there are at most max_surfaces_allowed entries, a sorted array is faster to search than a tree for this size
+    boost::container::flat_map<Address, ColorSurfaceCacheInfo *> color_address_lookup;
 
-    std::map<Address, DepthStencilSurfaceCacheInfo *> depth_address_lookup;
-    std::map<Address, DepthStencilSurfaceCacheInfo *> stencil_address_lookup;
+    boost::container::flat_map<Address, DepthStencilSurfaceCacheInfo *> depth_address_lookup;
+    boost::container::flat_map<Address, DepthStencilSurfaceCacheInfo *> stencil_address_lookup;
 
     // structure allowing to set the lru surface with a good complexity
     lru::Queue<ColorSurfaceCacheInfo> color_surface_queue;
     lru::Queue<DepthStencilSurfaceCacheInfo> ds_surface_queue;
 
-    std::map<std::pair<vk::ImageView, vk::ImageView>, Framebuffer> framebuffer_array;
+    // key = color view, depth-stencil view
+    typedef std::pair<VkImageView, VkImageView> FramebufferKey;
+    // the framebuffers are returned by reference, they must not move
+    unordered_map_stable<FramebufferKey, Framebuffer> framebuffer_array;
+    // framebuffers using each view, so that they can be destroyed without looking at all the other ones
+    unordered_map_fast<VkImageView, std::vector<FramebufferKey>> framebuffers_by_view;
 
     // used with check_for_surface
     // contains the addresses of the surfaces that are the target
@@ -189,11 +202,29 @@ private:
     void destroy_surface(ColorSurfaceCacheInfo &info);
     void destroy_surface(DepthStencilSurfaceCacheInfo &info);
 
+    // GPU memory the surfaces can use before the least recently used ones are evicted, 0 if there is no limit
+    uint64_t memory_budget = 0;
+    uint64_t allocated_bytes = 0;
+
+    // surface matching exactly the transfer image, if its content on the GPU is up to date and can be transferred
+    ColorSurfaceCacheInfo *find_transfer_surface(const SceGxmTransferImage &image);
+    // record the commands given by before_sync then a surface sync in a single time command buffer and submit it
+    // the command buffer is freed by the wait thread once it is done
+    void submit_surface_sync(ColorSurfaceCacheInfo &surface, const std::function<void(vk::CommandBuffer)> &before_sync);
+
+    void add_allocation(SurfaceCacheInfo &info, const vkutil::Image &image);
+    void mark_as_used(SurfaceCacheInfo &info);
+    // evict the surfaces which were not used for a few frames until the budget is respected
+    void enforce_memory_budget();
+
 public:
     // when creating a mutable image, can we pass as an argument
     // the possible format used for an image view to improve performance ?
     bool support_image_format_specifier = false;
 
+    // can we blit to BGRA8 images, used to swizzle surfaces on the GPU before their sync
+    bool support_bgra_blit = false;
+
     // can we protect mapped memory ?
     // On Windows this causes no issue, but according to my test
     // It only works with Nvidia drivers on Linux...
@@ -201,6 +232,8 @@ public:
 
     explicit VKSurfaceCache(VKState &state);
 
+    void set_memory_budget(uint64_t budget);
+
     SurfaceRetrieveResult retrieve_color_surface_for_framebuffer(MemState &mem, SceGxmColorSurface *color);
     std::optional<TextureLookupResult> retrieve_color_surface_as_texture(const SceGxmTexture &texture, const SceGxmColorBaseFormat base_format, TextureViewport *texture_viewport);
 
@@ -217,6 +250,14 @@ public:
     // so that subsequent calls to check_for_surface with the target destination also get delayed
     bool check_for_surface(MemState &mem, Address source_address, CallbackRequestFunction &callback, Address target_address);
 
+    // Perform on the GPU a transfer between two surfaces of the cache, then sync the destination back to the memory
+    // This avoids syncing the source and doing the transfer on the CPU
+    // Return false if the transfer can't be done this way, it must then be done on the CPU
+    bool transfer_copy(const SceGxmTransferImage &src, const SceGxmTransferImage &dst);
+    bool transfer_downscale(const SceGxmTransferImage &src, const SceGxmTransferImage &dst);
+    // only fills covering a whole rgba8 surface are done on the GPU
+    bool transfer_fill(const SceGxmTransferImage &dst, uint32_t fill_color);
+
     // If non-null, the return value must be sent as a PostSurfaceSyncRequest
     ColorSurfaceCacheInfo *perform_surface_sync();
 
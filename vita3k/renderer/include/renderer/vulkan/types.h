@@ -22,6 +22,10 @@
 #include <shader/uniform_block.h>
 #include <vkutil/objects.h>
 
+#include <chrono>
+#include <map>
+#include <vector>
+
 struct MemState;
 
 namespace renderer::vulkan {
@@ -30,11 +34,15 @@ struct VKState;
 struct VKRenderTarget;
 
 constexpr int MAX_FRAMES_RENDERING = 3;
-constexpr int NB_TEXTURE_STAGING_BUFFERS = 16;
+// the staging ring starts with this many buffers and grows instead of waiting for the GPU, up to the max
+constexpr int NB_TEXTURE_STAGING_BUFFERS = 4;
+constexpr int MAX_TEXTURE_STAGING_BUFFERS = 32;
+// staging buffers are at least this big so that multiple textures of a scene can be packed in one
+constexpr uint32_t TEXTURE_STAGING_BUFFER_MIN_SIZE = 2 * 1024 * 1024;
 
 struct TextureStagingBuffer {
     vkutil::Buffer buffer;
-    uint32_t used_so_far;
+    uint32_t used_so_far = 0;
     uint64_t scene_timestamp = ~0;
     uint64_t frame_timestamp = ~0;
     vk::Fence waiting_fence;
@@ -50,11 +58,16 @@ struct TextureCacheEntry {
 struct VKTextureCache : public TextureCache {
     VKState &state;
 
-    TextureStagingBuffer staging_buffers[NB_TEXTURE_STAGING_BUFFERS];
+    // used as a ring, in the order the buffers were last used
+    std::vector<TextureStagingBuffer> staging_buffers;
     uint32_t staging_idx = 0;
     uint64_t last_waited_scene = 0;
     uint64_t current_scene_timestamp;
 
+    // time the render thread spent waiting for a staging buffer to be available
+    uint64_t staging_stall_count = 0;
+    std::chrono::microseconds staging_stall_time{ 0 };
+
     std::array<TextureCacheEntry, TextureCacheSize> textures;
     std::vector<vk::Sampler> samplers;
 
@@ -62,16 +75,26 @@ struct VKTextureCache : public TextureCache {
     const SceGxmTexture *gxm_texture = nullptr;
     vk::CommandBuffer cmd_buffer = nullptr;
     bool is_texture_transfer_ready = false;
+    // the current texture is uploaded on the async transfer queue
+    bool is_async_upload = false;
 
     VKTextureCache(VKState &state);
-    // get an available staging buffer, wait for one if all are busy
-    void prepare_staging_buffer(bool is_configure = false);
+    // get an available staging buffer, add one to the ring or wait for one if all are busy
+    // the content of the texture is discarded unless keep_content is set
+    void prepare_staging_buffer(bool is_configure = false, bool keep_content = false);
+    // copy pixels to rows [y, y + height) of a mip of the current texture
+    void copy_to_texture(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t y, uint32_t height, uint32_t mip_index, const void *pixels, int face, uint32_t pixels_per_stride);
 
     bool init(const bool hashless_texture_cache, const fs::path &texture_folder, const std::string_view game_id);
     void select(size_t index, const SceGxmTexture &texture) override;
     void configure_texture(const SceGxmTexture &texture) override;
     void upload_texture_impl(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t height, uint32_t mip_index, const void *pixels, int face, uint32_t pixels_per_stride) override;
+    void upload_texture_region_impl(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t y, uint32_t height, const void *pixels, uint32_t pixels_per_stride) override;
     void upload_done() override;
+    uint32_t get_texture_memory_size() override {
+        return current_texture->memory_needed;
+    }
+    void free_texture(size_t index) override;
 
     void configure_sampler(size_t index, const SceGxmTexture &texture, bool no_linear) override;
 
@@ -92,6 +115,14 @@ struct FrameObject {
     // we need to have a specific prerender pool because prerender command buffer
     // can be reset if we use too many new textures at once
     vk::CommandPool prerender_pool;
+    // only created with async transfer, reset along the prerender pool
+    vk::CommandPool async_transfer_pool;
+    // signaled by the async transfers of this frame and waited for by its scenes
+    std::vector<vk::Semaphore> async_transfer_semaphores;
+    uint32_t async_transfer_semaphores_used = 0;
+    // set by the GPU at the end of the mid-scene flushes of this frame which have a notification
+    std::vector<vk::Event> notification_events;
+    uint32_t notification_events_used = 0;
 
     std::vector<vk::Fence> rendered_fences;
     // equals to context.frame_timestamp when the frame object is used
@@ -138,8 +169,10 @@ struct TrappedBuffer {
     uint32_t size;
     // used by the index buffer to keep the max index
     uint32_t extra;
-    // no need for it to be atomic
-    bool dirty = false;
+    // pages whose writes are tracked, see track_writes
+    Address tracked_addr = 0;
+    uint32_t tracked_size = 0;
+    uint32_t write_sequence = 0;
     uint8_t *mapped_location;
 
     TrappedBuffer() {}
@@ -154,9 +187,15 @@ struct BufferTrapping {
 
     VKState &state;
 
+    // guest data copied to the mapped buffers so far during the current frame
+    uint64_t frame_bytes_copied = 0;
+
     BufferTrapping(VKState &state);
     TrappedBuffer *access_buffer(Address addr, uint32_t size, MemState &mem, bool always_trap = false, bool cover_everything = false);
     void remove_range(Address start, Address end);
+
+private:
+    void copy_to_mapped(const TrappedBuffer &buffer, Address buffer_addr, Address addr, uint32_t size, MemState &mem);
 };
 
 // Use vulkan queries to implement visibility buffer
@@ -166,6 +205,8 @@ struct VisibilityBuffer {
     uint64_t buffer_offset;
     uint32_t size;
     vk::QueryPool query_pool;
+    // the query pool can be bigger than the buffer if it was used by another one before
+    uint32_t query_pool_size;
     std::vector<bool> queries_used; // the queries that were used in the current scene
 };
 
@@ -178,6 +219,12 @@ struct NotificationRequest {
     SceGxmNotification notifications[2];
 };
 
+// request to trigger a notification once the event set after a mid-scene flush is signaled
+struct EventNotificationRequest {
+    vk::Event event;
+    SceGxmNotification notification;
+};
+
 struct FrameDoneRequest {
     uint64_t frame_timestamp;
 };
@@ -212,6 +259,7 @@ struct BufferSyncRequest {
 typedef std::variant<
     FenceWaitRequest,
     NotificationRequest,
+    EventNotificationRequest,
     FrameDoneRequest,
     BufferSyncRequest,
     PostSurfaceSyncRequest,
@@ -251,12 +299,11 @@ struct VKContext : public renderer::Context {
     shader::RenderVertUniformBlockExtended curr_vert_ublock;
     shader::RenderFragUniformBlockExtended curr_frag_ublock;
 
-    // scratch memory to contain the constructed render info uniform before copying it
-    uint8_t shader_info_temp[std::max(shader::RenderVertUniformBlockExtended::get_max_size(), shader::RenderFragUniformBlockExtended::get_max_size())];
-
     // used to implement the Visibility Buffer
     std::map<Address, VisibilityBuffer> visibility_buffers;
     VisibilityBuffer *current_visibility_buffer = nullptr;
+    // query pools of the visibility buffers which were replaced, by number of queries
+    std::multimap<uint32_t, vk::QueryPool> free_query_pools;
     int visibility_max_used_idx = -1;
     bool is_in_query = false;
     int current_query_idx = -1;
@@ -276,6 +323,8 @@ struct VKContext : public renderer::Context {
     vk::DescriptorSet last_vert_texture_descriptor;
     uint16_t last_frag_texture_count = ~0;
     vk::DescriptorSet last_frag_texture_descriptor;
+    // the fragment textures pushed in the command buffer being recorded are still bound
+    bool frag_textures_pushed = false;
 
     VKRenderTarget *render_target = nullptr;
     vk::Viewport viewport;
@@ -298,10 +347,19 @@ struct VKContext : public renderer::Context {
     bool in_renderpass = false;
     bool refresh_pipeline = false;
     bool is_first_scene_draw = false;
+    // number of draws recorded since start_recording
+    uint32_t draws_in_recording = 0;
+    // id given by the GPU profiler to the scene being recorded
+    uint32_t profiled_scene = ~0U;
     // command buffer used to record the current scene
     vk::CommandBuffer render_cmd{};
     // command buffer used for commands that need to be executed before render_cmd (mostly because they can't be done during a render pass)
     vk::CommandBuffer prerender_cmd{};
+    // texture uploads recorded for the async transfer queue since the last submission
+    vk::CommandBuffer async_transfer_cmd{};
+    // semaphores of the async transfers the next submission on the general queue must wait for
+    std::vector<vk::Semaphore> async_transfer_waits;
+    std::vector<vk::PipelineStageFlags> async_transfer_wait_stages;
     // next fence to be used to wait for the current scene
     vk::Fence next_fence{};
     VKRenderTarget *cmd_target = nullptr;
@@ -312,6 +370,16 @@ struct VKContext : public renderer::Context {
     // special case where we can't determine the current macroblock
     bool ignore_macroblock = false;
 
+    // last values given to the extended dynamic state commands in the current command buffer
+    struct ExtendedDynamicState {
+        SceGxmCullMode cull_mode;
+        SceGxmDepthFunc depth_func;
+        SceGxmDepthWriteMode depth_write_mode;
+        GxmStencilStateOp front_stencil_op;
+        GxmStencilStateOp back_stencil_op;
+    } last_extended_dynamic_state;
+    bool is_extended_dynamic_state_valid = false;
+
     // used if necessary to restart easily the render pass
     vk::RenderPassBeginInfo curr_renderpass_info;
     // only useful if shader interlock is enabled, to know if we need to transition
@@ -335,6 +403,11 @@ struct VKContext : public renderer::Context {
     // check (when the render target has macroblock set) if we are drawing to another block
     void check_for_macroblock_change(bool is_draw);
 
+    // start the async transfer command buffer if this was not done since the last submission
+    vk::CommandBuffer get_async_transfer_cmd();
+    // submit cmdbuffers_to_submit on the general queue, after the async transfers they depend on
+    void submit_command_buffers(vk::Fence fence = nullptr);
+
 private:
     void wait_thread_function(const MemState &mem);
 };
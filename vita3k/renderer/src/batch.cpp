@@ -18,24 +18,31 @@
 #include <renderer/commands.h>
 #include <renderer/driver_functions.h>
 #include <renderer/functions.h>
+#include <renderer/profile.h>
 #include <renderer/state.h>
 #include <renderer/types.h>
 
 #include <renderer/vulkan/types.h>
 
 #include <config/state.h>
-#include <functional>
+#include <util/frame_timings.h>
 #include <util/log.h>
 
+#include <array>
+#include <chrono>
+
 struct FeatureState;
 
 namespace renderer {
 Command *generic_command_allocate() {
-    return new Command;
+    Command *cmd = &(new HostCommand)->command;
+    cmd->flags |= Command::FLAG_FROM_HOST;
+    return cmd;
 }
 
 void generic_command_free(Command *cmd) {
-    delete cmd;
+    // the command is the first member of the host command
+    delete reinterpret_cast<HostCommand *>(cmd);
 }
 
 void complete_command(State &state, CommandHelper &helper, const int code) {
@@ -68,58 +75,82 @@ static bool wait_cmd(MemState &mem, CommandList &command_list) {
 static void process_batch(renderer::State &state, const FeatureState &features, MemState &mem, Config &config, CommandList &command_list) {
     using CommandHandlerFunc = decltype(cmd_handle_set_context);
 
-    const static std::map<CommandOpcode, CommandHandlerFunc *> handlers = {
-        { CommandOpcode::SetContext, cmd_handle_set_context },
-        { CommandOpcode::SyncSurfaceData, cmd_handle_sync_surface_data },
-        { CommandOpcode::MidSceneFlush, cmd_handle_mid_scene_flush },
-        { CommandOpcode::CreateContext, cmd_handle_create_context },
-        { CommandOpcode::CreateRenderTarget, cmd_handle_create_render_target },
-        { CommandOpcode::MemoryMap, cmd_handle_memory_map },
-        { CommandOpcode::MemoryUnmap, cmd_handle_memory_unmap },
-        { CommandOpcode::Draw, cmd_handle_draw },
-        { CommandOpcode::TransferCopy, cmd_handle_transfer_copy },
-        { CommandOpcode::TransferDownscale, cmd_handle_transfer_downscale },
-        { CommandOpcode::TransferFill, cmd_handle_transfer_fill },
-        { CommandOpcode::Nop, cmd_handle_nop },
-        { CommandOpcode::SetState, cmd_handle_set_state },
-        { CommandOpcode::SignalSyncObject, cmd_handle_signal_sync_object },
-        { CommandOpcode::WaitSyncObject, cmd_handle_wait_sync_object },
-        { CommandOpcode::SignalNotification, cmd_handle_notification },
-        { CommandOpcode::NewFrame, cmd_new_frame },
-        { CommandOpcode::DestroyRenderTarget, cmd_handle_destroy_render_target },
-        { CommandOpcode::DestroyContext, cmd_handle_destroy_context }
-    };
-
-    Command *cmd = command_list.first;
+    static constexpr auto handlers = [] {
+        std::array<CommandHandlerFunc *, COMMAND_OPCODE_COUNT> table{};
+        table[static_cast<std::size_t>(CommandOpcode::SetContext)] = cmd_handle_set_context;
+        table[static_cast<std::size_t>(CommandOpcode::SyncSurfaceData)] = cmd_handle_sync_surface_data;
+        table[static_cast<std::size_t>(CommandOpcode::MidSceneFlush)] = cmd_handle_mid_scene_flush;
+        table[static_cast<std::size_t>(CommandOpcode::CreateContext)] = cmd_handle_create_context;
+        table[static_cast<std::size_t>(CommandOpcode::CreateRenderTarget)] = cmd_handle_create_render_target;
+        table[static_cast<std::size_t>(CommandOpcode::MemoryMap)] = cmd_handle_memory_map;
+        table[static_cast<std::size_t>(CommandOpcode::MemoryUnmap)] = cmd_handle_memory_unmap;
+        table[static_cast<std::size_t>(CommandOpcode::Draw)] = cmd_handle_draw;
+        table[static_cast<std::size_t>(CommandOpcode::TransferCopy)] = cmd_handle_transfer_copy;
+        table[static_cast<std::size_t>(CommandOpcode::TransferDownscale)] = cmd_handle_transfer_downscale;
+        table[static_cast<std::size_t>(CommandOpcode::TransferFill)] = cmd_handle_transfer_fill;
+        table[static_cast<std::size_t>(CommandOpcode::Nop)] = cmd_handle_nop;
+        table[static_cast<std::size_t>(CommandOpcode::SetState)] = cmd_handle_set_state;
+        table[static_cast<std::size_t>(CommandOpcode::SignalSyncObject)] = cmd_handle_signal_sync_object;
+        table[static_cast<std::size_t>(CommandOpcode::WaitSyncObject)] = cmd_handle_wait_sync_object;
+        table[static_cast<std::size_t>(CommandOpcode::SignalNotification)] = cmd_handle_notification;
+        table[static_cast<std::size_t>(CommandOpcode::NewFrame)] = cmd_new_frame;
+        table[static_cast<std::size_t>(CommandOpcode::DestroyRenderTarget)] = cmd_handle_destroy_render_target;
+        table[static_cast<std::size_t>(CommandOpcode::DestroyContext)] = cmd_handle_destroy_context;
+        return table;
+    }();
+
+    // commands from the context allocator are given back all at once when the list is done
+    std::size_t nb_to_release = 0;
 
     // Take a batch, and execute it. Hope it's not too large
-    do {
-        if (cmd == nullptr) {
-            break;
-        }
-
-        auto handler = handlers.find(cmd->opcode);
-        if (handler == handlers.end()) {
-            LOG_ERROR("Unimplemented command opcode {}", static_cast<int>(cmd->opcode));
+    Command *cmd = command_list.first;
+    while (cmd != nullptr) {
+        const std::size_t opcode = static_cast<std::size_t>(cmd->opcode);
+        CommandHandlerFunc *const handler = opcode < COMMAND_OPCODE_COUNT ? handlers[opcode] : nullptr;
+        if (handler == nullptr) {
+            LOG_ERROR("Unimplemented command opcode {}", opcode);
+        } else if (state.command_capture.is_active()) {
+            const auto start = std::chrono::steady_clock::now();
+            CommandHelper helper(cmd);
+            handler(state, mem, config, helper, features, command_list.context);
+            state.command_capture.record(cmd->opcode, std::chrono::steady_clock::now() - start);
+
+            if (cmd->opcode == CommandOpcode::NewFrame) {
+                // ask the Vulkan renderer to keep measuring the GPU time
+                state.gpu_timings_requested = true;
+                const std::lock_guard<std::mutex> guard(state.gpu_timings_mutex);
+                state.command_capture.end_frame(state.current_backend == Backend::Vulkan ? &state.gpu_timings : nullptr);
+            }
         } else {
             CommandHelper helper(cmd);
-            handler->second(state, mem, config, helper, features, command_list.context);
+            handler(state, mem, config, helper, features, command_list.context);
         }
 
         Command *last_cmd = cmd;
         cmd = cmd->next;
 
-        if (command_list.context) {
-            command_list.context->free_func(last_cmd);
-        } else {
+        if (last_cmd->flags & Command::FLAG_FROM_HOST)
             generic_command_free(last_cmd);
-        }
-    } while (true);
+        else if (!(last_cmd->flags & Command::FLAG_NO_FREE))
+            nb_to_release++;
+    }
+
+    if (nb_to_release > 0 && command_list.context)
+        command_list.context->release_func(nb_to_release);
 }
 
 void process_batches(renderer::State &state, const FeatureState &features, MemState &mem, Config &config) {
-    // always display a frame every 500ms
-    auto max_time = duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() + 500;
+    R_PROFILE(__func__);
+    const frame_timings::Scope timing(frame_timings::Stage::RenderCommands);
+
+    if (config.renderer_capture_frames > 0 && !state.command_capture_started) {
+        state.command_capture_started = true;
+        state.command_capture.start(state.log_path / "renderer_capture.csv", config.renderer_capture_frames);
+    }
+
+    // always display a frame every 500ms, or at the host refresh rate if it is decoupled from the game
+    const std::chrono::microseconds max_wait = state.display_interval.count() > 0 ? state.display_interval : std::chrono::milliseconds(500);
+    const auto max_time = std::chrono::steady_clock::now() + max_wait;
 
     while (!state.should_display) {
         // Try to wait for a batch (about 2 or 3ms, game should be fast for this)
@@ -135,8 +166,7 @@ void process_batches(renderer::State &state, const FeatureState &features, MemSt
                 return;
 
             if (!cmd_list || !wait_cmd(mem, *cmd_list)) {
-                auto curr_time = duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-                if (curr_time >= max_time)
+                if (std::chrono::steady_clock::now() >= max_time)
                     // display a frame even though the game is not diplaying anything
                     return;
 
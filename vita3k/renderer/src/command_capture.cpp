@@ -0,0 +1,98 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/command_capture.h>
+
+#include <renderer/state.h>
+
+#include <util/log.h>
+
+#include <fmt/format.h>
+
+namespace renderer {
+
+// must match the order of CommandOpcode
+static constexpr std::array<const char *, COMMAND_OPCODE_COUNT> OPCODE_NAMES = {
+    "create_context",
+    "create_render_target",
+    "memory_map",
+    "memory_unmap",
+    "draw",
+    "transfer_copy",
+    "transfer_downscale",
+    "transfer_fill",
+    "nop",
+    "set_state",
+    "set_context",
+    "sync_surface_data",
+    "mid_scene_flush",
+    "signal_sync_object",
+    "wait_sync_object",
+    "signal_notification",
+    "new_frame",
+    "destroy_render_target",
+    "destroy_context",
+};
+
+bool CommandCapture::start(const fs::path &path, uint32_t nb_frames) {
+    file.open(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open the renderer capture file {}", path);
+        return false;
+    }
+
+    std::string header = "frame,cpu_us,gpu_ms";
+    for (const char *name : OPCODE_NAMES)
+        header += fmt::format(",{}_count,{}_us", name, name);
+    file << header << '\n';
+
+    LOG_INFO("Capturing the renderer commands of {} frames to {}", nb_frames, path);
+    frames_left = nb_frames;
+    frame_idx = 0;
+    frame_stats = {};
+    frame_start = std::chrono::steady_clock::now();
+    return true;
+}
+
+void CommandCapture::end_frame(const GpuTimings *gpu_timings) {
+    if (!is_active())
+        return;
+
+    std::chrono::nanoseconds cpu_time{};
+    for (const OpcodeStats &stats : frame_stats)
+        cpu_time += stats.time;
+
+    // the GPU timings are read back a few frames after the frame they belong to
+    float gpu_ms = 0.0f;
+    if (gpu_timings)
+        gpu_ms = gpu_timings->scene_ms + gpu_timings->transfer_ms + gpu_timings->surface_sync_ms;
+
+    std::string line = fmt::format("{},{},{:.3f}", frame_idx, cpu_time.count() / 1000, gpu_ms);
+    for (const OpcodeStats &stats : frame_stats)
+        line += fmt::format(",{},{}", stats.count, stats.time.count() / 1000);
+    file << line << '\n';
+
+    frame_idx++;
+    frame_stats = {};
+    if (--frames_left == 0) {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - frame_start);
+        LOG_INFO("Renderer capture done, {} frames in {} ms", frame_idx, elapsed.count());
+        file.close();
+    }
+}
+
+} // namespace renderer
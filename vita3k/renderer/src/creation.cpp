@@ -28,6 +28,7 @@
 #include <gxm/functions.h>
 #include <renderer/functions.h>
 #include <util/align.h>
+#include <util/boot_trace.h>
 #include <util/log.h>
 #include <util/tracy.h>
 
@@ -175,7 +176,7 @@ COMMAND(handle_memory_unmap) {
 }
 
 // Client
-bool create(std::unique_ptr<FragmentProgram> &fp, State &state, const SceGxmProgram &program, const SceGxmBlendInfo *blend, GXPPtrMap &gxp_ptr_map) {
+bool create(std::unique_ptr<FragmentProgram> &fp, State &state, const SceGxmProgram &program, const Sha256Hash &hash, const SceGxmBlendInfo *blend, GXPPtrMap &gxp_ptr_map) {
     switch (state.current_backend) {
     case Backend::OpenGL:
         gl::create(fp, dynamic_cast<gl::GLState &>(state), program, blend);
@@ -190,8 +191,7 @@ bool create(std::unique_ptr<FragmentProgram> &fp, State &state, const SceGxmProg
         return false;
     }
 
-    // Try to hash this shader
-    fp->hash = sha256(&program, program.size);
+    fp->hash = hash;
     gxp_ptr_map.emplace(fp->hash, &program);
 
     fp->buffer_count = shader::usse::get_uniform_buffer_sizes(program, fp->uniform_buffer_sizes);
@@ -202,7 +202,7 @@ bool create(std::unique_ptr<FragmentProgram> &fp, State &state, const SceGxmProg
     return true;
 }
 
-bool create(std::unique_ptr<VertexProgram> &vp, State &state, const SceGxmProgram &program, GXPPtrMap &gxp_ptr_map, const std::vector<SceGxmVertexAttribute> &attributes) {
+bool create(std::unique_ptr<VertexProgram> &vp, State &state, const SceGxmProgram &program, const Sha256Hash &hash, GXPPtrMap &gxp_ptr_map, const std::vector<SceGxmVertexAttribute> &attributes) {
     switch (state.current_backend) {
     case Backend::OpenGL:
         gl::create(vp, dynamic_cast<gl::GLState &>(state), program);
@@ -217,8 +217,7 @@ bool create(std::unique_ptr<VertexProgram> &vp, State &state, const SceGxmProgra
         return false;
     }
 
-    // Hash this shader
-    vp->hash = sha256(&program, program.size);
+    vp->hash = hash;
     gxp_ptr_map.emplace(vp->hash, &program);
 
     vp->buffer_count = shader::usse::get_uniform_buffer_sizes(program, vp->uniform_buffer_sizes);
@@ -251,6 +250,7 @@ void destroy(SceGxmSyncObject *sync, State &state) {
 }
 
 bool init(SDL_Window *window, std::unique_ptr<State> &state, Backend backend, const Config &config, const Root &root_paths) {
+    const boot_trace::Span span("renderer::init");
     switch (backend) {
     case Backend::OpenGL:
         state = std::make_unique<gl::GLState>();
@@ -272,6 +272,7 @@ bool init(SDL_Window *window, std::unique_ptr<State> &state, Backend backend, co
     }
 
     state->current_backend = backend;
+    state->headless = config.headless;
 
     // Can change this
     state->command_buffer_queue.maxPendingCount_ = 30;
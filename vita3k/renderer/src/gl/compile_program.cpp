@@ -16,6 +16,7 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <renderer/profile.h>
+#include <renderer/shader_pack.h>
 #include <renderer/shaders.h>
 #include <renderer/types.h>
 
@@ -26,11 +27,37 @@
 
 #include <shader/spirv_recompiler.h>
 
+#include <cstring>
 #include <iomanip>
+#include <span>
 #include <vector>
 
+// GL_KHR_parallel_shader_compile is not part of the glad loader, the ARB extension uses the same value
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace renderer::gl {
-static SharedGLObject compile_glsl(GLenum type, const std::string &source) {
+static bool check_shader_status(GLuint shader) {
+    GLint log_length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+
+    // Intel driver returns an info log length of at least 1 even if it is empty.
+    if (log_length > 1) {
+        std::vector<GLchar> log;
+        log.resize(log_length);
+        glGetShaderInfoLog(shader, log_length, nullptr, log.data());
+
+        LOG_ERROR("{}", log.data());
+    }
+
+    GLint is_compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &is_compiled);
+    assert(is_compiled != GL_FALSE);
+    return is_compiled != GL_FALSE;
+}
+
+static SharedGLObject compile_glsl(GLenum type, const std::string &source, bool check_status) {
     R_PROFILE(__func__);
 
     SharedGLObject shader = std::make_shared<GLObject>();
@@ -44,29 +71,15 @@ static SharedGLObject compile_glsl(GLenum type, const std::string &source) {
 
     glCompileShader(shader->get());
 
-    GLint log_length = 0;
-    glGetShaderiv(shader->get(), GL_INFO_LOG_LENGTH, &log_length);
-
-    // Intel driver returns an info log length of at least 1 even if it is empty.
-    if (log_length > 1) {
-        std::vector<GLchar> log;
-        log.resize(log_length);
-        glGetShaderInfoLog(shader->get(), log_length, nullptr, log.data());
-
-        LOG_ERROR("{}", log.data());
-    }
-
-    GLint is_compiled = GL_FALSE;
-    glGetShaderiv(shader->get(), GL_COMPILE_STATUS, &is_compiled);
-    assert(is_compiled != GL_FALSE);
-    if (!is_compiled) {
+    // querying the compile status waits for the driver to be done with the shader
+    if (check_status && !check_shader_status(shader->get())) {
         return SharedGLObject();
     }
 
     return shader;
 }
 
-static SharedGLObject compile_spirv(GLenum type, const std::vector<std::uint32_t> &source) {
+static SharedGLObject compile_spirv(GLenum type, const std::vector<std::uint32_t> &source, bool check_status) {
     R_PROFILE(__func__);
 
     SharedGLObject shader = std::make_shared<GLObject>();
@@ -83,22 +96,8 @@ static SharedGLObject compile_spirv(GLenum type, const std::vector<std::uint32_t
     glShaderBinary(1, need_compile, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, source_glchar, length);
     glSpecializeShaderARB(need_compile[0], shader_entry, 0, nullptr, nullptr);
 
-    GLint log_length = 0;
-    glGetShaderiv(shader->get(), GL_INFO_LOG_LENGTH, &log_length);
-
-    // Intel driver returns an info log length of at least 1 even if it is empty.
-    if (log_length > 1) {
-        std::vector<GLchar> log;
-        log.resize(log_length);
-        glGetShaderInfoLog(shader->get(), log_length, nullptr, log.data());
-
-        LOG_ERROR("{}", log.data());
-    }
-
-    GLint is_compiled = GL_FALSE;
-    glGetShaderiv(shader->get(), GL_COMPILE_STATUS, &is_compiled);
-    assert(is_compiled != GL_FALSE);
-    if (!is_compiled) {
+    // querying the compile status waits for the driver to be done with the shader
+    if (check_status && !check_shader_status(shader->get())) {
         return SharedGLObject();
     }
 
@@ -116,16 +115,77 @@ static std::string convert_hash_to_hex(const Sha256Hash &hash) {
     return str;
 }
 
-static SharedGLObject compile_program(ProgramCache &program_cache, const SharedGLObject &frag_shader, const SharedGLObject &vert_shader, const ProgramHashes &hashes) {
+static std::string get_program_binary_name(const GLState &renderer, const ProgramHashes &hashes) {
+    return fmt::format("{}-{:016x}-{}-{}.bin", renderer.shader_version, renderer.program_binary_driver,
+        convert_hash_to_hex(std::get<0>(hashes)), convert_hash_to_hex(std::get<1>(hashes)));
+}
+
+// the program binaries are stored in the shader pack, each one is its format followed by the binary
+static SharedGLObject load_program_binary(GLState &renderer, const ProgramHashes &hashes) {
+    R_PROFILE(__func__);
+
+    if (!renderer.program_binary_driver)
+        return SharedGLObject();
+
+    const std::span<const std::uint8_t> binary = ShaderPack::get(renderer.shaders_path).find(get_program_binary_name(renderer, hashes));
+    if (binary.size() <= sizeof(GLenum))
+        return SharedGLObject();
+
     SharedGLObject program = std::make_shared<GLObject>();
     if (!program->init(glCreateProgram(), glDeleteProgram)) {
         return SharedGLObject();
     }
 
+    GLenum format;
+    memcpy(&format, binary.data(), sizeof(format));
+    glProgramBinary(program->get(), format, binary.data() + sizeof(format), static_cast<GLsizei>(binary.size() - sizeof(format)));
+
+    // the driver can still reject a binary, the program is then compiled from its shaders
+    GLint is_linked = GL_FALSE;
+    glGetProgramiv(program->get(), GL_LINK_STATUS, &is_linked);
+    if (is_linked == GL_FALSE) {
+        return SharedGLObject();
+    }
+
+    renderer.program_cache.emplace(hashes, program);
+
+    return program;
+}
+
+static void save_program_binary(GLState &renderer, GLuint program, const ProgramHashes &hashes) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<std::uint8_t> data(sizeof(GLenum) + length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, data.data() + sizeof(format));
+    memcpy(data.data(), &format, sizeof(format));
+
+    ShaderPack::get(renderer.shaders_path).add(get_program_binary_name(renderer, hashes), data.data(), data.size());
+}
+
+static SharedGLObject link_program(const SharedGLObject &frag_shader, const SharedGLObject &vert_shader, bool save_binary) {
+    SharedGLObject program = std::make_shared<GLObject>();
+    if (!program->init(glCreateProgram(), glDeleteProgram)) {
+        return SharedGLObject();
+    }
+
+    if (save_binary) {
+        glProgramParameteri(program->get(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glAttachShader(program->get(), frag_shader->get());
     glAttachShader(program->get(), vert_shader->get());
     glLinkProgram(program->get());
 
+    return program;
+}
+
+// check the result of the link and add the program to the cache
+static bool finish_program(GLState &renderer, const SharedGLObject &program, const SharedGLObject &frag_shader, const SharedGLObject &vert_shader, const ProgramHashes &hashes, bool save_binary) {
     GLint log_length = 0;
     glGetProgramiv(program->get(), GL_INFO_LOG_LENGTH, &log_length);
 
@@ -142,17 +202,54 @@ static SharedGLObject compile_program(ProgramCache &program_cache, const SharedG
     glGetProgramiv(program->get(), GL_LINK_STATUS, &is_linked);
     assert(is_linked != GL_FALSE);
     if (is_linked == GL_FALSE) {
-        return SharedGLObject();
+        return false;
     }
 
     glDetachShader(program->get(), frag_shader->get());
     glDetachShader(program->get(), vert_shader->get());
 
-    program_cache.emplace(hashes, program);
+    if (save_binary) {
+        save_program_binary(renderer, program->get(), hashes);
+    }
+
+    renderer.program_cache.emplace(hashes, program);
+
+    return true;
+}
+
+static SharedGLObject compile_program(GLState &renderer, const SharedGLObject &frag_shader, const SharedGLObject &vert_shader, const ProgramHashes &hashes, bool shader_cache) {
+    const bool save_binary = shader_cache && renderer.program_binary_driver;
+    const SharedGLObject program = link_program(frag_shader, vert_shader, save_binary);
+    if (!program || !finish_program(renderer, program, frag_shader, vert_shader, hashes, save_binary)) {
+        return SharedGLObject();
+    }
 
     return program;
 }
 
+// a program sent to the driver threads is only used once its link is done, the draws using it are skipped until then
+static SharedGLObject get_pending_program(GLState &renderer, PendingPrograms::iterator it, bool &is_compiling) {
+    GLint is_completed = GL_FALSE;
+    glGetProgramiv(it->second.program->get(), GL_COMPLETION_STATUS_KHR, &is_completed);
+    if (is_completed == GL_FALSE) {
+        is_compiling = true;
+        return SharedGLObject();
+    }
+
+    const ProgramHashes hashes = it->first;
+    const PendingProgram pending = std::move(it->second);
+    renderer.pending_programs.erase(it);
+
+    if (!finish_program(renderer, pending.program, pending.frag_shader, pending.vert_shader, hashes, pending.save_binary)) {
+        // the compile errors of the shaders were not checked yet
+        check_shader_status(pending.frag_shader->get());
+        check_shader_status(pending.vert_shader->get());
+        return SharedGLObject();
+    }
+
+    return pending.program;
+}
+
 static SharedGLObject compile_shader(const fs::path &shader_cache_path, const std::string &shader_version, const std::string &hash_hex,
     const char *type_str, const GLenum type, ShaderCache &cache, const Sha256Hash &hash) {
     // Set Shader version with hash
@@ -166,7 +263,7 @@ static SharedGLObject compile_shader(const fs::path &shader_cache_path, const st
     }
 
     // Compile Shader
-    SharedGLObject obj = compile_glsl(type, shader);
+    SharedGLObject obj = compile_glsl(type, shader, true);
     if (!obj) {
         LOG_CRITICAL("Error in compile {} shader:\n{}", type_str, hash_hex);
         return SharedGLObject();
@@ -189,6 +286,15 @@ static std::vector<ShadersHash>::iterator get_shaders_hash_index(std::vector<Sha
 
 void pre_compile_program(GLState &renderer, const ShadersHash &hash) {
     if (fs::exists(renderer.shaders_path) && !fs::is_empty(renderer.shaders_path)) {
+        const ProgramHashes hashes(hash.frag, hash.vert);
+
+        // Load the program binary saved by the previous run, if the driver is still the same
+        if (load_program_binary(renderer, hashes)) {
+            renderer.programs_count_pre_compiled++;
+            LOG_INFO("Program Loaded {}/{}", renderer.programs_count_pre_compiled, renderer.shaders_cache_hashs.size());
+            return;
+        }
+
         // Compile Fragment Shader
         const auto frag_hash_hex = convert_hash_to_hex(hash.frag);
         const SharedGLObject frag_shader = compile_shader(renderer.shaders_path, renderer.shader_version,
@@ -206,24 +312,23 @@ void pre_compile_program(GLState &renderer, const ShadersHash &hash) {
         }
 
         // Compile Program
-        const ProgramHashes hashes(hash.frag, hash.vert);
-        compile_program(renderer.program_cache, frag_shader, vert_shader, hashes);
+        compile_program(renderer, frag_shader, vert_shader, hashes, true);
         renderer.programs_count_pre_compiled++;
         LOG_INFO("Program Compiled {}/{}", renderer.programs_count_pre_compiled, renderer.shaders_cache_hashs.size());
     }
 }
 
 static SharedGLObject get_or_compile_shader(const SceGxmProgram *program, const FeatureState &features, const Sha256Hash &hash,
-    ShaderCache &cache, const GLenum type, const shader::Hints &hints, bool shader_cache, bool spirv, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, uint32_t &shaders_count_compiled) {
+    ShaderCache &cache, const GLenum type, const shader::Hints &hints, bool shader_cache, bool spirv, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, uint32_t &shaders_count_compiled, bool check_status) {
     const auto cached = cache.find(hash);
     if (cached == cache.end()) {
         SharedGLObject obj = nullptr;
 
         // Need to compile new one and add it to cache
         if (features.spirv_shader && spirv) {
-            obj = compile_spirv(type, load_spirv_shader(*program, features, false, hints, maskupdate, shader_cache_path, shader_log_path, shader_version + "spv", shader_cache));
+            obj = compile_spirv(type, load_spirv_shader(*program, hash, features, false, hints, maskupdate, shader_cache_path, shader_log_path, shader_version + "spv", shader_cache), check_status);
         } else {
-            obj = compile_glsl(type, load_glsl_shader(*program, features, hints, maskupdate, shader_cache_path, shader_log_path, shader_version, shader_cache));
+            obj = compile_glsl(type, load_glsl_shader(*program, hash, features, hints, maskupdate, shader_cache_path, shader_log_path, shader_version, shader_cache), check_status);
         }
 
         cache.emplace(hash, obj);
@@ -237,9 +342,11 @@ static SharedGLObject get_or_compile_shader(const SceGxmProgram *program, const
 }
 
 SharedGLObject compile_program(GLState &renderer, GLContext &context, const GxmRecordState &state, const FeatureState &features, const MemState &mem,
-    bool shader_cache, bool spirv, bool maskupdate) {
+    bool shader_cache, bool spirv, bool maskupdate, bool &is_compiling) {
     R_PROFILE(__func__);
 
+    is_compiling = false;
+
     assert(state.fragment_program);
     assert(state.vertex_program);
 
@@ -260,15 +367,30 @@ SharedGLObject compile_program(GLState &renderer, GLContext &context, const GxmR
         return cached->second;
     }
 
+    const PendingPrograms::iterator pending = renderer.pending_programs.find(hashes);
+    if (pending != renderer.pending_programs.end()) {
+        return get_pending_program(renderer, pending, is_compiling);
+    }
+
+    if (shader_cache) {
+        const SharedGLObject program = load_program_binary(renderer, hashes);
+        if (program) {
+            return program;
+        }
+    }
+
     // No... It doesn't exist. Now we try to find each object. If it doesn't exist then we can kind
     // of compile it again.
 
+    // with parallel shader compile, the driver compiles and links on its own threads as long as the result is not queried
+    const bool compile_async = renderer.async_compilation && renderer.support_parallel_shader_compile;
+
     // update the hints
     context.shader_hints.color_format = state.color_surface.colorFormat;
     context.shader_hints.attributes = &vertex_program_gxm.attributes;
 
     const SharedGLObject fragment_shader = get_or_compile_shader(fragment_program_gxm.program.get(mem), features, fragment_program.hash, renderer.fragment_shader_cache,
-        GL_FRAGMENT_SHADER, context.shader_hints, shader_cache, spirv, maskupdate, renderer.shaders_path, renderer.shaders_log_path, renderer.shader_version, renderer.shaders_count_compiled);
+        GL_FRAGMENT_SHADER, context.shader_hints, shader_cache, spirv, maskupdate, renderer.shaders_path, renderer.shaders_log_path, renderer.shader_version, renderer.shaders_count_compiled, !compile_async);
 
     if (!fragment_shader) {
         LOG_CRITICAL("Error in get/compile fragment vertex shader:\n{}", hex_string(fragment_program.hash));
@@ -276,14 +398,24 @@ SharedGLObject compile_program(GLState &renderer, GLContext &context, const GxmR
     }
 
     const SharedGLObject vertex_shader = get_or_compile_shader(vertex_program_gxm.program.get(mem), features, vertex_program.hash, renderer.vertex_shader_cache,
-        GL_VERTEX_SHADER, context.shader_hints, shader_cache, spirv, maskupdate, renderer.shaders_path, renderer.shaders_log_path, renderer.shader_version, renderer.shaders_count_compiled);
+        GL_VERTEX_SHADER, context.shader_hints, shader_cache, spirv, maskupdate, renderer.shaders_path, renderer.shaders_log_path, renderer.shader_version, renderer.shaders_count_compiled, !compile_async);
 
     if (!vertex_shader) {
         LOG_CRITICAL("Error in get/compiled vertex shader:\n{}", hex_string(vertex_program.hash));
         return SharedGLObject();
     }
 
-    SharedGLObject program = compile_program(renderer.program_cache, fragment_shader, vertex_shader, hashes);
+    SharedGLObject program;
+    if (compile_async) {
+        const bool save_binary = shader_cache && renderer.program_binary_driver;
+        const SharedGLObject linking_program = link_program(fragment_shader, vertex_shader, save_binary);
+        if (linking_program) {
+            renderer.pending_programs.emplace(hashes, PendingProgram{ linking_program, fragment_shader, vertex_shader, save_binary });
+            is_compiling = true;
+        }
+    } else {
+        program = compile_program(renderer, fragment_shader, vertex_shader, hashes, shader_cache);
+    }
 
     // Save shader cache haches
     const auto shader_cache_hash_index = get_shaders_hash_index(renderer.shaders_cache_hashs, fragment_program.hash, vertex_program.hash);
@@ -43,11 +43,21 @@ void Fence::insert() {
     }
 
     sync_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    signaled_ = false;
     if (!sync_) {
         LOG_ERROR("Unable to create fence sync object!");
     }
 }
 
+bool Fence::is_signaled() const {
+    if (!sync_)
+        return true;
+
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(sync_, GL_SYNC_STATUS, 1, nullptr, &status);
+    return status == GL_SIGNALED;
+}
+
 bool Fence::wait_for_signal() {
     if (signaled_) {
         if (sync_) {
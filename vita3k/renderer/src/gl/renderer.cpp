@@ -32,9 +32,11 @@
 
 #include <gxm/functions.h>
 #include <gxm/types.h>
+#include <util/frame_timings.h>
 #include <util/log.h>
 
 #include <SDL3/SDL_video.h>
+#include <xxhash.h>
 
 #include <array>
 #include <mutex>
@@ -236,7 +238,9 @@ bool create(SDL_Window *window, std::unique_ptr<State> &state, const Config &con
         { "GL_EXT_shader_framebuffer_fetch", &gl_state.features.direct_fragcolor },
         { "GL_ARB_gl_spirv", &gl_state.features.spirv_shader },
         { "GL_ARB_get_texture_sub_image", &gl_state.features.support_get_texture_sub_image },
-        { "GL_EXT_shader_image_load_formatted", &gl_state.features.support_unknown_format }
+        { "GL_EXT_shader_image_load_formatted", &gl_state.features.support_unknown_format },
+        { "GL_KHR_parallel_shader_compile", &gl_state.support_parallel_shader_compile },
+        { "GL_ARB_parallel_shader_compile", &gl_state.support_parallel_shader_compile }
     };
 
     for (int i = 0; i < total_extensions; i++) {
@@ -249,6 +253,15 @@ bool create(SDL_Window *window, std::unique_ptr<State> &state, const Config &con
         }
     }
 
+    GLint program_binary_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &program_binary_formats);
+    if (program_binary_formats > 0) {
+        // a program binary can only be used by the driver it was made with
+        const char *gl_vendor = reinterpret_cast<const char *>(glGetString(GL_VENDOR));
+        const std::string driver = fmt::format("{}|{}|{}", gl_vendor ? gl_vendor : "Unknown", state->get_gpu_name(), gl_version);
+        gl_state.program_binary_driver = XXH3_64bits(driver.data(), driver.size());
+    }
+
     if (gl_state.features.direct_fragcolor) {
         LOG_INFO("Your GPU supports direct access to last fragment color. Your performance with programmable blending games will be optimized.");
     } else if (gl_state.features.support_shader_interlock) {
@@ -284,6 +297,7 @@ bool GLState::init() {
 
 void GLState::late_init(const Config &cfg, const std::string_view game_id, MemState &mem) {
     texture_cache.init(true, texture_folder(), game_id);
+    texture_cache.set_async_import(cfg.async_texture_import);
 }
 
 bool create(std::unique_ptr<Context> &context) {
@@ -662,6 +676,12 @@ void get_surface_data(GLState &renderer, GLContext &context, uint32_t *pixels, S
     glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 }
 
+void new_frame(GLState &state, GLContext &context) {
+    state.ring_buffer_stalls = context.vertex_stream_ring_buffer.take_stall_count() + context.index_stream_ring_buffer.take_stall_count()
+        + context.vertex_uniform_stream_ring_buffer.take_stall_count() + context.fragment_uniform_stream_ring_buffer.take_stall_count()
+        + context.vertex_info_uniform_buffer.take_stall_count() + context.fragment_info_uniform_buffer.take_stall_count();
+}
+
 void GLState::render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &viewport_size, DisplayState &display,
     const GxmState &gxm, MemState &mem) {
     should_display = false;
@@ -672,7 +692,7 @@ void GLState::render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &v
         frame = display.next_rendered_frame;
     }
 
-    if (!frame.base)
+    if (!frame.base || headless)
         return;
 
     // Check if the surface exists
@@ -726,7 +746,10 @@ void GLState::render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &v
 }
 
 void GLState::swap_window(SDL_Window *window) {
-    SDL_GL_SwapWindow(window);
+    if (!headless) {
+        const frame_timings::Scope timing(frame_timings::Stage::PresentWait);
+        SDL_GL_SwapWindow(window);
+    }
 }
 
 std::vector<uint32_t> GLState::dump_frame(DisplayState &display, uint32_t &width, uint32_t &height) {
@@ -768,6 +791,11 @@ int GLState::get_max_2d_texture_width() {
     return static_cast<int>(max_texture_size);
 }
 
+void GLState::set_async_compilation(bool enable) {
+    // the programs already sent to the driver are still finished on their next draw
+    async_compilation = enable;
+}
+
 std::string_view GLState::get_gpu_name() {
     const char *gl_renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
     gl_renderer = gl_renderer ? gl_renderer : "Unknown";
@@ -22,12 +22,18 @@
 #include <util/align.h>
 #include <util/log.h>
 
+#include <algorithm>
+
 namespace renderer::gl {
 
 RingBuffer::RingBuffer(GLenum purpose, const std::size_t capacity)
-    : base_(nullptr)
+    : segments_to_fence_(0)
+    , base_(nullptr)
     , cursor_(0)
     , capacity_(capacity)
+    , segment_size_(capacity / SEGMENT_COUNT)
+    , current_segment_(0)
+    , stall_count_(0)
     , purpose_(purpose) {
     buffer_.init(glGenBuffers, glDeleteBuffers);
 }
@@ -54,6 +60,25 @@ void RingBuffer::create_and_map() {
     }
 }
 
+void RingBuffer::enter_segment(const std::size_t segment) {
+    segments_to_fence_ |= 1U << current_segment_;
+    current_segment_ = segment;
+
+    if (segments_to_fence_ & (1U << segment)) {
+        LOG_ERROR("A single draw call uses more data than the size of the ring buffer!");
+        glFinish();
+        return;
+    }
+
+    Fence &fence = segment_fences_[segment];
+    if (fence.empty())
+        return;
+
+    if (!fence.is_signaled())
+        stall_count_++;
+    fence.wait_for_signal();
+}
+
 std::pair<std::uint8_t *, std::size_t> RingBuffer::allocate(const std::size_t data_size) {
     if (!base_) {
         create_and_map();
@@ -63,28 +88,29 @@ std::pair<std::uint8_t *, std::size_t> RingBuffer::allocate(const std::size_t da
     }
 
     std::size_t offset = align(cursor_, 256);
-
-    if ((offset + data_size) >= capacity_) {
-        if (!safe_segment_consumed_fence_.empty()) {
-            safe_segment_consumed_fence_.wait_for_signal();
-        } else {
-            LOG_ERROR("Sync fence has not been inserted but the size of the ring buffer has already reached full!");
-            glFinish();
-        }
-
+    const bool wrap = (offset + data_size) >= capacity_;
+    if (wrap)
         offset = 0;
-        cursor_ = 0;
-    }
+
+    // wait for the GPU to be done with each segment the data is written to
+    const std::size_t first_segment = offset / segment_size_;
+    const std::size_t last_segment = std::min((offset + std::max<std::size_t>(data_size, 1) - 1) / segment_size_, SEGMENT_COUNT - 1);
+    if (wrap || first_segment != current_segment_)
+        enter_segment(first_segment);
+    for (std::size_t segment = first_segment + 1; segment <= last_segment; segment++)
+        enter_segment(segment);
 
     cursor_ = align(offset + data_size, 256);
     return std::make_pair(base_ + offset, offset);
 }
 
 void RingBuffer::draw_call_done() {
-    // Insert a fence when the buffer has been consumed about 25% (same as RPCS3)
-    if (safe_segment_consumed_fence_.empty() && (cursor_ >= (capacity_ >> 2))) {
-        safe_segment_consumed_fence_.insert();
+    // the draw calls using the segments left have all been sent now
+    for (std::size_t segment = 0; segment < SEGMENT_COUNT; segment++) {
+        if (segments_to_fence_ & (1U << segment))
+            segment_fences_[segment].insert();
     }
+    segments_to_fence_ = 0;
 }
 
 } // namespace renderer::gl
@@ -31,6 +31,7 @@
 
 #include <shader/spirv_recompiler.h>
 
+#include <bit>
 #include <cmath>
 
 namespace renderer::gl {
@@ -473,7 +474,10 @@ void sync_vertex_streams_and_attributes(GLContext &context, GxmRecordState &stat
         }
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, context.vertex_stream_ring_buffer.handle());
+    // the attribute formats stay in the vertex array, only the buffer offsets change between the draws using the same vertex program
+    // each location has its own binding so the attribute offset can go in the binding offset
+    const bool update_format = glvert->hash != context.vertex_format_program_hash || vertex_program.key_hash != context.vertex_format_key_hash;
+    uint32_t enabled_attributes = 0;
 
     for (const SceGxmVertexAttribute &attribute : vertex_program.attributes) {
         if (!glvert->attribute_infos.contains(attribute.regIndex))
@@ -543,21 +547,42 @@ void sync_vertex_streams_and_attributes(GLContext &context, GxmRecordState &stat
         const std::uint16_t stream_index = attribute.streamIndex;
 
         for (uint32_t i = 0; i < array_size; i++) {
-            if (upload_integral || (attribute.format == SCE_GXM_ATTRIBUTE_FORMAT_UNTYPED)) {
-                glVertexAttribIPointer(attrib_location + i, component_count, type, stream.stride, reinterpret_cast<const GLvoid *>(i * array_element_size + attribute.offset + offset_in_buffer[stream_index]));
-            } else {
-                glVertexAttribPointer(attrib_location + i, component_count, type, normalized, stream.stride, reinterpret_cast<const GLvoid *>(i * array_element_size + attribute.offset + offset_in_buffer[stream_index]));
+            const GLuint location = attrib_location + i;
+            if (update_format) {
+                if (upload_integral || (attribute.format == SCE_GXM_ATTRIBUTE_FORMAT_UNTYPED)) {
+                    glVertexAttribIFormat(location, component_count, type, 0);
+                } else {
+                    glVertexAttribFormat(location, component_count, type, normalized, 0);
+                }
+
+                glVertexAttribBinding(location, location);
+
+                if (gxm::is_stream_instancing(static_cast<SceGxmIndexSource>(stream.indexSource))) {
+                    glVertexBindingDivisor(location, 1);
+                } else {
+                    glVertexBindingDivisor(location, 0);
+                }
+
+                enabled_attributes |= 1U << location;
             }
 
-            glEnableVertexAttribArray(attrib_location + i);
+            glBindVertexBuffer(location, context.vertex_stream_ring_buffer.handle(), i * array_element_size + attribute.offset + offset_in_buffer[stream_index], stream.stride);
+        }
+    }
 
-            if (gxm::is_stream_instancing(static_cast<SceGxmIndexSource>(stream.indexSource))) {
-                glVertexAttribDivisor(attrib_location + i, 1);
+    if (update_format) {
+        for (uint32_t changed = enabled_attributes ^ context.enabled_vertex_attributes; changed != 0; changed &= changed - 1) {
+            const GLuint location = std::countr_zero(changed);
+            if (enabled_attributes & (1U << location)) {
+                glEnableVertexAttribArray(location);
             } else {
-                glVertexAttribDivisor(attrib_location + i, 0);
+                glDisableVertexAttribArray(location);
             }
         }
+
+        context.enabled_vertex_attributes = enabled_attributes;
+        context.vertex_format_program_hash = glvert->hash;
+        context.vertex_format_key_hash = vertex_program.key_hash;
     }
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 } // namespace renderer::gl
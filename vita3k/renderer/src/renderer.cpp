@@ -95,15 +95,16 @@ void draw(State &state, Context *ctx, SceGxmPrimitiveType prim_type, SceGxmIndex
     renderer::add_command(ctx, renderer::CommandOpcode::Draw, nullptr, prim_type, index_type, index_data, index_count, instance_count);
 }
 
-void transfer_copy(State &state, uint32_t colorKeyValue, uint32_t colorKeyMask, SceGxmTransferColorKeyMode colorKeyMode, const SceGxmTransferImage *images, SceGxmTransferType srcType, SceGxmTransferType destType) {
-    renderer::send_single_command(state, nullptr, renderer::CommandOpcode::TransferCopy, false, colorKeyValue, colorKeyMask, colorKeyMode, images, srcType, destType);
+// the transfer images are copied in the host command
+void transfer_copy(State &state, uint32_t colorKeyValue, uint32_t colorKeyMask, SceGxmTransferColorKeyMode colorKeyMode, const SceGxmTransferImage &src, const SceGxmTransferImage &dest, SceGxmTransferType srcType, SceGxmTransferType destType) {
+    renderer::send_single_command(state, nullptr, renderer::CommandOpcode::TransferCopy, false, colorKeyValue, colorKeyMask, colorKeyMode, src, dest, srcType, destType);
 }
 
-void transfer_downscale(State &state, const SceGxmTransferImage *src, const SceGxmTransferImage *dest) {
+void transfer_downscale(State &state, const SceGxmTransferImage &src, const SceGxmTransferImage &dest) {
     renderer::send_single_command(state, nullptr, renderer::CommandOpcode::TransferDownscale, false, src, dest);
 }
 
-void transfer_fill(State &state, uint32_t fillColor, const SceGxmTransferImage *dest) {
+void transfer_fill(State &state, uint32_t fillColor, const SceGxmTransferImage &dest) {
     renderer::send_single_command(state, nullptr, renderer::CommandOpcode::TransferFill, false, fillColor, dest);
 }
 
@@ -28,6 +28,7 @@
 #include <renderer/vulkan/functions.h>
 
 #include <config/state.h>
+#include <util/frame_timings.h>
 #include <util/log.h>
 #include <util/tracy.h>
 
@@ -82,6 +83,7 @@ COMMAND(handle_set_context) {
 
 COMMAND(handle_sync_surface_data) {
     TRACY_FUNC_COMMANDS(handle_sync_surface_data);
+    const frame_timings::Scope timing(frame_timings::Stage::SurfaceSync);
 
     const SceGxmNotification vertex_notification = helper.pop<SceGxmNotification>();
     const SceGxmNotification fragment_notification = helper.pop<SceGxmNotification>();
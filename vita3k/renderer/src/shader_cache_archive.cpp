@@ -0,0 +1,234 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/*
+Shader cache archive, so that the shader cache of an app made on one machine can be used on other ones
+The archive is a header followed by sections, an importer skips the sections it does not know.
+The shaders and pipeline descriptions are valid for any GPU with the same features, the Vulkan pipeline cache
+data is only kept when it was made by the same GPU and driver.
+*/
+
+#include <renderer/shaders.h>
+
+#include <renderer/shader_pack.h>
+#include <renderer/state.h>
+#include <renderer/types.h>
+#include <renderer/vulkan/state.h>
+
+#include <shader/spirv_recompiler.h>
+#include <util/log.h>
+
+#include <cstring>
+#include <set>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace renderer {
+
+// Increase this value when the archive layout changes
+static constexpr uint32_t SHADER_CACHE_ARCHIVE_VERSION = 1;
+static constexpr uint32_t SHADER_CACHE_ARCHIVE_MAGIC = 0x43533356; // "V3SC"
+
+struct ArchiveHeader {
+    uint32_t magic;
+    uint32_t version;
+    // the content is only valid for the same shader recompiler version, backend and GPU features
+    uint32_t shader_version;
+    uint32_t backend;
+    uint32_t features_mask;
+    uint32_t section_count;
+};
+
+enum class ArchiveSection : uint32_t {
+    // each shader is its name_size, data_size, then its name and data
+    Shaders,
+    // list of ShadersHash
+    ShaderHashes,
+    // Vulkan only
+    PipelineDescriptions,
+    PipelineCache,
+};
+
+struct SectionHeader {
+    ArchiveSection type;
+    uint32_t padding;
+    uint64_t size;
+};
+
+static void append_data(std::vector<uint8_t> &dest, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    dest.insert(dest.end(), bytes, bytes + size);
+}
+
+bool export_shader_cache(State &renderer, const fs::path &archive_path) {
+    std::vector<std::pair<ArchiveSection, std::vector<uint8_t>>> sections;
+
+    std::vector<uint8_t> shaders;
+    uint32_t shader_count = 0;
+    ShaderPack::get(renderer.shaders_path).for_each_entry([&](const std::string &name, std::span<const uint8_t> data) {
+        const uint32_t sizes[2] = { static_cast<uint32_t>(name.size()), static_cast<uint32_t>(data.size()) };
+        append_data(shaders, sizes, sizeof(sizes));
+        append_data(shaders, name.data(), name.size());
+        append_data(shaders, data.data(), data.size());
+        shader_count++;
+    });
+    if (shader_count == 0) {
+        LOG_WARN("The shader cache of this app is empty, nothing to export");
+        return false;
+    }
+    sections.emplace_back(ArchiveSection::Shaders, std::move(shaders));
+
+    std::vector<uint8_t> hashes;
+    append_data(hashes, renderer.shaders_cache_hashs.data(), renderer.shaders_cache_hashs.size() * sizeof(ShadersHash));
+    sections.emplace_back(ArchiveSection::ShaderHashes, std::move(hashes));
+
+    if (renderer.current_backend == Backend::Vulkan) {
+        vulkan::PipelineCache &pipeline_cache = dynamic_cast<vulkan::VKState &>(renderer).pipeline_cache;
+        sections.emplace_back(ArchiveSection::PipelineDescriptions, pipeline_cache.export_descriptions());
+        sections.emplace_back(ArchiveSection::PipelineCache, pipeline_cache.export_pipeline_cache());
+    }
+
+    fs::ofstream file(archive_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open {} to export the shader cache", archive_path);
+        return false;
+    }
+
+    const ArchiveHeader header = {
+        .magic = SHADER_CACHE_ARCHIVE_MAGIC,
+        .version = SHADER_CACHE_ARCHIVE_VERSION,
+        .shader_version = shader::CURRENT_VERSION,
+        .backend = static_cast<uint32_t>(renderer.current_backend),
+        .features_mask = renderer.get_features_mask(),
+        .section_count = static_cast<uint32_t>(sections.size()),
+    };
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &[type, data] : sections) {
+        const SectionHeader section_header = { type, 0, data.size() };
+        file.write(reinterpret_cast<const char *>(&section_header), sizeof(section_header));
+        file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    }
+    if (!file) {
+        LOG_ERROR("Failed to write the shader cache to {}", archive_path);
+        return false;
+    }
+
+    LOG_INFO("Exported {} shaders to {}", shader_count, archive_path);
+    return true;
+}
+
+static uint32_t import_shaders(State &renderer, std::span<const uint8_t> data) {
+    ShaderPack &pack = ShaderPack::get(renderer.shaders_path);
+    uint32_t shader_count = 0;
+    size_t offset = 0;
+    while (offset + 2 * sizeof(uint32_t) <= data.size()) {
+        uint32_t sizes[2];
+        memcpy(sizes, data.data() + offset, sizeof(sizes));
+        offset += sizeof(sizes);
+        if (static_cast<uint64_t>(sizes[0]) + sizes[1] > data.size() - offset)
+            break;
+
+        const std::string name(reinterpret_cast<const char *>(data.data() + offset), sizes[0]);
+        // the shaders already in the pack are kept
+        if (pack.add(name, data.data() + offset + sizes[0], sizes[1]))
+            shader_count++;
+        offset += sizes[0] + sizes[1];
+    }
+    return shader_count;
+}
+
+static void import_shader_hashes(State &renderer, std::span<const uint8_t> data) {
+    std::set<std::pair<Sha256Hash, Sha256Hash>> known_hashes;
+    for (const ShadersHash &hash : renderer.shaders_cache_hashs)
+        known_hashes.emplace(hash.frag, hash.vert);
+
+    for (size_t offset = 0; offset + sizeof(ShadersHash) <= data.size(); offset += sizeof(ShadersHash)) {
+        ShadersHash hash;
+        memcpy(&hash, data.data() + offset, sizeof(ShadersHash));
+        if (known_hashes.emplace(hash.frag, hash.vert).second)
+            renderer.shaders_cache_hashs.push_back(hash);
+    }
+}
+
+bool import_shader_cache(State &renderer, const fs::path &archive_path) {
+    std::vector<uint8_t> archive;
+    if (!fs_utils::read_data(archive_path, archive)) {
+        LOG_ERROR("Failed to read the shader cache archive {}", archive_path);
+        return false;
+    }
+
+    ArchiveHeader header{};
+    if (archive.size() >= sizeof(header))
+        memcpy(&header, archive.data(), sizeof(header));
+    if (header.magic != SHADER_CACHE_ARCHIVE_MAGIC || header.version != SHADER_CACHE_ARCHIVE_VERSION) {
+        LOG_ERROR("{} is not a shader cache archive or is outdated", archive_path);
+        return false;
+    }
+    if (header.shader_version != shader::CURRENT_VERSION || header.backend != static_cast<uint32_t>(renderer.current_backend)
+        || header.features_mask != renderer.get_features_mask()) {
+        LOG_ERROR("The shader cache archive {} was made by another version of Vita3K, for another renderer or with other GPU features", archive_path);
+        return false;
+    }
+
+    fs::create_directories(renderer.shaders_path);
+    uint32_t shader_count = 0;
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        SectionHeader section_header;
+        if (offset + sizeof(section_header) > archive.size())
+            break;
+        memcpy(&section_header, archive.data() + offset, sizeof(section_header));
+        offset += sizeof(section_header);
+        if (section_header.size > archive.size() - offset) {
+            LOG_WARN("The shader cache archive {} is truncated", archive_path);
+            break;
+        }
+
+        const std::span<const uint8_t> data(archive.data() + offset, section_header.size);
+        offset += section_header.size;
+        switch (section_header.type) {
+        case ArchiveSection::Shaders:
+            shader_count += import_shaders(renderer, data);
+            break;
+        case ArchiveSection::ShaderHashes:
+            import_shader_hashes(renderer, data);
+            break;
+        case ArchiveSection::PipelineDescriptions:
+            if (renderer.current_backend == Backend::Vulkan)
+                dynamic_cast<vulkan::VKState &>(renderer).pipeline_cache.import_descriptions(data);
+            break;
+        case ArchiveSection::PipelineCache:
+            if (renderer.current_backend == Backend::Vulkan && !data.empty())
+                dynamic_cast<vulkan::VKState &>(renderer).pipeline_cache.import_pipeline_cache(data);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // write the merged cache now, so that it is kept even if the app does not exit properly
+    if (renderer.current_backend == Backend::Vulkan)
+        dynamic_cast<vulkan::VKState &>(renderer).pipeline_cache.save_pipeline_cache();
+    else
+        save_shaders_cache_hashs(renderer, renderer.shaders_cache_hashs);
+
+    LOG_INFO("Imported {} shaders from {}", shader_count, archive_path);
+    return !renderer.shaders_cache_hashs.empty();
+}
+
+} // namespace renderer
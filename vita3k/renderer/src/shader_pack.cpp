@@ -0,0 +1,297 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/shader_pack.h>
+
+#include <util/align.h>
+#include <util/log.h>
+
+#include <map>
+#include <memory>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace renderer {
+
+// Increase this value when the file layout changes
+static constexpr uint32_t SHADER_PACK_VERSION = 1;
+static constexpr uint32_t SHADER_PACK_MAGIC = 0x4B505356; // "VSPK"
+
+static constexpr const char *SHADER_PACK_NAME = "shaders.pack";
+
+// each entry is a name_size, a data_size, the name then the data, both padded to 4 bytes
+// so that SPIR-V code can be used in place
+struct EntryHeader {
+    uint32_t name_size;
+    uint32_t data_size;
+};
+
+ShaderPack::~ShaderPack() {
+    close();
+}
+
+bool ShaderPack::map_file() {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE file_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file_mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    mapping = static_cast<const uint8_t *>(MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mapping) {
+        CloseHandle(file_mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    mapping_handle = file_mapping;
+    mapping_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the file is closed
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    mapping = static_cast<const uint8_t *>(data);
+    mapping_size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+    return true;
+}
+
+void ShaderPack::unmap_file() {
+    if (!mapping)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+#else
+    munmap(const_cast<uint8_t *>(mapping), mapping_size);
+#endif
+    mapping = nullptr;
+    mapping_size = 0;
+}
+
+bool ShaderPack::open(const fs::path &pack_path) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return load(pack_path);
+}
+
+bool ShaderPack::load(const fs::path &pack_path) {
+    path = pack_path;
+    entries.clear();
+    appended.clear();
+
+    if (!map_file())
+        return false;
+
+    uint32_t header[2] = {};
+    if (mapping_size >= sizeof(header))
+        memcpy(header, mapping, sizeof(header));
+    if (header[0] != SHADER_PACK_MAGIC || header[1] != SHADER_PACK_VERSION) {
+        LOG_WARN("Shader pack {} is outdated, discarding it", path);
+        unmap_file();
+        fs::remove(path);
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    while (offset + sizeof(EntryHeader) <= mapping_size) {
+        EntryHeader entry_header;
+        memcpy(&entry_header, mapping + offset, sizeof(EntryHeader));
+        const size_t name_offset = offset + sizeof(EntryHeader);
+        const size_t data_offset = name_offset + align(entry_header.name_size, 4);
+        const size_t next_offset = data_offset + align(entry_header.data_size, 4);
+        if (next_offset > mapping_size)
+            // the last entry was not fully written
+            break;
+
+        const std::string name(reinterpret_cast<const char *>(mapping + name_offset), entry_header.name_size);
+        entries.insert_or_assign(name, Entry{ data_offset, entry_header.data_size });
+        offset = next_offset;
+    }
+
+    size_t live_size = sizeof(header);
+    for (const auto &[name, entry] : entries)
+        live_size += sizeof(EntryHeader) + align(name.size(), 4) + align(entry.size, 4);
+
+    LOG_INFO("Shader pack {} opened with {} shaders", path, entries.size());
+
+    // an entry only partially written must be removed or the next ones appended would not be found
+    const bool is_truncated = offset != mapping_size;
+    // do not bother for small files
+    constexpr size_t compaction_threshold = 1024 * 1024;
+    if (is_truncated || (offset > compaction_threshold && live_size * 2 < offset))
+        compact();
+
+    return true;
+}
+
+void ShaderPack::close() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    unmap_file();
+    entries.clear();
+    appended.clear();
+}
+
+void ShaderPack::compact() {
+    LOG_INFO("Compacting shader pack {}", path);
+
+    const fs::path tmp_path = fs_utils::path_concat(path, ".tmp");
+    {
+        fs::ofstream file(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return;
+
+        const uint32_t header[2] = { SHADER_PACK_MAGIC, SHADER_PACK_VERSION };
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        constexpr char padding[4] = {};
+        for (const auto &[name, entry] : entries) {
+            const EntryHeader entry_header = { static_cast<uint32_t>(name.size()), entry.size };
+            file.write(reinterpret_cast<const char *>(&entry_header), sizeof(EntryHeader));
+            file.write(name.data(), name.size());
+            file.write(padding, align(name.size(), 4) - name.size());
+            file.write(reinterpret_cast<const char *>(mapping + entry.offset), align(entry.size, 4));
+        }
+        if (!file) {
+            file.close();
+            fs::remove(tmp_path);
+            return;
+        }
+    }
+
+    // the file is read again, this is only done at boot anyway
+    unmap_file();
+    entries.clear();
+    fs::rename(tmp_path, path);
+    load(fs::path(path));
+}
+
+std::span<const uint8_t> ShaderPack::find(const std::string &name) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    const auto appended_it = appended.find(name);
+    if (appended_it != appended.end())
+        return appended_it->second;
+
+    const auto it = entries.find(name);
+    if (it == entries.end())
+        return {};
+
+    return { mapping + it->second.offset, it->second.size };
+}
+
+bool ShaderPack::add(const std::string &name, const void *data, size_t size) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (path.empty())
+        return false;
+
+    // entries are never modified so that the views given by find remain valid
+    if (entries.find(name) != entries.end() || appended.find(name) != appended.end())
+        return true;
+
+    const bool is_new_file = !fs::exists(path) || fs::file_size(path) == 0;
+    fs::ofstream file(path, std::ios::out | std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open shader pack {} for writing", path);
+        return false;
+    }
+
+    if (is_new_file) {
+        const uint32_t header[2] = { SHADER_PACK_MAGIC, SHADER_PACK_VERSION };
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    }
+
+    constexpr char padding[4] = {};
+    const EntryHeader entry_header = { static_cast<uint32_t>(name.size()), static_cast<uint32_t>(size) };
+    file.write(reinterpret_cast<const char *>(&entry_header), sizeof(EntryHeader));
+    file.write(name.data(), name.size());
+    file.write(padding, align(name.size(), 4) - name.size());
+    file.write(static_cast<const char *>(data), size);
+    file.write(padding, align(size, 4) - size);
+    if (!file)
+        return false;
+
+    // keep a copy, the mapping does not cover the new entry
+    std::vector<uint8_t> &copy = appended[name];
+    copy.assign(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + size);
+    return true;
+}
+
+void ShaderPack::for_each_entry(const std::function<void(const std::string &name, std::span<const uint8_t> data)> &callback) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    for (const auto &[name, entry] : entries) {
+        if (appended.find(name) == appended.end())
+            callback(name, { mapping + entry.offset, entry.size });
+    }
+    for (const auto &[name, data] : appended)
+        callback(name, data);
+}
+
+static std::mutex packs_mutex;
+static std::map<fs::path, std::unique_ptr<ShaderPack>> packs;
+
+ShaderPack &ShaderPack::get(const fs::path &folder) {
+    const std::lock_guard<std::mutex> guard(packs_mutex);
+    auto &pack = packs[folder];
+    if (!pack) {
+        pack = std::make_unique<ShaderPack>();
+        pack->open(folder / SHADER_PACK_NAME);
+    }
+    return *pack;
+}
+
+void ShaderPack::close_folder(const fs::path &folder) {
+    const std::lock_guard<std::mutex> guard(packs_mutex);
+    packs.erase(folder);
+}
+
+} // namespace renderer
@@ -17,15 +17,20 @@
 
 #include <renderer/shaders.h>
 
+#include <renderer/shader_pack.h>
 #include <renderer/vulkan/state.h>
 
 #include <gxm/types.h>
 #include <renderer/state.h>
 #include <renderer/types.h>
 #include <shader/spirv_recompiler.h>
+#include <util/containers.h>
 #include <util/fs.h>
 #include <util/log.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -50,6 +55,7 @@ bool get_shaders_cache_hashs(State &renderer) {
     shaders_hashs.read((char *)&features_mask, sizeof(uint32_t));
     if (versionInFile != shader::CURRENT_VERSION || features_mask != renderer.get_features_mask()) {
         shaders_hashs.close();
+        ShaderPack::close_folder(renderer.shaders_path);
         fs::remove_all(renderer.shaders_path);
         fs::remove_all(renderer.shaders_log_path);
         if (versionInFile != shader::CURRENT_VERSION)
@@ -86,10 +92,10 @@ bool get_shaders_cache_hashs(State &renderer) {
     return !renderer.shaders_cache_hashs.empty();
 }
 
-void save_shaders_cache_hashs(State &renderer, std::vector<ShadersHash> &shaders_cache_hashs) {
-    fs::create_directories(renderer.shaders_path);
+static void write_shaders_cache_hashs(const State &renderer, const fs::path &shaders_path, const std::vector<ShadersHash> &shaders_cache_hashs) {
+    fs::create_directories(shaders_path);
     std::string hash_file_name = fmt::format("hashs-{}.dat", (renderer.current_backend == Backend::OpenGL) ? "gl" : "vk");
-    fs::ofstream shaders_hashs(renderer.shaders_path / hash_file_name, std::ios::out | std::ios::binary);
+    fs::ofstream shaders_hashs(shaders_path / hash_file_name, std::ios::out | std::ios::binary);
 
     if (shaders_hashs.is_open()) {
         // Write Size of shaders cache hashes list
@@ -115,6 +121,10 @@ void save_shaders_cache_hashs(State &renderer, std::vector<ShadersHash> &shaders
     }
 }
 
+void save_shaders_cache_hashs(State &renderer, std::vector<ShadersHash> &shaders_cache_hashs) {
+    write_shaders_cache_hashs(renderer, renderer.shaders_path, shaders_cache_hashs);
+}
+
 static bool load_shader(const fs::path &shader_name, char **destination, std::size_t &size_read) {
     fs::ifstream is(shader_name, fs::ifstream::binary);
     if (!is) {
@@ -137,29 +147,36 @@ static bool load_shader(const fs::path &shader_name, char **destination, std::si
     return true;
 }
 
-static Sha256Hash get_shader_hash(const SceGxmProgram &program) {
-    const Sha256Hash hash_bytes = sha256(&program, program.size);
-    return hash_bytes;
-}
-
 template <typename R>
 static R load_shader_generic(const fs::path &shader_path) {
     std::size_t read_size = 0;
     R source;
 
+    ShaderPack &pack = ShaderPack::get(shader_path.parent_path());
+    const std::string shader_name = shader_path.filename().string();
+    const std::span<const uint8_t> packed = pack.find(shader_name);
+    if (!packed.empty()) {
+        source.resize((packed.size() + sizeof(typename R::value_type) - 1) / sizeof(typename R::value_type));
+        memcpy(source.data(), packed.data(), packed.size());
+        return source;
+    }
+
     if (load_shader(shader_path, nullptr, read_size)) {
         source.resize((read_size + sizeof(typename R::value_type) - 1) / sizeof(typename R::value_type));
 
         char *dest_pointer = reinterpret_cast<char *>(source.data());
         load_shader(shader_path, &dest_pointer, read_size);
+
+        // shader cached before the pack existed, move it inside
+        if (pack.add(shader_name, source.data(), read_size))
+            fs::remove(shader_path);
     }
 
     return source;
 }
 
-static shader::GeneratedShader load_shader_generic(shader::Target target, const SceGxmProgram &program, const FeatureState &features, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shaderlog_path, const char *shader_type_str, const std::string &shader_version, bool shader_cache) {
-    // TODO: no need to recompute the hash here
-    const std::string hash_text = hex_string(get_shader_hash(program));
+static shader::GeneratedShader load_shader_generic(shader::Target target, const SceGxmProgram &program, const Sha256Hash &hash, const FeatureState &features, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shaderlog_path, const char *shader_type_str, const std::string &shader_version, bool shader_cache) {
+    const std::string hash_text = hex_string(hash);
     // Set Shader Hash with Version
     const std::string hash_hex_ver = fmt::format("{}-{}", shader_version, hash_text);
     const auto get_shader_path = [&](const char *ext) {
@@ -194,6 +211,11 @@ static shader::GeneratedShader load_shader_generic(shader::Target target, const
     const auto write_data_with_ext = [&](const std::string &ext, const std::string &data) {
         fs::path out_path;
         if (ext == shader_type_str) {
+            if (target == shader::Target::GLSLOpenGL) {
+                fs::create_directories(shader_cache_path);
+                ShaderPack::get(shader_cache_path).add(shader_path.filename().string(), data.c_str(), data.size());
+                return true;
+            }
             out_path = shader_path;
         } else {
             out_path = shader_log_path;
@@ -211,13 +233,13 @@ static shader::GeneratedShader load_shader_generic(shader::Target target, const
 
     if (target != shader::Target::GLSLOpenGL) {
         const auto shader_dst_path = get_shader_path("spv");
-        fs_utils::dump_data(shader_dst_path, source.spirv.data(), sizeof(uint32_t) * source.spirv.size());
+        ShaderPack::get(shaders_cache_path).add(shader_dst_path.filename().string(), source.spirv.data(), sizeof(uint32_t) * source.spirv.size());
     }
 
     return source;
 }
 
-std::string load_glsl_shader(const SceGxmProgram &program, const FeatureState &features, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, bool shader_cache) {
+std::string load_glsl_shader(const SceGxmProgram &program, const Sha256Hash &hash, const FeatureState &features, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, bool shader_cache) {
     SceGxmProgramType program_type = program.get_type();
 
     auto shader_type_to_str = [](SceGxmProgramType type) {
@@ -226,17 +248,17 @@ std::string load_glsl_shader(const SceGxmProgram &program, const FeatureState &f
 
     const char *shader_type_str = shader_type_to_str(program_type);
 
-    return load_shader_generic(shader::Target::GLSLOpenGL, program, features, hints, maskupdate, shader_cache_path, shader_log_path, shader_type_str, shader_version, shader_cache).glsl;
+    return load_shader_generic(shader::Target::GLSLOpenGL, program, hash, features, hints, maskupdate, shader_cache_path, shader_log_path, shader_type_str, shader_version, shader_cache).glsl;
 }
 
-std::vector<uint32_t> load_spirv_shader(const SceGxmProgram &program, const FeatureState &features, bool is_vulkan, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, bool shader_cache) {
+std::vector<uint32_t> load_spirv_shader(const SceGxmProgram &program, const Sha256Hash &hash, const FeatureState &features, bool is_vulkan, const shader::Hints &hints, bool maskupdate, const fs::path &shader_cache_path, const fs::path &shader_log_path, const std::string &shader_version, bool shader_cache) {
     const shader::Target target = is_vulkan ? shader::Target::SpirVVulkan : shader::Target::SpirVOpenGL;
     auto shader_type_to_str = [](SceGxmProgramType type) {
         return (type == SceGxmProgramType::Vertex) ? "vert.spv.txt" : ((type == SceGxmProgramType::Fragment) ? "frag.spv.txt" : "unknown.spv.txt");
     };
     const char *shader_type_str = shader_type_to_str(program.get_type());
 
-    return load_shader_generic(target, program, features, hints, maskupdate, shader_cache_path, shader_log_path, shader_type_str, shader_version, shader_cache).spirv;
+    return load_shader_generic(target, program, hash, features, hints, maskupdate, shader_cache_path, shader_log_path, shader_type_str, shader_version, shader_cache).spirv;
 }
 
 std::string pre_load_shader_glsl(const fs::path &shader_path) {
@@ -247,4 +269,90 @@ std::vector<uint32_t> pre_load_shader_spirv(const fs::path &shader_path) {
     return load_shader_generic<std::vector<uint32_t>>(shader_path);
 }
 
+std::span<const uint32_t> find_packed_shader_spirv(const fs::path &shader_path) {
+    const std::span<const uint8_t> packed = ShaderPack::get(shader_path.parent_path()).find(shader_path.filename().string());
+    // entries are always 4-byte aligned in the pack
+    return { reinterpret_cast<const uint32_t *>(packed.data()), packed.size() / sizeof(uint32_t) };
+}
+
+// the programs are either stored as is or embedded in the data segment of an executable,
+// the header is checked to skip anything else which would start with the magic
+static void find_gxp_programs(std::span<const uint8_t> data, std::vector<const SceGxmProgram *> &programs) {
+    // "GXP\0"
+    static constexpr uint32_t GXP_MAGIC = 0x00505847;
+
+    size_t offset = 0;
+    // the programs are at least 4-byte aligned
+    while (offset + sizeof(SceGxmProgram) <= data.size()) {
+        uint32_t magic;
+        memcpy(&magic, data.data() + offset, sizeof(magic));
+        if (magic != GXP_MAGIC) {
+            offset += sizeof(magic);
+            continue;
+        }
+
+        const SceGxmProgram *program = reinterpret_cast<const SceGxmProgram *>(data.data() + offset);
+        const uint64_t primary_program_end = offsetof(SceGxmProgram, primary_program_offset) + static_cast<uint64_t>(program->primary_program_offset)
+            + static_cast<uint64_t>(program->primary_program_instr_count) * sizeof(uint64_t);
+        const bool is_valid = program->major_version == 1
+            && program->size >= sizeof(SceGxmProgram) && program->size <= data.size() - offset
+            && program->primary_program_instr_count != 0 && primary_program_end <= program->size
+            && offsetof(SceGxmProgram, parameters_offset) + static_cast<uint64_t>(program->parameters_offset) <= program->size
+            && offsetof(SceGxmProgram, varyings_offset) + static_cast<uint64_t>(program->varyings_offset) < program->size;
+        if (!is_valid) {
+            offset += sizeof(magic);
+            continue;
+        }
+
+        programs.push_back(program);
+        offset += (program->size + 3) & ~3U;
+    }
+}
+
+uint32_t build_app_shader_cache(State &renderer, const std::vector<std::vector<uint8_t>> &binaries, const fs::path &shaders_path, const fs::path &shaders_log_path) {
+    if (renderer.current_backend != Backend::Vulkan)
+        return 0;
+
+    // the shaders cached during a previous run were compiled with the right hints, keep them
+    if (fs::exists(shaders_path / "hashs-vk.dat"))
+        return 0;
+
+    std::vector<const SceGxmProgram *> programs;
+    for (const std::vector<uint8_t> &binary : binaries)
+        find_gxp_programs(binary, programs);
+
+    // the render state is unknown before the app runs, use the most common one
+    const std::vector<SceGxmVertexAttribute> no_attributes;
+    shader::Hints hints{
+        .attributes = &no_attributes,
+        .color_format = SCE_GXM_COLOR_FORMAT_U8U8U8U8_ABGR,
+    };
+    std::fill_n(hints.vertex_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+    std::fill_n(hints.fragment_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+
+    const std::string shader_version = fmt::format("vk{}", shader::CURRENT_VERSION);
+    std::vector<ShadersHash> shaders_cache_hashs;
+    unordered_set_fast<Sha256Hash> translated;
+    for (const SceGxmProgram *program : programs) {
+        const Sha256Hash hash = sha256(program, program->size);
+        if (!translated.insert(hash).second)
+            continue;
+
+        if (load_spirv_shader(*program, hash, renderer.features, true, hints, false, shaders_path, shaders_log_path, shader_version, true).empty())
+            continue;
+
+        // same layout as the entries added by the vulkan pipeline cache
+        const Sha256Hash empty_hash{};
+        if (program->is_vertex())
+            shaders_cache_hashs.push_back({ hash, empty_hash });
+        else
+            shaders_cache_hashs.push_back({ empty_hash, hash });
+    }
+
+    if (!shaders_cache_hashs.empty())
+        write_shaders_cache_hashs(renderer, shaders_path, shaders_cache_hashs);
+
+    return static_cast<uint32_t>(shaders_cache_hashs.size());
+}
+
 } // namespace renderer
@@ -35,6 +35,8 @@
 
 #include <config/state.h>
 
+#include <array>
+
 namespace renderer {
 COMMAND_SET_STATE(region_clip) {
     TRACY_FUNC_COMMANDS_SET_STATE(region_clip);
@@ -537,7 +539,7 @@ COMMAND(handle_set_state) {
     renderer::GXMState gxm_state_to_set = helper.pop<renderer::GXMState>();
     using StateChangeHandlerFunc = decltype(cmd_set_state_region_clip);
 
-    static const std::map<renderer::GXMState, StateChangeHandlerFunc *> handlers = {
+    static const std::pair<GXMState, StateChangeHandlerFunc *> handler_list[] = {
         { GXMState::RegionClip, cmd_set_state_region_clip },
         { GXMState::Program, cmd_set_state_program },
         { GXMState::Viewport, cmd_set_state_viewport },
@@ -558,11 +560,18 @@ COMMAND(handle_set_state) {
         { GXMState::VisibilityIndex, cmd_set_state_visibility_index }
     };
 
-    auto result = handlers.find(gxm_state_to_set);
+    // indexed by the state, this is looked up for each state set command
+    static const auto handlers = [] {
+        std::array<StateChangeHandlerFunc *, static_cast<size_t>(GXMState::TotalState)> table{};
+        for (const auto &[state, handler] : handler_list)
+            table[static_cast<size_t>(state)] = handler;
+        return table;
+    }();
 
-    if (result != handlers.end()) {
+    const auto state_index = static_cast<size_t>(gxm_state_to_set);
+    if ((state_index < handlers.size()) && handlers[state_index]) {
         // LOG_TRACE("State set: {}", (int)gxm_state_to_set);
-        result->second(renderer, mem, config, helper, render_context);
+        handlers[state_index](renderer, mem, config, helper, render_context);
     } else {
         LOG_ERROR("Unknown state set command {}", static_cast<uint16_t>(gxm_state_to_set));
     }
@@ -89,6 +89,8 @@ COMMAND(new_frame) {
 
     if (renderer.current_backend == Backend::Vulkan) {
         vulkan::new_frame(*reinterpret_cast<vulkan::VKContext *>(renderer.context));
+    } else {
+        gl::new_frame(static_cast<gl::GLState &>(renderer), *reinterpret_cast<gl::GLContext *>(renderer.context));
     }
 }
 
@@ -24,11 +24,13 @@
 #include <mem/ptr.h>
 #include <util/align.h>
 #include <util/bit_cast.h>
+#include <util/frame_timings.h>
 #include <util/log.h>
 
 #include <algorithm>
 #include <cstring>
 #include <numeric>
+#include <vector>
 #if defined(__x86_64__) && !defined(__APPLE__)
 #include <xxh_x86dispatch.h>
 #else
@@ -68,14 +70,35 @@ uint64_t hash_texture_data(const SceGxmTexture &texture, uint32_t texture_size,
     }
 }
 
-// Function to hash an arbitrary swizzled texture in the most optimized way possible
+// Part of a texture layout which contains visible pixels, as an offset from the texture data
+struct HashSpan {
+    uint32_t offset;
+    uint32_t size;
+};
+
+// The visible pixels of a swizzled or tiled texture are not contiguous, hashing them means calling the
+// hasher on many small spans. The spans only depend on the layout, so they are computed once for each layout
+// and contiguous spans are merged, which does not change the resulting hash.
+typedef std::vector<HashSpan> HashLayout;
+
+static void add_span(HashLayout &layout, uint32_t offset, uint32_t size) {
+    if (size == 0)
+        return;
+
+    if (!layout.empty() && layout.back().offset + layout.back().size == offset)
+        layout.back().size += size;
+    else
+        layout.push_back({ offset, size });
+}
+
+// Get the spans of an arbitrary swizzled texture
 // this is a recursive function which calls itself on the 4 higher block making the sizzle
-// once a block entirely in the swizzle is found, it stops and hash it
-// the pixels should be hash in the exact order they appear in the memory
-static void hash_arbitrary_swizzled(const uint8_t *data, uint32_t width, uint32_t height, uint32_t texture_width, uint32_t texture_height, uint32_t texture_size, XXH3_state_t *hash_state) {
+// once a block entirely in the swizzle is found, it stops and adds it
+// the spans are in the exact order they appear in the memory
+static void get_arbitrary_swizzled_layout(uint32_t offset, uint32_t width, uint32_t height, uint32_t texture_width, uint32_t texture_height, uint32_t texture_size, HashLayout &layout) {
     if (width >= texture_width && height >= texture_height) {
         // whole block is included, hash it
-        XXH3_64bits_update(hash_state, data, texture_size);
+        add_span(layout, offset, texture_size);
         return;
     }
 
@@ -85,23 +108,23 @@ static void hash_arbitrary_swizzled(const uint8_t *data, uint32_t width, uint32_
     const uint32_t block_size = texture_size / 4;
 
     // we always hash the first subblock (it always contains something)
-    hash_arbitrary_swizzled(data, width, height, block_width, block_height, block_size, hash_state);
+    get_arbitrary_swizzled_layout(offset, width, height, block_width, block_height, block_size, layout);
 
     if (height > block_height) {
-        hash_arbitrary_swizzled(data + block_size, width, height - block_height, block_width, block_height, block_size, hash_state);
+        get_arbitrary_swizzled_layout(offset + block_size, width, height - block_height, block_width, block_height, block_size, layout);
     }
 
     if (width > block_width) {
-        hash_arbitrary_swizzled(data + 2 * block_size, width - block_width, height, block_width, block_height, block_size, hash_state);
+        get_arbitrary_swizzled_layout(offset + 2 * block_size, width - block_width, height, block_width, block_height, block_size, layout);
     }
 
     if (height > block_height && width > block_width) {
-        hash_arbitrary_swizzled(data + 3 * block_size, width - block_width, height - block_height, block_width, block_height, block_size, hash_state);
+        get_arbitrary_swizzled_layout(offset + 3 * block_size, width - block_width, height - block_height, block_width, block_height, block_size, layout);
     }
 }
 
-// hash only the visible pixels of a tiled texture
-static void hash_unaligned_tiled(const uint8_t *data, uint32_t width, uint32_t height, uint32_t block_width, uint32_t block_height, uint32_t bpp, XXH3_state_t *hash_state) {
+// get the spans of the visible pixels of a tiled texture
+static void get_unaligned_tiled_layout(uint32_t width, uint32_t height, uint32_t block_height, uint32_t bpp, HashLayout &layout) {
     // a tile is 32x32
     constexpr uint32_t tile_mask = 0x1F;
 
@@ -113,11 +136,12 @@ static void hash_unaligned_tiled(const uint8_t *data, uint32_t width, uint32_t h
     const uint32_t tile_block_lines = 32 / block_height;
     const uint32_t total_line_size = (32 * block_height * bpp) / 8;
 
+    uint32_t offset = 0;
     if (width == width_down_aligned) {
         // just hash everything (except the bottom) in one go
         const uint32_t hash_size = (width * height_down_aligned * bpp) / 8;
-        XXH3_64bits_update(hash_state, data, hash_size);
-        data += hash_size;
+        add_span(layout, offset, hash_size);
+        offset += hash_size;
     } else {
         // need to hash block lines one by one
         const uint32_t block_lines = height_down_aligned / 32;
@@ -126,12 +150,12 @@ static void hash_unaligned_tiled(const uint8_t *data, uint32_t width, uint32_t h
 
         // we are only using the left of the tiles
         for (uint32_t block_line = 0; block_line < block_lines; block_line++) {
-            XXH3_64bits_update(hash_state, data, filled_line_size);
-            data += filled_line_size;
+            add_span(layout, offset, filled_line_size);
+            offset += filled_line_size;
 
             for (uint32_t tile_block_line = 0; tile_block_line < tile_block_lines; tile_block_line++) {
-                XXH3_64bits_update(hash_state, data, end_line_used);
-                data += total_line_size;
+                add_span(layout, offset, end_line_used);
+                offset += total_line_size;
             }
         }
     }
@@ -145,8 +169,8 @@ static void hash_unaligned_tiled(const uint8_t *data, uint32_t width, uint32_t h
     const uint32_t used_tile_size = (32 * (height & tile_mask) * bpp) / 8;
     const uint32_t nb_tiles_x = width_down_aligned / 32;
     for (uint32_t tile_x = 0; tile_x < nb_tiles_x; tile_x++) {
-        XXH3_64bits_update(hash_state, data, used_tile_size);
-        data += tile_size;
+        add_span(layout, offset, used_tile_size);
+        offset += tile_size;
     }
 
     if (width == width_down_aligned)
@@ -157,9 +181,35 @@ static void hash_unaligned_tiled(const uint8_t *data, uint32_t width, uint32_t h
     const uint32_t end_line_used = ((width & tile_mask) * block_height * bpp) / 8;
     const uint32_t nb_lines_used = (height & tile_mask) / block_height;
     for (uint32_t line = 0; line < nb_lines_used; line++) {
-        XXH3_64bits_update(hash_state, data, end_line_used);
-        data += total_line_size;
+        add_span(layout, offset, end_line_used);
+        offset += total_line_size;
+    }
+}
+
+// only called by the renderer thread
+static const HashLayout &get_hash_layout(SceGxmTextureType texture_type, uint32_t width, uint32_t height, uint32_t block_height, uint32_t bpp) {
+    static unordered_map_fast<uint64_t, HashLayout> layouts;
+
+    // width and height are at most 4096, bpp at most 128 and block_height at most 12
+    const uint64_t key = static_cast<uint64_t>(width)
+        | static_cast<uint64_t>(height) << 16
+        | static_cast<uint64_t>(bpp) << 32
+        | static_cast<uint64_t>(block_height) << 40
+        | static_cast<uint64_t>(texture_type == SCE_GXM_TEXTURE_TILED) << 48;
+
+    auto [it, inserted] = layouts.try_emplace(key);
+    if (inserted) {
+        if (texture_type == SCE_GXM_TEXTURE_TILED) {
+            get_unaligned_tiled_layout(width, height, block_height, bpp, it->second);
+        } else {
+            const uint32_t texture_width = next_power_of_two(width);
+            const uint32_t texture_height = next_power_of_two(height);
+            const uint32_t texture_size = (texture_width * texture_height * bpp) / 8;
+            get_arbitrary_swizzled_layout(0, width, height, texture_width, texture_height, texture_size, it->second);
+        }
     }
+
+    return it->second;
 }
 
 uint64_t hash_texture_nostride(const SceGxmTexture &texture, const MemState &mem) {
@@ -262,20 +312,12 @@ uint64_t hash_texture_nostride(const SceGxmTexture &texture, const MemState &mem
         return hash;
     }
 
-    if (texture.texture_type() == SCE_GXM_TEXTURE_TILED) {
-        // some side tiles have non-used pixels
-        hash_unaligned_tiled(data.get(mem), width, height, block_width, block_height, bpp, hash_state);
-
-        hash ^= XXH3_64bits_digest(hash_state);
-        return hash;
-    }
+    // the texture is tiled, some side tiles have non-used pixels
+    // or the texture is arbitrarily swizzled, hash completely used block by completely used block
+    const uint8_t *data_loc = data.get(mem);
+    for (const HashSpan &span : get_hash_layout(texture.texture_type(), width, height, block_height, bpp))
+        XXH3_64bits_update(hash_state, data_loc + span.offset, span.size);
 
-    // texture is arbitrarily swizzled
-    // hash completely used block by completely used block
-    const uint32_t texture_width = next_power_of_two(width);
-    const uint32_t texture_height = next_power_of_two(height);
-    const uint32_t texture_size = (texture_width * texture_height * bpp) / 8;
-    hash_arbitrary_swizzled(data.get(mem), width, height, texture_width, texture_height, texture_size, hash_state);
     hash ^= XXH3_64bits_digest(hash_state);
     return hash;
 }
@@ -299,6 +341,12 @@ bool TextureCache::init(const bool hashless_texture_cache, const fs::path &textu
 
     // prevent stutter caused by the hashmap resizing
     texture_lookup.reserve(TextureCacheSize);
+    nb_textures = 0;
+    memory_used = 0;
+    nb_hits = 0;
+    nb_misses = 0;
+    nb_evictions = 0;
+    nb_partial_uploads = 0;
 
     use_sampler_cache = sampler_cache_size > 0;
     if (use_sampler_cache) {
@@ -312,12 +360,71 @@ bool TextureCache::init(const bool hashless_texture_cache, const fs::path &textu
 
     export_folder = texture_folder / "export" / std::string(game_id);
     import_folder = texture_folder / "import" / std::string(game_id);
+    transcode_folder = texture_folder / "transcoded" / std::string(game_id);
 
     refresh_available_textures();
 
     return true;
 }
 
+// Increase this value when the encoder output changes
+static constexpr uint32_t TRANSCODED_TEXTURE_VERSION = 1;
+static constexpr uint32_t TRANSCODED_TEXTURE_MAGIC = 0x32435445; // "ETC2"
+
+// a transcoded texture file is this header followed by the ETC2 blocks of all the faces and mips, in upload order
+struct TranscodedTextureHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t base_format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_count;
+    uint32_t data_size;
+};
+
+bool TextureCache::is_transcoded_to_etc2(SceGxmTextureBaseFormat base_format) const {
+    // BC4 and BC5 are decompressed to one or two 8-bit channels, ETC2 would not save much
+    return transcode_bcn_to_etc2 && !support_dxt
+        && (base_format == SCE_GXM_TEXTURE_BASE_FORMAT_UBC1
+            || base_format == SCE_GXM_TEXTURE_BASE_FORMAT_UBC2
+            || base_format == SCE_GXM_TEXTURE_BASE_FORMAT_UBC3);
+}
+
+static fs::path get_transcoded_texture_path(const fs::path &folder, uint64_t hash) {
+    return folder / fmt::format("{:016X}.etc2", hash);
+}
+
+// the hash only covers the first mip, the header is checked to make sure the file matches the texture
+static bool load_transcoded_texture(const fs::path &path, const TranscodedTextureHeader &expected, std::vector<uint8_t> &data) {
+    if (!fs::exists(path) || !fs_utils::read_data(path, data))
+        return false;
+
+    TranscodedTextureHeader header;
+    if (data.size() < sizeof(header))
+        return false;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != expected.magic || header.version != expected.version || header.base_format != expected.base_format
+        || header.width != expected.width || header.height != expected.height || header.mip_count != expected.mip_count
+        || header.data_size != data.size() - sizeof(header))
+        return false;
+
+    data.erase(data.begin(), data.begin() + sizeof(header));
+    return true;
+}
+
+static void save_transcoded_texture(const fs::path &path, TranscodedTextureHeader header, const std::vector<uint8_t> &data) {
+    fs::create_directories(path.parent_path());
+    fs::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open {} for writing", path);
+        return;
+    }
+
+    header.data_size = static_cast<uint32_t>(data.size());
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
 void TextureCache::upload_texture(const SceGxmTexture &gxm_texture, MemState &mem) {
     R_PROFILE(__func__);
 
@@ -412,6 +519,18 @@ void TextureCache::upload_texture(const SceGxmTexture &gxm_texture, MemState &me
     const uint32_t org_layout_width = layout_width;
     const uint32_t org_layout_height = layout_height;
 
+    // BC1/2/3 textures are kept compressed as ETC2 when BCn textures are not supported
+    const bool is_transcoded = is_transcoded_to_etc2(base_format);
+    // blocks of all the faces and mips, only the textures with a hash are kept on disk
+    std::vector<uint8_t> transcoded_data;
+    size_t transcoded_offset = 0;
+    bool is_transcoded_from_file = false;
+    const TranscodedTextureHeader transcoded_header = {
+        TRANSCODED_TEXTURE_MAGIC, TRANSCODED_TEXTURE_VERSION, base_format, org_width, org_height, total_mip, 0
+    };
+    if (is_transcoded && current_info->use_hash)
+        is_transcoded_from_file = load_transcoded_texture(get_transcoded_texture_path(transcode_folder, current_info->hash), transcoded_header, transcoded_data);
+
     while (face_uploaded_count < face_total_count && org_width > 0 && org_height > 0) {
         pixels = texture_data;
 
@@ -557,7 +676,30 @@ void TextureCache::upload_texture(const SceGxmTexture &gxm_texture, MemState &me
             pixels = texture_pixels_lineared.data();
         }
 
-        if (!support_dxt && gxm::is_bcn_format(base_format)) {
+        const void *export_pixels = pixels;
+        SceGxmTextureBaseFormat export_format = upload_format;
+        if (is_transcoded) {
+            const uint32_t etc2_size = get_compressed_size(SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8, pixels_per_stride, memory_height);
+            if (!is_transcoded_from_file || export_textures) {
+                // the blocks are decoded even when they are read from the file so that the texture can be exported
+                texture_data_decompressed.resize(align(pixels_per_stride, 4) * align(memory_height, 4) * 4);
+                decompress_compressed_texture(base_format, texture_data_decompressed.data(), pixels, pixels_per_stride, memory_height);
+                export_pixels = texture_data_decompressed.data();
+                export_format = SCE_GXM_TEXTURE_BASE_FORMAT_U8U8U8U8;
+            }
+
+            if (!is_transcoded_from_file) {
+                transcoded_data.resize(transcoded_offset + etc2_size);
+                compress_etc2_rgba8_image(pixels_per_stride, memory_height, reinterpret_cast<const uint32_t *>(texture_data_decompressed.data()), transcoded_data.data() + transcoded_offset);
+            } else if (transcoded_offset + etc2_size > transcoded_data.size()) {
+                LOG_ERROR("Transcoded texture {:016X} is too small", current_info->hash);
+                return;
+            }
+
+            pixels = transcoded_data.data() + transcoded_offset;
+            transcoded_offset += etc2_size;
+            upload_format = SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8;
+        } else if (!support_dxt && gxm::is_bcn_format(base_format)) {
             // decompress the texture
             const int num_comp = gxm::get_num_components(base_format);
             texture_data_decompressed.resize(pixels_per_stride * memory_height * num_comp);
@@ -565,11 +707,13 @@ void TextureCache::upload_texture(const SceGxmTexture &gxm_texture, MemState &me
             pixels = texture_data_decompressed.data();
             bpp = num_comp * 8;
             upload_format = get_matching_decompressed_format(base_format);
+            export_pixels = pixels;
+            export_format = upload_format;
         }
 
         upload_texture_impl(upload_format, width, height, mip_index, pixels, upload_type, pixels_per_stride);
         if (export_textures)
-            export_texture_impl(upload_format, width, height, mip_index, pixels, upload_type, pixels_per_stride);
+            export_texture_impl(export_format, width, height, mip_index, export_pixels, upload_type, pixels_per_stride);
 
         const uint32_t nb_pixels = align(layout_width, align_width) * align(layout_height, align_height);
         const uint32_t mip_size = (nb_pixels >> block_shift) * block_size;
@@ -611,6 +755,9 @@ void TextureCache::upload_texture(const SceGxmTexture &gxm_texture, MemState &me
             texture_data += total_source_so_far - source_unaligned_size;
         }
     }
+
+    if (is_transcoded && !is_transcoded_from_file && current_info->use_hash)
+        save_transcoded_texture(get_transcoded_texture_path(transcode_folder, current_info->hash), transcoded_header, transcoded_data);
 }
 
 // remove everything related to the sampler state
@@ -660,9 +807,11 @@ void TextureCache::cache_and_bind_texture(const SceGxmTexture &gxm_texture, MemS
         if (info->texture_size > 0) {
             // Cache is full.
             LOG_WARN_ONCE("Texture cache is full. Starting to replace textures");
-            texture_lookup.erase(std::bit_cast<TextureGxmDataRepr>(info->texture));
+            evict(info);
         }
         texture_lookup[texture_repr] = info;
+        nb_textures++;
+        nb_misses++;
 
         configure = true;
         upload = true;
@@ -699,6 +848,7 @@ void TextureCache::cache_and_bind_texture(const SceGxmTexture &gxm_texture, MemS
         index = cached_gxm_texture_index;
         info = gxm_it->second;
         configure = false;
+        nb_hits++;
         if (info->use_hash) {
             const uint64_t previous_hash = info->hash;
             if (import_textures || export_textures)
@@ -710,7 +860,7 @@ void TextureCache::cache_and_bind_texture(const SceGxmTexture &gxm_texture, MemS
         } else {
             range_protect_begin = align(gxm_texture.data_addr << 2, mem.page_size);
             range_protect_end = align_down((gxm_texture.data_addr << 2) + info->texture_size, mem.page_size);
-            upload = info->dirty;
+            upload = was_written_since(mem, range_protect_begin, range_protect_end - range_protect_begin, info->write_sequence);
         }
     }
     current_info = info;
@@ -725,11 +875,17 @@ void TextureCache::cache_and_bind_texture(const SceGxmTexture &gxm_texture, MemS
     }
 
     importing_texture = false;
-    if (upload && import_textures) {
+    // a replacement loaded in the background must be uploaded once it is ready, even if the texture did not change
+    if ((upload || info->is_import_pending) && import_textures) {
         auto it = available_textures_hash.find(info->hash);
-        if (it != available_textures_hash.end()) {
+        if (it != available_textures_hash.end())
+            imported_texture = get_imported_texture(info, it->second);
+        else
+            cancel_pending_import(info);
+
+        if (imported_texture) {
             importing_texture = true;
-            loading_texture = it->second;
+            upload = true;
             // always configure for replacement texture (although it may have no effect)
             // the reason being that we may have two replacement textures for the same gxm identifier
             // with different dimensions, so we can't assume
@@ -743,37 +899,32 @@ void TextureCache::cache_and_bind_texture(const SceGxmTexture &gxm_texture, MemS
     select(index, gxm_texture);
 
     if (configure) {
-        bool need_configure = true;
-
         if (importing_texture)
-            need_configure = !import_configure_texture();
-
-        if (need_configure) {
+            import_configure_texture();
+        else {
             configure_texture(gxm_texture);
-            importing_texture = false;
             info->is_imported = false;
         }
     }
     if (upload) {
+        const frame_timings::Scope timing(frame_timings::Stage::TextureUpload);
         if (export_textures && !importing_texture)
             export_select(gxm_texture);
 
+        // only the written rows of a hashless texture need to be uploaded again
+        const bool partial_upload = !configure && !info->use_hash && !importing_texture && !export_textures
+            && upload_written_rows(gxm_texture, mem, range_protect_begin, range_protect_end, info->texture_size, info->write_sequence);
+
         if (importing_texture)
             import_upload_texture();
-        else
+        else if (!partial_upload) {
             upload_texture(gxm_texture, mem);
-
-        if (!info->use_hash) {
-            info->dirty = false;
-            add_protect(mem, range_protect_begin, range_protect_end - range_protect_begin, MemPerm::ReadOnly, [info, texture_repr](Address, bool) {
-                if (memcmp(&info->texture, &texture_repr, sizeof(SceGxmTexture)) == 0) {
-                    info->dirty = true;
-                }
-
-                return true;
-            });
+            upload_bytes += info->texture_size;
         }
 
+        if (!info->use_hash)
+            info->write_sequence = track_writes(mem, range_protect_begin, range_protect_end - range_protect_begin);
+
         upload_done();
         if (export_textures && !importing_texture)
             export_done();
@@ -782,14 +933,135 @@ void TextureCache::cache_and_bind_texture(const SceGxmTexture &gxm_texture, MemS
     }
     importing_texture = false;
 
+    if (configure) {
+        memory_used -= info->memory_size;
+        info->memory_size = get_texture_memory_size();
+        memory_used += info->memory_size;
+    }
+
     // set the texture as the mru
     texture_queue.set_as_mru(info);
+    if (memory_budget > 0 && memory_used > memory_budget)
+        evict_over_budget();
 
     // retrieve the appropriate sampler if needed
     if (use_sampler_cache)
         cache_and_bind_sampler(gxm_texture);
 }
 
+// formats which are given to upload_texture_impl without any conversion
+static bool is_uploaded_as_is(SceGxmTextureBaseFormat base_format) {
+    if (gxm::is_block_compressed_format(base_format) || gxm::is_paletted_format(base_format) || gxm::is_yuv_format(base_format))
+        return false;
+
+    switch (base_format) {
+    case SCE_GXM_TEXTURE_BASE_FORMAT_U8U3U3U2:
+    case SCE_GXM_TEXTURE_BASE_FORMAT_SE5M9M9M9:
+    case SCE_GXM_TEXTURE_BASE_FORMAT_U2F10F10F10:
+    case SCE_GXM_TEXTURE_BASE_FORMAT_X8U24:
+    case SCE_GXM_TEXTURE_BASE_FORMAT_F32M:
+        return false;
+    default:
+        return true;
+    }
+}
+
+bool TextureCache::upload_written_rows(const SceGxmTexture &gxm_texture, MemState &mem, Address range_begin, Address range_end, uint32_t texture_size, uint32_t write_sequence) {
+    R_PROFILE(__func__);
+
+    const SceGxmTextureBaseFormat base_format = gxm::get_base_format(gxm::get_format(gxm_texture));
+    const auto texture_type = gxm_texture.texture_type();
+    const uint32_t width = gxm::get_width(gxm_texture);
+    const uint32_t height = gxm::get_height(gxm_texture);
+    // the other mips are computed from the first one, they would have to be uploaded too
+    if (!support_partial_upload || (texture_type != SCE_GXM_TEXTURE_LINEAR && texture_type != SCE_GXM_TEXTURE_LINEAR_STRIDED)
+        || get_upload_mip(gxm_texture.true_mip_count(), width, height) > 1 || !is_uploaded_as_is(base_format))
+        return false;
+
+    // same stride as in upload_texture
+    const uint32_t bytes_per_pixel = gxm::bits_per_pixel(base_format) / 8;
+    const uint32_t pixels_per_stride = (texture_type == SCE_GXM_TEXTURE_LINEAR_STRIDED)
+        ? gxm::get_stride_in_bytes(gxm_texture) / bytes_per_pixel
+        : align(width, 8);
+    const uint32_t stride = pixels_per_stride * bytes_per_pixel;
+    const Address data_addr = gxm_texture.data_addr << 2;
+
+    // written pages are grouped in runs, each run is uploaded with a single copy
+    // writes to the partial pages at both ends of the texture are not tracked, they are uploaded along the first and last pages
+    uint32_t nb_rows_uploaded = 0;
+    Address run_begin = 0;
+    for (Address page = range_begin; page <= range_end; page += mem.page_size) {
+        const bool is_written = page < range_end && was_written_since(mem, page, mem.page_size, write_sequence);
+        if (is_written) {
+            if (run_begin == 0)
+                run_begin = page;
+            continue;
+        }
+        if (run_begin == 0)
+            continue;
+
+        const Address begin = (run_begin == range_begin) ? data_addr : run_begin;
+        const Address end = (page == range_end) ? data_addr + texture_size : page;
+        const uint32_t first_row = (begin - data_addr) / stride;
+        const uint32_t last_row = std::min(height, (end - data_addr + stride - 1) / stride);
+        if (last_row > first_row) {
+            const Ptr<const uint8_t> rows(data_addr + first_row * stride);
+            upload_texture_region_impl(base_format, width, first_row, last_row - first_row, rows.get(mem), pixels_per_stride);
+            nb_rows_uploaded += last_row - first_row;
+            upload_bytes += (last_row - first_row) * stride;
+        }
+        run_begin = 0;
+    }
+
+    // was_written_since is also true for writes which happened before track_writes, upload everything in this case
+    if (nb_rows_uploaded == 0)
+        return false;
+
+    nb_partial_uploads++;
+    return true;
+}
+
+void TextureCache::evict(TextureCacheInfo *info) {
+    texture_lookup.erase(std::bit_cast<TextureGxmDataRepr>(info->texture));
+    memory_used -= info->memory_size;
+    info->memory_size = 0;
+    info->texture_size = 0;
+    info->is_imported = false;
+    cancel_pending_import(info);
+    nb_textures--;
+    nb_evictions++;
+    free_texture(info->index);
+}
+
+void TextureCache::evict_over_budget() {
+    R_PROFILE(__func__);
+
+    // the free slots are the least recently used items, the oldest texture comes right after them
+    lru::Item<TextureCacheInfo> *item = texture_queue.head->prev;
+    // keep enough textures for all the texture units of a draw
+    while (memory_used > memory_budget && nb_textures > SCE_GXM_MAX_TEXTURE_UNITS * 2) {
+        while (item->content.texture_size == 0)
+            item = item->prev;
+
+        lru::Item<TextureCacheInfo> *newer_item = item->prev;
+        evict(&item->content);
+        texture_queue.set_as_lru(&item->content);
+        item = newer_item;
+    }
+}
+
+void TextureCache::log_stats() const {
+    const uint64_t nb_lookups = nb_hits + nb_misses;
+    if (nb_lookups == 0)
+        return;
+
+    LOG_INFO("Texture cache: {} hits, {} misses ({:.1f}% hit rate), {} evictions, {} partial uploads, {} MiB uploaded", nb_hits, nb_misses, nb_hits * 100.0 / nb_lookups, nb_evictions, nb_partial_uploads, upload_bytes / (1024 * 1024));
+    if (memory_budget > 0)
+        LOG_INFO("Texture cache: {} textures using {} MiB out of a {} MiB budget", nb_textures, memory_used / (1024 * 1024), memory_budget / (1024 * 1024));
+    else
+        LOG_INFO("Texture cache: {} textures using {} MiB", nb_textures, memory_used / (1024 * 1024));
+}
+
 int TextureCache::cache_and_bind_sampler(const SceGxmTexture &gxm_texture, bool is_depth) {
     uint32_t compact_repr = 0;
     if (gxm_texture.texture_type() != SCE_GXM_TEXTURE_LINEAR_STRIDED) {
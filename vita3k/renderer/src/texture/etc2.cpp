@@ -0,0 +1,281 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/*
+Fast ETC2 RGBA8 encoder, used to keep BCn textures compressed on GPUs which only support ETC2
+The color part only uses the ETC1 individual and differential modes (which are valid ETC2 blocks),
+the alpha part is a regular EAC block. This favors speed over quality, textures are only encoded once.
+*/
+
+#include <renderer/functions.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace renderer::texture {
+
+static constexpr int ETC1_MODIFIERS[8][2] = {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static constexpr int EAC_MODIFIERS[16][8] = {
+    { -3, -6, -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 },
+    { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 },
+    { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 },
+    { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 },
+    { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 },
+    { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 },
+    { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 },
+    { -3, -5, -7, -9, 2, 4, 6, 8 },
+};
+
+// texels are stored in the block in column-major order
+static uint32_t texel_index(uint32_t x, uint32_t y) {
+    return x * 4 + y;
+}
+
+struct SubBlockEncoding {
+    uint32_t error = std::numeric_limits<uint32_t>::max();
+    uint32_t table = 0;
+    // 2-bit selector of each texel of the block, only the texels of the sub-block are set
+    uint32_t msb = 0;
+    uint32_t lsb = 0;
+};
+
+// find the best modifier table for the 8 texels of a sub-block with this base color
+static SubBlockEncoding encode_sub_block(const uint8_t (*texels)[4], bool flip, int sub_block, const int base[3]) {
+    SubBlockEncoding best;
+    for (uint32_t table = 0; table < 8; table++) {
+        SubBlockEncoding current;
+        current.table = table;
+        current.error = 0;
+
+        // selectors 0 and 1 are the positive modifiers, 2 and 3 the negative ones
+        int colors[4][3];
+        for (uint32_t selector = 0; selector < 4; selector++) {
+            const int modifier = (selector & 2) ? -ETC1_MODIFIERS[table][selector & 1] : ETC1_MODIFIERS[table][selector & 1];
+            for (int c = 0; c < 3; c++)
+                colors[selector][c] = std::clamp(base[c] + modifier, 0, 255);
+        }
+
+        for (uint32_t i = 0; i < 8; i++) {
+            // position of the texel in the block
+            const uint32_t x = flip ? (i % 4) : (sub_block * 2 + i / 4);
+            const uint32_t y = flip ? (sub_block * 2 + i / 4) : (i % 4);
+            const uint8_t *texel = texels[y * 4 + x];
+
+            uint32_t best_error = std::numeric_limits<uint32_t>::max();
+            uint32_t best_selector = 0;
+            for (uint32_t selector = 0; selector < 4; selector++) {
+                uint32_t error = 0;
+                for (int c = 0; c < 3; c++) {
+                    const int diff = colors[selector][c] - texel[c];
+                    error += diff * diff;
+                }
+                if (error < best_error) {
+                    best_error = error;
+                    best_selector = selector;
+                }
+            }
+
+            current.error += best_error;
+            const uint32_t index = texel_index(x, y);
+            current.msb |= (best_selector >> 1) << index;
+            current.lsb |= (best_selector & 1) << index;
+        }
+
+        if (current.error < best.error)
+            best = current;
+    }
+
+    return best;
+}
+
+static uint64_t encode_color_block(const uint8_t (*texels)[4]) {
+    uint64_t best_block = 0;
+    uint32_t best_error = std::numeric_limits<uint32_t>::max();
+
+    for (int flip = 0; flip < 2; flip++) {
+        // average color of both sub-blocks
+        int average[2][3] = {};
+        for (uint32_t y = 0; y < 4; y++) {
+            for (uint32_t x = 0; x < 4; x++) {
+                const int sub_block = flip ? (y / 2) : (x / 2);
+                for (int c = 0; c < 3; c++)
+                    average[sub_block][c] += texels[y * 4 + x][c];
+            }
+        }
+
+        // try the differential mode first, it has a better precision
+        int quantized[2][3];
+        bool is_differential = true;
+        for (int c = 0; c < 3; c++) {
+            for (int s = 0; s < 2; s++)
+                quantized[s][c] = (average[s][c] * 31 + 8 * 255 / 2) / (8 * 255);
+            const int diff = quantized[1][c] - quantized[0][c];
+            is_differential &= diff >= -4 && diff <= 3;
+        }
+
+        int base[2][3];
+        if (is_differential) {
+            for (int s = 0; s < 2; s++)
+                for (int c = 0; c < 3; c++)
+                    base[s][c] = (quantized[s][c] << 3) | (quantized[s][c] >> 2);
+        } else {
+            for (int s = 0; s < 2; s++) {
+                for (int c = 0; c < 3; c++) {
+                    quantized[s][c] = (average[s][c] * 15 + 8 * 255 / 2) / (8 * 255);
+                    base[s][c] = quantized[s][c] * 0x11;
+                }
+            }
+        }
+
+        const SubBlockEncoding first = encode_sub_block(texels, flip, 0, base[0]);
+        const SubBlockEncoding second = encode_sub_block(texels, flip, 1, base[1]);
+        const uint32_t error = first.error + second.error;
+        if (error >= best_error)
+            continue;
+
+        uint64_t block = 0;
+        for (int c = 0; c < 3; c++) {
+            // red is in the most significant byte
+            const int shift = 56 - c * 8;
+            if (is_differential)
+                block |= static_cast<uint64_t>((quantized[0][c] << 3) | ((quantized[1][c] - quantized[0][c]) & 0x7)) << shift;
+            else
+                block |= static_cast<uint64_t>((quantized[0][c] << 4) | quantized[1][c]) << shift;
+        }
+        block |= static_cast<uint64_t>(first.table) << 37;
+        block |= static_cast<uint64_t>(second.table) << 34;
+        block |= static_cast<uint64_t>(is_differential) << 33;
+        block |= static_cast<uint64_t>(flip) << 32;
+        block |= static_cast<uint64_t>(first.msb | second.msb) << 16;
+        block |= first.lsb | second.lsb;
+
+        best_block = block;
+        best_error = error;
+    }
+
+    return best_block;
+}
+
+static uint64_t encode_alpha_block(const uint8_t (*texels)[4]) {
+    int min_alpha = 255;
+    int max_alpha = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        min_alpha = std::min<int>(min_alpha, texels[i][3]);
+        max_alpha = std::max<int>(max_alpha, texels[i][3]);
+    }
+
+    if (min_alpha == max_alpha) {
+        // table 13 has a modifier of 0 for the selector 4
+        uint64_t block = (static_cast<uint64_t>(min_alpha) << 56) | (1ULL << 52) | (13ULL << 48);
+        for (uint32_t i = 0; i < 16; i++)
+            block |= 4ULL << (45 - i * 3);
+        return block;
+    }
+
+    uint64_t best_block = 0;
+    uint32_t best_error = std::numeric_limits<uint32_t>::max();
+    for (uint32_t table = 0; table < 16; table++) {
+        const int *modifiers = EAC_MODIFIERS[table];
+        // modifiers[3] is the lowest modifier and modifiers[7] the highest one
+        const int range = modifiers[7] - modifiers[3];
+        const int multiplier = std::clamp((max_alpha - min_alpha + range - 1) / range, 1, 15);
+
+        // also try the largest multiplier, the clamping makes it exact for blocks using only 0 and 255
+        const int candidates[] = { multiplier - 1, multiplier, multiplier + 1, 15 };
+        for (const int mul : candidates) {
+            if (mul < 1 || mul > 15)
+                continue;
+
+            const int base = std::clamp((min_alpha + max_alpha - (modifiers[3] + modifiers[7]) * mul + 1) / 2, 0, 255);
+            int values[8];
+            for (uint32_t selector = 0; selector < 8; selector++)
+                values[selector] = std::clamp(base + modifiers[selector] * mul, 0, 255);
+
+            uint64_t block = (static_cast<uint64_t>(base) << 56) | (static_cast<uint64_t>(mul) << 52) | (static_cast<uint64_t>(table) << 48);
+            uint32_t error = 0;
+            for (uint32_t y = 0; y < 4 && error < best_error; y++) {
+                for (uint32_t x = 0; x < 4; x++) {
+                    const int alpha = texels[y * 4 + x][3];
+                    int best_texel_error = std::abs(values[0] - alpha);
+                    uint32_t best_selector = 0;
+                    for (uint32_t selector = 1; selector < 8; selector++) {
+                        const int texel_error = std::abs(values[selector] - alpha);
+                        if (texel_error < best_texel_error) {
+                            best_texel_error = texel_error;
+                            best_selector = selector;
+                        }
+                    }
+                    error += best_texel_error * best_texel_error;
+                    block |= static_cast<uint64_t>(best_selector) << (45 - texel_index(x, y) * 3);
+                }
+            }
+
+            if (error < best_error) {
+                best_error = error;
+                best_block = block;
+            }
+        }
+
+        if (best_error == 0)
+            break;
+    }
+
+    return best_block;
+}
+
+static void store_big_endian(uint64_t value, uint8_t *dest) {
+    for (int i = 0; i < 8; i++)
+        dest[i] = static_cast<uint8_t>(value >> (56 - i * 8));
+}
+
+void compress_etc2_rgba8_image(uint32_t width, uint32_t height, const uint32_t *image, uint8_t *block_storage) {
+    const uint32_t block_count_x = (width + 3) / 4;
+    const uint32_t block_count_y = (height + 3) / 4;
+    // same layout as the output of decompress_bc_image
+    const uint32_t line_size = block_count_x * 4;
+
+    for_each_block_rows(block_count_y, block_count_x * block_count_y, [=](uint32_t first_row, uint32_t last_row) {
+        uint8_t texels[16][4];
+        uint8_t *block = block_storage + first_row * block_count_x * 16;
+        for (uint32_t j = first_row; j < last_row; j++) {
+            for (uint32_t i = 0; i < block_count_x; i++) {
+                for (uint32_t row = 0; row < 4; row++)
+                    memcpy(texels[row * 4], &image[(j * 4 + row) * line_size + i * 4], 4 * sizeof(uint32_t));
+
+                // the alpha block comes first
+                store_big_endian(encode_alpha_block(texels), block);
+                store_big_endian(encode_color_block(texels), block + 8);
+                block += 16;
+            }
+        }
+    });
+}
+
+} // namespace renderer::texture
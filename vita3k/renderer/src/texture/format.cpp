@@ -19,11 +19,31 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
 
 #include <gxm/types.h>
 #include <renderer/functions.h>
 #include <renderer/pvrt-dec.h>
+#include <threads/job_pool.h>
 #include <util/log.h>
+#include <util/profile.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BCN_AVX2
+#include <util/instrset_detect.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((__target__("avx2")))
+#include <immintrin.h>
+#else
+#define TARGET_AVX2
+#include <intrin.h>
+#endif
+#endif
 
 namespace renderer::texture {
 
@@ -343,27 +363,52 @@ uint32_t encode_morton(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
     return result;
 }
 
+// the pixel size is known at compile time so that the copy of each pixel is a single load and store
+template <uint32_t bytes_per_pixel>
+static void swizzled_texture_to_linear_texture_impl(uint8_t *dest, const uint8_t *src, uint32_t width, uint32_t height, uint32_t pixel_size = bytes_per_pixel) {
+    const uint32_t min = std::min(width, height);
+    const uint32_t k = std::bit_width(min) - 1;
+
+    // the morton code is the or of a part depending only on x and another depending only on y (see encode_morton),
+    // so the x part is computed once for each column and the y part once for each row
+    std::vector<uint32_t> x_codes(width);
+    for (uint32_t x = 0; x < width; x++)
+        x_codes[x] = ((x >> k) << (2 * k)) | (Part1By1(x & (min - 1)) << 1);
+
+    for (uint32_t y = 0; y < height; y++) {
+        const uint32_t y_code = ((y >> k) << (2 * k)) | Part1By1(y & (min - 1));
+        uint8_t *dest_row = dest + y * width * pixel_size;
+        for (uint32_t x = 0; x < width; x++)
+            memcpy(dest_row + x * pixel_size, src + (y_code | x_codes[x]) * pixel_size, bytes_per_pixel ? bytes_per_pixel : pixel_size);
+    }
+}
+
 void swizzled_texture_to_linear_texture(uint8_t *dest, const uint8_t *src, uint16_t width, uint16_t height, uint8_t bits_per_pixel) {
     if (bits_per_pixel % 8 != 0) {
         // Don't support yet
         return;
     }
 
-    uint8_t bytes_per_pixel = (bits_per_pixel + 7) >> 3;
-    uint32_t min = std::min(width, height);
-    uint32_t k = std::bit_width(min) - 1;
-
-    for (uint32_t i = 0; i < width * static_cast<uint32_t>(height); i++) {
-        uint32_t x = decode_morton2_x(i) & (min - 1);
-        uint32_t y = decode_morton2_y(i) & (min - 1);
-        uint32_t upper_bits = (i >> (2 * k)) << k;
-        if (width >= height) {
-            x |= upper_bits;
-        } else {
-            y |= upper_bits;
-        }
-
-        memcpy(dest + (y * width + x) * bytes_per_pixel, src + i * bytes_per_pixel, bytes_per_pixel);
+    const uint32_t bytes_per_pixel = bits_per_pixel >> 3;
+    switch (bytes_per_pixel) {
+    case 1:
+        swizzled_texture_to_linear_texture_impl<1>(dest, src, width, height);
+        break;
+    case 2:
+        swizzled_texture_to_linear_texture_impl<2>(dest, src, width, height);
+        break;
+    case 4:
+        swizzled_texture_to_linear_texture_impl<4>(dest, src, width, height);
+        break;
+    case 8:
+        swizzled_texture_to_linear_texture_impl<8>(dest, src, width, height);
+        break;
+    case 16:
+        swizzled_texture_to_linear_texture_impl<16>(dest, src, width, height);
+        break;
+    default:
+        swizzled_texture_to_linear_texture_impl<0>(dest, src, width, height, bytes_per_pixel);
+        break;
     }
 }
 
@@ -377,16 +422,16 @@ void tiled_texture_to_linear_texture(uint8_t *dest, const uint8_t *src, uint16_t
     const uint32_t bpp = bits_per_pixel >> 3;
     const uint32_t width_in_tiles = (width + 31) >> 5;
 
-    for (uint16_t y = 0; y < height; y++) {
-        for (uint16_t x = 0; x < width; x++) {
-            // Calculate texel address in tile
-            const uint32_t texel_offset_in_tile = (x & 0b11111) | ((y & 0b11111) << 5);
-            const uint32_t tile_address = (x >> 5) + width_in_tiles * (y >> 5);
-
-            const uint32_t offset = ((tile_address << 10) | (texel_offset_in_tile)) * bpp;
+    // the 32 texels of a tile on the same line are contiguous, copy them at once
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t *dest_row = dest + y * width * bpp;
+        for (uint32_t tile_x = 0; tile_x < width_in_tiles; tile_x++) {
+            const uint32_t tile_address = tile_x + width_in_tiles * (y >> 5);
+            const uint32_t offset = ((tile_address << 10) | ((y & 0b11111) << 5)) * bpp;
+            const uint32_t nb_texels = std::min(32U, width - tile_x * 32);
 
             // Make scanline
-            memcpy(dest + ((y * width) + x) * bpp, src + offset, bpp);
+            memcpy(dest_row + tile_x * 32 * bpp, src + offset, nb_texels * bpp);
         }
     }
 }
@@ -404,6 +449,7 @@ uint32_t get_compressed_size(SceGxmTextureBaseFormat base_format, uint32_t width
     case SCE_GXM_TEXTURE_BASE_FORMAT_UBC6H:
     case SCE_GXM_TEXTURE_BASE_FORMAT_SBC6H:
     case SCE_GXM_TEXTURE_BASE_FORMAT_UBC7:
+    case SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8:
         return ((width + 3) / 4) * ((height + 3) / 4) * 16;
 
         // each ASTC block is always 128 bits (16 bytes)
@@ -433,6 +479,56 @@ uint32_t get_compressed_size(SceGxmTextureBaseFormat base_format, uint32_t width
  * \param block_storage     pointer to the block to decompress.
  * \param image             pointer to image where the decompressed pixel data should be stored.
  **/
+static void write_bc1_texels_basic(const uint32_t colors[4], uint32_t indices, uint32_t *image) {
+    for (int i = 0; i < 16; ++i) {
+        image[i] = colors[indices & 0x03];
+        indices >>= 2;
+    }
+}
+
+#if defined(__aarch64__)
+static void write_bc1_texels(const uint32_t colors[4], uint32_t indices, uint32_t *image) {
+    const uint8x16_t palette = vreinterpretq_u8_u32(vld1q_u32(colors));
+    const int32x4_t shifts = { 0, -2, -4, -6 };
+    for (int row = 0; row < 4; row++) {
+        // index of each texel of the row, then the offset of each of its bytes in the palette
+        const uint32x4_t row_indices = vandq_u32(vshlq_u32(vdupq_n_u32(indices >> (row * 8)), shifts), vdupq_n_u32(0x03));
+        const uint8x16_t bytes = vreinterpretq_u8_u32(vmlaq_n_u32(vdupq_n_u32(0x03020100), row_indices, 0x04040404));
+        vst1q_u32(image + row * 4, vreinterpretq_u32_u8(vqtbl1q_u8(palette, bytes)));
+    }
+}
+#elif defined(BCN_AVX2)
+static void TARGET_AVX2 write_bc1_texels_avx2(const uint32_t colors[4], uint32_t indices, uint32_t *image) {
+    // only the first four lanes are ever selected
+    const __m256i palette = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(colors)));
+    const __m256i shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+    const __m256i mask = _mm256_set1_epi32(0x03);
+
+    // two rows of the block at a time
+    const __m256i low_indices = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(indices), shifts), mask);
+    const __m256i high_indices = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(indices >> 16), shifts), mask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(image), _mm256_permutevar8x32_epi32(palette, low_indices));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(image + 8), _mm256_permutevar8x32_epi32(palette, high_indices));
+}
+
+// same as in gxm/stream.cpp, the implementation is chosen the first time it is used
+static void write_bc1_texels_init(const uint32_t colors[4], uint32_t indices, uint32_t *image);
+
+static void (*write_bc1_texels)(const uint32_t colors[4], uint32_t indices, uint32_t *image) = write_bc1_texels_init;
+
+void write_bc1_texels_init(const uint32_t colors[4], uint32_t indices, uint32_t *image) {
+    if (util::instrset::instrset_detect() >= util::instrset::instrset_AVX2)
+        write_bc1_texels = write_bc1_texels_avx2;
+    else
+        write_bc1_texels = write_bc1_texels_basic;
+    write_bc1_texels(colors, indices, image);
+}
+#else
+static void write_bc1_texels(const uint32_t colors[4], uint32_t indices, uint32_t *image) {
+    write_bc1_texels_basic(colors, indices, image);
+}
+#endif
+
 static void decompress_block_bc1(const uint8_t *block_storage, uint32_t *image) {
     std::uint16_t n0 = static_cast<std::uint16_t>((block_storage[1] << 8) | block_storage[0]);
     std::uint16_t n1 = static_cast<std::uint16_t>((block_storage[3] << 8) | block_storage[2]);
@@ -454,8 +550,9 @@ static void decompress_block_bc1(const uint8_t *block_storage, uint32_t *image)
     b0 |= b0 >> 5;
     b1 |= b1 >> 5;
 
-    std::uint32_t c0 = 0xFF000000 | (b0 << 16) | (g0 << 8) | r0;
-    std::uint32_t c1 = 0xFF000000 | (b1 << 16) | (g1 << 8) | r1;
+    std::uint32_t colors[4];
+    colors[0] = 0xFF000000 | (b0 << 16) | (g0 << 8) | r0;
+    colors[1] = 0xFF000000 | (b1 << 16) | (g1 << 8) | r1;
 
     if (n0 > n1) {
         std::uint8_t r2 = static_cast<uint8_t>((2 * r0 + r1 + 1) / 3);
@@ -465,52 +562,22 @@ static void decompress_block_bc1(const uint8_t *block_storage, uint32_t *image)
         std::uint8_t b2 = static_cast<uint8_t>((2 * b0 + b1 + 1) / 3);
         std::uint8_t b3 = static_cast<uint8_t>((2 * b1 + b0 + 1) / 3);
 
-        std::uint32_t c2 = 0xFF000000 | (b2 << 16) | (g2 << 8) | r2;
-        std::uint32_t c3 = 0xFF000000 | (b3 << 16) | (g3 << 8) | r3;
-
-        for (int i = 0; i < 16; ++i) {
-            int index = (block_storage[i / 4] >> (i % 4 * 2)) & 0x03;
-            switch (index) {
-            case 0:
-                image[i] = c0;
-                break;
-            case 1:
-                image[i] = c1;
-                break;
-            case 2:
-                image[i] = c2;
-                break;
-            case 3:
-                image[i] = c3;
-                break;
-            }
-        }
+        colors[2] = 0xFF000000 | (b2 << 16) | (g2 << 8) | r2;
+        colors[3] = 0xFF000000 | (b3 << 16) | (g3 << 8) | r3;
     } else {
         // Transparent decode
         std::uint8_t r2 = static_cast<uint8_t>((r0 + r1) / 2);
         std::uint8_t g2 = static_cast<uint8_t>((g0 + g1) / 2);
         std::uint8_t b2 = static_cast<uint8_t>((b0 + b1) / 2);
 
-        std::uint32_t c2 = 0xFF000000 | (b2 << 16) | (g2 << 8) | r2;
-
-        for (int i = 0; i < 16; ++i) {
-            int index = (block_storage[i / 4] >> (i % 4 * 2)) & 0x03;
-            switch (index) {
-            case 0:
-                image[i] = c0;
-                break;
-            case 1:
-                image[i] = c1;
-                break;
-            case 2:
-                image[i] = c2;
-                break;
-            case 3:
-                image[i] = 0x00000000;
-                break;
-            }
-        }
+        colors[2] = 0xFF000000 | (b2 << 16) | (g2 << 8) | r2;
+        colors[3] = 0x00000000;
     }
+
+    // 2 bits per texel, the first texel in the lowest bits
+    uint32_t indices;
+    memcpy(&indices, block_storage, sizeof(indices));
+    write_bc1_texels(colors, indices, image);
 }
 
 /**
@@ -697,28 +764,56 @@ static void decompress_block_bc5s(const uint8_t *block_storage, uint16_t *image)
     decompress_block_alpha_signed(block_storage + 8, reinterpret_cast<uint8_t *>(image), 1, 2);
 }
 
+// the work is split between threads above this number of blocks, 256x256 texels
+static constexpr uint32_t PARALLEL_MIN_BLOCKS = 64 * 64;
+
+void for_each_block_rows(uint32_t block_count_y, uint32_t block_count, const std::function<void(uint32_t, uint32_t)> &func) {
+    // the threads are shared by all the textures and only started the first time a large one is processed
+    static JobPool pool;
+    static const int nb_threads = static_cast<int>(std::min(std::thread::hardware_concurrency(), 4U));
+
+    if (nb_threads <= 1 || block_count < PARALLEL_MIN_BLOCKS) {
+        func(0, block_count_y);
+        return;
+    }
+
+    static std::once_flag pool_started;
+    std::call_once(pool_started, [] { pool.start(nb_threads - 1, [] { PROFILE_THREAD_NAME("Texture decoder"); }); });
+
+    // the calling thread takes care of the first chunk
+    const uint32_t rows_per_chunk = (block_count_y + nb_threads - 1) / nb_threads;
+    std::vector<std::future<void>> chunks;
+    for (uint32_t first_row = rows_per_chunk; first_row < block_count_y; first_row += rows_per_chunk)
+        chunks.push_back(pool.submit([=, &func] { func(first_row, std::min(first_row + rows_per_chunk, block_count_y)); }));
+    func(0, std::min(rows_per_chunk, block_count_y));
+    for (auto &chunk : chunks)
+        chunk.wait();
+}
+
 void decompress_bc_image(uint32_t width, uint32_t height, const uint8_t *block_storage, uint32_t *image, const uint8_t format_id) {
     const uint32_t block_count_x = (width + 3) / 4;
     const uint32_t block_count_y = (height + 3) / 4;
     const uint32_t block_size = (format_id != 1 && format_id != 4 && format_id != 5) ? 16 : 8;
     const uint32_t line_size = block_count_x * 4;
 
-    auto decompress_bcn = [=, &block_storage]<typename T, typename F>(T _, F decompress_func) {
-        T temp_block_result[16] = {};
-        T *img = reinterpret_cast<T *>(image);
+    auto decompress_bcn = [=]<typename T, typename F>(T _, F decompress_func) {
+        for_each_block_rows(block_count_y, block_count_x * block_count_y, [=](uint32_t first_row, uint32_t last_row) {
+            T temp_block_result[16] = {};
+            T *img = reinterpret_cast<T *>(image);
+            const uint8_t *block = block_storage + first_row * block_count_x * block_size;
 
-        for (uint32_t j = 0; j < block_count_y; j++) {
-            for (uint32_t i = 0; i < block_count_x; i++) {
-                decompress_func(block_storage, temp_block_result);
+            for (uint32_t j = first_row; j < last_row; j++) {
+                for (uint32_t i = 0; i < block_count_x; i++) {
+                    decompress_func(block, temp_block_result);
 
-                const uint32_t offset = j * 4 * line_size + i * 4;
-                for (uint32_t delta = 0; delta < 16; delta++) {
-                    img[offset + (delta % 4) + ((delta / 4) * line_size)] = temp_block_result[delta];
-                }
+                    const uint32_t offset = j * 4 * line_size + i * 4;
+                    for (uint32_t row = 0; row < 4; row++)
+                        memcpy(&img[offset + row * line_size], &temp_block_result[row * 4], 4 * sizeof(T));
 
-                block_storage += block_size;
+                    block += block_size;
+                }
             }
-        }
+        });
     };
 
     switch (format_id) {
@@ -745,6 +745,15 @@ static int pvrtcDecompress(uint8_t *pCompressedData, Pixel32 *pDecompressedData,
     PVRTCWordIndices indices;
     std::vector<Pixel32> pPixels(ui32WordWidth * ui32WordHeight);
 
+    // The twiddled offset of a word is the bitwise or of the offsets of its column and its row,
+    // so they are computed once for the whole texture instead of four times per word.
+    std::vector<uint32_t> columnOffsets(i32NumXWords);
+    std::vector<uint32_t> rowOffsets(i32NumYWords);
+    for (int x = 0; x < i32NumXWords; x++)
+        columnOffsets[x] = TwiddleUV(i32NumXWords, i32NumYWords, x, 0);
+    for (int y = 0; y < i32NumYWords; y++)
+        rowOffsets[y] = TwiddleUV(i32NumXWords, i32NumYWords, 0, y);
+
     // For each row of words
     for (int wordY = -1; wordY < i32NumYWords - 1; wordY++) {
         // for each column of words
@@ -760,10 +769,10 @@ static int pvrtcDecompress(uint8_t *pCompressedData, Pixel32 *pDecompressedData,
 
             // Work out the offsets into the twiddle structs, multiply by two as there are two members per word.
             uint32_t WordOffsets[4] = {
-                TwiddleUV(i32NumXWords, i32NumYWords, indices.P[0], indices.P[1]) * 2,
-                TwiddleUV(i32NumXWords, i32NumYWords, indices.Q[0], indices.Q[1]) * 2,
-                TwiddleUV(i32NumXWords, i32NumYWords, indices.R[0], indices.R[1]) * 2,
-                TwiddleUV(i32NumXWords, i32NumYWords, indices.S[0], indices.S[1]) * 2,
+                (columnOffsets[indices.P[0]] | rowOffsets[indices.P[1]]) * 2,
+                (columnOffsets[indices.Q[0]] | rowOffsets[indices.Q[1]]) * 2,
+                (columnOffsets[indices.R[0]] | rowOffsets[indices.R[1]]) * 2,
+                (columnOffsets[indices.S[0]] | rowOffsets[indices.S[1]]) * 2,
             };
 
             // Access individual elements to fill out PVRTCWord
@@ -22,6 +22,7 @@
 #include "util/align.h"
 #include "util/float_to_half.h"
 #include "util/log.h"
+#include "util/profile.h"
 
 #include <ddspp.h>
 #include <fmt/format.h>
@@ -70,10 +71,12 @@ void TextureCache::set_replacement_state(bool import_textures, bool export_textu
     this->export_textures = export_textures;
     this->save_as_png = export_as_png;
 
-    // invalidate all the current textures, will force all of them to be re-uploaded next frame
+    // evict all the current textures, will force all of them to be configured and uploaded again next frame
     for (auto &queue_item : texture_queue.items) {
-        queue_item.content.hash = 0;
-        queue_item.content.dirty = true;
+        if (queue_item.content.texture_size > 0) {
+            evict(&queue_item.content);
+            texture_queue.set_as_lru(&queue_item.content);
+        }
     }
 
     refresh_available_textures();
@@ -436,149 +439,246 @@ void TextureCache::export_done() {
     exporting_texture = false;
 }
 
-bool TextureCache::import_configure_texture() {
-    uint64_t hash = current_info->hash;
-    const std::string file_name = fmt::format("{:016X}.{}", hash, loading_texture.is_dds ? "dds" : "png");
-    fs::path import_name = *loading_texture.folder_path / file_name;
+ImportedTexture::ImportedTexture() = default;
+
+ImportedTexture::~ImportedTexture() {
+    if (!is_dds && decoded)
+        stbi_image_free(decoded);
+}
+
+std::shared_ptr<ImportedTexture> TextureCache::load_imported_texture(uint64_t hash, const AvailableTexture &available, uint32_t nb_comp, bool is_cube) const {
+    const std::string file_name = fmt::format("{:016X}.{}", hash, available.is_dds ? "dds" : "png");
+    fs::path import_name = *available.folder_path / file_name;
 
     if (!fs::exists(import_name)) {
         LOG_ERROR("Texture {} was listed as available but was not found", file_name);
-        return false;
+        return nullptr;
     }
 
-    SceGxmTexture &gxm_texture = current_info->texture;
-    const SceGxmTextureBaseFormat format = gxm::get_base_format(gxm::get_format(gxm_texture));
-    uint32_t nb_comp = gxm::get_num_components(format);
-
-    const bool is_cube = gxm_texture.texture_type() == SCE_GXM_TEXTURE_CUBE || gxm_texture.texture_type() == SCE_GXM_TEXTURE_CUBE_ARBITRARY;
-    if (is_cube && !loading_texture.is_dds) {
+    if (is_cube && !available.is_dds) {
         LOG_ERROR("Trying to import cubemap as png {}", file_name);
-        return false;
+        return nullptr;
     }
 
-    // with 3-component or 4-component textures with a specific swizzle, upload them as 4 component
-    // (rgb8 textures are not that much supported on modern gpus)
-    if (nb_comp == 3)
-        nb_comp = 4;
-
-    uint32_t width, height;
-    uint16_t mipcount = 1;
-    SceGxmTextureBaseFormat base_format;
-    bool is_srgb = false;
-    bool swap_rb = false;
-    if (loading_texture.is_dds) {
-        if (dds_descriptor == nullptr)
-            dds_descriptor = new ddspp::Descriptor;
+    auto imported = std::make_shared<ImportedTexture>();
+    imported->is_dds = available.is_dds;
+    if (available.is_dds) {
+        imported->dds_descriptor = std::make_unique<ddspp::Descriptor>();
+        ddspp::Descriptor &dds_descriptor = *imported->dds_descriptor;
 
-        auto res = fs_utils::read_data(import_name, imported_texture_raw_data);
+        auto res = fs_utils::read_data(import_name, imported->raw_data);
         if (!res) {
             LOG_ERROR("Failed to read {}", file_name);
-            return false;
+            return nullptr;
         }
-        if (imported_texture_raw_data.size() < ddspp::MAX_HEADER_SIZE) {
-            imported_texture_raw_data.resize(ddspp::MAX_HEADER_SIZE);
+        if (imported->raw_data.size() < ddspp::MAX_HEADER_SIZE) {
+            imported->raw_data.resize(ddspp::MAX_HEADER_SIZE);
         }
 
-        if (ddspp::decode_header(imported_texture_raw_data.data(), *dds_descriptor) != ddspp::Success) {
+        if (ddspp::decode_header(imported->raw_data.data(), dds_descriptor) != ddspp::Success) {
             LOG_ERROR("Failed to decode file {} header", file_name);
-            return false;
+            return nullptr;
         }
 
-        if ((dds_descriptor->type == ddspp::Cubemap) != is_cube) {
+        if ((dds_descriptor.type == ddspp::Cubemap) != is_cube) {
             if (is_cube)
                 LOG_ERROR("Texture {} should be a cubemap but is a 2D texture", file_name);
             else
                 LOG_ERROR("Texture {} should be a 2D texture but is cubemap", file_name);
-            return false;
+            return nullptr;
         }
 
-        width = dds_descriptor->width;
-        height = dds_descriptor->height;
-        mipcount = dds_descriptor->numMips;
-        base_format = dxgi_to_gxm(dds_descriptor->format);
-        if (base_format == SCE_GXM_TEXTURE_BASE_FORMAT_INVALID) {
-            LOG_ERROR("dds format {} used by texture {} is unhandled", fmt::underlying(dds_descriptor->format), file_name);
-            return false;
+        imported->width = dds_descriptor.width;
+        imported->height = dds_descriptor.height;
+        imported->mip_count = dds_descriptor.numMips;
+        imported->format = dxgi_to_gxm(dds_descriptor.format);
+        if (imported->format == SCE_GXM_TEXTURE_BASE_FORMAT_INVALID) {
+            LOG_ERROR("dds format {} used by texture {} is unhandled", fmt::underlying(dds_descriptor.format), file_name);
+            return nullptr;
         }
-        is_srgb = ddspp::is_srgb(dds_descriptor->format);
-        swap_rb = dds_swap_rb(dds_descriptor->format);
+        imported->is_srgb = ddspp::is_srgb(dds_descriptor.format);
+        imported->swap_rb = dds_swap_rb(dds_descriptor.format);
 
-        if (texture::is_astc_format(base_format) && !support_astc) {
+        if (texture::is_astc_format(imported->format) && !support_astc) {
             LOG_ERROR_ONCE("ASTC textures are not support by this device");
-            return false;
+            return nullptr;
         }
 
-        if (gxm::is_bcn_format(base_format) && !support_dxt) {
+        if (gxm::is_bcn_format(imported->format) && !support_dxt && !is_transcoded_to_etc2(imported->format)) {
             LOG_ERROR_ONCE("BCn textures are not supported by this device");
 #ifdef __ANDROID__
             // this issue is most likely to happen on android
             SDL_ShowAndroidToast("BCn textures are not supported by this device!", 1, -1, 0, 0);
 #endif
-            return false;
+            return nullptr;
         }
 
-        imported_texture_decoded = imported_texture_raw_data.data() + dds_descriptor->headerSize;
+        imported->decoded = imported->raw_data.data() + dds_descriptor.headerSize;
+
+        if (is_transcoded_to_etc2(imported->format)) {
+            // BC1/2/3 replacements are transcoded like the original textures, this is the slowest part of the loading
+            auto [block_width, _] = gxm::get_block_size(imported->format);
+            std::vector<uint8_t> decompressed_data;
+            for (uint32_t face = 0; face < (is_cube ? 6 : 1); face++) {
+                uint32_t width = imported->width;
+                uint32_t height = imported->height;
+                for (uint32_t mip = 0; mip < imported->mip_count; mip++) {
+                    const uint8_t *mip_data = imported->decoded + ddspp::get_offset(dds_descriptor, mip, face);
+                    const uint32_t pixels_per_stride = align(width, block_width);
+                    const size_t offset = imported->transcoded_data.size();
+                    decompressed_data.resize(pixels_per_stride * align(height, 4) * 4);
+                    texture::decompress_compressed_texture(imported->format, decompressed_data.data(), mip_data, pixels_per_stride, height);
+                    imported->transcoded_data.resize(offset + texture::get_compressed_size(SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8, pixels_per_stride, height));
+                    texture::compress_etc2_rgba8_image(pixels_per_stride, height, reinterpret_cast<const uint32_t *>(decompressed_data.data()), imported->transcoded_data.data() + offset);
+
+                    width /= 2;
+                    height /= 2;
+                }
+            }
+        }
     } else {
         int nb_channels;
-        imported_texture_decoded = stbi_load(fs_utils::path_to_utf8(import_name).c_str(), reinterpret_cast<int *>(&width), reinterpret_cast<int *>(&height), &nb_channels, nb_comp);
-        if (imported_texture_decoded == nullptr) {
+        imported->decoded = stbi_load(fs_utils::path_to_utf8(import_name).c_str(), reinterpret_cast<int *>(&imported->width), reinterpret_cast<int *>(&imported->height), &nb_channels, nb_comp);
+        if (imported->decoded == nullptr) {
             LOG_ERROR("Failed to decode {}", file_name);
-            return false;
+            return nullptr;
         }
 
         if (nb_comp >= 3 && nb_channels <= 2) {
             LOG_ERROR("Texture {} has {} channels, expected {}", file_name, nb_channels, nb_comp);
-            stbi_image_free(imported_texture_decoded);
-            return false;
+            return nullptr;
         }
 
         if (nb_comp == 1)
-            base_format = SCE_GXM_TEXTURE_BASE_FORMAT_U8;
+            imported->format = SCE_GXM_TEXTURE_BASE_FORMAT_U8;
         else if (nb_comp == 2)
-            base_format = SCE_GXM_TEXTURE_BASE_FORMAT_U8U8;
+            imported->format = SCE_GXM_TEXTURE_BASE_FORMAT_U8U8;
         else
-            base_format = SCE_GXM_TEXTURE_BASE_FORMAT_U8U8U8U8;
+            imported->format = SCE_GXM_TEXTURE_BASE_FORMAT_U8U8U8U8;
     }
 
     if (log_texture_import)
-        LOG_DEBUG("Importing texture {} ({}x{})", file_name, width, height);
+        LOG_DEBUG("Importing texture {} ({}x{})", file_name, imported->width, imported->height);
+
+    return imported;
+}
+
+void TextureCache::set_async_import(bool async_import) {
+    if (this->async_import == async_import)
+        return;
+
+    this->async_import = async_import;
+    if (async_import) {
+        // decoding is mostly single-threaded, leave most of the cores to the emulation
+        import_pool.start(std::clamp<int>(std::thread::hardware_concurrency() / 4, 1, 2), [] { PROFILE_THREAD_NAME("Texture import"); });
+    } else {
+        pending_imports.clear();
+        import_pool.stop();
+    }
+}
+
+std::shared_ptr<ImportedTexture> TextureCache::get_imported_texture(TextureCacheInfo *info, const AvailableTexture &available) {
+    const SceGxmTexture &gxm_texture = info->texture;
+    const SceGxmTextureBaseFormat format = gxm::get_base_format(gxm::get_format(gxm_texture));
+    // with 3-component or 4-component textures with a specific swizzle, upload them as 4 component
+    // (rgb8 textures are not that much supported on modern gpus)
+    uint32_t nb_comp = gxm::get_num_components(format);
+    if (nb_comp == 3)
+        nb_comp = 4;
+    const bool is_cube = gxm_texture.texture_type() == SCE_GXM_TEXTURE_CUBE || gxm_texture.texture_type() == SCE_GXM_TEXTURE_CUBE_ARBITRARY;
+
+    if (!async_import)
+        return load_imported_texture(info->hash, available, nb_comp, is_cube);
+
+    if (info->is_import_pending && info->pending_import_hash != info->hash)
+        // the texture changed before its previous replacement was ready
+        cancel_pending_import(info);
+
+    auto it = pending_imports.find(info->hash);
+    if (it == pending_imports.end()) {
+        // the loader is only given the hash, the texture can be evicted in the meantime
+        it = pending_imports.emplace(info->hash, import_pool.submit([this, hash = info->hash, available, nb_comp, is_cube]() {
+                                return load_imported_texture(hash, available, nb_comp, is_cube);
+                            }))
+                 .first;
+    }
+
+    if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        info->is_import_pending = true;
+        info->pending_import_hash = info->hash;
+        return nullptr;
+    }
+
+    std::shared_ptr<ImportedTexture> imported = it->second.get();
+    pending_imports.erase(it);
+    info->is_import_pending = false;
+    return imported;
+}
+
+void TextureCache::cancel_pending_import(TextureCacheInfo *info) {
+    if (!info->is_import_pending)
+        return;
+
+    // the job keeps running but its result is dropped
+    pending_imports.erase(info->pending_import_hash);
+    info->is_import_pending = false;
+}
+
+void TextureCache::import_configure_texture() {
+    const ImportedTexture &imported = *imported_texture;
+    SceGxmTexture &gxm_texture = current_info->texture;
+    const SceGxmTextureBaseFormat format = gxm::get_base_format(gxm::get_format(gxm_texture));
+    // same as for the loading
+    uint32_t nb_comp = gxm::get_num_components(format);
+    if (nb_comp == 3)
+        nb_comp = 4;
 
     if (current_info->is_imported
-        && current_info->width == width
-        && current_info->height == height
+        && current_info->width == imported.width
+        && current_info->height == imported.height
         && current_info->mip_count == 1
-        && current_info->format == base_format
-        && current_info->is_srgb == is_srgb) {
+        && current_info->format == imported.format
+        && current_info->is_srgb == imported.is_srgb) {
         // no parameter was changed, no need to reconfigure the texture
-        return true;
+        return;
     }
 
     current_info->is_imported = true;
-    current_info->width = width;
-    current_info->height = height;
-    current_info->mip_count = mipcount;
-    current_info->format = base_format;
-    current_info->is_srgb = is_srgb;
-
-    import_configure_impl(base_format, width, height, is_srgb, nb_comp, mipcount, swap_rb);
-    return true;
+    current_info->width = imported.width;
+    current_info->height = imported.height;
+    current_info->mip_count = imported.mip_count;
+    current_info->format = imported.format;
+    current_info->is_srgb = imported.is_srgb;
+
+    // BC1/2/3 replacements are transcoded on upload like the original textures
+    const SceGxmTextureBaseFormat upload_format = is_transcoded_to_etc2(imported.format) ? SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8 : imported.format;
+    import_configure_impl(upload_format, imported.width, imported.height, imported.is_srgb, nb_comp, imported.mip_count, imported.swap_rb);
 }
 
 void TextureCache::import_upload_texture() {
-    if (loading_texture.is_dds) {
-        auto [block_width, _] = gxm::get_block_size(current_info->format);
-        const uint32_t mipcount = current_info->mip_count;
+    const ImportedTexture &imported = *imported_texture;
+    if (imported.is_dds) {
+        auto [block_width, _] = gxm::get_block_size(imported.format);
+        const uint32_t mipcount = imported.mip_count;
         const bool is_cube = current_info->texture.texture_type() == SCE_GXM_TEXTURE_CUBE || current_info->texture.texture_type() == SCE_GXM_TEXTURE_CUBE_ARBITRARY;
+        const bool is_transcoded = !imported.transcoded_data.empty();
+        size_t transcoded_offset = 0;
 
         // upload each face one by one
         for (uint32_t face = 0; face < (is_cube ? 6 : 1); face++) {
-            uint32_t width = current_info->width;
-            uint32_t height = current_info->height;
+            uint32_t width = imported.width;
+            uint32_t height = imported.height;
             // upload each mip one by one
             for (uint32_t mip = 0; mip < mipcount; mip++) {
-                const uint8_t *mip_data = imported_texture_decoded + ddspp::get_offset(*dds_descriptor, mip, face);
                 // dds textures are tightly packed (up to the block size)
-                upload_texture_impl(current_info->format, width, height, mip, mip_data, is_cube + face, align(width, block_width));
+                const uint32_t pixels_per_stride = align(width, block_width);
+                if (is_transcoded) {
+                    upload_texture_impl(SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8, width, height, mip, imported.transcoded_data.data() + transcoded_offset, is_cube + face, pixels_per_stride);
+                    transcoded_offset += texture::get_compressed_size(SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8, pixels_per_stride, height);
+                } else {
+                    const uint8_t *mip_data = imported.decoded + ddspp::get_offset(*imported.dds_descriptor, mip, face);
+                    upload_texture_impl(imported.format, width, height, mip, mip_data, is_cube + face, pixels_per_stride);
+                }
 
                 // on to the next mip
                 width /= 2;
@@ -587,20 +687,12 @@ void TextureCache::import_upload_texture() {
         }
     } else {
         // just upload the first mip and we are done (png does not support multiple mips / cubemaps)
-        upload_texture_impl(current_info->format, current_info->width, current_info->height, 0, imported_texture_decoded, 0, current_info->width);
+        upload_texture_impl(imported.format, imported.width, imported.height, 0, imported.decoded, 0, imported.width);
     }
 }
 
 void TextureCache::import_done() {
-    if (loading_texture.is_dds) {
-        imported_texture_raw_data.clear();
-        imported_texture_decoded = nullptr;
-    } else {
-        if (imported_texture_decoded) {
-            stbi_image_free(imported_texture_decoded);
-            imported_texture_decoded = nullptr;
-        }
-    }
+    imported_texture.reset();
 }
 
 void TextureCache::refresh_available_textures() {
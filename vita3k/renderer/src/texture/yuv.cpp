@@ -17,36 +17,46 @@
 
 #include <renderer/functions.h>
 
+#include <algorithm>
+#include <array>
+
 extern "C" {
 #include <libswscale/swscale.h>
 }
 
 namespace renderer::texture {
 
-static SwsContext *s_render_sws_context{};
-static size_t res[2] = { 0, 0 };
-static bool is_yuv_p3 = false;
+struct YuvSwsContext {
+    size_t width = 0;
+    size_t height = 0;
+    bool is_p3 = false;
+    SwsContext *context = nullptr;
+};
+
+// games often play videos of different sizes at the same time (a movie and a small animated background for example),
+// keep a few contexts around so that they are not recreated each time the video changes
+static constexpr size_t MAX_SWS_CONTEXTS = 4;
+// sorted from the most recently used to the least recently used
+static std::array<YuvSwsContext, MAX_SWS_CONTEXTS> s_render_sws_contexts;
+
 static SwsContext *get_sws_context(size_t width, size_t height, bool is_p3) {
-    bool recreate = false;
-    if (res[0] != width || res[1] != height || is_yuv_p3 != is_p3) {
-        recreate = true;
-        res[0] = width;
-        res[1] = height;
-        is_yuv_p3 = is_p3;
-    } else if (s_render_sws_context == nullptr) {
-        recreate = true;
-    }
+    auto it = std::find_if(s_render_sws_contexts.begin(), s_render_sws_contexts.end(), [&](const YuvSwsContext &entry) {
+        return entry.context && entry.width == width && entry.height == height && entry.is_p3 == is_p3;
+    });
+
+    if (it == s_render_sws_contexts.end()) {
+        // replace the least recently used context
+        it = s_render_sws_contexts.end() - 1;
+        if (it->context)
+            sws_freeContext(it->context);
 
-    if (recreate) {
-        if (s_render_sws_context != nullptr) {
-            sws_freeContext(s_render_sws_context);
-            s_render_sws_context = nullptr;
-        }
         const AVPixelFormat format = is_p3 ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_NV12;
-        s_render_sws_context = sws_getContext(width, height, format, width, height, AV_PIX_FMT_RGB0,
-            0, nullptr, nullptr, nullptr);
+        *it = YuvSwsContext{ width, height, is_p3,
+            sws_getContext(width, height, format, width, height, AV_PIX_FMT_RGB0, 0, nullptr, nullptr, nullptr) };
     }
-    return s_render_sws_context;
+
+    std::rotate(s_render_sws_contexts.begin(), it, it + 1);
+    return s_render_sws_contexts.front().context;
 }
 
 void yuv420_texture_to_rgb(uint8_t *dst, const uint8_t *src, uint32_t width, uint32_t height, uint32_t layout_width, uint32_t layout_height, bool is_p3) {
@@ -131,20 +131,29 @@ static void perform_transfer_copy_mode(MemState &mem, const SceGxmTransferImage
     }
 }
 
+// surface cache of the vulkan renderer, if the transfers must take it into account
+static vulkan::VKSurfaceCache *get_surface_cache(State &renderer) {
+    if (renderer.current_backend != Backend::Vulkan || !renderer.features.enable_memory_mapping || renderer.disable_surface_sync)
+        return nullptr;
+
+    return &dynamic_cast<vulkan::VKState &>(renderer).surface_cache;
+}
+
 COMMAND(handle_transfer_copy) {
     TRACY_FUNC_COMMANDS(handle_transfer_copy);
     const uint32_t colorKeyValue = helper.pop<uint32_t>();
     const uint32_t colorKeyMask = helper.pop<uint32_t>();
     SceGxmTransferColorKeyMode colorKeyMode = helper.pop<SceGxmTransferColorKeyMode>();
-    const SceGxmTransferImage *images = helper.pop<SceGxmTransferImage *>();
-    const SceGxmTransferFormat src_fmt = images[0].format;
-    const SceGxmTransferFormat dst_fmt = images[1].format;
+    // the images are copied, the operation can be run after the command has been freed
+    const SceGxmTransferImage src = helper.pop<SceGxmTransferImage>();
+    const SceGxmTransferImage dst = helper.pop<SceGxmTransferImage>();
+    const SceGxmTransferFormat src_fmt = src.format;
+    const SceGxmTransferFormat dst_fmt = dst.format;
     SceGxmTransferType src_type = helper.pop<SceGxmTransferType>();
     SceGxmTransferType dst_type = helper.pop<SceGxmTransferType>();
 
     if (src_fmt != dst_fmt) {
         LOG_ERROR_ONCE("Unhandled format conversion from 0x{:0X} to 0x{:0X}", fmt::underlying(src_fmt), fmt::underlying(dst_fmt));
-        delete[] images;
         return;
     }
 
@@ -152,10 +161,15 @@ COMMAND(handle_transfer_copy) {
         LOG_ERROR_ONCE("Transfer copy with non-zero key mask not handled for format 0x{:0X}", fmt::underlying(src_fmt));
     }
 
-    vulkan::CallbackRequestFunction copy_operation = [=, &mem]() {
-        const SceGxmTransferImage &src = images[0];
-        const SceGxmTransferImage &dst = images[1];
+    vulkan::VKSurfaceCache *surface_cache = get_surface_cache(renderer);
+    // the color key needs to look at each pixel, it is only done on the CPU
+    if (surface_cache && colorKeyMode == SCE_GXM_TRANSFER_COLORKEY_NONE && src_type == SCE_GXM_TRANSFER_LINEAR && dst_type == SCE_GXM_TRANSFER_LINEAR) {
+        if (surface_cache->transfer_copy(src, dst))
+            // both images are surfaces, the copy is done on the GPU
+            return;
+    }
 
+    vulkan::CallbackRequestFunction copy_operation = [=, &mem]() {
         // Get bits per pixel of the image
         const uint32_t bpp = gxm::get_bits_per_pixel(src.format);
 
@@ -180,38 +194,40 @@ COMMAND(handle_transfer_copy) {
             perform_transfer_copy_src_type<std::array<uint64_t, 2>, SCE_GXM_TRANSFER_COLORKEY_NONE>(mem, src, dst, src_type, dst_type, colorKeyValue, colorKeyMask);
             break;
         }
-
-        delete[] images;
     };
 
-    if (renderer.current_backend == Backend::Vulkan && renderer.features.enable_memory_mapping && !renderer.disable_surface_sync) {
-        if (dynamic_cast<vulkan::VKState &>(renderer).surface_cache.check_for_surface(mem, images[0].address.address(), copy_operation, images[1].address.address()))
-            // let the vulkan surface cache handle it
-            return;
-    }
+    if (surface_cache && surface_cache->check_for_surface(mem, src.address.address(), copy_operation, dst.address.address()))
+        // let the vulkan surface cache handle it
+        return;
 
     copy_operation();
 }
 
 COMMAND(handle_transfer_downscale) {
     TRACY_FUNC_COMMANDS(handle_transfer_downscale);
-    SceGxmTransferImage *src = helper.pop<SceGxmTransferImage *>();
-    SceGxmTransferImage *dst = helper.pop<SceGxmTransferImage *>();
+    // the images are copied, the operation can be run after the command has been freed
+    SceGxmTransferImage src = helper.pop<SceGxmTransferImage>();
+    SceGxmTransferImage dst = helper.pop<SceGxmTransferImage>();
 
-    if (src->format != dst->format) {
-        LOG_ERROR_ONCE("Unhandled format conversion from 0x{:0X} to 0x{:0X}", fmt::underlying(src->format), fmt::underlying(dst->format));
+    if (src.format != dst.format) {
+        LOG_ERROR_ONCE("Unhandled format conversion from 0x{:0X} to 0x{:0X}", fmt::underlying(src.format), fmt::underlying(dst.format));
         return;
     }
 
+    vulkan::VKSurfaceCache *surface_cache = get_surface_cache(renderer);
+    if (surface_cache && surface_cache->transfer_downscale(src, dst))
+        // both images are surfaces, the downscale is done on the GPU
+        return;
+
     // adjust the x/y value
-    const uint32_t pixel_bytes = gxm::get_bits_per_pixel(src->format) / 8;
-    src->address = (src->address.cast<uint8_t>() + src->y * src->stride + src->x * pixel_bytes).cast<void>();
-    dst->address = (dst->address.cast<uint8_t>() + dst->y * dst->stride + dst->x * pixel_bytes).cast<void>();
+    const uint32_t pixel_bytes = gxm::get_bits_per_pixel(src.format) / 8;
+    src.address = (src.address.cast<uint8_t>() + src.y * src.stride + src.x * pixel_bytes).cast<void>();
+    dst.address = (dst.address.cast<uint8_t>() + dst.y * dst.stride + dst.x * pixel_bytes).cast<void>();
 
     // only rgb formats are supported by the PS Vita for downscaling
     vulkan::CallbackRequestFunction downscale_operation = [&mem, src, dst]() {
         AVPixelFormat pixel_fmt = AV_PIX_FMT_NONE;
-        switch (src->format) {
+        switch (src.format) {
         case SCE_GXM_TRANSFER_FORMAT_U5U6U5_BGR:
             pixel_fmt = AV_PIX_FMT_RGB565LE;
             break;
@@ -225,16 +241,16 @@ COMMAND(handle_transfer_downscale) {
             break;
         }
 
-        uint8_t *src_ptr = src->address.cast<uint8_t>().get(mem);
-        uint8_t *dst_ptr = dst->address.cast<uint8_t>().get(mem);
+        uint8_t *src_ptr = src.address.cast<uint8_t>().get(mem);
+        uint8_t *dst_ptr = dst.address.cast<uint8_t>().get(mem);
 
-        if (pixel_fmt != AV_PIX_FMT_NONE && src->stride > 0 && dst->stride > 0) {
+        if (pixel_fmt != AV_PIX_FMT_NONE && src.stride > 0 && dst.stride > 0) {
             // use ffmpeg with the avg filter
-            SwsContext *ctx = sws_getContext(src->width, src->height, pixel_fmt, dst->width, dst->height, pixel_fmt, SWS_AREA, nullptr, nullptr, nullptr);
+            SwsContext *ctx = sws_getContext(src.width, src.height, pixel_fmt, dst.width, dst.height, pixel_fmt, SWS_AREA, nullptr, nullptr, nullptr);
             if (ctx == nullptr) {
-                LOG_ERROR("Failed to get ffmpeg context for format 0x{:0X}", fmt::underlying(src->format));
+                LOG_ERROR("Failed to get ffmpeg context for format 0x{:0X}", fmt::underlying(src.format));
             } else {
-                sws_scale(ctx, &src_ptr, &src->stride, 0, src->height, &dst_ptr, &dst->stride);
+                sws_scale(ctx, &src_ptr, &src.stride, 0, src.height, &dst_ptr, &dst.stride);
                 sws_freeContext(ctx);
             }
 
@@ -243,16 +259,16 @@ COMMAND(handle_transfer_downscale) {
             // slow and not entirely accurate (nearest instead of average) fallback
 
             auto perform_downscale = [&]<typename T>(T type) {
-                for (size_t y = 0; y < dst->height; y++) {
+                for (size_t y = 0; y < dst.height; y++) {
                     // stride is in bytes
-                    T *src_line = reinterpret_cast<T *>(src_ptr + (size_t)src->stride * y * 2);
-                    T *dst_line = reinterpret_cast<T *>(dst_ptr + (size_t)dst->stride * y);
-                    for (size_t x = 0; x < dst->width; x++) {
+                    T *src_line = reinterpret_cast<T *>(src_ptr + (size_t)src.stride * y * 2);
+                    T *dst_line = reinterpret_cast<T *>(dst_ptr + (size_t)dst.stride * y);
+                    for (size_t x = 0; x < dst.width; x++) {
                         dst_line[x] = src_line[2 * x];
                     }
                 }
             };
-            switch (gxm::get_bits_per_pixel(src->format)) {
+            switch (gxm::get_bits_per_pixel(src.format)) {
             case 8:
                 perform_downscale(uint8_t());
                 break;
@@ -267,20 +283,15 @@ COMMAND(handle_transfer_downscale) {
                 break;
             default:
                 // should not happen
-                LOG_ERROR("Unhandled format 0x{:0X}", fmt::underlying(src->format));
+                LOG_ERROR("Unhandled format 0x{:0X}", fmt::underlying(src.format));
                 break;
             }
         }
-
-        delete src;
-        delete dst;
     };
 
-    if (renderer.current_backend == Backend::Vulkan && renderer.features.enable_memory_mapping && !renderer.disable_surface_sync) {
-        if (dynamic_cast<vulkan::VKState &>(renderer).surface_cache.check_for_surface(mem, src->address.address(), downscale_operation, dst->address.address()))
-            // let the vulkan surface cache handle it
-            return;
-    }
+    if (surface_cache && surface_cache->check_for_surface(mem, src.address.address(), downscale_operation, dst.address.address()))
+        // let the vulkan surface cache handle it
+        return;
 
     downscale_operation();
 }
@@ -288,27 +299,30 @@ COMMAND(handle_transfer_downscale) {
 COMMAND(handle_transfer_fill) {
     TRACY_FUNC_COMMANDS(handle_transfer_fill);
     const uint32_t fill_color = helper.pop<uint32_t>();
-    const SceGxmTransferImage *dest = helper.pop<SceGxmTransferImage *>();
+    const SceGxmTransferImage dest = helper.pop<SceGxmTransferImage>();
 
-    const auto bpp = gxm::get_bits_per_pixel(dest->format);
+    vulkan::VKSurfaceCache *surface_cache = get_surface_cache(renderer);
+    if (surface_cache && surface_cache->transfer_fill(dest, fill_color))
+        // the whole surface is cleared on the GPU
+        return;
+
+    const auto bpp = gxm::get_bits_per_pixel(dest.format);
 
     const uint32_t bytes_per_pixel = (bpp + 7) >> 3;
-    for (uint32_t y = 0; y < dest->height; y++) {
-        for (uint32_t x = 0; x < dest->width; x++) {
+    for (uint32_t y = 0; y < dest.height; y++) {
+        for (uint32_t x = 0; x < dest.width; x++) {
             // Set offset of destination
-            const auto dest_offset = ((x + dest->x) * bytes_per_pixel) + ((y + dest->y) * dest->stride);
+            const auto dest_offset = ((x + dest.x) * bytes_per_pixel) + ((y + dest.y) * dest.stride);
 
             // Set pointer of destination
-            auto dest_ptr = (uint8_t *)dest->address.get(mem) + dest_offset;
+            auto dest_ptr = (uint8_t *)dest.address.get(mem) + dest_offset;
 
             // Fill color in destination
             memcpy(dest_ptr, &fill_color, bytes_per_pixel);
         }
     }
 
-    // TODO: handle case where dest is a cached surface
-
-    delete dest;
+    // TODO: handle partial fills of a cached surface
 }
 
 } // namespace renderer
@@ -23,13 +23,20 @@
 
 #include <gxm/functions.h>
 #include <renderer/functions.h>
+#include <renderer/profile.h>
 
 #include <util/log.h>
 #include <util/overloaded.h>
+#include <util/profile.h>
+
+#include <chrono>
+#include <thread>
 
 namespace renderer::vulkan {
 
 void VKContext::wait_thread_function(const MemState &mem) {
+    PROFILE_THREAD_NAME("GPU fence wait");
+
     // try to wait for multiple fences at the same time if possible
     std::vector<vk::Fence> fences;
 
@@ -73,6 +80,17 @@ void VKContext::wait_thread_function(const MemState &mem) {
                                state.notification_ready.notify_all();
                            }
                        },
+                       [&](EventNotificationRequest &request) {
+                           // the event is set once the commands sent before it are done, there is no fence to wait for
+                           while (state.device.getEventStatus(request.event) != vk::Result::eEventSet)
+                               std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+                           {
+                               std::unique_lock<std::mutex> lock(state.notification_mutex);
+                               *request.notification.address.get(mem) = request.notification.value;
+                           }
+                           state.notification_ready.notify_all();
+                       },
                        [&](FrameDoneRequest &request) {
                            wait_for_fences();
 
@@ -115,6 +133,8 @@ void VKContext::wait_thread_function(const MemState &mem) {
 }
 
 void set_context(VKContext &context, MemState &mem, VKRenderTarget *rt, const FeatureState &features) {
+    R_PROFILE(__func__);
+
     context.render_target = rt;
     context.scene_timestamp++;
     context.state.texture_cache.current_scene_timestamp = context.scene_timestamp;
@@ -166,7 +186,7 @@ void set_context(VKContext &context, MemState &mem, VKRenderTarget *rt, const Fe
         force_load = false;
         force_store = false;
     }
-    if (context.state.features.support_shader_interlock)
+    if (context.state.features.support_shader_interlock || state.scene_chunk_draws > 0)
         // we must always store the depth stencil
         force_store = true;
     context.current_render_pass = context.state.pipeline_cache.retrieve_render_pass(vk_format, force_load, force_store, color_surface_fin == nullptr);
@@ -195,6 +215,8 @@ void set_context(VKContext &context, MemState &mem, VKRenderTarget *rt, const Fe
 }
 
 void VKContext::start_recording(bool first_in_scene) {
+    R_PROFILE(__func__);
+
     if (is_recording) {
         LOG_ERROR("Attempt to start recording while already recording");
         return;
@@ -249,8 +271,12 @@ void VKContext::start_recording(bool first_in_scene) {
     };
     render_cmd.begin(begin_info);
     prerender_cmd.begin(begin_info);
+    profiled_scene = state.gpu_profiler.begin_scene(prerender_cmd, render_cmd, render_target, render_target->width, render_target->height);
 
     is_recording = true;
+    draws_in_recording = 0;
+    // nothing is bound in the new command buffer
+    frag_textures_pushed = false;
 
     // set all the dynamic state here
     render_cmd.setViewport(0, viewport);
@@ -261,6 +287,8 @@ void VKContext::start_recording(bool first_in_scene) {
     if (record.two_sided == SCE_GXM_TWO_SIDED_ENABLED) {
         sync_stencil_func(*this, true);
     }
+    is_extended_dynamic_state_valid = false;
+    sync_extended_dynamic_state(*this);
 }
 
 // we only need one descriptor per scene, so this does not need to be too big
@@ -394,6 +422,8 @@ void VKContext::stop_render_pass() {
 }
 
 void VKContext::stop_recording(const SceGxmNotification &notif1, const SceGxmNotification &notif2, bool submit) {
+    R_PROFILE(__func__);
+
     if (!is_recording) {
         LOG_ERROR("Stopping recording while not recording");
         return;
@@ -438,10 +468,14 @@ void VKContext::stop_recording(const SceGxmNotification &notif1, const SceGxmNot
         current_visibility_buffer->queries_used.assign(current_visibility_buffer->size, false);
     }
 
+    state.gpu_profiler.write_timestamp(render_cmd, profiled_scene, GpuProfiler::SurfaceSyncBegin);
     ColorSurfaceCacheInfo *surface_info = nullptr;
     if (state.features.enable_memory_mapping && !state.disable_surface_sync && submit)
         surface_info = state.surface_cache.perform_surface_sync();
 
+    state.gpu_profiler.write_timestamp(render_cmd, profiled_scene, GpuProfiler::RenderEnd);
+    state.gpu_profiler.write_timestamp(prerender_cmd, profiled_scene, GpuProfiler::PrerenderEnd);
+    profiled_scene = GpuProfiler::NO_SCENE;
     prerender_cmd.end();
     render_cmd.end();
 
@@ -453,8 +487,13 @@ void VKContext::stop_recording(const SceGxmNotification &notif1, const SceGxmNot
     prerender_cmd = nullptr;
     is_recording = false;
 
-    if (!submit)
+    if (!submit) {
+        if (state.scene_chunk_draws > 0) {
+            // send this part of the scene right away, the fence will be signaled by the last part
+            submit_command_buffers();
+        }
         return;
+    }
 
     if (render_target->multisample_mode && !record.color_surface.downscale) {
         // revert changes made in set_context
@@ -465,11 +504,7 @@ void VKContext::stop_recording(const SceGxmNotification &notif1, const SceGxmNot
     vk::Fence fence = next_fence;
     next_fence = nullptr;
 
-    vk::SubmitInfo submit_info{};
-    submit_info.setCommandBuffers(cmdbuffers_to_submit);
-
-    state.general_queue.submit(submit_info, fence);
-    cmdbuffers_to_submit.clear();
+    submit_command_buffers(fence);
     state.frame().rendered_fences.push_back(fence);
 
     if (state.features.enable_memory_mapping) {
@@ -537,6 +572,104 @@ void VKContext::check_for_macroblock_change(bool is_draw) {
     }
 }
 
+vk::CommandBuffer VKContext::get_async_transfer_cmd() {
+    if (!async_transfer_cmd) {
+        vk::CommandBufferAllocateInfo cmd_buffer_info{
+            .commandPool = state.frame().async_transfer_pool,
+            .level = vk::CommandBufferLevel::ePrimary,
+            .commandBufferCount = 1
+        };
+        async_transfer_cmd = state.device.allocateCommandBuffers(cmd_buffer_info)[0];
+
+        vk::CommandBufferBeginInfo begin_info{
+            .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit
+        };
+        async_transfer_cmd.begin(begin_info);
+    }
+
+    return async_transfer_cmd;
+}
+
+void VKContext::submit_command_buffers(vk::Fence fence) {
+    R_PROFILE(__func__);
+
+    if (async_transfer_cmd) {
+        async_transfer_cmd.end();
+
+        FrameObject &frame = state.frame();
+        if (frame.async_transfer_semaphores_used == frame.async_transfer_semaphores.size())
+            frame.async_transfer_semaphores.push_back(state.device.createSemaphore({}));
+        const vk::Semaphore semaphore = frame.async_transfer_semaphores[frame.async_transfer_semaphores_used++];
+
+        vk::SubmitInfo transfer_info{};
+        transfer_info.setCommandBuffers(async_transfer_cmd);
+        transfer_info.setSignalSemaphores(semaphore);
+        state.async_transfer_queue.submit(transfer_info);
+        async_transfer_cmd = nullptr;
+
+        // the ownership of the textures is acquired at the beginning of the prerender command buffers
+        async_transfer_waits.push_back(semaphore);
+        async_transfer_wait_stages.push_back(vk::PipelineStageFlagBits::eAllCommands);
+    }
+
+    vk::SubmitInfo submit_info{};
+    submit_info.setCommandBuffers(cmdbuffers_to_submit);
+    submit_info.setWaitSemaphores(async_transfer_waits);
+    submit_info.setWaitDstStageMask(async_transfer_wait_stages);
+
+    state.general_queue.submit(submit_info, fence);
+    cmdbuffers_to_submit.clear();
+    async_transfer_waits.clear();
+    async_transfer_wait_stages.clear();
+}
+
+// wait for the GPU to be done with the frame with this timestamp
+static bool wait_for_frame(VKContext &context, uint64_t frame_timestamp) {
+    if (context.state.features.enable_memory_mapping) {
+        // the wait is done by the wait thread
+        std::unique_lock<std::mutex> lock(context.new_frame_mutex);
+        context.new_frame_condv.wait(lock, [&]() {
+            return context.last_frame_waited >= frame_timestamp;
+        });
+        return true;
+    }
+
+    const FrameObject &frame = context.state.frames[frame_timestamp % MAX_FRAMES_RENDERING];
+    if (frame.rendered_fences.empty() || frame.frame_timestamp != frame_timestamp)
+        return true;
+
+    // don't reset the fences, this is done when the frame object is used again
+    auto result = context.state.device.waitForFences(frame.rendered_fences, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    if (result != vk::Result::eSuccess) {
+        LOG_ERROR("Could not wait for fences.");
+        assert(false);
+        return false;
+    }
+
+    return true;
+}
+
+// the frames above the stutter threshold are logged with their compilations when these took most of the frame
+static void publish_pipeline_stats(VKState &state) {
+    const PipelineStats stats = state.pipeline_cache.take_frame_stats();
+    const auto now = std::chrono::steady_clock::now();
+    const float frame_ms = std::chrono::duration<float, std::milli>(now - state.last_frame_start).count();
+    const bool is_stutter = state.last_frame_start != std::chrono::steady_clock::time_point{} && state.stutter_threshold_ms > 0 && frame_ms > state.stutter_threshold_ms;
+    state.last_frame_start = now;
+
+    const std::lock_guard<std::mutex> guard(state.pipeline_stats_mutex);
+    state.pipeline_stats = stats;
+    if (!is_stutter)
+        return;
+
+    state.last_stutter = { frame_ms, stats.sync_compile_ms > frame_ms / 2, stats };
+    if (state.last_stutter.caused_by_compilation)
+        LOG_WARN("Frame took {:.1f} ms: {} pipelines compiled on the render thread in {:.1f} ms, {} shader modules created ({:.1f} ms spent retrieving shaders)",
+            frame_ms, stats.sync_compiles, stats.sync_compile_ms, stats.shader_misses, stats.shader_retrieve_ms);
+    else
+        LOG_DEBUG("Frame took {:.1f} ms, {:.1f} ms of which compiling pipelines", frame_ms, stats.sync_compile_ms);
+}
+
 void new_frame(VKContext &context) {
     if (context.state.features.enable_memory_mapping) {
         FrameDoneRequest request = { context.frame_timestamp };
@@ -551,36 +684,39 @@ void new_frame(VKContext &context) {
     vk::Device device = context.state.device;
     FrameObject &frame = context.state.frame();
 
+    // with less frames in flight, the GPU can't be more than max_frames_in_flight frames behind
+    // this lowers the latency at the cost of less overlap between the CPU and the GPU
+    const uint64_t frames_in_flight = context.state.max_frames_in_flight;
+    if (frames_in_flight < MAX_FRAMES_RENDERING && context.frame_timestamp > frames_in_flight)
+        wait_for_frame(context, context.frame_timestamp - frames_in_flight);
+
     // wait on all fences still present to make sure
-    if (!frame.rendered_fences.empty()) {
+    // the wait thread must also be done with the events of the frame before they are reset
+    if (!frame.rendered_fences.empty() || frame.notification_events_used > 0) {
         // wait for the fences, then reset them
-
-        if (context.state.features.enable_memory_mapping) {
-            // this will underflow for the first MAX_FRAMES_RENDERING frames
-            // but that's not an issue as frame.rendered_fences will be empty
-            uint64_t previous_frame_timestamp = context.frame_timestamp - MAX_FRAMES_RENDERING;
-
-            // the wait is done by the wait thread
-            std::unique_lock<std::mutex> lock(context.new_frame_mutex);
-            context.new_frame_condv.wait(lock, [&]() {
-                return context.last_frame_waited >= previous_frame_timestamp;
-            });
-        } else {
-            auto result = device.waitForFences(frame.rendered_fences, VK_TRUE, std::numeric_limits<uint64_t>::max());
-            if (result != vk::Result::eSuccess) {
-                LOG_ERROR("Could not wait for fences.");
-                assert(false);
-                return;
-            }
-        }
+        // this will underflow for the first MAX_FRAMES_RENDERING frames
+        // but that's not an issue as frame.rendered_fences will be empty
+        if (!wait_for_frame(context, context.frame_timestamp - MAX_FRAMES_RENDERING))
+            return;
 
         // reset the fences in both case (the wait thread does not do that as they can still be used)
         device.resetFences(frame.rendered_fences);
         frame.rendered_fences.clear();
     }
 
+    // the timestamps of the frame are available now that its fences have been waited for
+    context.state.gpu_profiler.new_frame(context.state, context.state.current_frame_idx, context.state.gpu_timings_requested.exchange(false));
+
     device.resetCommandPool(frame.prerender_pool);
     device.resetCommandPool(frame.render_pool);
+    if (frame.async_transfer_pool) {
+        // all the scenes of this frame waited for these semaphores
+        device.resetCommandPool(frame.async_transfer_pool);
+        frame.async_transfer_semaphores_used = 0;
+    }
+    for (uint32_t i = 0; i < frame.notification_events_used; i++)
+        device.resetEvent(frame.notification_events[i]);
+    frame.notification_events_used = 0;
 
     // set the position in the used descriptor queue back to the beginning
     for (int i = 0; i < 16; i++) {
@@ -589,6 +725,18 @@ void new_frame(VKContext &context) {
     }
     frame.color_descriptor.descriptors_idx = 0;
 
+    context.state.descriptor_sets_allocated = context.state.frame_descriptor_sets_allocated;
+    context.state.descriptor_sets_pushed = context.state.frame_descriptor_sets_pushed;
+    context.state.frame_descriptor_sets_allocated = 0;
+    context.state.frame_descriptor_sets_pushed = 0;
+    context.state.color_read_draws = context.state.frame_color_read_draws;
+    context.state.color_read_barriers = context.state.frame_color_read_barriers;
+    context.state.frame_color_read_draws = 0;
+    context.state.frame_color_read_barriers = 0;
+    context.state.mapped_bytes_copied = context.state.buffer_trapping.frame_bytes_copied;
+    context.state.buffer_trapping.frame_bytes_copied = 0;
+    publish_pipeline_stats(context.state);
+
     // deferred destruction of the objects
     frame.destroy_queue.destroy_objects();
 
@@ -152,6 +152,13 @@ VKContext::VKContext(VKState &state, MemState &mem)
 VKContext::~VKContext() {
     if (gpu_request_wait_thread.joinable())
         gpu_request_wait_thread.join();
+
+    // the last scenes may still be using the query pools
+    vkutil::DestroyQueue &destroy_queue = state.frame().destroy_queue;
+    for (auto &[address, visibility_buffer] : visibility_buffers)
+        destroy_queue.add(visibility_buffer.query_pool);
+    for (auto &[size, query_pool] : free_query_pools)
+        destroy_queue.add(query_pool);
 }
 
 VKRenderTarget::VKRenderTarget(VKState &state, const SceGxmRenderTargetParams &params)
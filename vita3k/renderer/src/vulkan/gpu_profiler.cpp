@@ -0,0 +1,215 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/vulkan/gpu_profiler.h>
+
+#include <renderer/vulkan/state.h>
+
+#include <util/log.h>
+#include <vkutil/vkutil.h>
+
+#include <algorithm>
+
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyC.h>
+#endif
+
+namespace renderer::vulkan {
+
+// scenes recorded after this number in a frame are not profiled
+static constexpr uint32_t MAX_PROFILED_SCENES = 256;
+
+#ifdef TRACY_ENABLE
+// no other GPU context is given to tracy
+static constexpr uint8_t TRACY_GPU_CONTEXT = 0;
+// value of tracy::GpuContextType::Vulkan
+static constexpr uint8_t TRACY_GPU_CONTEXT_VULKAN = 2;
+
+static const ___tracy_source_location_data tracy_transfer_location = { "Transfer", "GpuProfiler", __FILE__, __LINE__, 0 };
+static const ___tracy_source_location_data tracy_scene_location = { "Scene", "GpuProfiler", __FILE__, __LINE__, 0 };
+static const ___tracy_source_location_data tracy_surface_sync_location = { "Surface sync", "GpuProfiler", __FILE__, __LINE__, 0 };
+
+// the zones are only given to tracy once their timestamps have been read back
+static void emit_tracy_zone(const ___tracy_source_location_data &location, uint16_t &next_query, uint64_t begin, uint64_t end) {
+    const uint16_t begin_query = next_query++;
+    const uint16_t end_query = next_query++;
+    ___tracy_emit_gpu_zone_begin_serial({ reinterpret_cast<uint64_t>(&location), begin_query, TRACY_GPU_CONTEXT });
+    ___tracy_emit_gpu_zone_end_serial({ end_query, TRACY_GPU_CONTEXT });
+    ___tracy_emit_gpu_time_serial({ static_cast<int64_t>(begin), begin_query, TRACY_GPU_CONTEXT });
+    ___tracy_emit_gpu_time_serial({ static_cast<int64_t>(end), end_query, TRACY_GPU_CONTEXT });
+}
+#endif
+
+bool GpuProfiler::init(VKState &state) {
+    const uint32_t valid_bits = state.physical_device_queue_families[state.general_family_index].timestampValidBits;
+    if (valid_bits == 0 || state.physical_device_properties.limits.timestampPeriod == 0.0f) {
+        LOG_INFO("Timestamp queries are not supported, GPU timings will not be available");
+        return false;
+    }
+
+    timestamp_period = state.physical_device_properties.limits.timestampPeriod;
+    timestamp_mask = valid_bits >= 64 ? ~0ULL : ((1ULL << valid_bits) - 1);
+
+    const vk::QueryPoolCreateInfo pool_info{
+        .queryType = vk::QueryType::eTimestamp,
+        .queryCount = MAX_PROFILED_SCENES * TimestampCount
+    };
+    for (Frame &frame : frames)
+        frame.query_pool = state.device.createQueryPool(pool_info);
+
+    is_supported = true;
+
+#ifdef TRACY_ENABLE
+    // tracy needs a GPU timestamp taken now to match the GPU time with its own
+    const vk::QueryPool query_pool = frames[0].query_pool;
+    vk::CommandBuffer cmd_buffer = vkutil::create_single_time_command(state.device, state.general_command_pool);
+    cmd_buffer.resetQueryPool(query_pool, 0, 1);
+    cmd_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, query_pool, 0);
+    vkutil::end_single_time_command(state.device, state.general_queue, state.general_command_pool, cmd_buffer);
+
+    uint64_t gpu_time = 0;
+    if (state.device.getQueryPoolResults(query_pool, 0, 1, sizeof(gpu_time), &gpu_time, sizeof(gpu_time), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait) == vk::Result::eSuccess) {
+        ___tracy_emit_gpu_new_context_serial({ static_cast<int64_t>(gpu_time), timestamp_period, TRACY_GPU_CONTEXT, 0, TRACY_GPU_CONTEXT_VULKAN });
+        static constexpr char context_name[] = "Vulkan";
+        ___tracy_emit_gpu_context_name_serial({ TRACY_GPU_CONTEXT, context_name, sizeof(context_name) - 1 });
+        has_tracy_context = true;
+    }
+#endif
+
+    return true;
+}
+
+void GpuProfiler::destroy(vk::Device device) {
+    for (Frame &frame : frames) {
+        if (frame.query_pool)
+            device.destroy(frame.query_pool);
+        frame.query_pool = nullptr;
+    }
+    is_supported = false;
+}
+
+void GpuProfiler::new_frame(VKState &state, int frame_idx, bool enable) {
+    if (!is_supported)
+        return;
+
+    Frame &frame = frames[frame_idx];
+    if (!frame.scenes.empty()) {
+        collect(state, frame);
+        frame.scenes.clear();
+    }
+
+    current_frame_idx = frame_idx;
+#ifdef TRACY_ENABLE
+    enable |= has_tracy_context && TracyIsConnected;
+#endif
+    is_enabled = enable;
+}
+
+uint32_t GpuProfiler::begin_scene(vk::CommandBuffer prerender_cmd, vk::CommandBuffer render_cmd, const VKRenderTarget *render_target, uint16_t width, uint16_t height) {
+    if (!is_enabled)
+        return NO_SCENE;
+
+    Frame &frame = frames[current_frame_idx];
+    if (frame.scenes.size() == MAX_PROFILED_SCENES)
+        return NO_SCENE;
+
+    const uint32_t scene_idx = static_cast<uint32_t>(frame.scenes.size());
+    frame.scenes.push_back({ render_target, width, height });
+
+    // the prerender command buffer is always submitted first
+    const uint32_t first_query = scene_idx * TimestampCount;
+    prerender_cmd.resetQueryPool(frame.query_pool, first_query, TimestampCount);
+    prerender_cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.query_pool, first_query + PrerenderBegin);
+    render_cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.query_pool, first_query + RenderBegin);
+
+    // the frame is part of the id so that the scene can't be mixed with the one of another frame
+    return current_frame_idx * MAX_PROFILED_SCENES + scene_idx;
+}
+
+void GpuProfiler::write_timestamp(vk::CommandBuffer cmd, uint32_t scene, Timestamp timestamp) {
+    if (scene == NO_SCENE)
+        return;
+
+    const Frame &frame = frames[scene / MAX_PROFILED_SCENES];
+    const uint32_t scene_idx = scene % MAX_PROFILED_SCENES;
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, frame.query_pool, scene_idx * TimestampCount + timestamp);
+}
+
+float GpuProfiler::get_elapsed_ms(uint64_t begin, uint64_t end) const {
+    return static_cast<float>(((end - begin) & timestamp_mask) * (timestamp_period / 1'000'000.0));
+}
+
+void GpuProfiler::collect(VKState &state, Frame &frame) {
+    const uint32_t query_count = static_cast<uint32_t>(frame.scenes.size()) * TimestampCount;
+    results.resize(query_count);
+    // the fences of the frame have been waited for, the only way for a result to be missing is if a scene was never submitted
+    const vk::Result result = state.device.getQueryPoolResults(frame.query_pool, 0, query_count, query_count * sizeof(uint64_t),
+        results.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess)
+        return;
+
+    const auto get_elapsed = [&](const uint64_t *timestamps, Timestamp begin, Timestamp end) {
+        return get_elapsed_ms(timestamps[begin], timestamps[end]);
+    };
+
+#ifdef TRACY_ENABLE
+    const bool emit_tracy_zones = has_tracy_context && TracyIsConnected;
+#endif
+
+    GpuTimings timings;
+    // render target of each entry of timings.render_targets
+    std::vector<const VKRenderTarget *> render_targets;
+    for (size_t i = 0; i < frame.scenes.size(); i++) {
+        const SceneInfo &scene = frame.scenes[i];
+        const uint64_t *timestamps = &results[i * TimestampCount];
+
+        const float transfer_ms = get_elapsed(timestamps, PrerenderBegin, PrerenderEnd);
+        const float scene_ms = get_elapsed(timestamps, RenderBegin, SurfaceSyncBegin);
+        const float surface_sync_ms = get_elapsed(timestamps, SurfaceSyncBegin, RenderEnd);
+        timings.transfer_ms += transfer_ms;
+        timings.scene_ms += scene_ms;
+        timings.surface_sync_ms += surface_sync_ms;
+
+        auto it = std::find(render_targets.begin(), render_targets.end(), scene.render_target);
+        if (it == render_targets.end()) {
+            render_targets.push_back(scene.render_target);
+            timings.render_targets.push_back({ scene.width, scene.height, 0, 0.0f });
+            it = render_targets.end() - 1;
+        }
+        GpuTimings::RenderTargetTimings &target_timings = timings.render_targets[it - render_targets.begin()];
+        target_timings.scene_count++;
+        target_timings.time_ms += transfer_ms + scene_ms + surface_sync_ms;
+
+#ifdef TRACY_ENABLE
+        if (emit_tracy_zones) {
+            emit_tracy_zone(tracy_transfer_location, next_tracy_query, timestamps[PrerenderBegin], timestamps[PrerenderEnd]);
+            emit_tracy_zone(tracy_scene_location, next_tracy_query, timestamps[RenderBegin], timestamps[SurfaceSyncBegin]);
+            emit_tracy_zone(tracy_surface_sync_location, next_tracy_query, timestamps[SurfaceSyncBegin], timestamps[RenderEnd]);
+        }
+#endif
+    }
+
+    std::sort(timings.render_targets.begin(), timings.render_targets.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.time_ms > rhs.time_ms;
+    });
+
+    const std::lock_guard<std::mutex> guard(state.gpu_timings_mutex);
+    state.gpu_timings = std::move(timings);
+}
+
+} // namespace renderer::vulkan
@@ -830,6 +830,9 @@ vk::Format translate_format(SceGxmTextureBaseFormat base_format) {
     case SCE_GXM_TEXTURE_BASE_FORMAT_UBC7:
         return vk::Format::eBc7UnormBlock;
 
+    case SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8:
+        return vk::Format::eEtc2R8G8B8A8UnormBlock;
+
 #define ASTC_FMT(b_x, b_y)                              \
     case SCE_GXM_TEXTURE_BASE_FORMAT_ASTC##b_x##x##b_y: \
         return vk::Format::eAstc##b_x##x##b_y##UnormBlock;
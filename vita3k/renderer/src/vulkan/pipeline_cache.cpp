@@ -24,12 +24,21 @@
 #include <gxm/functions.h>
 #include <gxm/types.h>
 #include <renderer/shaders.h>
+#include <renderer/profile.h>
 #include <shader/spirv_recompiler.h>
 
+#include <util/frame_timings.h>
 #include <util/fs.h>
 #include <util/log.h>
+#include <util/profile.h>
 
 #include <SDL3/SDL_cpuinfo.h>
+#include <SDL3/SDL_thread.h>
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <thread>
 
 // don't use the dispatch version, because we always hash a small amount
 // with a known size
@@ -38,21 +47,26 @@
 
 namespace renderer::vulkan {
 
-// Size of the record containing what is needed for the pipeline construction (what is after is dynamic state)
-constexpr size_t record_pipeline_len = offsetof(GxmRecordState, vertex_streams);
-
 // structure containing everything needed to compile a pipeline
 struct CompileRequest {
     // iterator to the pipeline location
     vk::Pipeline *pipeline;
 
     // this is everything we need to compile the shader on another thread (as the original data will change)
+    uint64_t key;
+    uint64_t fallback_key;
     SceGxmPrimitiveType type;
     vk::RenderPass render_pass;
+    vk::Format color_format;
     SceGxmVertexProgram *vertex_program_gxm;
     SceGxmFragmentProgram *fragment_program_gxm;
     shader::Hints hints;
 
+    // set instead of the gxm programs when preloading a pipeline read from the disk
+    std::optional<PipelineDescription> description;
+    vk::ShaderModule vertex_module;
+    vk::ShaderModule fragment_module;
+
     // the content of the record useful for the pipeline creation
     alignas(8) uint8_t record_data[record_pipeline_len];
 
@@ -64,7 +78,8 @@ struct CompileRequest {
 
 PipelineCache::PipelineCache(VKState &state)
     : state(state)
-    , pipeline_compile_queue_token(pipeline_compile_queue) {
+    , draw_compile_queue_token(draw_compile_queue)
+    , preload_compile_queue_token(preload_compile_queue) {
 }
 
 void PipelineCache::init(bool support_rasterized_order_access) {
@@ -174,6 +189,10 @@ void PipelineCache::init(bool support_rasterized_order_access) {
                 .bindingCount = i,
                 .pBindings = layout_bindings.data()
             };
+            // only one set per pipeline layout can be a push descriptor, use it for the fragment textures
+            // as most programs only sample textures in the fragment shader
+            if (state.support_push_descriptor)
+                descriptor_info.flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR;
             fragment_textures_layout[i] = state.device.createDescriptorSetLayout(descriptor_info);
         }
     }
@@ -238,6 +257,8 @@ void PipelineCache::init(bool support_rasterized_order_access) {
     else
         nb_worker_threads = 1;
 
+    shader_translation_pool.start(nb_worker_threads, [] { PROFILE_THREAD_NAME("Shader translation"); });
+
     if (use_async_compilation) {
         // we could not initialize the worker threads previously
         use_async_compilation = false;
@@ -245,39 +266,87 @@ void PipelineCache::init(bool support_rasterized_order_access) {
     }
 }
 
+// a new compile thread is started when there are more pending requests than this per running thread
+static constexpr int compile_requests_per_thread = 2;
+// a compile thread which had nothing to do for this long stops, unless it is the last one
+static constexpr int64_t compile_thread_idle_timeout_us = 5'000'000;
+
 void PipelineCache::set_async_compilation(bool enable) {
     if (enable == use_async_compilation)
         return;
 
+    std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(compile_threads_mutex);
     use_async_compilation = enable;
     if (nb_worker_threads == 0)
         // not ingame yet
         return;
 
     if (enable) {
-        LOG_INFO("Enabling asynchronous pipeline compilation with {} threads", nb_worker_threads);
-        // launch all the threads
-        for (int i = 0; i < nb_worker_threads; i++) {
-            std::thread thread(&PipelineCache::compiler_thread, this, std::ref(*state.mem));
-            thread.detach();
-        }
+        LOG_INFO("Enabling asynchronous pipeline compilation with up to {} threads", nb_worker_threads);
+        // the other threads are started when the requests pile up
+        nb_compile_threads = 1;
+        std::thread thread(&PipelineCache::compiler_thread, this, std::ref(*state.mem));
+        thread.detach();
     } else {
         LOG_INFO("Asynchronous pipeline compilation is now disabled");
 
         // we assume that by the time set_async_compilation is called again with enable=true, all previous worker threads have already exited
-        for (int i = 0; i < nb_worker_threads; i++)
+        for (int i = 0; i < nb_compile_threads; i++) {
             // if a thread receives nullptr, it exits
-            pipeline_compile_queue.enqueue(nullptr);
+            draw_compile_queue.enqueue(draw_compile_queue_token, nullptr);
+            pending_compile_requests++;
+            compile_requests_available.signal();
+        }
+        nb_compile_threads = 0;
+    }
+}
+
+void PipelineCache::enqueue_compile_request(CompileRequest *request, bool is_preload) {
+    if (is_preload)
+        preload_compile_queue.enqueue(preload_compile_queue_token, request);
+    else
+        draw_compile_queue.enqueue(draw_compile_queue_token, request);
+    const int pending = ++pending_compile_requests;
+    compile_requests_available.signal();
+
+    std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(compile_threads_mutex);
+    if (nb_compile_threads < nb_worker_threads && pending > nb_compile_threads * compile_requests_per_thread) {
+        nb_compile_threads++;
+        std::thread thread(&PipelineCache::compiler_thread, this, std::ref(*state.mem));
+        thread.detach();
     }
 }
 
 // magic number put at the beginning of the pipeline cache file
 constexpr uint32_t pipeline_cache_magic = 0xBEEF4321;
 
+// the data of a vulkan pipeline cache starts with a header identifying the GPU and driver it was made with,
+// the driver should ignore the data of another one but some do not check it
+static bool is_pipeline_cache_compatible(const vk::PhysicalDeviceProperties &properties, std::span<const char> data) {
+    // VkPipelineCacheHeaderVersionOne
+    struct {
+        uint32_t header_size;
+        uint32_t header_version;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint8_t uuid[VK_UUID_SIZE];
+    } header;
+    if (data.size() < sizeof(header))
+        return false;
+
+    memcpy(&header, data.data(), sizeof(header));
+    return header.header_version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendor_id == properties.vendorID
+        && header.device_id == properties.deviceID
+        && memcmp(header.uuid, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+
 void PipelineCache::read_pipeline_cache() {
     const std::string pipeline_cache_name = fmt::format("pipeline-cache-vk{}.dat", shader::CURRENT_VERSION);
     const fs::path path = state.shaders_path / pipeline_cache_name;
 
+    read_pipeline_descriptions();
+
     fs::ifstream pipeline_cache_file(path, std::ios::in | std::ios::binary);
     if (!pipeline_cache_file.is_open())
         return;
@@ -308,17 +377,23 @@ void PipelineCache::read_pipeline_cache() {
     }
     pipeline_size -= hashes_size;
 
-    // insert hashes with null pipeline
-    for (size_t i = 0; i < nb_hashes; i++) {
-        uint64_t hash;
-        read_integer(hash);
-        pipelines[hash] = nullptr;
-    }
+    std::vector<uint64_t> hashes(nb_hashes);
+    pipeline_cache_file.read(reinterpret_cast<char *>(hashes.data()), nb_hashes * sizeof(uint64_t));
 
     std::vector<char> pipeline_data(pipeline_size);
     pipeline_cache_file.read(pipeline_data.data(), pipeline_size);
     pipeline_cache_file.close();
 
+    // the pipelines would not be in the cache anymore
+    if (!is_pipeline_cache_compatible(state.physical_device_properties, pipeline_data)) {
+        LOG_WARN("Pipeline cache was made with another GPU or driver, ignoring it.");
+        return;
+    }
+
+    // insert hashes with null pipeline
+    for (const uint64_t hash : hashes)
+        pipelines[hash] = nullptr;
+
     vk::PipelineCacheCreateInfo cache_info{
         .initialDataSize = pipeline_size,
         .pInitialData = pipeline_data.data()
@@ -334,10 +409,17 @@ void PipelineCache::save_pipeline_cache() {
     // do a copy for thread safety
     std::vector<ShadersHash> shader_cache_copy;
     {
-        std::lock_guard<std::mutex> guard(shaders_mutex);
+        std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(shaders_mutex);
         shader_cache_copy = state.shaders_cache_hashs;
     }
     renderer::save_shaders_cache_hashs(state, shader_cache_copy);
+    save_pipeline_descriptions();
+
+    {
+        std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(shaders_mutex);
+        if (shader_variants.size() > shaders.size())
+            LOG_INFO("{} shader modules are used for {} shader variants, {} modules avoided", shaders.size(), shader_variants.size(), shader_variants.size() - shaders.size());
+    }
 
     const std::vector<uint8_t> pipeline_data = state.device.getPipelineCacheData(pipeline_cache);
     if (pipeline_data.empty())
@@ -369,6 +451,250 @@ void PipelineCache::save_pipeline_cache() {
     LOG_INFO("Pipeline cache saved");
 }
 
+// magic number put at the beginning of the pipeline descriptions file
+constexpr uint32_t pipeline_descriptions_magic = 0xBEEF4322;
+
+void PipelineCache::read_pipeline_descriptions() {
+    const std::string descriptions_name = fmt::format("pipelines-vk{}.dat", shader::CURRENT_VERSION);
+    fs::ifstream descriptions_file(state.shaders_path / descriptions_name, std::ios::in | std::ios::binary);
+    if (!descriptions_file.is_open())
+        return;
+
+    uint32_t magic_number = 0;
+    uint32_t description_size = 0;
+    uint32_t nb_descriptions = 0;
+    descriptions_file.read(reinterpret_cast<char *>(&magic_number), sizeof(magic_number));
+    descriptions_file.read(reinterpret_cast<char *>(&description_size), sizeof(description_size));
+    descriptions_file.read(reinterpret_cast<char *>(&nb_descriptions), sizeof(nb_descriptions));
+    if (!descriptions_file || magic_number != pipeline_descriptions_magic || description_size != sizeof(PipelineDescription)) {
+        LOG_WARN("Pipeline descriptions are outdated, ignoring them.");
+        return;
+    }
+
+    std::vector<PipelineDescription> descriptions(nb_descriptions);
+    descriptions_file.read(reinterpret_cast<char *>(descriptions.data()), nb_descriptions * sizeof(PipelineDescription));
+    if (!descriptions_file) {
+        LOG_WARN("Pipeline descriptions are corrupted, ignoring them.");
+        return;
+    }
+
+    pipelines_to_preload.clear();
+    add_pipeline_descriptions(descriptions);
+    LOG_INFO("Found {} pipelines to preload", pipelines_to_preload.size());
+}
+
+void PipelineCache::add_pipeline_descriptions(std::span<const PipelineDescription> descriptions) {
+    for (const PipelineDescription &desc : descriptions) {
+        if (desc.attribute_count > desc.attributes.size() || desc.binding_count > desc.bindings.size())
+            continue;
+
+        // the GPU may not be the same as the one the description was made with
+        const bool is_supported = std::none_of(desc.attributes.begin(), desc.attributes.begin() + desc.attribute_count, [&](const auto &attribute) {
+            return unsupported_rgb_vertex_attribute_formats.contains(attribute.format);
+        });
+        if (!is_supported || pipeline_descriptions.find(desc.key) != pipeline_descriptions.end())
+            continue;
+
+        pipeline_descriptions[desc.key] = desc;
+        pipelines_to_preload.push_back(desc.key);
+    }
+}
+
+void PipelineCache::save_pipeline_descriptions() {
+    // do a copy for thread safety
+    std::vector<PipelineDescription> descriptions;
+    {
+        std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(descriptions_mutex);
+        descriptions.reserve(pipeline_descriptions.size());
+        for (const auto &[_, desc] : pipeline_descriptions)
+            descriptions.push_back(desc);
+    }
+    if (descriptions.empty())
+        return;
+
+    const std::string descriptions_name = fmt::format("pipelines-vk{}.dat", shader::CURRENT_VERSION);
+    fs::ofstream descriptions_file(state.shaders_path / descriptions_name, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!descriptions_file.is_open())
+        return;
+
+    const uint32_t description_size = sizeof(PipelineDescription);
+    const uint32_t nb_descriptions = static_cast<uint32_t>(descriptions.size());
+    descriptions_file.write(reinterpret_cast<const char *>(&pipeline_descriptions_magic), sizeof(pipeline_descriptions_magic));
+    descriptions_file.write(reinterpret_cast<const char *>(&description_size), sizeof(description_size));
+    descriptions_file.write(reinterpret_cast<const char *>(&nb_descriptions), sizeof(nb_descriptions));
+    descriptions_file.write(reinterpret_cast<const char *>(descriptions.data()), nb_descriptions * sizeof(PipelineDescription));
+}
+
+std::vector<uint8_t> PipelineCache::export_descriptions() {
+    std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(descriptions_mutex);
+    const uint32_t description_size = sizeof(PipelineDescription);
+    std::vector<uint8_t> data(sizeof(description_size) + pipeline_descriptions.size() * sizeof(PipelineDescription));
+    memcpy(data.data(), &description_size, sizeof(description_size));
+    uint8_t *dest = data.data() + sizeof(description_size);
+    for (const auto &[_, desc] : pipeline_descriptions) {
+        memcpy(dest, &desc, sizeof(PipelineDescription));
+        dest += sizeof(PipelineDescription);
+    }
+    return data;
+}
+
+void PipelineCache::import_descriptions(std::span<const uint8_t> data) {
+    uint32_t description_size = 0;
+    if (data.size() >= sizeof(description_size))
+        memcpy(&description_size, data.data(), sizeof(description_size));
+    if (description_size != sizeof(PipelineDescription)) {
+        LOG_WARN("Imported pipeline descriptions are outdated, ignoring them.");
+        return;
+    }
+
+    std::vector<PipelineDescription> descriptions((data.size() - sizeof(description_size)) / sizeof(PipelineDescription));
+    memcpy(descriptions.data(), data.data() + sizeof(description_size), descriptions.size() * sizeof(PipelineDescription));
+
+    const size_t previous_count = pipelines_to_preload.size();
+    {
+        std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(descriptions_mutex);
+        add_pipeline_descriptions(descriptions);
+    }
+    LOG_INFO("Imported {} pipelines to preload", pipelines_to_preload.size() - previous_count);
+}
+
+std::vector<uint8_t> PipelineCache::export_pipeline_cache() {
+    const std::vector<uint8_t> pipeline_data = state.device.getPipelineCacheData(pipeline_cache);
+    if (pipeline_data.empty())
+        return {};
+
+    // same layout as the pipeline cache file, without the magic
+    std::vector<uint8_t> data(sizeof(uint64_t) + pipelines.size() * sizeof(uint64_t) + pipeline_data.size());
+    uint8_t *dest = data.data();
+    const uint64_t nb_hashes = pipelines.size();
+    memcpy(dest, &nb_hashes, sizeof(nb_hashes));
+    dest += sizeof(nb_hashes);
+    for (const auto &[hash, _] : pipelines) {
+        memcpy(dest, &hash, sizeof(hash));
+        dest += sizeof(hash);
+    }
+    memcpy(dest, pipeline_data.data(), pipeline_data.size());
+    return data;
+}
+
+void PipelineCache::import_pipeline_cache(std::span<const uint8_t> data) {
+    uint64_t nb_hashes = 0;
+    if (data.size() >= sizeof(nb_hashes))
+        memcpy(&nb_hashes, data.data(), sizeof(nb_hashes));
+    const uint64_t hashes_size = sizeof(nb_hashes) + nb_hashes * sizeof(uint64_t);
+    if (data.size() < hashes_size) {
+        LOG_WARN("Imported pipeline cache is corrupted, ignoring it.");
+        return;
+    }
+
+    const std::span<const uint8_t> pipeline_data = data.subspan(hashes_size);
+    if (!is_pipeline_cache_compatible(state.physical_device_properties, { reinterpret_cast<const char *>(pipeline_data.data()), pipeline_data.size() })) {
+        LOG_WARN("Imported pipeline cache was made with another GPU or driver, ignoring it.");
+        return;
+    }
+
+    vk::PipelineCacheCreateInfo cache_info{
+        .initialDataSize = pipeline_data.size(),
+        .pInitialData = pipeline_data.data()
+    };
+    const vk::PipelineCache imported_cache = state.device.createPipelineCache(cache_info);
+    state.device.mergePipelineCaches(pipeline_cache, imported_cache);
+    state.device.destroyPipelineCache(imported_cache);
+
+    for (uint64_t i = 0; i < nb_hashes; i++) {
+        uint64_t hash;
+        memcpy(&hash, data.data() + sizeof(nb_hashes) + i * sizeof(uint64_t), sizeof(hash));
+        pipelines.insert({ hash, nullptr });
+    }
+    LOG_INFO("Imported pipeline cache merged");
+}
+
+bool PipelineCache::preload_pipelines(std::chrono::milliseconds max_duration) {
+    R_PROFILE(__func__);
+
+    // can't use constexpr because of apple clang...
+    const vk::Pipeline pipeline_compiling = std::bit_cast<vk::Pipeline, uint64_t>(~0ULL);
+    const auto start = std::chrono::steady_clock::now();
+
+    while (!pipelines_to_preload.empty()) {
+        // when the compile threads are used, queuing everything is fast enough to not need the time limit
+        if (!use_async_compilation && std::chrono::steady_clock::now() - start >= max_duration)
+            return true;
+
+        const uint64_t key = pipelines_to_preload.back();
+        pipelines_to_preload.pop_back();
+        state.programs_count_pre_compiled++;
+
+        PipelineDescription desc;
+        {
+            std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(descriptions_mutex);
+            desc = pipeline_descriptions[key];
+        }
+        const GxmRecordState &record = desc.get_record();
+
+        auto it = pipelines.insert({ key, nullptr }).first;
+        if (it->second != nullptr)
+            continue;
+
+        // only the shaders already compiled to the disk can be used
+        const vk::ShaderModule vertex_module = precompile_shader(record.vertex_program_hash);
+        const vk::ShaderModule fragment_module = precompile_shader(record.fragment_program_hash);
+        if (!vertex_module || !fragment_module)
+            continue;
+
+        // the render pass load and store operations do not matter, any compatible render pass can be used
+        const vk::RenderPass render_pass = retrieve_render_pass(desc.color_format, false, false, false, desc.use_shader_interlock);
+
+        if (use_async_compilation) {
+            CompileRequest *request = new CompileRequest;
+            *request = {
+                .pipeline = &it->second,
+                .key = key,
+                .type = desc.type,
+                .render_pass = render_pass,
+                .color_format = desc.color_format,
+                .description = desc,
+                .vertex_module = vertex_module,
+                .fragment_module = fragment_module
+            };
+            it->second = pipeline_compiling;
+
+            enqueue_compile_request(request, true);
+        } else {
+            it->second = preload_pipeline(desc, render_pass, vertex_module, fragment_module);
+            state.shaders_count_compiled++;
+        }
+    }
+
+    return false;
+}
+
+// adds the time between its construction and its destruction to a counter of the frame statistics, in microseconds
+struct ScopedDuration {
+    std::atomic<uint64_t> &counter;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    explicit ScopedDuration(std::atomic<uint64_t> &counter)
+        : counter(counter) {}
+
+    ~ScopedDuration() {
+        counter += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+PipelineStats PipelineCache::take_frame_stats() {
+    return {
+        .sync_compiles = frame_stats.sync_compiles.exchange(0),
+        .async_compiles = frame_stats.async_compiles.exchange(0),
+        .sync_compile_ms = frame_stats.sync_compile_us.exchange(0) / 1000.0f,
+        .shader_retrieve_ms = frame_stats.shader_retrieve_us.exchange(0) / 1000.0f,
+        .pipeline_hits = frame_stats.pipeline_hits.exchange(0),
+        .pipeline_misses = frame_stats.pipeline_misses.exchange(0),
+        .shader_hits = frame_stats.shader_hits.exchange(0),
+        .shader_misses = frame_stats.shader_misses.exchange(0),
+    };
+}
+
 // Vulkan structs used to specify a specialization constant
 // Also, booleans in SPIRV are 32bit wide
 static const vk::SpecializationMapEntry srgb_entry = {
@@ -395,6 +721,10 @@ static const vk::SpecializationInfo srgb_info_false = {
 };
 
 vk::PipelineShaderStageCreateInfo PipelineCache::retrieve_shader(const SceGxmProgram *program, const Sha256Hash &hash, bool is_vertex, bool maskupdate, MemState &mem, const shader::Hints &hints, bool is_srgb) {
+    R_PROFILE(__func__);
+    // the waits for the other threads translating the same shader are counted too
+    const ScopedDuration duration(frame_stats.shader_retrieve_us);
+
     if (maskupdate)
         LOG_WARN_ONCE("Mask not implemented in the vulkan renderer!");
 
@@ -406,10 +736,25 @@ vk::PipelineShaderStageCreateInfo PipelineCache::retrieve_shader(const SceGxmPro
         spec_info = is_srgb ? &srgb_info_true : &srgb_info_false;
     }
 
+    // everything that would have needed another module without the specialization constant:
+    // the module hash, the gamma correction and the hints the module may have been generated with
+    uint64_t variant_key = XXH3_64bits(hash.data(), hash.size());
+    if (spec_info)
+        variant_key ^= is_srgb ? 1 : 0;
+    if (is_vertex) {
+        variant_key ^= XXH3_64bits(hints.vertex_textures, sizeof(hints.vertex_textures)) << 1;
+        if (hints.attributes)
+            variant_key ^= XXH3_64bits(hints.attributes->data(), hints.attributes->size() * sizeof(SceGxmVertexAttribute)) << 2;
+    } else {
+        variant_key ^= XXH3_64bits(hints.fragment_textures, sizeof(hints.fragment_textures)) << 1;
+        variant_key ^= static_cast<uint64_t>(gxm::get_base_format(hints.color_format)) << 32;
+    }
+
     vk::ShaderModule *shader_module;
     {
         // look if it is in the cache
-        std::unique_lock<std::mutex> lock(shaders_mutex);
+        std::unique_lock<PROFILE_LOCKABLE_TYPE(std::mutex)> lock(shaders_mutex);
+        shader_variants.insert(variant_key);
         shader_module = &shaders.insert({ hash, nullptr }).first->second;
         if (*shader_module == shader_compiling) {
             // another thread is compiling the same exact shader at the same time
@@ -421,9 +766,13 @@ vk::PipelineShaderStageCreateInfo PipelineCache::retrieve_shader(const SceGxmPro
                 std::this_thread::yield();
         }
 
-        if (*shader_module == nullptr)
+        if (*shader_module == nullptr) {
             // now mark the shader as compiling so that other threads accessing it won't try to compile it a second time
             *shader_module = shader_compiling;
+            frame_stats.shader_misses++;
+        } else {
+            frame_stats.shader_hits++;
+        }
     }
 
     if (*shader_module == shader_compiling) {
@@ -445,7 +794,7 @@ vk::PipelineShaderStageCreateInfo PipelineCache::retrieve_shader(const SceGxmPro
     LOG_INFO("Generating vulkan spv shader {}", hash_text);
     const std::string shader_version = fmt::format("vk{}", shader::CURRENT_VERSION);
 
-    shader::usse::SpirvCode source = load_spirv_shader(*program, state.features, true, hints, maskupdate, state.shaders_path, state.shaders_log_path, shader_version, true);
+    shader::usse::SpirvCode source = load_spirv_shader(*program, hash, state.features, true, hints, maskupdate, state.shaders_path, state.shaders_log_path, shader_version, true);
 
     vk::ShaderModuleCreateInfo shader_info{
         .codeSize = sizeof(uint32_t) * source.size(),
@@ -454,7 +803,7 @@ vk::PipelineShaderStageCreateInfo PipelineCache::retrieve_shader(const SceGxmPro
 
     *shader_module = state.device.createShaderModule(shader_info);
     {
-        std::lock_guard<std::mutex> guard(shaders_mutex);
+        std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(shaders_mutex);
         // Save shader cache hashes
         // vertex and fragment shaders are not linked together so no need to associate them
         Sha256Hash empty_hash{};
@@ -719,22 +1068,46 @@ vk::PipelineVertexInputStateCreateInfo PipelineCache::get_vertex_input_state(con
 }
 
 void PipelineCache::compiler_thread(MemState &mem) {
-    moodycamel::ConsumerToken consumer_token(pipeline_compile_queue);
+    PROFILE_THREAD_NAME("Pipeline compiler");
+    // the compilation happens in the background, it must not take the cores of the guest threads
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+    moodycamel::ConsumerToken draw_consumer_token(draw_compile_queue);
+    moodycamel::ConsumerToken preload_consumer_token(preload_compile_queue);
 
     // just a single loop, waiting for a pipeline compile request and compiling it
     CompileRequest *request;
     while (true) {
-        pipeline_compile_queue.wait_dequeue(consumer_token, request);
+        if (!compile_requests_available.wait(compile_thread_idle_timeout_us)) {
+            std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(compile_threads_mutex);
+            // once async compilation is disabled, the thread must wait for the nullptr sent to it
+            if (use_async_compilation && nb_compile_threads > 1) {
+                nb_compile_threads--;
+                break;
+            }
+            continue;
+        }
+
+        // a request is available, but the queues can look empty for a short time after it was enqueued
+        while (!draw_compile_queue.try_dequeue(draw_consumer_token, request)
+            && !preload_compile_queue.try_dequeue(preload_consumer_token, request)) {
+        }
+        pending_compile_requests--;
 
         if (request == nullptr)
             // use this as an instruction to stop the thread
             break;
 
-        vk::Pipeline pipeline = compile_pipeline(request->type, request->render_pass, *request->vertex_program_gxm, *request->fragment_program_gxm, *request->get_record(), request->hints, mem);
-        *request->pipeline = pipeline;
+        if (request->description) {
+            *request->pipeline = preload_pipeline(*request->description, request->render_pass, request->vertex_module, request->fragment_module);
+        } else {
+            vk::Pipeline pipeline = compile_pipeline(request->key, request->type, request->render_pass, request->color_format, *request->vertex_program_gxm, *request->fragment_program_gxm, *request->get_record(), request->hints, mem);
+            register_fallback_pipeline(request->fallback_key, pipeline);
+            *request->pipeline = pipeline;
 
-        request->vertex_program_gxm->compile_threads_on.fetch_sub(1, std::memory_order_release);
-        request->fragment_program_gxm->compile_threads_on.fetch_sub(1, std::memory_order_release);
+            request->vertex_program_gxm->compile_threads_on.fetch_sub(1, std::memory_order_release);
+            request->fragment_program_gxm->compile_threads_on.fetch_sub(1, std::memory_order_release);
+        }
 
         const auto time_s = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
         next_pipeline_cache_save = time_s + pipeline_cache_save_delay;
@@ -754,7 +1127,9 @@ static vk::StencilOpState convert_op_state(const GxmStencilStateOp &state) {
     };
 }
 
-vk::Pipeline PipelineCache::compile_pipeline(SceGxmPrimitiveType type, vk::RenderPass render_pass, const SceGxmVertexProgram &vertex_program_gxm, const SceGxmFragmentProgram &fragment_program_gxm, const GxmRecordState &record, const shader::Hints &hints, MemState &mem) {
+vk::Pipeline PipelineCache::compile_pipeline(uint64_t key, SceGxmPrimitiveType type, vk::RenderPass render_pass, vk::Format color_format, const SceGxmVertexProgram &vertex_program_gxm, const SceGxmFragmentProgram &fragment_program_gxm, const GxmRecordState &record, const shader::Hints &hints, MemState &mem) {
+    R_PROFILE(__func__);
+
     const VertexProgram &vertex_program = *vertex_program_gxm.renderer_data;
     const SceGxmProgram *gxm_fragment_shader = fragment_program_gxm.program.get(mem);
     const VKFragmentProgram &fragment_program = *reinterpret_cast<VKFragmentProgram *>(
@@ -763,21 +1138,59 @@ vk::Pipeline PipelineCache::compile_pipeline(SceGxmPrimitiveType type, vk::Rende
     // the vertex input state must be computed before shader are retrieved in case symbols are stripped
     const vk::PipelineVertexInputStateCreateInfo vertex_input = get_vertex_input_state(vertex_program_gxm, mem);
 
+    // translate the fragment shader on the pool while this thread takes care of the vertex shader
+    // the whole retrieve_shader call is a job so that a shader is only marked as compiling by a thread which is translating it
+    std::future<vk::PipelineShaderStageCreateInfo> fragment_shader_job = shader_translation_pool.submit([&]() {
+        return retrieve_shader(gxm_fragment_shader, fragment_program.hash, false, fragment_program_gxm.is_maskupdate, mem, hints, record.is_gamma_corrected);
+    });
     const vk::PipelineShaderStageCreateInfo vertex_shader = retrieve_shader(vertex_program_gxm.program.get(mem), vertex_program.hash, true, fragment_program_gxm.is_maskupdate, mem, hints);
-    const vk::PipelineShaderStageCreateInfo fragment_shader = retrieve_shader(gxm_fragment_shader, fragment_program.hash, false, fragment_program_gxm.is_maskupdate, mem, hints, record.is_gamma_corrected);
+    const vk::PipelineShaderStageCreateInfo fragment_shader = fragment_shader_job.get();
     const vk::PipelineShaderStageCreateInfo shader_stages[] = { vertex_shader, fragment_shader };
-    // disable the fragment shader if gxm asks us to
-    const bool is_fragment_disabled = record.front_side_fragment_program_mode == SCE_GXM_FRAGMENT_PROGRAM_DISABLED || gxm_fragment_shader->has_no_effect();
-    const uint32_t shader_stage_count = is_fragment_disabled ? 1U : 2U;
+
+    PipelineDescription desc{
+        .key = key,
+        .type = type,
+        .color_format = color_format,
+        .use_shader_interlock = state.features.support_shader_interlock && gxm_fragment_shader->is_frag_color_used(),
+        // disable the fragment shader if gxm asks us to
+        .is_fragment_disabled = record.front_side_fragment_program_mode == SCE_GXM_FRAGMENT_PROGRAM_DISABLED || gxm_fragment_shader->has_no_effect(),
+        .frag_has_no_output = static_cast<bool>(gxm_fragment_shader->program_flags & SCE_GXM_PROGRAM_FLAG_OUTPUT_UNDEFINED),
+        .is_frag_color_used = gxm_fragment_shader->is_frag_color_used(),
+        .vertex_texture_count = static_cast<uint8_t>(vertex_program.texture_count),
+        .fragment_texture_count = static_cast<uint8_t>(fragment_program.texture_count),
+        .binding_count = static_cast<uint8_t>(vertex_input.vertexBindingDescriptionCount),
+        .attribute_count = static_cast<uint8_t>(vertex_input.vertexAttributeDescriptionCount),
+        .blending = fragment_program.blending
+    };
+    memcpy(desc.record_data, &record, record_pipeline_len);
+
+    const vk::Pipeline pipeline = create_pipeline(desc, render_pass, vertex_input, shader_stages);
+
+    // remember how this pipeline was made so that it can be created again at boot next time
+    if (pipeline && vertex_input.vertexAttributeDescriptionCount <= desc.attributes.size()) {
+        std::copy_n(vertex_input.pVertexBindingDescriptions, desc.binding_count, desc.bindings.begin());
+        std::copy_n(vertex_input.pVertexAttributeDescriptions, desc.attribute_count, desc.attributes.begin());
+
+        std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(descriptions_mutex);
+        pipeline_descriptions[key] = desc;
+    }
+
+    return pipeline;
+}
+
+vk::Pipeline PipelineCache::create_pipeline(const PipelineDescription &desc, vk::RenderPass render_pass, const vk::PipelineVertexInputStateCreateInfo &vertex_input, const vk::PipelineShaderStageCreateInfo *shader_stages) {
+    R_PROFILE(__func__);
+
+    const GxmRecordState &record = desc.get_record();
+
+    const uint32_t shader_stage_count = desc.is_fragment_disabled ? 1U : 2U;
 
     const vk::PipelineInputAssemblyStateCreateInfo input_assembly{
-        .topology = translate_primitive(type)
+        .topology = translate_primitive(desc.type)
     };
 
     const bool two_sided = (record.two_sided == SCE_GXM_TWO_SIDED_ENABLED);
 
-    const bool use_shader_interlock = state.features.support_shader_interlock && gxm_fragment_shader->is_frag_color_used();
-
     const vk::PipelineRasterizationStateCreateInfo rasterizer{
         .depthClampEnable = state.physical_device_features.depthClamp,
         .polygonMode = translate_polygon_mode(record.front_polygon_mode),
@@ -803,11 +1216,10 @@ vk::Pipeline PipelineCache::compile_pipeline(SceGxmPrimitiveType type, vk::Rende
     };
 
     vk::PipelineColorBlendStateCreateInfo color_blending{};
-    if (support_coherent_framebuffer_fetch && gxm_fragment_shader->is_frag_color_used())
+    if (support_coherent_framebuffer_fetch && desc.is_frag_color_used)
         color_blending.flags = vk::PipelineColorBlendStateCreateFlagBits::eRasterizationOrderAttachmentAccessEXT;
 
-    const bool frag_has_no_output = static_cast<bool>(gxm_fragment_shader->program_flags & SCE_GXM_PROGRAM_FLAG_OUTPUT_UNDEFINED);
-    if (is_fragment_disabled || frag_has_no_output || use_shader_interlock) {
+    if (desc.is_fragment_disabled || desc.frag_has_no_output || desc.use_shader_interlock) {
         // The write mask must be empty as the lack of a fragment shader results in undefined values
         static const vk::PipelineColorBlendAttachmentState blending = {
             .blendEnable = VK_FALSE,
@@ -815,27 +1227,35 @@ vk::Pipeline PipelineCache::compile_pipeline(SceGxmPrimitiveType type, vk::Rende
         };
         color_blending.setAttachments(blending);
     } else {
-        const vk::PipelineColorBlendAttachmentState &blending = fragment_program.blending;
-        color_blending.setAttachments(blending);
+        color_blending.setAttachments(desc.blending);
     }
 
-    vk::PipelineLayout pipeline_layout = pipeline_layouts[vertex_program.texture_count][fragment_program.texture_count];
+    vk::PipelineLayout pipeline_layout = pipeline_layouts[desc.vertex_texture_count][desc.fragment_texture_count];
 
     // all of these can be changed at any time using the vita graphics api (like opengl)
     // Because each one can take a lot of different values, it's better to set them as dynamic
-    const std::array dynamic_states = {
+    std::vector<vk::DynamicState> dynamic_states = {
         vk::DynamicState::eViewport,
         vk::DynamicState::eScissor,
         vk::DynamicState::eStencilCompareMask,
         vk::DynamicState::eStencilReference,
         vk::DynamicState::eStencilWriteMask,
         vk::DynamicState::eDepthBias,
-        vk::DynamicState::eLineWidth,
     };
+    if (state.physical_device_features.wideLines)
+        dynamic_states.push_back(vk::DynamicState::eLineWidth);
+    if (state.support_extended_dynamic_state) {
+        // these are not part of the pipeline key in this case, see hash_pipeline_record
+        constexpr std::array extended_dynamic_states = {
+            vk::DynamicState::eCullModeEXT,
+            vk::DynamicState::eDepthWriteEnableEXT,
+            vk::DynamicState::eDepthCompareOpEXT,
+            vk::DynamicState::eStencilOpEXT,
+        };
+        dynamic_states.insert(dynamic_states.end(), extended_dynamic_states.begin(), extended_dynamic_states.end());
+    }
     vk::PipelineDynamicStateCreateInfo dynamic_info{};
     dynamic_info.setDynamicStates(dynamic_states);
-    if (!state.physical_device_features.wideLines)
-        dynamic_info.dynamicStateCount--;
 
     // we still need to specify the viewport and scissor count even though they are dynamic
     vk::PipelineViewportStateCreateInfo viewport{
@@ -868,10 +1288,87 @@ vk::Pipeline PipelineCache::compile_pipeline(SceGxmPrimitiveType type, vk::Rende
     return result.value;
 }
 
+vk::Pipeline PipelineCache::preload_pipeline(const PipelineDescription &desc, vk::RenderPass render_pass, vk::ShaderModule vertex_module, vk::ShaderModule fragment_module) {
+    vk::PipelineVertexInputStateCreateInfo vertex_input{
+        .vertexBindingDescriptionCount = desc.binding_count,
+        .pVertexBindingDescriptions = desc.bindings.data(),
+        .vertexAttributeDescriptionCount = desc.attribute_count,
+        .pVertexAttributeDescriptions = desc.attributes.data()
+    };
+
+    const vk::SpecializationInfo *spec_info = nullptr;
+    if (state.features.should_use_shader_interlock() && desc.is_frag_color_used)
+        spec_info = desc.get_record().is_gamma_corrected ? &srgb_info_true : &srgb_info_false;
+
+    const vk::PipelineShaderStageCreateInfo shader_stages[] = {
+        {
+            .stage = vk::ShaderStageFlagBits::eVertex,
+            .module = vertex_module,
+            .pName = "main_vs",
+        },
+        {
+            .stage = vk::ShaderStageFlagBits::eFragment,
+            .module = fragment_module,
+            .pName = "main_fs",
+            .pSpecializationInfo = spec_info,
+        }
+    };
+
+    return create_pipeline(desc, render_pass, vertex_input, shader_stages);
+}
+
+// pipelines with the same fallback key only differ by their fixed-function state, so they use the same layout,
+// vertex input and compatible render passes and can be bound in place of each other
+static uint64_t get_fallback_key(const GxmRecordState &record, const SceGxmVertexProgram &vertex_program_gxm, SceGxmPrimitiveType type, vk::Format color_format) {
+    // the shader hashes are at the beginning of the record
+    uint64_t key = XXH3_64bits(&record, offsetof(GxmRecordState, color_base_format));
+    key ^= vertex_program_gxm.key_hash;
+    key ^= static_cast<uint64_t>(type);
+    key ^= static_cast<uint64_t>(record.front_side_fragment_program_mode) << 16;
+    key ^= static_cast<uint64_t>(color_format) << 32;
+    return key;
+}
+
+void PipelineCache::register_fallback_pipeline(uint64_t fallback_key, vk::Pipeline pipeline) {
+    if (!pipeline)
+        return;
+
+    std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(fallback_mutex);
+    fallback_pipelines.try_emplace(fallback_key, pipeline);
+}
+
+vk::Pipeline PipelineCache::retrieve_fallback_pipeline(uint64_t fallback_key) {
+    std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(fallback_mutex);
+    auto it = fallback_pipelines.find(fallback_key);
+    return it == fallback_pipelines.end() ? nullptr : it->second;
+}
+
+// with the extended dynamic state, the cull mode and the depth and stencil ops are set when drawing
+// so they must not be part of the pipeline key
+static uint64_t hash_pipeline_record(const GxmRecordState &record, bool use_dynamic_state) {
+    if (!use_dynamic_state)
+        return XXH3_64bits(&record, record_pipeline_len);
+
+    alignas(8) uint8_t record_data[record_pipeline_len];
+    memcpy(record_data, &record, record_pipeline_len);
+    const auto clear_range = [&](size_t begin, size_t end) {
+        memset(record_data + begin, 0, end - begin);
+    };
+    // cull_mode and two_sided
+    clear_range(offsetof(GxmRecordState, cull_mode), offsetof(GxmRecordState, region_clip_mode));
+    // the stencil ops, depth funcs and depth write modes
+    clear_range(offsetof(GxmRecordState, front_stencil_state_op), offsetof(GxmRecordState, front_side_fragment_program_mode));
+
+    // use another seed so that these keys can't match the ones of pipelines saved without the dynamic state
+    return XXH3_64bits_withSeed(record_data, record_pipeline_len, 1);
+}
+
 vk::Pipeline PipelineCache::retrieve_pipeline(VKContext &context, SceGxmPrimitiveType &type, bool consider_for_async, MemState &mem) {
+    R_PROFILE(__func__);
+
     const GxmRecordState &record = context.record;
     // get the hash of the current context
-    uint64_t key = XXH3_64bits(&record, record_pipeline_len);
+    uint64_t key = hash_pipeline_record(record, state.support_extended_dynamic_state);
 
     // add the hash of the blending
     SceGxmFragmentProgram &fragment_program_gxm = *record.fragment_program.get(mem);
@@ -894,17 +1391,29 @@ vk::Pipeline PipelineCache::retrieve_pipeline(VKContext &context, SceGxmPrimitiv
     auto it = pipelines.find(key);
     if (it != pipelines.end()) {
         if (it->second != nullptr) {
-            if (it->second == pipeline_compiling)
-                // pipeline is still compiling
-                return nullptr;
-            else
-                return it->second;
+            if (it->second == pipeline_compiling) {
+                if (consider_for_async) {
+                    // pipeline is still compiling, look for it again on the next draw so it is used as soon as it is ready
+                    context.refresh_pipeline = true;
+                    return retrieve_fallback_pipeline(get_fallback_key(record, vertex_program_gxm, type, context.current_color_format));
+                }
+
+                // this draw can't be skipped, wait for the compile thread to be done with it
+                // (it may have been sent at boot by the pipeline preloading)
+                const frame_timings::Scope timing(frame_timings::Stage::PipelineWait);
+                const ScopedDuration duration(frame_stats.sync_compile_us);
+                while (it->second == pipeline_compiling)
+                    std::this_thread::yield();
+            }
+            frame_stats.pipeline_hits++;
+            return it->second;
         }
         already_in_cache = true;
     } else {
         // the pipeline hash was not in the cache;
         it = pipelines.insert({ key, pipeline_compiling }).first;
     }
+    frame_stats.pipeline_misses++;
 
     // get the correct renderpass here
     const SceGxmProgram *gxm_fragment_shader = fragment_program_gxm.program.get(mem);
@@ -916,14 +1425,18 @@ vk::Pipeline PipelineCache::retrieve_pipeline(VKContext &context, SceGxmPrimitiv
 
     // note: the flag can_use_deferred_compilation is not considered here because it causes way too many false positives
     const bool compile_pipeline_async = !already_in_cache && consider_for_async && use_async_compilation;
+    const uint64_t fallback_key = get_fallback_key(record, vertex_program_gxm, type, context.current_color_format);
 
     if (compile_pipeline_async) {
         // create the pipeline compile request
         CompileRequest *request = new CompileRequest;
         *request = {
             .pipeline = &it->second,
+            .key = key,
+            .fallback_key = fallback_key,
             .type = type,
             .render_pass = render_pass,
+            .color_format = context.current_color_format,
             .vertex_program_gxm = &vertex_program_gxm,
             .fragment_program_gxm = &fragment_program_gxm,
             .hints = context.shader_hints
@@ -935,12 +1448,17 @@ vk::Pipeline PipelineCache::retrieve_pipeline(VKContext &context, SceGxmPrimitiv
         vertex_program_gxm.compile_threads_on.fetch_add(1, std::memory_order_relaxed);
         fragment_program_gxm.compile_threads_on.fetch_add(1, std::memory_order_relaxed);
 
-        pipeline_compile_queue.enqueue(pipeline_compile_queue_token, request);
+        enqueue_compile_request(request, false);
+        frame_stats.async_compiles++;
 
-        return nullptr;
+        context.refresh_pipeline = true;
+        return retrieve_fallback_pipeline(fallback_key);
     } else {
         // can't wait, compile it right now
-        vk::Pipeline result = compile_pipeline(type, render_pass, vertex_program_gxm, fragment_program_gxm, record, context.shader_hints, mem);
+        const frame_timings::Scope timing(frame_timings::Stage::PipelineWait);
+        const ScopedDuration duration(frame_stats.sync_compile_us);
+        frame_stats.sync_compiles++;
+        vk::Pipeline result = compile_pipeline(key, type, render_pass, context.current_color_format, vertex_program_gxm, fragment_program_gxm, record, context.shader_hints, mem);
 
         const auto time_s = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
         next_pipeline_cache_save = time_s + pipeline_cache_save_delay;
@@ -948,6 +1466,7 @@ vk::Pipeline PipelineCache::retrieve_pipeline(VKContext &context, SceGxmPrimitiv
         if (!already_in_cache)
             state.shaders_count_compiled++;
 
+        register_fallback_pipeline(fallback_key, result);
         it->second = result;
 
         return result;
@@ -955,6 +1474,8 @@ vk::Pipeline PipelineCache::retrieve_pipeline(VKContext &context, SceGxmPrimitiv
 }
 
 vk::ShaderModule PipelineCache::precompile_shader(const Sha256Hash &hash, bool search_first) {
+    R_PROFILE(__func__);
+
     if (search_first) {
         // happens while loading the thread, no parallel access so no need for a mutex
         auto it = shaders.find(hash);
@@ -968,19 +1489,25 @@ vk::ShaderModule PipelineCache::precompile_shader(const Sha256Hash &hash, bool s
     Sha256Hash shader_hash;
     memcpy(shader_hash.data(), hash.data(), sizeof(Sha256Hash));
     const std::string shader_file_name = fmt::format("vk{}-{}.spv", shader::CURRENT_VERSION, hex_string(shader_hash));
-    const std::vector<uint32_t> source = renderer::pre_load_shader_spirv(state.shaders_path / shader_file_name);
+    // use the shader pack memory directly when possible
+    std::span<const uint32_t> code = renderer::find_packed_shader_spirv(state.shaders_path / shader_file_name);
+    std::vector<uint32_t> source;
+    if (code.empty()) {
+        source = renderer::pre_load_shader_spirv(state.shaders_path / shader_file_name);
+        code = source;
+    }
 
-    if (source.empty())
+    if (code.empty())
         return nullptr;
 
     vk::ShaderModuleCreateInfo shader_info{
-        .codeSize = sizeof(uint32_t) * source.size(),
-        .pCode = source.data()
+        .codeSize = sizeof(uint32_t) * code.size(),
+        .pCode = code.data()
     };
 
     vk::ShaderModule shader = state.device.createShaderModule(shader_info);
     {
-        std::lock_guard<std::mutex> guard(shaders_mutex);
+        std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(shaders_mutex);
         shaders[hash] = shader;
     }
 
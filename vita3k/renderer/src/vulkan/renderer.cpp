@@ -30,7 +30,9 @@
 #include <display/state.h>
 #include <shader/spirv_recompiler.h>
 #include <util/align.h>
+#include <util/frame_timings.h>
 #include <util/log.h>
+#include <util/profile.h>
 #include <vkutil/vkutil.h>
 
 #include <SDL3/SDL_vulkan.h>
@@ -151,6 +153,25 @@ const static std::vector<const char *> required_device_extensions = {
 namespace renderer::vulkan {
 
 #ifdef __ANDROID__
+static constexpr vk::BufferUsageFlags mapped_memory_flags = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferDst;
+
+// host memory given to the guest with the page table mapping method
+static vkutil::Buffer create_page_table_buffer(uint32_t size, bool move_to_guest) {
+    // add 4 KiB because we can as an easy way to prevent crashes due to memory accesses right after the memory boundary
+    // a buffer moved into the guest memory is followed by the guest memory instead, and needs a mapping of its own
+    vkutil::Buffer buffer(move_to_guest ? size : size + KiB(4));
+    vma::AllocationCreateInfo memory_mapped_alloc = {
+        .flags = vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessSequentialWrite,
+        .usage = vma::MemoryUsage::eAutoPreferHost,
+        .requiredFlags = vk::MemoryPropertyFlagBits::eHostCoherent,
+        .preferredFlags = vk::MemoryPropertyFlagBits::eHostCached,
+    };
+    if (move_to_guest)
+        memory_mapped_alloc.flags |= vma::AllocationCreateFlagBits::eDedicatedMemory;
+    buffer.init_buffer(mapped_memory_flags, memory_mapped_alloc);
+    return buffer;
+}
+
 static bool detect_patch_bcn(bool *support_dxt) {
     // some Adreno GPUs support BCn textures even though they say they don't
     // and we might need to patch a function for it to work
@@ -258,6 +279,29 @@ static bool select_queues(VKState &vk_state,
             break;
     }
 
+    // discrete GPUs have a transfer only family backed by DMA engines, copies submitted there run beside the rendering
+    // only use it if it can copy 1x1 blocks, as textures can have any size
+    if (vk_state.physical_device_properties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu) {
+        for (uint32_t i = 0; i < vk_state.physical_device_queue_families.size(); i++) {
+            const auto &queue_family = vk_state.physical_device_queue_families[i];
+            const bool is_transfer_only = (queue_family.queueFlags & vk::QueueFlagBits::eTransfer)
+                && !(queue_family.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+            if (!is_transfer_only || queue_family.minImageTransferGranularity != vk::Extent3D{ 1, 1, 1 })
+                continue;
+
+            std::vector<float> &priorities = queue_priorities.emplace_back(1, 1.0f);
+            vk::DeviceQueueCreateInfo queue_create_info{
+                .queueFamilyIndex = i,
+                .queueCount = 1,
+                .pQueuePriorities = priorities.data()
+            };
+            queue_infos.emplace_back(std::move(queue_create_info));
+            vk_state.async_transfer_family_index = i;
+            vk_state.support_async_transfer = true;
+            break;
+        }
+    }
+
     return found_graphics && found_transfer;
 }
 
@@ -612,6 +656,7 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
         bool support_buffer_device_address = false;
         bool support_external_memory = false;
         bool support_shader_interlock = false;
+        bool support_present_id = false;
         const std::map<std::string_view, bool *> optional_extensions = {
             { vk::KHRGetMemoryRequirements2ExtensionName, &temp_bool },
             // can be used by vma to improve performance
@@ -638,6 +683,15 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
 #endif
             // used for coherent framebuffer fetch
             { VK_EXT_RASTERIZATION_ORDER_ATTACHMENT_ACCESS_EXTENSION_NAME, &support_rasterized_order_access },
+            // bind the fragment textures without allocating descriptor sets
+            { vk::KHRPushDescriptorExtensionName, &support_push_descriptor },
+            // gives the memory the application can use without the driver having to page out
+            { vk::EXTMemoryBudgetExtensionName, &support_memory_budget },
+            // set the cull, depth and stencil ops without creating a pipeline for each of their values
+            { vk::EXTExtendedDynamicStateExtensionName, &support_extended_dynamic_state },
+            // wait for the previous frame to be presented, this keeps the latency low with fifo
+            { vk::KHRPresentIdExtensionName, &support_present_id },
+            { vk::KHRPresentWaitExtensionName, &support_present_wait },
 #ifdef __ANDROID__
             // dependencies of VK_ANDROID_external_memory_android_hardware_buffer
             { VK_KHR_BIND_MEMORY_2_EXTENSION_NAME, &temp_bool },
@@ -735,6 +789,18 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
             support_shader_interlock = false;
         }
 
+        if (support_extended_dynamic_state) {
+            auto props = physical_device.getFeatures2KHR<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
+            support_extended_dynamic_state = static_cast<bool>(props.get<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>().extendedDynamicState);
+        }
+
+        support_present_wait &= support_present_id;
+        if (support_present_wait) {
+            auto props = physical_device.getFeatures2KHR<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR, vk::PhysicalDevicePresentWaitFeaturesKHR>();
+            support_present_wait = props.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId
+                && props.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+        }
+
         support_shader_interlock &= static_cast<bool>(physical_device_features.fragmentStoresAndAtomics);
         if (support_shader_interlock) {
             auto props = physical_device.getFeatures2KHR<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceFragmentShaderInterlockFeaturesEXT>();
@@ -747,7 +813,10 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
             vk::PhysicalDeviceUniformBufferStandardLayoutFeatures,
             vk::PhysicalDeviceShaderFloat16Int8Features,
             vk::PhysicalDeviceFragmentShaderInterlockFeaturesEXT,
-            vk::PhysicalDeviceRasterizationOrderAttachmentAccessFeaturesEXT>
+            vk::PhysicalDeviceRasterizationOrderAttachmentAccessFeaturesEXT,
+            vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT,
+            vk::PhysicalDevicePresentIdFeaturesKHR,
+            vk::PhysicalDevicePresentWaitFeaturesKHR>
             device_info{
                 vk::DeviceCreateInfo{
                     .pEnabledFeatures = &enabled_features },
@@ -761,7 +830,13 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
                 vk::PhysicalDeviceFragmentShaderInterlockFeaturesEXT{
                     .fragmentShaderSampleInterlock = VK_TRUE },
                 vk::PhysicalDeviceRasterizationOrderAttachmentAccessFeaturesEXT{
-                    .rasterizationOrderColorAttachmentAccess = VK_TRUE }
+                    .rasterizationOrderColorAttachmentAccess = VK_TRUE },
+                vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT{
+                    .extendedDynamicState = VK_TRUE },
+                vk::PhysicalDevicePresentIdFeaturesKHR{
+                    .presentId = VK_TRUE },
+                vk::PhysicalDevicePresentWaitFeaturesKHR{
+                    .presentWait = VK_TRUE }
             };
         device_info.get().setQueueCreateInfos(queue_infos);
         device_info.get().setPEnabledExtensionNames(device_extensions);
@@ -781,6 +856,14 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
         if (!support_shader_interlock)
             device_info.unlink<vk::PhysicalDeviceFragmentShaderInterlockFeaturesEXT>();
 
+        if (!support_extended_dynamic_state)
+            device_info.unlink<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
+
+        if (!support_present_wait) {
+            device_info.unlink<vk::PhysicalDevicePresentIdFeaturesKHR>();
+            device_info.unlink<vk::PhysicalDevicePresentWaitFeaturesKHR>();
+        }
+
         try {
             device = physical_device.createDevice(device_info.get());
         } catch (vk::NotPermittedError &) {
@@ -798,6 +881,8 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
     // Get Queues
     general_queue = device.getQueue(general_family_index, 0);
     transfer_queue = device.getQueue(transfer_family_index, 0);
+    if (support_async_transfer)
+        async_transfer_queue = device.getQueue(async_transfer_family_index, 0);
 
     // Create Command Pools
     {
@@ -842,8 +927,26 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
         if (supported_mapping_methods_mask > 1)
             allocator_info.flags |= vma::AllocatorCreateFlagBits::eBufferDeviceAddress;
 
+#ifdef TRACY_ENABLE
+        // the device memory blocks allocated by vma are shown in the profiler, the resources are suballocated from them
+        static const vma::DeviceMemoryCallbacks memory_callbacks = {
+            .pfnAllocate = [](VmaAllocator, uint32_t, VkDeviceMemory memory, VkDeviceSize size, void *) { PROFILE_ALLOC(memory, size, "GPU memory"); },
+            .pfnFree = [](VmaAllocator, uint32_t, VkDeviceMemory memory, VkDeviceSize, void *) { PROFILE_FREE(memory, "GPU memory"); },
+        };
+        allocator_info.pDeviceMemoryCallbacks = &memory_callbacks;
+#endif
+
         allocator = vma::createAllocator(allocator_info);
-        vkutil::init(allocator);
+
+        // tile-based GPUs (mostly on Android) can keep the transient attachments in their tile memory
+        bool support_lazy_memory = false;
+        for (uint32_t i = 0; i < physical_device_memory.memoryTypeCount; i++) {
+            if (physical_device_memory.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated)
+                support_lazy_memory = true;
+        }
+        if (support_lazy_memory)
+            LOG_INFO("Using lazily allocated memory for the transient attachments");
+        vkutil::init(allocator, support_lazy_memory);
     }
 
     // create the default image and buffer
@@ -891,10 +994,24 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
         pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
         frame.prerender_pool = device.createCommandPool(pool_info);
 
+        if (support_async_transfer) {
+            vk::CommandPoolCreateInfo async_transfer_pool_info{
+                .flags = vk::CommandPoolCreateFlagBits::eTransient,
+                .queueFamilyIndex = async_transfer_family_index
+            };
+            frame.async_transfer_pool = device.createCommandPool(async_transfer_pool_info);
+        }
+
         frame.destroy_queue.init(device);
     }
 
-    if (!screen_renderer.setup())
+    gpu_profiler.init(*this);
+
+    max_frames_in_flight = std::clamp(config.max_frames_in_flight, 1, MAX_FRAMES_RENDERING);
+    if (max_frames_in_flight != MAX_FRAMES_RENDERING)
+        LOG_INFO("Max frames in flight: {}", max_frames_in_flight);
+
+    if (!screen_renderer.setup(config.present_mode))
         return false;
 
     support_fsr &= static_cast<bool>(screen_renderer.surface_capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eStorage);
@@ -922,6 +1039,33 @@ void VKState::late_init(const Config &cfg, const std::string_view game_id, MemSt
         features.use_texture_viewport = true;
     }
 
+    features.optimize_spirv = cfg.optimize_spirv && shader::is_spirv_optimizer_available();
+    if (cfg.optimize_spirv && !features.optimize_spirv)
+        LOG_WARN("The SPIR-V optimizer is not available in this build");
+
+    // the surfaces grow with the resolution multiplier, by default they can use a quarter of the largest device local heap
+    uint64_t surface_cache_budget = MiB(static_cast<uint64_t>(std::max(cfg.surface_cache_budget, 0)));
+    if (surface_cache_budget == 0) {
+        for (uint32_t i = 0; i < physical_device_memory.memoryHeapCount; i++) {
+            const vk::MemoryHeap &heap = physical_device_memory.memoryHeaps[i];
+            if (heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+                surface_cache_budget = std::max<uint64_t>(surface_cache_budget, heap.size / 4);
+        }
+    }
+    surface_cache.set_memory_budget(surface_cache_budget);
+
+    stutter_threshold_ms = static_cast<uint32_t>(std::max(cfg.pipeline_stutter_threshold_ms, 0));
+
+    scene_chunk_draws = static_cast<uint32_t>(std::max(cfg.scene_chunk_draws, 0));
+    if (scene_chunk_draws > 0)
+        LOG_INFO("Scenes are submitted every {} draws", scene_chunk_draws);
+
+    use_async_transfer = cfg.async_texture_upload && support_async_transfer;
+    if (use_async_transfer)
+        LOG_INFO("New textures are uploaded on the transfer queue family {}", async_transfer_family_index);
+    else if (cfg.async_texture_upload)
+        LOG_INFO("No dedicated transfer queue available, textures are uploaded on the graphics queue");
+
     // parse the mapping method
     auto &config_mapping = cfg.current_config.memory_mapping;
     MappingMethod request_mapping = MappingMethod::Disabled;
@@ -939,6 +1083,16 @@ void VKState::late_init(const Config &cfg, const std::string_view game_id, MemSt
         // we support the requested mapping method
         mapping_method = request_mapping;
 
+    if (mapping_method == MappingMethod::PageTable && cfg.page_table_fastmem) {
+        // every guest memory access goes through the page table otherwise, check the driver lets its mappings be moved
+        vkutil::Buffer probe_buffer = create_page_table_buffer(KiB(64), true);
+        move_mapped_memory = can_move_external_mapping(static_cast<uint8_t *>(probe_buffer.mapped_data), KiB(64));
+        if (move_mapped_memory)
+            LOG_INFO("The mapped buffers are moved into the guest memory, the page table is not used");
+        else
+            LOG_INFO("The mapped buffers cannot be moved into the guest memory, the page table is used");
+    }
+
     features.enable_memory_mapping = mapping_method != MappingMethod::Disabled;
 
 #ifdef __ANDROID__
@@ -950,6 +1104,13 @@ void VKState::late_init(const Config &cfg, const std::string_view game_id, MemSt
         _AHardwareBuffer_lock = reinterpret_cast<decltype(_AHardwareBuffer_lock)>(dlsym(libandroid, "AHardwareBuffer_lock"));
         _AHardwareBuffer_unlock = reinterpret_cast<decltype(_AHardwareBuffer_unlock)>(dlsym(libandroid, "AHardwareBuffer_unlock"));
         _AHardwareBuffer_release = reinterpret_cast<decltype(_AHardwareBuffer_release)>(dlsym(libandroid, "AHardwareBuffer_release"));
+
+        const bool has_symbols = _AHardwareBuffer_allocate && _AHardwareBuffer_lock && _AHardwareBuffer_unlock && _AHardwareBuffer_release
+            && (support_android_buffer_import || _AHardwareBuffer_getNativeHandle);
+        if (!has_symbols) {
+            LOG_WARN("The Android hardware buffer functions are not available, using the page table memory mapping instead");
+            mapping_method = MappingMethod::PageTable;
+        }
     }
 #endif
 
@@ -960,16 +1121,30 @@ void VKState::late_init(const Config &cfg, const std::string_view game_id, MemSt
         || std::string_view(physical_device_properties.deviceName).find("NVIDIA") != std::string_view::npos;
 #endif
 
+    const vk::FormatFeatureFlags bgra_unorm_features = physical_device.getFormatProperties(vk::Format::eB8G8R8A8Unorm).optimalTilingFeatures;
+    const vk::FormatFeatureFlags bgra_srgb_features = physical_device.getFormatProperties(vk::Format::eB8G8R8A8Srgb).optimalTilingFeatures;
+    surface_cache.support_bgra_blit = (bgra_unorm_features & vk::FormatFeatureFlagBits::eBlitDst)
+        && (bgra_srgb_features & vk::FormatFeatureFlagBits::eBlitDst);
+
     pipeline_cache.init(support_rasterized_order_access);
 
     texture_cache.init(true, texture_folder(), game_id);
+    texture_cache.set_async_import(cfg.async_texture_import);
+
+    texture_cache.transcode_bcn_to_etc2 = cfg.transcode_bcn_to_etc2 && texture_cache.support_etc2 && !texture_cache.support_dxt;
+    if (texture_cache.transcode_bcn_to_etc2)
+        LOG_INFO("BCn textures are transcoded to ETC2");
 }
 
 void VKState::cleanup() {
     device.waitIdle();
 
+    texture_cache.log_stats();
+
     screen_renderer.cleanup();
+    gpu_profiler.destroy(device);
 
+    vkutil::clear_image_pool();
     allocator.destroy();
 
     device.destroy(general_command_pool);
@@ -990,9 +1165,10 @@ void VKState::render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &v
         frame = display.next_rendered_frame;
     }
 
-    if (!frame.base)
+    if (!frame.base || headless)
         return;
 
+    screen_renderer.frame_pickup_time = std::chrono::steady_clock::now();
     if (!screen_renderer.acquire_swapchain_image())
         return;
 
@@ -1049,7 +1225,10 @@ void VKState::render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &v
 }
 
 void VKState::swap_window(SDL_Window *window) {
-    screen_renderer.swap_window();
+    if (!headless) {
+        const frame_timings::Scope timing(frame_timings::Stage::PresentWait);
+        screen_renderer.swap_window();
+    }
 
     // look once a frame if we need to save the pipeline cache
     const auto time_s = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
@@ -1080,6 +1259,7 @@ uint32_t VKState::get_features_mask() {
             bool use_memory_mapping : 1;
             bool use_rgb_attributes : 1;
             bool use_scaled_attributes : 1;
+            bool use_spirv_optimizer : 1;
         };
         uint32_t value;
     } features_mask;
@@ -1091,6 +1271,7 @@ uint32_t VKState::get_features_mask() {
     features_mask.use_memory_mapping = features.enable_memory_mapping;
     features_mask.use_rgb_attributes = features.support_rgb_attributes;
     features_mask.use_scaled_attributes = pipeline_cache.support_scaled_vertex_attribute;
+    features_mask.use_spirv_optimizer = features.optimize_spirv;
 
     return features_mask.value;
 }
@@ -1115,7 +1296,6 @@ bool VKState::map_memory(MemState &mem, Ptr<void> address, uint32_t size) {
     assert(features.enable_memory_mapping);
     // the address should be 4K aligned
     assert((address.address() & 4095) == 0);
-    constexpr vk::BufferUsageFlags mapped_memory_flags = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferDst;
 
     auto find_mem_type_with_flag = [&](const vk::MemoryPropertyFlags flags, uint32_t hardware_types) {
         while (hardware_types != 0) {
@@ -1146,9 +1326,37 @@ bool VKState::map_memory(MemState &mem, Ptr<void> address, uint32_t size) {
         return static_cast<uint32_t>(mapped_memory_type);
     };
 
+    auto map_page_table = [&]() {
+        // make sure the mapped address is 4K aligned
+        vkutil::Buffer buffer = create_page_table_buffer(size, move_mapped_memory);
+        const uint64_t buffer_ptr_val = std::bit_cast<uint64_t>(buffer.mapped_data);
+        const uint64_t buffer_offset = align(buffer_ptr_val, KiB(4)) - buffer_ptr_val;
+        buffer.mapped_data = std::bit_cast<void *>(buffer_ptr_val + buffer_offset);
+
+        vk::BufferDeviceAddressInfoKHR address_info{
+            .buffer = buffer.buffer
+        };
+        const uint64_t buffer_address = device.getBufferAddress(address_info) + buffer_offset;
+        const vk::Buffer mapped_buffer = buffer.buffer;
+
+        add_external_mapping(mem, address.address(), size, static_cast<uint8_t *>(buffer.mapped_data));
+        mapped_memories[address.address()] = { address.address(), std::move(buffer), mapped_buffer, size, buffer_address };
+    };
+
     switch (mapping_method) {
     case MappingMethod::NativeBuffer: {
 #ifdef __ANDROID__
+        // a range the driver cannot give a hardware buffer for is mapped like with the page table method instead,
+        // the guest memory is redirected to a host visible buffer in both cases so the rest of the renderer does not differ
+        auto fall_back = [&](AHardwareBuffer *buffer, bool locked) {
+            if (locked)
+                _AHardwareBuffer_unlock(buffer, nullptr);
+            if (buffer)
+                _AHardwareBuffer_release(buffer);
+            LOG_WARN("Mapping 0x{:X} ({} KiB) with a page table buffer instead", address.address(), size / KiB(1));
+            map_page_table();
+        };
+
         // if we get there, this means we support the hardware buffer extension
         AHardwareBuffer_Desc buffer_desc{
             .width = static_cast<uint32_t>(size + KiB(4)),
@@ -1157,56 +1365,65 @@ bool VKState::map_memory(MemState &mem, Ptr<void> address, uint32_t size) {
             .format = AHARDWAREBUFFER_FORMAT_BLOB,
             .usage = AHARDWAREBUFFER_USAGE_GPU_DATA_BUFFER | AHARDWAREBUFFER_USAGE_CPU_READ_MASK | AHARDWAREBUFFER_USAGE_CPU_WRITE_MASK,
         };
-        AHardwareBuffer *buffer;
+        AHardwareBuffer *buffer = nullptr;
         int err = _AHardwareBuffer_allocate(&buffer_desc, &buffer);
         if (err != 0) {
             LOG_ERROR("Failed to allocate Android hardware buffer, error {}", err);
-            return false;
+            fall_back(nullptr, false);
+            break;
         }
         void *mapped_location;
         err = _AHardwareBuffer_lock(buffer, AHARDWAREBUFFER_USAGE_CPU_READ_MASK | AHARDWAREBUFFER_USAGE_CPU_WRITE_MASK, -1, nullptr, &mapped_location);
         if (err != 0) {
             LOG_ERROR("Failed to lock Android hardware buffer, error {}", err);
-            return false;
+            fall_back(buffer, false);
+            break;
         }
 
         vk::DeviceMemory device_memory;
-        // prefer this extension
-        if (support_android_buffer_import) {
-            const vk::AndroidHardwareBufferPropertiesANDROID hardware_props = device.getAndroidHardwareBufferPropertiesANDROID(*buffer);
-
-            uint32_t mapped_memory_type = find_suitable_mapped_type(hardware_props.memoryTypeBits);
-            vk::StructureChain<vk::MemoryAllocateInfo, vk::ImportAndroidHardwareBufferInfoANDROID, vk::MemoryAllocateFlagsInfo> alloc_info{
-                vk::MemoryAllocateInfo{
-                    .allocationSize = size + KiB(4),
-                    .memoryTypeIndex = mapped_memory_type },
-                vk::ImportAndroidHardwareBufferInfoANDROID{
-                    .buffer = buffer },
-                vk::MemoryAllocateFlagsInfo{
-                    .flags = vk::MemoryAllocateFlagBits::eDeviceAddress }
-            };
-            device_memory = device.allocateMemory(alloc_info.get());
-        } else {
-            const native_handle_t *handle = _AHardwareBuffer_getNativeHandle(buffer);
-            if (handle == nullptr || handle->numFds == 0 || handle->data[0] == -1) {
-                LOG_ERROR("Failed to get native handle");
-                return false;
-            }
+        try {
+            // prefer this extension
+            if (support_android_buffer_import) {
+                const vk::AndroidHardwareBufferPropertiesANDROID hardware_props = device.getAndroidHardwareBufferPropertiesANDROID(*buffer);
+
+                uint32_t mapped_memory_type = find_suitable_mapped_type(hardware_props.memoryTypeBits);
+                vk::StructureChain<vk::MemoryAllocateInfo, vk::ImportAndroidHardwareBufferInfoANDROID, vk::MemoryAllocateFlagsInfo> alloc_info{
+                    vk::MemoryAllocateInfo{
+                        .allocationSize = size + KiB(4),
+                        .memoryTypeIndex = mapped_memory_type },
+                    vk::ImportAndroidHardwareBufferInfoANDROID{
+                        .buffer = buffer },
+                    vk::MemoryAllocateFlagsInfo{
+                        .flags = vk::MemoryAllocateFlagBits::eDeviceAddress }
+                };
+                device_memory = device.allocateMemory(alloc_info.get());
+            } else {
+                const native_handle_t *handle = _AHardwareBuffer_getNativeHandle(buffer);
+                if (handle == nullptr || handle->numFds == 0 || handle->data[0] == -1) {
+                    LOG_ERROR("Failed to get native handle");
+                    fall_back(buffer, true);
+                    break;
+                }
 
-            int fd = handle->data[0];
-            const vk::MemoryFdPropertiesKHR fd_props = device.getMemoryFdPropertiesKHR(vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd, fd);
-            uint32_t mapped_memory_type = find_suitable_mapped_type(fd_props.memoryTypeBits);
-            vk::StructureChain<vk::MemoryAllocateInfo, vk::ImportMemoryFdInfoKHR, vk::MemoryAllocateFlagsInfo> alloc_info{
-                vk::MemoryAllocateInfo{
-                    .allocationSize = size + KiB(4),
-                    .memoryTypeIndex = mapped_memory_type },
-                vk::ImportMemoryFdInfoKHR{
-                    .handleType = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd,
-                    .fd = fd },
-                vk::MemoryAllocateFlagsInfo{
-                    .flags = vk::MemoryAllocateFlagBits::eDeviceAddress }
-            };
-            device_memory = device.allocateMemory(alloc_info.get());
+                int fd = handle->data[0];
+                const vk::MemoryFdPropertiesKHR fd_props = device.getMemoryFdPropertiesKHR(vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd, fd);
+                uint32_t mapped_memory_type = find_suitable_mapped_type(fd_props.memoryTypeBits);
+                vk::StructureChain<vk::MemoryAllocateInfo, vk::ImportMemoryFdInfoKHR, vk::MemoryAllocateFlagsInfo> alloc_info{
+                    vk::MemoryAllocateInfo{
+                        .allocationSize = size + KiB(4),
+                        .memoryTypeIndex = mapped_memory_type },
+                    vk::ImportMemoryFdInfoKHR{
+                        .handleType = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd,
+                        .fd = fd },
+                    vk::MemoryAllocateFlagsInfo{
+                        .flags = vk::MemoryAllocateFlagBits::eDeviceAddress }
+                };
+                device_memory = device.allocateMemory(alloc_info.get());
+            }
+        } catch (vk::SystemError &e) {
+            LOG_ERROR("Failed to import Android hardware buffer: {}", e.what());
+            fall_back(buffer, true);
+            break;
         }
 
         vk::StructureChain<vk::BufferCreateInfo, vk::ExternalMemoryBufferCreateInfoKHR> buffer_info{
@@ -1232,31 +1449,9 @@ bool VKState::map_memory(MemState &mem, Ptr<void> address, uint32_t size) {
 #endif
         break;
     }
-    case MappingMethod::PageTable: {
-        // add 4 KiB because we can as an easy way to prevent crashes due to memory accesses right after the memory boundary
-        // also make sure later the mapped address is 4K aligned
-        vkutil::Buffer buffer(size + KiB(4));
-        constexpr vma::AllocationCreateInfo memory_mapped_alloc = {
-            .flags = vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessSequentialWrite,
-            .usage = vma::MemoryUsage::eAutoPreferHost,
-            .requiredFlags = vk::MemoryPropertyFlagBits::eHostCoherent,
-            .preferredFlags = vk::MemoryPropertyFlagBits::eHostCached,
-        };
-        buffer.init_buffer(mapped_memory_flags, memory_mapped_alloc);
-        const uint64_t buffer_ptr_val = std::bit_cast<uint64_t>(buffer.mapped_data);
-        const uint64_t buffer_offset = align(buffer_ptr_val, KiB(4)) - buffer_ptr_val;
-        buffer.mapped_data = std::bit_cast<void *>(buffer_ptr_val + buffer_offset);
-
-        vk::BufferDeviceAddressInfoKHR address_info{
-            .buffer = buffer.buffer
-        };
-        const uint64_t buffer_address = device.getBufferAddress(address_info) + buffer_offset;
-        const vk::Buffer mapped_buffer = buffer.buffer;
-
-        add_external_mapping(mem, address.address(), size, static_cast<uint8_t *>(buffer.mapped_data));
-        mapped_memories[address.address()] = { address.address(), std::move(buffer), mapped_buffer, size, buffer_address };
+    case MappingMethod::PageTable:
+        map_page_table();
         break;
-    }
 
     case MappingMethod::ExernalHost: {
         void *host_address = address.get(mem);
@@ -1369,6 +1564,10 @@ void VKState::unmap_memory(MemState &mem, Ptr<void> address) {
 #ifdef __ANDROID__
     case MappingMethod::NativeBuffer: {
         remove_external_mapping(mem, address.cast<uint8_t>().get(mem), ite->second.size);
+        // the ranges which fell back to a page table buffer free it with the mapping
+        if (!std::holds_alternative<ExternalBuffer>(ite->second.buffer_impl))
+            break;
+
         device.destroyBuffer(ite->second.buffer);
         ExternalBuffer &buffer = std::get<ExternalBuffer>(ite->second.buffer_impl);
         device.freeMemory(buffer.memory);
@@ -1485,6 +1684,15 @@ void VKState::precompile_shader(const ShadersHash &hash) {
     LOG_INFO("Program Compiled {}/{}", programs_count_pre_compiled, shaders_cache_hashs.size());
 }
 
+uint32_t VKState::get_pipelines_to_preload_count() {
+    return static_cast<uint32_t>(pipeline_cache.get_pipelines_to_preload_count());
+}
+
+bool VKState::preload_pipelines() {
+    // stop regularly so that the progress can be displayed
+    return pipeline_cache.preload_pipelines(std::chrono::milliseconds(30));
+}
+
 void VKState::preclose_action() {
     // Stop the GPU request wait thread before destruction begins.
     // VKState (owns the queue) is destroyed before VKContext (owns the thread).
@@ -1520,6 +1728,11 @@ void VKState::set_turbo_mode(bool set) {
 BufferTrapping::BufferTrapping(VKState &state)
     : state(state) {}
 
+void BufferTrapping::copy_to_mapped(const TrappedBuffer &buffer, Address buffer_addr, Address addr, uint32_t size, MemState &mem) {
+    memcpy(buffer.mapped_location + (addr - buffer_addr), Ptr<void>(addr).get(mem), size);
+    frame_bytes_copied += size;
+}
+
 TrappedBuffer *BufferTrapping::access_buffer(Address addr, uint32_t size, MemState &mem, bool always_trap, bool cover_everything) {
     const bool is_buffer_small = (size < 3 * KiB(4));
 
@@ -1539,18 +1752,60 @@ TrappedBuffer *BufferTrapping::access_buffer(Address addr, uint32_t size, MemSta
         temp_buffer.mapped_location += addr - mem_it->first;
         temp_buffer.extra = ~0;
 
-        memcpy(temp_buffer.mapped_location, Ptr<void>(addr).get(mem), size);
+        copy_to_mapped(temp_buffer, addr, addr, size, mem);
         return &temp_buffer;
     }
 
+    Address aligned_addr;
+    uint32_t aligned_size;
+    if (cover_everything) {
+        aligned_addr = align_down(addr, KiB(4));
+        aligned_size = align(addr + size, KiB(4)) - aligned_addr;
+    } else {
+        aligned_addr = align(addr, KiB(4));
+        aligned_size = align_down(addr + size - aligned_addr, KiB(4));
+    }
+
     auto it = trapped_buffers.find(addr);
     bool is_new = false;
     if (it != trapped_buffers.end()) {
         // must check if everything match
         TrappedBuffer &buffer = it->second;
-        if (!buffer.dirty && buffer.size >= size)
+        if (!was_written_since(mem, buffer.tracked_addr, buffer.tracked_size, buffer.write_sequence) && buffer.size >= size)
             // nothing to change
             return &it->second;
+
+        if (buffer.size == size && buffer.tracked_addr == aligned_addr && buffer.tracked_size == aligned_size) {
+            // same range as the last copy, only the pages written since then and the untracked ends are copied again
+            // the pages are tracked again before being checked, a write done during the copy is seen by the next access
+            const uint32_t previous_sequence = buffer.write_sequence;
+            buffer.write_sequence = track_writes(mem, aligned_addr, aligned_size);
+            buffer.extra = ~0;
+
+            if (aligned_addr > addr)
+                copy_to_mapped(buffer, addr, addr, std::min(aligned_addr, addr + size) - addr, mem);
+            // consecutive written pages are copied at once
+            Address run_start = 0;
+            uint32_t run_size = 0;
+            for (Address page_addr = aligned_addr; page_addr < aligned_addr + aligned_size; page_addr += KiB(4)) {
+                if (was_written_since(mem, page_addr, KiB(4), previous_sequence)) {
+                    if (run_size == 0)
+                        run_start = page_addr;
+                    run_size += KiB(4);
+                } else if (run_size > 0) {
+                    copy_to_mapped(buffer, addr, std::max(run_start, addr), std::min(run_start + run_size, addr + size) - std::max(run_start, addr), mem);
+                    run_size = 0;
+                }
+            }
+            if (run_size > 0)
+                copy_to_mapped(buffer, addr, std::max(run_start, addr), std::min(run_start + run_size, addr + size) - std::max(run_start, addr), mem);
+            if (aligned_addr + aligned_size < addr + size) {
+                const Address tail_start = std::max(aligned_addr + aligned_size, addr);
+                copy_to_mapped(buffer, addr, tail_start, addr + size - tail_start, mem);
+            }
+
+            return &it->second;
+        }
     } else {
         it = trapped_buffers.emplace(std::piecewise_construct, std::forward_as_tuple(addr), std::forward_as_tuple()).first;
         is_new = true;
@@ -1561,14 +1816,14 @@ TrappedBuffer *BufferTrapping::access_buffer(Address addr, uint32_t size, MemSta
         auto next_it = it;
         next_it++;
         while (next_it != trapped_buffers.end() && next_it->first < addr + size) {
-            if (next_it->second.dirty)
+            const TrappedBuffer &next_buffer = next_it->second;
+            if (was_written_since(mem, next_buffer.tracked_addr, next_buffer.tracked_size, next_buffer.write_sequence))
                 next_it = trapped_buffers.erase(next_it);
             else
                 next_it++;
         }
     }
     it->second.size = size;
-    it->second.dirty = false;
     it->second.extra = ~0;
 
     if (is_new) {
@@ -1583,22 +1838,12 @@ TrappedBuffer *BufferTrapping::access_buffer(Address addr, uint32_t size, MemSta
         it->second.mapped_location += addr - mem_it->first;
     }
 
-    Address aligned_addr;
-    uint32_t aligned_size;
-    if (cover_everything) {
-        aligned_addr = align_down(addr, KiB(4));
-        aligned_size = align(addr + size, KiB(4)) - aligned_addr;
-    } else {
-        aligned_addr = align(addr, KiB(4));
-        aligned_size = align_down(addr + size - aligned_addr, KiB(4));
-    }
-    add_protect(mem, aligned_addr, aligned_size, MemPerm::ReadOnly, [it](Address addr, bool write) {
-        it->second.dirty = true;
-        return true;
-    });
+    it->second.tracked_addr = aligned_addr;
+    it->second.tracked_size = aligned_size;
+    it->second.write_sequence = track_writes(mem, aligned_addr, aligned_size);
 
     // copy back the data as it was non-existent or dirty
-    memcpy(it->second.mapped_location, Ptr<void>(addr).get(mem), size);
+    copy_to_mapped(it->second, addr, addr, size, mem);
 
     return &it->second;
 }
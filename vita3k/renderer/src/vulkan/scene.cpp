@@ -18,6 +18,7 @@
 #include <renderer/vulkan/functions.h>
 
 #include <gxm/functions.h>
+#include <renderer/profile.h>
 #include <renderer/vulkan/gxm_to_vulkan.h>
 
 #include <config/state.h>
@@ -70,6 +71,8 @@ void set_uniform_buffer(VKContext &context, MemState &mem, const ShaderProgram *
 }
 
 void mid_scene_flush(VKContext &context, const SceGxmNotification notification) {
+    R_PROFILE(__func__);
+
     // two cases :
     // notification.addr is 0: this means that the mid scene flush must be used as a barrier in the renderpass
     // notification.addr is not 0: this means the app is waiting for this part to be finished to re-use the resources
@@ -93,8 +96,26 @@ void mid_scene_flush(VKContext &context, const SceGxmNotification notification)
 
     if (restart_render_pass) {
         SceGxmNotification empty_notification = { Ptr<uint32_t>(0), 0 };
-        const bool submit = notification.address.address() != 0;
-        context.stop_recording(notification, empty_notification, submit);
+        vk::Event notification_event = nullptr;
+        if (notification.address.address() != 0) {
+            // the app waits for this part of the scene to re-use its resources, so it must be sent right away
+            // an event set at its end tells the wait thread when it is done: the scene keeps a single fence
+            // and its surface is only synced at the end
+            FrameObject &frame = context.state.frame();
+            if (frame.notification_events_used == frame.notification_events.size())
+                frame.notification_events.push_back(context.state.device.createEvent({}));
+            notification_event = frame.notification_events[frame.notification_events_used++];
+            context.render_cmd.setEvent(notification_event, vk::PipelineStageFlagBits::eAllCommands);
+        }
+
+        context.stop_recording(empty_notification, empty_notification, false);
+        if (notification_event) {
+            // stop_recording already sends the parts of a split scene
+            if (!context.cmdbuffers_to_submit.empty())
+                context.submit_command_buffers();
+            context.state.request_queue.push(EventNotificationRequest{ notification_event, notification });
+        }
+
         context.start_recording();
         context.scene_timestamp++;
     }
@@ -103,17 +124,18 @@ void mid_scene_flush(VKContext &context, const SceGxmNotification notification)
 #ifdef __APPLE__
 // restride vertex attribute binding strides to multiple of 4
 // needed for metal because it only allows multiples of 4.
-void restride_stream(const uint8_t *&stream, uint32_t &size, uint32_t stride) {
+// the vertices are written directly to the ring buffer, without any temporary copy
+static void restride_stream(VKContext &context, const uint8_t *stream, uint32_t size, uint32_t stride) {
     const uint32_t new_stride = align(stride, 4);
     const uint32_t nb_vertex_input = ((size + stride - 1) / stride);
-
-    uint8_t *new_data = new uint8_t[nb_vertex_input * new_stride];
-    for (uint32_t i = 0; i < nb_vertex_input; i++) {
-        memcpy(new_data + new_stride * i, stream + stride * i, stride);
-    }
-
-    stream = new_data;
-    size = nb_vertex_input * new_stride;
+    // the last vertex may not be complete, only copy what is part of the stream for it
+    const uint32_t nb_full_vertex = size / stride;
+    const uint32_t last_vertex_size = size - nb_full_vertex * stride;
+
+    context.vertex_stream_ring_buffer.allocate(nb_vertex_input * new_stride);
+    context.vertex_stream_ring_buffer.copy_strided(nb_full_vertex, stream, stride, new_stride);
+    if (last_vertex_size > 0)
+        context.vertex_stream_ring_buffer.copy(context.prerender_cmd, last_vertex_size, stream + nb_full_vertex * stride, nb_full_vertex * new_stride);
 }
 #endif
 
@@ -125,6 +147,7 @@ static vk::DescriptorSet retrieve_descriptor(VKContext &context, bool is_vertex,
         return context.empty_set;
 
     VKState &state = context.state;
+    state.frame_descriptor_sets_allocated++;
     FrameDescriptor &frame_descriptor = is_vertex ? state.frame().vert_descriptors[textures_count - 1] : state.frame().frag_descriptors[textures_count - 1];
     if (frame_descriptor.descriptors_idx < frame_descriptor.sets.size())
         return frame_descriptor.sets[frame_descriptor.descriptors_idx++];
@@ -166,6 +189,8 @@ static vk::DescriptorSet retrieve_descriptor(VKContext &context, bool is_vertex,
 }
 
 static void draw_bind_descriptors(VKContext &context, MemState &mem) {
+    R_PROFILE(__func__);
+
     VKState &state = context.state;
 
     std::array<vk::DescriptorSet, 4> descriptors;
@@ -177,9 +202,14 @@ static void draw_bind_descriptors(VKContext &context, MemState &mem) {
 
     vk::PipelineLayout pipeline_layout = state.pipeline_cache.pipeline_layouts[vertex_textures_count][fragment_texture_count];
 
+    // with push descriptors, the fragment textures are pushed for each draw instead of using set 3
+    const bool push_frag_descr = state.support_push_descriptor && fragment_texture_count > 0;
+
     // try to use last descriptor if it still matches
     bool need_vert_descr = (vertex_textures_count != context.last_vert_texture_count);
-    bool need_frag_descr = (fragment_texture_count != context.last_frag_texture_count);
+    bool need_frag_descr = (fragment_texture_count != context.last_frag_texture_count) && !push_frag_descr;
+    // the pushed textures stay bound as long as they don't change and the vertex set is bound with the same layout
+    const bool need_frag_push = push_frag_descr && (!context.frag_textures_pushed || need_vert_descr || fragment_texture_count != context.last_frag_texture_count);
 
     context.last_vert_texture_count = vertex_textures_count;
     context.last_frag_texture_count = fragment_texture_count;
@@ -193,7 +223,7 @@ static void draw_bind_descriptors(VKContext &context, MemState &mem) {
         if (need_frag_descr) {
             context.last_frag_texture_descriptor = retrieve_descriptor(context, false, fragment_texture_count);
         }
-        descriptors[3] = context.last_frag_texture_descriptor;
+        descriptors[3] = push_frag_descr ? nullptr : context.last_frag_texture_descriptor;
     }
 
     // bind textures
@@ -220,7 +250,7 @@ static void draw_bind_descriptors(VKContext &context, MemState &mem) {
     }
 
     // fragment
-    if (need_frag_descr) {
+    if (need_frag_descr || need_frag_push) {
         for (uint32_t i = 0; i < fragment_texture_count; i++) {
             write_descrs[i] = vk::WriteDescriptorSet{
                 .dstSet = descriptors[3],
@@ -230,7 +260,10 @@ static void draw_bind_descriptors(VKContext &context, MemState &mem) {
             };
             write_descrs[i].setImageInfo(context.fragment_textures[i].sampler ? context.fragment_textures[i] : default_image_info);
         }
-        state.device.updateDescriptorSets(fragment_texture_count, write_descrs.data(), 0, nullptr);
+
+        // the pushed writes are recorded after the other sets are bound
+        if (!push_frag_descr)
+            state.device.updateDescriptorSets(fragment_texture_count, write_descrs.data(), 0, nullptr);
     }
 
     const uint32_t dynamic_offset_count = state.features.enable_memory_mapping ? 2U : 4U;
@@ -245,12 +278,23 @@ static void draw_bind_descriptors(VKContext &context, MemState &mem) {
         context.fragment_uniform_stream_ring_buffer.data_offset
     };
 
+    // the pushed set must not be bound
+    const uint32_t bound_sets = push_frag_descr ? 3 : descriptors.size();
     context.render_cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, 0,
-        descriptors.size(), descriptors.data(), dynamic_offset_count, dynamic_offsets);
+        bound_sets, descriptors.data(), dynamic_offset_count, dynamic_offsets);
+
+    if (need_frag_push) {
+        context.render_cmd.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, pipeline_layout, 3, fragment_texture_count, write_descrs.data());
+        state.frame_descriptor_sets_pushed++;
+    }
+    // binding all the sets replaces the pushed one
+    context.frag_textures_pushed = push_frag_descr;
 }
 
 // vertex count is only used with double buffer mapping
 static void bind_vertex_streams(VKContext &context, MemState &mem, uint32_t instance_count, uint32_t max_index) {
+    R_PROFILE(__func__);
+
     GxmRecordState &state = context.record;
     const SceGxmVertexProgram &vertex_program = *state.vertex_program.get(mem);
     VertexProgram *vkvert = vertex_program.renderer_data.get();
@@ -298,22 +342,15 @@ static void bind_vertex_streams(VKContext &context, MemState &mem, uint32_t inst
                 context.vertex_stream_buffers[i] = buffer;
             } else {
                 const uint8_t *stream = state.vertex_streams[i].data.get(mem);
-                uint32_t stream_size = state.vertex_streams[i].size;
+                const uint32_t stream_size = state.vertex_streams[i].size;
 #ifdef __APPLE__
                 // Vulkan allows any stride, but Metal only allows multiples of 4.
-                const bool restride = vertex_program.streams[i].stride % 4 != 0;
-                if (restride) {
-                    restride_stream(stream, stream_size, vertex_program.streams[i].stride);
-                }
+                if (vertex_program.streams[i].stride % 4 != 0)
+                    restride_stream(context, stream, stream_size, vertex_program.streams[i].stride);
+                else
 #endif
-                context.vertex_stream_ring_buffer.allocate(context.prerender_cmd, stream_size, stream);
+                    context.vertex_stream_ring_buffer.allocate(context.prerender_cmd, stream_size, stream);
                 context.vertex_stream_offsets[i] = context.vertex_stream_ring_buffer.data_offset;
-
-#ifdef __APPLE__
-                if (restride) {
-                    delete[] stream;
-                }
-#endif
             }
 
             state.vertex_streams[i].data = nullptr;
@@ -326,16 +363,28 @@ static void bind_vertex_streams(VKContext &context, MemState &mem, uint32_t inst
 
 void draw(VKContext &context, SceGxmPrimitiveType type, SceGxmIndexFormat format,
     Ptr<void> indices, size_t count, uint32_t instance_count, MemState &mem, const Config &config) {
+    R_PROFILE(__func__);
+
     void *indices_ptr = indices.get(mem);
 
     context.check_for_macroblock_change(true);
 
+    // split long scenes, this is not done while a visibility buffer is used as the queries would be reset
+    if (context.state.scene_chunk_draws > 0 && context.in_renderpass && context.draws_in_recording >= context.state.scene_chunk_draws
+        && context.visibility_max_used_idx == -1) {
+        SceGxmNotification empty_notification{};
+        context.stop_recording(empty_notification, empty_notification, false);
+        // this is still the same scene for the texture and surface caches
+        context.start_recording();
+    }
+
     if (!context.in_renderpass)
         context.start_render_pass();
+    context.draws_in_recording++;
 
-    // when we do multiple render pass for one scene (shader interlock or slow macroblock),
+    // when we do multiple render pass for one scene (shader interlock, slow macroblock or split scene),
     // we need to always load the depth-stencil after the first draw
-    if (context.is_first_scene_draw && (context.state.features.support_shader_interlock || context.ignore_macroblock)) {
+    if (context.is_first_scene_draw && (context.state.features.support_shader_interlock || context.ignore_macroblock || context.state.scene_chunk_draws > 0)) {
         // update the render pass to load and store the depth and stencil
         context.current_render_pass = context.state.pipeline_cache.retrieve_render_pass(context.current_color_format, true, true, !context.record.color_surface.data);
         context.is_first_scene_draw = false;
@@ -343,20 +392,27 @@ void draw(VKContext &context, SceGxmPrimitiveType type, SceGxmIndexFormat format
 
     const SceGxmFragmentProgram &gxm_fragment_program = *context.record.fragment_program.get(mem);
     const SceGxmProgram &fragment_program_gxp = *gxm_fragment_program.program.get(mem);
+    if (fragment_program_gxp.is_frag_color_used())
+        context.state.frame_color_read_draws++;
+
     if (context.state.features.direct_fragcolor && fragment_program_gxp.is_frag_color_used()) {
         // the fragment shader is using programmable blending with a subpass input
-        vk::ImageMemoryBarrier barrier{
-            .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
-            .dstAccessMask = vk::AccessFlagBits::eInputAttachmentRead,
-            .oldLayout = vk::ImageLayout::eGeneral,
-            .newLayout = vk::ImageLayout::eGeneral,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .image = context.current_color_base_image->image,
-            .subresourceRange = vkutil::color_subresource_range
-        };
-        context.render_cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eFragmentShader,
-            vk::DependencyFlagBits::eByRegion, {}, {}, barrier);
+        // with rasterization order attachment access, the reads already see the writes of the previous draws
+        if (!context.state.pipeline_cache.support_coherent_framebuffer_fetch) {
+            vk::ImageMemoryBarrier barrier{
+                .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
+                .dstAccessMask = vk::AccessFlagBits::eInputAttachmentRead,
+                .oldLayout = vk::ImageLayout::eGeneral,
+                .newLayout = vk::ImageLayout::eGeneral,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = context.current_color_base_image->image,
+                .subresourceRange = vkutil::color_subresource_range
+            };
+            context.render_cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eFragmentShader,
+                vk::DependencyFlagBits::eByRegion, {}, {}, barrier);
+            context.state.frame_color_read_barriers++;
+        }
     } else if (context.state.features.support_shader_interlock
         && fragment_program_gxp.is_frag_color_used() != context.last_draw_was_framebuffer_fetch) {
         // restart the render pass to act as a barrier
@@ -372,6 +428,7 @@ void draw(VKContext &context, SceGxmPrimitiveType type, SceGxmIndexFormat format
 
         context.render_cmd.beginRenderPass(context.curr_renderpass_info, vk::SubpassContents::eInline);
         context.last_draw_was_framebuffer_fetch = fragment_program_gxp.is_frag_color_used();
+        context.state.frame_color_read_barriers++;
     }
 
     if (context.current_visibility_buffer != nullptr && context.current_query_idx != -1 && !context.is_in_query) {
@@ -404,6 +461,9 @@ void draw(VKContext &context, SceGxmPrimitiveType type, SceGxmIndexFormat format
             if (new_pipeline != nullptr)
                 context.render_cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, context.current_pipeline);
         }
+
+        // the states which are no longer part of the pipeline are only refreshed along with it
+        sync_extended_dynamic_state(context);
     }
 
     // can happen with asynchronous pipeline compilation
@@ -445,9 +505,10 @@ void draw(VKContext &context, SceGxmPrimitiveType type, SceGxmIndexFormat format
     vert_ublock.screen_height = context.render_target->height / context.state.res_multiplier;
 
     if (context.curr_vert_ublock.changed || memcmp(&context.prev_vert_ublock, &vert_ublock, sizeof(vert_ublock)) != 0) {
-        // TODO: this intermediate step can be avoided
-        context.curr_vert_ublock.copy_to(context.shader_info_temp);
-        context.vertex_info_uniform_buffer.allocate(context.prerender_cmd, context.curr_vert_ublock.get_size(), context.shader_info_temp);
+        // the block is written directly in the persistently mapped ring buffer
+        const uint32_t block_size = context.curr_vert_ublock.get_size();
+        context.curr_vert_ublock.copy_to(context.vertex_info_uniform_buffer.allocate_mapped(block_size));
+        context.vertex_info_uniform_buffer.flush(block_size);
         memcpy(&context.prev_vert_ublock, &vert_ublock, sizeof(vert_ublock));
     }
 
@@ -462,9 +523,10 @@ void draw(VKContext &context, SceGxmPrimitiveType type, SceGxmIndexFormat format
         frag_ublock.res_multiplier /= 2;
 
     if (context.curr_frag_ublock.changed || memcmp(&context.prev_frag_ublock, &frag_ublock, sizeof(frag_ublock)) != 0) {
-        // TODO: this intermediate step can be avoided
-        context.curr_frag_ublock.copy_to(context.shader_info_temp);
-        context.fragment_info_uniform_buffer.allocate(context.prerender_cmd, context.curr_frag_ublock.get_size(), context.shader_info_temp);
+        // the block is written directly in the persistently mapped ring buffer
+        const uint32_t block_size = context.curr_frag_ublock.get_size();
+        context.curr_frag_ublock.copy_to(context.fragment_info_uniform_buffer.allocate_mapped(block_size));
+        context.fragment_info_uniform_buffer.flush(block_size);
         memcpy(&context.prev_frag_ublock, &frag_ublock, sizeof(frag_ublock));
     }
 
@@ -482,13 +544,7 @@ void draw(VKContext &context, SceGxmPrimitiveType type, SceGxmIndexFormat format
             TrappedBuffer *trapped_buffer = context.state.buffer_trapping.access_buffer(indices.address(), count * index_size, mem);
             if (trapped_buffer->extra == ~0) {
                 // store the max element in extra
-                if (format == SCE_GXM_INDEX_FORMAT_U16) {
-                    uint16_t *data = indices.cast<uint16_t>().get(mem);
-                    trapped_buffer->extra = *std::max_element(&data[0], &data[count]);
-                } else {
-                    uint32_t *data = indices.cast<uint32_t>().get(mem);
-                    trapped_buffer->extra = *std::max_element(&data[0], &data[count]);
-                }
+                trapped_buffer->extra = gxm::get_max_index(indices_ptr, count, format);
             }
             max_index = trapped_buffer->extra;
         }
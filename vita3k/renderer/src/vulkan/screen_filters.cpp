@@ -444,16 +444,16 @@ void FSRScreenFilter::init() {
     std::array<vk::DescriptorPoolSize, 3> pool_sizes{
         vk::DescriptorPoolSize{
             .type = vk::DescriptorType::eSampledImage,
-            .descriptorCount = screen.swapchain_size * 2 },
+            .descriptorCount = screen.swapchain_size * 3 },
         vk::DescriptorPoolSize{
             .type = vk::DescriptorType::eStorageImage,
-            .descriptorCount = screen.swapchain_size * 2 },
+            .descriptorCount = screen.swapchain_size * 3 },
         vk::DescriptorPoolSize{
             .type = vk::DescriptorType::eSampler,
-            .descriptorCount = screen.swapchain_size * 2 },
+            .descriptorCount = screen.swapchain_size * 3 },
     };
     vk::DescriptorPoolCreateInfo pool_info{
-        .maxSets = screen.swapchain_size * 2,
+        .maxSets = screen.swapchain_size * 3,
     };
     pool_info.setPoolSizes(pool_sizes);
     descriptor_pool = device.createDescriptorPool(pool_info);
@@ -464,6 +464,9 @@ void FSRScreenFilter::init() {
     std::vector<vk::DescriptorSetLayout> descr_set_layouts(screen.swapchain_size * 2, descriptor_set_layout);
     descr_set_info.setSetLayouts(descr_set_layouts);
     descriptor_sets = device.allocateDescriptorSets(descr_set_info);
+    descr_set_layouts.resize(screen.swapchain_size);
+    descr_set_info.setSetLayouts(descr_set_layouts);
+    direct_descriptor_sets = device.allocateDescriptorSets(descr_set_info);
 
     vk::PipelineLayoutCreateInfo layout_info{};
     layout_info.setSetLayouts(descriptor_set_layout);
@@ -540,34 +543,42 @@ void FSRScreenFilter::on_resize() {
     }
 
     // update the descriptor sets (except the first sampler image as it is not fixed)
-    std::vector<vk::DescriptorImageInfo> descr_images(screen.swapchain_size * 3);
-    std::vector<vk::WriteDescriptorSet> write_descr(screen.swapchain_size * 3);
+    std::vector<vk::DescriptorImageInfo> descr_images(screen.swapchain_size * 4);
+    std::vector<vk::WriteDescriptorSet> write_descr(screen.swapchain_size * 4);
     for (size_t i = 0; i < write_descr.size(); i++) {
-        descr_images[i].imageView = intermediate_images[i / 3].view;
+        descr_images[i].imageView = intermediate_images[i / 4].view;
         write_descr[i].setImageInfo(descr_images[i]);
     }
 
     for (uint32_t i = 0; i < screen.swapchain_size; i++) {
         // easu dst
-        descr_images[i * 3].imageLayout = vk::ImageLayout::eGeneral;
-        write_descr[i * 3]
+        descr_images[i * 4].imageLayout = vk::ImageLayout::eGeneral;
+        write_descr[i * 4]
             .setDstSet(descriptor_sets[i * 2])
             .setDstBinding(2)
             .setDescriptorType(vk::DescriptorType::eStorageImage);
         // rcas src
-        descr_images[i * 3 + 1].imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-        write_descr[i * 3 + 1]
+        descr_images[i * 4 + 1].imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+        write_descr[i * 4 + 1]
             .setDstSet(descriptor_sets[i * 2 + 1])
             .setDstBinding(1)
             .setDescriptorType(vk::DescriptorType::eSampledImage);
         // rcas dst
-        descr_images[i * 3 + 2]
+        descr_images[i * 4 + 2]
             .setImageView(screen.swapchain_views[i])
             .setImageLayout(vk::ImageLayout::eGeneral);
-        write_descr[i * 3 + 2]
+        write_descr[i * 4 + 2]
             .setDstSet(descriptor_sets[i * 2 + 1])
             .setDstBinding(2)
             .setDescriptorType(vk::DescriptorType::eStorageImage);
+        // direct rcas dst
+        descr_images[i * 4 + 3]
+            .setImageView(screen.swapchain_views[i])
+            .setImageLayout(vk::ImageLayout::eGeneral);
+        write_descr[i * 4 + 3]
+            .setDstSet(direct_descriptor_sets[i])
+            .setDstBinding(2)
+            .setDescriptorType(vk::DescriptorType::eStorageImage);
     }
     screen.state.device.updateDescriptorSets(write_descr, {});
 }
@@ -577,13 +588,18 @@ void FSRScreenFilter::render(bool is_pre_renderpass, vk::ImageView src_img, vk::
         // we are using compute shaders
         return;
 
-    // update descriptor set, (only the easu src)
+    // the upscaling pass does nothing if the source already has the output size, only sharpen it then
+    const bool skip_easu = viewport.offset_x == 0 && viewport.offset_y == 0
+        && viewport.width == output_size.width && viewport.height == output_size.height;
+    const vk::DescriptorSet src_descriptor_set = skip_easu ? direct_descriptor_sets[screen.swapchain_image_idx] : descriptor_sets[2 * screen.swapchain_image_idx];
+
+    // update descriptor set, (only the src of the first pass)
     vk::DescriptorImageInfo descr_image_info{
         .imageView = src_img,
         .imageLayout = src_layout,
     };
     vk::WriteDescriptorSet write_descr{
-        .dstSet = descriptor_sets[2 * screen.swapchain_image_idx],
+        .dstSet = src_descriptor_set,
         .dstBinding = 1,
         .dstArrayElement = 0,
         .descriptorType = vk::DescriptorType::eSampledImage,
@@ -592,22 +608,24 @@ void FSRScreenFilter::render(bool is_pre_renderpass, vk::ImageView src_img, vk::
     screen.state.device.updateDescriptorSets(write_descr, {});
 
     vk::CommandBuffer cmd_buffer = screen.current_cmd_buffer;
-    // first, make a barrier to make sure we can write to the intermediate texture
-    // we don't care about the previous content
-    intermediate_images[screen.swapchain_image_idx].transition_to_discard(cmd_buffer, vkutil::ImageLayout::StorageImage);
-
-    // upscaling pass
-    cmd_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline_easu);
-    cmd_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline_layout_easu, 0, descriptor_sets[2 * screen.swapchain_image_idx], {});
-    // push the viewport to the shader
-    EasuConstant easu_constant{
-        .viewport = viewport,
-        .output_size = output_size
-    };
-    cmd_buffer.pushConstants(pipeline_layout_easu, vk::ShaderStageFlagBits::eCompute, 0, sizeof(EasuConstant), &easu_constant);
     const int dispatch_x = (output_size.width + 15) / 16;
     const int dispatch_y = (output_size.height + 15) / 16;
-    cmd_buffer.dispatch(dispatch_x, dispatch_y, 1);
+    if (!skip_easu) {
+        // first, make a barrier to make sure we can write to the intermediate texture
+        // we don't care about the previous content
+        intermediate_images[screen.swapchain_image_idx].transition_to_discard(cmd_buffer, vkutil::ImageLayout::StorageImage);
+
+        // upscaling pass
+        cmd_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline_easu);
+        cmd_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline_layout_easu, 0, src_descriptor_set, {});
+        // push the viewport to the shader
+        EasuConstant easu_constant{
+            .viewport = viewport,
+            .output_size = output_size
+        };
+        cmd_buffer.pushConstants(pipeline_layout_easu, vk::ShaderStageFlagBits::eCompute, 0, sizeof(EasuConstant), &easu_constant);
+        cmd_buffer.dispatch(dispatch_x, dispatch_y, 1);
+    }
 
     // meanwhile, we need to clear the swapchain surface
     vk::ImageMemoryBarrier barrier{
@@ -627,7 +645,8 @@ void FSRScreenFilter::render(bool is_pre_renderpass, vk::ImageView src_img, vk::
     cmd_buffer.clearColorImage(screen.swapchain_images[screen.swapchain_image_idx], vk::ImageLayout::eTransferDstOptimal, clear_color, vkutil::color_subresource_range);
 
     // then transition the read texture to sampled // wait for the previous compute shader to be done
-    intermediate_images[screen.swapchain_image_idx].transition_to(cmd_buffer, vkutil::ImageLayout::SampledImage);
+    if (!skip_easu)
+        intermediate_images[screen.swapchain_image_idx].transition_to(cmd_buffer, vkutil::ImageLayout::SampledImage);
 
     // also transition the swapchain image to general
     barrier = {
@@ -645,7 +664,8 @@ void FSRScreenFilter::render(bool is_pre_renderpass, vk::ImageView src_img, vk::
 
     // sharpening pass
     cmd_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline_rcas);
-    cmd_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline_layout_rcas, 0, descriptor_sets[2 * screen.swapchain_image_idx + 1], {});
+    const vk::DescriptorSet rcas_descriptor_set = skip_easu ? src_descriptor_set : descriptor_sets[2 * screen.swapchain_image_idx + 1];
+    cmd_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline_layout_rcas, 0, rcas_descriptor_set, {});
     RcasConstant rcas_constant{
         .offset = output_offset,
         // some default value for sharpening
@@ -23,6 +23,10 @@
 #include "util/log.h"
 #include "vkutil/vkutil.h"
 
+#include <algorithm>
+#include <array>
+#include <map>
+
 #ifdef __ANDROID__
 #include <SDL3/SDL.h>
 #include <jni.h>
@@ -62,7 +66,30 @@ bool ScreenRenderer::create(SDL_Window *window) {
     return true;
 }
 
-bool ScreenRenderer::setup() {
+static vk::PresentModeKHR get_auto_present_mode(const std::vector<vk::PresentModeKHR> &present_modes) {
+    // preferred order : mailbox > fifo_relaxed > fifo > whatever
+    // the only drawback for mailbox is that it draws more power, so maybe on a portable device use something else
+    // this one should always be available
+    vk::PresentModeKHR present_mode = vk::PresentModeKHR::eImmediate;
+    for (const auto &mode : present_modes) {
+        if (mode == vk::PresentModeKHR::eMailbox)
+            return mode;
+
+        if (mode == vk::PresentModeKHR::eFifoRelaxed) {
+            present_mode = mode;
+        }
+        if (present_mode == vk::PresentModeKHR::eFifoRelaxed)
+            continue;
+
+        if (mode == vk::PresentModeKHR::eFifo) {
+            present_mode = mode;
+        }
+    }
+
+    return present_mode;
+}
+
+bool ScreenRenderer::setup(std::string_view requested_present_mode) {
     const auto surface_formats = state.physical_device.getSurfaceFormatsKHR(surface);
     bool surface_format_found = false;
 
@@ -98,26 +125,21 @@ bool ScreenRenderer::setup() {
         state.deep_stencil_use = vk::Format::eD16Unorm;
     }
 
-    // preferred order : mailbox > fifo_relaxed > fifo > whatever
-    // the only drawback for mailbox is that it draws more power, so maybe on a portable device use something else
     const auto present_modes = state.physical_device.getSurfacePresentModesKHR(surface);
-    // this one should always be available
-    present_mode = vk::PresentModeKHR::eImmediate;
-    for (const auto &mode : present_modes) {
-        if (mode == vk::PresentModeKHR::eMailbox) {
-            present_mode = mode;
-            break;
-        }
-
-        if (mode == vk::PresentModeKHR::eFifoRelaxed) {
-            present_mode = mode;
-        }
-        if (present_mode == vk::PresentModeKHR::eFifoRelaxed)
-            continue;
-
-        if (mode == vk::PresentModeKHR::eFifo) {
-            present_mode = mode;
-        }
+    present_mode = get_auto_present_mode(present_modes);
+    if (requested_present_mode != "Auto") {
+        static const std::map<std::string_view, vk::PresentModeKHR> present_mode_names = {
+            { "Fifo", vk::PresentModeKHR::eFifo },
+            { "Mailbox", vk::PresentModeKHR::eMailbox },
+            { "Immediate", vk::PresentModeKHR::eImmediate },
+        };
+        const auto it = present_mode_names.find(requested_present_mode);
+        if (it == present_mode_names.end())
+            LOG_WARN("Unknown present mode {}", requested_present_mode);
+        else if (std::find(present_modes.begin(), present_modes.end(), it->second) == present_modes.end())
+            LOG_WARN("Present mode {} is not supported by the surface", requested_present_mode);
+        else
+            present_mode = it->second;
     }
     LOG_INFO("Present mode: {}", vk::to_string(present_mode));
 
@@ -187,6 +209,7 @@ void ScreenRenderer::create_swapchain() {
         };
 
         swapchain = state.device.createSwapchainKHR(swapchain_info);
+        present_id = 0;
     }
 
     // Get Swapchain Images
@@ -268,6 +291,7 @@ void ScreenRenderer::cleanup() {
         state.device.destroy(image_acquired_semaphores[i]);
         state.device.destroy(image_ready_semaphores[i]);
     }
+    state.device.destroy(filter_query_pool);
 
     state.instance.destroy(surface);
 }
@@ -325,6 +349,14 @@ bool ScreenRenderer::acquire_swapchain_image(bool start_render_pass) {
     }
     state.device.resetFences(fences[swapchain_image_idx]);
 
+    if (filter_timed[swapchain_image_idx]) {
+        // the fence has been waited for, the timestamps are available
+        std::array<uint64_t, 2> timestamps;
+        if (state.device.getQueryPoolResults(filter_query_pool, swapchain_image_idx * 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64) == vk::Result::eSuccess)
+            state.screen_filter_gpu_ms = state.gpu_profiler.get_elapsed_ms(timestamps[0], timestamps[1]);
+        filter_timed[swapchain_image_idx] = false;
+    }
+
     // begin the render command
     current_cmd_buffer = command_buffers[swapchain_image_idx];
     current_cmd_buffer.reset();
@@ -358,6 +390,12 @@ void ScreenRenderer::render(vk::ImageView image_view, vk::ImageLayout layout, co
     if (swapchain_image_idx == ~0 && !acquire_swapchain_image())
         return;
 
+    const bool time_filter = state.gpu_profiler.is_profiling();
+    if (time_filter) {
+        current_cmd_buffer.resetQueryPool(filter_query_pool, swapchain_image_idx * 2, 2);
+        current_cmd_buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, filter_query_pool, swapchain_image_idx * 2);
+    }
+
     // we need to apply the screen filter at the right moment (before or after we start the render pass depending on it)
     filter->render(true, image_view, layout, viewport);
 
@@ -377,6 +415,11 @@ void ScreenRenderer::render(vk::ImageView image_view, vk::ImageLayout layout, co
 
     filter->render(false, image_view, layout, viewport);
 
+    if (time_filter) {
+        current_cmd_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, filter_query_pool, swapchain_image_idx * 2 + 1);
+        filter_timed[swapchain_image_idx] = true;
+    }
+
 #ifdef __ANDROID__
     // stock adreno driver bug
     // if there is too much load on the GPU, it just drops any render pass with ImGui graphics in it....
@@ -417,6 +460,14 @@ void ScreenRenderer::swap_window() {
         .pSwapchains = &swapchain,
         .pImageIndices = &swapchain_image_idx,
     };
+    const vk::PresentIdKHR present_id_info{
+        .swapchainCount = 1,
+        .pPresentIds = &present_id
+    };
+    if (state.support_present_wait) {
+        present_id++;
+        present_info.pNext = &present_id_info;
+    }
 
     auto result = state.general_queue.presentKHR(&present_info);
     if (result == vk::Result::eSuboptimalKHR) {
@@ -439,12 +490,46 @@ void ScreenRenderer::swap_window() {
         LOG_ERROR("Could not present KHR.");
         assert(false);
         return;
+    } else {
+        wait_for_previous_present();
     }
 
     swapchain_image_idx = ~0;
     current_cmd_buffer = nullptr;
 }
 
+// do not wait for more than 100ms if the frame never makes it to the screen
+static constexpr uint64_t present_wait_timeout = 100'000'000;
+// number of frames the latency is averaged on
+static constexpr uint32_t latency_sample_count = 30;
+
+void ScreenRenderer::wait_for_previous_present() {
+    // with fifo, the CPU can get a few frames ahead of the screen as long as there are swapchain images left
+    // waiting for the previous frame to be shown keeps at most one frame queued, which lowers the latency
+    const bool is_fifo = present_mode == vk::PresentModeKHR::eFifo || present_mode == vk::PresentModeKHR::eFifoRelaxed;
+    if (!state.support_present_wait || !is_fifo || present_id < 2)
+        return;
+
+    try {
+        const vk::Result result = state.device.waitForPresentKHR(swapchain, present_id - 1, present_wait_timeout);
+        if (result == vk::Result::eSuccess && previous_pickup_time != std::chrono::steady_clock::time_point{}) {
+            const std::chrono::duration<float, std::milli> latency = std::chrono::steady_clock::now() - previous_pickup_time;
+            latency_sum_ms += latency.count();
+            if (++latency_count == latency_sample_count) {
+                state.present_latency_ms = latency_sum_ms / latency_count;
+                latency_sum_ms = 0.0f;
+                latency_count = 0;
+            }
+        }
+    } catch (vk::SystemError &) {
+        // the swapchain is out of date, it is rebuilt when acquiring the next image
+    }
+
+    // frames only containing the gui have no pickup time
+    previous_pickup_time = frame_pickup_time;
+    frame_pickup_time = {};
+}
+
 void ScreenRenderer::set_filter(const std::string_view &filter) {
     if (this->filter && filter == this->filter->get_name())
         // we are already using this filter
@@ -496,6 +581,16 @@ void ScreenRenderer::create_layout_sync() {
         image_acquired_semaphores[i] = state.device.createSemaphore({});
         image_ready_semaphores[i] = state.device.createSemaphore({});
     }
+
+    // the pool only grows with the swapchain, the timestamps it had are not needed
+    if (filter_query_pool)
+        state.device.destroy(filter_query_pool);
+    const vk::QueryPoolCreateInfo query_pool_info{
+        .queryType = vk::QueryType::eTimestamp,
+        .queryCount = swapchain_size * 2
+    };
+    filter_query_pool = state.device.createQueryPool(query_pool_info);
+    filter_timed.assign(swapchain_size, false);
 }
 
 void ScreenRenderer::create_render_pass() {
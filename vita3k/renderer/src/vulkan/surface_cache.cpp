@@ -18,6 +18,7 @@
 #include <renderer/vulkan/surface_cache.h>
 
 #include <gxm/functions.h>
+#include <renderer/profile.h>
 #include <renderer/vulkan/gxm_to_vulkan.h>
 #include <renderer/vulkan/state.h>
 #include <renderer/vulkan/types.h>
@@ -94,16 +95,29 @@ ColorSurfaceCacheInfo::~ColorSurfaceCacheInfo() {
 }
 
 void VKSurfaceCache::destroy_framebuffers(vk::ImageView view) {
+    auto view_it = framebuffers_by_view.find(static_cast<VkImageView>(view));
+    if (view_it == framebuffers_by_view.end())
+        return;
+
+    const std::vector<FramebufferKey> keys = std::move(view_it->second);
+    framebuffers_by_view.erase(view_it);
+
     vkutil::DestroyQueue &destroy_queue = state.frame().destroy_queue;
-    for (auto it = framebuffer_array.begin(); it != framebuffer_array.end();) {
+    for (const FramebufferKey &key : keys) {
         // if the color of depth-stencil match the one of the render_target, this won't be used anymore
-        if (it->first.first == view || it->first.second == view) {
-            destroy_queue.add(it->second.standard);
-            destroy_queue.add(it->second.shader_interlock);
-            it = framebuffer_array.erase(it);
-        } else {
-            it = std::next(it);
-        }
+        auto it = framebuffer_array.find(key);
+        if (it == framebuffer_array.end())
+            continue;
+
+        destroy_queue.add(it->second.standard);
+        destroy_queue.add(it->second.shader_interlock);
+        framebuffer_array.erase(it);
+
+        // the framebuffer is also listed for the other view
+        const VkImageView other_view = (key.first == static_cast<VkImageView>(view)) ? key.second : key.first;
+        auto other_it = framebuffers_by_view.find(other_view);
+        if (other_it != framebuffers_by_view.end())
+            std::erase(other_it->second, key);
     }
 }
 
@@ -121,6 +135,9 @@ void VKSurfaceCache::destroy_surface(ColorSurfaceCacheInfo &info) {
 
     destroy_framebuffers(info.texture.view);
     destroy_queue.add_image(info.texture);
+
+    allocated_bytes -= info.allocated_bytes;
+    info.allocated_bytes = 0;
 }
 
 void VKSurfaceCache::destroy_surface(DepthStencilSurfaceCacheInfo &info) {
@@ -137,15 +154,96 @@ void VKSurfaceCache::destroy_surface(DepthStencilSurfaceCacheInfo &info) {
 
     destroy_framebuffers(info.texture.view);
     destroy_queue.add_image(info.texture);
+
+    allocated_bytes -= info.allocated_bytes;
+    info.allocated_bytes = 0;
+}
+
+void VKSurfaceCache::add_allocation(SurfaceCacheInfo &info, const vkutil::Image &image) {
+    const uint64_t size = image.get_allocation_size();
+    info.allocated_bytes += size;
+    allocated_bytes += size;
+    state.surface_cache_bytes = allocated_bytes;
+}
+
+void VKSurfaceCache::mark_as_used(SurfaceCacheInfo &info) {
+    info.last_frame_used = reinterpret_cast<VKContext *>(state.context)->frame_timestamp;
+}
+
+// a surface used by one of the last frames is likely to be used again soon, and evicting it loses its content
+static constexpr uint64_t min_frames_before_eviction = 2 * MAX_FRAMES_RENDERING;
+
+// get the least recently used surface which can be evicted, the queue is walked from its lru element
+template <typename T>
+static T *find_evictable_surface(const lru::Queue<T> &queue, uint64_t frame_timestamp) {
+    lru::Item<T> *item = queue.head->prev;
+    for (size_t i = 0; i < queue.items.size(); i++, item = item->prev) {
+        T &info = item->content;
+        if (info.texture.image && info.last_frame_used + min_frames_before_eviction <= frame_timestamp)
+            return &info;
+    }
+
+    return nullptr;
+}
+
+void VKSurfaceCache::enforce_memory_budget() {
+    R_PROFILE(__func__);
+
+    const uint64_t frame_timestamp = reinterpret_cast<VKContext *>(state.context)->frame_timestamp;
+    while (memory_budget != 0 && allocated_bytes > memory_budget) {
+        ColorSurfaceCacheInfo *color_info = find_evictable_surface(color_surface_queue, frame_timestamp);
+        DepthStencilSurfaceCacheInfo *ds_info = find_evictable_surface(ds_surface_queue, frame_timestamp);
+        if (!color_info && !ds_info) {
+            LOG_WARN_ONCE("The surfaces used by the last frames do not fit in the surface cache budget of {} MiB", memory_budget / MiB(1));
+            break;
+        }
+
+        // evict the one which was not used for the longest time
+        if (color_info && (!ds_info || color_info->last_frame_used <= ds_info->last_frame_used)) {
+            destroy_surface(*color_info);
+            color_address_lookup.erase(color_info->data.address());
+            color_info->data = Ptr<void>();
+            if (last_written_surface == color_info)
+                last_written_surface = nullptr;
+            color_surface_queue.set_as_lru(color_info);
+        } else {
+            destroy_surface(*ds_info);
+            if (ds_info->surface.depth_data)
+                depth_address_lookup.erase(ds_info->surface.depth_data.address());
+            if (ds_info->surface.stencil_data)
+                stencil_address_lookup.erase(ds_info->surface.stencil_data.address());
+            ds_info->surface.depth_data.reset();
+            ds_info->surface.stencil_data.reset();
+            ds_surface_queue.set_as_lru(ds_info);
+        }
+
+        state.surface_cache_evictions++;
+    }
+
+    state.surface_cache_bytes = allocated_bytes;
+}
+
+void VKSurfaceCache::set_memory_budget(uint64_t budget) {
+    memory_budget = budget;
+    state.surface_cache_budget = budget;
+    if (budget != 0)
+        LOG_INFO("The surface cache can use up to {} MiB of GPU memory", budget / MiB(1));
 }
 
 VKSurfaceCache::VKSurfaceCache(VKState &state)
     : state(state) {
     color_surface_queue.init(max_surfaces_allowed);
     ds_surface_queue.init(max_surfaces_allowed);
+
+    // no allocation is needed when surfaces are added
+    color_address_lookup.reserve(max_surfaces_allowed);
+    depth_address_lookup.reserve(max_surfaces_allowed);
+    stencil_address_lookup.reserve(max_surfaces_allowed);
 }
 
 SurfaceRetrieveResult VKSurfaceCache::retrieve_color_surface_for_framebuffer(MemState &mem, SceGxmColorSurface *color) {
+    R_PROFILE(__func__);
+
     // Create the key to access the cache struct
     const uint32_t address = color->data.address();
 
@@ -229,6 +327,7 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_color_surface_for_framebuffer(Mem
             constexpr uint64_t big_delay_between_frames = 60;
             state.pipeline_cache.can_use_deferred_compilation = context->frame_timestamp - info.last_frame_rendered < big_delay_between_frames;
             info.last_frame_rendered = context->frame_timestamp;
+            info.last_frame_used = context->frame_timestamp;
 
             if (vk_format == info.texture.format) {
                 return { info.texture.view, &info.texture };
@@ -260,6 +359,7 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_color_surface_for_framebuffer(Mem
 
     color_surface_queue.set_as_mru(&info_added);
     info_added.last_frame_rendered = context->frame_timestamp;
+    info_added.last_frame_used = context->frame_timestamp;
 
     color_address_lookup[address] = &info_added;
 
@@ -298,6 +398,7 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_color_surface_for_framebuffer(Mem
     if (state.features.support_shader_interlock)
         surface_usages |= vk::ImageUsageFlagBits::eStorage;
     image.init_image(surface_usages, vkutil::default_comp_mapping, image_create_flags, image_info_pNext);
+    add_allocation(info_added, image);
 
     // do it in the prerender if we read from this texture in the same scene (although this would be useless)
     vk::CommandBuffer cmd_buffer = context->prerender_cmd;
@@ -325,10 +426,14 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_color_surface_for_framebuffer(Mem
     // it's not impossible that this surface will be rendered once and only used after, so do not skip any shader on it
     state.pipeline_cache.can_use_deferred_compilation = false;
 
+    enforce_memory_budget();
+
     return { info_added.texture.view, &info_added.texture };
 }
 
 std::optional<TextureLookupResult> VKSurfaceCache::retrieve_color_surface_as_texture(const SceGxmTexture &texture, const SceGxmColorBaseFormat base_format, TextureViewport *texture_viewport) {
+    R_PROFILE(__func__);
+
     // Create the key to access the cache struct
     const uint32_t address = (texture.data_addr << 2);
 
@@ -434,6 +539,7 @@ std::optional<TextureLookupResult> VKSurfaceCache::retrieve_color_surface_as_tex
 
     // We should be able to use this texture, so set it as mru
     color_surface_queue.set_as_mru(&info);
+    mark_as_used(info);
 
     const vk::ImageView color_handle_view = reinterpret_cast<VKContext *>(state.context)->current_color_view;
     const bool is_same_image = (color_handle_view == info.texture.view) || (color_handle_view == info.alternate_view);
@@ -534,6 +640,7 @@ std::optional<TextureLookupResult> VKSurfaceCache::retrieve_color_surface_as_tex
                 resulting_swizzle = swizzle;
 
             casted->texture.init_image(vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst, resulting_swizzle);
+            add_allocation(info, casted->texture);
             casted->texture.transition_to(cmd_buffer, vkutil::ImageLayout::TransferDst);
         } else {
             casted->texture.transition_to_discard(cmd_buffer, vkutil::ImageLayout::TransferDst);
@@ -629,6 +736,8 @@ std::optional<TextureLookupResult> VKSurfaceCache::retrieve_color_surface_as_tex
 }
 
 SurfaceRetrieveResult VKSurfaceCache::retrieve_depth_stencil_for_framebuffer(SceGxmDepthStencilSurface *depth_stencil, const uint32_t width, const uint32_t height) {
+    R_PROFILE(__func__);
+
     // when writing we use the render target size which is already upscaled
     int32_t memory_width = static_cast<int32_t>(width / state.res_multiplier);
     int32_t memory_height = static_cast<int32_t>(height / state.res_multiplier);
@@ -657,6 +766,7 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_depth_stencil_for_framebuffer(Sce
     if (cached_info != nullptr) {
         // this the most recently used depth-stencil surface
         ds_surface_queue.set_as_mru(cached_info);
+        mark_as_used(*cached_info);
 
         bool need_remake = cached_info->texture.width < width
             || cached_info->texture.height < height
@@ -683,6 +793,7 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_depth_stencil_for_framebuffer(Sce
 
     // update the lookup info
     ds_surface_queue.set_as_mru(cached_info);
+    mark_as_used(*cached_info);
     if (depth_stencil->depth_data)
         depth_address_lookup[depth_stencil->depth_data.address()] = cached_info;
     if (depth_stencil->stencil_data)
@@ -720,6 +831,7 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_depth_stencil_for_framebuffer(Sce
     image.format = state.deep_stencil_use;
     image.layout = vkutil::ImageLayout::Undefined;
     image.init_image(vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eSampled);
+    add_allocation(*cached_info, image);
 
     image.transition_to(cmd_buffer, vkutil::ImageLayout::TransferDst, vkutil::ds_subresource_range);
     vk::ClearDepthStencilValue clear_value{
@@ -729,6 +841,8 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_depth_stencil_for_framebuffer(Sce
     cmd_buffer.clearDepthStencilImage(image.image, vk::ImageLayout::eTransferDstOptimal, clear_value, vkutil::ds_subresource_range);
     image.transition_to(cmd_buffer, vkutil::ImageLayout::DepthStencilReadOnly, vkutil::ds_subresource_range);
 
+    enforce_memory_budget();
+
     return {
         image.view,
         &image
@@ -736,6 +850,8 @@ SurfaceRetrieveResult VKSurfaceCache::retrieve_depth_stencil_for_framebuffer(Sce
 }
 
 std::optional<TextureLookupResult> VKSurfaceCache::retrieve_depth_stencil_as_texture(const SceGxmTexture &texture, TextureViewport *texture_viewport) {
+    R_PROFILE(__func__);
+
     SceGxmTextureBaseFormat base_format = gxm::get_base_format(gxm::get_format(texture));
     bool can_be_depth = false;
     bool can_be_stencil = false;
@@ -836,6 +952,7 @@ std::optional<TextureLookupResult> VKSurfaceCache::retrieve_depth_stencil_as_tex
 
     // we sample from it, set the surface as most recently used
     ds_surface_queue.set_as_mru(found_info);
+    mark_as_used(*found_info);
 
     // take MSAA into account
     if (cached_info.multisample_mode != SCE_GXM_MULTISAMPLE_NONE)
@@ -918,6 +1035,7 @@ std::optional<TextureLookupResult> VKSurfaceCache::retrieve_depth_stencil_as_tex
             .delta_row = delta_row_samples,
         };
         read_only.depth_view.init_image(vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
+        add_allocation(cached_info, read_only.depth_view);
         // we want a texture view with only the depth or stencil aspect bit
         // TODO: not efficient
         state.device.destroy(read_only.depth_view.view);
@@ -1021,7 +1139,7 @@ Framebuffer &VKSurfaceCache::retrieve_framebuffer_handle(MemState &mem, SceGxmCo
     color_view = color_result.view;
     ds_view = ds_result.view;
 
-    std::pair<vk::ImageView, vk::ImageView> key = { color_view, ds_view };
+    const FramebufferKey key = { static_cast<VkImageView>(color_view), static_cast<VkImageView>(ds_view) };
     auto it = framebuffer_array.find(key);
 
     if (it != framebuffer_array.end()) {
@@ -1052,6 +1170,10 @@ Framebuffer &VKSurfaceCache::retrieve_framebuffer_handle(MemState &mem, SceGxmCo
         fb_interlock = state.device.createFramebuffer(fb_info);
     }
 
+    framebuffers_by_view[key.first].push_back(key);
+    if (key.second != key.first)
+        framebuffers_by_view[key.second].push_back(key);
+
     return (framebuffer_array[key] = { fb_standard, fb_interlock, color_result.base_image });
 }
 
@@ -1059,7 +1181,8 @@ bool VKSurfaceCache::check_for_surface(MemState &mem, Address source_address, Ca
     if (!state.features.enable_memory_mapping || state.disable_surface_sync)
         return false;
 
-    if (vector_utils::find_index(cpu_surfaces_changed, source_address) != -1) {
+    if (vector_utils::find_index(cpu_surfaces_changed, source_address) != -1
+        || (target_address && vector_utils::find_index(cpu_surfaces_changed, target_address) != -1)) {
         // there is a transfer operation pending on this surface, just add the callback after and we are done
         state.request_queue.push(CallbackRequest{ new CallbackRequestFunction(std::move(callback)) });
 
@@ -1085,60 +1208,233 @@ bool VKSurfaceCache::check_for_surface(MemState &mem, Address source_address, Ca
     if (!*surface.need_surface_sync) {
         // first send the command to sync the surface with the GPU
         *surface.need_surface_sync = true;
+        submit_surface_sync(surface, nullptr);
+    }
 
-        // we shouldn't have a command buffer being used, but just in case
-        vk::CommandBuffer prev_cmd = context.render_cmd;
+    // now push the callback
+    state.request_queue.push(CallbackRequest{ new CallbackRequestFunction(std::move(callback)) });
+
+    if (target_address)
+        cpu_surfaces_changed.push_back(target_address);
 
-        // for the time being, just create a temp command buffer / fence
-        // That's not the best approach but I guess it works
-        vk::CommandBuffer surface_cmd = nullptr;
-        vk::Fence fence = state.device.createFence({});
-        ColorSurfaceCacheInfo *returned_info = nullptr;
-        {
-            std::lock_guard<std::mutex> lock(state.multithread_pool_mutex);
-            surface_cmd = vkutil::create_single_time_command(state.device, state.multithread_command_pool);
+    return true;
+}
 
-            context.render_cmd = surface_cmd;
-            last_written_surface = &surface;
-            returned_info = perform_surface_sync();
-            context.render_cmd = prev_cmd;
+void VKSurfaceCache::submit_surface_sync(ColorSurfaceCacheInfo &surface, const std::function<void(vk::CommandBuffer)> &before_sync) {
+    VKContext &context = *static_cast<VKContext *>(state.context);
 
-            surface_cmd.end();
-        }
-        // submit this command
-        vk::SubmitInfo submit_info{};
-        submit_info.setCommandBuffers(surface_cmd);
-        state.general_queue.submit(submit_info, fence);
-
-        // now we need to wait for the fence, then destroy it along with the command buffer
-        // to prevent memory leaks
-        CallbackRequestFunction vk_callback = [&state = this->state, fence, surface_cmd]() {
-            auto result = state.device.waitForFences(fence, vk::True, std::numeric_limits<uint64_t>::max());
-            if (result != vk::Result::eSuccess)
-                LOG_ERROR("Could not wait for fences.");
-
-            // destroy the objects
-            state.device.destroyFence(fence);
-
-            std::lock_guard<std::mutex> lock(state.multithread_pool_mutex);
-            state.device.freeCommandBuffers(state.multithread_command_pool, surface_cmd);
-        };
-        state.request_queue.push(CallbackRequest{ new CallbackRequestFunction(std::move(vk_callback)) });
+    // we shouldn't have a command buffer being used, but just in case
+    vk::CommandBuffer prev_cmd = context.render_cmd;
+    ColorSurfaceCacheInfo *prev_written_surface = last_written_surface;
+
+    // for the time being, just create a temp command buffer / fence
+    // That's not the best approach but I guess it works
+    vk::CommandBuffer surface_cmd = nullptr;
+    vk::Fence fence = state.device.createFence({});
+    ColorSurfaceCacheInfo *returned_info = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(state.multithread_pool_mutex);
+        surface_cmd = vkutil::create_single_time_command(state.device, state.multithread_command_pool);
+
+        if (before_sync)
+            before_sync(surface_cmd);
+
+        context.render_cmd = surface_cmd;
+        last_written_surface = &surface;
+        returned_info = perform_surface_sync();
+        context.render_cmd = prev_cmd;
+        // the scene being rendered (if it was split) still needs its surface sync
+        last_written_surface = prev_written_surface;
+
+        surface_cmd.end();
+    }
+    // submit this command
+    vk::SubmitInfo submit_info{};
+    submit_info.setCommandBuffers(surface_cmd);
+    state.general_queue.submit(submit_info, fence);
+
+    // now we need to wait for the fence, then destroy it along with the command buffer
+    // to prevent memory leaks
+    CallbackRequestFunction vk_callback = [&state = this->state, fence, surface_cmd]() {
+        auto result = state.device.waitForFences(fence, vk::True, std::numeric_limits<uint64_t>::max());
+        if (result != vk::Result::eSuccess)
+            LOG_ERROR("Could not wait for fences.");
+
+        // destroy the objects
+        state.device.destroyFence(fence);
+
+        std::lock_guard<std::mutex> lock(state.multithread_pool_mutex);
+        state.device.freeCommandBuffers(state.multithread_command_pool, surface_cmd);
+    };
+    state.request_queue.push(CallbackRequest{ new CallbackRequestFunction(std::move(vk_callback)) });
 
-        if (returned_info)
-            state.request_queue.push(PostSurfaceSyncRequest{ returned_info });
+    if (returned_info) {
+        if (state.mapping_method == MappingMethod::DoubleBuffer && returned_info->need_buffer_sync)
+            state.request_queue.push(BufferSyncRequest{ returned_info->data.address(), static_cast<uint32_t>(returned_info->total_bytes) });
+        state.request_queue.push(PostSurfaceSyncRequest{ returned_info });
     }
+}
 
-    // now push the callback
-    state.request_queue.push(CallbackRequest{ new CallbackRequestFunction(std::move(callback)) });
+ColorSurfaceCacheInfo *VKSurfaceCache::find_transfer_surface(const SceGxmTransferImage &image) {
+    // a transfer pending on the CPU may still change the memory of this surface
+    if (vector_utils::find_index(cpu_surfaces_changed, image.address.address()) != -1)
+        return nullptr;
 
-    if (target_address)
-        cpu_surfaces_changed.push_back(target_address);
+    auto it = color_address_lookup.find(image.address.address());
+    if (it == color_address_lookup.end())
+        return nullptr;
 
+    ColorSurfaceCacheInfo &surface = *it->second;
+    const VKContext &context = *static_cast<VKContext *>(state.context);
+    // same conditions as check_for_surface, the memory must not have been written since the surface was rendered
+    if (surface.last_frame_rendered + MAX_FRAMES_RENDERING <= context.frame_timestamp || *surface.dirty)
+        return nullptr;
+
+    if (surface.tiling != SurfaceTiling::Linear || surface.texture.layout != vkutil::ImageLayout::ColorAttachmentReadWrite
+        || !format_support_surface_sync(surface.format))
+        return nullptr;
+
+    // the transfer must see the pixels the same way as the surface
+    if (image.stride < 0 || static_cast<uint32_t>(image.stride) != surface.stride_bytes
+        || gxm::get_bits_per_pixel(image.format) != gxm::bits_per_pixel(surface.format)
+        || image.x + image.width > surface.original_width || image.y + image.height > surface.original_height)
+        return nullptr;
+
+    return &surface;
+}
+
+// the surfaces are upscaled with the resolution multiplier
+static vk::Offset3D scale_offset(uint32_t x, uint32_t y, float res_multiplier) {
+    return { static_cast<int32_t>(x * res_multiplier), static_cast<int32_t>(y * res_multiplier), 0 };
+}
+
+// the transfer reads and writes the surfaces outside of any scene, order it with everything sent before and after
+static void transfer_barrier(vk::CommandBuffer cmd, bool before_transfer) {
+    vk::MemoryBarrier barrier{
+        .srcAccessMask = before_transfer ? vk::AccessFlagBits::eMemoryWrite : vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+    };
+    const vk::PipelineStageFlags src_stage = before_transfer ? vk::PipelineStageFlagBits::eAllCommands : vk::PipelineStageFlagBits::eTransfer;
+    cmd.pipelineBarrier(src_stage, vk::PipelineStageFlagBits::eAllCommands, {}, barrier, {}, {});
+}
+
+// the transfer is sent right away, the scenes recorded but not submitted yet would be rendered after it
+static bool can_transfer_on_gpu(const VKState &state) {
+    if (!state.features.enable_memory_mapping || state.disable_surface_sync)
+        return false;
+
+    const VKContext &context = *static_cast<VKContext *>(state.context);
+    return !context.is_recording && context.cmdbuffers_to_submit.empty();
+}
+
+bool VKSurfaceCache::transfer_copy(const SceGxmTransferImage &src, const SceGxmTransferImage &dst) {
+    if (!can_transfer_on_gpu(state))
+        return false;
+
+    ColorSurfaceCacheInfo *src_surface = find_transfer_surface(src);
+    ColorSurfaceCacheInfo *dst_surface = find_transfer_surface(dst);
+    if (!src_surface || !dst_surface || src_surface == dst_surface)
+        return false;
+
+    // an image copy keeps the bits, but they are only seen the same way in the memory if both surfaces have the same layout
+    if (src_surface->texture.format != dst_surface->texture.format || src_surface->swizzle != dst_surface->swizzle)
+        return false;
+
+    const float res_multiplier = state.res_multiplier;
+    const vk::Offset3D extent = scale_offset(src.width, src.height, res_multiplier);
+    vk::ImageCopy copy{
+        .srcSubresource = vkutil::color_subresource_layer,
+        .srcOffset = scale_offset(src.x, src.y, res_multiplier),
+        .dstSubresource = vkutil::color_subresource_layer,
+        .dstOffset = scale_offset(dst.x, dst.y, res_multiplier),
+        .extent = { static_cast<uint32_t>(extent.x), static_cast<uint32_t>(extent.y), 1 }
+    };
+
+    *dst_surface->need_surface_sync = true;
+    submit_surface_sync(*dst_surface, [&](vk::CommandBuffer cmd) {
+        transfer_barrier(cmd, true);
+        cmd.copyImage(src_surface->texture.image, vk::ImageLayout::eGeneral, dst_surface->texture.image, vk::ImageLayout::eGeneral, copy);
+        transfer_barrier(cmd, false);
+    });
+
+    // CPU operations on the destination must wait for its sync
+    cpu_surfaces_changed.push_back(dst.address.address());
+    return true;
+}
+
+bool VKSurfaceCache::transfer_downscale(const SceGxmTransferImage &src, const SceGxmTransferImage &dst) {
+    if (!can_transfer_on_gpu(state))
+        return false;
+
+    ColorSurfaceCacheInfo *src_surface = find_transfer_surface(src);
+    ColorSurfaceCacheInfo *dst_surface = find_transfer_surface(dst);
+    if (!src_surface || !dst_surface || src_surface == dst_surface)
+        return false;
+
+    if (src_surface->texture.format != dst_surface->texture.format || src_surface->swizzle != dst_surface->swizzle)
+        return false;
+
+    // a linear blit halving the size averages each 2x2 block, like the PS Vita
+    const vk::FormatFeatureFlags needed_features = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+    const vk::FormatProperties properties = state.physical_device.getFormatProperties(src_surface->texture.format);
+    if ((properties.optimalTilingFeatures & needed_features) != needed_features)
+        return false;
+
+    const float res_multiplier = state.res_multiplier;
+    vk::ImageBlit blit{
+        .srcSubresource = vkutil::color_subresource_layer,
+        .srcOffsets = std::array<vk::Offset3D, 2>{ scale_offset(src.x, src.y, res_multiplier), scale_offset(src.x + src.width, src.y + src.height, res_multiplier) },
+        .dstSubresource = vkutil::color_subresource_layer,
+        .dstOffsets = std::array<vk::Offset3D, 2>{ scale_offset(dst.x, dst.y, res_multiplier), scale_offset(dst.x + dst.width, dst.y + dst.height, res_multiplier) },
+    };
+    blit.srcOffsets[1].z = 1;
+    blit.dstOffsets[1].z = 1;
+
+    *dst_surface->need_surface_sync = true;
+    submit_surface_sync(*dst_surface, [&](vk::CommandBuffer cmd) {
+        transfer_barrier(cmd, true);
+        cmd.blitImage(src_surface->texture.image, vk::ImageLayout::eGeneral, dst_surface->texture.image, vk::ImageLayout::eGeneral, blit, vk::Filter::eLinear);
+        transfer_barrier(cmd, false);
+    });
+
+    cpu_surfaces_changed.push_back(dst.address.address());
+    return true;
+}
+
+bool VKSurfaceCache::transfer_fill(const SceGxmTransferImage &dst, uint32_t fill_color) {
+    if (!can_transfer_on_gpu(state))
+        return false;
+
+    ColorSurfaceCacheInfo *dst_surface = find_transfer_surface(dst);
+    if (!dst_surface)
+        return false;
+
+    // a clear covers the whole image, and the fill color must be converted to the components of the surface
+    if (dst.x != 0 || dst.y != 0 || dst.width != dst_surface->original_width || dst.height != dst_surface->original_height
+        || dst_surface->texture.format != vk::Format::eR8G8B8A8Unorm || dst_surface->swizzle != vkutil::rgba_mapping)
+        return false;
+
+    const vk::ClearColorValue clear_color{ std::array<float, 4>({
+        static_cast<float>(fill_color & 0xFF) / 255.0f,
+        static_cast<float>((fill_color >> 8) & 0xFF) / 255.0f,
+        static_cast<float>((fill_color >> 16) & 0xFF) / 255.0f,
+        static_cast<float>(fill_color >> 24) / 255.0f,
+    }) };
+
+    *dst_surface->need_surface_sync = true;
+    submit_surface_sync(*dst_surface, [&](vk::CommandBuffer cmd) {
+        transfer_barrier(cmd, true);
+        cmd.clearColorImage(dst_surface->texture.image, vk::ImageLayout::eGeneral, clear_color, vkutil::color_subresource_range);
+        transfer_barrier(cmd, false);
+    });
+
+    cpu_surfaces_changed.push_back(dst.address.address());
     return true;
 }
 
 ColorSurfaceCacheInfo *VKSurfaceCache::perform_surface_sync() {
+    R_PROFILE(__func__);
+
     // surface sync is supported only if memory mapping is enabled
     if (!state.features.enable_memory_mapping)
         return nullptr;
@@ -1160,16 +1456,32 @@ ColorSurfaceCacheInfo *VKSurfaceCache::perform_surface_sync() {
         is_swizzle_identity = true;
     }
 
-    if (state.res_multiplier != 1.0f) {
+    // a blit keeps the components when converting to another format, so blitting a RGBA8 surface
+    // to a BGRA8 image applies the BGRA swizzle (by far the most common one) on the GPU
+    const vk::Format surface_format = last_written_surface->texture.format;
+    const bool swizzle_with_blit = !is_swizzle_identity && support_bgra_blit
+        && last_written_surface->swizzle.r == vk::ComponentSwizzle::eB
+        && (surface_format == vk::Format::eR8G8B8A8Unorm || surface_format == vk::Format::eR8G8B8A8Srgb);
+
+    if (state.res_multiplier != 1.0f || swizzle_with_blit) {
         // scale back the image using a blit command first
 
+        vk::Format blit_format = surface_format;
+        if (swizzle_with_blit) {
+            blit_format = (surface_format == vk::Format::eR8G8B8A8Srgb) ? vk::Format::eB8G8R8A8Srgb : vk::Format::eB8G8R8A8Unorm;
+            is_swizzle_identity = true;
+        }
+
         if (!last_written_surface->blit_image)
             last_written_surface->blit_image = std::make_unique<vkutil::Image>();
 
         vkutil::Image &blit_image = *last_written_surface->blit_image;
+        if (blit_image.image && blit_image.format != blit_format)
+            // the surface swizzle changed
+            state.frame().destroy_queue.add_image(blit_image);
 
         if (!blit_image.image) {
-            blit_image.format = last_written_surface->texture.format;
+            blit_image.format = blit_format;
             blit_image.width = last_written_surface->original_width;
             blit_image.height = last_written_surface->original_height;
 
@@ -1242,6 +1554,22 @@ static void swizzle_text_T_2(T *pixels, uint32_t nb_pixel) {
 
 template <typename T, size_t type>
 static void swizzle_text_T_4(T *pixels, uint32_t nb_pixel) {
+    if constexpr (std::is_same_v<T, uint8_t>) {
+        // handle a whole pixel at once, the compiler can vectorize this
+        for (uint32_t i = 0; i < nb_pixel; i++) {
+            uint32_t pixel;
+            memcpy(&pixel, &pixels[4 * i], sizeof(uint32_t));
+            if constexpr (type == 0)
+                pixel = (pixel & 0xFF00FF00) | ((pixel >> 16) & 0xFF) | ((pixel & 0xFF) << 16);
+            else if constexpr (type == 1)
+                pixel = (pixel >> 24) | ((pixel >> 8) & 0xFF00) | ((pixel << 8) & 0xFF0000) | (pixel << 24);
+            else
+                pixel = (pixel << 8) | (pixel >> 24);
+            memcpy(&pixels[4 * i], &pixel, sizeof(uint32_t));
+        }
+        return;
+    }
+
     for (uint32_t i = 0; i < nb_pixel; i++) {
         if constexpr (type == 0) {
             // BGRA
@@ -1290,6 +1618,8 @@ static void swizzle_text_T(T *pixels, uint32_t nb_pixel, ColorSurfaceCacheInfo *
 }
 
 void VKSurfaceCache::perform_post_surface_sync(const MemState &mem, ColorSurfaceCacheInfo *surface) {
+    R_PROFILE(__func__);
+
     if (surface == nullptr)
         return;
 
@@ -21,6 +21,7 @@
 
 #include <gxm/functions.h>
 #include <renderer/functions.h>
+#include <renderer/profile.h>
 
 #include <util/log.h>
 
@@ -106,6 +107,55 @@ void sync_depth_bias(VKContext &context) {
     context.render_cmd.setDepthBias(static_cast<float>(context.record.depth_bias_unit), 0.0, static_cast<float>(context.record.depth_bias_slope));
 }
 
+static bool is_same_stencil_op(const GxmStencilStateOp &lhs, const GxmStencilStateOp &rhs) {
+    return lhs.func == rhs.func && lhs.stencil_fail == rhs.stencil_fail && lhs.depth_fail == rhs.depth_fail && lhs.depth_pass == rhs.depth_pass;
+}
+
+static void set_stencil_op(vk::CommandBuffer cmd, vk::StencilFaceFlags face, const GxmStencilStateOp &op) {
+    cmd.setStencilOpEXT(face, translate_stencil_op(op.stencil_fail), translate_stencil_op(op.depth_pass),
+        translate_stencil_op(op.depth_fail), translate_stencil_func(op.func));
+}
+
+// the pipelines do not depend on these states when the extended dynamic state is supported
+void sync_extended_dynamic_state(VKContext &context) {
+    if (!context.is_recording || !context.state.support_extended_dynamic_state)
+        return;
+
+    const GxmRecordState &record = context.record;
+    const bool two_sided = (record.two_sided == SCE_GXM_TWO_SIDED_ENABLED);
+    const VKContext::ExtendedDynamicState current{
+        .cull_mode = record.cull_mode,
+        .depth_func = record.front_depth_func,
+        .depth_write_mode = record.front_depth_write_mode,
+        .front_stencil_op = record.front_stencil_state_op,
+        .back_stencil_op = two_sided ? record.back_stencil_state_op : record.front_stencil_state_op
+    };
+
+    VKContext::ExtendedDynamicState &last = context.last_extended_dynamic_state;
+    // the state must be set again for each new command buffer
+    const bool is_valid = context.is_extended_dynamic_state_valid;
+    if (!is_valid || current.cull_mode != last.cull_mode)
+        context.render_cmd.setCullModeEXT(translate_cull_mode(current.cull_mode));
+    if (!is_valid || current.depth_func != last.depth_func)
+        context.render_cmd.setDepthCompareOpEXT(translate_depth_func(current.depth_func));
+    if (!is_valid || current.depth_write_mode != last.depth_write_mode)
+        context.render_cmd.setDepthWriteEnableEXT(current.depth_write_mode == SCE_GXM_DEPTH_WRITE_ENABLED);
+
+    const bool front_changed = !is_valid || !is_same_stencil_op(current.front_stencil_op, last.front_stencil_op);
+    const bool back_changed = !is_valid || !is_same_stencil_op(current.back_stencil_op, last.back_stencil_op);
+    if (front_changed && back_changed && is_same_stencil_op(current.front_stencil_op, current.back_stencil_op)) {
+        set_stencil_op(context.render_cmd, vk::StencilFaceFlagBits::eFrontAndBack, current.front_stencil_op);
+    } else {
+        if (front_changed)
+            set_stencil_op(context.render_cmd, vk::StencilFaceFlagBits::eFront, current.front_stencil_op);
+        if (back_changed)
+            set_stencil_op(context.render_cmd, vk::StencilFaceFlagBits::eBack, current.back_stencil_op);
+    }
+
+    last = current;
+    context.is_extended_dynamic_state_valid = true;
+}
+
 void sync_depth_data(VKContext &context) {
     if (context.record.depth_stencil_surface.force_load)
         return;
@@ -208,16 +258,44 @@ void sync_visibility_buffer(VKContext &context, Ptr<uint32_t> buffer, uint32_t s
         return;
     }
 
+    if (!context.state.features.enable_memory_mapping) {
+        // the query results are copied by the GPU to the guest memory
+        LOG_WARN_ONCE("Visibility buffers are only supported with memory mapping");
+        context.current_visibility_buffer = nullptr;
+        return;
+    }
+
+    const uint32_t query_count = stride / sizeof(uint32_t);
     auto ite = context.visibility_buffers.find(buffer.address());
+    if (ite != context.visibility_buffers.end() && ite->second.size != query_count) {
+        // the buffer was re-allocated with another size, its queries are not used by the current scene
+        // as the visibility buffer can only be changed between scenes
+        context.free_query_pools.emplace(ite->second.query_pool_size, ite->second.query_pool);
+        if (context.current_visibility_buffer == &ite->second)
+            context.current_visibility_buffer = nullptr;
+        context.visibility_buffers.erase(ite);
+        ite = context.visibility_buffers.end();
+    }
+
     if (ite == context.visibility_buffers.end()) {
-        // create a new query pool
-        vk::QueryPoolCreateInfo pool_info{
-            .queryType = vk::QueryType::eOcclusion,
-            .queryCount = static_cast<uint32_t>(stride / sizeof(uint32_t))
-        };
-        vk::QueryPool query_pool = context.state.device.createQueryPool(pool_info);
+        // reuse a query pool big enough if there is one, the queries are reset before being used in a scene
+        vk::QueryPool query_pool;
+        uint32_t query_pool_size;
+        auto free_pool = context.free_query_pools.lower_bound(query_count);
+        if (free_pool != context.free_query_pools.end()) {
+            query_pool_size = free_pool->first;
+            query_pool = free_pool->second;
+            context.free_query_pools.erase(free_pool);
+        } else {
+            vk::QueryPoolCreateInfo pool_info{
+                .queryType = vk::QueryType::eOcclusion,
+                .queryCount = query_count
+            };
+            query_pool = context.state.device.createQueryPool(pool_info);
+            query_pool_size = query_count;
+        }
 
-        context.visibility_buffers[buffer.address()] = { buffer.address(), nullptr, 0, static_cast<uint32_t>(stride / sizeof(uint32_t)), query_pool };
+        context.visibility_buffers[buffer.address()] = { buffer.address(), nullptr, 0, query_count, query_pool, query_pool_size };
         ite = context.visibility_buffers.find(buffer.address());
 
         std::tie(ite->second.gpu_buffer, ite->second.buffer_offset) = context.state.get_matching_mapping(buffer.cast<void>());
@@ -260,6 +338,8 @@ void sync_visibility_index(VKContext &context, bool enable, uint32_t index, bool
 }
 
 void refresh_pipeline(VKContext &context) {
+    R_PROFILE(__func__);
+
     context.refresh_pipeline = true;
 }
 
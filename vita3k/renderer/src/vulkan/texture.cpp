@@ -24,6 +24,7 @@
 #include <gxm/functions.h>
 #include <gxm/types.h>
 #include <renderer/functions.h>
+#include <renderer/profile.h>
 #include <util/align.h>
 #include <vkutil/vkutil.h>
 
@@ -55,9 +56,12 @@ static bool is_depth_stencil_compatible_format(SceGxmTextureBaseFormat format, b
 }
 
 VKTextureCache::VKTextureCache(VKState &state)
-    : state(state) {}
+    : state(state)
+    , staging_buffers(NB_TEXTURE_STAGING_BUFFERS) {}
 
 void sync_texture(VKContext &context, MemState &mem, std::size_t index, SceGxmTexture texture, const Config &config) {
+    R_PROFILE(__func__);
+
     // why are we doing this here?
     // well textures are synced right before the draw
     // in particular, we know that the scissor is the correct one for the upcoming draw
@@ -141,7 +145,7 @@ void sync_texture(VKContext &context, MemState &mem, std::size_t index, SceGxmTe
     }
 }
 
-void VKTextureCache::prepare_staging_buffer(bool is_configure) {
+void VKTextureCache::prepare_staging_buffer(bool is_configure, bool keep_content) {
     assert(!is_texture_transfer_ready);
     VKContext *context = reinterpret_cast<VKContext *>(state.context);
 
@@ -152,30 +156,38 @@ void VKTextureCache::prepare_staging_buffer(bool is_configure) {
     bool use_previous_buffer = (current_scene_timestamp == staging_buffer->scene_timestamp) && (staging_buffer->buffer.size - staging_buffer->used_so_far) >= current_texture->memory_needed;
 
     if (!use_previous_buffer) {
-        staging_idx = (staging_idx + 1) % NB_TEXTURE_STAGING_BUFFERS;
+        staging_idx = (staging_idx + 1) % staging_buffers.size();
         staging_buffer = &staging_buffers[staging_idx];
     }
 
     // if we are not using the previous buffer, we wait if the buffer was used at least once,
     // less than MAX_FRAMES_RENDERING frames ago and we have not yet waited for its fence
-    const bool need_wait = !use_previous_buffer
+    bool need_wait = !use_previous_buffer
         && staging_buffer->frame_timestamp != ~0
         && staging_buffer->frame_timestamp > context->frame_timestamp - MAX_FRAMES_RENDERING
         && staging_buffer->scene_timestamp > last_waited_scene;
     const vk::Fence current_fence = context->next_fence;
 
+    // rather than waiting for the GPU to be done with the oldest buffer, insert a new one before it in the ring
+    // the fence of the current scene has not been submitted yet, so its status can't be checked
+    if (need_wait && staging_buffers.size() < MAX_TEXTURE_STAGING_BUFFERS
+        && (staging_buffer->scene_timestamp == current_scene_timestamp || state.device.getFenceStatus(staging_buffer->waiting_fence) != vk::Result::eSuccess)) {
+        staging_buffers.insert(staging_buffers.begin() + staging_idx, TextureStagingBuffer{});
+        staging_buffer = &staging_buffers[staging_idx];
+        need_wait = false;
+        LOG_INFO("Texture staging ring grown to {} buffers ({} stalls so far, {} ms spent waiting)", staging_buffers.size(),
+            staging_stall_count, staging_stall_time.count() / 1000);
+    }
+
     if (need_wait) {
+        const auto stall_start = std::chrono::steady_clock::now();
         if (staging_buffer->scene_timestamp == current_scene_timestamp) {
             assert(current_fence == staging_buffer->waiting_fence);
             // special case, all the staging buffer are occupied by the current scene
             // submit the command buffer and wait for it
             context->prerender_cmd.end();
             context->cmdbuffers_to_submit.push_back(context->prerender_cmd);
-
-            vk::SubmitInfo submit_info{};
-            submit_info.setCommandBuffers(context->cmdbuffers_to_submit);
-            state.general_queue.submit(submit_info, current_fence);
-            context->cmdbuffers_to_submit.clear();
+            context->submit_command_buffers(current_fence);
 
             auto result = state.device.waitForFences(current_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
             if (result != vk::Result::eSuccess) {
@@ -206,10 +218,17 @@ void VKTextureCache::prepare_staging_buffer(bool is_configure) {
             }
             last_waited_scene = staging_buffer->scene_timestamp;
         }
+
+        const auto stall_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - stall_start);
+        staging_stall_count++;
+        staging_stall_time += stall_time;
+        LOG_DEBUG("Waited {} us for a texture staging buffer ({} stalls, {} ms in total)", stall_time.count(), staging_stall_count, staging_stall_time.count() / 1000);
     }
 
     // then we can use the buffer
-    cmd_buffer = context->prerender_cmd;
+    // a new texture does not depend on previous GPU work, it can be uploaded on the async transfer queue
+    is_async_upload = is_configure && state.use_async_transfer;
+    cmd_buffer = is_async_upload ? context->get_async_transfer_cmd() : context->prerender_cmd;
     if (!use_previous_buffer) {
         staging_buffer->scene_timestamp = current_scene_timestamp;
         staging_buffer->frame_timestamp = context->frame_timestamp;
@@ -221,7 +240,7 @@ void VKTextureCache::prepare_staging_buffer(bool is_configure) {
             // destroy the previous one if there is, no need to defer destroy it as we know it is no longer being used
             staging_buffer->buffer.destroy();
 
-            staging_buffer->buffer.size = current_texture->memory_needed;
+            staging_buffer->buffer.size = std::max(align(current_texture->memory_needed, 16), TEXTURE_STAGING_BUFFER_MIN_SIZE);
             staging_buffer->buffer.init_buffer(vk::BufferUsageFlagBits::eTransferSrc, vkutil::vma_mapped_alloc);
         }
     }
@@ -238,6 +257,8 @@ void VKTextureCache::prepare_staging_buffer(bool is_configure) {
     // if this is done during configure, layout is undefined, otherwise it is shader read only
     if (is_configure)
         vkutil::transition_image_layout(cmd_buffer, current_texture->texture.image, vkutil::ImageLayout::Undefined, vkutil::ImageLayout::TransferDst, range);
+    else if (keep_content)
+        vkutil::transition_image_layout(cmd_buffer, current_texture->texture.image, vkutil::ImageLayout::SampledImage, vkutil::ImageLayout::TransferDst, range);
     else
         vkutil::transition_image_layout_discard(cmd_buffer, current_texture->texture.image, vkutil::ImageLayout::SampledImage, vkutil::ImageLayout::TransferDst, range);
 
@@ -278,6 +299,32 @@ bool VKTextureCache::init(const bool hashless_texture_cache, const fs::path &tex
     const vk::FormatProperties astc_support = state.physical_device.getFormatProperties(vk::Format::eAstc4x4SrgbBlock);
     support_astc = static_cast<bool>(astc_support.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
 
+    // check for etc2 support, used to transcode bcn textures
+    const vk::FormatProperties etc2_support = state.physical_device.getFormatProperties(vk::Format::eEtc2R8G8B8A8SrgbBlock);
+    support_etc2 = static_cast<bool>(etc2_support.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+
+    support_partial_upload = true;
+
+    // the textures can use half of the largest device local heap, the rest is left for the surfaces and buffers
+    vk::DeviceSize device_memory = 0;
+    if (state.support_memory_budget) {
+        auto props = state.physical_device.getMemoryProperties2KHR<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        const vk::PhysicalDeviceMemoryProperties &memory = props.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+        const vk::PhysicalDeviceMemoryBudgetPropertiesEXT &budget = props.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        for (uint32_t i = 0; i < memory.memoryHeapCount; i++) {
+            if (memory.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+                device_memory = std::max(device_memory, budget.heapBudget[i]);
+        }
+    } else {
+        for (uint32_t i = 0; i < state.physical_device_memory.memoryHeapCount; i++) {
+            const vk::MemoryHeap &heap = state.physical_device_memory.memoryHeaps[i];
+            if (heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+                device_memory = std::max(device_memory, heap.size);
+        }
+    }
+    memory_budget = device_memory / 2;
+    LOG_INFO("Texture cache memory budget: {} MiB", memory_budget / (1024 * 1024));
+
     return true;
 }
 
@@ -302,6 +349,8 @@ static vk::Format linear_to_srgb(const vk::Format format) {
         return vk::Format::eBc3SrgbBlock;
     case vk::Format::eBc7UnormBlock:
         return vk::Format::eBc7SrgbBlock;
+    case vk::Format::eEtc2R8G8B8A8UnormBlock:
+        return vk::Format::eEtc2R8G8B8A8SrgbBlock;
     default: {
         LOG_WARN_ONCE("Trying to use gamma correction with non-compatible format {}", vk::to_string(format));
         return format;
@@ -343,6 +392,8 @@ static uint32_t get_image_memory_upper_bound(const SceGxmTexture &gxm_texture, c
 }
 
 void VKTextureCache::configure_texture(const SceGxmTexture &gxm_texture) {
+    R_PROFILE(__func__);
+
     const SceGxmTextureFormat format = gxm::get_format(gxm_texture);
     const SceGxmTextureBaseFormat base_format = gxm::get_base_format(format);
 
@@ -356,9 +407,14 @@ void VKTextureCache::configure_texture(const SceGxmTexture &gxm_texture) {
     const uint16_t mip_count = renderer::texture::get_upload_mip(gxm_texture.true_mip_count(), width, height);
 
     vk::Format vk_format = texture::translate_format(base_format);
-    if (gxm::is_bcn_format(base_format) && !support_dxt)
-        // texture will be decompressed
-        vk_format = bcn_to_rgba8(vk_format);
+    if (gxm::is_bcn_format(base_format) && !support_dxt) {
+        if (is_transcoded_to_etc2(base_format))
+            // texture will be transcoded
+            vk_format = vk::Format::eEtc2R8G8B8A8UnormBlock;
+        else
+            // texture will be decompressed
+            vk_format = bcn_to_rgba8(vk_format);
+    }
     if (gxm_texture.gamma_mode)
         vk_format = linear_to_srgb(vk_format);
 
@@ -455,6 +511,20 @@ void VKTextureCache::upload_texture_impl(SceGxmTextureBaseFormat base_format, ui
     if (!is_texture_transfer_ready)
         prepare_staging_buffer();
 
+    copy_to_texture(base_format, width, 0, height, mip_index, pixels, face, pixels_per_stride);
+}
+
+void VKTextureCache::upload_texture_region_impl(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t y, uint32_t height, const void *pixels, uint32_t pixels_per_stride) {
+    R_PROFILE(__func__);
+
+    if (!is_texture_transfer_ready)
+        prepare_staging_buffer(false, true);
+
+    copy_to_texture(base_format, width, y, height, 0, pixels, 0, pixels_per_stride);
+}
+
+void VKTextureCache::copy_to_texture(SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t y, uint32_t height,
+    uint32_t mip_index, const void *pixels, int face, uint32_t pixels_per_stride) {
     vkutil::Image &image = current_texture->texture;
     TextureStagingBuffer &staging_buffer = staging_buffers[staging_idx];
 
@@ -473,7 +543,7 @@ void VKTextureCache::upload_texture_impl(SceGxmTextureBaseFormat base_format, ui
 
     vk::DeviceSize upload_size;
     uint32_t buffer_height = height;
-    if (gxm::is_bcn_format(base_format)) {
+    if (gxm::is_bcn_format(base_format) || base_format == SCE_GXM_TEXTURE_BASE_FORMAT_ETC2RGBA8) {
         upload_size = renderer::texture::get_compressed_size(base_format, pixels_per_stride, height);
         pixels_per_stride = align(pixels_per_stride, 4);
         buffer_height = align(buffer_height, 4);
@@ -506,7 +576,7 @@ void VKTextureCache::upload_texture_impl(SceGxmTextureBaseFormat base_format, ui
         .bufferRowLength = pixels_per_stride,
         .bufferImageHeight = buffer_height,
         .imageSubresource = layer,
-        .imageOffset = { 0, 0, 0 },
+        .imageOffset = { 0, static_cast<int32_t>(y), 0 },
         .imageExtent = { width, height, 1 }
     };
     cmd_buffer.copyBufferToImage(staging_buffer.buffer.buffer, image.image, vk::ImageLayout::eTransferDstOptimal, region);
@@ -514,6 +584,8 @@ void VKTextureCache::upload_texture_impl(SceGxmTextureBaseFormat base_format, ui
 }
 
 void VKTextureCache::upload_done() {
+    R_PROFILE(__func__);
+
     // transition the texture back to read only
     vk::ImageSubresourceRange range{
         .aspectMask = vk::ImageAspectFlagBits::eColor,
@@ -522,19 +594,35 @@ void VKTextureCache::upload_done() {
         .baseArrayLayer = 0,
         .layerCount = current_texture->is_cube ? 6U : 1U
     };
-    vkutil::transition_image_layout(cmd_buffer, current_texture->texture.image, vkutil::ImageLayout::TransferDst, vkutil::ImageLayout::SampledImage, range);
+    if (is_async_upload) {
+        // the texture is released by the async transfer queue then acquired by the general queue before it is used in the scene
+        VKContext *context = reinterpret_cast<VKContext *>(state.context);
+        vkutil::transfer_image_ownership(cmd_buffer, current_texture->texture.image, vkutil::ImageLayout::TransferDst, vkutil::ImageLayout::SampledImage,
+            state.async_transfer_family_index, state.general_family_index, true, range);
+        vkutil::transfer_image_ownership(context->prerender_cmd, current_texture->texture.image, vkutil::ImageLayout::TransferDst, vkutil::ImageLayout::SampledImage,
+            state.async_transfer_family_index, state.general_family_index, false, range);
+        is_async_upload = false;
+    } else {
+        vkutil::transition_image_layout(cmd_buffer, current_texture->texture.image, vkutil::ImageLayout::TransferDst, vkutil::ImageLayout::SampledImage, range);
+    }
     current_texture->texture.layout = vkutil::ImageLayout::SampledImage;
     // this should not be necessary
     cmd_buffer = nullptr;
     is_texture_transfer_ready = false;
 }
 
+void VKTextureCache::free_texture(size_t index) {
+    vkutil::Image &image = textures[index].texture;
+    // the texture may still be used by the scenes being rendered
+    if (image.image)
+        state.frame().destroy_queue.add_image(image);
+    textures[index].memory_needed = 0;
+}
+
 void VKTextureCache::configure_sampler(size_t index, const SceGxmTexture &texture, bool no_linear) {
     vk::Sampler &sampler = samplers[index];
-    if (sampler) {
-        // the previous one has not been used for a while, we can destroy it
-        state.device.destroy(sampler);
-    }
+    // the previous one has not been used for a while, but the scenes being rendered may still use it
+    state.frame().destroy_queue.add(sampler);
 
     // linear strided textures use the mag filter as the min filter too
     const bool is_linear_strided = texture.texture_type() == SCE_GXM_TEXTURE_LINEAR_STRIDED;
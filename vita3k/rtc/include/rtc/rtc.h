@@ -94,6 +94,11 @@ inline time_t rtc_timegm(struct tm *tm) {
 
 std::uint64_t rtc_base_ticks();
 std::uint64_t rtc_get_ticks(uint64_t base_tick);
+// time of the guest since the epoch, in microseconds
+std::uint64_t rtc_ticks_since_epoch();
+// speed of the guest clock relative to the host one, above 1 to fast forward the app
+void rtc_set_speed(double speed);
+double rtc_get_speed();
 void __RtcPspTimeToTm(tm *val, const SceDateTime *pt);
 void __RtcTicksToPspTime(SceDateTime *t, std::uint64_t ticks);
 std::uint64_t __RtcPspTimeToTicks(const SceDateTime *pt);
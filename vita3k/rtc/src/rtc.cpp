@@ -19,12 +19,42 @@
 
 #include <util/log.h>
 
-static std::uint64_t rtc_ticks_since_epoch() {
+#include <mutex>
+
+// in fast forward, the guest clock runs faster than the host one from the point where its speed last changed
+static std::mutex clock_mutex;
+static std::uint64_t host_anchor = 0;
+static std::uint64_t guest_anchor = 0;
+static double clock_speed = 1.0;
+
+static std::uint64_t host_ticks_since_epoch() {
     const auto now = std::chrono::high_resolution_clock::now();
     const auto now_timepoint = std::chrono::time_point_cast<VitaClocks>(now);
     return now_timepoint.time_since_epoch().count();
 }
 
+static std::uint64_t guest_ticks_since_epoch(std::uint64_t host_ticks) {
+    return guest_anchor + static_cast<std::uint64_t>(static_cast<double>(host_ticks - host_anchor) * clock_speed);
+}
+
+std::uint64_t rtc_ticks_since_epoch() {
+    const std::lock_guard<std::mutex> guard(clock_mutex);
+    return guest_ticks_since_epoch(host_ticks_since_epoch());
+}
+
+void rtc_set_speed(double speed) {
+    const std::lock_guard<std::mutex> guard(clock_mutex);
+    const auto host_ticks = host_ticks_since_epoch();
+    guest_anchor = guest_ticks_since_epoch(host_ticks);
+    host_anchor = host_ticks;
+    clock_speed = speed;
+}
+
+double rtc_get_speed() {
+    const std::lock_guard<std::mutex> guard(clock_mutex);
+    return clock_speed;
+}
+
 std::uint64_t rtc_base_ticks() {
     return RTC_OFFSET + std::time(nullptr) * VITA_CLOCKS_PER_SEC - rtc_ticks_since_epoch();
 }
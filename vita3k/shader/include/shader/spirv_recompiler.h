@@ -66,6 +66,9 @@ struct GeneratedShader {
     usse::SpirvCode spirv;
 };
 
+// is the SPIR-V optimizer (from SPIRV-Tools) built in
+bool is_spirv_optimizer_available();
+
 // Dump generated SPIR-V disassembly up to this point
 void spirv_disasm_print(const usse::SpirvCode &spirv_binary, std::string *spirv_dump = nullptr);
 
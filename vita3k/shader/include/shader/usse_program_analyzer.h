@@ -236,4 +236,13 @@ void get_attribute_informations(const SceGxmProgram &program, AttributeInformati
 int get_uniform_buffer_sizes(const SceGxmProgram &program, UniformBufferSizes &sizes);
 
 void analyze(USSEBlockNode &root, USSEOffset end_offset, const AnalyzeReadFunction &read_func);
+
+/**
+ * \brief Get the control flow tree of a program, analyzing it only if no program with the same code was seen before.
+ *
+ * Many programs only differ by their parameters and a program is translated again for each render state
+ * it is used with, so the trees are shared between all the programs with identical instructions.
+ * This is safe to call from multiple threads.
+ */
+std::shared_ptr<const USSEBlockNode> get_program_tree(const std::uint64_t *code, USSEOffset count);
 } // namespace shader::usse
@@ -853,7 +853,8 @@ struct USSERecompiler final {
 
     spv::Function *end_hook_func;
 
-    USSEBlockNode tree_block_node;
+    // shared with the other programs having the same code
+    std::shared_ptr<const USSEBlockNode> program_tree;
 
     explicit USSERecompiler(spv::Builder &b, const SceGxmProgram &program, const FeatureState &features,
         const SpirvShaderParameters &parameters, utils::SpirvUtilFunctions &utils, spv::Function *end_hook_func,
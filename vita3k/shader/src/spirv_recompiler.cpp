@@ -25,6 +25,7 @@
 #include <gxm/functions.h>
 #include <gxm/types.h>
 #include <shader/gxp_parser.h>
+#include <shader/profile.h>
 #include <shader/usse_translator_entry.h>
 #include <shader/usse_translator_types.h>
 #include <util/fs.h>
@@ -34,8 +35,12 @@
 #include <SPIRV/SpvBuilder.h>
 #include <SPIRV/disassemble.h>
 #include <spirv_glsl.hpp>
+#ifdef VITA3K_SPIRV_OPTIMIZER
+#include <spirv-tools/optimizer.hpp>
+#endif
 
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <functional>
 #include <list>
@@ -1827,7 +1832,47 @@ static void generate_update_mask_body(spv::Builder &b, TranslationState &transla
     b.createStore(mask_v, out);
 }
 
+bool is_spirv_optimizer_available() {
+#ifdef VITA3K_SPIRV_OPTIMIZER
+    return true;
+#else
+    return false;
+#endif
+}
+
+// The translator works on the register banks through variables, loads and stores, which the drivers
+// do not always clean up (especially on mobile), so promote them to SSA values and remove what's left
+static void optimize_spirv(SpirvCode &spirv) {
+    SHADER_PROFILE("optimize_spirv");
+
+#ifdef VITA3K_SPIRV_OPTIMIZER
+    spvtools::Optimizer optimizer(SPV_ENV_VULKAN_1_1);
+    optimizer.SetMessageConsumer([](spv_message_level_t level, const char *, const spv_position_t &, const char *message) {
+        if (level <= SPV_MSG_ERROR)
+            LOG_ERROR("SPIR-V optimizer: {}", message);
+    });
+    optimizer.RegisterPass(spvtools::CreateMergeReturnPass())
+        .RegisterPass(spvtools::CreateInlineExhaustivePass())
+        .RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass())
+        .RegisterPass(spvtools::CreateLocalSingleStoreElimPass())
+        .RegisterPass(spvtools::CreateSSARewritePass())
+        .RegisterPass(spvtools::CreateCCPPass())
+        .RegisterPass(spvtools::CreateFoldSpecConstantOpAndCompositePass())
+        .RegisterPass(spvtools::CreateDeadBranchElimPass())
+        .RegisterPass(spvtools::CreateAggressiveDCEPass())
+        .RegisterPass(spvtools::CreateRedundancyEliminationPass())
+        .RegisterPass(spvtools::CreateCFGCleanupPass());
+
+    SpirvCode optimized;
+    // keep the unoptimized code if anything goes wrong, it is still valid
+    if (optimizer.Run(spirv.data(), spirv.size(), &optimized))
+        spirv = std::move(optimized);
+#endif
+}
+
 static SpirvCode convert_gxp_to_spirv_impl(const SceGxmProgram &program, const std::string &shader_hash, const FeatureState &features, TranslationState &translation_state, bool force_shader_debug, const std::function<bool(const std::string &ext, const std::string &dump)> &dumper) {
+    SHADER_PROFILE("convert_gxp_to_spirv");
+
     SpirvCode spirv;
 
     SceGxmProgramType program_type = program.get_type();
@@ -1968,6 +2013,9 @@ static SpirvCode convert_gxp_to_spirv_impl(const SceGxmProgram &program, const s
 
     b.dump(spirv);
 
+    if (translation_state.is_vulkan && features.optimize_spirv)
+        optimize_spirv(spirv);
+
     if (LOG_SHADER_CODE || force_shader_debug) {
         std::string spirv_dump;
         spirv_disasm_print(spirv, &spirv_dump);
@@ -1987,6 +2035,8 @@ static SpirvCode convert_gxp_to_spirv_impl(const SceGxmProgram &program, const s
 }
 
 static std::string convert_spirv_to_glsl(const std::string &shader_name, SpirvCode &spirv_binary, const FeatureState &features, TranslationState &translation_state) {
+    SHADER_PROFILE("convert_spirv_to_glsl");
+
     spirv_cross::CompilerGLSL glsl(std::move(spirv_binary));
 
     spirv_cross::CompilerGLSL::Options options;
@@ -2070,6 +2120,9 @@ static spv::ImageFormat translate_color_format(const SceGxmColorBaseFormat forma
 
 GeneratedShader convert_gxp(const SceGxmProgram &program, const std::string &shader_hash, const FeatureState &features, const Target target, const Hints &hints, bool maskupdate,
     bool force_shader_debug, const std::function<bool(const std::string &ext, const std::string &dump)> &dumper) {
+    SHADER_PROFILE("convert_gxp");
+    const auto translation_start = std::chrono::steady_clock::now();
+
     TranslationState translation_state;
     translation_state.is_fragment = program.is_fragment();
     translation_state.is_maskupdate = maskupdate;
@@ -2103,6 +2156,10 @@ GeneratedShader convert_gxp(const SceGxmProgram &program, const std::string &sha
         }
     }
 
+    const auto translation_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - translation_start);
+    LOG_DEBUG("Shader {} translated in {:.2f} ms ({} instructions)", shader_hash, translation_time.count() / 1000.0,
+        program.primary_program_instr_count + (program.secondary_program_end() - program.secondary_program_start()));
+
     return shader;
 }
 
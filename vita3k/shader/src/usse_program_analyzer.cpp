@@ -17,11 +17,18 @@
 
 #include <gxm/types.h>
 #include <shader/gxp_parser.h>
+#include <shader/profile.h>
 #include <shader/usse_program_analyzer.h>
 #include <shader/usse_types.h>
+#include <util/profile.h>
+
+#include <xxh3.h>
 
 #include <cassert>
+#include <cstring>
+#include <mutex>
 #include <queue>
+#include <unordered_map>
 
 namespace shader::usse {
 bool is_kill(const std::uint64_t inst) {
@@ -593,4 +600,44 @@ void analyze(USSEBlockNode &root, USSEOffset end_offset, const AnalyzeReadFuncti
     }
 }
 
+// a game has at most a few thousand different programs, start again if this is ever reached
+static constexpr size_t MAX_CACHED_PROGRAM_TREES = 8192;
+
+std::shared_ptr<const USSEBlockNode> get_program_tree(const std::uint64_t *code, USSEOffset count) {
+    SHADER_PROFILE("get_program_tree");
+
+    struct CachedTree {
+        // kept to rule out hash collisions
+        std::vector<std::uint64_t> code;
+        std::shared_ptr<const USSEBlockNode> tree;
+    };
+    static PROFILE_LOCKABLE(std::mutex, cache_mutex, "Program trees");
+    static std::unordered_map<std::uint64_t, CachedTree> cache;
+
+    const std::uint64_t hash = XXH3_64bits(code, count * sizeof(std::uint64_t));
+    const auto is_same_code = [&](const CachedTree &cached) {
+        return cached.code.size() == count && memcmp(cached.code.data(), code, count * sizeof(std::uint64_t)) == 0;
+    };
+
+    {
+        const std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(cache_mutex);
+        auto it = cache.find(hash);
+        if (it != cache.end() && is_same_code(it->second))
+            return it->second.tree;
+    }
+
+    // analyze outside of the lock, two threads may end up doing the same work but this is rare
+    auto tree = std::make_shared<USSEBlockNode>(nullptr, 0);
+    analyze(*tree, count - 1, [code](USSEOffset off) { return code[off]; });
+
+    const std::lock_guard<PROFILE_LOCKABLE_TYPE(std::mutex)> guard(cache_mutex);
+    if (cache.size() >= MAX_CACHED_PROGRAM_TREES)
+        cache.clear();
+    auto [it, inserted] = cache.try_emplace(hash);
+    if (inserted)
+        it->second = { std::vector<std::uint64_t>(code, code + count), tree };
+
+    return tree;
+}
+
 } // namespace shader::usse
@@ -20,20 +20,26 @@
 #include <gxm/types.h>
 #include <shader/decoder_detail.h>
 #include <shader/matcher.h>
+#include <shader/profile.h>
 #include <shader/usse_disasm.h>
 #include <shader/usse_translator.h>
 #include <shader/usse_translator_types.h>
 #include <util/log.h>
 
-#include <optional>
+#include <array>
+#include <vector>
 
 namespace shader::usse {
 
 template <typename Visitor>
 using USSEMatcher = shader::decoder::Matcher<Visitor, uint64_t>;
 
+// the 5 most significant bits of an instruction are its opcode
+static constexpr int USSE_OPCODE_SHIFT = 59;
+static constexpr size_t USSE_OPCODE_COUNT = 32;
+
 template <typename V>
-static std::optional<const USSEMatcher<V>> DecodeUSSE(uint64_t instruction) {
+static const USSEMatcher<V> *DecodeUSSE(uint64_t instruction) {
     static const std::array<USSEMatcher<V>, 35> table = {
 #define INST(fn, name, bitstring) shader::decoder::detail::detail<USSEMatcher<V>>::GetMatcher(fn, name, bitstring)
         // clang-format off
@@ -860,10 +866,26 @@ static std::optional<const USSEMatcher<V>> DecodeUSSE(uint64_t instruction) {
     };
 #undef INST
 
-    const auto matches_instruction = [instruction](const auto &matcher) { return matcher.Matches(instruction); };
+    // for each opcode, the matchers which can match an instruction with it, in the order of the table as the first match wins
+    // most opcodes only have one or two of them
+    static const auto opcode_table = [] {
+        std::array<std::vector<uint8_t>, USSE_OPCODE_COUNT> candidates;
+        for (uint64_t opcode = 0; opcode < USSE_OPCODE_COUNT; opcode++) {
+            for (size_t i = 0; i < table.size(); i++) {
+                const uint64_t opcode_mask = table[i].GetMask() >> USSE_OPCODE_SHIFT;
+                if ((opcode & opcode_mask) == (table[i].GetExpected() >> USSE_OPCODE_SHIFT))
+                    candidates[opcode].push_back(static_cast<uint8_t>(i));
+            }
+        }
+        return candidates;
+    }();
+
+    for (const uint8_t matcher_idx : opcode_table[instruction >> USSE_OPCODE_SHIFT]) {
+        if (table[matcher_idx].Matches(instruction))
+            return &table[matcher_idx];
+    }
 
-    auto iter = std::find_if(table.begin(), table.end(), matches_instruction);
-    return iter != table.end() ? std::optional<const USSEMatcher<V>>(*iter) : std::nullopt;
+    return nullptr;
 }
 
 //
@@ -876,8 +898,7 @@ USSERecompiler::USSERecompiler(spv::Builder &b, const SceGxmProgram &program, co
     , count(0)
     , b(b)
     , visitor(b, *this, program, features, utils, cur_instr, parameters, queries, true)
-    , end_hook_func(end_hook_func)
-    , tree_block_node(nullptr, 0) {
+    , end_hook_func(end_hook_func) {
 }
 
 void USSERecompiler::reset(const std::uint64_t *_inst, const std::size_t _count) {
@@ -885,8 +906,7 @@ void USSERecompiler::reset(const std::uint64_t *_inst, const std::size_t _count)
     count = _count;
     visitor.reset_for_new_session();
 
-    usse::analyze(tree_block_node, static_cast<shader::usse::USSEOffset>(_count - 1),
-        [&](usse::USSEOffset off) -> std::uint64_t { return inst[off]; });
+    program_tree = usse::get_program_tree(inst, static_cast<shader::usse::USSEOffset>(_count));
 }
 
 spv::Id USSERecompiler::get_condition_value(const std::uint8_t pred, const bool neg) {
@@ -939,8 +959,8 @@ void USSERecompiler::compile_code_node(const usse::USSECodeNode &code) {
         cur_instr = inst[pc];
 
         // Recompile the instruction, to the current block
-        auto decoder = usse::DecodeUSSE<usse::USSETranslatorVisitor>(cur_instr);
-        if (decoder.has_value())
+        const auto *decoder = usse::DecodeUSSE<usse::USSETranslatorVisitor>(cur_instr);
+        if (decoder)
             decoder->call(visitor, cur_instr);
         else
             LOG_DISASM("{:016x}: error: instruction unmatched", cur_instr);
@@ -1052,6 +1072,8 @@ void USSERecompiler::compile_block(const usse::USSEBlockNode &block) {
 }
 
 spv::Function *USSERecompiler::compile_program_function() {
+    SHADER_PROFILE("compile_program_function");
+
     // Make a new function (subroutine)
     spv::Block *last_build_point = b.getBuildPoint();
     spv::Block *new_sub_block = nullptr;
@@ -1061,7 +1083,7 @@ spv::Function *USSERecompiler::compile_program_function() {
     spv::Function *ret_func = b.makeFunctionEntry(spv::NoPrecision, b.makeVoidType(), sub_name.c_str(), {}, {}, {},
         &new_sub_block);
 
-    compile_block(tree_block_node);
+    compile_block(*program_tree);
 
     b.leaveFunction();
     b.setBuildPoint(last_build_point);
@@ -0,0 +1,109 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef job_pool_h
+#define job_pool_h
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads running jobs in submission order.
+// Each job returns a future so that the caller can do other work and wait for the result later.
+// Jobs must not wait on other jobs of the same pool, or all the workers could end up waiting.
+class JobPool {
+public:
+    JobPool() = default;
+    JobPool(const JobPool &) = delete;
+    JobPool &operator=(const JobPool &) = delete;
+
+    ~JobPool() {
+        stop();
+    }
+
+    // can be called again after stop
+    // on_worker_start is run by each new worker before its first job (to name the thread for example)
+    void start(int nb_threads, const std::function<void()> &on_worker_start = {}) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = false;
+        for (int i = static_cast<int>(workers_.size()); i < nb_threads; i++)
+            workers_.emplace_back(&JobPool::worker, this, on_worker_start);
+    }
+
+    // the jobs already submitted are run before the workers exit
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cond_.notify_all();
+        for (std::thread &worker : workers_)
+            worker.join();
+        workers_.clear();
+    }
+
+    // if the pool has no worker, the job is run right away on the calling thread
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F &&job) {
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(job));
+        auto result = task->get_future();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stopped_ || workers_.empty()) {
+                lock.unlock();
+                (*task)();
+                return result;
+            }
+            jobs_.emplace_back([task]() { (*task)(); });
+        }
+        cond_.notify_one();
+        return result;
+    }
+
+private:
+    void worker(const std::function<void()> on_worker_start) {
+        if (on_worker_start)
+            on_worker_start();
+
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [&] { return stopped_ || !jobs_.empty(); });
+                if (jobs_.empty())
+                    return;
+
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::function<void()>> jobs_;
+    std::vector<std::thread> workers_;
+    bool stopped_ = false;
+};
+
+#endif
@@ -0,0 +1,186 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#ifndef ring_queue_h
+#define ring_queue_h
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+
+// Bounded lock-free queue with multiple producers and a single consumer.
+// It has the same interface as Queue but items are stored in a fixed ring and returned by value,
+// so push and pop never allocate and only go to the kernel if the other side is actually waiting.
+// top, pop and reset must only be called from the consumer thread.
+template <typename T, size_t Capacity = 64>
+class RingQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // default value: the capacity of the ring
+    // with multiple producers, this limit can be exceeded by one item per concurrent producer
+    unsigned int maxPendingCount_ = Capacity;
+
+    std::optional<T> top(const int ms = 0) {
+        if (!wait_for([&]() { return aborted || is_ready(tail_.load(std::memory_order_relaxed)); }, ms) || aborted)
+            return {};
+
+        return slots_[tail_.load(std::memory_order_relaxed) & MASK].item;
+    }
+
+    std::optional<T> pop(const int ms = 0) {
+        if (!wait_for([&]() { return aborted || is_ready(tail_.load(std::memory_order_relaxed)); }, ms) || aborted)
+            return {};
+
+        std::optional<T> item = consume();
+        signal();
+        return item;
+    }
+
+    void push(const T &item) {
+        emplace(item);
+    }
+
+    void push(T &&item) {
+        emplace(std::move(item));
+    }
+
+    size_t size() {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    void abort() {
+        aborted = true;
+        signal();
+    }
+
+    void reset() {
+        while (is_ready(tail_.load(std::memory_order_relaxed)))
+            consume();
+        aborted = false;
+    }
+
+    void wait_empty() {
+        wait_for([&]() { return aborted || size() == 0; }, 0);
+    }
+
+    RingQueue() {
+        for (size_t i = 0; i < Capacity; i++)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    RingQueue(const RingQueue &) = delete; // disable copying
+    RingQueue &operator=(const RingQueue &) = delete; // disable assignment
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct Slot {
+        // equal to the position for an empty slot, position + 1 once the item is written
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    bool is_ready(size_t pos) const {
+        return slots_[pos & MASK].sequence.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    template <typename U>
+    void emplace(U &&item) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            if (aborted)
+                return;
+
+            Slot &slot = slots_[pos & MASK];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const bool has_room = pos - tail_.load(std::memory_order_acquire) < maxPendingCount_;
+            if (sequence == pos && has_room) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.item = std::forward<U>(item);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    break;
+                }
+                // pos was updated by the failed exchange
+            } else if (sequence == pos || static_cast<std::ptrdiff_t>(sequence - pos) < 0) {
+                // the queue is full, wait for the consumer
+                wait_for([&]() {
+                    return aborted || head_.load(std::memory_order_relaxed) != pos
+                        || (slot.sequence.load(std::memory_order_acquire) == pos && pos - tail_.load(std::memory_order_acquire) < maxPendingCount_);
+                },
+                    0);
+                pos = head_.load(std::memory_order_relaxed);
+            } else {
+                // another producer took this slot
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        signal();
+    }
+
+    std::optional<T> consume() {
+        const size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot &slot = slots_[pos & MASK];
+        std::optional<T> item = std::move(slot.item);
+        slot.sequence.store(pos + Capacity, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_release);
+        return item;
+    }
+
+    // wake up the threads blocked in wait_for, only notify the kernel if there are some
+    void signal() {
+        events_.fetch_add(1, std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) != 0)
+            events_.notify_all();
+    }
+
+    // with a timeout (in microseconds, like Queue), the thread yields until the deadline instead of sleeping
+    template <typename Pred>
+    bool wait_for(Pred pred, const int ms) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(ms);
+        while (true) {
+            const uint32_t events = events_.load(std::memory_order_seq_cst);
+            if (pred())
+                return true;
+
+            if (ms != 0) {
+                if (std::chrono::steady_clock::now() >= deadline)
+                    return false;
+                std::this_thread::yield();
+                continue;
+            }
+
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            if (!pred())
+                events_.wait(events, std::memory_order_seq_cst);
+            waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+    }
+
+    std::array<Slot, Capacity> slots_;
+    alignas(64) std::atomic<size_t> head_{ 0 };
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+    alignas(64) std::atomic<uint32_t> events_{ 0 };
+    std::atomic<uint32_t> waiters_{ 0 };
+    std::atomic<bool> aborted{ false };
+};
+
+#endif /* ring_queue_h */
@@ -0,0 +1,52 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Time spent by the parts of the audio pipeline which do not run in the host audio callback
+ *
+ * The NGS systems and the decoders are updated by guest threads, in the ngs and codec libraries,
+ * so the durations are summed in a single process-wide object until AudioState::update_stats takes them.
+ */
+struct AudioPipelineStats {
+    // in microseconds
+    std::atomic<uint64_t> ngs_update_time = 0;
+    std::atomic<uint32_t> ngs_update_max_time = 0;
+    std::atomic<uint64_t> decode_time = 0;
+
+    void add_ngs_update(uint32_t time) {
+        ngs_update_time += time;
+        uint32_t max_time = ngs_update_max_time;
+        while (time > max_time && !ngs_update_max_time.compare_exchange_weak(max_time, time)) {
+        }
+    }
+
+    void add_decode(uint32_t time) {
+        decode_time += time;
+    }
+};
+
+inline AudioPipelineStats audio_pipeline_stats;
+
+// duration in microseconds since start
+inline uint32_t audio_stats_elapsed_us(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
@@ -0,0 +1,57 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Trace of the startup of the emulator and of the application, until its first frame
+ *
+ * The spans are recorded from any thread and can be saved in the Chrome trace event format,
+ * which can be opened in chrome://tracing or https://ui.perfetto.dev.
+ * Nothing is recorded anymore once the first frame of the application has been presented.
+ */
+namespace boot_trace {
+
+using Clock = std::chrono::steady_clock;
+
+// Records the time spent between its construction and its destruction
+class Span {
+public:
+    explicit Span(std::string_view name);
+    ~Span();
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+private:
+    std::string name;
+    Clock::time_point start;
+};
+
+// The application chosen by the user starts to boot: the time to first frame is counted from here
+void begin_app_boot();
+
+// Logs the time to first frame with its main steps, and saves the trace if trace_path is not empty
+void end(const fs::path &trace_path);
+
+} // namespace boot_trace
@@ -0,0 +1,93 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Breakdown of the time of each frame between the main stages of the emulation
+ *
+ * Scoped timers placed in the renderer and in the kernel add their time to the stage of the current
+ * frame, end_frame then keeps the totals of the frame in a short history for the performance overlay.
+ * The timers only read the clock while the breakdown is enabled.
+ */
+namespace frame_timings {
+
+enum class Stage {
+    GuestCpu, // guest code of the main thread of the app
+    RenderCommands, // processing of the gxm commands by the renderer
+    PipelineWait, // draws waiting for their pipeline or shaders to be compiled
+    TextureUpload,
+    SurfaceSync, // surfaces written back to the guest memory
+    PresentWait,
+    Count
+};
+
+constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::Count);
+// about two seconds at 60 fps
+constexpr size_t HISTORY_SIZE = 128;
+
+struct Frame {
+    float total_ms = 0.0f;
+    std::array<float, STAGE_COUNT> stage_ms = {};
+};
+
+using Clock = std::chrono::steady_clock;
+
+extern std::atomic<bool> enabled;
+extern std::array<std::atomic<uint64_t>, STAGE_COUNT> current_ns;
+
+// the stages are timed in parallel: guest code runs while the renderer processes the previous commands,
+// so their sum is not the frame time
+inline void add(Stage stage, Clock::duration duration) {
+    current_ns[static_cast<size_t>(stage)].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), std::memory_order_relaxed);
+}
+
+// Adds the time spent between its construction and its destruction to a stage of the current frame
+class Scope {
+public:
+    explicit Scope(Stage stage)
+        : stage(stage)
+        , start(enabled.load(std::memory_order_relaxed) ? Clock::now() : Clock::time_point{}) {
+    }
+
+    ~Scope() {
+        if (start != Clock::time_point{})
+            add(stage, Clock::now() - start);
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    Stage stage;
+    Clock::time_point start;
+};
+
+// to be called once per frame shown by the app, the time since the previous call is the frame time
+void end_frame();
+
+// the frames of the history, from the oldest to the most recent
+std::vector<Frame> get_history();
+
+} // namespace frame_timings
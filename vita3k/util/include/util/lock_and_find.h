@@ -20,9 +20,17 @@
 #include "find.h"
 
 #include <mutex>
+#include <shared_mutex>
 
 template <typename T, typename Key>
 std::shared_ptr<T> lock_and_find(Key key, const std::map<Key, std::shared_ptr<T>> &map, std::mutex &mutex) {
     const std::lock_guard<std::mutex> lock(mutex);
     return util::find(key, map);
 }
+
+// lookups of different callers can run at the same time
+template <typename T, typename Key>
+std::shared_ptr<T> lock_and_find(Key key, const std::map<Key, std::shared_ptr<T>> &map, std::shared_mutex &mutex) {
+    const std::shared_lock<std::shared_mutex> lock(mutex);
+    return util::find(key, map);
+}
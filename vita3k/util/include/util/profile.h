@@ -0,0 +1,50 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+// Markers of the Tracy profiler shared by the modules, they compile to nothing when the module is not built with Tracy.
+// A lockable mutex is bigger than the mutex it wraps: only use PROFILE_LOCKABLE for mutexes declared in a source file
+// or in a header only included by modules built with Tracy.
+
+#ifdef TRACY_ENABLE
+
+#include <tracy/Tracy.hpp>
+
+#define PROFILE_SCOPE(name) ZoneScopedN(name)
+#define PROFILE_THREAD_NAME(name) tracy::SetThreadName(name)
+// for the threads created by libraries, which are only seen in their callbacks
+#define PROFILE_THREAD_NAME_ONCE(name)                                                           \
+    static thread_local const bool ___profile_thread_named = (tracy::SetThreadName(name), true); \
+    (void)___profile_thread_named
+#define PROFILE_LOCKABLE(type, var, description) TracyLockableN(type, var, description)
+#define PROFILE_LOCKABLE_TYPE(type) LockableBase(type)
+// the allocations of each pool are shown in their own memory view
+#define PROFILE_ALLOC(ptr, size, pool) TracyAllocN(ptr, size, pool)
+#define PROFILE_FREE(ptr, pool) TracyFreeN(ptr, pool)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_THREAD_NAME_ONCE(name)
+#define PROFILE_LOCKABLE(type, var, description) type var
+#define PROFILE_LOCKABLE_TYPE(type) type
+#define PROFILE_ALLOC(ptr, size, pool)
+#define PROFILE_FREE(ptr, pool)
+
+#endif // TRACY_ENABLE
@@ -0,0 +1,135 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/boot_trace.h>
+
+#include <util/log.h>
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace boot_trace {
+
+struct Event {
+    std::string name;
+    Clock::time_point start;
+    Clock::time_point end;
+    uint32_t thread;
+    uint32_t depth;
+};
+
+static std::mutex mutex;
+static const Clock::time_point trace_start = Clock::now();
+static Clock::time_point app_boot_start;
+static std::vector<Event> events;
+static std::map<std::thread::id, uint32_t> thread_numbers;
+static bool ended = false;
+
+// spans of the same thread are nested, the depth tells the main steps apart in the summary
+static thread_local uint32_t current_depth = 0;
+
+Span::Span(std::string_view name)
+    : name(name)
+    , start(Clock::now()) {
+    current_depth++;
+}
+
+Span::~Span() {
+    const auto end = Clock::now();
+    current_depth--;
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (ended)
+        return;
+
+    const auto thread_number = thread_numbers.emplace(std::this_thread::get_id(), static_cast<uint32_t>(thread_numbers.size())).first->second;
+    events.push_back({ std::move(name), start, end, thread_number, current_depth });
+}
+
+void begin_app_boot() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    app_boot_start = Clock::now();
+}
+
+static int64_t to_us(Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - trace_start).count();
+}
+
+static int64_t to_ms(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+static std::string escape_json(const std::string &str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (const char c : str) {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+static void save(const fs::path &trace_path, const std::vector<Event> &trace_events, Clock::time_point first_frame) {
+    fs::ofstream trace(trace_path);
+    if (!trace) {
+        LOG_ERROR("Cannot write the boot trace to {}", trace_path);
+        return;
+    }
+
+    trace << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (const auto &event : trace_events) {
+        trace << fmt::format("{{\"name\": \"{}\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {}, \"dur\": {}}},\n",
+            escape_json(event.name), event.thread, to_us(event.start), to_us(event.end) - to_us(event.start));
+    }
+    trace << fmt::format("{{\"name\": \"First frame\", \"ph\": \"i\", \"s\": \"g\", \"pid\": 1, \"tid\": 0, \"ts\": {}}}\n", to_us(first_frame));
+    trace << "]}\n";
+
+    LOG_INFO("Boot trace saved to {}", trace_path);
+}
+
+void end(const fs::path &trace_path) {
+    const auto first_frame = Clock::now();
+    std::vector<Event> trace_events;
+    Clock::time_point boot_start;
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        if (ended)
+            return;
+        ended = true;
+        trace_events = std::move(events);
+        boot_start = app_boot_start == Clock::time_point{} ? trace_start : app_boot_start;
+    }
+
+    std::string steps;
+    for (const auto &event : trace_events) {
+        if (event.depth != 0 || event.start < boot_start)
+            continue;
+        steps += fmt::format("{}{} {} ms", steps.empty() ? "" : ", ", event.name, to_ms(event.end - event.start));
+    }
+    LOG_INFO("Time to first frame: {} ms ({})", to_ms(first_frame - boot_start), steps);
+
+    if (!trace_path.empty())
+        save(trace_path, trace_events, first_frame);
+}
+
+} // namespace boot_trace
@@ -18,7 +18,7 @@
 /*
 float32 to float16 conversion
 we can have 2 cases
-1 program compiled for aarch64: Use the native __fp16 type
+1 program compiled for aarch64: Use NEON, 8 floats at a time, and the native __fp16 type for the remaining ones
 2 autodetect and use fast or basic conversion depends of runtime cpu
 */
 
@@ -29,9 +29,15 @@ we can have 2 cases
 #if defined(__aarch64__)
 #include <arm_neon.h>
 void float_to_half(const float *src, uint16_t *dest, const int total) {
+    int i = 0;
+    for (; i + 8 <= total; i += 8) {
+        const float16x8_t half_vector = vcombine_f16(vcvt_f16_f32(vld1q_f32(src + i)), vcvt_f16_f32(vld1q_f32(src + i + 4)));
+        vst1q_u16(dest + i, vreinterpretq_u16_f16(half_vector));
+    }
+
     // use the native type __fp16
     __fp16 *dest_fp = reinterpret_cast<__fp16 *>(dest);
-    for (int i = 0; i < total; i++) {
+    for (; i < total; i++) {
         dest_fp[i] = static_cast<__fp16>(src[i]);
     }
 }
@@ -0,0 +1,64 @@
+// Vita3K emulator project
+// Copyright (C) 2026 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include <util/frame_timings.h>
+
+#include <algorithm>
+#include <mutex>
+
+namespace frame_timings {
+
+std::atomic<bool> enabled = false;
+std::array<std::atomic<uint64_t>, STAGE_COUNT> current_ns = {};
+
+static std::mutex mutex;
+static std::array<Frame, HISTORY_SIZE> history;
+static size_t history_next = 0;
+static size_t history_count = 0;
+static Clock::time_point last_frame_end;
+
+void end_frame() {
+    const auto now = Clock::now();
+
+    Frame frame;
+    for (size_t i = 0; i < STAGE_COUNT; i++)
+        frame.stage_ms[i] = static_cast<float>(current_ns[i].exchange(0, std::memory_order_relaxed)) / 1e6f;
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    // the first frame after enabling the breakdown has no start, it is not kept
+    const Clock::time_point frame_start = last_frame_end;
+    last_frame_end = enabled ? now : Clock::time_point{};
+    if (!enabled || frame_start == Clock::time_point{})
+        return;
+
+    frame.total_ms = std::chrono::duration<float, std::milli>(now - frame_start).count();
+    history[history_next] = frame;
+    history_next = (history_next + 1) % HISTORY_SIZE;
+    history_count = std::min(history_count + 1, HISTORY_SIZE);
+}
+
+std::vector<Frame> get_history() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    std::vector<Frame> frames;
+    frames.reserve(history_count);
+    for (size_t i = 0; i < history_count; i++)
+        frames.push_back(history[(history_next + HISTORY_SIZE - history_count + i) % HISTORY_SIZE]);
+    return frames;
+}
+
+} // namespace frame_timings
@@ -19,15 +19,22 @@
 
 #include <openssl/evp.h>
 
+// OpenSSL already selects the SHA extensions of the CPU (SHA-NI, ARMv8 SHA2) at runtime.
+// With OpenSSL 3, EVP_sha256() makes every digest look the implementation up again, so it is only fetched once.
+static const EVP_MD *get_sha256_md() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static EVP_MD *const md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    if (md)
+        return md;
+#endif
+    return EVP_sha256();
+}
+
 Sha256Hash sha256(const void *data, size_t size) {
     Sha256Hash hash;
 
-    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-    EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
-    EVP_DigestUpdate(ctx, data, size);
     unsigned int len;
-    EVP_DigestFinal(ctx, hash.data(), &len);
-    EVP_MD_CTX_free(ctx);
+    EVP_Digest(data, size, hash.data(), &len, get_sha256_md(), nullptr);
 
     return hash;
 }
@@ -22,7 +22,10 @@
 #include <Windows.h>
 #endif
 
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/dist_sink.h>
+#include <spdlog/sinks/dup_filter_sink.h>
 #include <spdlog/sinks/msvc_sink.h>
 #ifdef __ANDROID__
 #include <spdlog/sinks/android_sink.h>
@@ -30,7 +33,10 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #endif
 
+#include <chrono>
 #include <iostream>
+#include <map>
+#include <thread>
 #include <vector>
 
 namespace logging {
@@ -39,10 +45,62 @@ static const fs::path &LOG_FILE_NAME = "vita3k.log";
 static const char *LOG_PATTERN = "%^[%H:%M:%S.%e] |%L| [%!]: %v%$";
 static std::vector<spdlog::sink_ptr> sinks;
 
+// The messages are formatted by the calling thread, then written to the sinks by a single logging thread.
+// When the queue is full, the oldest messages are dropped instead of blocking the emulated threads.
+static constexpr size_t LOG_QUEUE_SIZE = 8192;
+// identical messages following each other in this duration are written once, with the number of repetitions
+static constexpr auto DUPLICATE_FILTER_DURATION = std::chrono::seconds(5);
+// a line of code logging more messages than this in a window only has the first ones written
+static constexpr uint32_t RATE_LIMIT_MESSAGES = 100;
+static constexpr auto RATE_LIMIT_WINDOW = std::chrono::seconds(1);
+
+// Drops the messages of a line of code logging too often, the number of dropped messages is written
+// along with the next message of this line once its window is over
+class RateLimitSink : public spdlog::sinks::dist_sink<std::mutex> {
+    struct Window {
+        spdlog::log_clock::time_point start;
+        uint32_t count = 0;
+        uint32_t dropped = 0;
+    };
+
+    std::map<std::pair<const char *, int>, Window> windows;
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &msg) override {
+        if (msg.source.empty()) {
+            dist_sink::sink_it_(msg);
+            return;
+        }
+
+        Window &window = windows[{ msg.source.filename, msg.source.line }];
+        if (msg.time - window.start >= RATE_LIMIT_WINDOW) {
+            if (window.dropped > 0) {
+                const std::string text = fmt::format("{} messages of this line were dropped", window.dropped);
+                dist_sink::sink_it_(spdlog::details::log_msg(msg.time, msg.source, msg.logger_name, spdlog::level::warn, text));
+            }
+            window = { msg.time, 0, 0 };
+        }
+
+        if (++window.count > RATE_LIMIT_MESSAGES) {
+            window.dropped++;
+            return;
+        }
+        dist_sink::sink_it_(msg);
+    }
+};
+
 static void register_log_exception_handler();
 
 static void flush() {
-    spdlog::details::registry::instance().flush_all();
+    // give the logging thread some time to write the queued messages, then flush the files from here
+    // as the process may be about to end
+    if (const auto pool = spdlog::thread_pool()) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+        while (pool->queue_size() > 0 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+    }
+    for (const auto &sink : sinks)
+        sink->flush();
 }
 
 ExitCode init(const Root &root_paths, bool use_stdout) {
@@ -114,7 +172,15 @@ ExitCode add_sink(const fs::path &log_path) {
     }
 #endif
 
-    spdlog::set_default_logger(std::make_shared<spdlog::logger>("vita3k logger", begin(sinks), end(sinks)));
+    if (!spdlog::thread_pool())
+        spdlog::init_thread_pool(LOG_QUEUE_SIZE, 1);
+
+    const auto duplicate_filter = std::make_shared<spdlog::sinks::dup_filter_sink_mt>(DUPLICATE_FILTER_DURATION);
+    duplicate_filter->set_sinks(sinks);
+    const auto rate_limit = std::make_shared<RateLimitSink>();
+    rate_limit->add_sink(duplicate_filter);
+
+    spdlog::set_default_logger(std::make_shared<spdlog::async_logger>("vita3k logger", rate_limit, spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest));
     spdlog::set_pattern(LOG_PATTERN);
     return Success;
 }
@@ -334,20 +334,48 @@ bool socketSetBlocking(int sockfd, bool blocking) {
     return true;
 }
 
+// Shared by all the transfers, so that the next requests to a host reuse the connection,
+// the DNS result and the TLS session of the previous one instead of setting them up again
+static CURLSH *get_curl_share() {
+    static std::mutex locks[CURL_LOCK_DATA_LAST];
+    static CURLSH *const share = [] {
+        CURLSH *share = curl_share_init();
+        if (!share)
+            return share;
+
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, +[](CURL *, curl_lock_data data, curl_lock_access, void *) { locks[data].lock(); });
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, +[](CURL *, curl_lock_data data, void *) { locks[data].unlock(); });
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+        return share;
+    }();
+    return share;
+}
+
+static void set_common_options(CURL *curl) {
+    if (CURLSH *share = get_curl_share())
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    // HTTP/2 when the server offers it over TLS, several requests can then share a connection
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true); // Follow redirects
+
+#ifdef __ANDROID__
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+#endif
+}
+
 std::string get_web_response(const std::string &url) {
     auto curl = curl_easy_init();
     if (!curl)
         return {};
 
+    set_common_options(curl);
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_USERAGENT, "Vita3K Emulator");
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true); // Follow redirects
     curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
 
-#ifdef __ANDROID__
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-#endif
-
     std::string response_string;
     const auto writeFunc = +[](void *ptr, size_t size, size_t nmemb, std::string *data) {
         data->append((char *)ptr, size * nmemb);
@@ -450,17 +478,13 @@ bool download_file(const std::string &url, const std::string &output_file_path,
     const uint64_t bytes_already_downloaded = fs::exists(output_file_path) ? fs::file_size(output_file_path) : 0;
     const auto callbackData = CallbackData({ start_time, bytes_already_downloaded }, progress_callback);
 
+    set_common_options(curl_download);
     curl_easy_setopt(curl_download, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl_download, CURLOPT_WRITEFUNCTION, write_data);
     curl_easy_setopt(curl_download, CURLOPT_NOPROGRESS, false); // Enable progress function
     curl_easy_setopt(curl_download, CURLOPT_RESUME_FROM_LARGE, bytes_already_downloaded);
     curl_easy_setopt(curl_download, CURLOPT_XFERINFODATA, &callbackData);
     curl_easy_setopt(curl_download, CURLOPT_XFERINFOFUNCTION, curl_callback);
-    curl_easy_setopt(curl_download, CURLOPT_FOLLOWLOCATION, true); // Follow redirects
-
-#ifdef __ANDROID__
-    curl_easy_setopt(curl_download, CURLOPT_SSL_VERIFYPEER, 0L);
-#endif
 
     auto fp = fopen(output_file_path.c_str(), "ab");
     if (!fp) {
@@ -22,7 +22,10 @@
 
 namespace vkutil {
 
-void init(vma::Allocator vma_allocator);
+// support_lazy_memory tells if the device has a lazily allocated memory type, it is then used for the transient attachments
+void init(vma::Allocator vma_allocator, bool support_lazy_memory);
+// destroys the images kept for recycling, must be called before the allocator is destroyed
+void clear_image_pool();
 
 struct Image {
     vma::Allocation allocation;
@@ -38,6 +41,13 @@ struct Image {
     // should the existing image, view, sampler be destroyed when this image is destroyed?
     bool destroy_on_deletion = true;
 
+    // parameters the image was created with by init_image, an image going through a DestroyQueue
+    // is then kept to be reused by the next init_image call with the same parameters
+    vk::ImageUsageFlags usage{};
+    vk::ImageCreateFlags create_flags{};
+    const void *create_pNext = nullptr;
+    bool recyclable = false;
+
     Image();
     Image(uint32_t width, uint32_t height, vk::Format format);
     ~Image();
@@ -50,10 +60,14 @@ struct Image {
     Image(const Image &) = delete;
     Image &operator=(Image const &) = delete;
 
+    // the pNext chain is compared by address to recycle images, it must not live on the stack of the caller
     void init_image(vk::ImageUsageFlags usage, vk::ComponentMapping mapping = default_comp_mapping, const vk::ImageCreateFlags image_create_flags = vk::ImageCreateFlags(), const void *pNext = nullptr);
     // called by ~Image
     void destroy();
 
+    // size of the memory allocated for the image, 0 if it was not created
+    vk::DeviceSize get_allocation_size() const;
+
     void transition_to(vk::CommandBuffer buffer, ImageLayout new_layout, const vk::ImageSubresourceRange &range = color_subresource_range);
     // use this when you don't care about the former content of the image
     void transition_to_discard(vk::CommandBuffer buffer, ImageLayout new_layout, const vk::ImageSubresourceRange &range = color_subresource_range);
@@ -149,13 +163,26 @@ public:
     void create() override;
 
     void copy(vk::CommandBuffer cmd_buffer, const uint32_t size, const void *data, const uint32_t offset = 0) override;
+    // copy nb_elements elements of src_stride bytes, each one placed every dst_stride bytes in the buffer
+    // this avoids going through a temporary buffer when the layout of the data must be changed
+    void copy_strided(const uint32_t nb_elements, const void *data, const uint32_t src_stride, const uint32_t dst_stride, const uint32_t offset = 0);
+
+    // allocate data_size bytes and return where they are mapped, so that the content can be written in place
+    // flush must be called once it has been written
+    uint8_t *allocate_mapped(const uint32_t data_size) {
+        allocate(data_size);
+        return static_cast<uint8_t *>(buffer.mapped_data) + data_offset;
+    }
+    void flush(const uint32_t size, const uint32_t offset = 0);
 };
 
 // Queue that contains GPU objects that are planned to be destroyed (deferred destruction)
+// the images created by init_image are not destroyed but given back to the image pool
 class DestroyQueue {
 private:
     vk::Device device;
     std::vector<uint64_t> destroy_list;
+    std::vector<Image> recycle_list;
 
 public:
     void init(vk::Device device);
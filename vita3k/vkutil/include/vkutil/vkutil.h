@@ -98,6 +98,11 @@ static constexpr vma::AllocationCreateInfo vma_auto_alloc = {
     .usage = vma::MemoryUsage::eAuto
 };
 
+// only for transient attachments, the memory may never be committed on tile-based GPUs
+static constexpr vma::AllocationCreateInfo vma_lazy_alloc = {
+    .usage = vma::MemoryUsage::eGpuLazilyAllocated
+};
+
 static constexpr vma::AllocationCreateInfo vma_mapped_alloc = {
     .flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
     .usage = vma::MemoryUsage::eAuto,
@@ -132,6 +137,9 @@ enum struct ImageLayout {
 void transition_image_layout(vk::CommandBuffer cmd_buffer, vk::Image image, ImageLayout src_layout, ImageLayout dst_layout, const vk::ImageSubresourceRange &range = color_subresource_range);
 // transition image layout assuming you don't care about the former image content
 void transition_image_layout_discard(vk::CommandBuffer cmd_buffer, vk::Image image, ImageLayout src_layout, ImageLayout dst_layout, const vk::ImageSubresourceRange &range = color_subresource_range);
+// queue family ownership transfer with a layout transition, it must be recorded twice with the same layouts:
+// first with is_release on the source queue, then without it on the destination queue
+void transfer_image_ownership(vk::CommandBuffer cmd_buffer, vk::Image image, ImageLayout src_layout, ImageLayout dst_layout, uint32_t src_family, uint32_t dst_family, bool is_release, const vk::ImageSubresourceRange &range = color_subresource_range);
 // Return the vulkan layout associated with ImageLayout
 vk::ImageLayout get_underlying_layout(ImageLayout layout);
 
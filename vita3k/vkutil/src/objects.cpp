@@ -25,9 +25,78 @@
 namespace vkutil {
 
 static vma::Allocator allocator = nullptr;
-
-void init(vma::Allocator vma_allocator) {
+static bool use_lazy_memory = false;
+
+// images which are not used by the GPU anymore, kept to be reused instead of being created again
+// surfaces of the same size and format are often destroyed and created again in the same frames
+struct PooledImage {
+    vk::Image image;
+    vma::Allocation allocation;
+    vk::DeviceSize size;
+    uint32_t width;
+    uint32_t height;
+    vk::Format format;
+    vk::ImageUsageFlags usage;
+    vk::ImageCreateFlags create_flags;
+    const void *create_pNext;
+    // value of pool_frame when the image was put in the pool
+    uint64_t frame;
+};
+
+static constexpr vk::DeviceSize IMAGE_POOL_MAX_SIZE = 64 * 1024 * 1024;
+// an image which was not reused during this number of frames is destroyed
+static constexpr uint64_t IMAGE_POOL_MAX_AGE = 120;
+
+static std::vector<PooledImage> image_pool;
+static vk::DeviceSize image_pool_size = 0;
+static uint64_t pool_frame = 0;
+
+void init(vma::Allocator vma_allocator, bool support_lazy_memory) {
     allocator = vma_allocator;
+    use_lazy_memory = support_lazy_memory;
+}
+
+static void destroy_pooled_image(size_t index) {
+    allocator.destroyImage(image_pool[index].image, image_pool[index].allocation);
+    image_pool_size -= image_pool[index].size;
+    image_pool.erase(image_pool.begin() + index);
+}
+
+void clear_image_pool() {
+    while (!image_pool.empty())
+        destroy_pooled_image(image_pool.size() - 1);
+}
+
+static void recycle_image(Image &image) {
+    const vk::DeviceSize size = allocator.getAllocationInfo(image.allocation).size;
+    if (size > IMAGE_POOL_MAX_SIZE) {
+        allocator.destroyImage(image.image, image.allocation);
+        return;
+    }
+
+    // the oldest images are at the beginning
+    while (image_pool_size + size > IMAGE_POOL_MAX_SIZE)
+        destroy_pooled_image(0);
+
+    image_pool.push_back({ image.image, image.allocation, size, image.width, image.height, image.format, image.usage, image.create_flags, image.create_pNext, pool_frame });
+    image_pool_size += size;
+}
+
+static bool take_pooled_image(Image &image) {
+    for (size_t i = image_pool.size(); i-- > 0;) {
+        const PooledImage &pooled = image_pool[i];
+        if (pooled.width != image.width || pooled.height != image.height || pooled.format != image.format
+            || pooled.usage != image.usage || pooled.create_flags != image.create_flags || pooled.create_pNext != image.create_pNext)
+            continue;
+
+        image.image = pooled.image;
+        image.allocation = pooled.allocation;
+        image_pool_size -= pooled.size;
+        image_pool.erase(image_pool.begin() + i);
+        return true;
+    }
+
+    return false;
 }
 
 Image::Image() = default;
@@ -77,6 +146,13 @@ Image::~Image() {
     destroy();
 }
 
+vk::DeviceSize Image::get_allocation_size() const {
+    if (!image || !allocator)
+        return 0;
+
+    return allocator.getAllocationInfo(allocation).size;
+}
+
 void Image::init_image(vk::ImageUsageFlags usage, vk::ComponentMapping mapping, const vk::ImageCreateFlags image_create_flags, const void *pNext) {
     vk::ImageCreateInfo image_info{
         .pNext = pNext,
@@ -96,7 +172,16 @@ void Image::init_image(vk::ImageUsageFlags usage, vk::ComponentMapping mapping,
         .initialLayout = vk::ImageLayout::eUndefined,
     };
 
-    std::tie(image, allocation) = allocator.createImage(image_info, vma_auto_alloc);
+    this->usage = usage;
+    create_flags = image_create_flags;
+    create_pNext = pNext;
+    recyclable = true;
+
+    if (!take_pooled_image(*this)) {
+        // the content of a transient attachment never leaves the render pass, it does not need actual memory on tilers
+        const bool is_lazy = use_lazy_memory && (usage & vk::ImageUsageFlagBits::eTransientAttachment);
+        std::tie(image, allocation) = allocator.createImage(image_info, is_lazy ? vma_lazy_alloc : vma_auto_alloc);
+    }
 
     // only create a view if one of these flags is set
     constexpr vk::ImageUsageFlags view_usages = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eStorage;
@@ -224,6 +309,21 @@ void HostRingBuffer::copy(vk::CommandBuffer cmd_buffer, const uint32_t size, con
         allocator.flushAllocation(buffer.allocation, data_offset + offset, size);
 }
 
+void HostRingBuffer::copy_strided(const uint32_t nb_elements, const void *data, const uint32_t src_stride, const uint32_t dst_stride, const uint32_t offset) {
+    uint8_t *dst = static_cast<uint8_t *>(buffer.mapped_data) + data_offset + offset;
+    const uint8_t *src = static_cast<const uint8_t *>(data);
+    for (uint32_t i = 0; i < nb_elements; i++)
+        memcpy(dst + dst_stride * i, src + src_stride * i, src_stride);
+
+    if (!is_coherent)
+        allocator.flushAllocation(buffer.allocation, data_offset + offset, nb_elements * dst_stride);
+}
+
+void HostRingBuffer::flush(const uint32_t size, const uint32_t offset) {
+    if (!is_coherent)
+        allocator.flushAllocation(buffer.allocation, data_offset + offset, size);
+}
+
 void LocalRingBuffer::create() {
     // the auto_alloc default behavior should give us memory on the gpu
     // UpdateBuffer needs the buffer to have TransferDst specified
@@ -250,10 +350,16 @@ void DestroyQueue::add_image(Image &image) {
     }
 
     if (image.image) {
-        add(image.image);
-        image.image = nullptr;
-        destroy_list.push_back(std::bit_cast<uint64_t>(image.allocation));
+        if (image.recyclable) {
+            Image &recycled = recycle_list.emplace_back(std::move(image));
+            recycled.destroy_on_deletion = false;
+        } else {
+            add(image.image);
+            image.image = nullptr;
+            destroy_list.push_back(std::bit_cast<uint64_t>(image.allocation));
+        }
     }
+    image.recyclable = false;
 }
 
 void DestroyQueue::add_buffer(Buffer &buffer) {
@@ -277,6 +383,15 @@ void DestroyQueue::add_cmd_buffer(vk::CommandBuffer cmd_buffer, vk::CommandPool
     }
 
 void DestroyQueue::destroy_objects() {
+    // this is called once per frame
+    pool_frame++;
+    while (!image_pool.empty() && image_pool.front().frame + IMAGE_POOL_MAX_AGE < pool_frame)
+        destroy_pooled_image(0);
+
+    for (Image &image : recycle_list)
+        recycle_image(image);
+    recycle_list.clear();
+
     if (destroy_list.empty())
         return;
 
@@ -316,6 +431,7 @@ void DestroyQueue::destroy_objects() {
             HANDLE_DESTROY(Fence)
             HANDLE_DESTROY(Semaphore)
             HANDLE_DESTROY(Framebuffer)
+            HANDLE_DESTROY(QueryPool)
 
         default:
             LOG_ERROR("Unknown object type {}", vk::to_string(type));
@@ -159,6 +159,27 @@ void transition_image_layout_discard(vk::CommandBuffer cmd_buffer, vk::Image ima
     transition_image_layout_impl(cmd_buffer, image, src_layout, dst_layout, range, true);
 }
 
+void transfer_image_ownership(vk::CommandBuffer cmd_buffer, vk::Image image, ImageLayout src_layout, ImageLayout dst_layout, uint32_t src_family, uint32_t dst_family, bool is_release, const vk::ImageSubresourceRange &range) {
+    const ImageLayoutTransition &src_transition = layout_transitions[static_cast<int>(src_layout)];
+    const ImageLayoutTransition &dst_transition = layout_transitions[static_cast<int>(dst_layout)];
+
+    // the release only makes the source accesses available, the acquire makes them visible to the destination accesses
+    vk::ImageMemoryBarrier barrier{
+        .srcAccessMask = is_release ? src_transition.access : vk::AccessFlags(),
+        .dstAccessMask = is_release ? vk::AccessFlags() : dst_transition.access,
+        .oldLayout = src_transition.layout,
+        .newLayout = dst_transition.layout,
+        .srcQueueFamilyIndex = src_family,
+        .dstQueueFamilyIndex = dst_family,
+        .image = image,
+        .subresourceRange = range
+    };
+
+    const vk::PipelineStageFlags src_stages = is_release ? src_transition.stages : vk::PipelineStageFlagBits::eTopOfPipe;
+    const vk::PipelineStageFlags dst_stages = is_release ? vk::PipelineStageFlagBits::eBottomOfPipe : dst_transition.stages;
+    cmd_buffer.pipelineBarrier(src_stages, dst_stages, vk::DependencyFlags(), {}, {}, barrier);
+}
+
 vk::ImageLayout get_underlying_layout(ImageLayout layout) {
     return layout_transitions[static_cast<int>(layout)].layout;
 }